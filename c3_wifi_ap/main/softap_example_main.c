@@ -5,6 +5,7 @@
  * and processes data packets from connected stations.
  */
 
+#include <stdio.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -15,52 +16,53 @@
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "esp_mac.h"
+#include "esp_timer.h"
+#include "esp_now.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
 
+#include "sched_types.h"
+#include "frame_codec.h"
+#include "record_schema.h"
+#include "frame_export.h"
+#include "mac_allowlist.h"
+
 /* WiFi configuration */
 #define EXAMPLE_ESP_WIFI_SSID      CONFIG_ESP_WIFI_SSID
 #define EXAMPLE_ESP_WIFI_PASS      CONFIG_ESP_WIFI_PASSWORD
 #define EXAMPLE_ESP_WIFI_CHANNEL   CONFIG_ESP_WIFI_CHANNEL
 #define EXAMPLE_MAX_STA_CONN       CONFIG_ESP_MAX_STA_CONN
 
-/* Packet receiver configuration */
-#define MAX_CLASSES                4      // 3 classes (Class 1: 3s, Class 2: 5s, Class 3: 6s, Class 4: random)
-#define MAX_PACKET_SIZE           1400   // Maximum packet data size
-#define PROMISCUOUS_FILTER_MASK   WIFI_PROMIS_FILTER_MASK_DATA  // Only receive data frames
+/* Packet receiver configuration (class and size limits come from sched_types.h) */
+#define PROMISCUOUS_FILTER_MASK   WIFI_PROMIS_FILTER_MASK_DATA_MPDU  // Only unaggregated data frames; stations never aggregate
 #define RX_TASK_STACK_SIZE        4096
 #define RX_TASK_PRIORITY          5
+#define RX_TASK_POLL_MS           500     // How often the receiver task checks for a finished benchmark
+#define BENCH_IDLE_TIMEOUT_MS     1000    // A benchmark with no frames for this long is over
+#define BENCH_PREFIX              "@BENCH"  // Result line, as printed by the station
+#define SOURCE_REPORT_MS          10000   // How often RX path cost and unregistered sources are reported
+
+#if CONFIG_AP_RX_PATH_ESPNOW
+#define RX_PATH_NAME              "ESP-NOW"
+#else
+#define RX_PATH_NAME              "promiscuous"
+#endif
 
 static const char *TAG = "wifi-ap-receiver";
 
 /* Add a reception counter to track packet sequence */
 static uint32_t rx_packet_counter = 0;
 
-/* Class definitions */
-typedef enum {
-    CLASS_1 = 0,                 // Class 1: 3-second period
-    CLASS_2 = 1,                 // Class 2: 5-second period
-    CLASS_3 = 2,                 // Class 3: 6-second period
-    CLASS_RANDOM = 3,            // Random packet
-} class_id_t;
-
-/* Data type definitions */
-typedef enum {
-    DATA_TYPE_INT8 = 0,          // 8-bit integer
-    DATA_TYPE_INT16 = 1,         // 16-bit integer
-    DATA_TYPE_INT32 = 2,         // 32-bit integer
-    DATA_TYPE_FLOAT = 3,         // 32-bit float
-    DATA_TYPE_DOUBLE = 4,        // 64-bit double
-} data_type_t;
-
-/* Updated data packet header (now includes all necessary information) */
-typedef struct {
-    uint8_t class_counts[MAX_CLASSES];      // Number of items for each class
-    data_type_t class_types[MAX_CLASSES];   // Data type for each class
-    uint16_t total_size;                    // Total size of all data in bytes
-    uint32_t timestamp;                     // Transmission timestamp
-} __attribute__((packed)) data_packet_header_t;
+/* Decoded values of the class being processed (every value takes at least one byte) */
+static double class_samples[MAX_PACKET_SIZE];
+
+/* Sample capture times reconstructed from the frame being processed */
+static sample_times_t frame_times;
+
+/* Groups the station held back under send-on-delta, and the data they repeat */
+static sample_held_t frame_held;
+static sample_hold_t hold_state;
 
 /* Receiver context */
 typedef struct {
@@ -75,16 +77,61 @@ typedef struct {
     uint32_t packets_received;       // Total packets received
     uint32_t data_packets;           // Data packets received
     uint32_t error_packets;          // Packets with errors
+    uint32_t crc_errors;             // Frames dropped on a bad or missing CRC trailer
+    uint32_t unknown_source;         // Frames from unregistered stations (only the RX callback writes it)
+    uint32_t rx_callbacks;           // Receive callbacks, wanted frames or not (likewise)
+    uint32_t rx_callback_us;         // Time spent in them, wrapping (likewise)
+    uint32_t held_samples;           // Samples restored from send-on-delta held groups
+    uint32_t held_dropped;           // Held groups whose reference group was not received
     uint32_t current_time_ms;        // Current time in milliseconds
 } receiver_context_t;
 
+/* Benchmark run being received ("bench tx" on the station) */
+typedef struct {
+    bool active;
+    bool ended;                      // End marker seen
+    uint16_t run;
+    uint32_t frames;                 // Benchmark frames, retransmissions included
+    uint32_t retries;                // Frames with the Retry flag
+    uint32_t duplicates;             // Retransmissions of the frame received just before
+    uint32_t last_seq;
+    uint32_t max_seq;
+    uint32_t sent;                   // Frames the station sent, from the end marker
+    uint64_t bytes;
+    int64_t first_us;
+    int64_t last_us;
+    int64_t rssi_sum;
+    uint64_t idle_first, total_first;  // CPU run time at the first and last frame
+    uint64_t idle_last, total_last;
+} bench_rx_t;
+
 /* Global receiver context */
 static receiver_context_t receiver_ctx;
 
+/* Guarded by receiver_ctx.mutex */
+static bench_rx_t bench_rx;
+static uint16_t bench_reported_run;
+static bool bench_reported;
+
+/* Registered stations. The RX callback reads the published table; the event
+ * handler edits a copy and publishes that. The C3 has one core and the driver
+ * task outranks the event task, so a lookup never overlaps an edit. */
+static mac_allowlist_t source_lists[2];
+static mac_allowlist_t *source_allowlist = &source_lists[0];
+
+/* Latency probes echoed and echoes the driver refused (only the RX callback writes them) */
+static uint32_t bench_echoes;
+static uint32_t bench_echo_errors;
+
 /* Function prototypes */
 static void receiver_task(void *pvParameters);
+#if !CONFIG_AP_RX_PATH_ESPNOW
 static void wifi_promiscuous_rx_cb(void *buf, wifi_promiscuous_pkt_type_t type);
-static void process_data_packet(const uint8_t *data, size_t length);
+#endif
+static void process_data_packet(const frame_view_t *view);
+static void export_frame(const uint8_t *frame, const frame_view_t *view, int8_t rssi);
+static void bench_rx_frame(const uint8_t *frame, const frame_view_t *view, int8_t rssi);
+static void bench_echo(const uint8_t *frame, size_t len, const frame_view_t *view);
 
 /* Get the current time in milliseconds */
 static uint32_t get_current_time_ms(void)
@@ -106,6 +153,10 @@ static void receiver_init(void)
     receiver_ctx.packets_received = 0;
     receiver_ctx.data_packets = 0;
     receiver_ctx.error_packets = 0;
+    receiver_ctx.crc_errors = 0;
+    receiver_ctx.unknown_source = 0;
+    receiver_ctx.rx_callbacks = 0;
+    receiver_ctx.rx_callback_us = 0;
     receiver_ctx.current_time_ms = 0;
     
     // Initialize class types to sensible defaults
@@ -132,6 +183,24 @@ static void receiver_init(void)
     ESP_LOGI(TAG, "Packet receiver initialized");
 }
 
+/* Register or drop a station's address in the source allowlist */
+static void source_allowlist_update(const uint8_t *mac, bool add)
+{
+    mac_allowlist_t *active = __atomic_load_n(&source_allowlist, __ATOMIC_ACQUIRE);
+    mac_allowlist_t *next = active == &source_lists[0] ? &source_lists[1] : &source_lists[0];
+    
+    *next = *active;
+    if (add) {
+        if (!mac_allowlist_add(next, mac)) {
+            ESP_LOGW(TAG, "Source allowlist full, frames from "MACSTR" will be dropped", MAC2STR(mac));
+            return;
+        }
+    } else if (!mac_allowlist_remove(next, mac)) {
+        return;
+    }
+    __atomic_store_n(&source_allowlist, next, __ATOMIC_RELEASE);
+}
+
 /* WiFi event handler */
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                               int32_t event_id, void* event_data)
@@ -140,10 +209,12 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         wifi_event_ap_staconnected_t* event = (wifi_event_ap_staconnected_t*) event_data;
         ESP_LOGI(TAG, "station "MACSTR" join, AID=%d",
                  MAC2STR(event->mac), event->aid);
+        source_allowlist_update(event->mac, true);
     } else if (event_id == WIFI_EVENT_AP_STADISCONNECTED) {
         wifi_event_ap_stadisconnected_t* event = (wifi_event_ap_stadisconnected_t*) event_data;
         ESP_LOGI(TAG, "station "MACSTR" leave, AID=%d, reason=%d",
                  MAC2STR(event->mac), event->aid, event->reason);
+        source_allowlist_update(event->mac, false);
     }
 }
 
@@ -205,6 +276,7 @@ void wifi_init_softap(void)
     ESP_LOGI(TAG, "wifi_init_softap finished.");
 }
 
+#if !CONFIG_AP_RX_PATH_ESPNOW
 /* Enable promiscuous mode for packet capturing */
 static void enable_promiscuous_mode(void)
 {
@@ -222,202 +294,376 @@ static void enable_promiscuous_mode(void)
     
     ESP_LOGI(TAG, "Promiscuous mode enabled successfully");
 }
+#endif
 
-/* WiFi promiscuous mode callback */
-/* WiFi promiscuous mode callback */
-static void wifi_promiscuous_rx_cb(void *buf, wifi_promiscuous_pkt_type_t type)
+/* Charge one receive callback to the path's CPU time (only the RX callbacks call it) */
+static void rx_path_time(int64_t start_us)
+{
+    receiver_ctx.rx_callbacks++;
+    receiver_ctx.rx_callback_us += esp_timer_get_time() - start_us;
+}
+
+/* Validate and process one station frame; both receive paths end here */
+static void receive_frame(const uint8_t *frame, size_t len, int8_t rssi)
 {
-    if (type != WIFI_PKT_DATA) {
-        return;  // We're only interested in data packets
-    }
-    
-    const wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
-    const uint8_t *payload = pkt->payload;
-    const size_t pkt_len = pkt->rx_ctrl.sig_len;
-    
     // Update current time
     receiver_ctx.current_time_ms = get_current_time_ms();
     
-    // Basic validation - we need at least 24 bytes for the basic 802.11 header
-    if (pkt_len < 24) {
-        ESP_LOGD(TAG, "Packet too small for 802.11 header: %d bytes", pkt_len);
-        return;
+    // Get our MAC address
+    uint8_t our_mac[6];
+    esp_wifi_get_mac(WIFI_IF_AP, our_mac);
+    
+    // Validate the frame once; the view carries per-class offsets for decoding
+    frame_view_t view;
+    frame_status_t status = frame_parse(frame, len, our_mac, &view);
+    
+#if CONFIG_AP_REQUIRE_FRAME_CRC
+    // Benchmark frames carry no trailer; every other frame must
+    if (status == FRAME_OK && view.kind != FRAME_KIND_BENCH && !(view.header->flags & FRAME_FLAG_CRC)) {
+        status = FRAME_ERR_BAD_CRC;
+    }
+#endif
+    
+    switch (status) {
+        case FRAME_OK:
+            break;
+        case FRAME_ERR_TOO_SHORT:
+        case FRAME_ERR_NOT_TO_DS:
+        case FRAME_ERR_NOT_FOR_US:
+            return;  // Not a data frame from a station to us
+        case FRAME_ERR_BAD_CRC:
+            // Corrupted on the air: count it without the cost of logging every one
+            if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+                receiver_ctx.crc_errors++;
+                xSemaphoreGive(receiver_ctx.mutex);
+            }
+            ESP_LOGD(TAG, "Dropped frame with bad CRC (%d bytes)", (int)len);
+            return;
+        default:
+            ESP_LOGW(TAG, "Invalid data packet header: %s (total size %d)",
+                     frame_status_name(status), view.header->total_size);
+            if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+                receiver_ctx.error_packets++;
+                xSemaphoreGive(receiver_ctx.mutex);
+            }
+            return;
     }
     
-    // We need at least enough data for header + our data packet header
-    if (pkt_len < 24 + sizeof(data_packet_header_t)) {
-        ESP_LOGD(TAG, "Packet too small for data packet header: %d bytes", pkt_len);
+    // Benchmark frames are only counted or echoed; exporting them would swamp the console
+    if (view.kind == FRAME_KIND_BENCH) {
+        frame_bench_t bench;
+        if (frame_bench_read(&view, &bench) && (bench.flags & FRAME_BENCH_PROBE)) {
+            bench_echo(frame, len, &view);
+        } else {
+            bench_rx_frame(frame, &view, rssi);
+        }
         return;
     }
     
-    // Parse 802.11 header
-    uint8_t frame_control_1 = payload[0];
-    uint8_t frame_control_2 = payload[1];
-    uint8_t frame_type = (frame_control_1 & 0x0C);
-    uint8_t from_ds = (frame_control_2 & 0x02) >> 1;
-    uint8_t to_ds = (frame_control_2 & 0x01);
+    // Increment packet count only for valid packets
+    if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        receiver_ctx.packets_received++;
+        xSemaphoreGive(receiver_ctx.mutex);
+    }
     
-    // Check if this is a data frame (type = 0x08) with proper flags
-    // For AP receiving, we want packets from stations (to_ds=1, from_ds=0)
-    if (frame_type != 0x08 || from_ds != 0 || to_ds != 1) {
-        return;  // Not a data frame from station to AP
+#ifdef CONFIG_AP_EXPORT_FRAMES
+    export_frame(frame, &view, rssi);
+#endif
+    
+    // Schema announcements define record layouts used by later data frames
+    if (view.kind == FRAME_KIND_SCHEMA) {
+        uint32_t conflicts = record_schema_conflicts();
+        int loaded = record_schema_unpack(view.payload, view.payload_len);
+        if (loaded < 0) {
+            ESP_LOGW(TAG, "Malformed schema announcement (%d bytes)", view.payload_len);
+        } else {
+            if (record_schema_conflicts() != conflicts) {
+                ESP_LOGW(TAG, "Schema from " MACSTR " conflicts with an announced layout; "
+                         "records of that ID are no longer decoded (%lu conflicts)",
+                         MAC2STR(view.src_mac), record_schema_conflicts());
+            }
+            ESP_LOGD(TAG, "Schema announcement: %d schema(s)", loaded);
+        }
+        return;
     }
     
-    // Extract MAC addresses from header to check if this packet is intended for us
-    uint8_t destination_mac[6];
-    memcpy(destination_mac, &payload[4], 6);
+    // Process the data packet
+    process_data_packet(&view);
+}
 
-    // Get our MAC address
-    uint8_t our_mac[6];
-    esp_wifi_get_mac(WIFI_IF_AP, our_mac);
+#if CONFIG_AP_RX_PATH_ESPNOW
+
+/* ESP-NOW frame from a station: put the plain data header back and process it like a sniffed one */
+static void espnow_rx(const esp_now_recv_info_t *info, const uint8_t *data, int len)
+{
+    static uint8_t frame[FRAME_MAX_LEN];
     
-    // Check if packet is for us or broadcast
-    bool is_for_us = true;
-    bool is_broadcast = true;
+#if CONFIG_AP_SOURCE_ALLOWLIST
+    if (!mac_allowlist_contains(__atomic_load_n(&source_allowlist, __ATOMIC_ACQUIRE), info->src_addr)) {
+        receiver_ctx.unknown_source++;
+        return;
+    }
+#endif
     
-    for (int i = 0; i < 6; i++) {
-        if (destination_mac[i] != our_mac[i]) {
-            is_for_us = false;
-        }
-        if (destination_mac[i] != 0xFF) {
-            is_broadcast = false;
-        }
+    frame_addr_t addr;
+    esp_wifi_get_mac(WIFI_IF_AP, addr.da);
+    memcpy(addr.bssid, addr.da, WIFI_MAC_LEN);
+    memcpy(addr.sa, info->src_addr, WIFI_MAC_LEN);
+    size_t frame_len = frame_build_from_body(frame, sizeof(frame), &addr, data, len);
+    if (frame_len == 0) {
+        ESP_LOGW(TAG, "ESP-NOW frame too long (%d bytes)", len);
+        return;
     }
     
-    if (!is_for_us && !is_broadcast) {
-        return;  // Packet not intended for us
+    receive_frame(frame, frame_len, info->rx_ctrl->rssi);
+}
+
+/* ESP-NOW receive callback (driver task) */
+static void espnow_rx_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len)
+{
+    int64_t start = esp_timer_get_time();
+    espnow_rx(info, data, len);
+    rx_path_time(start);
+}
+
+/* Receive station frames over ESP-NOW: the driver passes on only ESP-NOW frames for us */
+static void enable_espnow_rx(void)
+{
+    ESP_LOGI(TAG, "Enabling ESP-NOW reception");
+    ESP_ERROR_CHECK(esp_now_init());
+    ESP_ERROR_CHECK(esp_now_register_recv_cb(espnow_rx_cb));
+    ESP_LOGI(TAG, "ESP-NOW reception enabled");
+}
+
+#else /* CONFIG_AP_RX_PATH_ESPNOW */
+
+/* Sniffed data frame: drop other stations' frames before parsing anything */
+static void promiscuous_rx(const wifi_promiscuous_pkt_t *pkt, wifi_promiscuous_pkt_type_t type)
+{
+    if (type != WIFI_PKT_DATA) {
+        return;  // We're only interested in data packets
     }
     
-    // Skip the 802.11 header (24 bytes) to get to our payload
-    const uint8_t *data = payload + 24;
-    size_t data_len = pkt_len - 24;
+    const uint8_t *payload = pkt->payload;
+    const size_t pkt_len = pkt->rx_ctrl.sig_len;
     
-    // Basic size validation for our header
-    if (data_len < sizeof(data_packet_header_t)) {
-        if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-            receiver_ctx.error_packets++;
-            xSemaphoreGive(receiver_ctx.mutex);
-        }
-        ESP_LOGW(TAG, "Received packet too small: %d bytes (expected at least %d)", 
-                data_len, sizeof(data_packet_header_t));
+#if CONFIG_AP_SOURCE_ALLOWLIST
+    // Most data frames on a busy channel are someone else's: check the sender before anything else
+    if (pkt_len < WIFI_DATA_HEADER_LEN) {
         return;
     }
-    
-    // Do a basic validation of the data packet header
-    const data_packet_header_t *header = (const data_packet_header_t *)data;
-    
-    // Validate total size is reasonable
-    if (header->total_size > MAX_PACKET_SIZE) {
-        ESP_LOGW(TAG, "Invalid total size in header: %d (max allowed: %d)", 
-                 header->total_size, MAX_PACKET_SIZE);
-        if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-            receiver_ctx.error_packets++;
-            xSemaphoreGive(receiver_ctx.mutex);
-        }
+    if (!mac_allowlist_contains(__atomic_load_n(&source_allowlist, __ATOMIC_ACQUIRE),
+                                payload + WIFI_ADDR2_OFFSET)) {
+        receiver_ctx.unknown_source++;
         return;
     }
+#endif
     
-    // Validate class types
-    bool valid_types = true;
-    for (int i = 0; i < MAX_CLASSES; i++) {
-        if (header->class_types[i] > DATA_TYPE_DOUBLE) {
-            valid_types = false;
-            break;
-        }
+    receive_frame(payload, pkt_len, pkt->rx_ctrl.rssi);
+}
+
+/* WiFi promiscuous mode callback (driver task) */
+static void wifi_promiscuous_rx_cb(void *buf, wifi_promiscuous_pkt_type_t type)
+{
+    int64_t start = esp_timer_get_time();
+    promiscuous_rx((const wifi_promiscuous_pkt_t *)buf, type);
+    rx_path_time(start);
+}
+
+#endif /* CONFIG_AP_RX_PATH_ESPNOW */
+
+/* Idle and total run time so far, both 0 without run time statistics */
+static void cpu_sample(uint64_t *idle, uint64_t *total)
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    *idle = ulTaskGetIdleRunTimeCounter();
+    *total = portGET_RUN_TIME_COUNTER_VALUE();
+#else
+    *idle = 0;
+    *total = 0;
+#endif
+}
+
+/* Count one benchmark frame */
+static void bench_rx_frame(const uint8_t *frame, const frame_view_t *view, int8_t rssi)
+{
+    frame_bench_t bench;
+    if (!frame_bench_read(view, &bench)) {
+        return;
     }
+    int64_t now = esp_timer_get_time();
     
-    if (!valid_types) {
-        ESP_LOGW(TAG, "Invalid class types in header");
-        if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-            receiver_ctx.error_packets++;
-            xSemaphoreGive(receiver_ctx.mutex);
-        }
+    if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) != pdTRUE) {
         return;
     }
     
-    // Check if we have enough data for header + payload
-    if (data_len < sizeof(data_packet_header_t) + header->total_size) {
-        ESP_LOGW(TAG, "Insufficient data: header indicates %d data bytes, packet has %d bytes available",
-                 header->total_size, data_len - sizeof(data_packet_header_t));
+    // Late end markers of a run already reported
+    if (bench_reported && bench.run == bench_reported_run) {
+        xSemaphoreGive(receiver_ctx.mutex);
+        return;
+    }
+    if (!bench_rx.active || bench.run != bench_rx.run) {
+        if (bench_rx.active) {
+            ESP_LOGW(TAG, "Benchmark run %u replaced by run %u before it was reported", bench_rx.run, bench.run);
+        }
+        memset(&bench_rx, 0, sizeof(bench_rx));
+        bench_rx.active = true;
+        bench_rx.run = bench.run;
+        bench_rx.first_us = now;
+        cpu_sample(&bench_rx.idle_first, &bench_rx.total_first);
     }
     
-    // Increment packet count only for valid packets
-    if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-        receiver_ctx.packets_received++;
-        xSemaphoreGive(receiver_ctx.mutex);
+    if (bench.flags & FRAME_BENCH_END) {
+        bench_rx.ended = true;
+        bench_rx.sent = bench.seq;
+    } else {
+        // A retransmission repeats the previous frame only if its ACK was lost
+        bool retry = (frame[1] & WIFI_FC1_RETRY) != 0;
+        if (retry && bench_rx.frames > 0 && bench.seq == bench_rx.last_seq) {
+            bench_rx.duplicates++;
+        }
+        bench_rx.frames++;
+        bench_rx.retries += retry;
+        bench_rx.last_seq = bench.seq;
+        bench_rx.bytes += (size_t)((const uint8_t *)(view->header + 1) - frame) + view->header->total_size;
+        bench_rx.max_seq = bench.seq > bench_rx.max_seq ? bench.seq : bench_rx.max_seq;
+        bench_rx.rssi_sum += rssi;
+        bench_rx.last_us = now;
+        cpu_sample(&bench_rx.idle_last, &bench_rx.total_last);
     }
     
-    // Process the data packet
-    process_data_packet(data, data_len);
+    xSemaphoreGive(receiver_ctx.mutex);
 }
 
-/* Process a data packet */
-/* Process a data packet */
-static void process_data_packet(const uint8_t *data, size_t length)
+/* Send a latency probe straight back to the station, from the RX path to keep the turnaround short */
+static void bench_echo(const uint8_t *frame, size_t len, const frame_view_t *view)
 {
-    rx_packet_counter++;
-    // Make sure the packet is at least as large as our header
-    if (length < sizeof(data_packet_header_t)) {
-        ESP_LOGE(TAG, "Data packet too small: %d bytes (minimum size: %d)", 
-                 length, sizeof(data_packet_header_t));
+    static uint8_t echo[FRAME_MAX_LEN + WIFI_HTC_LEN];
+    
+    // sig_len also counts the FCS; echo only the MAC frame
+    size_t frame_len = (size_t)((const uint8_t *)(view->header + 1) - frame) + view->header->total_size;
+    size_t echo_len = frame_build_bench_echo(echo, sizeof(echo), frame, frame_len < len ? frame_len : len);
+    if (echo_len == 0) {
         return;
     }
     
-    // Cast to data packet header structure
-    const data_packet_header_t *header = (const data_packet_header_t *)data;
+    esp_err_t ret = esp_wifi_80211_tx(WIFI_IF_AP, echo, echo_len, true);
+    if (ret != ESP_OK) {
+        if (bench_echo_errors++ == 0) {
+            ESP_LOGW(TAG, "Failed to echo latency probe: %s", esp_err_to_name(ret));
+        }
+        return;
+    }
+    if (bench_echoes++ == 0) {
+        ESP_LOGI(TAG, "Echoing latency probes from " MACSTR, MAC2STR(view->src_mac));
+    }
+}
+
+/* Print and clear a benchmark run once its end marker arrived or its frames stopped */
+static void bench_rx_check(void)
+{
+    bench_rx_t b;
     
-    // Validate total size
-    if (header->total_size > MAX_PACKET_SIZE) {
-        ESP_LOGE(TAG, "Invalid total size in header: %d (max allowed: %d)", 
-                 header->total_size, MAX_PACKET_SIZE);
+    if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) != pdTRUE) {
         return;
     }
+    int64_t last = bench_rx.last_us > bench_rx.first_us ? bench_rx.last_us : bench_rx.first_us;
+    bool over = bench_rx.active &&
+        (bench_rx.ended || esp_timer_get_time() - last > (int64_t)BENCH_IDLE_TIMEOUT_MS * 1000);
+    if (!over) {
+        xSemaphoreGive(receiver_ctx.mutex);
+        return;
+    }
+    b = bench_rx;
+    bench_rx.active = false;
+    bench_reported = true;
+    bench_reported_run = b.run;
+    xSemaphoreGive(receiver_ctx.mutex);
+    
+    // Without the end marker the highest sequence number bounds what was sent
+    uint32_t unique = b.frames - b.duplicates;
+    uint32_t expected = b.ended ? b.sent : (b.frames > 0 ? b.max_seq + 1 : 0);
+    uint32_t lost = expected > unique ? expected - unique : 0;
+    double seconds = (b.last_us - b.first_us) / 1e6;
+    uint64_t span = b.total_last - b.total_first;
+    uint64_t idle = b.idle_last - b.idle_first;
+    int cpu_pct = span == 0 ? -1 : idle >= span ? 0 : (int)((span - idle) * 100 / span);
+    
+    printf(BENCH_PREFIX " side=ap mode=tx run=%u duration_ms=%lld frames=%lu retries=%lu duplicates=%lu bytes=%llu expected=%lu%s"
+           " lost=%lu loss_pct=%.2f fps=%.1f kbps=%.1f rssi=%.1f cpu_pct=%d\n",
+           b.run, (b.last_us - b.first_us) / 1000, b.frames, b.retries, b.duplicates, b.bytes, expected,
+           b.ended ? "" : " end=missing", lost, expected > 0 ? 100.0 * lost / expected : 0.0,
+           seconds > 0 ? unique / seconds : 0.0, seconds > 0 ? b.bytes * 8 / seconds / 1000.0 : 0.0,
+           b.frames > 0 ? (double)b.rssi_sum / b.frames : 0.0, cpu_pct);
+}
+
+/* Print a validated frame for the host collector (see frame_export.h) */
+static void export_frame(const uint8_t *frame, const frame_view_t *view, int8_t rssi)
+{
+    static char line[FRAME_EXPORT_LINE_MAX(FRAME_MAX_LEN + WIFI_HTC_LEN)];
     
-    // Validate class types (must be between 0-4)
-    for (int i = 0; i < MAX_CLASSES; i++) {
-        if (header->class_types[i] > DATA_TYPE_DOUBLE) {
-            ESP_LOGE(TAG, "Invalid class type for class %d: %d", i, header->class_types[i]);
-            return;
-        }
+    // Only the bytes the header and CRC trailer account for; sig_len also counts the FCS
+    if (frame_export_format(line, sizeof(line), receiver_ctx.current_time_ms, rssi,
+                            frame, view->frame_len) > 0) {
+        printf("%s\n", line);
     }
+}
+
+/* Format decoded record fields as "a, b, c" */
+static void format_values(char *out, size_t out_len, const double *values, int count)
+{
+    size_t pos = 0;
+    out[0] = '\0';
     
-    // Calculate expected total data size based on class counts and types
-    uint16_t expected_size = 0;
-    for (int i = 0; i < MAX_CLASSES; i++) {
-        if (header->class_counts[i] > 0) {
-            uint16_t element_size = 0;
-            switch (header->class_types[i]) {
-                case DATA_TYPE_INT8:   element_size = 1; break;
-                case DATA_TYPE_INT16:  element_size = 2; break;
-                case DATA_TYPE_INT32:  
-                case DATA_TYPE_FLOAT:  element_size = 4; break;
-                case DATA_TYPE_DOUBLE: element_size = 8; break;
-                default:               element_size = 0; break;  // Should not happen after validation
-            }
-            expected_size += element_size * header->class_counts[i];
+    for (int i = 0; i < count && pos < out_len; i++) {
+        int n = snprintf(out + pos, out_len - pos, i == 0 ? "%g" : ", %g", values[i]);
+        if (n < 0) {
+            break;
         }
+        pos += n;
     }
+}
+
+/* Process a validated data packet */
+static void process_data_packet(const frame_view_t *view)
+{
+    rx_packet_counter++;
+    const data_packet_header_t *header = view->header;
     
-    // Verify the total size in header matches our calculation
-    if (expected_size != header->total_size) {
+    // Verify the total size in header matches the class counts and types
+    if (!(header->flags & (FRAME_FLAG_SAMPLE_TIMES | FRAME_FLAG_HELD)) &&
+        view->expected_size != header->total_size) {
         ESP_LOGW(TAG, "Size mismatch: header says %d, calculated %d", 
-                 header->total_size, expected_size);
+                 header->total_size, view->expected_size);
     }
     
-    // Verify actual received data size matches or exceeds what we need
-    if (length - sizeof(data_packet_header_t) < header->total_size) {
-        ESP_LOGW(TAG, "Data packet size mismatch: expected %d, got %d",
-                 header->total_size, length - sizeof(data_packet_header_t));
-        // We'll continue processing what we can
+    // Reconstruct per-sample capture times if the station sent them
+    bool have_times = false;
+    if (view->time_block != NULL) {
+        have_times = sample_time_decode(view->time_block, view->time_block_len,
+                                        header->timestamp, &frame_times);
+        if (!have_times) {
+            ESP_LOGW(TAG, "Malformed sample time block (%d bytes)", view->time_block_len);
+        }
     }
-
+    
+    // Groups held back by send-on-delta repeat the last value before them
+    bool have_held = false;
+    if (view->held_block != NULL) {
+        have_held = sample_held_decode(view->held_block, view->held_block_len, &frame_held) > 0;
+        if (!have_held) {
+            ESP_LOGW(TAG, "Malformed held block (%d bytes)", view->held_block_len);
+        }
+    }
+    
     // Print transmission summary (matching the station's output format)
     ESP_LOGI(TAG, "=============================================================");
     ESP_LOGI(TAG, "Received packet #%lu", rx_packet_counter);
     ESP_LOGI(TAG, "  Total data size: %d bytes", header->total_size);
-    // ESP_LOGI(TAG, "  Transmission timestamp: %lu", header->timestamp);
-    // ESP_LOGI(TAG, "  Reception timestamp: %lu", current_time);
-    // ESP_LOGI(TAG, "  Latency: %lu ms", latency);
+    if (view->qos) {
+        ESP_LOGI(TAG, "  QoS data frame: AC=%s, TID=%d",
+                 wmm_ac_name(view->access_category), view->tid);
+    }
     
     // Store class information from the packet
     if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
@@ -431,9 +677,6 @@ static void process_data_packet(const uint8_t *data, size_t length)
         xSemaphoreGive(receiver_ctx.mutex);
     }
     
-    // Get data pointer (after header)
-    const uint8_t *payload = data + sizeof(data_packet_header_t);
-    
     // Calculate latency (time from transmission to reception)
     uint32_t current_time = get_current_time_ms();
     uint32_t packet_timestamp = header->timestamp;
@@ -460,64 +703,132 @@ static void process_data_packet(const uint8_t *data, size_t length)
          header->class_counts[3], header->class_types[3],
          header->total_size, latency);
     
-    // Process the data for each class
-    const uint8_t *class_data = payload;
-    
-    // Process each class's data
+    // Process each class's data using the offsets computed during validation
     for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
         if (header->class_counts[class_id] == 0) {
             continue;  // No data for this class
         }
         
-        // Calculate element size based on data type
-        uint16_t element_size = 0;
-        switch (header->class_types[class_id]) {
-            case DATA_TYPE_INT8:   element_size = 1; break;
-            case DATA_TYPE_INT16:  element_size = 2; break;
-            case DATA_TYPE_INT32:
-            case DATA_TYPE_FLOAT:  element_size = 4; break;
-            case DATA_TYPE_DOUBLE: element_size = 8; break;
-            default:
-                ESP_LOGE(TAG, "Unexpected data type %d for class %d", 
-                        header->class_types[class_id], class_id);
-                continue;  // Skip this class
-        }
-        
-        // Calculate total size for this class
-        uint16_t class_size = element_size * header->class_counts[class_id];
+        data_type_t class_type = header->class_types[class_id];
+        uint8_t count = header->class_counts[class_id];
+        uint8_t fields = class_type_fields(class_type);
+        class_type_widen(class_type, class_samples,
+                         view->payload + view->class_offset[class_id], count);
         
-        // Make sure we have enough data
-        size_t remaining_bytes = (payload + header->total_size) - class_data;
-        if (remaining_bytes < class_size) {
-            ESP_LOGW(TAG, "Not enough data for class %d: need %d bytes, have %d",
-                     class_id, class_size, remaining_bytes);
-            break;  // Stop processing
+        if (data_type_is_schema(class_type)) {
+            // Show the first and last record field by field
+            char first[64], last[64];
+            format_values(first, sizeof(first), class_samples, fields);
+            format_values(last, sizeof(last), &class_samples[(count - 1) * fields], fields);
+            ESP_LOGI(TAG, "  Class %d data (%d records, schema %d): first=(%s), last=(%s)",
+                     class_id + 1, count, data_type_schema_id(class_type), first, last);
+        } else {
+            ESP_LOGI(TAG, "  Class %d data (%d elements, type %s): first=%g, last=%g",
+                     class_id + 1, count, data_type_name(class_type),
+                     class_samples[0], class_samples[count - 1]);
         }
         
-        // Process based on data type
-        ESP_LOGI(TAG, "  Class %d data (%d elements, type %d):",
-                 class_id + 1, header->class_counts[class_id], header->class_types[class_id]);
-        
-        
+        uint32_t first_time, last_time;
+        if (have_times &&
+            sample_time_at(&frame_times, class_id, 0, &first_time) &&
+            sample_time_at(&frame_times, class_id, count - 1, &last_time)) {
+            ESP_LOGI(TAG, "    Sampled at %lu..%lu ms (%d groups)",
+                     first_time, last_time, frame_times.groups[class_id]);
+        }
         
-        // Move to next class's data
-        class_data += class_size;
+        // Hold-last-value: restore the held groups as copies of the group before them
+        const uint8_t *class_data = view->payload + view->class_offset[class_id];
+        uint16_t element_size = view->class_size[class_id] / count;
+        if (have_held) {
+            sample_run_t runs[SAMPLE_HOLD_MAX_RUNS];
+            uint32_t dropped;
+            int run_count = sample_hold_expand(&hold_state, &frame_held, class_id, class_data, count,
+                                               element_size, runs, &dropped);
+            uint32_t restored = 0, groups = 0;
+            for (int r = 0; r < run_count; r++) {
+                if (runs[r].held) {
+                    restored += (uint32_t)runs[r].items * runs[r].repeat;
+                    groups += runs[r].repeat;
+                }
+            }
+            if (restored > 0) {
+                ESP_LOGI(TAG, "    Restored %lu held group(s), %lu samples (unchanged within dead-band)",
+                         groups, restored);
+                if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+                    receiver_ctx.held_samples += restored;
+                    xSemaphoreGive(receiver_ctx.mutex);
+                }
+            }
+            if (dropped > 0) {
+                ESP_LOGW(TAG, "    Dropped %lu held group(s): the group they repeat was not received",
+                         dropped);
+                if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+                    receiver_ctx.held_dropped += dropped;
+                    xSemaphoreGive(receiver_ctx.mutex);
+                }
+            }
+        }
+        sample_hold_keep(&hold_state, have_held ? &frame_held : NULL, class_id, class_data, count,
+                         element_size);
     }
      ESP_LOGI(TAG, "=============================================================");
 }
 
+/* Log the receive path's callback time per accepted frame since the last report */
+static void rx_path_report(void)
+{
+    static uint32_t last_callbacks, last_us, last_frames;
+    
+    uint32_t callbacks = receiver_ctx.rx_callbacks;
+    uint32_t us = receiver_ctx.rx_callback_us;
+    uint32_t frames = receiver_ctx.packets_received;
+    if (frames == last_frames) {
+        return;
+    }
+    
+    ESP_LOGI(TAG, "RX path %s: %lu callback(s) for %lu frame(s), %.1f us per frame",
+             RX_PATH_NAME, callbacks - last_callbacks, frames - last_frames,
+             (double)(us - last_us) / (frames - last_frames));
+    last_callbacks = callbacks;
+    last_us = us;
+    last_frames = frames;
+}
+
 /* Main receiver task */
 static void receiver_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "Receiver task started");
     
-    // This task just periodically prints statistics
+    // This task reports finished benchmark runs and periodically prints statistics
     TickType_t last_wake_time = xTaskGetTickCount();
-    const TickType_t stats_interval = pdMS_TO_TICKS(5000);  // 5 seconds
+    const TickType_t poll_interval = pdMS_TO_TICKS(RX_TASK_POLL_MS);
+    uint32_t crc_reported = 0;
+    uint32_t unknown_reported = 0;
+    uint32_t polls = 0;
     
     while (1) {
         // Wait for the next interval
-        vTaskDelayUntil(&last_wake_time, stats_interval);
+        vTaskDelayUntil(&last_wake_time, poll_interval);
+        bench_rx_check();
+        
+        // Corrupted frames are reported in bulk rather than one log line each
+        uint32_t crc_errors = receiver_ctx.crc_errors;
+        if (crc_errors != crc_reported) {
+            ESP_LOGW(TAG, "%lu frame(s) failed the CRC check (%lu total)",
+                     crc_errors - crc_reported, crc_errors);
+            crc_reported = crc_errors;
+        }
+        
+        // Foreign traffic is normal on a shared channel; summarise it and the RX path cost now and then
+        if (++polls % (SOURCE_REPORT_MS / RX_TASK_POLL_MS) == 0) {
+            uint32_t unknown_source = receiver_ctx.unknown_source;
+            if (unknown_source != unknown_reported) {
+                ESP_LOGI(TAG, "Ignored %lu frame(s) from unregistered sources (%lu total)",
+                         unknown_source - unknown_reported, unknown_source);
+                unknown_reported = unknown_source;
+            }
+            rx_path_report();
+        }
         
         // Print statistics
         // if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
@@ -552,9 +863,13 @@ void app_main(void)
     ESP_LOGI(TAG, "Starting WiFi in AP mode");
     wifi_init_softap();
     
-    // After WiFi initialization, enable promiscuous mode for packet capture
+    // After WiFi initialization, start receiving station frames
     vTaskDelay(pdMS_TO_TICKS(1000));  // Short delay to ensure WiFi is fully initialized
+#if CONFIG_AP_RX_PATH_ESPNOW
+    enable_espnow_rx();
+#else
     enable_promiscuous_mode();
+#endif
     
     // Initialize packet receiver
     ESP_LOGI(TAG, "Initializing packet receiver");
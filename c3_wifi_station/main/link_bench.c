@@ -0,0 +1,486 @@
+/**
+ * @file link_bench.c
+ * @brief Link benchmarks run instead of the scheduler ("bench tx", "bench ping")
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "link_bench.h"
+#include "frame_codec.h"
+
+#define BENCH_TASK_STACK_SIZE  4096
+#define BENCH_RTT_BINS         (20 * BENCH_RTT_BINS_PER_OCTAVE)    // Up to about 1 s
+
+static const char *TAG = "link-bench";
+
+static const struct {
+    const char *option;
+    wifi_phy_rate_t rate;
+} bench_rates[] = {
+    {"1", WIFI_PHY_RATE_1M_L},
+    {"2", WIFI_PHY_RATE_2M_L},
+    {"5.5", WIFI_PHY_RATE_5M_L},
+    {"11", WIFI_PHY_RATE_11M_L},
+    {"6", WIFI_PHY_RATE_6M},
+    {"9", WIFI_PHY_RATE_9M},
+    {"12", WIFI_PHY_RATE_12M},
+    {"18", WIFI_PHY_RATE_18M},
+    {"24", WIFI_PHY_RATE_24M},
+    {"36", WIFI_PHY_RATE_36M},
+    {"48", WIFI_PHY_RATE_48M},
+    {"54", WIFI_PHY_RATE_54M},
+    {"mcs0", WIFI_PHY_RATE_MCS0_LGI},
+    {"mcs1", WIFI_PHY_RATE_MCS1_LGI},
+    {"mcs2", WIFI_PHY_RATE_MCS2_LGI},
+    {"mcs3", WIFI_PHY_RATE_MCS3_LGI},
+    {"mcs4", WIFI_PHY_RATE_MCS4_LGI},
+    {"mcs5", WIFI_PHY_RATE_MCS5_LGI},
+    {"mcs6", WIFI_PHY_RATE_MCS6_LGI},
+    {"mcs7", WIFI_PHY_RATE_MCS7_LGI},
+};
+
+static const struct {
+    const char *option;
+    wifi_ps_type_t mode;
+} bench_ps_modes[] = {
+    {"none", WIFI_PS_NONE},
+    {"min", WIFI_PS_MIN_MODEM},
+    {"max", WIFI_PS_MAX_MODEM},
+};
+
+static const struct {
+    const char *option;
+    uint8_t protocol;
+} bench_protocols[] = {
+    {"b", WIFI_PROTOCOL_11B},
+    {"bg", WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G},
+    {"bgn", WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N},
+};
+
+/* Counters of one run */
+typedef struct {
+    const scheduler_config_t *config;
+    TaskHandle_t waiter;
+    esp_err_t status;
+    uint16_t run;
+    uint32_t attempts;          // esp_wifi_80211_tx calls
+    uint32_t sent;              // Accepted by the driver
+    uint32_t no_mem;            // Rejected because the TX queue was full
+    uint32_t errors;            // Rejected for any other reason
+    uint64_t bytes;             // Frame bytes accepted
+    int64_t elapsed_us;
+    int cpu_pct;
+} bench_tx_t;
+
+bool bench_rate_from_option(const char *option, wifi_phy_rate_t *rate)
+{
+    for (size_t i = 0; i < sizeof(bench_rates) / sizeof(bench_rates[0]); i++) {
+        if (strcasecmp(option, bench_rates[i].option) == 0) {
+            *rate = bench_rates[i].rate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *bench_rate_label(wifi_phy_rate_t rate)
+{
+    for (size_t i = 0; i < sizeof(bench_rates) / sizeof(bench_rates[0]); i++) {
+        if (bench_rates[i].rate == rate) {
+            return bench_rates[i].option;
+        }
+    }
+    return "?";
+}
+
+bool bench_ps_from_option(const char *option, wifi_ps_type_t *mode)
+{
+    for (size_t i = 0; i < sizeof(bench_ps_modes) / sizeof(bench_ps_modes[0]); i++) {
+        if (strcasecmp(option, bench_ps_modes[i].option) == 0) {
+            *mode = bench_ps_modes[i].mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *bench_ps_label(wifi_ps_type_t mode)
+{
+    for (size_t i = 0; i < sizeof(bench_ps_modes) / sizeof(bench_ps_modes[0]); i++) {
+        if (bench_ps_modes[i].mode == mode) {
+            return bench_ps_modes[i].option;
+        }
+    }
+    return "?";
+}
+
+bool bench_protocol_from_option(const char *option, uint8_t *protocol)
+{
+    for (size_t i = 0; i < sizeof(bench_protocols) / sizeof(bench_protocols[0]); i++) {
+        if (strcasecmp(option, bench_protocols[i].option) == 0) {
+            *protocol = bench_protocols[i].protocol;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *bench_protocol_label(uint8_t protocol)
+{
+    for (size_t i = 0; i < sizeof(bench_protocols) / sizeof(bench_protocols[0]); i++) {
+        if (bench_protocols[i].protocol == protocol) {
+            return bench_protocols[i].option;
+        }
+    }
+    return "?";
+}
+
+/* Idle and total run time so far, both 0 without run time statistics */
+static void cpu_sample(uint64_t *idle, uint64_t *total)
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    *idle = ulTaskGetIdleRunTimeCounter();
+    *total = portGET_RUN_TIME_COUNTER_VALUE();
+#else
+    *idle = 0;
+    *total = 0;
+#endif
+}
+
+static int cpu_load_pct(uint64_t idle0, uint64_t total0, uint64_t idle1, uint64_t total1)
+{
+    if (total1 <= total0) {
+        return -1;
+    }
+    uint64_t span = total1 - total0;
+    uint64_t idle = idle1 - idle0;
+    return idle >= span ? 0 : (int)((span - idle) * 100 / span);
+}
+
+/* Destination and BSSID are the AP, source is us */
+static esp_err_t bench_frame_addr(frame_addr_t *addr)
+{
+    wifi_ap_record_t ap_info;
+    esp_err_t ret = esp_wifi_sta_get_ap_info(&ap_info);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    memcpy(addr->da, ap_info.bssid, WIFI_MAC_LEN);
+    memcpy(addr->bssid, ap_info.bssid, WIFI_MAC_LEN);
+    return esp_wifi_get_mac(WIFI_IF_STA, addr->sa);
+}
+
+/*
+ * Runs at idle priority: the loop never blocks while the driver accepts
+ * frames, and yielding on a full queue lets the idle task (and with it
+ * the watchdog and the CPU load figure) see the time the radio is the
+ * bottleneck.
+ */
+static void bench_tx_task(void *pvParameters)
+{
+    bench_tx_t *b = pvParameters;
+    const scheduler_config_t *config = b->config;
+    uint8_t *frame = malloc(FRAME_MAX_LEN);
+    frame_addr_t addr;
+
+    b->status = frame != NULL ? bench_frame_addr(&addr) : ESP_ERR_NO_MEM;
+    if (b->status == ESP_OK && config->bench_fixed_rate) {
+        b->status = esp_wifi_config_80211_tx_rate(WIFI_IF_STA, config->bench_rate);
+    }
+    if (b->status != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot start benchmark: %s", esp_err_to_name(b->status));
+        free(frame);
+        xTaskNotifyGive(b->waiter);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    frame_bench_t bench = { .run = b->run };
+    uint64_t idle0, total0, idle1, total1;
+    int64_t start = esp_timer_get_time();
+    int64_t end = start + (int64_t)config->bench_duration_s * 1000000;
+    cpu_sample(&idle0, &total0);
+
+    while (esp_timer_get_time() < end) {
+        bench.seq = b->sent;
+        size_t len = frame_build_bench(frame, FRAME_MAX_LEN, &addr, &bench, config->bench_payload_len,
+                                       (uint32_t)(esp_timer_get_time() / 1000));
+        esp_err_t ret = esp_wifi_80211_tx(WIFI_IF_STA, frame, len, true);
+        b->attempts++;
+        if (ret == ESP_OK) {
+            b->sent++;
+            b->bytes += len;
+        } else if (ret == ESP_ERR_NO_MEM) {
+            b->no_mem++;
+            taskYIELD();
+        } else {
+            if (b->errors++ == 0) {
+                ESP_LOGW(TAG, "esp_wifi_80211_tx failed: %s", esp_err_to_name(ret));
+            }
+            taskYIELD();
+        }
+    }
+
+    b->elapsed_us = esp_timer_get_time() - start;
+    cpu_sample(&idle1, &total1);
+    b->cpu_pct = cpu_load_pct(idle0, total0, idle1, total1);
+
+    // Tell the AP how many frames to expect; several copies in case one is lost
+    bench.flags = FRAME_BENCH_END;
+    bench.seq = b->sent;
+    size_t len = frame_build_bench(frame, FRAME_MAX_LEN, &addr, &bench, BENCH_MIN_PAYLOAD,
+                                   (uint32_t)(esp_timer_get_time() / 1000));
+    for (int i = 0; i < BENCH_END_FRAMES; i++) {
+        vTaskDelay(pdMS_TO_TICKS(BENCH_END_SPACING_MS));
+        esp_wifi_80211_tx(WIFI_IF_STA, frame, len, true);
+    }
+
+    free(frame);
+    xTaskNotifyGive(b->waiter);
+    vTaskDelete(NULL);
+}
+
+esp_err_t bench_tx_run(const scheduler_config_t *config)
+{
+    static bench_tx_t b;
+
+    memset(&b, 0, sizeof(b));
+    b.config = config;
+    b.waiter = xTaskGetCurrentTaskHandle();
+    b.run = (uint16_t)esp_random();
+
+    ESP_LOGI(TAG, "Benchmark run %u: %lu s of %u-byte payloads at rate %s",
+             b.run, config->bench_duration_s, config->bench_payload_len,
+             config->bench_fixed_rate ? bench_rate_label(config->bench_rate) : "auto");
+
+    if (xTaskCreate(bench_tx_task, "bench_tx", BENCH_TASK_STACK_SIZE, &b, tskIDLE_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create benchmark task");
+        return ESP_ERR_NO_MEM;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (b.status != ESP_OK) {
+        return b.status;
+    }
+
+    double seconds = b.elapsed_us / 1e6;
+    printf(BENCH_PREFIX " side=sta mode=tx run=%u duration_ms=%lld payload=%u rate=%s tx_power=%d attempts=%lu sent=%lu"
+           " no_mem=%lu errors=%lu reject_pct=%.2f fps=%.1f kbps=%.1f cpu_pct=%d\n",
+           b.run, b.elapsed_us / 1000, config->bench_payload_len,
+           config->bench_fixed_rate ? bench_rate_label(config->bench_rate) : "auto", config->wifi_tx_power,
+           b.attempts, b.sent, b.no_mem, b.errors,
+           b.attempts > 0 ? 100.0 * (b.no_mem + b.errors) / b.attempts : 0.0,
+           b.sent / seconds, b.bytes * 8 / seconds / 1000.0, b.cpu_pct);
+    return ESP_OK;
+}
+
+/* Probe awaiting its echo; written by the benchmark, claimed by the receive callback */
+static struct {
+    uint8_t mac[WIFI_MAC_LEN];
+    TaskHandle_t task;
+    uint16_t run;
+    uint32_t seq;               // Last probe sent; increases across sweep points
+    bool waiting;               // Atomic; whoever clears it owns the outcome
+    int64_t rx_us;
+    uint32_t late;              // Echoes of probes already given up on
+} ping_rx;
+
+static void ping_rx_cb(void *buf, wifi_promiscuous_pkt_type_t type)
+{
+    if (type != WIFI_PKT_DATA) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    const wifi_promiscuous_pkt_t *pkt = buf;
+    frame_bench_t bench;
+
+    if (!frame_parse_bench_echo(pkt->payload, pkt->rx_ctrl.sig_len, ping_rx.mac, &bench) ||
+        bench.run != ping_rx.run) {
+        return;
+    }
+    if (bench.seq != ping_rx.seq || !__atomic_exchange_n(&ping_rx.waiting, false, __ATOMIC_ACQ_REL)) {
+        ping_rx.late++;
+        return;
+    }
+    ping_rx.rx_us = now;
+    xTaskNotifyGive(ping_rx.task);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const uint32_t *sorted, uint32_t count, double p)
+{
+    return count == 0 ? 0 : sorted[(uint32_t)(p * (count - 1) + 0.5)];
+}
+
+/* Lower edge in microseconds of a histogram bin */
+static uint32_t rtt_bin_floor(int bin)
+{
+    return (uint32_t)(exp2((double)bin / BENCH_RTT_BINS_PER_OCTAVE) + 0.5);
+}
+
+static int rtt_bin(uint32_t rtt_us)
+{
+    int bin = rtt_us > 0 ? (int)(log2(rtt_us) * BENCH_RTT_BINS_PER_OCTAVE) : 0;
+    return bin < BENCH_RTT_BINS ? bin : BENCH_RTT_BINS - 1;
+}
+
+/* Apply a protocol and wait until the station has reassociated */
+static esp_err_t bench_set_protocol(uint8_t protocol)
+{
+    uint8_t current = 0;
+    if (esp_wifi_get_protocol(WIFI_IF_STA, &current) == ESP_OK && current == protocol) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = esp_wifi_set_protocol(WIFI_IF_STA, protocol);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    // The station event handler reconnects after the disconnect
+    esp_wifi_disconnect();
+    wifi_ap_record_t ap_info;
+    for (int waited = 0; waited < BENCH_CONNECT_TIMEOUT_MS; waited += 100) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(BENCH_SETTLE_MS));
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+/* One sweep point: count probes of payload_len bytes */
+static void bench_ping_point(const scheduler_config_t *config, const frame_addr_t *addr, uint8_t *frame,
+                             uint32_t *rtts, uint8_t protocol, wifi_ps_type_t ps, uint16_t payload_len)
+{
+    uint32_t count = 0, sent = 0, errors = 0;
+    uint32_t bins[BENCH_RTT_BINS] = {0};
+    uint64_t sum = 0;
+    frame_bench_t bench = { .run = ping_rx.run, .flags = FRAME_BENCH_PROBE };
+
+    ping_rx.late = 0;
+    for (uint32_t i = 0; i < config->bench_ping_count; i++) {
+        bench.seq = ping_rx.seq + 1;
+        size_t len = frame_build_bench(frame, FRAME_MAX_LEN, addr, &bench, payload_len,
+                                       (uint32_t)(esp_timer_get_time() / 1000));
+
+        // Drop a notification left by an echo that raced the previous timeout
+        ulTaskNotifyTake(pdTRUE, 0);
+        ping_rx.seq = bench.seq;
+        __atomic_store_n(&ping_rx.waiting, true, __ATOMIC_RELEASE);
+
+        int64_t tx_us = esp_timer_get_time();
+        esp_err_t ret = esp_wifi_80211_tx(WIFI_IF_STA, frame, len, true);
+        if (ret != ESP_OK) {
+            __atomic_store_n(&ping_rx.waiting, false, __ATOMIC_RELEASE);
+            errors++;
+            vTaskDelay(pdMS_TO_TICKS(BENCH_PING_INTERVAL_MS));
+            continue;
+        }
+        sent++;
+
+        bool echoed = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BENCH_PING_TIMEOUT_MS)) > 0;
+        if (!echoed) {
+            // The callback may have claimed the echo just after the timeout
+            echoed = !__atomic_exchange_n(&ping_rx.waiting, false, __ATOMIC_ACQ_REL);
+            if (echoed) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+        }
+        if (echoed) {
+            uint32_t rtt = (uint32_t)(ping_rx.rx_us - tx_us);
+            rtts[count++] = rtt;
+            bins[rtt_bin(rtt)]++;
+            sum += rtt;
+        }
+        vTaskDelay(pdMS_TO_TICKS(BENCH_PING_INTERVAL_MS));
+    }
+
+    qsort(rtts, count, sizeof(rtts[0]), compare_u32);
+    uint32_t lost = sent - count;
+    printf(BENCH_PREFIX " side=sta mode=ping run=%u protocol=%s ps=%s payload=%u probes=%lu errors=%lu echoes=%lu"
+           " lost=%lu loss_pct=%.1f late=%lu rtt_min_us=%lu rtt_p50_us=%lu rtt_p90_us=%lu rtt_p99_us=%lu"
+           " rtt_max_us=%lu rtt_mean_us=%lu\n",
+           ping_rx.run, bench_protocol_label(protocol), bench_ps_label(ps), payload_len, sent, errors, count,
+           lost, sent > 0 ? 100.0 * lost / sent : 0.0, ping_rx.late,
+           count > 0 ? rtts[0] : 0, percentile(rtts, count, 0.5), percentile(rtts, count, 0.9),
+           percentile(rtts, count, 0.99), count > 0 ? rtts[count - 1] : 0,
+           count > 0 ? (uint32_t)(sum / count) : 0);
+
+    // Histogram as lower_edge_us:count for every occupied bin
+    printf(BENCH_PREFIX " side=sta mode=ping_hist run=%u protocol=%s ps=%s payload=%u bins=",
+           ping_rx.run, bench_protocol_label(protocol), bench_ps_label(ps), payload_len);
+    bool first = true;
+    for (int b = 0; b < BENCH_RTT_BINS; b++) {
+        if (bins[b] > 0) {
+            printf("%s%lu:%lu", first ? "" : ",", rtt_bin_floor(b), bins[b]);
+            first = false;
+        }
+    }
+    printf("\n");
+}
+
+esp_err_t bench_ping_run(const scheduler_config_t *config)
+{
+    frame_addr_t addr;
+    uint8_t *frame = malloc(FRAME_MAX_LEN);
+    uint32_t *rtts = malloc(sizeof(uint32_t) * config->bench_ping_count);
+    esp_err_t ret = frame != NULL && rtts != NULL ? bench_frame_addr(&addr) : ESP_ERR_NO_MEM;
+
+    memset(&ping_rx, 0, sizeof(ping_rx));
+    ping_rx.task = xTaskGetCurrentTaskHandle();
+    ping_rx.run = (uint16_t)esp_random();
+
+    // Echoes are FromDS frames the network stack would drop, so catch them here
+    if (ret == ESP_OK) {
+        memcpy(ping_rx.mac, addr.sa, WIFI_MAC_LEN);
+        wifi_promiscuous_filter_t filter = { .filter_mask = WIFI_PROMIS_FILTER_MASK_DATA };
+        esp_wifi_set_promiscuous_filter(&filter);
+        esp_wifi_set_promiscuous_rx_cb(ping_rx_cb);
+        ret = esp_wifi_set_promiscuous(true);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot start latency benchmark: %s", esp_err_to_name(ret));
+        free(frame);
+        free(rtts);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Latency run %u: %u probes x %u sizes x %u power save modes x %u protocols",
+             ping_rx.run, config->bench_ping_count, config->bench_ping_size_count,
+             config->bench_ping_ps_count, config->bench_ping_protocol_count);
+
+    for (int p = 0; p < config->bench_ping_protocol_count && ret == ESP_OK; p++) {
+        uint8_t protocol = config->bench_ping_protocols[p];
+        ret = bench_set_protocol(protocol);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Protocol %s: %s", bench_protocol_label(protocol), esp_err_to_name(ret));
+            break;
+        }
+        for (int m = 0; m < config->bench_ping_ps_count; m++) {
+            wifi_ps_type_t ps = config->bench_ping_ps[m];
+            esp_wifi_set_ps(ps);
+            vTaskDelay(pdMS_TO_TICKS(BENCH_SETTLE_MS));
+            for (int z = 0; z < config->bench_ping_size_count; z++) {
+                bench_ping_point(config, &addr, frame, rtts, protocol, ps, config->bench_ping_sizes[z]);
+            }
+        }
+    }
+
+    esp_wifi_set_promiscuous(false);
+    free(frame);
+    free(rtts);
+    return ret;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file link_bench.h
+ * @brief Link benchmarks run instead of the scheduler ("bench tx", "bench ping")
+ *
+ * bench tx saturates the link with benchmark frames (frame_codec.h) through
+ * esp_wifi_80211_tx for a fixed time and prints one BENCH_PREFIX result
+ * line. The AP counts the frames it receives and prints its own line when
+ * the run ends, so the pair gives offered and delivered throughput for the
+ * configured protocol, TX power and PHY rate.
+ *
+ * bench ping sends one latency probe at a time. The AP echoes each probe
+ * from its receive callback, and the station times the round trip on its
+ * own clock, so no two clocks are mixed. The sweep covers payload sizes,
+ * power save modes and protocols. Each point prints a summary line and a
+ * histogram line with BENCH_RTT_BINS_PER_OCTAVE bins per octave of
+ * microseconds.
+ *
+ * CPU load needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS and is reported
+ * as -1 without it.
+ */
+
+#ifndef LINK_BENCH_H
+#define LINK_BENCH_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+#include "terminal_cmd.h"
+
+#define BENCH_PREFIX             "@BENCH"   // Start of a result line, on station and AP
+#define BENCH_DEFAULT_DURATION_S 10
+#define BENCH_MAX_DURATION_S     600
+#define BENCH_MIN_PAYLOAD        sizeof(frame_bench_t)
+#define BENCH_END_FRAMES         3          // End markers sent after the run
+#define BENCH_END_SPACING_MS     20
+
+#define BENCH_PING_DEFAULT_COUNT  100
+#define BENCH_PING_MAX_COUNT      2000      // RTTs are kept for exact percentiles
+#define BENCH_PING_INTERVAL_MS    50        // Gap between a probe's outcome and the next probe
+#define BENCH_PING_TIMEOUT_MS     500       // A probe without an echo by then is lost
+#define BENCH_SETTLE_MS           500       // Pause after changing the power save mode
+#define BENCH_CONNECT_TIMEOUT_MS  15000     // Reconnection after a protocol change
+#define BENCH_RTT_BINS_PER_OCTAVE 4
+
+/**
+ * @brief Parse a PHY rate option: 1, 2, 5.5, 11 (11b), 6 ... 54 (11g) or mcs0 ... mcs7
+ */
+bool bench_rate_from_option(const char *option, wifi_phy_rate_t *rate);
+
+/**
+ * @brief Label of a rate accepted by bench_rate_from_option(), "?" for others
+ */
+const char *bench_rate_label(wifi_phy_rate_t rate);
+
+/**
+ * @brief Parse a power save mode option: none, min or max
+ */
+bool bench_ps_from_option(const char *option, wifi_ps_type_t *mode);
+
+/**
+ * @brief Parse a protocol option: b, bg or bgn
+ */
+bool bench_protocol_from_option(const char *option, uint8_t *protocol);
+
+const char *bench_ps_label(wifi_ps_type_t mode);
+const char *bench_protocol_label(uint8_t protocol);
+
+/**
+ * @brief Run the transmit benchmark on the connected station and print its result
+ *
+ * Blocks for config->bench_duration_s plus the end markers.
+ *
+ * @return ESP_OK, or the error that stopped the run before it started
+ */
+esp_err_t bench_tx_run(const scheduler_config_t *config);
+
+/**
+ * @brief Run the round-trip latency sweep on the connected station and print its results
+ *
+ * Leaves the last swept power save mode and protocol in place.
+ *
+ * @return ESP_OK, or the error that stopped the sweep
+ */
+esp_err_t bench_ping_run(const scheduler_config_t *config);
+
+#endif /* LINK_BENCH_H */
@@ -7,6 +7,8 @@
 #include <stdlib.h>
 #include "esp_log.h"
 #include "packet_generator.h"
+#include "record_schema.h"
+#include "sample_codec.h"
 
 static const char *TAG = "packet-gen";
 
@@ -20,6 +22,10 @@ esp_err_t create_test_packet(class_id_t class_id, uint16_t count, data_type_t da
 {
     esp_err_t ret = ESP_OK;
     
+    if (data_type_is_schema(data_type)) {
+        return create_test_record_packet(class_id, count, data_type_schema_id(data_type));
+    }
+    
     switch (data_type) {
         case DATA_TYPE_INT8:
             ret = create_test_int8_packet(class_id, count);
@@ -173,4 +179,42 @@ esp_err_t create_test_double_packet(class_id_t class_id, uint16_t count)
     free(values);
     
     return ret;
-}
\ No newline at end of file
+}
+
+/**
+ * Create a test packet of mixed-field records
+ */
+esp_err_t create_test_record_packet(class_id_t class_id, uint16_t count, uint8_t schema_id)
+{
+    const record_schema_t *schema = record_schema_get(schema_id);
+    if (schema == NULL) {
+        ESP_LOGE(TAG, "Schema %d is not defined", schema_id);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Create packed records with native-order fields at the schema offsets
+    uint8_t *records = malloc(count * schema->record_size);
+    if (records == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for schema %d test data", schema_id);
+        return ESP_FAIL;
+    }
+    
+    // Field f of record i holds i * (f + 1), converted to the field type
+    for (int i = 0; i < count; i++) {
+        uint8_t *record = records + i * schema->record_size;
+        for (int f = 0; f < schema->field_count; f++) {
+            double value = (double)i * (f + 1);
+            uint64_t field;  // Aligned temporary; packed fields may sit at odd offsets
+            size_t field_size = sample_narrow(schema->field_types[f], &field, &value, 1);
+            memcpy(record + schema->field_offset[f], &field, field_size);
+        }
+    }
+    
+    // Submit packet with this data
+    esp_err_t ret = scheduler_submit_packet(class_id, records, count);
+    
+    // Free the temporary buffer
+    free(records);
+    
+    return ret;
+}
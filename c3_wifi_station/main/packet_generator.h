@@ -65,4 +65,15 @@ esp_err_t create_test_float_packet(class_id_t class_id, uint16_t count);
  */
 esp_err_t create_test_double_packet(class_id_t class_id, uint16_t count);
 
+/**
+ * @brief Create a test packet of records described by a registered schema
+ * 
+ * @param class_id Class identifier
+ * @param count Number of records
+ * @param schema_id Schema describing the record fields
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for an unknown schema,
+ *         ESP_FAIL on failure
+ */
+esp_err_t create_test_record_packet(class_id_t class_id, uint16_t count, uint8_t schema_id);
+
 #endif /* PACKET_GENERATORS_H */
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "freertos/event_groups.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
@@ -15,31 +16,60 @@
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "esp_mac.h"
+#include "esp_timer.h"
+#include "esp_now.h"
+#include "esp_idf_version.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
 
 #include "terminal_cmd.h"
 #include "packet_generator.h"
+#include "link_bench.h"
+#include "sched_core.h"
+#include "frame_codec.h"
+#include "tx_track.h"
+#include "energy_budget.h"
 
 /* WiFi configuration */
 #define EXAMPLE_ESP_WIFI_SSID      CONFIG_ESP_WIFI_SSID
 #define EXAMPLE_ESP_WIFI_PASS      CONFIG_ESP_WIFI_PASSWORD
 #define EXAMPLE_ESP_MAXIMUM_RETRY  CONFIG_ESP_MAXIMUM_RETRY
 
-/* Scheduler Configuration */
-#define MAX_CLASSES              4     // 3 classes (Class 1: 3s, Class 2: 5s, Class 3: 6s)
-#define MAX_PACKET_SIZE          1400  // Maximum packet data size
-#define MAX_QUEUE_SIZE           50    // Maximum packets per queue
+/* Scheduler Configuration (queue and buffer sizes come from sched_types.h) */
 #define SCHEDULER_CHECK_INTERVAL_MS 50 // How often to check queues
 #define DEADLINE_PROCESSING_THRESHOLD_MS 1000 // Process if deadline is within this threshold
-#define MAX_TX_SIZE              1400  // Maximum data size for transmission buffer
+
+/* TX buffering: frame N+1 is assembled while the driver still has frame N */
+#define TX_BUFFER_COUNT             2
+#define TX_DONE_TIMEOUT_MS          100  // Reclaim a buffer whose TX-done never came
+#define TX_REPORT_QUEUE_LEN         8    // TX-done reports awaiting the scheduler task
+
+/* ESP-NOW carries the frame body (see frame_codec.h); v1 peers take 250 bytes at most */
+#ifdef ESP_NOW_MAX_DATA_LEN_V2
+#define ESPNOW_MAX_BODY             ESP_NOW_MAX_DATA_LEN_V2
+#else
+#define ESPNOW_MAX_BODY             ESP_NOW_MAX_DATA_LEN
+#endif
+#define ESPNOW_MAX_TX_SIZE          (ESPNOW_MAX_BODY - sizeof(data_packet_header_t) - \
+                                     SAMPLE_TIME_MAX_LEN - FRAME_CRC_LEN)
+
+/* TX failures that override the RSSI-based power choice */
+#define TX_FAIL_MIN_FRAMES          10   // Outcomes needed in an interval before acting on them
+#define TX_FAIL_RAISE_PCT           10   // Step power up at this failure rate
+
+/* Energy-budget degradation (see energy_budget.h) */
+#define ENERGY_BATCH_THRESHOLD_MS   (2 * SCHEDULER_CHECK_INTERVAL_MS) // Latest send that still meets deadlines
+#define ENERGY_POWER_CAP            TX_POWER_LOW  // TX power cap from ENERGY_LEVEL_LOW_POWER on
 
 /* FreeRTOS event group to signal when we are connected */
 static EventGroupHandle_t s_wifi_event_group;
 
 static uint32_t tx_packet_counter = 1;
 
+/* Data frames sent since the last schema announcement; starts due */
+static uint32_t frames_since_schema_announce = CONFIG_SCHED_SCHEMA_ANNOUNCE_INTERVAL;
+
 /* The event group allows multiple bits for each event, but we only care about two events:
  * - we are connected to the AP with an IP
  * - we failed to connect after the maximum amount of retries */
@@ -50,141 +80,61 @@ static const char *TAG = "wifi-sta-sender";
 
 static int s_retry_num = 0;
 
-/* Internal queue packet structure */
-typedef struct {
-    class_id_t class_id;          // Class identifier (0, 1, 2)
-    uint32_t deadline;            // Absolute deadline for this packet (in ms)
-    data_type_t data_type;        // Type of data contained
-    uint16_t data_count;          // Number of data elements
-    uint16_t size;                // Actual data size in bytes (not include header)
-    uint8_t data[MAX_PACKET_SIZE]; // Packet data
-} queue_packet_t;
-
-/* Node structure for the linked list queue */
-typedef struct queue_node {
-    queue_packet_t packet;
-    struct queue_node *next;
-} queue_node_t;
-
-/* Queue structure */
-typedef struct {
-    queue_node_t *head;
-    queue_node_t *tail;
-    int count;
-} packet_queue_t;
-
-/* Updated data packet header (now includes all necessary information) */
-typedef struct {
-    uint8_t class_counts[MAX_CLASSES];      // Number of items for each class
-    data_type_t class_types[MAX_CLASSES];   // Data type for each class
-    uint16_t total_size;                    // Total size of all data in bytes
-    uint32_t timestamp;                     // Transmission timestamp
-} __attribute__((packed)) data_packet_header_t;
-
 /* Scheduler context */
 typedef struct {
-    packet_queue_t packet_queues[MAX_CLASSES]; // Separate queue for each class
+    sched_core_t core;            // Queues, class configuration and statistics
     SemaphoreHandle_t mutex;      // Mutex for operations
     TaskHandle_t scheduler_task;  // Scheduler task handle
     TaskHandle_t packet_creator_task; // Packet creator task handle
-    
-    // Class information
-    data_type_t class_types[MAX_CLASSES];  // Data type for each class
-    uint32_t class_periods[MAX_CLASSES];   // Period for each class (ms)
-    uint32_t class_deadlines[MAX_CLASSES]; // Deadline for each class (ms)
-    uint32_t processing_threshold;         // Deadline processing threshold (ms)
-    
-    // Statistics
-    uint32_t packets_processed;   // Total packets processed
-    uint32_t packets_transmitted; // Packets successfully transmitted
-    uint32_t deadline_misses;     // Packets that missed deadlines
     uint32_t current_time_ms;     // Current time in milliseconds
+    bool wmm_enabled;             // Send QoS data frames
+    wmm_ac_t class_access[MAX_CLASSES]; // Access category for each class
+    bool espnow;                  // Frame bodies go to espnow_peer over ESP-NOW
+    uint8_t espnow_peer[WIFI_MAC_LEN];  // The AP, registered as an ESP-NOW peer
+    tx_track_t tx;                // TX outcomes from the driver's TX-done reports
+    energy_budget_t energy;       // Modelled spend against the budget (mj_per_hour 0: off)
+    uint32_t base_threshold;      // Configured processing threshold
+    int8_t base_tx_power;         // Configured TX power, restored when the budget recovers
+    uint32_t shed_packets;        // Packets refused at ENERGY_LEVEL_SHED
+    uint32_t held_block_bytes;    // Held blocks sent for send-on-delta classes
 } scheduler_context_t;
 
 
 /* Global scheduler context */
 static scheduler_context_t scheduler_ctx;
 
+/* Frame buffers, reused round-robin as the driver's TX-done callback hands them back */
+typedef struct {
+    uint8_t frames[TX_BUFFER_COUNT][FRAME_MAX_LEN];
+    uint8_t data[MAX_TX_SIZE + SAMPLE_TIME_MAX_LEN]; // Batch staging: class data plus sample time block
+    uint8_t next;                 // Next buffer to fill; the oldest in flight when all are
+    uint8_t in_flight;            // Buffers the driver has not reported done
+    QueueHandle_t done;           // tx_report_t per sent frame; NULL when TX-done is unavailable
+} tx_buffers_t;
+
+/* One TX-done report, queued by the driver callback for the scheduler task */
+typedef struct {
+    bool ok;
+    bool tagged;                  // The driver handed the frame back: tag is its CRC trailer
+    uint32_t tag;
+    uint32_t done_us;
+} tx_report_t;
+
+/* Only the scheduler task fills and sends buffers */
+static tx_buffers_t tx_buffers;
+
 /* Function prototypes */
 static void scheduler_task(void *pvParameters);
 static void process_packets(void);
-static esp_err_t send_data_packet(uint8_t *data, uint16_t size, uint8_t class_counts[MAX_CLASSES]);
+static bool send_next_batch(uint32_t current_time);
+static void update_energy_budget(uint32_t current_time);
+static int tx_collect_reports(TickType_t wait);
+static esp_err_t send_data_packet(uint8_t *data, uint16_t size, const sched_batch_t *batch);
+static void send_schema_announcement(void);
 static void random_packet_task(void *pvParameters);
 void wifi_init_sta(scheduler_config_t *config);
 static void adjust_tx_power_by_rssi(scheduler_config_t *config);
 
-/* Queue functions */
-static void queue_init(packet_queue_t *queue) {
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->count = 0;
-}
-
-/* Add packet to the end of queue */
-static bool queue_enqueue(packet_queue_t *queue, queue_packet_t *packet) {
-    if (queue->count >= MAX_QUEUE_SIZE) {
-        return false;  // Queue is full
-    }
-    
-    queue_node_t *new_node = (queue_node_t*)malloc(sizeof(queue_node_t));
-    if (!new_node) {
-        return false;  // Memory allocation failed
-    }
-    
-    // Copy packet data
-    memcpy(&new_node->packet, packet, sizeof(queue_packet_t));
-    new_node->next = NULL;
-    
-    // Add to queue
-    if (queue->count == 0) {
-        // First packet
-        queue->head = new_node;
-        queue->tail = new_node;
-    } else {
-        // Add to end
-        queue->tail->next = new_node;
-        queue->tail = new_node;
-    }
-    
-    queue->count++;
-    return true;
-}
-
-/* Remove and return packet from the front of queue */
-static bool queue_dequeue(packet_queue_t *queue, queue_packet_t *packet) {
-    if (queue->count == 0) {
-        return false;  // Queue is empty
-    }
-    
-    queue_node_t *node = queue->head;
-    
-    // Copy packet data
-    memcpy(packet, &node->packet, sizeof(queue_packet_t));
-    
-    // Update queue
-    queue->head = node->next;
-    queue->count--;
-    
-    if (queue->count == 0) {
-        queue->tail = NULL;
-    }
-    
-    // Free node
-    free(node);
-    return true;
-}
-
-/* Peek at the front packet without removing it */
-static bool queue_peek(packet_queue_t *queue, queue_packet_t *packet) {
-    if (queue->count == 0) {
-        return false;  // Queue is empty
-    }
-    
-    // Copy packet data
-    memcpy(packet, &queue->head->packet, sizeof(queue_packet_t));
-    return true;
-}
-
 /* Get the current time in milliseconds */
 static uint32_t get_current_time_ms(void)
 {
@@ -201,18 +151,7 @@ static uint32_t find_earliest_deadline(void)
         return earliest_deadline;
     }
     
-    // Check each class queue
-    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
-        packet_queue_t *queue = &scheduler_ctx.packet_queues[class_id];
-        
-        // If queue is not empty, check the first packet's deadline
-        if (queue->head != NULL) {
-            uint32_t deadline = queue->head->packet.deadline;
-            if (deadline < earliest_deadline) {
-                earliest_deadline = deadline;
-            }
-        }
-    }
+    earliest_deadline = sched_core_earliest_deadline(&scheduler_ctx.core);
     
     xSemaphoreGive(scheduler_ctx.mutex);
     return earliest_deadline;
@@ -386,9 +325,14 @@ esp_err_t scheduler_set_class_type(class_id_t class_id, data_type_t data_type)
     }
     
     if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-        scheduler_ctx.class_types[class_id] = data_type;
+        scheduler_ctx.core.class_types[class_id] = data_type;
         xSemaphoreGive(scheduler_ctx.mutex);
         
+        // Announce a newly used schema before the next data frame
+        if (data_type_is_schema(data_type)) {
+            frames_since_schema_announce = CONFIG_SCHED_SCHEMA_ANNOUNCE_INTERVAL;
+        }
+        
         ESP_LOGI(TAG, "Set class %d data type to %d", class_id, data_type);
         return ESP_OK;
     }
@@ -405,65 +349,111 @@ esp_err_t scheduler_submit_packet(class_id_t class_id, const void *data, uint16_
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Get data type for this class
-    data_type_t data_type = scheduler_ctx.class_types[class_id];
-    
-    // Calculate size based on data type and count
-    uint16_t element_size = 0;
-    switch (data_type) {
-        case DATA_TYPE_INT8:   element_size = 1; break;
-        case DATA_TYPE_INT16:  element_size = 2; break;
-        case DATA_TYPE_INT32:  element_size = 4; break;
-        case DATA_TYPE_FLOAT:  element_size = 4; break;
-        case DATA_TYPE_DOUBLE: element_size = 8; break;
-    }
-    
-    uint16_t total_size = element_size * count;
-    if (total_size > MAX_PACKET_SIZE) {
-        ESP_LOGE(TAG, "Data too large: %d bytes (max: %d)", total_size, MAX_PACKET_SIZE);
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    // Create queue packet
-    queue_packet_t packet = {0};
-    
-    // Set class info
-    packet.class_id = class_id;
-    packet.data_type = data_type;
-    packet.data_count = count;
-    packet.size = total_size;
-    
-    // Set deadline based on class - use configurable deadlines now
     uint32_t current_time = get_current_time_ms();
-    packet.deadline = current_time + scheduler_ctx.class_deadlines[class_id];
-    
-    // Copy data
-    if (data != NULL && total_size > 0) {
-        memcpy(packet.data, data, total_size);
-    }
+    sched_status_t status = SCHED_ERR_QUEUE_FULL;
     
     // Submit packet to the appropriate queue with mutex protection
+    bool shed = false;
     if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-        bool success = queue_enqueue(&scheduler_ctx.packet_queues[class_id], &packet);
+        // An overdrawn energy budget drops best-effort traffic at the source
+        shed = class_id == CLASS_RANDOM && scheduler_ctx.energy.mj_per_hour > 0 &&
+               scheduler_ctx.energy.level == ENERGY_LEVEL_SHED;
+        if (shed) {
+            scheduler_ctx.shed_packets++;
+        } else {
+            status = sched_core_submit(&scheduler_ctx.core, class_id, data, count, current_time);
+        }
         xSemaphoreGive(scheduler_ctx.mutex);
-        
-        if (!success) {
+    } else {
+        return ESP_FAIL;
+    }
+    
+    if (shed) {
+        ESP_LOGD(TAG, "Energy budget overdrawn, shedding class %d packet", class_id + 1);
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    switch (status) {
+        case SCHED_OK:
+            return ESP_OK;
+        case SCHED_ERR_TOO_LARGE:
+            ESP_LOGE(TAG, "Data too large: %d elements of type %s (max: %d bytes)",
+                     count, data_type_name(scheduler_ctx.core.class_types[class_id]), MAX_PACKET_SIZE);
+            return ESP_ERR_INVALID_ARG;
+        case SCHED_ERR_INVALID_ARG:
+            ESP_LOGE(TAG, "Invalid data type for class %d", class_id);
+            return ESP_ERR_INVALID_ARG;
+        default:
             ESP_LOGE(TAG, "Failed to queue packet: Queue %d full", class_id);
             return ESP_FAIL;
+    }
+}
+
+/* Largest TX power the energy budget allows */
+static int8_t energy_power_cap(energy_level_t level)
+{
+    return level >= ENERGY_LEVEL_LOW_POWER ? ENERGY_POWER_CAP : TX_POWER_HIGH;
+}
+
+/* Accrue the energy budget and apply its degradation level on a change */
+static void update_energy_budget(uint32_t current_time)
+{
+    energy_level_t previous = ENERGY_LEVEL_NORMAL, level = ENERGY_LEVEL_NORMAL;
+    if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+    previous = scheduler_ctx.energy.level;
+    level = energy_budget_update(&scheduler_ctx.energy, current_time);
+    if (level != previous) {
+        // Batch harder by sending only when deadlines force it
+        uint32_t threshold = scheduler_ctx.base_threshold;
+        if (level >= ENERGY_LEVEL_BATCH && threshold > ENERGY_BATCH_THRESHOLD_MS) {
+            threshold = ENERGY_BATCH_THRESHOLD_MS;
         }
-    } else {
-        return ESP_FAIL;
+        scheduler_ctx.core.processing_threshold = threshold;
     }
+    xSemaphoreGive(scheduler_ctx.mutex);
     
-    return ESP_OK;
+    if (level == previous) {
+        return;
+    }
+    ESP_LOGW(TAG, "Energy budget level %s -> %s", energy_level_name(previous), energy_level_name(level));
+    
+    int8_t power = 0;
+    int8_t cap = energy_power_cap(level);
+    if (esp_wifi_get_max_tx_power(&power) != ESP_OK) {
+        return;
+    }
+    if (power > cap) {
+        esp_wifi_set_max_tx_power(cap);
+    } else if (cap > power && power < scheduler_ctx.base_tx_power) {
+        // Cap lifted: back to the configured power (auto TX power readjusts from there)
+        esp_wifi_set_max_tx_power(scheduler_ctx.base_tx_power < cap ? scheduler_ctx.base_tx_power : cap);
+    }
 }
 
-/* Process and transmit packets with fixed class order */
+/* Process and transmit packets using the configured batch policy */
 static void process_packets(void)
 {
     uint32_t current_time = get_current_time_ms();
     scheduler_ctx.current_time_ms = current_time;
     
+    // Keep TX outcomes current even while nothing is sent
+    if (tx_buffers.done != NULL) {
+        tx_collect_reports(0);
+    }
+    
+    if (scheduler_ctx.energy.mj_per_hour > 0) {
+        update_energy_budget(current_time);
+    }
+    
+    // Count frames that send-on-delta kept off the air
+    if (scheduler_ctx.core.dedup_mask != 0 &&
+        xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        sched_core_dedup_tick(&scheduler_ctx.core, current_time);
+        xSemaphoreGive(scheduler_ctx.mutex);
+    }
+    
     // Find earliest deadline first
     uint32_t earliest_deadline = find_earliest_deadline();
     
@@ -474,7 +464,7 @@ static void process_packets(void)
     
     // Check if we need to process now based on deadline threshold
     // Use the configurable threshold from scheduler context instead of the fixed macro
-    if (earliest_deadline > current_time + scheduler_ctx.processing_threshold) {
+    if (earliest_deadline > current_time + scheduler_ctx.core.processing_threshold) {
         ESP_LOGD(TAG, "Earliest deadline not approaching yet: %lu, current time: %lu", 
                  earliest_deadline, current_time);
         return; // No urgency to process
@@ -483,79 +473,48 @@ static void process_packets(void)
     ESP_LOGI(TAG, "Processing packets - earliest deadline approaching: %lu, current time: %lu", 
              earliest_deadline, current_time);
     
-    // Allocate data buffer
-    uint8_t *data_buffer = malloc(MAX_TX_SIZE);
-    if (data_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate data buffer");
-        return;
+    // Burst while data stays due; each batch is built while the driver sends the previous frame
+    bool due = true;
+    while (due && send_next_batch(current_time)) {
+        current_time = get_current_time_ms();
+        scheduler_ctx.current_time_ms = current_time;
+        due = false;
+        if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+            due = sched_core_due(&scheduler_ctx.core, current_time);
+            xSemaphoreGive(scheduler_ctx.mutex);
+        }
     }
+}
+
+/* Build one batch and send it, returning whether a data frame went out */
+static bool send_next_batch(uint32_t current_time)
+{
+    uint8_t *data_buffer = tx_buffers.data;
     
-    // Clear buffer
-    memset(data_buffer, 0, MAX_TX_SIZE);
-    uint8_t *data_ptr = data_buffer;
-    uint16_t remaining_space = MAX_TX_SIZE;
-    uint8_t class_counts[MAX_CLASSES] = {0};
+    // Drop expired packets and fill the buffer under the scheduler policy
+    sched_batch_t batch = {0};
+    if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        // Send-on-delta classes may need a held block next to the class data
+        uint16_t capacity = scheduler_ctx.espnow && ESPNOW_MAX_TX_SIZE < MAX_TX_SIZE ?
+                            ESPNOW_MAX_TX_SIZE : MAX_TX_SIZE;
+        capacity -= scheduler_ctx.core.dedup_mask != 0 ? SAMPLE_HELD_MAX_LEN : 0;
+        sched_core_build_batch(&scheduler_ctx.core, current_time, data_buffer, capacity, &batch);
+        xSemaphoreGive(scheduler_ctx.mutex);
+    }
     
-    // Process packets in FIXED CLASS ORDER: Class 1 → Class 2 → Class 3
-    // No matter what the deadlines are, we always maintain this order in the buffer
     for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
-        queue_packet_t packet;
-        bool packet_available = false;
-        
-        // Take mutex for queue operations
-        if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-            // Process all available packets from this class that fit in buffer
-            while (queue_peek(&scheduler_ctx.packet_queues[class_id], &packet)) {
-                // Check if packet fits in remaining space
-                if (packet.size > remaining_space) {
-                    // Stop processing this class if packet doesn't fit
-                    break;
-                }
-                
-                // Dequeue the packet
-                queue_dequeue(&scheduler_ctx.packet_queues[class_id], &packet);
-                packet_available = true;
-                
-                // Skip packets that missed deadline
-                if (current_time > packet.deadline) {
-                    ESP_LOGW(TAG, "Class %d packet missed deadline: Deadline=%lu, Current=%lu",
-                            class_id + 1, packet.deadline, current_time);
-                    
-                    scheduler_ctx.deadline_misses++;
-                    scheduler_ctx.packets_processed++;
-                    
-                    // Skip this packet (don't include in buffer)
-                    packet_available = false;
-                    continue;
-                }
-                
-                // We have a valid packet that fits, copy it to buffer
-                if (packet_available) {
-                    memcpy(data_ptr, packet.data, packet.size);
-                    data_ptr += packet.size;
-                    remaining_space -= packet.size;
-                    
-                    // Update class count (how many data items per class)
-                    class_counts[class_id] += packet.data_count;
-                    
-                    scheduler_ctx.packets_processed++;
-                    
-                    ESP_LOGI(TAG, "Added Class %d packet to transmission: Size=%d, Deadline=%lu",
-                            class_id + 1, packet.size, packet.deadline);
-                    
-                    // If buffer is nearly full, stop adding more packets
-                    if (remaining_space < 100) {
-                        break;
-                    }
-                }
-            }
-            
-            xSemaphoreGive(scheduler_ctx.mutex);
+        if (batch.class_misses[class_id] > 0) {
+            ESP_LOGW(TAG, "Class %d: %d packet(s) missed deadline, Current=%lu",
+                    class_id + 1, batch.class_misses[class_id], current_time);
+        }
+        if (batch.class_packets[class_id] > 0) {
+            ESP_LOGI(TAG, "Added %d Class %d packet(s) to transmission: Items=%d",
+                    batch.class_packets[class_id], class_id + 1, batch.class_counts[class_id]);
         }
     }
     
     // Calculate actual data size
-    uint16_t actual_data_size = MAX_TX_SIZE - remaining_space;
+    uint16_t actual_data_size = batch.size;
     
     // Count how many different classes were included
     ESP_LOGI(TAG, "==========Sending buffer #%lu...================", tx_packet_counter);
@@ -564,33 +523,254 @@ static void process_packets(void)
 
     
     // Send data if we have any
-    if (actual_data_size > 0) {
-        esp_err_t ret = send_data_packet(data_buffer, actual_data_size, class_counts);
-        
-        if (ret == ESP_OK) {
-            if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-                // Count how many class types were transmitted
-                scheduler_ctx.packets_transmitted += 
-                    (class_counts[0] > 0 ? 1 : 0) + 
-                    (class_counts[1] > 0 ? 1 : 0) + 
-                    (class_counts[2] > 0 ? 1 : 0) +
-                    (class_counts[3] > 0 ? 1 : 0);
-                xSemaphoreGive(scheduler_ctx.mutex);
-            }
+    if (actual_data_size == 0) {
+        ESP_LOGW(TAG, "No data to transmit after processing");
+        return false;
+    }
+    
+    // Re-announce schemas periodically in case the AP missed one
+    if (frames_since_schema_announce >= CONFIG_SCHED_SCHEMA_ANNOUNCE_INTERVAL) {
+        send_schema_announcement();
+    }
+    frames_since_schema_announce++;
+    
+    esp_err_t ret = send_data_packet(data_buffer, actual_data_size, &batch);
+    if (ret != ESP_OK) {
+        return false;
+    }
+    
+    if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        sched_core_batch_sent(&scheduler_ctx.core, &batch);
+        xSemaphoreGive(scheduler_ctx.mutex);
+    }
+    return true;
+}
+
+/* CRC trailer at the end of a frame, which tells TX-done reports apart */
+static uint32_t frame_tag(const uint8_t *frame, size_t len)
+{
+    const uint8_t *crc = frame + len - FRAME_CRC_LEN;
+    return (uint32_t)crc[0] | ((uint32_t)crc[1] << 8) | ((uint32_t)crc[2] << 16) | ((uint32_t)crc[3] << 24);
+}
+
+/* Driver TX-done callback (wifi task): queue the outcome, which also hands a frame buffer back */
+static void on_tx_done(const esp_80211_tx_info_t *tx_info)
+{
+    if (tx_info->ifidx != WIFI_IF_STA || tx_buffers.done == NULL) {
+        return;
+    }
+    tx_report_t report = {
+        .ok = tx_info->tx_status == WIFI_SEND_SUCCESS,
+        .done_us = (uint32_t)esp_timer_get_time(),
+    };
+    if (tx_info->data != NULL && tx_info->data_len >= WIFI_DATA_HEADER_LEN + FRAME_CRC_LEN) {
+        report.tagged = true;
+        report.tag = frame_tag(tx_info->data, tx_info->data_len);
+    }
+    xQueueSend(tx_buffers.done, &report, 0);
+}
+
+/* ESP-NOW send callback (wifi task): the same report as on_tx_done(), untagged */
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+static void on_espnow_sent(const esp_now_send_info_t *tx_info, esp_now_send_status_t status)
+#else
+static void on_espnow_sent(const uint8_t *mac_addr, esp_now_send_status_t status)
+#endif
+{
+    if (tx_buffers.done == NULL) {
+        return;
+    }
+    tx_report_t report = {
+        .ok = status == ESP_NOW_SEND_SUCCESS,
+        .done_us = (uint32_t)esp_timer_get_time(),
+    };
+    xQueueSend(tx_buffers.done, &report, 0);
+}
+
+/* Register the AP as the only ESP-NOW peer, on the channel we are connected on */
+static esp_err_t espnow_init(void)
+{
+    wifi_ap_record_t ap_info;
+    esp_err_t ret = esp_wifi_sta_get_ap_info(&ap_info);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = esp_now_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (tx_buffers.done != NULL) {
+        esp_now_register_send_cb(on_espnow_sent);
+    }
+    
+    esp_now_peer_info_t peer = {
+        .channel = 0,
+        .ifidx = WIFI_IF_STA,
+        .encrypt = false,
+    };
+    memcpy(peer.peer_addr, ap_info.bssid, WIFI_MAC_LEN);
+    ret = esp_now_add_peer(&peer);
+    if (ret != ESP_OK && ret != ESP_ERR_ESPNOW_EXIST) {
+        esp_now_deinit();
+        return ret;
+    }
+    
+    memcpy(scheduler_ctx.espnow_peer, ap_info.bssid, WIFI_MAC_LEN);
+    return ESP_OK;
+}
+
+/*
+ * Match queued TX-done reports to sent frames, waiting up to @p wait for the
+ * first; returns the frame buffers handed back. A report for a frame already
+ * reclaimed hands nothing back.
+ */
+static int tx_collect_reports(TickType_t wait)
+{
+    tx_report_t report;
+    int retired = 0;
+    
+    while (xQueueReceive(tx_buffers.done, &report, retired == 0 ? wait : 0) == pdTRUE) {
+        uint32_t seq = TX_TRACK_SEQ_NONE;
+        int done = 0;
+        if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+            done = tx_track_done(&scheduler_ctx.tx, report.tagged ? &report.tag : NULL, report.ok,
+                                 report.done_us, &seq);
+            xSemaphoreGive(scheduler_ctx.mutex);
+        }
+        retired += done;
+        tx_buffers.in_flight -= done < tx_buffers.in_flight ? done : tx_buffers.in_flight;
+        if (done > 0 && !report.ok && seq != TX_TRACK_SEQ_NONE) {
+            ESP_LOGW(TAG, "Frame #%lu was not delivered", seq);
+        }
+    }
+    return retired;
+}
+
+/* Return the next frame buffer, waiting for the driver if all are in flight */
+static uint8_t *tx_buffer_acquire(void)
+{
+    if (tx_buffers.done == NULL) {
+        return tx_buffers.frames[tx_buffers.next];
+    }
+    
+    // Collect reports that arrived since the last frame
+    tx_collect_reports(0);
+    
+    if (tx_buffers.in_flight == TX_BUFFER_COUNT &&
+        tx_collect_reports(pdMS_TO_TICKS(TX_DONE_TIMEOUT_MS)) == 0) {
+        // The report was lost (e.g. across a disconnect); the frame is long gone
+        ESP_LOGW(TAG, "No TX-done within %d ms, reclaiming frame buffer %d",
+                 TX_DONE_TIMEOUT_MS, tx_buffers.next);
+        tx_buffers.in_flight--;
+        if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+            tx_track_lost(&scheduler_ctx.tx);
+            xSemaphoreGive(scheduler_ctx.mutex);
         }
+    }
+    
+    return tx_buffers.frames[tx_buffers.next];
+}
+
+/* Hand the buffer from tx_buffer_acquire() to the driver; @p seq identifies it in TX-done reports */
+static esp_err_t tx_buffer_send(size_t len, uint32_t seq)
+{
+    uint32_t sent_us = (uint32_t)esp_timer_get_time();
+    uint32_t tag = frame_tag(tx_buffers.frames[tx_buffers.next], len);
+    esp_err_t ret;
+    if (scheduler_ctx.espnow) {
+        // ESP-NOW takes the frame body; its send callback reports the outcome like TX-done
+        ret = esp_now_send(scheduler_ctx.espnow_peer, tx_buffers.frames[tx_buffers.next] + WIFI_DATA_HEADER_LEN,
+                           len - WIFI_DATA_HEADER_LEN);
     } else {
-        ESP_LOGW(TAG, "No data to transmit after processing");
+        ret = esp_wifi_80211_tx(WIFI_IF_STA, tx_buffers.frames[tx_buffers.next], len, true);
     }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    tx_buffers.next = (tx_buffers.next + 1) % TX_BUFFER_COUNT;
+    tx_buffers.in_flight++;
     
-    // Free the data buffer
-    free(data_buffer);
+    int8_t power = TX_POWER_HIGH;
+    if (scheduler_ctx.energy.mj_per_hour > 0) {
+        esp_wifi_get_max_tx_power(&power);
+    }
+    if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        if (tx_buffers.done != NULL) {
+            tx_track_sent(&scheduler_ctx.tx, seq, tag, sent_us);
+        }
+        if (scheduler_ctx.energy.mj_per_hour > 0) {
+            energy_budget_frame(&scheduler_ctx.energy, len, power);
+        }
+        xSemaphoreGive(scheduler_ctx.mutex);
+    }
+    return ret;
+}
+
+/* Fill in 802.11 addresses: destination and BSSID are the AP, source is us */
+static void get_frame_addr(frame_addr_t *addr)
+{
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+        memcpy(addr->da, ap_info.bssid, WIFI_MAC_LEN);
+        memcpy(addr->bssid, ap_info.bssid, WIFI_MAC_LEN);
+    } else {
+        // Fallback to broadcast
+        memset(addr->da, 0xFF, WIFI_MAC_LEN);
+        memset(addr->bssid, 0xFF, WIFI_MAC_LEN);
+    }
+    
+    esp_wifi_get_mac(WIFI_IF_STA, addr->sa);
+}
+
+/* Announce the record schemas used by any class so the AP can decode them */
+static void send_schema_announcement(void)
+{
+    uint8_t schema_ids[MAX_CLASSES];
+    size_t id_count = 0;
+    
+    if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        for (int i = 0; i < MAX_CLASSES; i++) {
+            if (data_type_is_schema(scheduler_ctx.core.class_types[i])) {
+                schema_ids[id_count++] = data_type_schema_id(scheduler_ctx.core.class_types[i]);
+            }
+        }
+        xSemaphoreGive(scheduler_ctx.mutex);
+    }
+    
+    if (id_count == 0) {
+        // All classes use plain data types; check again after another interval
+        frames_since_schema_announce = 0;
+        return;
+    }
+    
+    frame_addr_t addr;
+    get_frame_addr(&addr);
+    
+    uint8_t *frame = tx_buffer_acquire();
+    size_t frame_len = frame_build_schema(frame, FRAME_MAX_LEN, &addr, schema_ids, id_count,
+                                          get_current_time_ms());
+    if (frame_len == 0) {
+        ESP_LOGE(TAG, "Failed to build schema announcement");
+        return;
+    }
+    
+    esp_err_t ret = tx_buffer_send(frame_len, TX_TRACK_SEQ_NONE);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to send schema announcement: %s", esp_err_to_name(ret));
+        return;
+    }
+    
+    frames_since_schema_announce = 0;
+    ESP_LOGI(TAG, "  Announced %d record schema(s)", id_count);
 }
 
 /* Send the data packet with all class data and type information */
-static esp_err_t send_data_packet(uint8_t *data, uint16_t size, uint8_t class_counts[MAX_CLASSES])
+static esp_err_t send_data_packet(uint8_t *data, uint16_t size, const sched_batch_t *batch)
 {
-    // Increment the transmission counter
-    tx_packet_counter++;
+    // Number this frame (logged as "Sending buffer #") and advance the counter
+    uint32_t frame_seq = tx_packet_counter++;
 
     // Verify size is valid
     if (size > MAX_TX_SIZE) {
@@ -598,83 +778,75 @@ static esp_err_t send_data_packet(uint8_t *data, uint16_t size, uint8_t class_co
         size = MAX_TX_SIZE;  // Truncate to maximum
     }
     
-    // Create proper 802.11 data frame header
-    const size_t HEADER_SIZE = 24;  // Basic 802.11 header size
-    
     // Create data packet header
     data_packet_header_t header = {0};
     header.total_size = size;
     header.timestamp = get_current_time_ms();
     
     // Copy class counts and types
-    for (int i = 0; i < MAX_CLASSES; i++) {
-        header.class_counts[i] = class_counts[i];
-        
-        // Get class type from scheduler context
+    uint32_t class_periods[MAX_CLASSES];
+    wmm_ac_t class_access[MAX_CLASSES];
+    bool wmm_enabled = false;
+    memcpy(header.class_counts, batch->class_counts, sizeof(header.class_counts));
+    if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(header.class_types, scheduler_ctx.core.class_types, sizeof(header.class_types));
+        memcpy(class_periods, scheduler_ctx.core.class_periods, sizeof(class_periods));
+        memcpy(class_access, scheduler_ctx.class_access, sizeof(class_access));
+        wmm_enabled = scheduler_ctx.wmm_enabled;
+        xSemaphoreGive(scheduler_ctx.mutex);
+    }
+    
+    // Report groups held back by send-on-delta and mark the class's last group;
+    // the batch left room for them
+    if (batch->held.count > 0 || batch->held.mark_count > 0) {
+        size_t held_len = sample_held_encode(data + size, SAMPLE_HELD_MAX_LEN, &batch->held);
+        if (held_len > 0) {
+            header.flags |= FRAME_FLAG_HELD;
+            size += held_len;
+            header.total_size = size;
+        }
         if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-            header.class_types[i] = scheduler_ctx.class_types[i];
+            scheduler_ctx.held_block_bytes += held_len;
             xSemaphoreGive(scheduler_ctx.mutex);
         }
     }
     
-    // Calculate total buffer size needed
-    size_t packet_size = HEADER_SIZE + sizeof(data_packet_header_t) + size;
-    
-    // Allocate buffer for 802.11 header + our header + data
-    uint8_t *packet_buffer = malloc(packet_size);
-    if (packet_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate packet buffer");
-        return ESP_FAIL;
+    // Append sample capture times after the class data (data has room for them)
+    if (batch->times.class_mask != 0) {
+        size_t time_len = sample_time_encode(data + size, SAMPLE_TIME_MAX_LEN, header.timestamp,
+                                             class_periods, &batch->times);
+        if (time_len > 0) {
+            header.flags |= FRAME_FLAG_SAMPLE_TIMES;
+            size += time_len;
+            header.total_size = size;
+            ESP_LOGD(TAG, "Sample time block: %d bytes", time_len);
+        } else {
+            ESP_LOGW(TAG, "Sample times do not fit in %d bytes, sending without", SAMPLE_TIME_MAX_LEN);
+        }
     }
     
-    // Clear buffer to ensure all padding bytes are zero
-    memset(packet_buffer, 0, packet_size);
-    
-    // Setup 802.11 header
-    // Frame Control: Data frame (0x08) with FromDS=0, ToDS=1 (Station to AP)
-    packet_buffer[0] = 0x08;  // Data frame type
-    packet_buffer[1] = 0x01;  // FromDS=0, ToDS=1
-    
-    // Set destination address (AP MAC)
-    wifi_ap_record_t ap_info;
-    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
-        memcpy(&packet_buffer[4], ap_info.bssid, 6);
-    } else {
-        // Fallback to broadcast
-        memset(&packet_buffer[4], 0xFF, 6);
-    }
+    frame_addr_t addr;
+    get_frame_addr(&addr);
     
-    // Set source address - our own MAC address
-    uint8_t mac[6];
-    esp_wifi_get_mac(WIFI_IF_STA, mac);
-    memcpy(&packet_buffer[10], mac, 6);
+    // Frame buffer for 802.11 (QoS) header + our header + data + CRC, free once the driver is done with it
+    size_t packet_size;
+    uint8_t *packet_buffer = tx_buffer_acquire();
     
-    // Set BSSID in the header as well
-    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
-        memcpy(&packet_buffer[16], ap_info.bssid, 6);
+    // With WMM the frame contends in the category of its most urgent class; ESP-NOW drops the header
+    if (wmm_enabled && !scheduler_ctx.espnow) {
+        wmm_ac_t ac = frame_access_category(header.class_counts, class_access);
+        packet_size = frame_build_qos(packet_buffer, FRAME_MAX_LEN, &addr, ac, &header, data);
+        ESP_LOGD(TAG, "QoS data frame: AC=%s TID=%d", wmm_ac_name(ac), wmm_ac_tid(ac));
     } else {
-        // Fallback
-        memset(&packet_buffer[16], 0xFF, 6);
+        packet_size = frame_build(packet_buffer, FRAME_MAX_LEN, &addr, &header, data);
     }
     
     // Debug: Log header size and data sizes
     ESP_LOGD(TAG, "Header size: %d, Data size: %d, Total packet size: %d", 
              sizeof(data_packet_header_t), size, packet_size);
     
-    // Copy our header after the 802.11 header
-    memcpy(packet_buffer + HEADER_SIZE, &header, sizeof(data_packet_header_t));
-    
-    // Copy data after our header
-    if (data != NULL && size > 0) {
-        memcpy(packet_buffer + HEADER_SIZE + sizeof(data_packet_header_t), data, size);
-    }
-    
-    // Send packet
-    //ESP_LOGI(TAG, "Sending buffer #%lu...", tx_packet_counter);
-    esp_err_t ret = esp_wifi_80211_tx(WIFI_IF_STA, 
-                                     packet_buffer, 
-                                     packet_size, 
-                                     true);
+    // Send packet; the buffer stays with the driver until its TX-done
+    esp_err_t ret = tx_buffer_send(packet_size, frame_seq);
     
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to send data packet: %s", esp_err_to_name(ret));
@@ -688,9 +860,6 @@ static esp_err_t send_data_packet(uint8_t *data, uint16_t size, uint8_t class_co
         ESP_LOGI(TAG,"================================================");
     }
     
-    // Free buffer
-    free(packet_buffer);
-    
     return ret;
 }
 
@@ -714,6 +883,22 @@ static void scheduler_task(void *pvParameters)
     }
 }
 
+/* Histogram as lower_edge:count for every occupied bin; latency edges are in us, run bins count from 1 */
+static void format_bins(char *buf, size_t size, const uint32_t *bins, int count, bool latency)
+{
+    size_t len = 0;
+    buf[0] = '\0';
+    for (int b = 0; b < count && len < size; b++) {
+        if (bins[b] > 0) {
+            len += snprintf(buf + len, size - len, "%s%lu:%lu", len > 0 ? "," : "",
+                            latency ? tx_track_bin_floor_us(b) : (uint32_t)b + 1, bins[b]);
+        }
+    }
+    if (len == 0) {
+        snprintf(buf, size, "-");
+    }
+}
+
 /* Print scheduler statistics */
 void print_scheduler_stats(void)
 {
@@ -722,19 +907,57 @@ void print_scheduler_stats(void)
     }
     
     // ESP_LOGI(TAG, "->Scheduler Statistics:");
-    // ESP_LOGI(TAG, "  Packets processed: %lu", scheduler_ctx.packets_processed);
-    // ESP_LOGI(TAG, "  Packets transmitted: %lu", scheduler_ctx.packets_transmitted);
-    // ESP_LOGI(TAG, "  Deadline misses: %lu", scheduler_ctx.deadline_misses);
+    // ESP_LOGI(TAG, "  Packets processed: %lu", scheduler_ctx.core.packets_processed);
+    // ESP_LOGI(TAG, "  Packets transmitted: %lu", scheduler_ctx.core.packets_transmitted);
+    // ESP_LOGI(TAG, "  Deadline misses: %lu", scheduler_ctx.core.deadline_misses);
     
     // Queue status
     int queue_length[MAX_CLASSES];
     for (int i = 0; i < MAX_CLASSES; i++) {
-        queue_length[i] = scheduler_ctx.packet_queues[i].count;
+        queue_length[i] = scheduler_ctx.core.packet_queues[i].count;
     }
     
     ESP_LOGI(TAG, "  Queue status: Class1=%d, Class2=%d, Class3=%d, Random=%d", 
         queue_length[0], queue_length[1], queue_length[2], queue_length[3]);
     
+    // TX outcomes from the driver's TX-done reports
+    const tx_track_t *tx = &scheduler_ctx.tx;
+    ESP_LOGI(TAG, "  TX: sent=%lu ok=%lu failed=%lu lost_reports=%lu late_reports=%lu in_flight=%d/%d"
+        " latency avg=%lu us max=%lu us",
+        tx->frames_sent, tx->frames_ok, tx->frames_failed, tx->reports_lost, tx->reports_late,
+        tx_buffers.in_flight, TX_BUFFER_COUNT,
+        tx->frames_ok > 0 ? (uint32_t)(tx->latency_ok_sum_us / tx->frames_ok) : 0, tx->latency_ok_max_us);
+    if (tx->frames_failed > 0) {
+        char ok_bins[160], failed_bins[160], runs[64];
+        format_bins(ok_bins, sizeof(ok_bins), tx->latency_ok, TX_TRACK_LATENCY_BINS, true);
+        format_bins(failed_bins, sizeof(failed_bins), tx->latency_failed, TX_TRACK_LATENCY_BINS, true);
+        format_bins(runs, sizeof(runs), tx->fail_runs, TX_TRACK_RUN_BINS, false);
+        ESP_LOGI(TAG, "  TX latency ok=%s failed=%s fail_runs=%s last_failed=#%lu",
+            ok_bins, failed_bins, runs, tx->last_failed_seq);
+    }
+    
+    // Modelled spend against the energy budget
+    const energy_budget_t *energy = &scheduler_ctx.energy;
+    if (energy->mj_per_hour > 0) {
+        ESP_LOGI(TAG, "  Energy: level=%s budget=%lu mJ/h spend=%lu mJ/h spent=%lu mJ (frames %lu mJ)"
+            " balance=%ld mJ (%d%% of bucket) shed=%lu",
+            energy_level_name(energy->level), energy->mj_per_hour, (uint32_t)energy_budget_rate(energy),
+            (uint32_t)energy->spent_mj, (uint32_t)energy->frames_mj, (int32_t)energy->balance_mj,
+            (int)(100.0 * energy->balance_mj / energy->capacity_mj), scheduler_ctx.shed_packets);
+    }
+    
+    // What send-on-delta kept off the air, per class
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        const sched_dedup_t *dedup = &scheduler_ctx.core.dedup[i];
+        if (scheduler_ctx.core.dedup_mask & (1u << i)) {
+            ESP_LOGI(TAG, "  Dedup class %d: held=%lu groups, %lu bytes avoided, %lu frames avoided",
+                i + 1, dedup->held_groups, dedup->held_bytes, dedup->frames_avoided);
+        }
+    }
+    if (scheduler_ctx.core.dedup_mask != 0) {
+        ESP_LOGI(TAG, "  Dedup held blocks: %lu bytes", scheduler_ctx.held_block_bytes);
+    }
+    
     xSemaphoreGive(scheduler_ctx.mutex);
 }
 
@@ -772,8 +995,8 @@ static void packet_creator_task(void *pvParameters)
             data_type_t data_type = DATA_TYPE_INT32;     // Default type
             
             if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-                period_ms = scheduler_ctx.class_periods[class_id];
-                data_type = scheduler_ctx.class_types[class_id];
+                period_ms = scheduler_ctx.core.class_periods[class_id];
+                data_type = scheduler_ctx.core.class_types[class_id];
                 xSemaphoreGive(scheduler_ctx.mutex);
             }
             
@@ -925,6 +1148,55 @@ static void adjust_tx_power_by_rssi(scheduler_config_t *config)
     }
 }
 
+/* Hold a controller's power choice under the energy budget's cap */
+static int8_t energy_cap_tx_power(int8_t power)
+{
+    int8_t cap = TX_POWER_HIGH;
+    if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        if (scheduler_ctx.energy.mj_per_hour > 0) {
+            cap = energy_power_cap(scheduler_ctx.energy.level);
+        }
+        xSemaphoreGive(scheduler_ctx.mutex);
+    }
+    return power < cap ? power : cap;
+}
+
+/* Next power level above the current setting */
+static int8_t tx_power_step_up(int8_t power)
+{
+    if (power < TX_POWER_LOW) {
+        return TX_POWER_LOW;
+    }
+    if (power < TX_POWER_MEDIUM) {
+        return TX_POWER_MEDIUM;
+    }
+    return TX_POWER_HIGH;
+}
+
+/* Correct an RSSI-based power choice with the TX outcomes since the last check */
+static int8_t tx_power_from_outcomes(int8_t rssi_power, int8_t current_power)
+{
+    uint32_t ok = 0, failed = 0;
+    if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        tx_track_take_window(&scheduler_ctx.tx, &ok, &failed);
+        xSemaphoreGive(scheduler_ctx.mutex);
+    }
+    
+    // Frames the driver gave up on mean the link is short of margin, whatever the RSSI says
+    uint32_t frames = ok + failed;
+    if (frames >= TX_FAIL_MIN_FRAMES && failed * 100 >= frames * TX_FAIL_RAISE_PCT) {
+        int8_t raised = tx_power_step_up(current_power);
+        ESP_LOGW(TAG, "->%lu of %lu frames failed since the last check", failed, frames);
+        return raised > rssi_power ? raised : rssi_power;
+    }
+    
+    // Do not lower power on RSSI alone while frames still fail
+    if (failed > 0 && rssi_power < current_power) {
+        return current_power;
+    }
+    return rssi_power;
+}
+
 static void auto_tx_power_task(void *pvParameters)
 {
     scheduler_config_t *config = (scheduler_config_t*)pvParameters;
@@ -957,10 +1229,12 @@ static void auto_tx_power_task(void *pvParameters)
                 } else {
                     new_tx_power = TX_POWER_HIGH;
                 }
+                new_tx_power = tx_power_from_outcomes(new_tx_power, config->wifi_tx_power);
+                new_tx_power = energy_cap_tx_power(new_tx_power);
                 
                 // Only change if different from current setting
                 if (new_tx_power != config->wifi_tx_power) {
-                    ESP_LOGW(TAG, "***Adjusting TX power based on RSSI %d dBm: %d -> %d", 
+                    ESP_LOGW(TAG, "***Adjusting TX power based on RSSI %d dBm and TX outcomes: %d -> %d", 
                              rssi, config->wifi_tx_power, new_tx_power);
                     
                     // Update config and apply setting
@@ -981,10 +1255,8 @@ static void auto_tx_power_task(void *pvParameters)
 /* Initialize the packet scheduler */
 void scheduler_init(scheduler_config_t *config)
 {
-    // Initialize packet queues for each class
-    for (int i = 0; i < MAX_CLASSES; i++) {
-        queue_init(&scheduler_ctx.packet_queues[i]);
-    }
+    // Initialize packet queues and statistics
+    sched_core_init(&scheduler_ctx.core);
 
     // Initialize mutex
     scheduler_ctx.mutex = xSemaphoreCreateMutex();
@@ -993,20 +1265,62 @@ void scheduler_init(scheduler_config_t *config)
         return;
     }
 
+    // Energy-budget scheduling, modelled with the power save mode in use
+    if (config->energy_budget > 0) {
+        energy_model_t model;
+        energy_model_defaults(&model);
+        energy_ps_t ps = config->wifi_ps_mode == WIFI_PS_NONE ? ENERGY_PS_NONE
+                       : config->wifi_ps_mode == WIFI_PS_MAX_MODEM ? ENERGY_PS_MAX : ENERGY_PS_MIN;
+        energy_budget_init(&scheduler_ctx.energy, &model, config->energy_budget, ps, get_current_time_ms());
+        ESP_LOGI(TAG, "Energy budget %lu mJ/h, baseline %lu mJ/h", config->energy_budget,
+                 (uint32_t)(scheduler_ctx.energy.baseline_mw * 3600.0));
+        if (!energy_budget_feasible(&scheduler_ctx.energy)) {
+            ESP_LOGW(TAG, "Energy budget is below the idle baseline; the station will run shedding");
+        }
+    }
+
+    // Frame buffers and TX outcomes come back through the driver's TX-done callback
+    tx_track_init(&scheduler_ctx.tx);
+    tx_buffers.done = xQueueCreate(TX_REPORT_QUEUE_LEN, sizeof(tx_report_t));
+    if (tx_buffers.done == NULL || esp_wifi_register_80211_tx_cb(on_tx_done) != ESP_OK) {
+        ESP_LOGW(TAG, "TX-done callback unavailable, frames are sent without buffer handback or outcomes");
+        if (tx_buffers.done != NULL) {
+            vQueueDelete(tx_buffers.done);
+            tx_buffers.done = NULL;
+        }
+    }
+
     // Set class types, periods, and deadlines from the configuration
     for (int i = 0; i < MAX_CLASSES; i++) {
-        scheduler_ctx.class_types[i] = config->class_types[i];
-        scheduler_ctx.class_periods[i] = config->class_periods[i];
-        scheduler_ctx.class_deadlines[i] = config->class_deadlines[i];
+        scheduler_ctx.core.class_types[i] = config->class_types[i];
+        scheduler_ctx.core.class_periods[i] = config->class_periods[i];
+        scheduler_ctx.core.class_deadlines[i] = config->class_deadlines[i];
+        scheduler_ctx.class_access[i] = config->class_access[i];
+    }
+    scheduler_ctx.wmm_enabled = config->wmm_enabled;
+    
+    // Over ESP-NOW, send-done reports take the place of the driver's TX-done
+    if (config->espnow_transport) {
+        esp_err_t err = espnow_init();
+        if (err == ESP_OK) {
+            scheduler_ctx.espnow = true;
+            ESP_LOGI(TAG, "Sending over ESP-NOW to " MACSTR ", at most %d data bytes per frame",
+                     MAC2STR(scheduler_ctx.espnow_peer), (int)ESPNOW_MAX_TX_SIZE);
+        } else {
+            ESP_LOGW(TAG, "ESP-NOW unavailable (%s), sending raw data frames", esp_err_to_name(err));
+        }
     }
     
     // Set processing threshold from configuration - ONLY ONCE
-    scheduler_ctx.processing_threshold = config->processing_threshold;
-
-    // Initialize statistics
-    scheduler_ctx.packets_processed = 0;
-    scheduler_ctx.packets_transmitted = 0;
-    scheduler_ctx.deadline_misses = 0;
+    scheduler_ctx.core.processing_threshold = config->processing_threshold;
+    scheduler_ctx.base_threshold = config->processing_threshold;
+    scheduler_ctx.base_tx_power = config->wifi_tx_power;
+    scheduler_ctx.core.sample_time_mask = config->sample_time_mask;
+    scheduler_ctx.core.dedup_mask = config->dedup_mask;
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        scheduler_ctx.core.dedup_deadband[i] = config->dedup_deadband[i];
+        scheduler_ctx.core.dedup_keyframe_ms[i] = config->dedup_keyframe_ms[i];
+    }
     scheduler_ctx.current_time_ms = 0;
     
     // Create packet creator task with packet counts passed as parameters
@@ -1055,29 +1369,21 @@ void scheduler_init(scheduler_config_t *config)
     
     // Log initialization details
     ESP_LOGI(TAG, "Packet scheduler initialized with the following configuration:");
+    ESP_LOGI(TAG, "Batch policy: %s", SCHED_POLICY_NAME);
     for (int i = 0; i < MAX_CLASSES; i++) {
-        const char *type_str;
-        switch (scheduler_ctx.class_types[i]) {
-            case DATA_TYPE_INT8:   type_str = "INT8";   break;
-            case DATA_TYPE_INT16:  type_str = "INT16";  break;
-            case DATA_TYPE_INT32:  type_str = "INT32";  break;
-            case DATA_TYPE_FLOAT:  type_str = "FLOAT";  break;
-            case DATA_TYPE_DOUBLE: type_str = "DOUBLE"; break;
-            default:               type_str = "UNKNOWN"; break;
-        }
-        
         ESP_LOGI(TAG, "Class %d: Type=%s, Period=%lu ms, Deadline=%lu ms, Count=%u", 
-                i + 1, type_str, scheduler_ctx.class_periods[i], scheduler_ctx.class_deadlines[i],
+                i + 1, data_type_name(scheduler_ctx.core.class_types[i]),
+                scheduler_ctx.core.class_periods[i], scheduler_ctx.core.class_deadlines[i],
                 task_params[i]);
     }
     
     // Also log the processing threshold
-    ESP_LOGI(TAG, "Processing threshold: %lu ms", scheduler_ctx.processing_threshold);
+    ESP_LOGI(TAG, "Processing threshold: %lu ms", scheduler_ctx.core.processing_threshold);
 
     // Create random packet task if enabled
     if (config->random_packet_enabled) {
         // Set the type for random packets
-        scheduler_ctx.class_types[CLASS_RANDOM] = config->random_packet_type;
+        scheduler_ctx.core.class_types[CLASS_RANDOM] = config->random_packet_type;
 
         // Clone config for the task since it will persist
         scheduler_config_t *task_config = malloc(sizeof(scheduler_config_t));
@@ -1112,16 +1418,7 @@ void scheduler_init(scheduler_config_t *config)
                     ESP_LOGI(TAG, "  Burst settings: After %lu ms, switch to %lu ms intervals", 
                             config->random_packet_burst_period, config->random_packet_burst_interval);
                 }
-                const char *type_str;
-                switch (config->random_packet_type) {
-                    case DATA_TYPE_INT8:   type_str = "INT8";   break;
-                    case DATA_TYPE_INT16:  type_str = "INT16";  break;
-                    case DATA_TYPE_INT32:  type_str = "INT32";  break;
-                    case DATA_TYPE_FLOAT:  type_str = "FLOAT";  break;
-                    case DATA_TYPE_DOUBLE: type_str = "DOUBLE"; break;
-                    default:               type_str = "UNKNOWN"; break;
-                }
-                ESP_LOGI(TAG, "  Packet type: %s", type_str);
+                ESP_LOGI(TAG, "  Packet type: %s", data_type_name(config->random_packet_type));
             }
         }
     }
@@ -1186,6 +1483,16 @@ void app_main(void)
     verify_wifi_settings(&config);
     ESP_LOGI(TAG, "---------Verifying WiFi settings----------");
     
+    // 'bench' measures the raw link instead of running the scheduler
+    if (config.bench_mode == BENCH_TX) {
+        bench_tx_run(&config);
+        return;
+    }
+    if (config.bench_mode == BENCH_PING) {
+        bench_ping_run(&config);
+        return;
+    }
+    
     // Once user has completed configuration via terminal, initialize packet scheduler
     ESP_LOGI(TAG, "User configuration complete, initializing scheduler...");
     scheduler_init(&config);
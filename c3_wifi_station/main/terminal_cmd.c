@@ -6,6 +6,8 @@
 #include "terminal_cmd.h"
 #include "esp_log.h"
 #include "esp_random.h"
+#include "record_schema.h"
+#include "link_bench.h"
 
 static const char *TAG = "terminal";
 
@@ -24,8 +26,14 @@ static int cmd_reset(int argc, char **argv, scheduler_config_t *config);
 static int cmd_random(int argc, char **argv, scheduler_config_t *config);
 static int cmd_start(int argc, char **argv, scheduler_config_t *config);
 static int cmd_threshold(int argc, char **argv, scheduler_config_t *config);
+static int cmd_budget(int argc, char **argv, scheduler_config_t *config);
 static int cmd_type(int argc, char **argv, scheduler_config_t *config);
 static int cmd_packet_count(int argc, char **argv, scheduler_config_t *config);
+static int cmd_schema(int argc, char **argv, scheduler_config_t *config);
+static int cmd_timestamps(int argc, char **argv, scheduler_config_t *config);
+static int cmd_dedup(int argc, char **argv, scheduler_config_t *config);
+static int cmd_manifest(int argc, char **argv, scheduler_config_t *config);
+static int cmd_bench(int argc, char **argv, scheduler_config_t *config);
 
 
 /* Forward declarations for new terminal commands */
@@ -35,8 +43,38 @@ static int cmd_random_packet_count(int argc, char **argv, scheduler_config_t *co
 static int cmd_random_packet_burst(int argc, char **argv, scheduler_config_t *config);
 static void cmd_adjust_tx_power_by_rssi(scheduler_config_t *config);
 static int cmd_auto_tx_power(int argc, char **argv, scheduler_config_t *config); // adaptive tx power
+static int cmd_wmm(int argc, char **argv, scheduler_config_t *config);
+static int cmd_transport(int argc, char **argv, scheduler_config_t *config);
 
 /* Helper function for generating random values */
+/* Display label for a class type: "INT32", "SCHEMA2", ... (terminal task only) */
+static const char *type_label(data_type_t type)
+{
+    static char label[16];
+    
+    if (data_type_is_schema(type)) {
+        snprintf(label, sizeof(label), "SCHEMA%d", data_type_schema_id(type));
+        return label;
+    }
+    return data_type_name(type);
+}
+
+/* Parse a type option; schemas must already be registered */
+static bool parse_type_option(const char *option, data_type_t *type)
+{
+    if (!data_type_from_option(option, type)) {
+        printf("Error: Invalid data type '%s'.\n", option);
+        printf("Available datatypes: int8, int16, int32, float, double, schema<id>\n");
+        return false;
+    }
+    if (data_type_is_schema(*type) && record_schema_get(data_type_schema_id(*type)) == NULL) {
+        printf("Error: Schema %d is not defined. Use 'schema' to define it first.\n",
+               data_type_schema_id(*type));
+        return false;
+    }
+    return true;
+}
+
 static uint32_t random_range(uint32_t min, uint32_t max) 
 {
     return min + (esp_random() % (max - min + 1));
@@ -142,40 +180,17 @@ static int cmd_random_packet_type(int argc, char **argv, scheduler_config_t *con
     
     if (argc < 2) {
         printf("Usage: rtype <datatype>\n");
-        printf("Available datatypes: int8, int16, int32, float, double\n");
+        printf("Available datatypes: int8, int16, int32, float, double, schema<id>\n");
         printf("Example: rtype int32\n");
         
         // Show current type
-        const char *type_str;
-        switch (config->random_packet_type) {
-            case DATA_TYPE_INT8:   type_str = "INT8";   break;
-            case DATA_TYPE_INT16:  type_str = "INT16";  break;
-            case DATA_TYPE_INT32:  type_str = "INT32";  break;
-            case DATA_TYPE_FLOAT:  type_str = "FLOAT";  break;
-            case DATA_TYPE_DOUBLE: type_str = "DOUBLE"; break;
-            default:               type_str = "UNKNOWN"; break;
-        }
-        printf("Current type: %s\n", type_str);
+        printf("Current type: %s\n", type_label(config->random_packet_type));
         return 1;
     }
     
     // Parse data type
     data_type_t new_type;
-    const char *type_name = argv[1];
-    
-    if (strcasecmp(type_name, TYPE_OPTION_INT8) == 0) {
-        new_type = DATA_TYPE_INT8;
-    } else if (strcasecmp(type_name, TYPE_OPTION_INT16) == 0) {
-        new_type = DATA_TYPE_INT16;
-    } else if (strcasecmp(type_name, TYPE_OPTION_INT32) == 0) {
-        new_type = DATA_TYPE_INT32;
-    } else if (strcasecmp(type_name, TYPE_OPTION_FLOAT) == 0) {
-        new_type = DATA_TYPE_FLOAT;
-    } else if (strcasecmp(type_name, TYPE_OPTION_DOUBLE) == 0) {
-        new_type = DATA_TYPE_DOUBLE;
-    } else {
-        printf("Error: Invalid data type '%s'.\n", type_name);
-        printf("Available datatypes: int8, int16, int32, float, double\n");
+    if (!parse_type_option(argv[1], &new_type)) {
         return 1;
     }
     
@@ -184,17 +199,7 @@ static int cmd_random_packet_type(int argc, char **argv, scheduler_config_t *con
     config->class_types[CLASS_RANDOM] = new_type;  // Also update in the class types array
     
     // Show confirmation
-    const char *type_str;
-    switch (new_type) {
-        case DATA_TYPE_INT8:   type_str = "INT8";   break;
-        case DATA_TYPE_INT16:  type_str = "INT16";  break;
-        case DATA_TYPE_INT32:  type_str = "INT32";  break;
-        case DATA_TYPE_FLOAT:  type_str = "FLOAT";  break;
-        case DATA_TYPE_DOUBLE: type_str = "DOUBLE"; break;
-        default:               type_str = "UNKNOWN"; break;
-    }
-    
-    printf("Random packet type set to %s\n", type_str);
+    printf("Random packet type set to %s\n", type_label(new_type));
     
     return 0;
 }
@@ -585,6 +590,96 @@ static int cmd_auto_tx_power(int argc, char **argv, scheduler_config_t *config)
     return 0;
 }
 
+/* Configure WMM access categories: wmm on|off, wmm auto, wmm <class> <ac> */
+static int cmd_wmm(int argc, char **argv, scheduler_config_t *config)
+{
+    ESP_LOGI(TAG, "Configuring WMM access categories");
+    
+    if (argc < 2) {
+        printf("Usage: wmm [on|off]            - Send QoS data frames or plain data frames\n");
+        printf("       wmm <class> <vo|vi|be|bk> - Set access category for a class (1-%d)\n", MAX_CLASSES);
+        printf("       wmm auto                - Assign categories by deadline\n");
+        printf("Current status: %s\n", config->wmm_enabled ? "ENABLED" : "DISABLED");
+        return 1;
+    }
+    
+    if (strcasecmp(argv[1], "on") == 0 || strcasecmp(argv[1], "off") == 0) {
+        config->wmm_enabled = strcasecmp(argv[1], "on") == 0;
+        printf("WMM QoS data frames %s\n", config->wmm_enabled ? "enabled" : "disabled");
+        return 0;
+    }
+    
+    if (strcasecmp(argv[1], "auto") == 0) {
+        // Rank classes by deadline: shortest gets VO, then VI, BE and BK
+        for (int i = 0; i < MAX_CLASSES; i++) {
+            int rank = 0;
+            for (int j = 0; j < MAX_CLASSES; j++) {
+                if (config->class_deadlines[j] < config->class_deadlines[i] ||
+                    (config->class_deadlines[j] == config->class_deadlines[i] && j < i)) {
+                    rank++;
+                }
+            }
+            config->class_access[i] = (wmm_ac_t)(WMM_AC_VO - (rank < WMM_AC_VO ? rank : WMM_AC_VO));
+        }
+    } else {
+        if (argc < 3) {
+            printf("Error: Missing access category. Use vo, vi, be or bk.\n");
+            return 1;
+        }
+        
+        int class_num = atoi(argv[1]);
+        if (class_num < 1 || class_num > MAX_CLASSES) {
+            printf("Error: Invalid class number. Must be between 1 and %d.\n", MAX_CLASSES);
+            return 1;
+        }
+        
+        wmm_ac_t ac;
+        if (!wmm_ac_from_option(argv[2], &ac)) {
+            printf("Error: Invalid access category '%s'. Use vo, vi, be or bk.\n", argv[2]);
+            return 1;
+        }
+        config->class_access[class_num - 1] = ac;
+    }
+    
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        printf("Class %d: AC=%s, Deadline=%lu ms\n",
+               i + 1, wmm_ac_name(config->class_access[i]), config->class_deadlines[i]);
+    }
+    if (!config->wmm_enabled) {
+        printf("Note: categories apply after 'wmm on'\n");
+    }
+    
+    return 0;
+}
+
+/* Choose how data frames reach the AP: transport raw|espnow */
+static int cmd_transport(int argc, char **argv, scheduler_config_t *config)
+{
+    ESP_LOGI(TAG, "Configuring frame transport");
+    
+    if (argc < 2) {
+        printf("Usage: transport [raw|espnow] - Send raw 802.11 data frames or ESP-NOW frames\n");
+        printf("Current transport: %s\n", config->espnow_transport ? "ESP-NOW" : "RAW");
+        return 1;
+    }
+    
+    if (strcasecmp(argv[1], "raw") == 0) {
+        config->espnow_transport = false;
+    } else if (strcasecmp(argv[1], "espnow") == 0) {
+        config->espnow_transport = true;
+    } else {
+        printf("Error: Invalid transport '%s'. Use raw or espnow.\n", argv[1]);
+        return 1;
+    }
+    
+    printf("Frames are sent as %s\n", config->espnow_transport ? "ESP-NOW frames" : "raw 802.11 data frames");
+    if (config->espnow_transport) {
+        printf("Note: the AP must use the ESP-NOW receive path; WMM categories and 'bench' do not apply\n");
+    }
+    
+    return 0;
+}
+
 static int cmd_verify_wifi(int argc, char **argv, scheduler_config_t *config)
 {
     ESP_LOGI(TAG, "Verifying WiFi settings");
@@ -610,10 +705,16 @@ static int cmd_help(int argc, char **argv, scheduler_config_t *config)
     printf("  %-10s - Set period and deadline for a class\n", "set");
     printf("  %-10s - Set data type for a class\n", "type");
     printf("  %-10s - Set packet count for a class\n", "count");
+    printf("  %-10s - Define a mixed-field record schema\n", "schema");
+    printf("  %-10s - Send per-sample capture times for a class\n", "timestamps");
+    printf("  %-10s - Send a class only when it changes beyond a dead-band\n", "dedup");
     printf("  %-10s - Set processing threshold\n", "threshold");
+    printf("  %-10s - Set an energy budget in mJ/hour (off for deadlines only)\n", "budget");
     printf("  %-10s - Reset all classes to default values\n", "reset");
     printf("  %-10s - Set random periods and deadlines for all classes\n", "random");
     printf("  %-10s - Start the program with current configuration\n", "start");
+    printf("  %-10s - Print the configuration as an experiment manifest line\n", "manifest");
+    printf("  %-10s - Run a link benchmark instead of starting (bench tx / bench ping)\n", "bench");
     
     printf("\nRandom packet commands:\n");
     printf("  %-10s - Enable the random packet (on/off) and packet generation\n", "rpacket");
@@ -635,11 +736,17 @@ static int cmd_help(int argc, char **argv, scheduler_config_t *config)
     printf("  %-10s - Set WiFi protocol (b/bg/bgn)\n", "protocol");
     printf("  %-10s - Enable/disable auto TX power adjustment\n", "autotx");
     printf("  %-10s - Set auto TX power check interval\n", "autotx_interval");
+    printf("  %-10s - Set WMM access category per class (vo/vi/be/bk)\n", "wmm");
+    printf("  %-10s - Send frames raw or over ESP-NOW (raw/espnow)\n", "transport");
     printf("  Example: txpower 80     - Set TX power to 20dBm (maximum)\n");
     printf("  Example: psmode min     - Use minimum power save\n");
     printf("  Example: protocol bgn   - Use 802.11b/g/n protocols\n");
     printf("  Example: autotx on      - Enable automatic TX power adjustment\n");
     printf("  Example: autotx_interval 3000  - Check and adjust every 3 seconds\n");
+    printf("  Example: wmm on         - Send QoS data frames\n");
+    printf("  Example: wmm 1 vo       - Class 1 contends as voice traffic\n");
+    printf("  Example: wmm auto       - Shortest deadline gets VO, then VI, BE, BK\n");
+    printf("  Example: transport espnow - Send to the AP's ESP-NOW receive path\n");
     
     
     printf("\nClass-specific commands:\n");
@@ -651,9 +758,26 @@ static int cmd_help(int argc, char **argv, scheduler_config_t *config)
     
     printf("\nType command:\n");
     printf("  type <class> <datatype>         - Set data type for a class\n");
-    printf("  Available types: int8, int16, int32, float, double\n");
+    printf("  Available types: int8, int16, int32, float, double, schema<id>\n");
     printf("  Example: type 1 int32           - Set Class 1 type to INT32\n");
     
+    printf("\nSchema command:\n");
+    printf("  schema <id> <fieldtype> ...     - Define record fields for schema 0-%d\n", SCHEMA_MAX_COUNT - 1);
+    printf("  Example: schema 0 int16 float int32\n");
+    printf("  Example: type 2 schema0         - Class 2 sends schema 0 records\n");
+    
+    printf("\nTimestamps command:\n");
+    printf("  timestamps <class|all> <on|off> - Send capture times of each sample\n");
+    printf("  Example: timestamps 1 on        - Class 1 frames carry sample times\n");
+    printf("  Example: timestamps all off     - Only the frame timestamp is sent\n");
+    
+    printf("\nDedup command:\n");
+    printf("  dedup <class> <deadband> [keyframe_ms] - Hold samples within deadband of the last sent\n");
+    printf("  dedup <class|all> off           - Send every sample\n");
+    printf("  Example: dedup 2 0.5            - Class 2 sends changes over 0.5, and every %d s\n",
+           DEFAULT_DEDUP_KEYFRAME_MS / 1000);
+    printf("  Example: dedup 1 0 0            - Class 1 drops exact repeats, no keyframes\n");
+    
     printf("\nCount command:\n");
     printf("  count <class> <value>           - Set packet count for a class\n");
     printf("  Example: count 1 10             - Set Class 1 packet count to 10\n");
@@ -674,36 +798,26 @@ static int cmd_status(int argc, char **argv, scheduler_config_t *config)
     ESP_LOGI(TAG, "Displaying current class configuration");
     printf("\nCurrent Class Configuration:\n");
     for (int i = 0; i < MAX_CLASSES; i++) {  // Show only the 3 regular classes + random
-        const char *type_str;
-        switch (config->class_types[i]) {
-            case DATA_TYPE_INT8:   type_str = "INT8";   break;
-            case DATA_TYPE_INT16:  type_str = "INT16";  break;
-            case DATA_TYPE_INT32:  type_str = "INT32";  break;
-            case DATA_TYPE_FLOAT:  type_str = "FLOAT";  break;
-            case DATA_TYPE_DOUBLE: type_str = "DOUBLE"; break;
-            default:               type_str = "UNKNOWN"; break;
+        printf("Class %d: Type=%s, Period=%lu ms, Deadline=%lu ms, Count=%u, Times=%s\n", 
+               i + 1, type_label(config->class_types[i]), config->class_periods[i],
+               config->class_deadlines[i], config->packet_counts[i],
+               (config->sample_time_mask & (1u << i)) ? "per-sample" : "frame");
+        if (config->dedup_mask & (1u << i)) {
+            printf("         Send-on-delta: deadband=%g, keyframe=%lu ms\n",
+                   config->dedup_deadband[i], config->dedup_keyframe_ms[i]);
         }
-        
-        printf("Class %d: Type=%s, Period=%lu ms, Deadline=%lu ms, Count=%u\n", 
-               i + 1, type_str, config->class_periods[i], config->class_deadlines[i],
-               config->packet_counts[i]);
     }
     
     // Add threshold information
     printf("\nProcessing Threshold: %lu ms\n", config->processing_threshold);
     printf("(Tasks are processed when deadline is within this threshold)\n");
+    if (config->energy_budget > 0) {
+        printf("Energy Budget: %lu mJ/hour\n", config->energy_budget);
+    } else {
+        printf("Energy Budget: OFF\n");
+    }
 
     // Add random packet information
-    const char *type_str;
-    switch (config->random_packet_type) {
-        case DATA_TYPE_INT8:   type_str = "INT8";   break;
-        case DATA_TYPE_INT16:  type_str = "INT16";  break;
-        case DATA_TYPE_INT32:  type_str = "INT32";  break;
-        case DATA_TYPE_FLOAT:  type_str = "FLOAT";  break;
-        case DATA_TYPE_DOUBLE: type_str = "DOUBLE"; break;
-        default:               type_str = "UNKNOWN"; break;
-    }
-    
     printf("\nRandom Packet Configuration: %s\n", 
            config->random_packet_enabled ? "ENABLED" : "DISABLED");
     printf("  Initial interval: %lu-%lu ms\n", 
@@ -714,7 +828,7 @@ static int cmd_status(int argc, char **argv, scheduler_config_t *config)
                config->random_packet_burst_period, config->random_packet_burst_interval);
     }
     printf("  Packet: Type=%s, Size=%u elements\n", 
-           type_str, config->random_packet_count);
+           type_label(config->random_packet_type), config->random_packet_count);
     printf("  Deadline: %lu ms\n", config->class_deadlines[CLASS_RANDOM]);
     
     // Add WiFi configuration information
@@ -785,6 +899,13 @@ static int cmd_status(int argc, char **argv, scheduler_config_t *config)
     printf("  Auto TX power adjustment: %s\n", config->auto_tx_power ? "ENABLED" : "DISABLED");
     printf("  Auto TX power check interval: %lu ms\n", config->auto_tx_power_interval);
     
+    // Display WMM access categories
+    printf("  WMM QoS frames: %s\n", config->wmm_enabled ? "ENABLED" : "DISABLED");
+    printf("  Access categories: C1=%s C2=%s C3=%s Random=%s\n",
+           wmm_ac_name(config->class_access[CLASS_1]), wmm_ac_name(config->class_access[CLASS_2]),
+           wmm_ac_name(config->class_access[CLASS_3]), wmm_ac_name(config->class_access[CLASS_RANDOM]));
+    printf("  Frame transport: %s\n", config->espnow_transport ? "ESP-NOW" : "RAW");
+    
     return 0;
 }
 
@@ -923,7 +1044,7 @@ static int cmd_type(int argc, char **argv, scheduler_config_t *config)
     
     if (argc < 3) {
         printf("Usage: type <class> <datatype>\n");
-        printf("Available datatypes: int8, int16, int32, float, double\n");
+        printf("Available datatypes: int8, int16, int32, float, double, schema<id>\n");
         printf("Example: type 1 int32\n");
         printf("Example: type 2 float\n");
         printf("Example: type 3 int16\n");
@@ -941,21 +1062,7 @@ static int cmd_type(int argc, char **argv, scheduler_config_t *config)
     
     // Parse data type
     data_type_t new_type;
-    const char *type_name = argv[2];
-    
-    if (strcasecmp(type_name, TYPE_OPTION_INT8) == 0) {
-        new_type = DATA_TYPE_INT8;
-    } else if (strcasecmp(type_name, TYPE_OPTION_INT16) == 0) {
-        new_type = DATA_TYPE_INT16;
-    } else if (strcasecmp(type_name, TYPE_OPTION_INT32) == 0) {
-        new_type = DATA_TYPE_INT32;
-    } else if (strcasecmp(type_name, TYPE_OPTION_FLOAT) == 0) {
-        new_type = DATA_TYPE_FLOAT;
-    } else if (strcasecmp(type_name, TYPE_OPTION_DOUBLE) == 0) {
-        new_type = DATA_TYPE_DOUBLE;
-    } else {
-        printf("Error: Invalid data type '%s'.\n", type_name);
-        printf("Available datatypes: int8, int16, int32, float, double\n");
+    if (!parse_type_option(argv[2], &new_type)) {
         return 1;
     }
     
@@ -963,17 +1070,171 @@ static int cmd_type(int argc, char **argv, scheduler_config_t *config)
     config->class_types[class_id] = new_type;
     
     // Show confirmation
-    const char *type_str;
-    switch (new_type) {
-        case DATA_TYPE_INT8:   type_str = "INT8";   break;
-        case DATA_TYPE_INT16:  type_str = "INT16";  break;
-        case DATA_TYPE_INT32:  type_str = "INT32";  break;
-        case DATA_TYPE_FLOAT:  type_str = "FLOAT";  break;
-        case DATA_TYPE_DOUBLE: type_str = "DOUBLE"; break;
-        default:               type_str = "UNKNOWN"; break;
+    printf("Updated Class %d: Type=%s\n", class_num, type_label(new_type));
+    
+    return 0;
+}
+
+/* Define a mixed-field record schema */
+static int cmd_schema(int argc, char **argv, scheduler_config_t *config)
+{
+    ESP_LOGI(TAG, "Defining record schema");
+    
+    if (argc < 3) {
+        printf("Usage: schema <id> <fieldtype> [<fieldtype> ...]\n");
+        printf("Schema IDs: 0-%d, up to %d fields of int8, int16, int32, float, double\n",
+               SCHEMA_MAX_COUNT - 1, SCHEMA_MAX_FIELDS);
+        printf("Example: schema 0 int16 float int32  - Temperature, humidity, counter\n");
+        printf("Then:    type 1 schema0\n");
+        
+        // Show defined schemas
+        for (int id = 0; id < SCHEMA_MAX_COUNT; id++) {
+            const record_schema_t *schema = record_schema_get(id);
+            if (schema == NULL) {
+                continue;
+            }
+            printf("Schema %d (%d bytes):", id, schema->record_size);
+            for (int f = 0; f < schema->field_count; f++) {
+                printf(" %s", data_type_name(schema->field_types[f]));
+            }
+            printf("\n");
+        }
+        return 1;
+    }
+    
+    // Parse schema ID
+    int id = atoi(argv[1]);
+    if (id < 0 || id >= SCHEMA_MAX_COUNT) {
+        printf("Error: Invalid schema ID. Must be between 0 and %d.\n", SCHEMA_MAX_COUNT - 1);
+        return 1;
+    }
+    
+    int field_count = argc - 2;
+    if (field_count > SCHEMA_MAX_FIELDS) {
+        printf("Error: Too many fields. At most %d are allowed.\n", SCHEMA_MAX_FIELDS);
+        return 1;
+    }
+    
+    // Parse field types; fields must be plain data types
+    data_type_t field_types[SCHEMA_MAX_FIELDS];
+    for (int f = 0; f < field_count; f++) {
+        if (!data_type_from_option(argv[f + 2], &field_types[f]) ||
+            data_type_is_schema(field_types[f])) {
+            printf("Error: Invalid field type '%s'.\n", argv[f + 2]);
+            printf("Available field types: int8, int16, int32, float, double\n");
+            return 1;
+        }
     }
     
-    printf("Updated Class %d: Type=%s\n", class_num, type_str);
+    if (!record_schema_register(id, field_types, field_count)) {
+        printf("Error: Could not register schema %d.\n", id);
+        return 1;
+    }
+    
+    printf("Defined Schema %d: %d fields, %d bytes per record\n",
+           id, field_count, record_schema_get(id)->record_size);
+    
+    return 0;
+}
+
+/* Enable or disable per-sample capture times for a class */
+static int cmd_timestamps(int argc, char **argv, scheduler_config_t *config)
+{
+    ESP_LOGI(TAG, "Setting per-sample timestamps");
+    
+    if (argc < 3) {
+        printf("Usage: timestamps <class|all> <on|off>\n");
+        printf("Example: timestamps 1 on\n");
+        printf("Example: timestamps all off\n");
+        return 1;
+    }
+    
+    // Parse class number or 'all'
+    class_mask_t mask;
+    if (strcmp(argv[1], "all") == 0) {
+        mask = CLASS_MASK_ALL;
+    } else {
+        int class_num = atoi(argv[1]);
+        if (class_num < 1 || class_num > MAX_CLASSES) {
+            printf("Error: Invalid class number. Must be between 1 and %d.\n", MAX_CLASSES);
+            return 1;
+        }
+        mask = 1u << (class_num - 1);
+    }
+    
+    if (strcmp(argv[2], "on") == 0) {
+        config->sample_time_mask |= mask;
+    } else if (strcmp(argv[2], "off") == 0) {
+        config->sample_time_mask &= ~mask;
+    } else {
+        printf("Error: Invalid option '%s'. Use 'on' or 'off'.\n", argv[2]);
+        return 1;
+    }
+    
+    printf("Per-sample timestamps %s for %s\n", argv[2],
+           strcmp(argv[1], "all") == 0 ? "all classes" : argv[1]);
+    
+    return 0;
+}
+
+/*
+ * Send-on-delta: a sample group whose values all stay within the dead-band
+ * of the last group sent is held back, and the AP repeats the last value
+ * for it. A keyframe goes out at least every keyframe_ms regardless.
+ */
+static int cmd_dedup(int argc, char **argv, scheduler_config_t *config)
+{
+    if (argc < 3) {
+        printf("Usage: dedup <class> <deadband> [keyframe_ms]\n");
+        printf("       dedup <class|all> off\n");
+        printf("Example: dedup 2 0.5 30000\n");
+        return 1;
+    }
+    
+    if (strcmp(argv[1], "all") == 0 && strcmp(argv[2], "off") == 0) {
+        config->dedup_mask = 0;
+        printf("Send-on-delta off for all classes\n");
+        return 0;
+    }
+    
+    int class_num = atoi(argv[1]);
+    if (class_num < 1 || class_num > MAX_CLASSES) {
+        printf("Error: Invalid class number. Must be between 1 and %d.\n", MAX_CLASSES);
+        return 1;
+    }
+    int class_id = class_num - 1;
+    
+    if (strcmp(argv[2], "off") == 0) {
+        config->dedup_mask &= ~(1u << class_id);
+        printf("Send-on-delta off for class %d\n", class_num);
+        return 0;
+    }
+    
+    char *end;
+    float deadband = strtof(argv[2], &end);
+    if (*end != '\0' || !(deadband >= 0)) {
+        printf("Error: Dead-band must be a number of at least 0 or 'off'.\n");
+        return 1;
+    }
+    
+    uint32_t keyframe = DEFAULT_DEDUP_KEYFRAME_MS;
+    if (argc > 3) {
+        unsigned long value = strtoul(argv[3], &end, 10);
+        if (*end != '\0' || value > MAX_DEDUP_KEYFRAME_MS) {
+            printf("Error: Keyframe interval must be 0-%d ms.\n", MAX_DEDUP_KEYFRAME_MS);
+            return 1;
+        }
+        keyframe = value;
+    }
+    
+    config->dedup_mask |= 1u << class_id;
+    config->dedup_deadband[class_id] = deadband;
+    config->dedup_keyframe_ms[class_id] = keyframe;
+    if (keyframe > 0) {
+        printf("Class %d sends on changes over %g, keyframe every %lu ms\n", class_num, deadband, keyframe);
+    } else {
+        printf("Class %d sends on changes over %g, no keyframes\n", class_num, deadband);
+    }
     
     return 0;
 }
@@ -997,6 +1258,9 @@ static int cmd_reset(int argc, char **argv, scheduler_config_t *config)
     config->class_types[CLASS_1] = DATA_TYPE_INT32;  // Class 1 - INT32
     config->class_types[CLASS_2] = DATA_TYPE_FLOAT;  // Class 2 - FLOAT
     config->class_types[CLASS_3] = DATA_TYPE_INT16;  // Class 3 - INT16
+    record_schema_reset();
+    config->sample_time_mask = 0;
+    config->dedup_mask = 0;
     
     // Set default packet counts
     config->packet_counts[CLASS_1] = DEFAULT_CLASS1_COUNT;
@@ -1020,6 +1284,11 @@ static int cmd_reset(int argc, char **argv, scheduler_config_t *config)
     config->wifi_tx_power = DEFAULT_WIFI_TX_POWER;
     config->wifi_ps_mode = DEFAULT_WIFI_PS_MODE;
     config->wifi_protocol = DEFAULT_WIFI_PROTOCOL;
+    config->wmm_enabled = DEFAULT_WMM_ENABLED;
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        config->class_access[i] = DEFAULT_WMM_AC;
+    }
+    config->espnow_transport = DEFAULT_ESPNOW_TRANSPORT;
     
     printf("All classes reset to default values.\n");
     printf("Processing threshold reset to %lu ms.\n", config->processing_threshold);
@@ -1061,6 +1330,41 @@ static int cmd_threshold(int argc, char **argv, scheduler_config_t *config)
     return 0;
 }
 
+/*
+ * Energy-budget scheduling: the station models its energy use and, as the
+ * budget runs low, batches harder, caps TX power and finally sheds the
+ * random class (energy_budget.h).
+ */
+static int cmd_budget(int argc, char **argv, scheduler_config_t *config)
+{
+    if (argc < 2) {
+        printf("Usage: budget <mJ_per_hour>|off\n");
+        if (config->energy_budget > 0) {
+            printf("Current budget: %lu mJ/hour\n", config->energy_budget);
+        } else {
+            printf("Current budget: OFF\n");
+        }
+        return 1;
+    }
+    
+    if (strcasecmp(argv[1], "off") == 0) {
+        config->energy_budget = 0;
+        printf("Energy budget off; scheduling on deadlines alone.\n");
+        return 0;
+    }
+    
+    char *end;
+    unsigned long budget = strtoul(argv[1], &end, 10);
+    if (*end != '\0' || budget == 0 || budget > MAX_ENERGY_BUDGET) {
+        printf("Error: Budget must be 1-%d mJ/hour or 'off'.\n", MAX_ENERGY_BUDGET);
+        return 1;
+    }
+    
+    config->energy_budget = budget;
+    printf("Energy budget set to %lu mJ/hour (%.1f mW average).\n", config->energy_budget, budget / 3600.0);
+    return 0;
+}
+
 /* Set random values for all classes */
 static int cmd_random(int argc, char **argv, scheduler_config_t *config) 
 {
@@ -1122,18 +1426,248 @@ static int cmd_random(int argc, char **argv, scheduler_config_t *config)
 }
 
 /* Start the program with the current configuration */
+/* Protocol option that produces the configured protocol bitmap */
+static const char *protocol_label(const scheduler_config_t *config)
+{
+    bool n = config->wifi_protocol & WIFI_PROTOCOL_11N;
+    bool g = config->wifi_protocol & WIFI_PROTOCOL_11G;
+
+    if (n) {
+        return config->disable_11b_rates ? "gn" : "bgn";
+    }
+    if (g) {
+        return config->disable_11b_rates ? "g" : "bg";
+    }
+    return "b";
+}
+
+static const char *ps_mode_label(wifi_ps_type_t mode)
+{
+    switch (mode) {
+        case WIFI_PS_NONE: return "none";
+        case WIFI_PS_MIN_MODEM: return "min";
+        case WIFI_PS_MAX_MODEM: return "max";
+        default: return "unknown";
+    }
+}
+
+/*
+ * One-line key=value record of the whole configuration. Captured with the
+ * current trace, it becomes the trace's entry in data/manifest.txt.
+ */
+static void print_manifest(const scheduler_config_t *config)
+{
+    printf(MANIFEST_PREFIX);
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        printf(" class%d_period_ms=%lu class%d_deadline_ms=%lu class%d_type=%s class%d_count=%u",
+               i + 1, config->class_periods[i], i + 1, config->class_deadlines[i],
+               i + 1, type_label(config->class_types[i]), i + 1, config->packet_counts[i]);
+    }
+    printf(" sample_times=0x%lx threshold_ms=%lu energy_budget_mj_h=%lu",
+           config->sample_time_mask, config->processing_threshold, config->energy_budget);
+    printf(" dedup=0x%lx", config->dedup_mask);
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        if (config->dedup_mask & (1u << i)) {
+            printf(" class%d_deadband=%g class%d_keyframe_ms=%lu",
+                   i + 1, config->dedup_deadband[i], i + 1, config->dedup_keyframe_ms[i]);
+        }
+    }
+    printf(" random=%d random_min_ms=%lu random_max_ms=%lu burst=%d burst_period_ms=%lu burst_interval_ms=%lu"
+           " random_count=%u random_type=%s",
+           config->random_packet_enabled, config->random_packet_min_interval,
+           config->random_packet_max_interval, config->random_packet_burst_enabled,
+           config->random_packet_burst_period, config->random_packet_burst_interval,
+           config->random_packet_count, type_label(config->random_packet_type));
+    printf(" tx_power=%d ps_mode=%s protocol=%s autotx=%d autotx_interval_ms=%lu wmm=%d transport=%s\n",
+           config->wifi_tx_power, ps_mode_label(config->wifi_ps_mode), protocol_label(config),
+           config->auto_tx_power, config->auto_tx_power_interval, config->wmm_enabled,
+           config->espnow_transport ? "espnow" : "raw");
+}
+
+static int cmd_manifest(int argc, char **argv, scheduler_config_t *config)
+{
+    print_manifest(config);
+    return 0;
+}
+
 static int cmd_start(int argc, char **argv, scheduler_config_t *config) 
 {
     ESP_LOGI(TAG, "Starting program with current configuration");
     
     printf("\nStarting program with following configuration:\n");
     cmd_status(0, NULL, config);
+    print_manifest(config);
     
     printf("\nProgram starting...\n");
     config->start_program = true;
     return 0;
 }
 
+/* Split a comma-separated list; returns the number of items, -1 if more than max */
+static int split_list(char *list, char **items, int max)
+{
+    int n = 0;
+    for (char *save = NULL, *item = strtok_r(list, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save)) {
+        if (n == max) {
+            return -1;
+        }
+        items[n++] = item;
+    }
+    return n;
+}
+
+static void bench_usage(void)
+{
+    printf("Usage: bench tx [seconds] [payload_bytes] [rate]\n");
+    printf("       seconds: 1-%d (default %d)\n", BENCH_MAX_DURATION_S, BENCH_DEFAULT_DURATION_S);
+    printf("       payload_bytes: %d-%d (default %d, the largest frame)\n",
+           (int)BENCH_MIN_PAYLOAD, MAX_TX_SIZE, MAX_TX_SIZE);
+    printf("       rate: 1, 2, 5.5, 11, 6-54 or mcs0-mcs7 (default: chosen by the driver)\n");
+    printf("       bench ping [probes] [sizes] [psmodes] [protocols]\n");
+    printf("       probes: per sweep point, 1-%d (default %d)\n", BENCH_PING_MAX_COUNT, BENCH_PING_DEFAULT_COUNT);
+    printf("       sizes: payload bytes, comma-separated (default 16,512,%d)\n", MAX_TX_SIZE);
+    printf("       psmodes: none,min,max (default: the psmode setting)\n");
+    printf("       protocols: b,bg,bgn (default: the protocol setting)\n");
+    printf("  Example: bench tx 30 1400 54\n");
+    printf("  Example: bench ping 200 16,1400 none,min,max b,bgn\n");
+}
+
+/* Parse the arguments of 'bench tx' */
+static int bench_tx_args(int argc, char **argv, scheduler_config_t *config)
+{
+    uint32_t duration = BENCH_DEFAULT_DURATION_S;
+    uint32_t payload = MAX_TX_SIZE;
+    if (argc > 2) {
+        duration = strtoul(argv[2], NULL, 10);
+        if (duration < 1 || duration > BENCH_MAX_DURATION_S) {
+            printf("Error: Duration must be between 1 and %d seconds.\n", BENCH_MAX_DURATION_S);
+            return 1;
+        }
+    }
+    if (argc > 3) {
+        payload = strtoul(argv[3], NULL, 10);
+        if (payload < BENCH_MIN_PAYLOAD || payload > MAX_TX_SIZE) {
+            printf("Error: Payload must be between %d and %d bytes.\n", (int)BENCH_MIN_PAYLOAD, MAX_TX_SIZE);
+            return 1;
+        }
+    }
+    config->bench_fixed_rate = false;
+    if (argc > 4) {
+        if (!bench_rate_from_option(argv[4], &config->bench_rate)) {
+            printf("Error: Unknown rate '%s'.\n", argv[4]);
+            return 1;
+        }
+        config->bench_fixed_rate = true;
+    }
+    
+    config->bench_duration_s = duration;
+    config->bench_payload_len = (uint16_t)payload;
+    printf("\nBenchmark: %lu s of %lu-byte payloads, rate %s, protocol %s, TX power %d\n",
+           duration, payload, config->bench_fixed_rate ? bench_rate_label(config->bench_rate) : "auto",
+           protocol_label(config), config->wifi_tx_power);
+    return 0;
+}
+
+/* Parse the arguments of 'bench ping' */
+static int bench_ping_args(int argc, char **argv, scheduler_config_t *config)
+{
+    char *items[BENCH_SWEEP_MAX];
+    int n;
+    
+    config->bench_ping_count = BENCH_PING_DEFAULT_COUNT;
+    config->bench_ping_sizes[0] = 16;
+    config->bench_ping_sizes[1] = 512;
+    config->bench_ping_sizes[2] = MAX_TX_SIZE;
+    config->bench_ping_size_count = 3;
+    config->bench_ping_ps[0] = config->wifi_ps_mode;
+    config->bench_ping_ps_count = 1;
+    config->bench_ping_protocols[0] = config->wifi_protocol;
+    config->bench_ping_protocol_count = 1;
+    
+    if (argc > 2) {
+        unsigned long count = strtoul(argv[2], NULL, 10);
+        if (count < 1 || count > BENCH_PING_MAX_COUNT) {
+            printf("Error: Probes must be between 1 and %d.\n", BENCH_PING_MAX_COUNT);
+            return 1;
+        }
+        config->bench_ping_count = (uint16_t)count;
+    }
+    if (argc > 3) {
+        if ((n = split_list(argv[3], items, BENCH_SWEEP_MAX)) <= 0) {
+            printf("Error: Give 1 to %d sizes.\n", BENCH_SWEEP_MAX);
+            return 1;
+        }
+        for (int i = 0; i < n; i++) {
+            unsigned long size = strtoul(items[i], NULL, 10);
+            if (size < BENCH_MIN_PAYLOAD || size > MAX_TX_SIZE) {
+                printf("Error: Sizes must be between %d and %d bytes.\n", (int)BENCH_MIN_PAYLOAD, MAX_TX_SIZE);
+                return 1;
+            }
+            config->bench_ping_sizes[i] = (uint16_t)size;
+        }
+        config->bench_ping_size_count = (uint8_t)n;
+    }
+    if (argc > 4) {
+        if ((n = split_list(argv[4], items, BENCH_SWEEP_MAX)) <= 0) {
+            printf("Error: Give 1 to %d power save modes.\n", BENCH_SWEEP_MAX);
+            return 1;
+        }
+        for (int i = 0; i < n; i++) {
+            if (!bench_ps_from_option(items[i], &config->bench_ping_ps[i])) {
+                printf("Error: Unknown power save mode '%s'. Use none, min or max.\n", items[i]);
+                return 1;
+            }
+        }
+        config->bench_ping_ps_count = (uint8_t)n;
+    }
+    if (argc > 5) {
+        if ((n = split_list(argv[5], items, BENCH_SWEEP_MAX)) <= 0) {
+            printf("Error: Give 1 to %d protocols.\n", BENCH_SWEEP_MAX);
+            return 1;
+        }
+        for (int i = 0; i < n; i++) {
+            if (!bench_protocol_from_option(items[i], &config->bench_ping_protocols[i])) {
+                printf("Error: Unknown protocol '%s'. Use b, bg or bgn.\n", items[i]);
+                return 1;
+            }
+        }
+        config->bench_ping_protocol_count = (uint8_t)n;
+    }
+    
+    printf("\nLatency sweep: %u probes at each of %u sizes, %u power save modes and %u protocols\n",
+           config->bench_ping_count, config->bench_ping_size_count, config->bench_ping_ps_count,
+           config->bench_ping_protocol_count);
+    return 0;
+}
+
+/* Connect and run a link benchmark instead of the scheduler */
+static int cmd_bench(int argc, char **argv, scheduler_config_t *config)
+{
+    bench_mode_t mode;
+    int ret;
+    
+    if (argc >= 2 && strcasecmp(argv[1], "tx") == 0) {
+        mode = BENCH_TX;
+        ret = bench_tx_args(argc, argv, config);
+    } else if (argc >= 2 && strcasecmp(argv[1], "ping") == 0) {
+        mode = BENCH_PING;
+        ret = bench_ping_args(argc, argv, config);
+    } else {
+        bench_usage();
+        return 1;
+    }
+    if (ret != 0) {
+        return ret;
+    }
+    
+    config->bench_mode = mode;
+    print_manifest(config);
+    
+    printf("\nConnecting...\n");
+    config->start_program = true;
+    return 0;
+}
+
 /* Define the command array */
 static const cmd_t commands[] = {
     {"help", "Print the list of commands", cmd_help},
@@ -1141,10 +1675,16 @@ static const cmd_t commands[] = {
     {"set", "Set period and deadline for a class", cmd_set_class},
     {"type", "Set data type for a class", cmd_type},
     {"count", "Set packet count for a class", cmd_packet_count},
+    {"schema", "Define a mixed-field record schema", cmd_schema},
+    {"timestamps", "Send per-sample capture times for a class", cmd_timestamps},
+    {"dedup", "Send a class only when it changes beyond a dead-band", cmd_dedup},
     {"threshold", "Set processing threshold", cmd_threshold},
+    {"budget", "Set an energy budget in mJ/hour", cmd_budget},
     {"reset", "Reset all classes to default values", cmd_reset},
     {"random", "Set random periods and deadlines for all classes", cmd_random},
     {"start", "Start program with current configuration", cmd_start},
+    {"manifest", "Print the configuration as an experiment manifest line", cmd_manifest},
+    {"bench", "Run the link throughput or latency benchmark", cmd_bench},
     {"rpacket", "Configure random packet generation", cmd_random_packet},
     {"rtype", "Set random packet data type", cmd_random_packet_type},
     {"rsize", "Set random packet size", cmd_random_packet_count},
@@ -1155,6 +1695,8 @@ static const cmd_t commands[] = {
     {"protocol", "Set WiFi protocol", cmd_wifi_protocol},
     {"autotx", "Configure automatic TX power adjustment", cmd_auto_tx_power},
     {"autotx_interval", "Set auto TX power check interval", cmd_auto_tx_interval},
+    {"wmm", "Set WMM access category per class", cmd_wmm},
+    {"transport", "Send frames raw or over ESP-NOW", cmd_transport},
     {"verify_wifi", "Verify current WiFi settings against configuration", cmd_verify_wifi},
     {NULL, NULL, NULL}
 };
@@ -1262,8 +1804,19 @@ esp_err_t terminal_init_and_configure(scheduler_config_t *config)
     config->packet_counts[CLASS_3] = DEFAULT_CLASS3_COUNT;
     config->packet_counts[CLASS_RANDOM] = 0;  // Not applicable for random packets
     
+    // Per-sample timestamps are off; frames carry only the frame timestamp
+    config->sample_time_mask = 0;
+    
+    // Send-on-delta is off; when enabled a class keyframes every minute by default
+    config->dedup_mask = 0;
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        config->dedup_deadband[i] = 0;
+        config->dedup_keyframe_ms[i] = DEFAULT_DEDUP_KEYFRAME_MS;
+    }
+    
     // Set default processing threshold
     config->processing_threshold = DEFAULT_PROCESSING_THRESHOLD;
+    config->energy_budget = 0;
 
     // Initialize random packet parameters
     config->random_packet_enabled = false;  // Disabled by default
@@ -1280,10 +1833,21 @@ esp_err_t terminal_init_and_configure(scheduler_config_t *config)
     config->wifi_ps_mode = DEFAULT_WIFI_PS_MODE;
     config->wifi_protocol = DEFAULT_WIFI_PROTOCOL;
     config->disable_11b_rates = false;
+    config->wmm_enabled = DEFAULT_WMM_ENABLED;
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        config->class_access[i] = DEFAULT_WMM_AC;
+    }
+    config->espnow_transport = DEFAULT_ESPNOW_TRANSPORT;
 
     // Initialize auto TX power adjustment
     config->auto_tx_power = false;
     config->auto_tx_power_interval = 5000; // Default: check every 5 seconds
+
+    // The scheduler runs unless a 'bench' command is given
+    config->bench_mode = BENCH_NONE;
+    config->bench_duration_s = BENCH_DEFAULT_DURATION_S;
+    config->bench_payload_len = MAX_TX_SIZE;
+    config->bench_fixed_rate = false;
     
     // Display current configuration
     cmd_status(0, NULL, config);
@@ -21,6 +21,8 @@
 #include "linenoise/linenoise.h"
 #include "esp_random.h"  // For esp_random() function
 #include "esp_wifi.h"
+#include "sched_types.h"  // class_id_t, data_type_t, MAX_CLASSES
+#include "frame_codec.h"  // wmm_ac_t
 
 
 /* Terminal Configuration */
@@ -31,7 +33,6 @@
 #define MAX_CMDLINE_LENGTH  256
 
 /* Class and Deadline Configuration */
-#define MAX_CLASSES         4     // Number of classes
 #define DEFAULT_CLASS1_PERIOD 3000    // Default: 3 seconds
 #define DEFAULT_CLASS2_PERIOD 5000    // Default: 5 seconds
 #define DEFAULT_CLASS3_PERIOD 6000    // Default: 6 seconds
@@ -50,13 +51,12 @@
 #define MAX_DEADLINE_FACTOR 1.2       // Deadline can be 120% of period at maximum
 #define MIN_THRESHOLD       100       // Minimum processing threshold: 100ms
 #define MAX_THRESHOLD       5000      // Maximum processing threshold: 5000ms (5s)
+#define MAX_ENERGY_BUDGET   100000000 // Largest energy budget: 100 J/hour (mJ/hour)
+#define DEFAULT_DEDUP_KEYFRAME_MS 60000  // Send-on-delta sends an unchanged class at least once a minute
+#define MAX_DEDUP_KEYFRAME_MS 3600000    // Longest keyframe interval: 1 hour
 
-/* Data type options for command line */
-#define TYPE_OPTION_INT8  "int8"
-#define TYPE_OPTION_INT16 "int16"
-#define TYPE_OPTION_INT32 "int32"
-#define TYPE_OPTION_FLOAT "float"
-#define TYPE_OPTION_DOUBLE "double"
+/* Start of the configuration line printed on start (see data/manifest.txt) */
+#define MANIFEST_PREFIX     "@CFG"
 
 /* Random Packet Configuration */
 #define DEFAULT_RANDOM_PACKET_MIN_INTERVAL 500    // Default min interval: 500ms
@@ -73,6 +73,9 @@
 #define DEFAULT_WIFI_PS_MODE     WIFI_PS_MIN_MODEM  // Default: Min modem
 #define DEFAULT_WIFI_PROTOCOL    (WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N)  // Default: 11bgn
 #define DEFAULT_DISABLE_11B_RATES false  // Default: 11b rates enabled
+#define DEFAULT_WMM_ENABLED      false   // Default: plain data frames
+#define DEFAULT_WMM_AC           WMM_AC_BE  // Default access category per class
+#define DEFAULT_ESPNOW_TRANSPORT false   // Default: raw 802.11 data frames
 
 /* Adaptive TX power configuration */
 #define RSSI_EXCELLENT    -5    // -15 dBm or better: excellent signal
@@ -85,21 +88,14 @@
 #define TX_POWER_MEDIUM   60     // 15 dBm
 #define TX_POWER_HIGH     80     // 20 dBm (maximum)
 
-/* Forward declarations for scheduler types */
+/* What runs once connected: the scheduler or one of the link benchmarks (link_bench.h) */
 typedef enum {
-    CLASS_1 = 0,                 // Class 1
-    CLASS_2 = 1,                 // Class 2
-    CLASS_3 = 2,                 // Class 3
-    CLASS_RANDOM = 3,            // Random packet class
-} class_id_t;
+    BENCH_NONE = 0,                // The scheduler
+    BENCH_TX,                      // 'bench tx': raw-link throughput
+    BENCH_PING,                    // 'bench ping': round-trip latency sweep
+} bench_mode_t;
 
-typedef enum {
-    DATA_TYPE_INT8 = 0,          // 8-bit integer
-    DATA_TYPE_INT16 = 1,         // 16-bit integer
-    DATA_TYPE_INT32 = 2,         // 32-bit integer
-    DATA_TYPE_FLOAT = 3,         // 32-bit float
-    DATA_TYPE_DOUBLE = 4,        // 64-bit double
-} data_type_t;
+#define BENCH_SWEEP_MAX     8      // Values per swept parameter of 'bench ping'
 
 /* Configuration structure to be passed back to the main program */
 typedef struct {
@@ -107,7 +103,12 @@ typedef struct {
     uint32_t class_deadlines[MAX_CLASSES]; // Deadline for each class (ms)
     data_type_t class_types[MAX_CLASSES];  // Data type for each class
     uint16_t packet_counts[MAX_CLASSES];   // Packet count for each class
+    class_mask_t sample_time_mask;         // Bit i set: class i sends per-sample times
+    class_mask_t dedup_mask;               // Bit i set: class i sends on delta only
+    float dedup_deadband[MAX_CLASSES];     // Changes up to this much are held back
+    uint32_t dedup_keyframe_ms[MAX_CLASSES]; // Longest gap between sent groups (0: only on change)
     uint32_t processing_threshold;         // Deadline processing threshold (ms)
+    uint32_t energy_budget;                // Energy budget (mJ/hour); 0 schedules on deadlines alone
     bool start_program;                    // Flag to indicate if program should start
     
     // Random packet generation parameters
@@ -125,11 +126,28 @@ typedef struct {
     wifi_ps_type_t wifi_ps_mode;   // WiFi power save mode
     uint8_t wifi_protocol;         // WiFi protocol bitmap
     bool disable_11b_rates;        // Whether to disable 11b rates for pure G mode
+    bool wmm_enabled;              // Send QoS data frames with a WMM access category
+    wmm_ac_t class_access[MAX_CLASSES];  // Access category for each class
+    bool espnow_transport;         // Send frame bodies over ESP-NOW instead of raw data frames
 
     // adaptive tx power on rssi 
     bool auto_tx_power;            // Whether to automatically adjust TX power based on RSSI
     uint32_t auto_tx_power_interval;  // Interval (ms) for checking and adjusting TX power
 
+    // Link benchmarks, run instead of the scheduler
+    bench_mode_t bench_mode;
+    uint32_t bench_duration_s;     // How long 'bench tx' saturates the link
+    uint16_t bench_payload_len;    // Payload bytes per 'bench tx' frame
+    bool bench_fixed_rate;         // Send at bench_rate rather than the driver's choice
+    wifi_phy_rate_t bench_rate;    // PHY rate when bench_fixed_rate is set
+    uint16_t bench_ping_count;     // Probes per 'bench ping' sweep point
+    uint16_t bench_ping_sizes[BENCH_SWEEP_MAX];        // Probe payload bytes to sweep
+    uint8_t bench_ping_size_count;
+    wifi_ps_type_t bench_ping_ps[BENCH_SWEEP_MAX];     // Power save modes to sweep
+    uint8_t bench_ping_ps_count;
+    uint8_t bench_ping_protocols[BENCH_SWEEP_MAX];     // Protocol bitmaps to sweep
+    uint8_t bench_ping_protocol_count;
+
 } scheduler_config_t;
 
 /**
@@ -0,0 +1,137 @@
+/**
+ * @file energy_budget.c
+ * @brief Station energy model and budget bucket
+ */
+
+#include "energy_budget.h"
+
+#define MS_PER_HOUR     3600000.0
+
+/* Balance, as a fraction of the bucket, needed for NORMAL, BATCH and LOW_POWER */
+static const double level_floor[] = { 0.5, 0.25, 0.0 };
+
+void energy_model_defaults(energy_model_t *model)
+{
+    *model = (energy_model_t){
+        .voltage_v = 5.0,
+        .idle_a = 0.027,
+        .listen_a = 0.08,
+        .tx_a = 0.25,
+        .tx_min_a = 0.17,
+        .beacon_ms = 102.4,
+        .max_modem_beacons = 3,
+        .listen_ms = 6.0,
+        .tx_lead_ms = 1.0,
+        .tx_fixed_ms = 0.2,
+        .rate_mbps = 1.0,
+        .tx_tail_ms = 3.0,
+    };
+}
+
+/* Current between frames: the receiver stays on without power save */
+static double floor_a(const energy_model_t *model, energy_ps_t ps)
+{
+    return ps == ENERGY_PS_NONE ? model->listen_a : model->idle_a;
+}
+
+double energy_frame_mj(const energy_model_t *model, energy_ps_t ps, size_t len, int8_t tx_power)
+{
+    double scale = (double)(tx_power - ENERGY_TX_POWER_MIN) / (ENERGY_TX_POWER_MAX - ENERGY_TX_POWER_MIN);
+    scale = scale < 0 ? 0 : scale > 1 ? 1 : scale;
+    double tx_a = model->tx_min_a + (model->tx_a - model->tx_min_a) * scale;
+
+    double air_ms = model->tx_fixed_ms + (model->rate_mbps > 0 ? len * 8.0 / (model->rate_mbps * 1000.0) : 0);
+    double base = floor_a(model, ps);
+    double charge = (tx_a - base) * air_ms + (model->listen_a - base) * (model->tx_lead_ms + model->tx_tail_ms);
+    return charge * model->voltage_v;   // A * ms * V = mJ
+}
+
+/* Average power with no frames: CPU idle plus power-save wakes, or the receiver always on */
+static double baseline_mw(const energy_model_t *model, energy_ps_t ps)
+{
+    if (ps == ENERGY_PS_NONE || model->beacon_ms <= 0) {
+        return model->listen_a * model->voltage_v * 1000.0;
+    }
+    double period = model->beacon_ms * (ps == ENERGY_PS_MAX ? model->max_modem_beacons : 1.0);
+    double duty = model->listen_ms < period ? model->listen_ms / period : 1.0;
+    return (model->idle_a + (model->listen_a - model->idle_a) * duty) * model->voltage_v * 1000.0;
+}
+
+void energy_budget_init(energy_budget_t *budget, const energy_model_t *model, uint32_t mj_per_hour,
+                        energy_ps_t ps, uint32_t now_ms)
+{
+    *budget = (energy_budget_t){
+        .model = *model,
+        .ps = ps,
+        .mj_per_hour = mj_per_hour,
+        .baseline_mw = baseline_mw(model, ps),
+        .capacity_mj = mj_per_hour * (ENERGY_BUDGET_BUCKET_S / 3600.0),
+        .last_ms = now_ms,
+        .level = ENERGY_LEVEL_NORMAL,
+    };
+    budget->balance_mj = budget->capacity_mj;
+}
+
+void energy_budget_frame(energy_budget_t *budget, size_t len, int8_t tx_power)
+{
+    double mj = energy_frame_mj(&budget->model, budget->ps, len, tx_power);
+    budget->balance_mj -= mj;
+    budget->spent_mj += mj;
+    budget->frames_mj += mj;
+    budget->frames++;
+}
+
+energy_level_t energy_budget_update(energy_budget_t *budget, uint32_t now_ms)
+{
+    uint32_t dt = now_ms - budget->last_ms;
+    budget->last_ms = now_ms;
+    budget->elapsed_ms += dt;
+
+    double baseline = budget->baseline_mw * dt / 1000.0;
+    budget->spent_mj += baseline;
+    budget->balance_mj += budget->mj_per_hour * (dt / MS_PER_HOUR) - baseline;
+    if (budget->balance_mj > budget->capacity_mj) {
+        budget->balance_mj = budget->capacity_mj;
+    }
+
+    double fraction = budget->capacity_mj > 0 ? budget->balance_mj / budget->capacity_mj : -1.0;
+    int target = ENERGY_LEVEL_SHED;
+    for (int level = ENERGY_LEVEL_NORMAL; level < ENERGY_LEVEL_SHED; level++) {
+        if (fraction >= level_floor[level]) {
+            target = level;
+            break;
+        }
+    }
+    // Going back up needs a margin above the floor
+    while (target < (int)budget->level &&
+           fraction < level_floor[target] + ENERGY_BUDGET_HYSTERESIS_PCT / 100.0) {
+        target++;
+    }
+
+    if (target != (int)budget->level) {
+        budget->level = (energy_level_t)target;
+        budget->level_changes++;
+    }
+    return budget->level;
+}
+
+bool energy_budget_feasible(const energy_budget_t *budget)
+{
+    return budget->baseline_mw * 3600.0 < budget->mj_per_hour;
+}
+
+double energy_budget_rate(const energy_budget_t *budget)
+{
+    return budget->elapsed_ms > 0 ? budget->spent_mj * MS_PER_HOUR / budget->elapsed_ms : 0.0;
+}
+
+const char *energy_level_name(energy_level_t level)
+{
+    switch (level) {
+        case ENERGY_LEVEL_NORMAL: return "normal";
+        case ENERGY_LEVEL_BATCH: return "batch";
+        case ENERGY_LEVEL_LOW_POWER: return "low_power";
+        case ENERGY_LEVEL_SHED: return "shed";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,435 @@
+/**
+ * @file frame_codec.c
+ * @brief Build and parse scheduler data frames
+ */
+
+#include <string.h>
+#include <strings.h>
+#include "frame_codec.h"
+#include "crc32c.h"
+
+static const uint8_t broadcast_mac[WIFI_MAC_LEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+/* User priority sent for each category (the higher of its two 802.1D priorities
+ * for VI and VO, the default priority for BE and BK) */
+static const uint8_t wmm_ac_tids[WMM_AC_NUM] = {
+    [WMM_AC_BK] = 1,
+    [WMM_AC_BE] = 0,
+    [WMM_AC_VI] = 5,
+    [WMM_AC_VO] = 6,
+};
+
+static const char *const wmm_ac_names[WMM_AC_NUM] = {
+    [WMM_AC_BK] = "BK",
+    [WMM_AC_BE] = "BE",
+    [WMM_AC_VI] = "VI",
+    [WMM_AC_VO] = "VO",
+};
+
+uint16_t frame_payload_size(const uint8_t class_counts[MAX_CLASSES],
+                            const data_type_t class_types[MAX_CLASSES])
+{
+    uint32_t size = 0;
+
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        size += (uint32_t)class_type_size(class_types[i]) * class_counts[i];
+    }
+
+    return size > UINT16_MAX ? UINT16_MAX : (uint16_t)size;
+}
+
+/* Station-to-AP MAC header; a negative tid produces a plain data header */
+static size_t write_mac_header(uint8_t *out, const frame_addr_t *addr, int tid)
+{
+    size_t mac_header_len = tid < 0 ? WIFI_DATA_HEADER_LEN : WIFI_QOS_DATA_HEADER_LEN;
+
+    // Clear the 802.11 header so duration, sequence and QoS control are zero
+    memset(out, 0, mac_header_len);
+
+    // Frame Control: Data (0x08) or QoS Data (0x88) with FromDS=0, ToDS=1 (Station to AP)
+    out[0] = tid < 0 ? WIFI_FC0_DATA : (WIFI_FC0_DATA | WIFI_FC0_SUBTYPE_QOS);
+    out[1] = WIFI_FC1_TO_DS;
+
+    memcpy(&out[4], addr->da, WIFI_MAC_LEN);
+    memcpy(&out[10], addr->sa, WIFI_MAC_LEN);
+    memcpy(&out[16], addr->bssid, WIFI_MAC_LEN);
+
+    // QoS control: TID in the low bits, normal ack policy
+    if (tid >= 0) {
+        out[WIFI_DATA_HEADER_LEN] = (uint8_t)tid & WIFI_QOS_TID_MASK;
+    }
+
+    return mac_header_len;
+}
+
+/* Common writer; a negative tid produces a plain data frame */
+static size_t build_frame(uint8_t *out, size_t out_cap, const frame_addr_t *addr, int tid,
+                          const data_packet_header_t *header, const uint8_t *payload, bool crc)
+{
+    size_t mac_header_len = tid < 0 ? WIFI_DATA_HEADER_LEN : WIFI_QOS_DATA_HEADER_LEN;
+    size_t covered = sizeof(data_packet_header_t) + header->total_size;
+    size_t frame_len = mac_header_len + covered + (crc ? FRAME_CRC_LEN : 0);
+    if (frame_len > out_cap) {
+        return 0;
+    }
+
+    write_mac_header(out, addr, tid);
+
+    // Our header after the 802.11 header, then the class data
+    data_packet_header_t *written = (data_packet_header_t *)(out + mac_header_len);
+    memcpy(written, header, sizeof(data_packet_header_t));
+    if (payload != NULL && header->total_size > 0) {
+        memcpy(out + mac_header_len + sizeof(data_packet_header_t),
+               payload, header->total_size);
+    }
+
+    if (crc) {
+        written->flags |= FRAME_FLAG_CRC;
+        uint32_t sum = crc32c(0, written, covered);
+        uint8_t *trailer = out + mac_header_len + covered;
+        for (int i = 0; i < FRAME_CRC_LEN; i++) {
+            trailer[i] = (uint8_t)(sum >> (8 * i));
+        }
+    }
+
+    return frame_len;
+}
+
+size_t frame_build(uint8_t *out, size_t out_cap, const frame_addr_t *addr,
+                   const data_packet_header_t *header, const uint8_t *payload)
+{
+    return build_frame(out, out_cap, addr, -1, header, payload, true);
+}
+
+size_t frame_build_qos(uint8_t *out, size_t out_cap, const frame_addr_t *addr, wmm_ac_t ac,
+                       const data_packet_header_t *header, const uint8_t *payload)
+{
+    return build_frame(out, out_cap, addr, wmm_ac_tid(ac), header, payload, true);
+}
+
+size_t frame_build_from_body(uint8_t *out, size_t out_cap, const frame_addr_t *addr,
+                             const uint8_t *body, size_t body_len)
+{
+    if (WIFI_DATA_HEADER_LEN + body_len > out_cap) {
+        return 0;
+    }
+    size_t mac_header_len = write_mac_header(out, addr, -1);
+    memcpy(out + mac_header_len, body, body_len);
+    return mac_header_len + body_len;
+}
+
+size_t frame_build_schema(uint8_t *out, size_t out_cap, const frame_addr_t *addr,
+                          const uint8_t *schema_ids, size_t id_count, uint32_t timestamp)
+{
+    uint8_t payload[MAX_CLASSES * (2 + SCHEMA_MAX_FIELDS)];
+    size_t len = record_schema_pack(payload, sizeof(payload), schema_ids, id_count);
+    if (len == 0) {
+        return 0;
+    }
+
+    data_packet_header_t header = {0};
+    header.class_types[0] = (data_type_t)FRAME_SCHEMA_MARKER;
+    header.total_size = (uint16_t)len;
+    header.timestamp = timestamp;
+
+    return frame_build(out, out_cap, addr, &header, payload);
+}
+
+size_t frame_build_bench(uint8_t *out, size_t out_cap, const frame_addr_t *addr,
+                         const frame_bench_t *bench, uint16_t payload_len, uint32_t timestamp)
+{
+    if (payload_len < sizeof(frame_bench_t) || payload_len > MAX_TX_SIZE) {
+        return 0;
+    }
+
+    data_packet_header_t header = {0};
+    header.class_types[0] = (data_type_t)FRAME_BENCH_MARKER;
+    header.total_size = payload_len;
+    header.timestamp = timestamp;
+
+    // No trailer: the payload is written after the header, and the link benchmark measures the raw link
+    size_t frame_len = build_frame(out, out_cap, addr, -1, &header, NULL, false);
+    if (frame_len == 0) {
+        return 0;
+    }
+
+    // The filler is a counting pattern so a corrupted frame is easy to spot in a capture
+    uint8_t *payload = out + WIFI_DATA_HEADER_LEN + sizeof(data_packet_header_t);
+    memcpy(payload, bench, sizeof(*bench));
+    for (size_t i = sizeof(*bench); i < payload_len; i++) {
+        payload[i] = (uint8_t)i;
+    }
+
+    return frame_len;
+}
+
+bool frame_bench_read(const frame_view_t *view, frame_bench_t *bench)
+{
+    if (view->kind != FRAME_KIND_BENCH || view->payload_len < sizeof(*bench)) {
+        return false;
+    }
+    memcpy(bench, view->payload, sizeof(*bench));
+    return true;
+}
+
+/* Offset of the frame_bench_t in a plain or QoS benchmark frame, 0 if it is not one */
+static size_t bench_offset(const uint8_t *frame, size_t len)
+{
+    if (len < WIFI_DATA_HEADER_LEN || (frame[0] & WIFI_FC0_TYPE_MASK) != WIFI_FC0_DATA) {
+        return 0;
+    }
+    size_t mac_header_len = WIFI_DATA_HEADER_LEN;
+    if (frame[0] & WIFI_FC0_SUBTYPE_QOS) {
+        mac_header_len = WIFI_QOS_DATA_HEADER_LEN + ((frame[1] & WIFI_FC1_ORDER) ? WIFI_HTC_LEN : 0);
+    }
+    if (len < mac_header_len + sizeof(data_packet_header_t) + sizeof(frame_bench_t)) {
+        return 0;
+    }
+    const data_packet_header_t *header = (const data_packet_header_t *)(frame + mac_header_len);
+    if (header->class_types[0] != (data_type_t)FRAME_BENCH_MARKER) {
+        return 0;
+    }
+    return mac_header_len + sizeof(data_packet_header_t);
+}
+
+size_t frame_build_bench_echo(uint8_t *out, size_t out_cap, const uint8_t *probe, size_t probe_len)
+{
+    size_t offset = bench_offset(probe, probe_len);
+    if (offset == 0 || probe_len > out_cap ||
+        (probe[1] & (WIFI_FC1_TO_DS | WIFI_FC1_FROM_DS)) != WIFI_FC1_TO_DS) {
+        return 0;
+    }
+    frame_bench_t bench;
+    memcpy(&bench, probe + offset, sizeof(bench));
+    if (!(bench.flags & FRAME_BENCH_PROBE)) {
+        return 0;
+    }
+
+    // FromDS addressing: receiver is the station, then BSSID, then source (the AP itself)
+    memcpy(out, probe, probe_len);
+    out[1] = WIFI_FC1_FROM_DS;
+    out[2] = out[3] = 0;
+    memcpy(&out[4], &probe[10], WIFI_MAC_LEN);
+    memcpy(&out[10], &probe[16], WIFI_MAC_LEN);
+    memcpy(&out[16], &probe[16], WIFI_MAC_LEN);
+
+    bench.flags = (uint8_t)((bench.flags & ~FRAME_BENCH_PROBE) | FRAME_BENCH_ECHO);
+    memcpy(out + offset, &bench, sizeof(bench));
+    return probe_len;
+}
+
+bool frame_parse_bench_echo(const uint8_t *frame, size_t len, const uint8_t our_mac[WIFI_MAC_LEN],
+                            frame_bench_t *bench)
+{
+    size_t offset = bench_offset(frame, len);
+    if (offset == 0 || (frame[1] & (WIFI_FC1_TO_DS | WIFI_FC1_FROM_DS)) != WIFI_FC1_FROM_DS ||
+        memcmp(&frame[4], our_mac, WIFI_MAC_LEN) != 0) {
+        return false;
+    }
+    memcpy(bench, frame + offset, sizeof(*bench));
+    return (bench->flags & FRAME_BENCH_ECHO) != 0;
+}
+
+frame_status_t frame_parse(const uint8_t *frame, size_t len,
+                           const uint8_t our_mac[WIFI_MAC_LEN], frame_view_t *view)
+{
+    // We need the 802.11 header and our data packet header
+    if (len < WIFI_DATA_HEADER_LEN + sizeof(data_packet_header_t)) {
+        return FRAME_ERR_TOO_SHORT;
+    }
+
+    // For AP receiving, we want data frames from stations (to_ds=1, from_ds=0)
+    if ((frame[0] & WIFI_FC0_TYPE_MASK) != WIFI_FC0_DATA ||
+        (frame[1] & (WIFI_FC1_TO_DS | WIFI_FC1_FROM_DS)) != WIFI_FC1_TO_DS) {
+        return FRAME_ERR_NOT_TO_DS;
+    }
+
+    // QoS data frames add a QoS control field, and an HT control field with +HTC
+    size_t mac_header_len = WIFI_DATA_HEADER_LEN;
+    view->qos = (frame[0] & WIFI_FC0_SUBTYPE_QOS) != 0;
+    view->tid = 0;
+    if (view->qos) {
+        mac_header_len = WIFI_QOS_DATA_HEADER_LEN;
+        if (frame[1] & WIFI_FC1_ORDER) {
+            mac_header_len += WIFI_HTC_LEN;
+        }
+        if (len < mac_header_len + sizeof(data_packet_header_t)) {
+            return FRAME_ERR_TOO_SHORT;
+        }
+        view->tid = frame[WIFI_DATA_HEADER_LEN] & WIFI_QOS_TID_MASK;
+    }
+    view->access_category = wmm_ac_from_tid(view->tid);
+
+    // Host tools decoding exported frames pass NULL and accept any destination
+    const uint8_t *destination_mac = &frame[4];
+    if (our_mac != NULL && memcmp(destination_mac, our_mac, WIFI_MAC_LEN) != 0 &&
+        memcmp(destination_mac, broadcast_mac, WIFI_MAC_LEN) != 0) {
+        return FRAME_ERR_NOT_FOR_US;
+    }
+
+    const data_packet_header_t *header = (const data_packet_header_t *)(frame + mac_header_len);
+    view->header = header;
+
+    if (header->total_size > MAX_PACKET_SIZE + SAMPLE_TIME_MAX_LEN) {
+        return FRAME_ERR_BAD_SIZE;
+    }
+
+    size_t available = len - mac_header_len - sizeof(data_packet_header_t);
+    size_t covered = sizeof(data_packet_header_t) + header->total_size;
+    view->frame_len = (uint16_t)(mac_header_len + covered);
+
+    // Reject corrupted frames before decoding anything in them
+    if (header->flags & FRAME_FLAG_CRC) {
+        const uint8_t *trailer = (const uint8_t *)header + covered;
+        if (available < (size_t)header->total_size + FRAME_CRC_LEN) {
+            return FRAME_ERR_BAD_CRC;
+        }
+        uint32_t sum = (uint32_t)trailer[0] | (uint32_t)trailer[1] << 8 |
+                       (uint32_t)trailer[2] << 16 | (uint32_t)trailer[3] << 24;
+        if (crc32c(0, header, covered) != sum) {
+            return FRAME_ERR_BAD_CRC;
+        }
+        view->frame_len += FRAME_CRC_LEN;
+    } else if (view->frame_len > len) {
+        view->frame_len = (uint16_t)len;
+    }
+
+    view->src_mac = &frame[WIFI_ADDR2_OFFSET];
+    view->held_block = NULL;
+    view->held_block_len = 0;
+    view->time_block = NULL;
+    view->time_block_len = 0;
+    view->payload = frame + mac_header_len + sizeof(data_packet_header_t);
+    view->payload_len = available < header->total_size ? (uint16_t)available : header->total_size;
+
+    if (header->class_types[0] == (data_type_t)FRAME_SCHEMA_MARKER) {
+        view->kind = FRAME_KIND_SCHEMA;
+        return FRAME_OK;
+    }
+    if (header->class_types[0] == (data_type_t)FRAME_BENCH_MARKER) {
+        view->kind = FRAME_KIND_BENCH;
+        return FRAME_OK;
+    }
+    view->kind = FRAME_KIND_DATA;
+
+    // Resolve every class's element size once; schemas must be announced first
+    uint16_t element_size[MAX_CLASSES];
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        element_size[i] = class_type_size(header->class_types[i]);
+        if (element_size[i] == 0) {
+            return data_type_is_schema(header->class_types[i]) ?
+                FRAME_ERR_UNKNOWN_SCHEMA : FRAME_ERR_BAD_TYPE;
+        }
+    }
+
+    // A frame can never describe more class data than the largest payload
+    uint32_t expected_size = 0;
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        expected_size += (uint32_t)element_size[i] * header->class_counts[i];
+    }
+    if (expected_size > MAX_PACKET_SIZE) {
+        return FRAME_ERR_BAD_SIZE;
+    }
+    view->expected_size = (uint16_t)expected_size;
+
+    // Every class arrives in full, so decoders index it without checks of their own
+    if (view->payload_len < expected_size) {
+        return FRAME_ERR_BAD_SIZE;
+    }
+
+    // Precompute where each class starts so decoders can index directly
+    uint16_t offset = 0;
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        view->class_offset[i] = offset;
+        view->class_size[i] = element_size[i] * header->class_counts[i];
+        offset += view->class_size[i];
+    }
+
+    // The held block follows the class data; its first two bytes give its length
+    uint16_t blocks = view->expected_size;
+    if ((header->flags & FRAME_FLAG_HELD) && view->payload_len > blocks + 1) {
+        uint16_t held_len = (uint16_t)SAMPLE_HELD_LEN(view->payload[blocks], view->payload[blocks + 1]);
+        if (blocks + held_len > view->payload_len) {
+            return FRAME_OK;    // Truncated; neither block is usable
+        }
+        view->held_block = view->payload + blocks;
+        view->held_block_len = held_len;
+        blocks += held_len;
+    }
+
+    // The sample time block comes last
+    if ((header->flags & FRAME_FLAG_SAMPLE_TIMES) && header->total_size > blocks &&
+        view->payload_len > blocks) {
+        view->time_block = view->payload + blocks;
+        view->time_block_len = view->payload_len - blocks;
+    }
+
+    return FRAME_OK;
+}
+
+wmm_ac_t frame_access_category(const uint8_t class_counts[MAX_CLASSES],
+                               const wmm_ac_t class_access[MAX_CLASSES])
+{
+    wmm_ac_t ac = WMM_AC_BK;
+    bool any = false;
+
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        if (class_counts[i] > 0 && class_access[i] < WMM_AC_NUM) {
+            if (!any || class_access[i] > ac) {
+                ac = class_access[i];
+            }
+            any = true;
+        }
+    }
+
+    return any ? ac : WMM_AC_BE;
+}
+
+uint8_t wmm_ac_tid(wmm_ac_t ac)
+{
+    return ac < WMM_AC_NUM ? wmm_ac_tids[ac] : wmm_ac_tids[WMM_AC_BE];
+}
+
+wmm_ac_t wmm_ac_from_tid(uint8_t tid)
+{
+    switch (tid & 0x07) {
+        case 1:
+        case 2:  return WMM_AC_BK;
+        case 4:
+        case 5:  return WMM_AC_VI;
+        case 6:
+        case 7:  return WMM_AC_VO;
+        default: return WMM_AC_BE;
+    }
+}
+
+const char *wmm_ac_name(wmm_ac_t ac)
+{
+    return ac < WMM_AC_NUM ? wmm_ac_names[ac] : "??";
+}
+
+bool wmm_ac_from_option(const char *option, wmm_ac_t *ac)
+{
+    for (int i = 0; i < WMM_AC_NUM; i++) {
+        if (strcasecmp(option, wmm_ac_names[i]) == 0) {
+            *ac = (wmm_ac_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *frame_status_name(frame_status_t status)
+{
+    switch (status) {
+        case FRAME_OK:             return "OK";
+        case FRAME_ERR_TOO_SHORT:  return "too short";
+        case FRAME_ERR_NOT_TO_DS:  return "not to-DS data";
+        case FRAME_ERR_NOT_FOR_US: return "not for us";
+        case FRAME_ERR_BAD_SIZE:   return "bad size";
+        case FRAME_ERR_BAD_TYPE:   return "bad class type";
+        case FRAME_ERR_UNKNOWN_SCHEMA: return "unknown schema";
+        case FRAME_ERR_BAD_CRC:    return "bad CRC";
+        default:                   return "unknown";
+    }
+}
@@ -0,0 +1,100 @@
+/**
+ * @file frame_export.c
+ * @brief Export line formatter and parser
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "frame_export.h"
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/* Value of a hex digit, or -1 */
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;  // Lowercase
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+size_t frame_export_format(char *out, size_t out_cap, uint32_t rx_ms, int8_t rssi,
+                           const uint8_t *frame, size_t len)
+{
+    int n = snprintf(out, out_cap, FRAME_EXPORT_PREFIX "%lu %d ", (unsigned long)rx_ms, rssi);
+    if (n < 0 || (size_t)n + 2 * len + 1 > out_cap) {
+        return 0;
+    }
+
+    char *p = out + n;
+    for (size_t i = 0; i < len; i++) {
+        *p++ = hex_digits[frame[i] >> 4];
+        *p++ = hex_digits[frame[i] & 0x0F];
+    }
+    *p = '\0';
+
+    return (size_t)(p - out);
+}
+
+/* Parse an unsigned or negative decimal field ending in a space */
+static bool parse_field(const char **p, const char *end, int64_t *value)
+{
+    const char *s = *p;
+    bool negative = false;
+    int64_t v = 0;
+
+    if (s < end && *s == '-') {
+        negative = true;
+        s++;
+    }
+    const char *digits = s;
+    while (s < end && *s >= '0' && *s <= '9' && s - digits < 10) {
+        v = v * 10 + (*s - '0');
+        s++;
+    }
+    if (s == digits || s >= end || *s != ' ') {
+        return false;
+    }
+
+    *value = negative ? -v : v;
+    *p = s + 1;
+    return true;
+}
+
+bool frame_export_parse(const char *line, size_t line_len, uint32_t *rx_ms, int8_t *rssi,
+                        uint8_t *frame, size_t frame_cap, size_t *len)
+{
+    const char *end = line + line_len;
+    const char *p = line + FRAME_EXPORT_PREFIX_LEN;
+    int64_t time_value, rssi_value;
+
+    if (line_len < FRAME_EXPORT_PREFIX_LEN ||
+        memcmp(line, FRAME_EXPORT_PREFIX, FRAME_EXPORT_PREFIX_LEN) != 0 ||
+        !parse_field(&p, end, &time_value) || time_value < 0 || time_value > UINT32_MAX ||
+        !parse_field(&p, end, &rssi_value) || rssi_value < INT8_MIN || rssi_value > INT8_MAX) {
+        return false;
+    }
+
+    size_t digits = (size_t)(end - p);
+    if (digits % 2 != 0 || digits / 2 > frame_cap) {
+        return false;
+    }
+
+    for (size_t i = 0; i < digits / 2; i++) {
+        int hi = hex_value(p[2 * i]);
+        int lo = hex_value(p[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        frame[i] = (uint8_t)(hi << 4 | lo);
+    }
+
+    *rx_ms = (uint32_t)time_value;
+    *rssi = (int8_t)rssi_value;
+    *len = digits / 2;
+    return true;
+}
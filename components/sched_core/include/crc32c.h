@@ -0,0 +1,24 @@
+/**
+ * @file crc32c.h
+ * @brief CRC-32C (Castagnoli) for the frame trailer
+ *
+ * Reflected polynomial 0x82F63B78, initial value and final XOR 0xFFFFFFFF,
+ * as in iSCSI and ext4; "123456789" checks to 0xE3069283. Computed a byte
+ * at a time from a 1 KB table: the ESP32-C3 has no CRC instruction and its
+ * ROM CRC routines use other polynomials.
+ */
+
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Extend @p crc over @p len bytes
+ *
+ * @param crc 0 to start, or the result over the preceding bytes
+ */
+uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+
+#endif /* CRC32C_H */
@@ -0,0 +1,124 @@
+/**
+ * @file energy_budget.h
+ * @brief Energy-budget scheduling: station energy model and budget bucket
+ *
+ * The station's energy is modelled as in host/sim: a baseline of CPU idle
+ * plus power-save receiver wakes (or the receiver always on without power
+ * save), and for every frame a receiver-on lead and tail around its
+ * airtime. Transmit current scales linearly with the TX power setting
+ * between tx_min_a and tx_a. The defaults are the simulator's, at the
+ * 5 V supply the power meter measures; host/sim/sim_validate calibrates
+ * them.
+ *
+ * The budget accrues at mj_per_hour into a bucket of ENERGY_BUDGET_BUCKET_S
+ * seconds of budget, which starts full; spend is drawn from it as it is
+ * modelled. The balance sets a degradation level:
+ *
+ *   NORMAL      balance at least half the bucket
+ *   BATCH       at least a quarter: hold frames until deadlines force them
+ *               out, so each carries more data
+ *   LOW_POWER   not overdrawn: also cap TX power
+ *   SHED        overdrawn: also stop queueing best-effort packets
+ *
+ * Moving back up a level needs ENERGY_BUDGET_HYSTERESIS_PCT more of the
+ * bucket than the level's floor. The caller maps levels to actions.
+ */
+
+#ifndef ENERGY_BUDGET_H
+#define ENERGY_BUDGET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ENERGY_BUDGET_BUCKET_S          600     // Seconds of budget the bucket holds
+#define ENERGY_BUDGET_HYSTERESIS_PCT    5
+
+/* TX power range in esp_wifi_set_max_tx_power() units (0.25 dBm) */
+#define ENERGY_TX_POWER_MIN             8
+#define ENERGY_TX_POWER_MAX             80
+
+/* Power model, currents in A and times in ms */
+typedef struct {
+    double voltage_v;
+    double idle_a;              // CPU running, modem asleep
+    double listen_a;            // Receiver on
+    double tx_a;                // Transmitting at ENERGY_TX_POWER_MAX
+    double tx_min_a;            // Transmitting at ENERGY_TX_POWER_MIN
+    double beacon_ms;
+    double max_modem_beacons;   // Beacons per wake in max modem sleep
+    double listen_ms;           // Receiver on per power-save wake
+    double tx_lead_ms;          // Receiver on before a frame
+    double tx_fixed_ms;         // Airtime besides the frame bytes
+    double rate_mbps;           // PHY rate of the frame bytes
+    double tx_tail_ms;          // Receiver on after a frame
+} energy_model_t;
+
+typedef enum {
+    ENERGY_PS_NONE,
+    ENERGY_PS_MIN,
+    ENERGY_PS_MAX,
+} energy_ps_t;
+
+typedef enum {
+    ENERGY_LEVEL_NORMAL = 0,
+    ENERGY_LEVEL_BATCH,
+    ENERGY_LEVEL_LOW_POWER,
+    ENERGY_LEVEL_SHED,
+} energy_level_t;
+
+/* Budget state; mj_per_hour 0 means budget mode is off */
+typedef struct {
+    energy_model_t model;
+    energy_ps_t ps;
+    uint32_t mj_per_hour;
+    double baseline_mw;         // Spend with nothing to send
+    double capacity_mj;
+    double balance_mj;          // Bucket content; negative when overdrawn
+    double spent_mj;            // Total modelled spend
+    double frames_mj;           // Of which frames
+    uint32_t frames;
+    uint32_t elapsed_ms;
+    uint32_t last_ms;
+    energy_level_t level;
+    uint32_t level_changes;
+} energy_budget_t;
+
+void energy_model_defaults(energy_model_t *model);
+
+/**
+ * @brief Energy one frame of @p len bytes at @p tx_power adds to the baseline
+ */
+double energy_frame_mj(const energy_model_t *model, energy_ps_t ps, size_t len, int8_t tx_power);
+
+/**
+ * @brief Start a budget at @p now_ms with a full bucket
+ */
+void energy_budget_init(energy_budget_t *budget, const energy_model_t *model, uint32_t mj_per_hour,
+                        energy_ps_t ps, uint32_t now_ms);
+
+/**
+ * @brief Charge a frame the driver accepted
+ */
+void energy_budget_frame(energy_budget_t *budget, size_t len, int8_t tx_power);
+
+/**
+ * @brief Accrue budget and baseline spend up to @p now_ms and update the level
+ *
+ * @return The new level
+ */
+energy_level_t energy_budget_update(energy_budget_t *budget, uint32_t now_ms);
+
+/**
+ * @brief Whether the baseline alone fits in the budget
+ */
+bool energy_budget_feasible(const energy_budget_t *budget);
+
+/**
+ * @brief Average modelled spend so far, in mJ per hour
+ */
+double energy_budget_rate(const energy_budget_t *budget);
+
+const char *energy_level_name(energy_level_t level);
+
+#endif /* ENERGY_BUDGET_H */
@@ -0,0 +1,294 @@
+/**
+ * @file frame_codec.h
+ * @brief Raw 802.11 data frame layout shared by the station sender and AP receiver
+ *
+ * Frame layout:
+ *   [802.11 data header, 24 bytes][data_packet_header_t][class data...]
+ * or, when a WMM access category is requested, a 26-byte QoS data header
+ * whose QoS control field carries the TID of that category.
+ * Class data is concatenated in class order; each class contributes
+ * class_counts[i] elements of class_types[i]. A class type may name a
+ * record schema (record_schema.h), in which case elements are records.
+ *
+ * If FRAME_FLAG_HELD is set, a held block (sample_held.h) follows the class
+ * data. If FRAME_FLAG_SAMPLE_TIMES is set, a sample time block
+ * (sample_time.h) comes last. total_size covers the class data and blocks.
+ * The station keeps class data and held block within MAX_TX_SIZE.
+ *
+ * Data and schema frames end in a CRC-32C (crc32c.h) of data_packet_header_t
+ * and the total_size bytes after it, little-endian, and set FRAME_FLAG_CRC.
+ * The 802.11 header is left out since retries rewrite it. frame_parse()
+ * checks the trailer before decoding anything else, so a corrupted frame
+ * costs one pass over its bytes.
+ *
+ * Over ESP-NOW the station sends the frame from data_packet_header_t on
+ * (the frame body); the ESP-NOW action frame takes the place of the
+ * 802.11 data header. The AP puts a plain data header back in front with
+ * frame_build_from_body(), so frames from either path parse, decode and
+ * export the same way.
+ *
+ * Schema announcement frames use the same layout with all class counts
+ * zero, class_types[0] == FRAME_SCHEMA_MARKER and the payload produced by
+ * record_schema_pack().
+ *
+ * Throughput benchmark frames ("bench tx") likewise have all class counts
+ * zero and class_types[0] == FRAME_BENCH_MARKER; the payload is a
+ * frame_bench_t followed by filler up to the requested length. A latency
+ * probe comes back as an echo: the same frame sent FromDS to the station.
+ */
+
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sched_types.h"
+#include "record_schema.h"
+#include "sample_time.h"
+#include "sample_held.h"
+
+/* 802.11 header constants */
+#define WIFI_DATA_HEADER_LEN     24      // Basic 802.11 data header size
+#define WIFI_QOS_DATA_HEADER_LEN 26      // Data header plus QoS control
+#define WIFI_HTC_LEN             4       // HT control field of +HTC QoS frames
+#define WIFI_FC0_TYPE_MASK       0x0C    // Type bits of frame control byte 0
+#define WIFI_FC0_DATA            0x08    // Data frame type
+#define WIFI_FC0_SUBTYPE_QOS     0x80    // QoS bit of the data subtype
+#define WIFI_FC1_TO_DS           0x01    // ToDS flag (station to AP)
+#define WIFI_FC1_FROM_DS         0x02    // FromDS flag
+#define WIFI_FC1_RETRY           0x08    // Retransmission of an earlier frame
+#define WIFI_FC1_ORDER           0x80    // Order flag; +HTC in QoS frames
+#define WIFI_QOS_TID_MASK        0x0F    // TID bits of QoS control byte 0
+#define WIFI_MAC_LEN             6
+#define WIFI_ADDR2_OFFSET        10      // Transmitter address in the 802.11 header
+
+/* WMM access categories, ordered from lowest to highest priority */
+typedef enum {
+    WMM_AC_BK = 0,      // Background
+    WMM_AC_BE,          // Best effort
+    WMM_AC_VI,          // Video
+    WMM_AC_VO,          // Voice
+    WMM_AC_NUM
+} wmm_ac_t;
+
+/* Data packet header (includes all information needed to decode the payload) */
+typedef struct {
+    uint8_t class_counts[MAX_CLASSES];      // Number of items for each class
+    data_type_t class_types[MAX_CLASSES];   // Data type for each class
+    uint16_t total_size;                    // Total size of all data in bytes
+    uint32_t timestamp;                     // Transmission timestamp
+    uint8_t flags;                          // FRAME_FLAG_* bits
+} __attribute__((packed)) data_packet_header_t;
+
+/* data_packet_header_t flags */
+#define FRAME_FLAG_SAMPLE_TIMES  0x01    // Sample time block follows the class data
+#define FRAME_FLAG_HELD          0x02    // Held block follows the class data, before any time block
+#define FRAME_FLAG_CRC           0x04    // CRC-32C trailer follows the total_size bytes
+
+#define FRAME_CRC_LEN            4
+
+/* class_types[0] value marking a schema announcement frame */
+#define FRAME_SCHEMA_MARKER      0xFF
+
+/* class_types[0] value marking a throughput benchmark frame */
+#define FRAME_BENCH_MARKER       0xFE
+
+/* Start of a benchmark frame's payload */
+typedef struct {
+    uint16_t run;                           // Identifies one benchmark run
+    uint8_t flags;                          // FRAME_BENCH_* bits
+    uint8_t reserved;
+    uint32_t seq;                           // Frame number in the run; in end frames, frames sent
+} __attribute__((packed)) frame_bench_t;
+
+/* frame_bench_t flags */
+#define FRAME_BENCH_END          0x01    // Run is over; sent a few times after the last frame
+#define FRAME_BENCH_PROBE        0x02    // Latency probe; the AP echoes it at once
+#define FRAME_BENCH_ECHO         0x04    // AP-to-station copy of a probe
+
+/* Largest frame the station can emit */
+#define FRAME_MAX_LEN  (WIFI_QOS_DATA_HEADER_LEN + sizeof(data_packet_header_t) + MAX_TX_SIZE + \
+                        SAMPLE_TIME_MAX_LEN + FRAME_CRC_LEN)
+
+/* Addresses placed in the 802.11 header */
+typedef struct {
+    uint8_t da[WIFI_MAC_LEN];       // Destination (AP) address
+    uint8_t sa[WIFI_MAC_LEN];       // Source (our) address
+    uint8_t bssid[WIFI_MAC_LEN];    // BSSID
+} frame_addr_t;
+
+/* Frame validation result */
+typedef enum {
+    FRAME_OK = 0,
+    FRAME_ERR_TOO_SHORT,         // Shorter than 802.11 header + data packet header
+    FRAME_ERR_NOT_TO_DS,         // Not a station-to-AP data frame
+    FRAME_ERR_NOT_FOR_US,        // Destination is neither us nor broadcast
+    FRAME_ERR_BAD_SIZE,          // Class data larger than MAX_PACKET_SIZE or the payload, or total_size too large
+    FRAME_ERR_BAD_TYPE,          // Unknown data type code for a class
+    FRAME_ERR_UNKNOWN_SCHEMA,    // Class refers to a schema not yet announced
+    FRAME_ERR_BAD_CRC,           // CRC trailer missing or wrong: corrupted or truncated
+} frame_status_t;
+
+/* Kind of a validated frame */
+typedef enum {
+    FRAME_KIND_DATA = 0,         // Class data
+    FRAME_KIND_SCHEMA,           // Schema announcement; payload is for record_schema_unpack()
+    FRAME_KIND_BENCH,            // Benchmark frame; see frame_bench_read()
+} frame_kind_t;
+
+/* Decoded view into a received frame; pointers alias the frame buffer */
+typedef struct {
+    frame_kind_t kind;
+    const data_packet_header_t *header;
+    const uint8_t *src_mac;                 // Transmitter address
+    uint16_t frame_len;                     // MAC header through the CRC trailer, at most len
+    bool qos;                               // QoS data frame
+    uint8_t tid;                            // QoS TID, 0 for plain data frames
+    wmm_ac_t access_category;               // Category of the TID (BE for plain frames)
+    const uint8_t *payload;                 // Class data, in class order
+    uint16_t payload_len;                   // Payload bytes present (at most total_size)
+    uint16_t expected_size;                 // Size implied by class counts and types
+    uint16_t class_offset[MAX_CLASSES];     // Offset of each class within payload
+    uint16_t class_size[MAX_CLASSES];       // Bytes of each class
+    const uint8_t *held_block;              // Held block, NULL if absent
+    uint16_t held_block_len;                // Held block bytes
+    const uint8_t *time_block;              // Sample time block, NULL if absent
+    uint16_t time_block_len;                // Time block bytes present
+} frame_view_t;
+
+/**
+ * @brief Bytes of class data implied by per-class counts and types
+ */
+uint16_t frame_payload_size(const uint8_t class_counts[MAX_CLASSES],
+                            const data_type_t class_types[MAX_CLASSES]);
+
+/**
+ * @brief Write a complete station-to-AP data frame
+ *
+ * Appends the CRC trailer and sets FRAME_FLAG_CRC in the written header.
+ *
+ * @param out Destination buffer (FRAME_MAX_LEN is always enough)
+ * @param out_cap Size of @p out
+ * @return Frame length, or 0 if it does not fit
+ */
+size_t frame_build(uint8_t *out, size_t out_cap, const frame_addr_t *addr,
+                   const data_packet_header_t *header, const uint8_t *payload);
+
+/**
+ * @brief Write a station-to-AP QoS data frame in a WMM access category
+ *
+ * Same as frame_build() with a 26-byte QoS data header whose TID is the
+ * user priority of @p ac.
+ */
+size_t frame_build_qos(uint8_t *out, size_t out_cap, const frame_addr_t *addr, wmm_ac_t ac,
+                       const data_packet_header_t *header, const uint8_t *payload);
+
+/**
+ * @brief Rebuild the plain data frame around a frame body received over ESP-NOW
+ *
+ * @param addr Addresses of the ESP-NOW frame: station as source, AP as
+ *             destination and BSSID
+ * @return Frame length, or 0 if it does not fit
+ */
+size_t frame_build_from_body(uint8_t *out, size_t out_cap, const frame_addr_t *addr,
+                             const uint8_t *body, size_t body_len);
+
+/**
+ * @brief Write a schema announcement frame for the given schema IDs
+ *
+ * @return Frame length, or 0 if nothing is registered or it does not fit
+ */
+size_t frame_build_schema(uint8_t *out, size_t out_cap, const frame_addr_t *addr,
+                          const uint8_t *schema_ids, size_t id_count, uint32_t timestamp);
+
+/**
+ * @brief Write a benchmark frame whose payload is @p payload_len bytes
+ *
+ * @param payload_len At least sizeof(frame_bench_t), at most MAX_TX_SIZE
+ * @return Frame length, or 0 if it does not fit
+ */
+size_t frame_build_bench(uint8_t *out, size_t out_cap, const frame_addr_t *addr,
+                         const frame_bench_t *bench, uint16_t payload_len, uint32_t timestamp);
+
+/**
+ * @brief Turn a received probe into the AP-to-station echo
+ *
+ * The echo keeps the probe's length and payload, with FRAME_BENCH_ECHO
+ * set in place of FRAME_BENCH_PROBE.
+ *
+ * @param probe MAC frame as received (frame_parse() returned FRAME_KIND_BENCH)
+ * @param probe_len Bytes of MAC frame, without the FCS
+ * @return Echo length, or 0 if @p probe is not a probe or does not fit
+ */
+size_t frame_build_bench_echo(uint8_t *out, size_t out_cap, const uint8_t *probe, size_t probe_len);
+
+/**
+ * @brief Recognize an echo addressed to @p our_mac and copy its frame_bench_t
+ *
+ * frame_parse() only accepts station-to-AP frames; this is the station's
+ * receive side of the latency benchmark.
+ */
+bool frame_parse_bench_echo(const uint8_t *frame, size_t len, const uint8_t our_mac[WIFI_MAC_LEN],
+                            frame_bench_t *bench);
+
+/**
+ * @brief Copy the frame_bench_t out of a FRAME_KIND_BENCH view
+ *
+ * @return false if the payload is too short to hold one
+ */
+bool frame_bench_read(const frame_view_t *view, frame_bench_t *bench);
+
+/**
+ * @brief Validate a received frame once and fill a view with per-class offsets
+ *
+ * Plain and QoS data frames are accepted (including +HTC QoS frames);
+ * view->qos, view->tid and view->access_category describe the MAC header.
+ * The class data must be present in full, so decoders can index it through
+ * class_offset and class_size without further checks. A truncated held or
+ * sample time block is not an error: the view leaves it out. On
+ * FRAME_ERR_BAD_SIZE, FRAME_ERR_BAD_TYPE and FRAME_ERR_UNKNOWN_SCHEMA only
+ * view->header is set. For schema announcements only kind, header, src_mac,
+ * payload and payload_len are set.
+ *
+ * @param our_mac AP address; broadcast frames are also accepted. NULL
+ *                accepts any destination.
+ */
+frame_status_t frame_parse(const uint8_t *frame, size_t len,
+                           const uint8_t our_mac[WIFI_MAC_LEN], frame_view_t *view);
+
+/**
+ * @brief Highest-priority category among the classes present in a frame
+ *
+ * A frame carries several classes, so it contends in the category of its
+ * most urgent class. Returns WMM_AC_BE when every count is zero.
+ */
+wmm_ac_t frame_access_category(const uint8_t class_counts[MAX_CLASSES],
+                               const wmm_ac_t class_access[MAX_CLASSES]);
+
+/**
+ * @brief 802.1D user priority (TID) used for an access category
+ */
+uint8_t wmm_ac_tid(wmm_ac_t ac);
+
+/**
+ * @brief Access category a TID maps to
+ */
+wmm_ac_t wmm_ac_from_tid(uint8_t tid);
+
+/**
+ * @brief Label of an access category ("VO", "VI", "BE", "BK")
+ */
+const char *wmm_ac_name(wmm_ac_t ac);
+
+/**
+ * @brief Parse a terminal option ("vo", "vi", "be", "bk"), case-insensitive
+ */
+bool wmm_ac_from_option(const char *option, wmm_ac_t *ac);
+
+/**
+ * @brief Short description of a frame_status_t for logs
+ */
+const char *frame_status_name(frame_status_t status);
+
+#endif /* FRAME_CODEC_H */
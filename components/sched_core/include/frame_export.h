@@ -0,0 +1,48 @@
+/**
+ * @file frame_export.h
+ * @brief Text export of received frames for host collectors
+ *
+ * The AP prints one line per validated frame on its console next to its
+ * normal log output:
+ *
+ *   @FRM <rx_ms> <rssi> <frame bytes as lowercase hex>
+ *
+ * rx_ms is the AP's clock when the frame arrived and rssi its signal
+ * strength in dBm. Collectors keep lines starting with FRAME_EXPORT_PREFIX
+ * and skip everything else, so the export survives interleaved logs on a
+ * serial console, and run the same frame_parse() as the AP on the bytes.
+ */
+
+#ifndef FRAME_EXPORT_H
+#define FRAME_EXPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FRAME_EXPORT_PREFIX      "@FRM "
+#define FRAME_EXPORT_PREFIX_LEN  5
+
+/* Longest line (without newline) for a frame of len bytes */
+#define FRAME_EXPORT_LINE_MAX(len)  (FRAME_EXPORT_PREFIX_LEN + 11 + 1 + 4 + 1 + 2 * (len) + 1)
+
+/**
+ * @brief Format an export line, NUL-terminated and without a newline
+ *
+ * @return Line length, or 0 if it does not fit in @p out_cap
+ */
+size_t frame_export_format(char *out, size_t out_cap, uint32_t rx_ms, int8_t rssi,
+                           const uint8_t *frame, size_t len);
+
+/**
+ * @brief Parse an export line back into the frame bytes
+ *
+ * @param line Line without its terminator; need not be NUL-terminated
+ * @param frame Receives the frame bytes
+ * @param len Receives the frame length
+ * @return false if the line is not an export line or the frame exceeds @p frame_cap
+ */
+bool frame_export_parse(const char *line, size_t line_len, uint32_t *rx_ms, int8_t *rssi,
+                        uint8_t *frame, size_t frame_cap, size_t *len);
+
+#endif /* FRAME_EXPORT_H */
@@ -0,0 +1,59 @@
+/**
+ * @file mac_allowlist.h
+ * @brief Source MAC allowlist with a fixed-cost lookup
+ *
+ * The AP receives every data frame on its channel in promiscuous mode. It
+ * checks the transmitter address of each one against the stations it has
+ * registered before parsing anything else, so frames of other networks
+ * cost one lookup.
+ *
+ * Addresses are kept in an open-addressed table of MAC_ALLOWLIST_SLOTS
+ * slots. An address lives in one of the MAC_ALLOWLIST_PROBES slots starting
+ * at its hash, and a lookup compares all of them without stopping early:
+ * the cost is the same for every frame, whatever the table holds. Adding
+ * fails if the address's window is full, which at MAC_ALLOWLIST_MAX
+ * entries in the table is rare.
+ *
+ * The table is not locked. A caller that changes it while another task
+ * reads it publishes a changed copy instead (see the AP).
+ */
+
+#ifndef MAC_ALLOWLIST_H
+#define MAC_ALLOWLIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAC_ALLOWLIST_SLOT_BITS  6
+#define MAC_ALLOWLIST_SLOTS      (1 << MAC_ALLOWLIST_SLOT_BITS)
+#define MAC_ALLOWLIST_PROBES     8       // Slots a lookup compares
+#define MAC_ALLOWLIST_MAX        16      // Entries, at most a quarter of the slots
+
+typedef struct {
+    uint64_t slots[MAC_ALLOWLIST_SLOTS];    // Address in the low 48 bits plus a used bit; 0 when free
+    uint8_t count;
+} mac_allowlist_t;
+
+void mac_allowlist_init(mac_allowlist_t *list);
+
+/**
+ * @brief Register an address
+ *
+ * @return true if the address is in the list, already or now; false if
+ *         the list or the address's window is full
+ */
+bool mac_allowlist_add(mac_allowlist_t *list, const uint8_t mac[6]);
+
+/**
+ * @brief Remove an address
+ *
+ * @return true if it was in the list
+ */
+bool mac_allowlist_remove(mac_allowlist_t *list, const uint8_t mac[6]);
+
+/**
+ * @brief Whether an address is registered, in the same time for any address
+ */
+bool mac_allowlist_contains(const mac_allowlist_t *list, const uint8_t mac[6]);
+
+#endif /* MAC_ALLOWLIST_H */
@@ -0,0 +1,133 @@
+/**
+ * @file record_schema.h
+ * @brief Mixed-field record schemas for composite sensor classes
+ *
+ * A class normally carries elements of one data_type_t. A class can
+ * instead carry records described by a schema: an ordered list of
+ * primitive fields, packed without padding. The class type code is then
+ * DATA_TYPE_SCHEMA(id) and the class count is the number of records.
+ *
+ * Field offsets and the record size are computed once at registration.
+ * The station registers schemas at configuration time and announces them
+ * to the AP in schema frames (see frame_codec.h); data frames only carry
+ * the schema ID. The AP's registry is shared by all stations, so once an
+ * ID is announced its layout is fixed: an announcement with another layout
+ * is a conflict, and the AP stops decoding records of that ID rather than
+ * read one station's records with another's layout. A new layout needs a
+ * new ID.
+ */
+
+#ifndef RECORD_SCHEMA_H
+#define RECORD_SCHEMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sched_types.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#define SCHEMA_MAX_FIELDS        8     // Fields per record
+
+/* Data frames between repeated schema announcements */
+#ifndef CONFIG_SCHED_SCHEMA_ANNOUNCE_INTERVAL
+#define CONFIG_SCHED_SCHEMA_ANNOUNCE_INTERVAL 20
+#endif
+
+/* A registered record layout */
+typedef struct {
+    bool registered;
+    bool conflict;                              // Announced with two layouts; not decoded
+    uint8_t field_count;
+    data_type_t field_types[SCHEMA_MAX_FIELDS];
+    uint16_t field_offset[SCHEMA_MAX_FIELDS];   // Byte offset of each field in a record
+    uint16_t record_size;                       // Packed record size in bytes
+} record_schema_t;
+
+/**
+ * @brief Register or replace a schema
+ *
+ * @param id Schema ID, below SCHEMA_MAX_COUNT
+ * @param field_types Primitive type of each field, in record order
+ * @param field_count 1..SCHEMA_MAX_FIELDS
+ * @return true if registered; false for a bad ID, field list or a record
+ *         larger than MAX_PACKET_SIZE
+ */
+bool record_schema_register(uint8_t id, const data_type_t *field_types, uint8_t field_count);
+
+/**
+ * @brief Look up a registered schema, NULL if the ID is unknown
+ */
+const record_schema_t *record_schema_get(uint8_t id);
+
+/**
+ * @brief Forget all registered schemas
+ */
+void record_schema_reset(void);
+
+/**
+ * @brief Serialize schemas for a schema announcement frame
+ *
+ * Each entry is [id][field_count][field type codes...], one byte each.
+ *
+ * @param ids Schema IDs to include; unregistered IDs are skipped
+ * @return Bytes written, or 0 if nothing fits
+ */
+size_t record_schema_pack(uint8_t *out, size_t out_cap, const uint8_t *ids, size_t id_count);
+
+/**
+ * @brief Register every schema in a received announcement
+ *
+ * A schema whose ID is registered with another layout, or already in
+ * conflict, is not registered. Its ID is withdrawn until the next
+ * record_schema_reset() and the conflict counted.
+ *
+ * @return Number of schemas registered, or -1 if the announcement is malformed
+ */
+int record_schema_unpack(const uint8_t *in, size_t len);
+
+/**
+ * @brief Conflicting announcements seen by record_schema_unpack() since the last reset
+ */
+uint32_t record_schema_conflicts(void);
+
+/**
+ * @brief Check a class type code: a primitive type or a registered schema
+ */
+bool class_type_is_valid(data_type_t type);
+
+/**
+ * @brief Bytes of one class element: primitive size or schema record size
+ *
+ * @return 0 for an unknown type or unregistered schema
+ */
+uint16_t class_type_size(data_type_t type);
+
+/**
+ * @brief Values produced per element by class_type_widen() (field count for schemas)
+ */
+uint8_t class_type_fields(data_type_t type);
+
+/**
+ * @brief Encode native-order elements of a class type into wire order
+ *
+ * For schemas @p src holds packed records with native-order fields at the
+ * schema offsets; each field is encoded with its sample kernel.
+ *
+ * @return Bytes written, or 0 for an unknown type
+ */
+size_t class_type_encode(data_type_t type, uint8_t *dst, const void *src, size_t count);
+
+/**
+ * @brief Decode wire-order elements of a class type to doubles
+ *
+ * Schema records are decoded record-major: count * class_type_fields(type)
+ * values.
+ *
+ * @return Bytes consumed, or 0 for an unknown type
+ */
+size_t class_type_widen(data_type_t type, double *dst, const uint8_t *src, size_t count);
+
+#endif /* RECORD_SCHEMA_H */
@@ -0,0 +1,89 @@
+/**
+ * @file sample_codec.h
+ * @brief Per-type sample encode/decode kernels generated from SCHED_DATA_TYPES
+ *
+ * Samples travel little-endian on air. On little-endian targets (ESP32-C3,
+ * x86, ARM hosts) each kernel is a single bulk copy; on big-endian hosts
+ * every element is swapped through an unsigned word of the type's width.
+ *
+ * For each type in SCHED_DATA_TYPES the following are generated, e.g. for
+ * INT16:
+ *   sample_encode_INT16(uint8_t *dst, const int16_t *src, size_t count)
+ *   sample_decode_INT16(int16_t *dst, const uint8_t *src, size_t count)
+ *   sample_widen_INT16(double *dst, const uint8_t *src, size_t count)
+ *   sample_narrow_INT16(int16_t *dst, const double *src, size_t count)
+ *
+ * Code that only knows the type at run time looks its kernels up once in
+ * sample_kernels[] and calls them with the whole run of samples; the
+ * sample_encode() family does the same for a single call.
+ */
+
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sched_types.h"
+
+/* Define SAMPLE_FORCE_SWAP to exercise the big-endian path on a little-endian host */
+#if defined(SAMPLE_FORCE_SWAP) || \
+    (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__))
+#define SAMPLE_HOST_LITTLE_ENDIAN 0
+#else
+#define SAMPLE_HOST_LITTLE_ENDIAN 1
+#endif
+
+#define SAMPLE_CODEC_DECLARE(name, ctype, bits, label, option)                        \
+    void sample_encode_##name(uint8_t *dst, const ctype *src, size_t count);          \
+    void sample_decode_##name(ctype *dst, const uint8_t *src, size_t count);          \
+    void sample_widen_##name(double *dst, const uint8_t *src, size_t count);         \
+    void sample_narrow_##name(ctype *dst, const double *src, size_t count);
+SCHED_DATA_TYPES(SAMPLE_CODEC_DECLARE)
+#undef SAMPLE_CODEC_DECLARE
+
+/* The kernels of one type, with the element pointers left generic */
+typedef struct {
+    void (*encode)(uint8_t *dst, const void *src, size_t count);
+    void (*decode)(void *dst, const uint8_t *src, size_t count);
+    void (*widen)(double *dst, const uint8_t *src, size_t count);
+    void (*narrow)(void *dst, const double *src, size_t count);
+} sample_kernels_t;
+
+/* Indexed by data_type_t; check the type with data_type_is_valid() first */
+extern const sample_kernels_t sample_kernels[NUM_DATA_TYPE];
+
+/**
+ * @brief Encode native samples of a runtime type into wire order
+ *
+ * @param dst Output buffer, at least count * data_type_size(type) bytes
+ * @param src Array of count elements of the C type for @p type
+ * @return Bytes written, or 0 for an unknown type
+ */
+size_t sample_encode(data_type_t type, uint8_t *dst, const void *src, size_t count);
+
+/**
+ * @brief Decode wire-order samples of a runtime type into native elements
+ *
+ * @return Bytes consumed, or 0 for an unknown type
+ */
+size_t sample_decode(data_type_t type, void *dst, const uint8_t *src, size_t count);
+
+/**
+ * @brief Decode wire-order samples of any type straight to double
+ *
+ * Used by the AP and host tools that treat all classes as numeric series.
+ *
+ * @return Bytes consumed, or 0 for an unknown type
+ */
+size_t sample_widen(data_type_t type, double *dst, const uint8_t *src, size_t count);
+
+/**
+ * @brief Convert doubles to native-order elements of a runtime type
+ *
+ * Used to synthesize test data; no wire encoding is applied.
+ *
+ * @return Bytes written, or 0 for an unknown type
+ */
+size_t sample_narrow(data_type_t type, void *dst, const double *src, size_t count);
+
+#endif /* SAMPLE_CODEC_H */
@@ -0,0 +1,130 @@
+/**
+ * @file sample_held.h
+ * @brief Send-on-delta held groups and their hold-last-value reconstruction
+ *
+ * A class in send-on-delta mode does not queue a sample group whose values
+ * all lie within its dead-band of the last group it queued. The station
+ * counts such held groups and reports them with the next group it does
+ * queue, which then carries them in a held block. Every group the class
+ * queues gets the next 8-bit sequence number, so entries can name the
+ * group they repeat:
+ *
+ *   [entries: 8 bits][marks: 8 bits] then per entry:
+ *     class    8 bits
+ *     offset   8 bits   element index in the class data of the frame where
+ *                       the held groups belong (the carrying group starts here)
+ *     held     8 bits   number of groups held back
+ *     items    8 bits   elements per held group
+ *     ref      8 bits   sequence number of the group they repeat
+ *   then per mark:
+ *     class    8 bits
+ *     last     8 bits   sequence number of the class's last group in the frame
+ *
+ * Entries are in class order and, within a class, by offset. Every frame
+ * with data of a send-on-delta class marks it, entries or not. The receiver
+ * restores each held group as a copy of the group just before it: the
+ * items elements ending at offset, or for offset 0 the last elements of the
+ * class's previous frame. The latter only if that frame's mark equals ref;
+ * when the reference frame was lost or never sent, the held groups are
+ * dropped rather than filled in with other values. Held groups come
+ * without capture times.
+ */
+
+#ifndef SAMPLE_HELD_H
+#define SAMPLE_HELD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sched_types.h"
+
+#define SAMPLE_HELD_MAX_ENTRIES  8
+#define SAMPLE_HELD_ENTRY_LEN    5
+#define SAMPLE_HELD_MARK_LEN     2
+#define SAMPLE_HELD_LEN(entries, marks) \
+    ((size_t)2 + SAMPLE_HELD_ENTRY_LEN * (size_t)(entries) + SAMPLE_HELD_MARK_LEN * (size_t)(marks))
+#define SAMPLE_HELD_MAX_LEN      SAMPLE_HELD_LEN(SAMPLE_HELD_MAX_ENTRIES, MAX_CLASSES)
+
+/* Longest reconstruction of one class: runs around every entry plus the tail */
+#define SAMPLE_HOLD_MAX_RUNS     (2 * SAMPLE_HELD_MAX_ENTRIES + 1)
+
+typedef struct {
+    uint8_t class_id;
+    uint8_t offset;
+    uint8_t held;
+    uint8_t items;
+    uint8_t ref;
+} sample_held_entry_t;
+
+typedef struct {
+    uint8_t class_id;
+    uint8_t last;
+} sample_held_mark_t;
+
+/* Held groups reported in one frame, and the sequence marks of its classes */
+typedef struct {
+    uint8_t count;
+    sample_held_entry_t entries[SAMPLE_HELD_MAX_ENTRIES];
+    uint8_t mark_count;
+    sample_held_mark_t marks[MAX_CLASSES];
+} sample_held_t;
+
+/* Receiver state: the most recent class data, the reference for offset 0 */
+typedef struct {
+    uint8_t last[MAX_CLASSES][MAX_PACKET_SIZE];
+    uint8_t last_items[MAX_CLASSES];
+    uint16_t element_size[MAX_CLASSES];
+    uint8_t last_seq[MAX_CLASSES];      // Sequence number of the last group in last
+    bool seq_known[MAX_CLASSES];        // The frame behind last was marked
+} sample_hold_t;
+
+/* A stretch of reconstructed class data: items elements at data, repeat times over */
+typedef struct {
+    const uint8_t *data;
+    uint8_t items;
+    uint8_t repeat;
+    bool held;                  // Restored copies rather than received elements
+} sample_run_t;
+
+/**
+ * @brief Encode a held block
+ *
+ * @return Bytes written, or 0 if it does not fit in @p out_cap
+ */
+size_t sample_held_encode(uint8_t *out, size_t out_cap, const sample_held_t *held);
+
+/**
+ * @brief Decode a held block
+ *
+ * @return Bytes consumed, or 0 if the block is truncated or malformed
+ */
+size_t sample_held_decode(const uint8_t *in, size_t len, sample_held_t *held);
+
+void sample_hold_init(sample_hold_t *hold);
+
+/**
+ * @brief Split a class's data into runs with its held groups restored
+ *
+ * Entries whose reference group was not received (another sequence number,
+ * no marked earlier data of the same element size) or that are
+ * inconsistent with the data are dropped.
+ *
+ * @param data The class data of the frame, @p count elements of @p element_size bytes
+ * @param[out] dropped Held groups of dropped entries
+ * @return Number of runs written
+ */
+int sample_hold_expand(const sample_hold_t *hold, const sample_held_t *held, int class_id,
+                       const uint8_t *data, uint8_t count, uint16_t element_size,
+                       sample_run_t runs[SAMPLE_HOLD_MAX_RUNS], uint32_t *dropped);
+
+/**
+ * @brief Remember a class's data as the reference for the next frame
+ *
+ * Call after the runs of the frame are consumed; they may point into @p hold.
+ *
+ * @param held The frame's held block, NULL if it had none
+ */
+void sample_hold_keep(sample_hold_t *hold, const sample_held_t *held, int class_id,
+                      const uint8_t *data, uint8_t count, uint16_t element_size);
+
+#endif /* SAMPLE_HELD_H */
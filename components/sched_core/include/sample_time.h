@@ -0,0 +1,77 @@
+/**
+ * @file sample_time.h
+ * @brief Optional per-sample capture times, delta-of-delta encoded
+ *
+ * Each queued packet is a group of samples captured together, so a sample
+ * time is the capture time of its group. For every class that carries
+ * times, the block records how many samples each group holds and when each
+ * group was captured:
+ *
+ *   [class mask: 8 bits] then, per class in the mask, in class order:
+ *     groups           6 bits
+ *     items            1 bit uniform flag, then 8 bits once or per group
+ *     first offset     frame timestamp - first group time
+ *     period           class period (only with 2+ groups)
+ *     dod[1..n-1]      (t[k] - t[k-1]) - period
+ *
+ * Signed values use a zigzag bucket code: '0' for zero, '10' + 7 bits,
+ * '110' + 9 bits, '1110' + 12 bits or '1111' + 32 bits. A perfectly periodic
+ * class therefore costs one bit per group after the first.
+ *
+ * The widths above are those of the default sizing. Builds with more
+ * classes take one mask byte per 8 classes, and with MAX_QUEUE_SIZE of 64
+ * or more the group count takes 8 bits (a batch takes at most 255 packets
+ * of a class).
+ */
+
+#ifndef SAMPLE_TIME_H
+#define SAMPLE_TIME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sched_types.h"
+
+/* Largest time block appended to a frame; keeps the frame under 1500 bytes */
+#define SAMPLE_TIME_MAX_LEN      48
+
+#define SAMPLE_TIME_MASK_BITS    (((MAX_CLASSES) + 7) / 8 * 8)
+#if MAX_QUEUE_SIZE < 64
+#define SAMPLE_TIME_GROUP_BITS   6
+#else
+#define SAMPLE_TIME_GROUP_BITS   8
+#endif
+
+/* Capture times of the sample groups in one frame */
+typedef struct {
+    class_mask_t class_mask;                        // Bit i set: class i carries times
+    uint8_t groups[MAX_CLASSES];                    // Sample groups per class
+    uint8_t items[MAX_CLASSES][MAX_QUEUE_SIZE];     // Samples in each group
+    uint32_t times[MAX_CLASSES][MAX_QUEUE_SIZE];    // Capture time of each group (ms)
+} sample_times_t;
+
+/**
+ * @brief Encode the classes in times->class_mask
+ *
+ * @param frame_time Timestamp in the frame header; first offsets are relative to it
+ * @param periods Class periods used as the delta-of-delta reference (ms)
+ * @return Bytes written, or 0 if the block does not fit in @p out_cap
+ */
+size_t sample_time_encode(uint8_t *out, size_t out_cap, uint32_t frame_time,
+                          const uint32_t periods[MAX_CLASSES], const sample_times_t *times);
+
+/**
+ * @brief Reconstruct capture times from a time block
+ *
+ * @return false if the block is truncated or malformed
+ */
+bool sample_time_decode(const uint8_t *in, size_t len, uint32_t frame_time, sample_times_t *times);
+
+/**
+ * @brief Capture time of the index-th sample of a class (in frame order)
+ *
+ * @return false if the class has no times or the index is out of range
+ */
+bool sample_time_at(const sample_times_t *times, int class_id, uint16_t index, uint32_t *time_ms);
+
+#endif /* SAMPLE_TIME_H */
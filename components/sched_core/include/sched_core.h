@@ -0,0 +1,161 @@
+/**
+ * @file sched_core.h
+ * @brief Portable deadline-driven packet scheduler core
+ *
+ * Holds the per-class queues and assembles transmission batches. The core
+ * has no RTOS or WiFi dependencies: callers supply the current time, own
+ * the locking and hand the assembled batch to their transport.
+ *
+ * Classes in send-on-delta mode (dedup_mask) hold back sample groups that
+ * stay within their dead-band of the last group queued, at least until a
+ * keyframe is due; the next queued group reports them (sample_held.h).
+ * Dropping an expired group of such a class forces the next one out, since
+ * the AP can no longer restore held groups that refer to it.
+ *
+ * The batch assembly policy is fixed at build time. On ESP-IDF it comes
+ * from Kconfig (CONFIG_SCHED_POLICY_*); host builds pass the same macros
+ * with -D. Only the selected policy is compiled in.
+ */
+
+#ifndef SCHED_CORE_H
+#define SCHED_CORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sched_types.h"
+#include "sched_queue.h"
+#include "sample_time.h"
+#include "sample_held.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+/* Batch assembly policy */
+#if defined(CONFIG_SCHED_POLICY_EDF)
+#define SCHED_POLICY_EDF          1
+#define SCHED_POLICY_NAME         "EDF"
+#else
+#define SCHED_POLICY_FIXED_ORDER  1
+#define SCHED_POLICY_NAME         "FIXED_ORDER"
+#endif
+
+/* Stop adding packets once fewer than this many bytes remain in the batch */
+#ifndef CONFIG_SCHED_BATCH_FILL_MARGIN
+#define CONFIG_SCHED_BATCH_FILL_MARGIN 100
+#endif
+
+/* Result codes for scheduler core operations */
+typedef enum {
+    SCHED_OK = 0,
+    SCHED_ERR_INVALID_ARG,       // Unknown class or type
+    SCHED_ERR_TOO_LARGE,         // Packet exceeds MAX_PACKET_SIZE
+    SCHED_ERR_QUEUE_FULL,        // Class queue full or out of memory
+} sched_status_t;
+
+/* Send-on-delta state and statistics of one class */
+typedef struct {
+    uint8_t last[MAX_PACKET_SIZE];  // Wire bytes of the last group queued
+    uint16_t last_count;            // Its elements, 0 before the first
+    data_type_t last_type;
+    uint32_t last_queued;           // When it was queued (ms)
+    uint8_t last_seq;               // Its sequence number
+    uint8_t pending;                // Groups held since, reported by the next one queued
+    bool keyframe;                  // Queue the next group whatever its values
+    bool shadow;                    // A held group's deadline is pending
+    uint32_t shadow_deadline;       // Earliest such deadline (ms)
+
+    uint32_t held_groups;           // Groups held back
+    uint32_t held_bytes;            // Their class data bytes
+    uint32_t frames_avoided;        // Held deadlines that came due with nothing else to send
+} sched_dedup_t;
+
+/* Scheduler core state */
+typedef struct {
+    packet_queue_t packet_queues[MAX_CLASSES]; // Separate queue for each class
+
+    // Class information
+    data_type_t class_types[MAX_CLASSES];  // Data type for each class
+    uint32_t class_periods[MAX_CLASSES];   // Period for each class (ms)
+    uint32_t class_deadlines[MAX_CLASSES]; // Deadline for each class (ms)
+    uint32_t processing_threshold;         // Deadline processing threshold (ms)
+    class_mask_t sample_time_mask;         // Classes whose frames carry sample times
+    class_mask_t dedup_mask;               // Classes in send-on-delta mode
+    double dedup_deadband[MAX_CLASSES];    // Largest change still held back, in the class's units
+    uint32_t dedup_keyframe_ms[MAX_CLASSES]; // Queue a group at least this often (0: only on change)
+    sched_dedup_t dedup[MAX_CLASSES];
+
+    // Statistics
+    uint32_t packets_processed;   // Total packets processed
+    uint32_t packets_transmitted; // Packets successfully transmitted
+    uint32_t deadline_misses;     // Packets that missed deadlines
+} sched_core_t;
+
+/* One assembled transmission batch */
+typedef struct {
+    uint8_t class_counts[MAX_CLASSES];   // Data elements per class (goes into the frame header)
+    uint8_t class_packets[MAX_CLASSES];  // Queued packets merged per class
+    uint8_t class_misses[MAX_CLASSES];   // Packets dropped for a missed deadline
+    uint16_t size;                       // Bytes written to the batch buffer
+    sample_times_t times;                // Capture time of each merged packet
+    sample_held_t held;                  // Groups held back before merged packets, class marks
+} sched_batch_t;
+
+/**
+ * @brief Reset queues, class configuration and statistics
+ */
+void sched_core_init(sched_core_t *core);
+
+/**
+ * @brief Queue one packet of @p count elements of the class's data type
+ *
+ * In send-on-delta mode a group within the dead-band is held back instead
+ * and SCHED_OK returned.
+ *
+ * @param data Native-order samples; they are stored little-endian (wire order)
+ * @param now_ms Current time, used to stamp the absolute deadline
+ */
+sched_status_t sched_core_submit(sched_core_t *core, class_id_t class_id,
+                                 const void *data, uint16_t count, uint32_t now_ms);
+
+/**
+ * @brief Earliest head-of-queue deadline, UINT32_MAX when all queues are empty
+ */
+uint32_t sched_core_earliest_deadline(const sched_core_t *core);
+
+/**
+ * @brief Whether the earliest deadline is within the processing threshold
+ */
+bool sched_core_due(const sched_core_t *core, uint32_t now_ms);
+
+/**
+ * @brief Count frames send-on-delta avoided; call once per scheduling tick
+ *
+ * A frame counts as avoided when a held group's deadline would have been
+ * due while no queued data is. Batches clear pending held deadlines, as the
+ * held groups would have ridden along.
+ */
+void sched_core_dedup_tick(sched_core_t *core, uint32_t now_ms);
+
+/**
+ * @brief Drop expired packets and assemble the next batch
+ *
+ * Class data is laid out in class order regardless of policy, which is the
+ * order the AP decodes it in. The policy only decides which packets go in.
+ * Packets reporting held groups stop being merged once batch->held is full.
+ * Send-on-delta classes in the batch get a mark in batch->held, so send a
+ * held block whenever it has entries or marks.
+ *
+ * @param buf Destination buffer of @p capacity bytes
+ * @param[out] batch Per-class counts for the frame header and logging
+ * @return Number of bytes written (same as batch->size)
+ */
+uint16_t sched_core_build_batch(sched_core_t *core, uint32_t now_ms,
+                                uint8_t *buf, uint16_t capacity, sched_batch_t *batch);
+
+/**
+ * @brief Account a batch that the transport accepted
+ */
+void sched_core_batch_sent(sched_core_t *core, const sched_batch_t *batch);
+
+#endif /* SCHED_CORE_H */
@@ -0,0 +1,59 @@
+/**
+ * @file sched_queue.h
+ * @brief Per-class FIFO packet queue used by the scheduler
+ *
+ * The queue performs no locking; callers serialize access (the firmware
+ * holds the scheduler mutex, host tools are single threaded).
+ */
+
+#ifndef SCHED_QUEUE_H
+#define SCHED_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sched_types.h"
+
+/* Internal queue packet structure */
+typedef struct {
+    class_id_t class_id;          // Class identifier (0, 1, 2, 3)
+    uint32_t deadline;            // Absolute deadline for this packet (in ms)
+    uint32_t created;             // Capture time of the samples (in ms)
+    data_type_t data_type;        // Type of data contained
+    uint16_t data_count;          // Number of data elements
+    uint16_t size;                // Actual data size in bytes (not include header)
+    uint8_t held;                 // Groups held back by send-on-delta just before this one
+    uint8_t held_items;           // Elements in each of them
+    uint8_t held_ref;             // Sequence number of the group they repeat
+    uint8_t seq;                  // Send-on-delta sequence number of this group
+    uint8_t data[MAX_PACKET_SIZE]; // Packet data
+} queue_packet_t;
+
+/* Node structure for the linked list queue */
+typedef struct queue_node {
+    queue_packet_t packet;
+    struct queue_node *next;
+} queue_node_t;
+
+/* Queue structure */
+typedef struct {
+    queue_node_t *head;
+    queue_node_t *tail;
+    int count;
+} packet_queue_t;
+
+void queue_init(packet_queue_t *queue);
+bool queue_enqueue(packet_queue_t *queue, queue_packet_t *packet);
+bool queue_enqueue_front(packet_queue_t *queue, queue_packet_t *packet);
+bool queue_dequeue(packet_queue_t *queue, queue_packet_t *packet);
+bool queue_peek(packet_queue_t *queue, queue_packet_t *packet);
+
+/* Pointer to the front packet without copying it, NULL if empty */
+const queue_packet_t *queue_front(const packet_queue_t *queue);
+
+/* Remove and free the front packet without copying it out */
+bool queue_drop(packet_queue_t *queue);
+
+/* Free every queued packet */
+void queue_clear(packet_queue_t *queue);
+
+#endif /* SCHED_QUEUE_H */
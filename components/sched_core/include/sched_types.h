@@ -0,0 +1,119 @@
+/**
+ * @file sched_types.h
+ * @brief Class, data type and sizing definitions shared by station, AP and host tools
+ *
+ * This header has no ESP-IDF dependencies so the same definitions can be
+ * compiled into the firmware projects and into Linux host tools.
+ */
+
+#ifndef SCHED_TYPES_H
+#define SCHED_TYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Scheduler sizing. The class count and queue depth can be raised with -D
+ * for host stress builds of the core alone (host/bench/sched_bench.c); the
+ * frame header and time block layouts depend on them, so the firmware and
+ * anything that talks to it must keep the defaults. Per-class flags are
+ * kept in a class_mask_t, which limits MAX_CLASSES to 32.
+ */
+#ifndef MAX_CLASSES
+#define MAX_CLASSES              4     // Class 1, Class 2, Class 3 and the random class
+#endif
+#define MAX_PACKET_SIZE          1400  // Maximum packet data size
+#ifndef MAX_QUEUE_SIZE
+#define MAX_QUEUE_SIZE           50    // Maximum packets per queue
+#endif
+#define MAX_TX_SIZE              1400  // Maximum data size for transmission buffer
+
+/* One bit per class, bit i for class i */
+typedef uint32_t class_mask_t;
+#define CLASS_MASK_ALL           ((class_mask_t)(UINT32_MAX >> (32 - MAX_CLASSES)))
+
+_Static_assert(MAX_CLASSES >= 1 && MAX_CLASSES <= 32, "class flags must fit in class_mask_t");
+
+/* Class identifiers */
+typedef enum {
+    CLASS_1 = 0,                 // Class 1
+    CLASS_2 = 1,                 // Class 2
+    CLASS_3 = 2,                 // Class 3
+    CLASS_RANDOM = 3,            // Random packet class
+} class_id_t;
+
+/*
+ * Element type table: X(enum suffix, C type, bits, display name, command option)
+ *
+ * Every per-type table and specialized routine is generated from this list,
+ * so adding a type here is the only change needed to support it end to end.
+ * Order defines the on-air type code and must not change. Bits is the width
+ * of the unsigned word used to byte-swap the type (see sample_codec.h).
+ */
+#define SCHED_DATA_TYPES(X)                            \
+    X(INT8,   int8_t,  8,  "INT8",   "int8")           \
+    X(INT16,  int16_t, 16, "INT16",  "int16")          \
+    X(INT32,  int32_t, 32, "INT32",  "int32")          \
+    X(FLOAT,  float,   32, "FLOAT",  "float")          \
+    X(DOUBLE, double,  64, "DOUBLE", "double")
+
+typedef enum {
+#define SCHED_TYPE_ENUM(name, ctype, bits, label, option) DATA_TYPE_##name,
+    SCHED_DATA_TYPES(SCHED_TYPE_ENUM)
+#undef SCHED_TYPE_ENUM
+    NUM_DATA_TYPE
+} data_type_t;
+
+/*
+ * Class type codes at or above DATA_TYPE_SCHEMA_BASE name a record schema
+ * (see record_schema.h) instead of a single element type.
+ */
+#define SCHEMA_MAX_COUNT         8     // Schema IDs 0..7
+#define DATA_TYPE_SCHEMA_BASE    0x80
+#define DATA_TYPE_SCHEMA(id)     ((data_type_t)(DATA_TYPE_SCHEMA_BASE + (id)))
+
+/* Element size in bytes, indexed by data_type_t */
+extern const uint8_t data_type_sizes[NUM_DATA_TYPE];
+
+/* Check that a type code received from the air is one we know */
+static inline bool data_type_is_valid(uint32_t type)
+{
+    return type < NUM_DATA_TYPE;
+}
+
+/* Check whether a class type code names a schema (registered or not) */
+static inline bool data_type_is_schema(uint32_t type)
+{
+    return type >= DATA_TYPE_SCHEMA_BASE && type < DATA_TYPE_SCHEMA_BASE + SCHEMA_MAX_COUNT;
+}
+
+/* Schema ID of a schema type code */
+static inline uint8_t data_type_schema_id(uint32_t type)
+{
+    return (uint8_t)(type - DATA_TYPE_SCHEMA_BASE);
+}
+
+/* Element size for a validated type; 0 for unknown codes and schemas */
+static inline uint16_t data_type_size(data_type_t type)
+{
+    return data_type_is_valid(type) ? data_type_sizes[type] : 0;
+}
+
+/**
+ * @brief Upper-case display name of a data type ("INT8", ..., "SCHEMA" or "UNKNOWN")
+ */
+const char *data_type_name(data_type_t type);
+
+/**
+ * @brief Parse a command line type option ("int8", "float", ..., "schema<id>")
+ *
+ * A schema option only checks the ID range; use record_schema_get() to
+ * check that it is registered.
+ *
+ * @param option Case-insensitive option string
+ * @param[out] type Parsed type
+ * @return true if the option names a known type
+ */
+bool data_type_from_option(const char *option, data_type_t *type);
+
+#endif /* SCHED_TYPES_H */
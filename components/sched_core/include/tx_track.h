@@ -0,0 +1,106 @@
+/**
+ * @file tx_track.h
+ * @brief TX outcome tracking: driver TX-done reports matched to sent frames
+ *
+ * Each pending frame carries a tag, its CRC-32C trailer (frame_codec.h). When
+ * the driver hands the frame back with its report, the report goes to the
+ * pending frame with that tag; frames sent before it were reported in order
+ * and missed, so they count as lost. A report without the frame goes to the
+ * oldest pending frame, unless it is older than that frame's send call. A
+ * report that matches nothing belongs to a frame already given up on and is
+ * dropped rather than credited to the next one. A report only says
+ * whether the frame was delivered; the retry count is not exposed, so the
+ * time from the send call to the report stands in for it (queueing plus
+ * every retry). Failed frames are ones the driver gave up on after its
+ * retries.
+ *
+ * Latencies go into log2 microsecond bins: bin b holds [2^b, 2^(b+1)) us,
+ * bin 0 also holds 0 and the last bin everything longer. Runs of
+ * consecutive failures go into bins of 1, 2, ... TX_TRACK_RUN_BINS or more.
+ *
+ * Not thread safe; the caller serializes access.
+ */
+
+#ifndef TX_TRACK_H
+#define TX_TRACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TX_TRACK_DEPTH           8      // Frames awaiting a report; at least the frames in flight
+#define TX_TRACK_LATENCY_BINS    16     // Last bin starts at 32.8 ms
+#define TX_TRACK_RUN_BINS        8
+#define TX_TRACK_SEQ_NONE        UINT32_MAX  // Frame without a data frame number (schema announcements)
+
+/* A sent frame awaiting its report */
+typedef struct {
+    uint32_t seq;                // Data frame number, or TX_TRACK_SEQ_NONE
+    uint32_t tag;                // CRC trailer of the frame
+    uint32_t sent_us;
+} tx_track_entry_t;
+
+/* Pending frames and outcome statistics */
+typedef struct {
+    tx_track_entry_t pending[TX_TRACK_DEPTH];
+    uint8_t head;
+    uint8_t count;
+
+    uint32_t frames_sent;        // Frames the driver accepted
+    uint32_t frames_ok;
+    uint32_t frames_failed;
+    uint32_t reports_lost;       // Frames given up on without a report
+    uint32_t reports_unmatched;  // Reports with no frame pending
+    uint32_t reports_late;       // Reports for frames already given up on, dropped
+    uint32_t untracked;          // Frames sent while the pending ring was full
+    uint32_t last_failed_seq;    // TX_TRACK_SEQ_NONE until a data frame fails
+
+    uint32_t latency_ok[TX_TRACK_LATENCY_BINS];
+    uint32_t latency_failed[TX_TRACK_LATENCY_BINS];
+    uint64_t latency_ok_sum_us;
+    uint32_t latency_ok_max_us;
+
+    uint32_t fail_runs[TX_TRACK_RUN_BINS];
+    uint32_t fail_run;           // Consecutive failures so far
+
+    // Outcomes since the last tx_track_take_window(), for the controllers
+    uint32_t window_ok;
+    uint32_t window_failed;
+} tx_track_t;
+
+void tx_track_init(tx_track_t *track);
+
+/**
+ * @brief Record a frame the driver accepted
+ *
+ * @param tag CRC trailer of the frame
+ */
+void tx_track_sent(tx_track_t *track, uint32_t seq, uint32_t tag, uint32_t now_us);
+
+/**
+ * @brief Apply a TX-done report to the pending frame it belongs to
+ *
+ * @param tag CRC trailer of the reported frame, NULL when the driver did
+ *            not hand the frame back
+ * @param[out] seq Frame number of the reported frame
+ * @return Pending frames retired: the reported one plus any sent before it
+ *         whose reports were missed; 0 when the report matched no frame
+ *         (it is counted and dropped)
+ */
+int tx_track_done(tx_track_t *track, const uint32_t *tag, bool ok, uint32_t now_us, uint32_t *seq);
+
+/**
+ * @brief Give up on the oldest pending frame's report
+ */
+void tx_track_lost(tx_track_t *track);
+
+/**
+ * @brief Outcomes since the previous call
+ */
+void tx_track_take_window(tx_track_t *track, uint32_t *ok, uint32_t *failed);
+
+/**
+ * @brief Lower edge of a latency bin in microseconds
+ */
+uint32_t tx_track_bin_floor_us(int bin);
+
+#endif /* TX_TRACK_H */
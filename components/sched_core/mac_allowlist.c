@@ -0,0 +1,80 @@
+/**
+ * @file mac_allowlist.c
+ * @brief Source MAC allowlist with a fixed-cost lookup
+ */
+
+#include <string.h>
+#include "mac_allowlist.h"
+
+#define SLOT_MASK   (MAC_ALLOWLIST_SLOTS - 1)
+#define KEY_USED    (1ULL << 48)
+
+static uint64_t mac_key(const uint8_t mac[6])
+{
+    uint64_t key = KEY_USED;
+    for (int i = 0; i < 6; i++) {
+        key |= (uint64_t)mac[i] << (8 * i);
+    }
+    return key;
+}
+
+/* First slot of the address's window; the multiply mixes the vendor and device bytes */
+static uint32_t mac_slot(uint64_t key)
+{
+    uint32_t x = (uint32_t)key ^ ((uint32_t)(key >> 32) * 0x9E3779B1u);
+    return (x * 0x9E3779B1u) >> (32 - MAC_ALLOWLIST_SLOT_BITS);
+}
+
+void mac_allowlist_init(mac_allowlist_t *list)
+{
+    memset(list, 0, sizeof(*list));
+}
+
+bool mac_allowlist_add(mac_allowlist_t *list, const uint8_t mac[6])
+{
+    if (mac_allowlist_contains(list, mac)) {
+        return true;
+    }
+    if (list->count >= MAC_ALLOWLIST_MAX) {
+        return false;
+    }
+
+    uint64_t key = mac_key(mac);
+    uint32_t slot = mac_slot(key);
+    for (int i = 0; i < MAC_ALLOWLIST_PROBES; i++) {
+        uint64_t *entry = &list->slots[(slot + i) & SLOT_MASK];
+        if (*entry == 0) {
+            *entry = key;
+            list->count++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool mac_allowlist_remove(mac_allowlist_t *list, const uint8_t mac[6])
+{
+    uint64_t key = mac_key(mac);
+    uint32_t slot = mac_slot(key);
+    for (int i = 0; i < MAC_ALLOWLIST_PROBES; i++) {
+        uint64_t *entry = &list->slots[(slot + i) & SLOT_MASK];
+        if (*entry == key) {
+            // Lookups always compare the whole window, so no tombstone is needed
+            *entry = 0;
+            list->count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool mac_allowlist_contains(const mac_allowlist_t *list, const uint8_t mac[6])
+{
+    uint64_t key = mac_key(mac);
+    uint32_t slot = mac_slot(key);
+    bool found = false;
+    for (int i = 0; i < MAC_ALLOWLIST_PROBES; i++) {
+        found |= list->slots[(slot + i) & SLOT_MASK] == key;
+    }
+    return found;
+}
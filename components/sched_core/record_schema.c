@@ -0,0 +1,231 @@
+/**
+ * @file record_schema.c
+ * @brief Schema registry and generic record encode/decode
+ */
+
+#include <string.h>
+#include "record_schema.h"
+#include "sample_codec.h"
+
+static record_schema_t schemas[SCHEMA_MAX_COUNT];
+static uint32_t schema_conflicts;
+
+bool record_schema_register(uint8_t id, const data_type_t *field_types, uint8_t field_count)
+{
+    if (id >= SCHEMA_MAX_COUNT || field_types == NULL ||
+        field_count == 0 || field_count > SCHEMA_MAX_FIELDS) {
+        return false;
+    }
+
+    record_schema_t schema = {0};
+    uint16_t offset = 0;
+
+    for (int i = 0; i < field_count; i++) {
+        if (!data_type_is_valid(field_types[i])) {
+            return false;
+        }
+        schema.field_types[i] = field_types[i];
+        schema.field_offset[i] = offset;
+        offset += data_type_sizes[field_types[i]];
+    }
+
+    if (offset > MAX_PACKET_SIZE) {
+        return false;
+    }
+
+    schema.registered = true;
+    schema.field_count = field_count;
+    schema.record_size = offset;
+    schemas[id] = schema;
+
+    return true;
+}
+
+const record_schema_t *record_schema_get(uint8_t id)
+{
+    if (id >= SCHEMA_MAX_COUNT || !schemas[id].registered) {
+        return NULL;
+    }
+    return &schemas[id];
+}
+
+void record_schema_reset(void)
+{
+    memset(schemas, 0, sizeof(schemas));
+    schema_conflicts = 0;
+}
+
+/* Whether a registered schema has exactly these fields */
+static bool schema_matches(const record_schema_t *schema, const data_type_t *field_types,
+                           uint8_t field_count)
+{
+    if (schema->field_count != field_count) {
+        return false;
+    }
+    for (int f = 0; f < field_count; f++) {
+        if (schema->field_types[f] != field_types[f]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t record_schema_pack(uint8_t *out, size_t out_cap, const uint8_t *ids, size_t id_count)
+{
+    size_t len = 0;
+
+    for (size_t i = 0; i < id_count; i++) {
+        const record_schema_t *schema = record_schema_get(ids[i]);
+        if (schema == NULL) {
+            continue;
+        }
+        if (len + 2 + schema->field_count > out_cap) {
+            return 0;
+        }
+
+        out[len++] = ids[i];
+        out[len++] = schema->field_count;
+        for (int f = 0; f < schema->field_count; f++) {
+            out[len++] = (uint8_t)schema->field_types[f];
+        }
+    }
+
+    return len;
+}
+
+int record_schema_unpack(const uint8_t *in, size_t len)
+{
+    int loaded = 0;
+    size_t pos = 0;
+
+    while (pos < len) {
+        if (len - pos < 2) {
+            return -1;
+        }
+
+        uint8_t id = in[pos];
+        uint8_t field_count = in[pos + 1];
+        pos += 2;
+
+        if (field_count == 0 || field_count > SCHEMA_MAX_FIELDS || len - pos < field_count) {
+            return -1;
+        }
+
+        data_type_t field_types[SCHEMA_MAX_FIELDS];
+        for (int f = 0; f < field_count; f++) {
+            field_types[f] = (data_type_t)in[pos + f];
+        }
+        pos += field_count;
+
+        if (id >= SCHEMA_MAX_COUNT) {
+            return -1;
+        }
+        record_schema_t *known = &schemas[id];
+        if (known->conflict || (known->registered && !schema_matches(known, field_types, field_count))) {
+            known->registered = false;
+            known->conflict = true;
+            schema_conflicts++;
+            continue;
+        }
+        if (!record_schema_register(id, field_types, field_count)) {
+            return -1;
+        }
+        loaded++;
+    }
+
+    return loaded;
+}
+
+uint32_t record_schema_conflicts(void)
+{
+    return schema_conflicts;
+}
+
+bool class_type_is_valid(data_type_t type)
+{
+    return class_type_size(type) != 0;
+}
+
+uint16_t class_type_size(data_type_t type)
+{
+    if (data_type_is_valid(type)) {
+        return data_type_sizes[type];
+    }
+    if (data_type_is_schema(type)) {
+        const record_schema_t *schema = record_schema_get(data_type_schema_id(type));
+        return schema != NULL ? schema->record_size : 0;
+    }
+    return 0;
+}
+
+uint8_t class_type_fields(data_type_t type)
+{
+    if (data_type_is_valid(type)) {
+        return 1;
+    }
+    if (data_type_is_schema(type)) {
+        const record_schema_t *schema = record_schema_get(data_type_schema_id(type));
+        return schema != NULL ? schema->field_count : 0;
+    }
+    return 0;
+}
+
+size_t class_type_encode(data_type_t type, uint8_t *dst, const void *src, size_t count)
+{
+    if (data_type_is_valid(type)) {
+        return sample_encode(type, dst, src, count);
+    }
+
+    const record_schema_t *schema = data_type_is_schema(type) ?
+        record_schema_get(data_type_schema_id(type)) : NULL;
+    if (schema == NULL) {
+        return 0;
+    }
+
+    // Fields are packed, so native and wire records share the same offsets.
+    // Each field goes through an aligned temporary since packed fields may
+    // sit at odd offsets. Registration checked the field types.
+    const sample_kernels_t *kernels[SCHEMA_MAX_FIELDS];
+    for (int f = 0; f < schema->field_count; f++) {
+        kernels[f] = &sample_kernels[schema->field_types[f]];
+    }
+    const uint8_t *record = src;
+    for (size_t r = 0; r < count; r++) {
+        for (int f = 0; f < schema->field_count; f++) {
+            uint16_t offset = schema->field_offset[f];
+            uint64_t field;
+            memcpy(&field, record + offset, data_type_sizes[schema->field_types[f]]);
+            kernels[f]->encode(dst + offset, &field, 1);
+        }
+        record += schema->record_size;
+        dst += schema->record_size;
+    }
+
+    return count * schema->record_size;
+}
+
+size_t class_type_widen(data_type_t type, double *dst, const uint8_t *src, size_t count)
+{
+    if (data_type_is_valid(type)) {
+        return sample_widen(type, dst, src, count);
+    }
+
+    const record_schema_t *schema = data_type_is_schema(type) ?
+        record_schema_get(data_type_schema_id(type)) : NULL;
+    if (schema == NULL) {
+        return 0;
+    }
+
+    const sample_kernels_t *kernels[SCHEMA_MAX_FIELDS];
+    for (int f = 0; f < schema->field_count; f++) {
+        kernels[f] = &sample_kernels[schema->field_types[f]];
+    }
+    for (size_t r = 0; r < count; r++) {
+        for (int f = 0; f < schema->field_count; f++) {
+            kernels[f]->widen(dst++, src + schema->field_offset[f], 1);
+        }
+        src += schema->record_size;
+    }
+
+    return count * schema->record_size;
+}
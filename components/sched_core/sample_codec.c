@@ -0,0 +1,168 @@
+/**
+ * @file sample_codec.c
+ * @brief Specialized sample kernels and their runtime-type table
+ */
+
+#include <string.h>
+#include "sample_codec.h"
+
+/* Little-endian load/store of an unsigned word */
+static inline void store_le8(uint8_t *p, uint8_t v)
+{
+    p[0] = v;
+}
+
+static inline void store_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void store_le32(uint8_t *p, uint32_t v)
+{
+    store_le16(p, (uint16_t)v);
+    store_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline void store_le64(uint8_t *p, uint64_t v)
+{
+    store_le32(p, (uint32_t)v);
+    store_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+static inline uint8_t load_le8(const uint8_t *p)
+{
+    return p[0];
+}
+
+static inline uint16_t load_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t load_le32(const uint8_t *p)
+{
+    return (uint32_t)load_le16(p) | ((uint32_t)load_le16(p + 2) << 16);
+}
+
+static inline uint64_t load_le64(const uint8_t *p)
+{
+    return (uint64_t)load_le32(p) | ((uint64_t)load_le32(p + 4) << 32);
+}
+
+/*
+ * The SAMPLE_HOST_LITTLE_ENDIAN branch is a compile-time constant, so each
+ * kernel compiles to either a bulk memcpy or a fixed-width swap loop.
+ */
+#define SAMPLE_CODEC_DEFINE(name, ctype, bits, label, option)                        \
+    _Static_assert(sizeof(ctype) * 8 == bits, #name " width mismatch");              \
+                                                                                     \
+    void sample_encode_##name(uint8_t *dst, const ctype *src, size_t count)          \
+    {                                                                                \
+        if (SAMPLE_HOST_LITTLE_ENDIAN) {                                             \
+            memcpy(dst, src, count * sizeof(ctype));                                 \
+            return;                                                                  \
+        }                                                                            \
+        for (size_t i = 0; i < count; i++) {                                         \
+            uint##bits##_t raw;                                                      \
+            memcpy(&raw, &src[i], sizeof(raw));                                      \
+            store_le##bits(dst + i * sizeof(ctype), raw);                            \
+        }                                                                            \
+    }                                                                                \
+                                                                                     \
+    void sample_decode_##name(ctype *dst, const uint8_t *src, size_t count)          \
+    {                                                                                \
+        if (SAMPLE_HOST_LITTLE_ENDIAN) {                                             \
+            memcpy(dst, src, count * sizeof(ctype));                                 \
+            return;                                                                  \
+        }                                                                            \
+        for (size_t i = 0; i < count; i++) {                                         \
+            uint##bits##_t raw = load_le##bits(src + i * sizeof(ctype));             \
+            memcpy(&dst[i], &raw, sizeof(raw));                                      \
+        }                                                                            \
+    }                                                                                \
+                                                                                     \
+    void sample_widen_##name(double *dst, const uint8_t *src, size_t count)          \
+    {                                                                                \
+        for (size_t i = 0; i < count; i++) {                                         \
+            ctype value;                                                             \
+            if (SAMPLE_HOST_LITTLE_ENDIAN) {                                         \
+                memcpy(&value, src + i * sizeof(ctype), sizeof(value));              \
+            } else {                                                                 \
+                uint##bits##_t raw = load_le##bits(src + i * sizeof(ctype));         \
+                memcpy(&value, &raw, sizeof(value));                                 \
+            }                                                                        \
+            dst[i] = (double)value;                                                  \
+        }                                                                            \
+    }                                                                                \
+                                                                                     \
+    void sample_narrow_##name(ctype *dst, const double *src, size_t count)           \
+    {                                                                                \
+        for (size_t i = 0; i < count; i++) {                                         \
+            dst[i] = (ctype)src[i];                                                  \
+        }                                                                            \
+    }
+SCHED_DATA_TYPES(SAMPLE_CODEC_DEFINE)
+#undef SAMPLE_CODEC_DEFINE
+
+/* Adapters from the generic table signatures to the typed kernels */
+#define SAMPLE_KERNEL_ADAPT(name, ctype, bits, label, option)                        \
+    static void encode_##name(uint8_t *dst, const void *src, size_t count)           \
+    {                                                                                \
+        sample_encode_##name(dst, src, count);                                       \
+    }                                                                                \
+                                                                                     \
+    static void decode_##name(void *dst, const uint8_t *src, size_t count)           \
+    {                                                                                \
+        sample_decode_##name(dst, src, count);                                       \
+    }                                                                                \
+                                                                                     \
+    static void narrow_##name(void *dst, const double *src, size_t count)            \
+    {                                                                                \
+        sample_narrow_##name(dst, src, count);                                       \
+    }
+SCHED_DATA_TYPES(SAMPLE_KERNEL_ADAPT)
+#undef SAMPLE_KERNEL_ADAPT
+
+const sample_kernels_t sample_kernels[NUM_DATA_TYPE] = {
+#define SAMPLE_KERNEL_ROW(name, ctype, bits, label, option)                          \
+    [DATA_TYPE_##name] = { encode_##name, decode_##name, sample_widen_##name, narrow_##name },
+    SCHED_DATA_TYPES(SAMPLE_KERNEL_ROW)
+#undef SAMPLE_KERNEL_ROW
+};
+
+size_t sample_encode(data_type_t type, uint8_t *dst, const void *src, size_t count)
+{
+    if (!data_type_is_valid(type)) {
+        return 0;
+    }
+    sample_kernels[type].encode(dst, src, count);
+    return count * data_type_sizes[type];
+}
+
+size_t sample_decode(data_type_t type, void *dst, const uint8_t *src, size_t count)
+{
+    if (!data_type_is_valid(type)) {
+        return 0;
+    }
+    sample_kernels[type].decode(dst, src, count);
+    return count * data_type_sizes[type];
+}
+
+size_t sample_widen(data_type_t type, double *dst, const uint8_t *src, size_t count)
+{
+    if (!data_type_is_valid(type)) {
+        return 0;
+    }
+    sample_kernels[type].widen(dst, src, count);
+    return count * data_type_sizes[type];
+}
+
+size_t sample_narrow(data_type_t type, void *dst, const double *src, size_t count)
+{
+    if (!data_type_is_valid(type)) {
+        return 0;
+    }
+    sample_kernels[type].narrow(dst, src, count);
+    return count * data_type_sizes[type];
+}
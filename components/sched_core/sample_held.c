@@ -0,0 +1,141 @@
+/**
+ * @file sample_held.c
+ * @brief Held block codec and hold-last-value reconstruction
+ */
+
+#include <string.h>
+#include "sample_held.h"
+
+size_t sample_held_encode(uint8_t *out, size_t out_cap, const sample_held_t *held)
+{
+    size_t len = SAMPLE_HELD_LEN(held->count, held->mark_count);
+    if (held->count > SAMPLE_HELD_MAX_ENTRIES || held->mark_count > MAX_CLASSES || len > out_cap) {
+        return 0;
+    }
+
+    uint8_t *p = out;
+    *p++ = held->count;
+    *p++ = held->mark_count;
+    for (uint8_t i = 0; i < held->count; i++) {
+        const sample_held_entry_t *entry = &held->entries[i];
+        *p++ = entry->class_id;
+        *p++ = entry->offset;
+        *p++ = entry->held;
+        *p++ = entry->items;
+        *p++ = entry->ref;
+    }
+    for (uint8_t i = 0; i < held->mark_count; i++) {
+        *p++ = held->marks[i].class_id;
+        *p++ = held->marks[i].last;
+    }
+    return len;
+}
+
+size_t sample_held_decode(const uint8_t *in, size_t len, sample_held_t *held)
+{
+    if (len < 2 || in[0] > SAMPLE_HELD_MAX_ENTRIES || in[1] > MAX_CLASSES ||
+        len < SAMPLE_HELD_LEN(in[0], in[1])) {
+        return 0;
+    }
+
+    held->count = in[0];
+    held->mark_count = in[1];
+    const uint8_t *p = in + 2;
+    for (uint8_t i = 0; i < held->count; i++) {
+        sample_held_entry_t *entry = &held->entries[i];
+        entry->class_id = *p++;
+        entry->offset = *p++;
+        entry->held = *p++;
+        entry->items = *p++;
+        entry->ref = *p++;
+        if (entry->class_id >= MAX_CLASSES || entry->held == 0 || entry->items == 0) {
+            return 0;
+        }
+    }
+    for (uint8_t i = 0; i < held->mark_count; i++) {
+        held->marks[i].class_id = *p++;
+        held->marks[i].last = *p++;
+        if (held->marks[i].class_id >= MAX_CLASSES) {
+            return 0;
+        }
+    }
+    return SAMPLE_HELD_LEN(held->count, held->mark_count);
+}
+
+void sample_hold_init(sample_hold_t *hold)
+{
+    memset(hold, 0, sizeof(*hold));
+}
+
+int sample_hold_expand(const sample_hold_t *hold, const sample_held_t *held, int class_id,
+                       const uint8_t *data, uint8_t count, uint16_t element_size,
+                       sample_run_t runs[SAMPLE_HOLD_MAX_RUNS], uint32_t *dropped)
+{
+    int n = 0;
+    uint8_t pos = 0;
+
+    *dropped = 0;
+    for (uint8_t i = 0; i < held->count; i++) {
+        const sample_held_entry_t *entry = &held->entries[i];
+        if (entry->class_id != class_id) {
+            continue;
+        }
+        if (entry->offset < pos || entry->offset >= count) {
+            *dropped += entry->held;
+            continue;
+        }
+
+        // The held groups repeat the group that ends where they belong. Within
+        // the frame that is the one just before; the station queues them in
+        // order and drops expired groups only from the front.
+        const uint8_t *reference;
+        if (entry->offset >= entry->items) {
+            reference = data + (size_t)(entry->offset - entry->items) * element_size;
+        } else if (entry->offset == 0 && hold->seq_known[class_id] &&
+                   hold->last_seq[class_id] == entry->ref &&
+                   hold->element_size[class_id] == element_size &&
+                   hold->last_items[class_id] >= entry->items) {
+            reference = hold->last[class_id] +
+                (size_t)(hold->last_items[class_id] - entry->items) * element_size;
+        } else {
+            *dropped += entry->held;
+            continue;
+        }
+
+        if (entry->offset > pos) {
+            runs[n++] = (sample_run_t){ data + (size_t)pos * element_size, entry->offset - pos, 1, false };
+        }
+        runs[n++] = (sample_run_t){ reference, entry->items, entry->held, true };
+        pos = entry->offset;
+    }
+
+    if (count > pos) {
+        runs[n++] = (sample_run_t){ data + (size_t)pos * element_size, count - pos, 1, false };
+    }
+    return n;
+}
+
+void sample_hold_keep(sample_hold_t *hold, const sample_held_t *held, int class_id,
+                      const uint8_t *data, uint8_t count, uint16_t element_size)
+{
+    size_t size = (size_t)count * element_size;
+    if (count == 0) {
+        return;
+    }
+    if (size > sizeof(hold->last[class_id])) {
+        hold->seq_known[class_id] = false;
+        return;
+    }
+    memcpy(hold->last[class_id], data, size);
+    hold->last_items[class_id] = count;
+    hold->element_size[class_id] = element_size;
+
+    // Without a mark nothing can refer to this data
+    hold->seq_known[class_id] = false;
+    for (uint8_t i = 0; held != NULL && i < held->mark_count; i++) {
+        if (held->marks[i].class_id == class_id) {
+            hold->last_seq[class_id] = held->marks[i].last;
+            hold->seq_known[class_id] = true;
+        }
+    }
+}
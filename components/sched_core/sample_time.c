@@ -0,0 +1,218 @@
+/**
+ * @file sample_time.c
+ * @brief Delta-of-delta sample time block encoder and decoder
+ */
+
+#include <string.h>
+#include "sample_time.h"
+
+/* MSB-first bit writer over a fixed buffer */
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t bits;
+    bool overflow;
+} bit_writer_t;
+
+/* MSB-first bit reader */
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t bits;
+    bool underflow;
+} bit_reader_t;
+
+static void put_bits(bit_writer_t *w, uint32_t value, int count)
+{
+    for (int i = count - 1; i >= 0; i--) {
+        size_t byte = w->bits / 8;
+        if (byte >= w->cap) {
+            w->overflow = true;
+            return;
+        }
+        if (w->bits % 8 == 0) {
+            w->buf[byte] = 0;
+        }
+        if ((value >> i) & 1) {
+            w->buf[byte] |= 0x80 >> (w->bits % 8);
+        }
+        w->bits++;
+    }
+}
+
+static uint32_t get_bits(bit_reader_t *r, int count)
+{
+    uint32_t value = 0;
+
+    for (int i = 0; i < count; i++) {
+        size_t byte = r->bits / 8;
+        if (byte >= r->len) {
+            r->underflow = true;
+            return 0;
+        }
+        value = (value << 1) | ((r->buf[byte] >> (7 - r->bits % 8)) & 1);
+        r->bits++;
+    }
+
+    return value;
+}
+
+static inline uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/* Zigzag bucket code, see sample_time.h */
+static void put_signed(bit_writer_t *w, int32_t v)
+{
+    uint32_t zz = zigzag(v);
+
+    if (zz == 0) {
+        put_bits(w, 0x0, 1);
+    } else if (zz < (1u << 7)) {
+        put_bits(w, 0x2, 2);
+        put_bits(w, zz, 7);
+    } else if (zz < (1u << 9)) {
+        put_bits(w, 0x6, 3);
+        put_bits(w, zz, 9);
+    } else if (zz < (1u << 12)) {
+        put_bits(w, 0xE, 4);
+        put_bits(w, zz, 12);
+    } else {
+        put_bits(w, 0xF, 4);
+        put_bits(w, zz, 32);
+    }
+}
+
+static int32_t get_signed(bit_reader_t *r)
+{
+    if (get_bits(r, 1) == 0) {
+        return 0;
+    }
+    if (get_bits(r, 1) == 0) {
+        return unzigzag(get_bits(r, 7));
+    }
+    if (get_bits(r, 1) == 0) {
+        return unzigzag(get_bits(r, 9));
+    }
+    if (get_bits(r, 1) == 0) {
+        return unzigzag(get_bits(r, 12));
+    }
+    return unzigzag(get_bits(r, 32));
+}
+
+size_t sample_time_encode(uint8_t *out, size_t out_cap, uint32_t frame_time,
+                          const uint32_t periods[MAX_CLASSES], const sample_times_t *times)
+{
+    bit_writer_t w = { .buf = out, .cap = out_cap };
+
+    put_bits(&w, times->class_mask, SAMPLE_TIME_MASK_BITS);
+
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        if (!(times->class_mask & (1u << class_id))) {
+            continue;
+        }
+
+        uint8_t groups = times->groups[class_id];
+        const uint8_t *items = times->items[class_id];
+        const uint32_t *t = times->times[class_id];
+
+        put_bits(&w, groups, SAMPLE_TIME_GROUP_BITS);
+        if (groups == 0) {
+            continue;
+        }
+
+        // Sample counts: once if every group has the same count
+        bool uniform = true;
+        for (int k = 1; k < groups; k++) {
+            uniform = uniform && items[k] == items[0];
+        }
+        put_bits(&w, uniform, 1);
+        for (int k = 0; k < (uniform ? 1 : groups); k++) {
+            put_bits(&w, items[k], 8);
+        }
+
+        put_signed(&w, (int32_t)(frame_time - t[0]));
+        if (groups < 2) {
+            continue;
+        }
+
+        int32_t period = (int32_t)periods[class_id];
+        put_signed(&w, period);
+        for (int k = 1; k < groups; k++) {
+            put_signed(&w, (int32_t)(t[k] - t[k - 1]) - period);
+        }
+    }
+
+    return w.overflow ? 0 : (w.bits + 7) / 8;
+}
+
+bool sample_time_decode(const uint8_t *in, size_t len, uint32_t frame_time, sample_times_t *times)
+{
+    bit_reader_t r = { .buf = in, .len = len };
+
+    memset(times, 0, sizeof(*times));
+    times->class_mask = get_bits(&r, SAMPLE_TIME_MASK_BITS);
+
+    for (int class_id = 0; class_id < MAX_CLASSES && !r.underflow; class_id++) {
+        if (!(times->class_mask & (1u << class_id))) {
+            continue;
+        }
+
+        uint32_t group_count = get_bits(&r, SAMPLE_TIME_GROUP_BITS);
+        if (group_count > MAX_QUEUE_SIZE) {
+            return false;
+        }
+        uint8_t groups = (uint8_t)group_count;
+        times->groups[class_id] = groups;
+        if (groups == 0) {
+            continue;
+        }
+
+        uint8_t *items = times->items[class_id];
+        uint32_t *t = times->times[class_id];
+
+        if (get_bits(&r, 1)) {
+            uint8_t count = (uint8_t)get_bits(&r, 8);
+            memset(items, count, groups);
+        } else {
+            for (int k = 0; k < groups; k++) {
+                items[k] = (uint8_t)get_bits(&r, 8);
+            }
+        }
+
+        t[0] = frame_time - (uint32_t)get_signed(&r);
+        if (groups < 2) {
+            continue;
+        }
+
+        int32_t period = get_signed(&r);
+        for (int k = 1; k < groups; k++) {
+            t[k] = t[k - 1] + (uint32_t)(period + get_signed(&r));
+        }
+    }
+
+    return !r.underflow;
+}
+
+bool sample_time_at(const sample_times_t *times, int class_id, uint16_t index, uint32_t *time_ms)
+{
+    if (class_id < 0 || class_id >= MAX_CLASSES || !(times->class_mask & (1u << class_id))) {
+        return false;
+    }
+
+    for (int k = 0; k < times->groups[class_id]; k++) {
+        if (index < times->items[class_id][k]) {
+            *time_ms = times->times[class_id][k];
+            return true;
+        }
+        index -= times->items[class_id][k];
+    }
+
+    return false;
+}
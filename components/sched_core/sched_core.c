@@ -0,0 +1,369 @@
+/**
+ * @file sched_core.c
+ * @brief Batch assembly for the packet scheduler
+ */
+
+#include <string.h>
+#include "sched_core.h"
+#include "record_schema.h"
+
+/* Values of the last and the new group compared per class_type_widen() call */
+#define DEDUP_CHUNK_VALUES  64
+
+void sched_core_init(sched_core_t *core)
+{
+    memset(core, 0, sizeof(*core));
+
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        queue_init(&core->packet_queues[i]);
+        core->class_types[i] = DATA_TYPE_INT32;
+    }
+}
+
+/* Whether a group stays within the dead-band of the class's last queued group
+ * and no keyframe is due; a change of type or size always goes out, as does
+ * a group too large for the 8-bit item count of a held entry */
+static bool dedup_holds(const sched_core_t *core, class_id_t class_id,
+                        const queue_packet_t *packet, uint32_t now_ms)
+{
+    const sched_dedup_t *dedup = &core->dedup[class_id];
+    uint32_t keyframe = core->dedup_keyframe_ms[class_id];
+
+    if (dedup->last_count == 0 || dedup->last_count > UINT8_MAX || dedup->keyframe ||
+        packet->data_count != dedup->last_count || packet->data_type != dedup->last_type ||
+        dedup->pending == UINT8_MAX || (keyframe > 0 && now_ms - dedup->last_queued >= keyframe)) {
+        return false;
+    }
+
+    double band = core->dedup_deadband[class_id];
+    uint16_t element_size = packet->size / packet->data_count;
+    uint8_t fields = class_type_fields(packet->data_type);   // Nonzero: submit checked the type
+    uint16_t per_chunk = DEDUP_CHUNK_VALUES / fields;
+    double now[DEDUP_CHUNK_VALUES], last[DEDUP_CHUNK_VALUES];
+
+    // Usual groups fit in one chunk, so the type is resolved once per group
+    for (uint16_t i = 0; i < packet->data_count; i += per_chunk) {
+        uint16_t n = packet->data_count - i < per_chunk ? packet->data_count - i : per_chunk;
+        size_t at = (size_t)i * element_size;
+        size_t values = (size_t)n * fields;
+        class_type_widen(packet->data_type, now, packet->data + at, n);
+        class_type_widen(packet->data_type, last, dedup->last + at, n);
+        for (size_t v = 0; v < values; v++) {
+            double change = now[v] - last[v];
+            if (!(change <= band && change >= -band)) {
+                return false;   // Also a NaN appearing or going away
+            }
+        }
+    }
+    return true;
+}
+
+sched_status_t sched_core_submit(sched_core_t *core, class_id_t class_id,
+                                 const void *data, uint16_t count, uint32_t now_ms)
+{
+    if (class_id >= MAX_CLASSES) {
+        return SCHED_ERR_INVALID_ARG;
+    }
+
+    data_type_t data_type = core->class_types[class_id];
+    uint16_t element_size = class_type_size(data_type);
+    if (element_size == 0) {
+        return SCHED_ERR_INVALID_ARG;  // Unknown type or unregistered schema
+    }
+
+    uint32_t total_size = (uint32_t)element_size * count;
+    if (total_size > MAX_PACKET_SIZE) {
+        return SCHED_ERR_TOO_LARGE;
+    }
+
+    queue_packet_t packet;
+    packet.class_id = class_id;
+    packet.data_type = data_type;
+    packet.data_count = count;
+    packet.size = (uint16_t)total_size;
+    packet.deadline = now_ms + core->class_deadlines[class_id];
+    packet.created = now_ms;
+    packet.held = 0;
+    packet.held_items = 0;
+    packet.held_ref = 0;
+    packet.seq = 0;
+
+    // Queue samples in wire order so batch assembly is a plain byte copy
+    if (data != NULL && total_size > 0) {
+        class_type_encode(data_type, packet.data, data, count);
+    }
+
+    sched_dedup_t *dedup = &core->dedup[class_id];
+    bool delta = data != NULL && total_size > 0 && (core->dedup_mask & (1u << class_id));
+    if (delta && dedup_holds(core, class_id, &packet, now_ms)) {
+        dedup->pending++;
+        dedup->held_groups++;
+        dedup->held_bytes += packet.size;
+        if (!dedup->shadow) {
+            dedup->shadow = true;
+            dedup->shadow_deadline = packet.deadline;
+        }
+        return SCHED_OK;
+    }
+    if (delta) {
+        packet.seq = (uint8_t)(dedup->last_seq + 1);
+    }
+    if (delta && dedup->pending > 0) {
+        packet.held = dedup->pending;
+        packet.held_items = (uint8_t)dedup->last_count;   // At most UINT8_MAX, or nothing was held
+        packet.held_ref = dedup->last_seq;
+    }
+
+    if (!queue_enqueue(&core->packet_queues[class_id], &packet)) {
+        return SCHED_ERR_QUEUE_FULL;
+    }
+
+    if (delta) {
+        memcpy(dedup->last, packet.data, packet.size);
+        dedup->last_count = packet.data_count;
+        dedup->last_type = data_type;
+        dedup->last_queued = now_ms;
+        dedup->last_seq = packet.seq;
+        dedup->pending = 0;
+        dedup->keyframe = false;
+    }
+
+    return SCHED_OK;
+}
+
+uint32_t sched_core_earliest_deadline(const sched_core_t *core)
+{
+    uint32_t earliest_deadline = UINT32_MAX;
+
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        const queue_packet_t *head = queue_front(&core->packet_queues[class_id]);
+        if (head != NULL && head->deadline < earliest_deadline) {
+            earliest_deadline = head->deadline;
+        }
+    }
+
+    return earliest_deadline;
+}
+
+bool sched_core_due(const sched_core_t *core, uint32_t now_ms)
+{
+    uint32_t earliest_deadline = sched_core_earliest_deadline(core);
+
+    return earliest_deadline != UINT32_MAX &&
+           earliest_deadline <= now_ms + core->processing_threshold;
+}
+
+void sched_core_dedup_tick(sched_core_t *core, uint32_t now_ms)
+{
+    bool due = false;
+    int earliest = -1;
+
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        const sched_dedup_t *dedup = &core->dedup[class_id];
+        if (!dedup->shadow) {
+            continue;
+        }
+        if (dedup->shadow_deadline <= now_ms + core->processing_threshold) {
+            due = true;
+        }
+        if (earliest < 0 || dedup->shadow_deadline < core->dedup[earliest].shadow_deadline) {
+            earliest = class_id;
+        }
+    }
+    if (!due) {
+        return;
+    }
+
+    // The frame that would have gone out carries every held group so far
+    if (!sched_core_due(core, now_ms)) {
+        core->dedup[earliest].frames_avoided++;
+    }
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        core->dedup[class_id].shadow = false;
+    }
+}
+
+/* Drop packets at the head of each queue whose deadline has passed.
+ * Deadlines within a class are non-decreasing, so expired packets
+ * always form a prefix of the queue. A dropped send-on-delta group may
+ * carry held groups or be the one later held groups repeat; either way
+ * the next group goes out in full so the AP has a reference again. */
+static void drop_expired(sched_core_t *core, uint32_t now_ms, sched_batch_t *batch)
+{
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        packet_queue_t *queue = &core->packet_queues[class_id];
+        const queue_packet_t *head;
+
+        while ((head = queue_front(queue)) != NULL && now_ms > head->deadline) {
+            if (core->dedup_mask & (1u << class_id)) {
+                core->dedup[class_id].keyframe = true;
+            }
+            queue_drop(queue);
+            batch->class_misses[class_id]++;
+            core->deadline_misses++;
+            core->packets_processed++;
+        }
+    }
+}
+
+/* A packet fits if its bytes fit and the class element count still fits
+ * in the 8-bit per-class count carried in the frame header */
+static inline bool packet_fits(const queue_packet_t *packet, uint16_t remaining, uint16_t items)
+{
+    return packet->size <= remaining && items + packet->data_count <= UINT8_MAX;
+}
+
+#if SCHED_POLICY_FIXED_ORDER
+
+/* Take packets class by class: all of Class 1 that fits, then Class 2, ... */
+static void select_packets(const sched_core_t *core, uint16_t capacity,
+                           uint8_t take[MAX_CLASSES])
+{
+    uint16_t remaining = capacity;
+
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        uint16_t items = 0;
+
+        for (const queue_node_t *node = core->packet_queues[class_id].head;
+             node != NULL; node = node->next) {
+            if (!packet_fits(&node->packet, remaining, items)) {
+                break;
+            }
+
+            take[class_id]++;
+            items += node->packet.data_count;
+            remaining -= node->packet.size;
+
+            // If buffer is nearly full, stop adding packets of this class
+            if (remaining < CONFIG_SCHED_BATCH_FILL_MARGIN) {
+                break;
+            }
+        }
+    }
+}
+
+#elif SCHED_POLICY_EDF
+
+/* Repeatedly take the fitting head packet with the earliest deadline
+ * across all classes */
+static void select_packets(const sched_core_t *core, uint16_t capacity,
+                           uint8_t take[MAX_CLASSES])
+{
+    const queue_node_t *cursor[MAX_CLASSES];
+    uint16_t items[MAX_CLASSES] = {0};
+    uint16_t remaining = capacity;
+
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        cursor[class_id] = core->packet_queues[class_id].head;
+    }
+
+    while (1) {
+        int best = -1;
+
+        for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+            const queue_node_t *node = cursor[class_id];
+            if (node == NULL || !packet_fits(&node->packet, remaining, items[class_id])) {
+                continue;
+            }
+            if (best < 0 || node->packet.deadline < cursor[best]->packet.deadline) {
+                best = class_id;
+            }
+        }
+
+        if (best < 0) {
+            break;
+        }
+
+        take[best]++;
+        items[best] += cursor[best]->packet.data_count;
+        remaining -= cursor[best]->packet.size;
+        cursor[best] = cursor[best]->next;
+
+        // If buffer is nearly full, stop adding packets
+        if (remaining < CONFIG_SCHED_BATCH_FILL_MARGIN) {
+            break;
+        }
+    }
+}
+
+#endif
+
+uint16_t sched_core_build_batch(sched_core_t *core, uint32_t now_ms,
+                                uint8_t *buf, uint16_t capacity, sched_batch_t *batch)
+{
+    uint8_t take[MAX_CLASSES] = {0};
+    uint8_t *data_ptr = buf;
+
+    memset(batch, 0, sizeof(*batch));
+    batch->times.class_mask = core->sample_time_mask;
+
+    drop_expired(core, now_ms, batch);
+    select_packets(core, capacity, take);
+
+    // Emit selected packets in fixed class order, which is how the AP decodes them
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        packet_queue_t *queue = &core->packet_queues[class_id];
+        uint8_t last_seq = 0;
+
+        for (uint8_t i = 0; i < take[class_id]; i++) {
+            const queue_packet_t *packet = queue_front(queue);
+
+            // Held groups need an entry in the held block; once it is full they wait
+            if (packet->held > 0) {
+                if (batch->held.count == SAMPLE_HELD_MAX_ENTRIES) {
+                    break;
+                }
+                batch->held.entries[batch->held.count++] = (sample_held_entry_t){
+                    .class_id = (uint8_t)class_id,
+                    .offset = batch->class_counts[class_id],
+                    .held = packet->held,
+                    .items = packet->held_items,
+                    .ref = packet->held_ref,
+                };
+            }
+
+            memcpy(data_ptr, packet->data, packet->size);
+            data_ptr += packet->size;
+
+            // Every merged packet is one sample group for the time block
+            uint8_t group = batch->times.groups[class_id]++;
+            batch->times.items[class_id][group] = (uint8_t)packet->data_count;
+            batch->times.times[class_id][group] = packet->created;
+
+            batch->class_counts[class_id] += packet->data_count;
+            batch->class_packets[class_id]++;
+            core->packets_processed++;
+            last_seq = packet->seq;
+
+            queue_drop(queue);
+        }
+
+        // Mark the last group so the AP knows what held groups at offset 0 of its next frame repeat
+        if (batch->class_packets[class_id] > 0 && (core->dedup_mask & (1u << class_id))) {
+            batch->held.marks[batch->held.mark_count++] = (sample_held_mark_t){
+                .class_id = (uint8_t)class_id,
+                .last = last_seq,
+            };
+        }
+    }
+
+    batch->size = (uint16_t)(data_ptr - buf);
+
+    // Held groups would have gone out with this frame
+    if (batch->size > 0) {
+        for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+            core->dedup[class_id].shadow = false;
+        }
+    }
+    return batch->size;
+}
+
+void sched_core_batch_sent(sched_core_t *core, const sched_batch_t *batch)
+{
+    // Count how many class types were transmitted
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        if (batch->class_counts[class_id] > 0) {
+            core->packets_transmitted++;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/**
+ * @file sched_types.c
+ * @brief Tables generated from the SCHED_DATA_TYPES list
+ */
+
+#include <stddef.h>
+#include <strings.h>
+#include "sched_types.h"
+
+const uint8_t data_type_sizes[NUM_DATA_TYPE] = {
+#define SCHED_TYPE_SIZE(name, ctype, bits, label, option) [DATA_TYPE_##name] = sizeof(ctype),
+    SCHED_DATA_TYPES(SCHED_TYPE_SIZE)
+#undef SCHED_TYPE_SIZE
+};
+
+static const char *const data_type_names[NUM_DATA_TYPE] = {
+#define SCHED_TYPE_NAME(name, ctype, bits, label, option) [DATA_TYPE_##name] = label,
+    SCHED_DATA_TYPES(SCHED_TYPE_NAME)
+#undef SCHED_TYPE_NAME
+};
+
+static const char *const data_type_options[NUM_DATA_TYPE] = {
+#define SCHED_TYPE_OPTION(name, ctype, bits, label, option) [DATA_TYPE_##name] = option,
+    SCHED_DATA_TYPES(SCHED_TYPE_OPTION)
+#undef SCHED_TYPE_OPTION
+};
+
+const char *data_type_name(data_type_t type)
+{
+    if (data_type_is_valid(type)) {
+        return data_type_names[type];
+    }
+    return data_type_is_schema(type) ? "SCHEMA" : "UNKNOWN";
+}
+
+bool data_type_from_option(const char *option, data_type_t *type)
+{
+    if (option == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < NUM_DATA_TYPE; i++) {
+        if (strcasecmp(option, data_type_options[i]) == 0) {
+            *type = (data_type_t)i;
+            return true;
+        }
+    }
+
+    // "schema<id>" selects a record schema
+    if (strncasecmp(option, "schema", 6) == 0 && option[6] >= '0' && option[6] <= '9' &&
+        option[7] == '\0' && option[6] - '0' < SCHEMA_MAX_COUNT) {
+        *type = DATA_TYPE_SCHEMA(option[6] - '0');
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file tx_track.c
+ * @brief TX outcome tracking for driver TX-done reports
+ */
+
+#include <string.h>
+#include "tx_track.h"
+
+void tx_track_init(tx_track_t *track)
+{
+    memset(track, 0, sizeof(*track));
+    track->last_failed_seq = TX_TRACK_SEQ_NONE;
+}
+
+static int latency_bin(uint32_t us)
+{
+    int bin = 0;
+    while (us > 1 && bin < TX_TRACK_LATENCY_BINS - 1) {
+        us >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+/* Close a run of failures once a frame gets through */
+static void end_fail_run(tx_track_t *track)
+{
+    if (track->fail_run == 0) {
+        return;
+    }
+    uint32_t bin = track->fail_run < TX_TRACK_RUN_BINS ? track->fail_run - 1 : TX_TRACK_RUN_BINS - 1;
+    track->fail_runs[bin]++;
+    track->fail_run = 0;
+}
+
+void tx_track_sent(tx_track_t *track, uint32_t seq, uint32_t tag, uint32_t now_us)
+{
+    track->frames_sent++;
+    if (track->count == TX_TRACK_DEPTH) {
+        track->untracked++;
+        return;
+    }
+    tx_track_entry_t *entry = &track->pending[(track->head + track->count) % TX_TRACK_DEPTH];
+    entry->seq = seq;
+    entry->tag = tag;
+    entry->sent_us = now_us;
+    track->count++;
+}
+
+/* Position of the pending frame a report belongs to, or -1 if it was given up on */
+static int find_reported(const tx_track_t *track, const uint32_t *tag, uint32_t now_us)
+{
+    if (tag == NULL) {
+        // Reported in order, but not before the oldest pending frame was sent
+        const tx_track_entry_t *entry = &track->pending[track->head];
+        return (int32_t)(now_us - entry->sent_us) >= 0 ? 0 : -1;
+    }
+    for (int i = 0; i < track->count; i++) {
+        if (track->pending[(track->head + i) % TX_TRACK_DEPTH].tag == *tag) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int tx_track_done(tx_track_t *track, const uint32_t *tag, bool ok, uint32_t now_us, uint32_t *seq)
+{
+    if (track->count == 0) {
+        track->reports_unmatched++;
+        return 0;
+    }
+    int pos = find_reported(track, tag, now_us);
+    if (pos < 0) {
+        track->reports_late++;
+        return 0;
+    }
+
+    // Frames sent before the reported one will not be reported any more
+    track->reports_lost += pos;
+    track->head = (track->head + pos) % TX_TRACK_DEPTH;
+    track->count -= pos;
+
+    const tx_track_entry_t *entry = &track->pending[track->head];
+    uint32_t latency = now_us - entry->sent_us;
+    *seq = entry->seq;
+    track->head = (track->head + 1) % TX_TRACK_DEPTH;
+    track->count--;
+
+    if (ok) {
+        track->frames_ok++;
+        track->window_ok++;
+        track->latency_ok[latency_bin(latency)]++;
+        track->latency_ok_sum_us += latency;
+        if (latency > track->latency_ok_max_us) {
+            track->latency_ok_max_us = latency;
+        }
+        end_fail_run(track);
+    } else {
+        track->frames_failed++;
+        track->window_failed++;
+        track->latency_failed[latency_bin(latency)]++;
+        track->fail_run++;
+        if (*seq != TX_TRACK_SEQ_NONE) {
+            track->last_failed_seq = *seq;
+        }
+    }
+    return pos + 1;
+}
+
+void tx_track_lost(tx_track_t *track)
+{
+    if (track->count == 0) {
+        return;
+    }
+    track->head = (track->head + 1) % TX_TRACK_DEPTH;
+    track->count--;
+    track->reports_lost++;
+}
+
+void tx_track_take_window(tx_track_t *track, uint32_t *ok, uint32_t *failed)
+{
+    *ok = track->window_ok;
+    *failed = track->window_failed;
+    track->window_ok = 0;
+    track->window_failed = 0;
+}
+
+uint32_t tx_track_bin_floor_us(int bin)
+{
+    return bin == 0 ? 0 : 1u << bin;
+}
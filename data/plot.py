@@ -1,50 +1,284 @@
+"""Plot current traces and print their energy breakdown.
+
+Traces are read in chunks and never held whole: the energy figures come
+from running sums and the figure from a min/max envelope of at most
+MAX_PLOT_POINTS columns, so hour-long captures fit in constant memory.
+Accepts csv text, trc files (host/trace/trace_io.h) and "-" for stdin.
+host/trace/trace_stat computes the same figures, plus bursts and state
+residency, much faster.
+
+When a zoom pyramid (".trp", built by host/trace/trace_zoom) sits next to
+the trace, the figure is drawn from it instead: only the buckets of the
+window from the level trace_pyramid_select() would pick are mapped, so any
+window of any trace draws in constant time. --start/--end zoom in.
+
+Usage: python plot.py [--interval ms] [--voltage V] [--threshold A]
+                      [--start s] [--end s] [--width points] [--stream] trace...
+"""
+
+import argparse
+import os
+import struct
+import sys
+
 import numpy as np
 import matplotlib.pyplot as plt
 
-def plot_samples(file_path):
-    # Read data from file
-    with open(file_path, 'r') as file:
-        data_str = file.read().strip()
-    
-    # Convert string to list of floating-point numbers, ignoring empty entries
-    samples = np.array([float(value) for value in data_str.split(',') if value.strip()])
-
-    num_samples = 50000
-    sample_interval = 0.6e-3
-    time_axis = np.arange(num_samples) * sample_interval
-    
-    # Ensure we have 30,000 samples
-    if len(samples) != num_samples:
-        print(f"Warning: Expected 50,000 samples but got {len(samples)}.")
-    
-    # Plot data with lines connecting points
+SAMPLE_INTERVAL = 0.6e-3
+VOLTAGE = 5
+WIFI_CURR_TH = 0.03
+CHUNK_BYTES = 1 << 20
+MAX_PLOT_POINTS = 20000
+
+TRC_MAGIC = 0x31435254
+TRC_HEADER = struct.Struct("<IIdQ")  # magic, version, interval_s, count
+
+TRP_MAGIC = 0x31505254
+TRP_HEADER = struct.Struct("<IIdQII")  # magic, version, interval_s, count, fanout, levels
+TRP_LEVEL = struct.Struct("<QQQ")  # offset, buckets, bucket_samples
+TRP_BUCKET = np.dtype([("min", "<f4"), ("max", "<f4"), ("mean", "<f4"), ("value", "<f4"), ("index", "<u4")])
+
+
+def iter_chunks(file_path, chunk_bytes=CHUNK_BYTES):
+    """Yield (samples, interval_s) with samples as numpy arrays, one chunk at a time.
+
+    interval_s is the trc header's, or None for csv.
+    """
+    stream = sys.stdin.buffer if file_path == "-" else open(file_path, "rb")
+    try:
+        head = stream.read(TRC_HEADER.size)
+        if len(head) == TRC_HEADER.size and TRC_HEADER.unpack(head)[0] == TRC_MAGIC:
+            _, _, interval, _ = TRC_HEADER.unpack(head)
+            carry = b""
+            while True:
+                block = stream.read(chunk_bytes)
+                if not block:
+                    break
+                block = carry + block
+                usable = len(block) - len(block) % 4
+                carry = block[usable:]
+                yield np.frombuffer(block[:usable], dtype="<f4").astype(np.float64), interval
+            return
+
+        # csv: a number may straddle two reads, so hold back the last token
+        carry = head
+        while True:
+            block = stream.read(chunk_bytes)
+            text = carry + block
+            if block:
+                cut = max(text.rfind(b","), text.rfind(b"\n"), text.rfind(b" "))
+                if cut < 0:
+                    carry = text
+                    continue
+                text, carry = text[:cut], text[cut + 1:]
+            tokens = text.replace(b"\n", b",").replace(b" ", b",").split(b",")
+            samples = np.array([float(t) for t in tokens if t.strip()])
+            if samples.size:
+                yield samples, None
+            if not block:
+                break
+    finally:
+        if stream is not sys.stdin.buffer:
+            stream.close()
+
+
+class Envelope:
+    """Min/max of every stride samples; stride doubles to stay within max_points."""
+
+    def __init__(self, max_points=MAX_PLOT_POINTS):
+        self.max_points = max_points
+        self.stride = 1
+        self.count = 0
+        self.mins = np.empty(0)
+        self.maxs = np.empty(0)
+
+    def push(self, x):
+        bucket = (self.count + np.arange(x.size)) // self.stride
+        starts = np.flatnonzero(np.r_[True, bucket[1:] != bucket[:-1]])
+        mins = np.minimum.reduceat(x, starts)
+        maxs = np.maximum.reduceat(x, starts)
+
+        # The first bucket may continue the last one
+        if self.mins.size and bucket[0] == self.mins.size - 1:
+            self.mins[-1] = min(self.mins[-1], mins[0])
+            self.maxs[-1] = max(self.maxs[-1], maxs[0])
+            mins, maxs = mins[1:], maxs[1:]
+        self.mins = np.concatenate([self.mins, mins])
+        self.maxs = np.concatenate([self.maxs, maxs])
+        self.count += x.size
+
+        while self.mins.size > self.max_points:
+            self._fold()
+
+    def _fold(self):
+        mins, maxs = self.mins, self.maxs
+        if mins.size % 2:
+            mins, maxs = np.append(mins, mins[-1]), np.append(maxs, maxs[-1])
+        self.mins = np.minimum(mins[0::2], mins[1::2])
+        self.maxs = np.maximum(maxs[0::2], maxs[1::2])
+        self.stride *= 2
+
+
+class Pyramid:
+    """Memory-mapped zoom pyramid (host/trace/trace_pyramid.h)."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            head = f.read(TRP_HEADER.size)
+            magic, _, self.interval, self.count, self.fanout, levels = TRP_HEADER.unpack(head)
+            if magic != TRP_MAGIC:
+                raise ValueError(f"{path}: not a pyramid")
+            table = f.read(TRP_LEVEL.size * levels)
+        self.path = path
+        self.levels = [TRP_LEVEL.unpack_from(table, i * TRP_LEVEL.size) for i in range(levels)]
+
+    def select(self, first, last, width):
+        """Coarsest level with at least width buckets in [first, last), or None for raw samples."""
+        span = max(last - first, 1)
+        for level in reversed(range(len(self.levels))):
+            if span // self.levels[level][2] >= width:
+                return level
+        return None
+
+    def buckets(self, level, first, last):
+        """Buckets of level covering samples [first, last) and their first sample index."""
+        offset, count, size = self.levels[level]
+        lo = first // size
+        hi = min(-(-last // size), count)
+        mapped = np.memmap(self.path, dtype=TRP_BUCKET, mode="r", offset=offset, shape=(count,))
+        return np.array(mapped[lo:hi]), np.arange(lo, hi) * size
+
+
+def trc_window(trc_path, first, last):
+    """Samples [first, last) of a trc file, mapped rather than read."""
+    samples = np.memmap(trc_path, dtype="<f4", mode="r", offset=TRC_HEADER.size)
+    return np.array(samples[first:last], dtype=np.float64)
+
+
+def find_pyramid(file_path):
+    if file_path == "-":
+        return None
+    base = file_path.rsplit(".", 1)[0]
+    trp = file_path if file_path.endswith(".trp") else base + ".trp"
+    return trp if os.path.exists(trp) else None
+
+
+def plot_pyramid(trp_path, sample_interval=None, voltage=VOLTAGE, start=None, end=None, width=MAX_PLOT_POINTS):
+    pyramid = Pyramid(trp_path)
+    interval = sample_interval or pyramid.interval or SAMPLE_INTERVAL
+    first = int(round(start / interval)) if start else 0
+    last = min(int(round(end / interval)) if end else pyramid.count, pyramid.count)
+    first = min(first, max(last - 1, 0))
+    level = pyramid.select(first, last, width)
+
     plt.figure(figsize=(20, 10))
-    plt.plot(time_axis, samples, marker='.', linestyle='-', markersize=1, alpha=0.8)
-    plt.xlabel("Sample Index")
-    plt.ylabel("Value")
-    plt.title("Current Measurements")
+    if level is None:
+        base = trp_path.rsplit(".", 1)[0]
+        samples = trc_window(base + ".trc", first, last)
+        time_axis = (first + np.arange(samples.size)) * interval
+        plt.plot(time_axis, samples, marker='.', linestyle='-', markersize=1, alpha=0.8)
+        shown = "raw samples"
+    else:
+        buckets, starts = pyramid.buckets(level, first, last)
+        plt.fill_between(starts * interval, buckets["min"], buckets["max"], step="post", alpha=0.5, linewidth=0.5)
+        plt.plot(buckets["index"] * interval, buckets["value"], linestyle='-', linewidth=0.5)
+        shown = f"level {level}, {pyramid.levels[level][2]} samples per bucket"
+    plt.xlabel("Time (s)")
+    plt.ylabel("Current (A)")
+    plt.title(f"Current Measurements ({last - first} of {pyramid.count} samples, {shown})")
     plt.grid(True)
-    plt.xticks(np.linspace(0, max(time_axis), num=7))
+    plt.xticks(np.linspace(first * interval, last * interval, num=7))
 
-    png_path = file_path.rsplit(".", 1)[0] + ".png"
-    
-    # Save the plot instead of showing it
-    plt.savefig(png_path)
+    suffix = f"_{first * interval:g}-{last * interval:g}s" if start or end else ""
+    plt.savefig(trp_path.rsplit(".", 1)[0] + suffix + ".png")
     plt.close()
 
-    voltage = 5
+    # The top level's means give the total without touching the samples
+    size = pyramid.levels[-1][2]
+    top, starts = pyramid.buckets(len(pyramid.levels) - 1, 0, pyramid.count)
+    weights = np.minimum(size, pyramid.count - starts)
+    total_sum = float((top["mean"].astype(np.float64) * weights).sum())
+
+    print("Samples: ", pyramid.count, f"({pyramid.count * interval:.3f} s)")
+    print("Shown: ", shown)
+    print("Total energy consumption: ", total_sum * interval * voltage, "J")
+
+
+def plot_samples(file_path, sample_interval=None, voltage=VOLTAGE, wifi_curr_th=WIFI_CURR_TH):
+    envelope = Envelope()
+    total_sum = 0.0
+    low_sum, low_count = 0.0, 0
+    high_sum, high_count = 0.0, 0
+    trc_interval = None
+
+    for samples, interval in iter_chunks(file_path):
+        trc_interval = interval
+        envelope.push(samples)
+        total_sum += samples.sum()
+        above = samples > wifi_curr_th
+        high_sum += samples[above].sum()
+        high_count += int(above.sum())
+        low_sum += samples[~above].sum()
+        low_count += int((~above).sum())
 
-    wifi_curr_th = 0.03
+    if sample_interval is None:
+        sample_interval = trc_interval or SAMPLE_INTERVAL
+    num_samples = envelope.count
+    if num_samples == 0:
+        print(f"{file_path}: no samples")
+        return
 
-    cpu_curr = np.average(samples[samples <= wifi_curr_th])
+    time_axis = np.arange(envelope.mins.size) * envelope.stride * sample_interval
 
-    total_energy = np.sum(samples) * sample_interval * voltage
-    wifi_energy = np.sum((samples[samples > wifi_curr_th]-cpu_curr)) * sample_interval * voltage
-    
+    # Plot the envelope; at full resolution it is the trace itself
+    plt.figure(figsize=(20, 10))
+    if envelope.stride == 1:
+        plt.plot(time_axis, envelope.maxs, marker='.', linestyle='-', markersize=1, alpha=0.8)
+    else:
+        plt.fill_between(time_axis, envelope.mins, envelope.maxs, step="post", alpha=0.8, linewidth=0.5)
+    plt.xlabel("Time (s)")
+    plt.ylabel("Current (A)")
+    plt.title(f"Current Measurements ({num_samples} samples)")
+    plt.grid(True)
+    plt.xticks(np.linspace(0, num_samples * sample_interval, num=7))
+
+    if file_path != "-":
+        png_path = file_path.rsplit(".", 1)[0] + ".png"
+        # Save the plot instead of showing it
+        plt.savefig(png_path)
+    plt.close()
+
+    cpu_curr = low_sum / low_count if low_count else float("nan")
+
+    total_energy = total_sum * sample_interval * voltage
+    wifi_energy = (high_sum - high_count * cpu_curr) * sample_interval * voltage
+
+    print("Samples: ", num_samples, f"({num_samples * sample_interval:.3f} s)")
     print("Average Operating Current: ", cpu_curr, "A")
     print("Total energy consumption: ", total_energy, "J")
     print("Wifi energy consumption: ", wifi_energy, "J") # include both listen and transmit
 
-# Example usage
-file_path = "random_4-2.csv"  # Replace with actual file path
-plot_samples(file_path)
\ No newline at end of file
+
+def main():
+    parser = argparse.ArgumentParser(description="Plot current traces and print their energy breakdown")
+    parser.add_argument("traces", nargs="*", default=["random_4-2.csv"], help="csv or trc files, - for stdin")
+    parser.add_argument("--interval", type=float, help="sample interval in ms (default: trc header or 0.6)")
+    parser.add_argument("--voltage", type=float, default=VOLTAGE)
+    parser.add_argument("--threshold", type=float, default=WIFI_CURR_TH, help="wifi current threshold in A")
+    parser.add_argument("--start", type=float, help="window start in s (pyramid only)")
+    parser.add_argument("--end", type=float, help="window end in s (pyramid only)")
+    parser.add_argument("--width", type=int, default=MAX_PLOT_POINTS, help="points to draw from a pyramid")
+    parser.add_argument("--stream", action="store_true", help="ignore pyramids and read the whole trace")
+    args = parser.parse_args()
+
+    for file_path in args.traces:
+        interval = args.interval * 1e-3 if args.interval else None
+        trp = None if args.stream else find_pyramid(file_path)
+        if trp is not None:
+            plot_pyramid(trp, interval, args.voltage, args.start, args.end, args.width)
+        else:
+            plot_samples(file_path, interval, args.voltage, args.threshold)
+
+
+if __name__ == "__main__":
+    main()
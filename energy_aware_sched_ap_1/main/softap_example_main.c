@@ -5,6 +5,7 @@
  * and processes data packets from connected stations.
  */
 
+#include <stdio.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -19,15 +20,18 @@
 #include "lwip/err.h"
 #include "lwip/sys.h"
 
+#include "sched_types.h"
+#include "frame_codec.h"
+#include "record_schema.h"
+#include "frame_export.h"
+
 /* WiFi configuration */
 #define EXAMPLE_ESP_WIFI_SSID      CONFIG_ESP_WIFI_SSID
 #define EXAMPLE_ESP_WIFI_PASS      CONFIG_ESP_WIFI_PASSWORD
 #define EXAMPLE_ESP_WIFI_CHANNEL   CONFIG_ESP_WIFI_CHANNEL
 #define EXAMPLE_MAX_STA_CONN       CONFIG_ESP_MAX_STA_CONN
 
-/* Packet receiver configuration */
-#define MAX_CLASSES                4     // 3 classes (Class 1: 3s, Class 2: 5s, Class 3: 6s)
-#define MAX_PACKET_SIZE           1400   // Maximum packet data size
+/* Packet receiver configuration (class and size limits come from sched_types.h) */
 #define PROMISCUOUS_FILTER_MASK   WIFI_PROMIS_FILTER_MASK_DATA  // Only receive data frames
 #define RX_TASK_STACK_SIZE        4096
 #define RX_TASK_PRIORITY          5
@@ -37,30 +41,11 @@ static const char *TAG = "wifi-ap-receiver";
 /* Add a reception counter to track packet sequence */
 static uint32_t rx_packet_counter = 0;
 
-/* Class definitions */
-typedef enum {
-    CLASS_1 = 0,                 // Class 1: 3-second period
-    CLASS_2 = 1,                 // Class 2: 5-second period
-    CLASS_3 = 2,                 // Class 3: 6-second period
-    CLASS_RANDOM = 3,
-} class_id_t;
-
-/* Data type definitions */
-typedef enum {
-    DATA_TYPE_INT8 = 0,          // 8-bit integer
-    DATA_TYPE_INT16 = 1,         // 16-bit integer
-    DATA_TYPE_INT32 = 2,         // 32-bit integer
-    DATA_TYPE_FLOAT = 3,         // 32-bit float
-    DATA_TYPE_DOUBLE = 4,        // 64-bit double
-} data_type_t;
+/* Decoded values of the class being processed (every value takes at least one byte) */
+static double class_samples[MAX_PACKET_SIZE];
 
-/* Updated data packet header (now includes all necessary information) */
-typedef struct {
-    uint8_t class_counts[MAX_CLASSES];      // Number of items for each class
-    data_type_t class_types[MAX_CLASSES];   // Data type for each class
-    uint16_t total_size;                    // Total size of all data in bytes
-    uint32_t timestamp;                     // Transmission timestamp
-} __attribute__((packed)) data_packet_header_t;
+/* Sample capture times reconstructed from the frame being processed */
+static sample_times_t frame_times;
 
 /* Receiver context */
 typedef struct {
@@ -84,7 +69,8 @@ static receiver_context_t receiver_ctx;
 /* Function prototypes */
 static void receiver_task(void *pvParameters);
 static void wifi_promiscuous_rx_cb(void *buf, wifi_promiscuous_pkt_type_t type);
-static void process_data_packet(const uint8_t *data, size_t length);
+static void process_data_packet(const frame_view_t *view);
+static void export_frame(const uint8_t *frame, const frame_view_t *view, int8_t rssi);
 
 /* Get the current time in milliseconds */
 static uint32_t get_current_time_ms(void)
@@ -187,7 +173,7 @@ void wifi_init_softap(void)
     strncpy((char*)wifi_config.ap.ssid, wifi_ssid, sizeof(wifi_config.ap.ssid) - 1);
     wifi_config.ap.ssid_len = strlen(wifi_ssid);
     strncpy((char*)wifi_config.ap.password, wifi_password, sizeof(wifi_config.ap.password) - 1);
-
+    
     if (strlen(wifi_password) == 0) {
         wifi_config.ap.authmode = WIFI_AUTH_OPEN;
     }
@@ -223,7 +209,6 @@ static void enable_promiscuous_mode(void)
     ESP_LOGI(TAG, "Promiscuous mode enabled successfully");
 }
 
-/* WiFi promiscuous mode callback */
 /* WiFi promiscuous mode callback */
 static void wifi_promiscuous_rx_cb(void *buf, wifi_promiscuous_pkt_type_t type)
 {
@@ -238,186 +223,119 @@ static void wifi_promiscuous_rx_cb(void *buf, wifi_promiscuous_pkt_type_t type)
     // Update current time
     receiver_ctx.current_time_ms = get_current_time_ms();
     
-    // Basic validation - we need at least 24 bytes for the basic 802.11 header
-    if (pkt_len < 24) {
-        ESP_LOGD(TAG, "Packet too small for 802.11 header: %d bytes", pkt_len);
-        return;
-    }
-    
-    // We need at least enough data for header + our data packet header
-    if (pkt_len < 24 + sizeof(data_packet_header_t)) {
-        ESP_LOGD(TAG, "Packet too small for data packet header: %d bytes", pkt_len);
-        return;
-    }
-    
-    // Parse 802.11 header
-    uint8_t frame_control_1 = payload[0];
-    uint8_t frame_control_2 = payload[1];
-    uint8_t frame_type = (frame_control_1 & 0x0C);
-    uint8_t from_ds = (frame_control_2 & 0x02) >> 1;
-    uint8_t to_ds = (frame_control_2 & 0x01);
-    
-    // Check if this is a data frame (type = 0x08) with proper flags
-    // For AP receiving, we want packets from stations (to_ds=1, from_ds=0)
-    if (frame_type != 0x08 || from_ds != 0 || to_ds != 1) {
-        return;  // Not a data frame from station to AP
-    }
-    
-    // Extract MAC addresses from header to check if this packet is intended for us
-    uint8_t destination_mac[6];
-    memcpy(destination_mac, &payload[4], 6);
-
     // Get our MAC address
     uint8_t our_mac[6];
     esp_wifi_get_mac(WIFI_IF_AP, our_mac);
     
-    // Check if packet is for us or broadcast
-    bool is_for_us = true;
-    bool is_broadcast = true;
+    // Validate the frame once; the view carries per-class offsets for decoding
+    frame_view_t view;
+    frame_status_t status = frame_parse(payload, pkt_len, our_mac, &view);
     
-    for (int i = 0; i < 6; i++) {
-        if (destination_mac[i] != our_mac[i]) {
-            is_for_us = false;
-        }
-        if (destination_mac[i] != 0xFF) {
-            is_broadcast = false;
-        }
+    switch (status) {
+        case FRAME_OK:
+            break;
+        case FRAME_ERR_TOO_SHORT:
+        case FRAME_ERR_NOT_TO_DS:
+        case FRAME_ERR_NOT_FOR_US:
+            return;  // Not a data frame from a station to us
+        default:
+            ESP_LOGW(TAG, "Invalid data packet header: %s (total size %d)",
+                     frame_status_name(status), view.header->total_size);
+            if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+                receiver_ctx.error_packets++;
+                xSemaphoreGive(receiver_ctx.mutex);
+            }
+            return;
     }
     
-    if (!is_for_us && !is_broadcast) {
-        return;  // Packet not intended for us
+    // Increment packet count only for valid packets
+    if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        receiver_ctx.packets_received++;
+        xSemaphoreGive(receiver_ctx.mutex);
     }
     
-    // Skip the 802.11 header (24 bytes) to get to our payload
-    const uint8_t *data = payload + 24;
-    size_t data_len = pkt_len - 24;
+#ifdef CONFIG_AP_EXPORT_FRAMES
+    export_frame(payload, &view, pkt->rx_ctrl.rssi);
+#endif
     
-    // Basic size validation for our header
-    if (data_len < sizeof(data_packet_header_t)) {
-        if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-            receiver_ctx.error_packets++;
-            xSemaphoreGive(receiver_ctx.mutex);
+    // Schema announcements define record layouts used by later data frames
+    if (view.kind == FRAME_KIND_SCHEMA) {
+        uint32_t conflicts = record_schema_conflicts();
+        int loaded = record_schema_unpack(view.payload, view.payload_len);
+        if (loaded < 0) {
+            ESP_LOGW(TAG, "Malformed schema announcement (%d bytes)", view.payload_len);
+        } else {
+            if (record_schema_conflicts() != conflicts) {
+                ESP_LOGW(TAG, "Schema conflicts with an announced layout; "
+                         "records of that ID are no longer decoded (%lu conflicts)",
+                         record_schema_conflicts());
+            }
+            ESP_LOGD(TAG, "Schema announcement: %d schema(s)", loaded);
         }
-        ESP_LOGW(TAG, "Received packet too small: %d bytes (expected at least %d)", 
-                data_len, sizeof(data_packet_header_t));
         return;
     }
     
-    // Do a basic validation of the data packet header
-    const data_packet_header_t *header = (const data_packet_header_t *)data;
+    // Process the data packet
+    process_data_packet(&view);
+}
+
+/* Print a validated frame for the host collector (see frame_export.h) */
+static void export_frame(const uint8_t *frame, const frame_view_t *view, int8_t rssi)
+{
+    static char line[FRAME_EXPORT_LINE_MAX(FRAME_MAX_LEN + WIFI_HTC_LEN)];
     
-    // Validate total size is reasonable
-    if (header->total_size > MAX_PACKET_SIZE) {
-        ESP_LOGW(TAG, "Invalid total size in header: %d (max allowed: %d)", 
-                 header->total_size, MAX_PACKET_SIZE);
-        if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-            receiver_ctx.error_packets++;
-            xSemaphoreGive(receiver_ctx.mutex);
-        }
-        return;
+    // Only the bytes the header and CRC trailer account for; sig_len also counts the FCS
+    if (frame_export_format(line, sizeof(line), receiver_ctx.current_time_ms, rssi,
+                            frame, view->frame_len) > 0) {
+        printf("%s\n", line);
     }
+}
+
+/* Format decoded record fields as "a, b, c" */
+static void format_values(char *out, size_t out_len, const double *values, int count)
+{
+    size_t pos = 0;
+    out[0] = '\0';
     
-    // Validate class types
-    bool valid_types = true;
-    for (int i = 0; i < MAX_CLASSES; i++) {
-        if (header->class_types[i] > DATA_TYPE_DOUBLE) {
-            valid_types = false;
+    for (int i = 0; i < count && pos < out_len; i++) {
+        int n = snprintf(out + pos, out_len - pos, i == 0 ? "%g" : ", %g", values[i]);
+        if (n < 0) {
             break;
         }
+        pos += n;
     }
-    
-    if (!valid_types) {
-        ESP_LOGW(TAG, "Invalid class types in header");
-        if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-            receiver_ctx.error_packets++;
-            xSemaphoreGive(receiver_ctx.mutex);
-        }
-        return;
-    }
-    
-    // Check if we have enough data for header + payload
-    if (data_len < sizeof(data_packet_header_t) + header->total_size) {
-        ESP_LOGW(TAG, "Insufficient data: header indicates %d data bytes, packet has %d bytes available",
-                 header->total_size, data_len - sizeof(data_packet_header_t));
-    }
-    
-    // Increment packet count only for valid packets
-    if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-        receiver_ctx.packets_received++;
-        xSemaphoreGive(receiver_ctx.mutex);
-    }
-    
-    // Process the data packet
-    process_data_packet(data, data_len);
 }
 
-/* Process a data packet */
-/* Process a data packet */
-static void process_data_packet(const uint8_t *data, size_t length)
+/* Process a validated data packet */
+static void process_data_packet(const frame_view_t *view)
 {
     rx_packet_counter++;
-    // Make sure the packet is at least as large as our header
-    if (length < sizeof(data_packet_header_t)) {
-        ESP_LOGE(TAG, "Data packet too small: %d bytes (minimum size: %d)", 
-                 length, sizeof(data_packet_header_t));
-        return;
-    }
-    
-    // Cast to data packet header structure
-    const data_packet_header_t *header = (const data_packet_header_t *)data;
+    const data_packet_header_t *header = view->header;
     
-    // Validate total size
-    if (header->total_size > MAX_PACKET_SIZE) {
-        ESP_LOGE(TAG, "Invalid total size in header: %d (max allowed: %d)", 
-                 header->total_size, MAX_PACKET_SIZE);
-        return;
-    }
-    
-    // Validate class types (must be between 0-4)
-    for (int i = 0; i < MAX_CLASSES; i++) {
-        if (header->class_types[i] > DATA_TYPE_DOUBLE) {
-            ESP_LOGE(TAG, "Invalid class type for class %d: %d", i, header->class_types[i]);
-            return;
-        }
+    // Verify the total size in header matches the class counts and types
+    if (!(header->flags & FRAME_FLAG_SAMPLE_TIMES) && view->expected_size != header->total_size) {
+        ESP_LOGW(TAG, "Size mismatch: header says %d, calculated %d", 
+                 header->total_size, view->expected_size);
     }
     
-    // Calculate expected total data size based on class counts and types
-    uint16_t expected_size = 0;
-    for (int i = 0; i < MAX_CLASSES; i++) {
-        if (header->class_counts[i] > 0) {
-            uint16_t element_size = 0;
-            switch (header->class_types[i]) {
-                case DATA_TYPE_INT8:   element_size = 1; break;
-                case DATA_TYPE_INT16:  element_size = 2; break;
-                case DATA_TYPE_INT32:  
-                case DATA_TYPE_FLOAT:  element_size = 4; break;
-                case DATA_TYPE_DOUBLE: element_size = 8; break;
-                default:               element_size = 0; break;  // Should not happen after validation
-            }
-            expected_size += element_size * header->class_counts[i];
+    // Reconstruct per-sample capture times if the station sent them
+    bool have_times = false;
+    if (view->time_block != NULL) {
+        have_times = sample_time_decode(view->time_block, view->time_block_len,
+                                        header->timestamp, &frame_times);
+        if (!have_times) {
+            ESP_LOGW(TAG, "Malformed sample time block (%d bytes)", view->time_block_len);
         }
     }
     
-    // Verify the total size in header matches our calculation
-    if (expected_size != header->total_size) {
-        ESP_LOGW(TAG, "Size mismatch: header says %d, calculated %d", 
-                 header->total_size, expected_size);
-    }
-    
-    // Verify actual received data size matches or exceeds what we need
-    if (length - sizeof(data_packet_header_t) < header->total_size) {
-        ESP_LOGW(TAG, "Data packet size mismatch: expected %d, got %d",
-                 header->total_size, length - sizeof(data_packet_header_t));
-        // We'll continue processing what we can
-    }
-
     // Print transmission summary (matching the station's output format)
     ESP_LOGI(TAG, "=============================================================");
     ESP_LOGI(TAG, "Received packet #%lu", rx_packet_counter);
     ESP_LOGI(TAG, "  Total data size: %d bytes", header->total_size);
-    // ESP_LOGI(TAG, "  Transmission timestamp: %lu", header->timestamp);
-    // ESP_LOGI(TAG, "  Reception timestamp: %lu", current_time);
-    // ESP_LOGI(TAG, "  Latency: %lu ms", latency);
+    if (view->qos) {
+        ESP_LOGI(TAG, "  QoS data frame: AC=%s, TID=%d",
+                 wmm_ac_name(view->access_category), view->tid);
+    }
     
     // Store class information from the packet
     if (xSemaphoreTake(receiver_ctx.mutex, portMAX_DELAY) == pdTRUE) {
@@ -431,9 +349,6 @@ static void process_data_packet(const uint8_t *data, size_t length)
         xSemaphoreGive(receiver_ctx.mutex);
     }
     
-    // Get data pointer (after header)
-    const uint8_t *payload = data + sizeof(data_packet_header_t);
-    
     // Calculate latency (time from transmission to reception)
     uint32_t current_time = get_current_time_ms();
     uint32_t packet_timestamp = header->timestamp;
@@ -454,54 +369,44 @@ static void process_data_packet(const uint8_t *data, size_t length)
     }
     
     ESP_LOGI(TAG, "Received data packet: Class1=%d(%d), Class2=%d(%d), Class3=%d(%d), Random=%d(%d), Size=%d, Latency=%lu ms",
-          header->class_counts[0], header->class_types[0],
-          header->class_counts[1], header->class_types[1],
-          header->class_counts[2], header->class_types[2],
-          header->class_counts[3], header->class_types[3],
-          header->total_size, latency);
-    
-    // Process the data for each class
-    const uint8_t *class_data = payload;
+         header->class_counts[0], header->class_types[0],
+         header->class_counts[1], header->class_types[1],
+         header->class_counts[2], header->class_types[2],
+         header->class_counts[3], header->class_types[3],
+         header->total_size, latency);
     
-    // Process each class's data
+    // Process each class's data using the offsets computed during validation
     for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
         if (header->class_counts[class_id] == 0) {
             continue;  // No data for this class
         }
         
-        // Calculate element size based on data type
-        uint16_t element_size = 0;
-        switch (header->class_types[class_id]) {
-            case DATA_TYPE_INT8:   element_size = 1; break;
-            case DATA_TYPE_INT16:  element_size = 2; break;
-            case DATA_TYPE_INT32:
-            case DATA_TYPE_FLOAT:  element_size = 4; break;
-            case DATA_TYPE_DOUBLE: element_size = 8; break;
-            default:
-                ESP_LOGE(TAG, "Unexpected data type %d for class %d", 
-                        header->class_types[class_id], class_id);
-                continue;  // Skip this class
-        }
-        
-        // Calculate total size for this class
-        uint16_t class_size = element_size * header->class_counts[class_id];
+        data_type_t class_type = header->class_types[class_id];
+        uint8_t count = header->class_counts[class_id];
+        uint8_t fields = class_type_fields(class_type);
+        class_type_widen(class_type, class_samples,
+                         view->payload + view->class_offset[class_id], count);
         
-        // Make sure we have enough data
-        size_t remaining_bytes = (payload + header->total_size) - class_data;
-        if (remaining_bytes < class_size) {
-            ESP_LOGW(TAG, "Not enough data for class %d: need %d bytes, have %d",
-                     class_id, class_size, remaining_bytes);
-            break;  // Stop processing
+        if (data_type_is_schema(class_type)) {
+            // Show the first and last record field by field
+            char first[64], last[64];
+            format_values(first, sizeof(first), class_samples, fields);
+            format_values(last, sizeof(last), &class_samples[(count - 1) * fields], fields);
+            ESP_LOGI(TAG, "  Class %d data (%d records, schema %d): first=(%s), last=(%s)",
+                     class_id + 1, count, data_type_schema_id(class_type), first, last);
+        } else {
+            ESP_LOGI(TAG, "  Class %d data (%d elements, type %s): first=%g, last=%g",
+                     class_id + 1, count, data_type_name(class_type),
+                     class_samples[0], class_samples[count - 1]);
         }
         
-        // Process based on data type
-        ESP_LOGI(TAG, "  Class %d data (%d elements, type %d):",
-                 class_id + 1, header->class_counts[class_id], header->class_types[class_id]);
-        
-        
-        
-        // Move to next class's data
-        class_data += class_size;
+        uint32_t first_time, last_time;
+        if (have_times &&
+            sample_time_at(&frame_times, class_id, 0, &first_time) &&
+            sample_time_at(&frame_times, class_id, count - 1, &last_time)) {
+            ESP_LOGI(TAG, "    Sampled at %lu..%lu ms (%d groups)",
+                     first_time, last_time, frame_times.groups[class_id]);
+        }
     }
      ESP_LOGI(TAG, "=============================================================");
 }
@@ -18,10 +18,10 @@
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
-// #include "types.h"
 #include "terminal_cmd.h"
-#include "msgqueue.h"
 #include "packet_generator.h"
+#include "sched_core.h"
+#include "frame_codec.h"
 
 
 /* WiFi configuration */
@@ -29,13 +29,9 @@
 #define EXAMPLE_ESP_WIFI_PASS      CONFIG_ESP_WIFI_PASSWORD
 #define EXAMPLE_ESP_MAXIMUM_RETRY  CONFIG_ESP_MAXIMUM_RETRY
 
-/* Scheduler Configuration */
-// #define MAX_CLASSES              3     // 3 classes (Class 1: 3s, Class 2: 5s, Class 3: 6s)
-#define MAX_PACKET_SIZE          1400  // Maximum packet data size
-#define MAX_QUEUE_SIZE           50    // Maximum packets per queue
+/* Scheduler Configuration (queue and buffer sizes come from sched_types.h) */
 #define SCHEDULER_CHECK_INTERVAL_MS 50 // How often to check queues
 #define DEADLINE_PROCESSING_THRESHOLD_MS 10000 // Process if deadline is within this threshold
-#define MAX_TX_SIZE              1400  // Maximum data size for transmission buffer
 #define MAX_POINT_SIZE           50
 
 /* FreeRTOS event group to signal when we are connected */
@@ -51,7 +47,6 @@ static uint32_t tx_packet_counter = 1;
 
 static const char *TAG = "wifi-sta-sender";
 
-static const uint16_t Type_Size[NUM_DATA_TYPE] = {sizeof(int8_t), sizeof(int16_t), sizeof(int32_t), sizeof(float), sizeof(double)};
 // static uint32_t Class_Period[MAX_CLASSES] = {3000, 5000, 6000};
 // static uint32_t Class_Deadlines[MAX_CLASSES] = {3000, 5000, 6000};
 // static data_type_t Class_Types[] = {DATA_TYPE_INT32, DATA_TYPE_FLOAT, DATA_TYPE_INT16};
@@ -60,31 +55,12 @@ static const uint16_t Type_Size[NUM_DATA_TYPE] = {sizeof(int8_t), sizeof(int16_t
 static int s_retry_num = 0;
 
 
-/* Updated data packet header (now includes all necessary information) */
-typedef struct {
-    uint8_t class_counts[MAX_CLASSES];      // Number of items for each class
-    data_type_t class_types[MAX_CLASSES];   // Data type for each class
-    uint16_t total_size;                    // Total size of all data in bytes
-    uint32_t timestamp;                     // Transmission timestamp
-} __attribute__((packed)) data_packet_header_t;
-
 /* Scheduler context */
 typedef struct {
-    packet_queue_t packet_queues[MAX_CLASSES]; // Separate queue for each class
+    sched_core_t core;            // Queues, class configuration and statistics
     SemaphoreHandle_t mutex;      // Mutex for operations
     TaskHandle_t scheduler_task;  // Scheduler task handle
     TaskHandle_t packet_creator_task; // Packet creator task handle
-    
-    // Class information
-    data_type_t class_types[MAX_CLASSES]; // Data type for each class
-    uint32_t class_periods[MAX_CLASSES];   // Period for each class (ms)
-    uint32_t class_deadlines[MAX_CLASSES]; // Deadline for each class (ms)
-    uint32_t processing_threshold; 
-
-    // Statistics
-    uint32_t packets_processed;   // Total packets processed
-    uint32_t packets_transmitted; // Packets successfully transmitted
-    uint32_t deadline_misses;     // Packets that missed deadlines
     uint32_t current_time_ms;     // Current time in milliseconds
 } scheduler_context_t;
 
@@ -94,7 +70,7 @@ static scheduler_context_t scheduler_ctx;
 /* Function prototypes */
 static void scheduler_task(void *pvParameters);
 static void process_packets(void);
-static esp_err_t send_data_packet(uint8_t *data, uint16_t size, uint8_t class_counts[MAX_CLASSES]);
+static esp_err_t send_data_packet(uint8_t *data, uint16_t size, const uint8_t class_counts[MAX_CLASSES]);
 static void random_packet_task(void *pvParameters);
 
 
@@ -114,18 +90,7 @@ static uint32_t find_earliest_deadline(void)
         return earliest_deadline;
     }
     
-    // Check each class queue
-    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
-        packet_queue_t *queue = &scheduler_ctx.packet_queues[class_id];
-        
-        // If queue is not empty, check the first packet's deadline
-        if (queue->head != NULL) {
-            uint32_t deadline = queue->head->packet.deadline;
-            if (deadline < earliest_deadline) {
-                earliest_deadline = deadline;
-            }
-        }
-    }
+    earliest_deadline = sched_core_earliest_deadline(&scheduler_ctx.core);
     
     xSemaphoreGive(scheduler_ctx.mutex);
     return earliest_deadline;
@@ -269,67 +234,34 @@ esp_err_t scheduler_submit_packet(class_id_t class_id, const void *data, uint16_
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Get data type for this class
-    data_type_t data_type = scheduler_ctx.class_types[class_id];
-    
-    // Calculate size based on data type and count
-    uint16_t element_size = Type_Size[(int)data_type];
-    
-    uint16_t total_size = element_size * count;
-    if (total_size > MAX_PACKET_SIZE) {
-        ESP_LOGE(TAG, "Data too large: %d bytes (max: %d)", total_size, MAX_PACKET_SIZE);
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    // Create queue packet
-    queue_packet_t packet = {0};
-    
-    // Set class info
-    packet.class_id = class_id;
-    packet.data_type = data_type;
-    packet.data_count = count;
-    packet.size = total_size;
-    
-    // Set deadline based on class
     uint32_t current_time = get_current_time_ms();
-    packet.deadline = current_time + scheduler_ctx.class_deadlines[class_id];
-    // switch (class_id) {
-    //     case CLASS_1:
-    //         packet.deadline = current_time + Class_Deadlines[CLASS_1];  // 3 seconds
-    //         break;
-    //     case CLASS_2:
-    //         packet.deadline = current_time + Class_Deadlines[CLASS_2];  // 5 seconds
-    //         break;
-    //     case CLASS_3:
-    //         packet.deadline = current_time + Class_Deadlines[CLASS_3];  // 6 seconds
-    //         break;
-    // }
-    
-    // Copy data
-    if (data != NULL && total_size > 0) {
-        memcpy(packet.data, data, total_size);
-    }
+    sched_status_t status = SCHED_ERR_QUEUE_FULL;
     
     // Submit packet to the appropriate queue with mutex protection
     if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-        bool success = queue_enqueue(&scheduler_ctx.packet_queues[class_id], &packet);
+        status = sched_core_submit(&scheduler_ctx.core, class_id, data, count, current_time);
         xSemaphoreGive(scheduler_ctx.mutex);
-        
-        if (!success) {
-            ESP_LOGE(TAG, "Failed to queue packet: Queue %d full", class_id);
-            return ESP_FAIL;
-        }
     } else {
         return ESP_FAIL;
     }
     
-    // ESP_LOGI(TAG, "Queued Class %d packet: Type=%d, Count=%d, Size=%d, Deadline=%lu",
-    //          class_id + 1, data_type, count, total_size, packet.deadline);
-    
-    return ESP_OK;
+    switch (status) {
+        case SCHED_OK:
+            return ESP_OK;
+        case SCHED_ERR_TOO_LARGE:
+            ESP_LOGE(TAG, "Data too large: %d elements of type %s (max: %d bytes)",
+                     count, data_type_name(scheduler_ctx.core.class_types[class_id]), MAX_PACKET_SIZE);
+            return ESP_ERR_INVALID_ARG;
+        case SCHED_ERR_INVALID_ARG:
+            ESP_LOGE(TAG, "Invalid data type for class %d", class_id);
+            return ESP_ERR_INVALID_ARG;
+        default:
+            ESP_LOGE(TAG, "Failed to queue packet: Queue %d full", class_id);
+            return ESP_FAIL;
+    }
 }
 
-/* Process and transmit packets with fixed class order */
+/* Process and transmit packets using the configured batch policy */
 static void process_packets(void)
 {
     uint32_t current_time = get_current_time_ms();
@@ -344,7 +276,7 @@ static void process_packets(void)
     }
     
     // Check if we need to process now based on deadline threshold
-    if (earliest_deadline > current_time + scheduler_ctx.processing_threshold) {
+    if (earliest_deadline > current_time + scheduler_ctx.core.processing_threshold) {
         // ESP_LOGI(TAG, "Earliest deadline not approaching yet: %lu, current time: %lu", 
         //          earliest_deadline, current_time);
         return; // No urgency to process
@@ -360,72 +292,26 @@ static void process_packets(void)
         return;
     }
     
-    // Clear buffer
-    memset(data_buffer, 0, MAX_TX_SIZE);
-    uint8_t *data_ptr = data_buffer;
-    uint16_t remaining_space = MAX_TX_SIZE;
-    uint8_t class_counts[MAX_CLASSES] = {0};
+    // Drop expired packets and fill the buffer under the scheduler policy
+    sched_batch_t batch = {0};
+    if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        sched_core_build_batch(&scheduler_ctx.core, current_time, data_buffer, MAX_TX_SIZE, &batch);
+        xSemaphoreGive(scheduler_ctx.mutex);
+    }
     
-    // Process packets in FIXED CLASS ORDER: Class 1 → Class 2 → Class 3
-    // No matter what the deadlines are, we always maintain this order in the buffer
     for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
-        queue_packet_t packet;
-        bool packet_available = false;
-        
-        // Take mutex for queue operations
-        if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-            // Process all available packets from this class that fit in buffer
-            while (queue_peek(&scheduler_ctx.packet_queues[class_id], &packet)) {
-                // Check if packet fits in remaining space
-                if (packet.size > remaining_space) {
-                    // Stop processing this class if packet doesn't fit
-                    break;
-                }
-                
-                // Dequeue the packet
-                queue_dequeue(&scheduler_ctx.packet_queues[class_id], &packet);
-                packet_available = true;
-                
-                // Skip packets that missed deadline
-                if (current_time > packet.deadline) {
-                    ESP_LOGW(TAG, "Class %d packet missed deadline: Deadline=%lu, Current=%lu",
-                            class_id + 1, packet.deadline, current_time);
-                    
-                    scheduler_ctx.deadline_misses++;
-                    scheduler_ctx.packets_processed++;
-                    
-                    // Skip this packet (don't include in buffer)
-                    packet_available = false;
-                    continue;
-                }
-                
-                // We have a valid packet that fits, copy it to buffer
-                if (packet_available) {
-                    memcpy(data_ptr, packet.data, packet.size);
-                    data_ptr += packet.size;
-                    remaining_space -= packet.size;
-                    
-                    // Update class count (how many data items per class)
-                    class_counts[class_id] += packet.data_count;
-                    
-                    scheduler_ctx.packets_processed++;
-                    
-                    ESP_LOGI(TAG, "Added Class %d packet to transmission: Size=%d, Deadline=%lu",
-                            class_id + 1, packet.size, packet.deadline);
-                    
-                    // // If buffer is nearly full, stop adding more packets?
-                    // if (remaining_space < 100) {
-                    //     break;
-                    // }
-                }
-            }
-            
-            xSemaphoreGive(scheduler_ctx.mutex);
+        if (batch.class_misses[class_id] > 0) {
+            ESP_LOGW(TAG, "Class %d: %d packet(s) missed deadline, Current=%lu",
+                    class_id + 1, batch.class_misses[class_id], current_time);
+        }
+        if (batch.class_packets[class_id] > 0) {
+            ESP_LOGI(TAG, "Added %d Class %d packet(s) to transmission: Items=%d",
+                    batch.class_packets[class_id], class_id + 1, batch.class_counts[class_id]);
         }
     }
     
     // Calculate actual data size
-    uint16_t actual_data_size = MAX_TX_SIZE - remaining_space;
+    uint16_t actual_data_size = batch.size;
     
     // Count how many different classes were included
     ESP_LOGI(TAG, "======Sending buffer #%lu...=========", tx_packet_counter);
@@ -435,16 +321,11 @@ static void process_packets(void)
     
     // Send data if we have any
     if (actual_data_size > 0) {
-        esp_err_t ret = send_data_packet(data_buffer, actual_data_size, class_counts);
+        esp_err_t ret = send_data_packet(data_buffer, actual_data_size, batch.class_counts);
         
         if (ret == ESP_OK) {
             if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-                // Count how many class types were transmitted
-                scheduler_ctx.packets_transmitted += 
-                    (class_counts[0] > 0 ? 1 : 0) + 
-                    (class_counts[1] > 0 ? 1 : 0) + 
-                    (class_counts[2] > 0 ? 1 : 0) +
-                    (class_counts[3] > 0 ? 1 : 0);
+                sched_core_batch_sent(&scheduler_ctx.core, &batch);
                 xSemaphoreGive(scheduler_ctx.mutex);
             }
         }
@@ -457,7 +338,7 @@ static void process_packets(void)
 }
 
 /* Send the data packet with all class data and type information */
-static esp_err_t send_data_packet(uint8_t *data, uint16_t size, uint8_t class_counts[MAX_CLASSES])
+static esp_err_t send_data_packet(uint8_t *data, uint16_t size, const uint8_t class_counts[MAX_CLASSES])
 {
     // Increment the transmission counter
     tx_packet_counter++;
@@ -468,79 +349,47 @@ static esp_err_t send_data_packet(uint8_t *data, uint16_t size, uint8_t class_co
         size = MAX_TX_SIZE;  // Truncate to maximum
     }
     
-    // Create proper 802.11 data frame header
-    const size_t HEADER_SIZE = 24;  // Basic 802.11 header size
-    
     // Create data packet header
     data_packet_header_t header = {0};
     header.total_size = size;
     header.timestamp = get_current_time_ms();
     
     // Copy class counts and types
-    for (int i = 0; i < MAX_CLASSES; i++) {
-        header.class_counts[i] = class_counts[i];
-        
-        // Get class type from scheduler context
-        if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-            header.class_types[i] = scheduler_ctx.class_types[i];
-            xSemaphoreGive(scheduler_ctx.mutex);
-        }
-    }
-    
-    // Calculate total buffer size needed
-    size_t packet_size = HEADER_SIZE + sizeof(data_packet_header_t) + size;
-    
-    // Allocate buffer for 802.11 header + our header + data
-    uint8_t *packet_buffer = malloc(packet_size);
-    if (packet_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate packet buffer");
-        return ESP_FAIL;
+    memcpy(header.class_counts, class_counts, sizeof(header.class_counts));
+    if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(header.class_types, scheduler_ctx.core.class_types, sizeof(header.class_types));
+        xSemaphoreGive(scheduler_ctx.mutex);
     }
     
-    // Clear buffer to ensure all padding bytes are zero
-    memset(packet_buffer, 0, packet_size);
-    
-    // Setup 802.11 header
-    // Frame Control: Data frame (0x08) with FromDS=0, ToDS=1 (Station to AP)
-    packet_buffer[0] = 0x08;  // Data frame type
-    packet_buffer[1] = 0x01;  // FromDS=0, ToDS=1
-    
-    // Set destination address (AP MAC)
+    // Destination and BSSID are the AP; fall back to broadcast
+    frame_addr_t addr;
     wifi_ap_record_t ap_info;
     if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
-        memcpy(&packet_buffer[4], ap_info.bssid, 6);
+        memcpy(addr.da, ap_info.bssid, WIFI_MAC_LEN);
+        memcpy(addr.bssid, ap_info.bssid, WIFI_MAC_LEN);
     } else {
-        // Fallback to broadcast
-        memset(&packet_buffer[4], 0xFF, 6);
+        memset(addr.da, 0xFF, WIFI_MAC_LEN);
+        memset(addr.bssid, 0xFF, WIFI_MAC_LEN);
     }
     
     // Set source address - our own MAC address
-    uint8_t mac[6];
-    esp_wifi_get_mac(WIFI_IF_STA, mac);
-    memcpy(&packet_buffer[10], mac, 6);
+    esp_wifi_get_mac(WIFI_IF_STA, addr.sa);
     
-    // Set BSSID in the header as well
-    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
-        memcpy(&packet_buffer[16], ap_info.bssid, 6);
-    } else {
-        // Fallback
-        memset(&packet_buffer[16], 0xFF, 6);
+    // Allocate buffer for 802.11 header + our header + data + CRC trailer
+    size_t packet_size = WIFI_DATA_HEADER_LEN + sizeof(data_packet_header_t) + size + FRAME_CRC_LEN;
+    uint8_t *packet_buffer = malloc(packet_size);
+    if (packet_buffer == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate packet buffer");
+        return ESP_FAIL;
     }
     
+    packet_size = frame_build(packet_buffer, packet_size, &addr, &header, data);
+    
     // Debug: Log header size and data sizes
     ESP_LOGD(TAG, "Header size: %d, Data size: %d, Total packet size: %d", 
              sizeof(data_packet_header_t), size, packet_size);
     
-    // Copy our header after the 802.11 header
-    memcpy(packet_buffer + HEADER_SIZE, &header, sizeof(data_packet_header_t));
-    
-    // Copy data after our header
-    if (data != NULL && size > 0) {
-        memcpy(packet_buffer + HEADER_SIZE + sizeof(data_packet_header_t), data, size);
-    }
-    
     // Send packet
-    //ESP_LOGI(TAG, "Sending buffer #%lu...", tx_packet_counter);
     esp_err_t ret = esp_wifi_80211_tx(WIFI_IF_STA, 
                                      packet_buffer, 
                                      packet_size, 
@@ -644,14 +493,14 @@ void print_scheduler_stats(void)
     }
     
     // ESP_LOGI(TAG, "->Scheduler Statistics:");
-    // ESP_LOGI(TAG, "  Packets processed: %lu", scheduler_ctx.packets_processed);
-    // ESP_LOGI(TAG, "  Packets transmitted: %lu", scheduler_ctx.packets_transmitted);
-    // ESP_LOGI(TAG, "  Deadline misses: %lu", scheduler_ctx.deadline_misses);
+    // ESP_LOGI(TAG, "  Packets processed: %lu", scheduler_ctx.core.packets_processed);
+    // ESP_LOGI(TAG, "  Packets transmitted: %lu", scheduler_ctx.core.packets_transmitted);
+    // ESP_LOGI(TAG, "  Deadline misses: %lu", scheduler_ctx.core.deadline_misses);
     
     // Queue status
     int queue_length[MAX_CLASSES];
     for (int i = 0; i < MAX_CLASSES; i++) {
-        queue_length[i] = scheduler_ctx.packet_queues[i].count;
+        queue_length[i] = scheduler_ctx.core.packet_queues[i].count;
     }
     
 
@@ -704,8 +553,8 @@ static void packet_creator_task(void *pvParameters)
             data_type_t data_type = DATA_TYPE_INT32; 
 
             if (xSemaphoreTake(scheduler_ctx.mutex, portMAX_DELAY) == pdTRUE) {
-                period_ms = scheduler_ctx.class_periods[class_id];
-                data_type = scheduler_ctx.class_types[class_id];
+                period_ms = scheduler_ctx.core.class_periods[class_id];
+                data_type = scheduler_ctx.core.class_types[class_id];
                 xSemaphoreGive(scheduler_ctx.mutex);
             }
             
@@ -751,10 +600,8 @@ static void packet_creator_task(void *pvParameters)
 /* Initialize the packet scheduler */
 void scheduler_init(scheduler_config_t *config)
 {
-    // Initialize packet queues for each class
-    for (int i = 0; i < MAX_CLASSES; i++) {
-        queue_init(&scheduler_ctx.packet_queues[i]);
-    }
+    // Initialize packet queues and statistics
+    sched_core_init(&scheduler_ctx.core);
 
     // Initialize mutex
     scheduler_ctx.mutex = xSemaphoreCreateMutex();
@@ -769,17 +616,12 @@ void scheduler_init(scheduler_config_t *config)
     // scheduler_ctx.class_types[CLASS_3] = DATA_TYPE_INT16;  // Class 3 (6s) - INT16
 
     for (int i = 0; i < MAX_CLASSES; i++) {
-        scheduler_ctx.class_types[i] = config->class_types[i];
-        scheduler_ctx.class_periods[i] = config->class_periods[i];
-        scheduler_ctx.class_deadlines[i] = config->class_deadlines[i];
+        scheduler_ctx.core.class_types[i] = config->class_types[i];
+        scheduler_ctx.core.class_periods[i] = config->class_periods[i];
+        scheduler_ctx.core.class_deadlines[i] = config->class_deadlines[i];
     }
 
-    scheduler_ctx.processing_threshold = config->processing_threshold;
-
-    // Initialize statistics
-    scheduler_ctx.packets_processed = 0;
-    scheduler_ctx.packets_transmitted = 0;
-    scheduler_ctx.deadline_misses = 0;
+    scheduler_ctx.core.processing_threshold = config->processing_threshold;
     scheduler_ctx.current_time_ms = 0;
     
     // Create packet creator task with packet counts passed as parameters
@@ -829,29 +671,21 @@ void scheduler_init(scheduler_config_t *config)
     //ESP_LOGI(TAG, "Packet scheduler initialized with %d classes and separate creation/scheduling tasks", MAX_CLASSES);
         // Log initialization details
     ESP_LOGI(TAG, "Packet scheduler initialized with the following configuration:");
+    ESP_LOGI(TAG, "Batch policy: %s", SCHED_POLICY_NAME);
     for (int i = 0; i < MAX_CLASSES; i++) {
-        const char *type_str;
-        switch (scheduler_ctx.class_types[i]) {
-            case DATA_TYPE_INT8:   type_str = "INT8";   break;
-            case DATA_TYPE_INT16:  type_str = "INT16";  break;
-            case DATA_TYPE_INT32:  type_str = "INT32";  break;
-            case DATA_TYPE_FLOAT:  type_str = "FLOAT";  break;
-            case DATA_TYPE_DOUBLE: type_str = "DOUBLE"; break;
-            default:               type_str = "UNKNOWN"; break;
-        }
-        
         ESP_LOGI(TAG, "Class %d: Type=%s, Period=%lu ms, Deadline=%lu ms, Count=%u", 
-                 i + 1, type_str, scheduler_ctx.class_periods[i], scheduler_ctx.class_deadlines[i],
+                 i + 1, data_type_name(scheduler_ctx.core.class_types[i]),
+                 scheduler_ctx.core.class_periods[i], scheduler_ctx.core.class_deadlines[i],
                  task_params[i]);
     }
 
     // Also log the processing threshold
-    ESP_LOGI(TAG, "Processing threshold: %lu ms", scheduler_ctx.processing_threshold);
+    ESP_LOGI(TAG, "Processing threshold: %lu ms", scheduler_ctx.core.processing_threshold);
 
     // Create random packet task if enabled
     if (config->random_packet_enabled) {
         // Set the type for random packets
-        scheduler_ctx.class_types[CLASS_RANDOM] = config->random_packet_type;
+        scheduler_ctx.core.class_types[CLASS_RANDOM] = config->random_packet_type;
 
         // Clone config for the task since it will persist
         scheduler_config_t *task_config = malloc(sizeof(scheduler_config_t));
@@ -882,16 +716,7 @@ void scheduler_init(scheduler_config_t *config)
                 ESP_LOGI(TAG, "  Burst interval: %lu ms", config->random_packet_burst_interval);
                 ESP_LOGI(TAG, "  Packet size: %u", config->random_packet_count);
                 
-                const char *type_str;
-                switch (config->random_packet_type) {
-                    case DATA_TYPE_INT8:   type_str = "INT8";   break;
-                    case DATA_TYPE_INT16:  type_str = "INT16";  break;
-                    case DATA_TYPE_INT32:  type_str = "INT32";  break;
-                    case DATA_TYPE_FLOAT:  type_str = "FLOAT";  break;
-                    case DATA_TYPE_DOUBLE: type_str = "DOUBLE"; break;
-                    default:               type_str = "UNKNOWN"; break;
-                }
-                ESP_LOGI(TAG, "  Packet type: %s", type_str);
+                ESP_LOGI(TAG, "  Packet type: %s", data_type_name(config->random_packet_type));
             }
         }
     }
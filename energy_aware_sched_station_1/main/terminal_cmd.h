@@ -20,6 +20,7 @@
 #include "esp_vfs_dev.h"
 #include "linenoise/linenoise.h"
 #include "esp_random.h"  // For esp_random() function
+#include "sched_types.h"  // class_id_t, data_type_t, MAX_CLASSES
 
 /* Terminal Configuration */
 #define UART_NUM            UART_NUM_0
@@ -29,7 +30,6 @@
 #define MAX_CMDLINE_LENGTH  256
 
 /* Class and Deadline Configuration */
-// #define MAX_CLASSES         3     // Number of classes
 #define DEFAULT_CLASS1_PERIOD 3000    // Default: 3 seconds
 #define DEFAULT_CLASS2_PERIOD 5000    // Default: 5 seconds
 #define DEFAULT_CLASS3_PERIOD 6000    // Default: 6 seconds
@@ -64,24 +64,6 @@
 #define DEFAULT_RANDOM_PACKET_COUNT 10             // Default packet size
 #define DEFAULT_RANDOM_PACKET_TYPE DATA_TYPE_INT32 // Default packet type
 
-/* Forward declarations for scheduler types */
-typedef enum {
-    CLASS_1 = 0,                 // Class 1
-    CLASS_2 = 1,                 // Class 2
-    CLASS_3 = 2,                 // Class 3
-    CLASS_RANDOM = 3,
-    MAX_CLASSES
-} class_id_t;
-
-typedef enum {
-    DATA_TYPE_INT8 = 0,          // 8-bit integer
-    DATA_TYPE_INT16 = 1,         // 16-bit integer
-    DATA_TYPE_INT32 = 2,         // 32-bit integer
-    DATA_TYPE_FLOAT = 3,         // 32-bit float
-    DATA_TYPE_DOUBLE = 4,        // 64-bit double
-    NUM_DATA_TYPE
-} data_type_t;
-
 /* Configuration structure to be passed back to the main program */
 typedef struct {
     uint32_t class_periods[MAX_CLASSES];   // Period for each class (ms)
@@ -0,0 +1,268 @@
+/**
+ * @file air.c
+ * @brief Node side of the virtual-air transport
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "air.h"
+
+#define AIR_RX_POLL_MS  100     // How often the RX thread checks for shutdown
+
+/* ESP-NOW action frame layout */
+#define ESPNOW_FC0_ACTION       0xD0    // Management frame, action subtype
+#define ESPNOW_CATEGORY_VENDOR  127
+#define ESPNOW_ELEMENT_VENDOR   221
+#define ESPNOW_TYPE             4
+#define ESPNOW_VERSION          2
+#define ESPNOW_CATEGORY_OFFSET  24
+#define ESPNOW_ELEMENT_OFFSET   32      // After category, OUI and 4 random bytes
+#define ESPNOW_ELEMENT_FIXED    5       // OUI, type and version ahead of the data
+
+static const uint8_t espressif_oui[3] = {0x18, 0xFE, 0x34};
+
+uint64_t air_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+size_t air_medium_addr(const char *medium, void *addr)
+{
+    struct sockaddr_un *sun = addr;
+
+    memset(sun, 0, sizeof(*sun));
+    sun->sun_family = AF_UNIX;
+
+    // Abstract namespace: leading NUL, name is not NUL-terminated
+    int n = snprintf(sun->sun_path + 1, sizeof(sun->sun_path) - 1, "air-medium/%s",
+                     medium != NULL ? medium : AIR_DEFAULT_MEDIUM);
+    if (n < 0 || (size_t)n >= sizeof(sun->sun_path) - 1) {
+        n = sizeof(sun->sun_path) - 2;
+    }
+
+    return offsetof(struct sockaddr_un, sun_path) + 1 + (size_t)n;
+}
+
+static int send_msg(air_node_t *node, air_msg_type_t type, const uint8_t *frame, size_t len)
+{
+    air_msg_header_t header = {
+        .magic = AIR_MAGIC,
+        .type = type,
+        .len = (uint16_t)len,
+        .tx_time_us = air_now_us(),
+    };
+    struct iovec iov[2] = {
+        { .iov_base = &header, .iov_len = sizeof(header) },
+        { .iov_base = (void *)frame, .iov_len = len },
+    };
+    struct msghdr msg = {
+        .msg_iov = iov,
+        .msg_iovlen = len > 0 ? 2 : 1,
+    };
+
+    return sendmsg(node->fd, &msg, MSG_DONTWAIT) < 0 ? -1 : 0;
+}
+
+int air_open(air_node_t *node, const char *medium)
+{
+    memset(node, 0, sizeof(*node));
+    snprintf(node->medium, sizeof(node->medium), "%s", medium != NULL ? medium : AIR_DEFAULT_MEDIUM);
+
+    node->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (node->fd < 0) {
+        return -1;
+    }
+
+    // Autobind gives the node a unique abstract address the medium can reply to
+    struct sockaddr_un self = { .sun_family = AF_UNIX };
+    struct sockaddr_un peer;
+    size_t peer_len = air_medium_addr(node->medium, &peer);
+
+    if (bind(node->fd, (struct sockaddr *)&self, sizeof(sa_family_t)) < 0 ||
+        connect(node->fd, (struct sockaddr *)&peer, peer_len) < 0 ||
+        send_msg(node, AIR_MSG_HELLO, NULL, 0) < 0) {
+        int err = errno;
+        close(node->fd);
+        node->fd = -1;
+        errno = err;
+        return -1;
+    }
+
+    return 0;
+}
+
+int air_tx(air_node_t *node, const uint8_t *frame, size_t len)
+{
+    if (len == 0 || len > AIR_MAX_FRAME) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (send_msg(node, AIR_MSG_FRAME, frame, len) < 0) {
+        node->tx_errors++;
+        return -1;
+    }
+
+    node->tx_frames++;
+    return 0;
+}
+
+/*
+ * Receive one datagram and hand a well-formed delivery to cb.
+ * Returns 1 if delivered, 2 if a datagram was skipped, 0 if none was
+ * waiting and -1 on a socket error.
+ */
+static int receive_one(air_node_t *node, air_rx_cb_t cb, void *ctx, int flags)
+{
+    uint8_t buf[sizeof(air_msg_header_t) + AIR_MAX_FRAME];
+
+    ssize_t n = recv(node->fd, buf, sizeof(buf), flags);
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+    }
+    if (n < (ssize_t)sizeof(air_msg_header_t)) {
+        return 2;
+    }
+
+    air_msg_header_t header;
+    memcpy(&header, buf, sizeof(header));
+    if (header.magic != AIR_MAGIC || header.type != AIR_MSG_FRAME ||
+        header.len != (size_t)n - sizeof(header)) {
+        return 2;  // Not a well-formed delivery
+    }
+
+    air_rx_info_t info = {
+        .tx_time_us = header.tx_time_us,
+        .rx_time_us = header.rx_time_us,
+        .len = header.len,
+    };
+    node->rx_frames++;
+    cb(buf + sizeof(header), header.len, &info, ctx);
+
+    return 1;
+}
+
+static void *rx_thread_main(void *arg)
+{
+    air_node_t *node = arg;
+    struct pollfd pfd = { .fd = node->fd, .events = POLLIN };
+
+    while (__atomic_load_n(&node->rx_running, __ATOMIC_ACQUIRE)) {
+        if (poll(&pfd, 1, AIR_RX_POLL_MS) > 0) {
+            receive_one(node, node->rx_cb, node->rx_ctx, 0);
+        }
+    }
+
+    return NULL;
+}
+
+int air_rx_poll(air_node_t *node, air_rx_cb_t cb, void *ctx, int max_frames)
+{
+    int delivered = 0;
+
+    while (delivered < max_frames) {
+        int ret = receive_one(node, cb, ctx, MSG_DONTWAIT);
+        if (ret < 0) {
+            return -1;
+        }
+        if (ret == 0) {
+            break;
+        }
+        if (ret == 1) {
+            delivered++;
+        }
+    }
+
+    return delivered;
+}
+
+int air_start_rx(air_node_t *node, air_rx_cb_t cb, void *ctx)
+{
+    node->rx_cb = cb;
+    node->rx_ctx = ctx;
+    node->rx_running = true;
+
+    if (pthread_create(&node->rx_thread, NULL, rx_thread_main, node) != 0) {
+        node->rx_running = false;
+        return -1;
+    }
+
+    return 0;
+}
+
+size_t air_espnow_encode(uint8_t *out, size_t out_cap, const uint8_t da[6], const uint8_t sa[6],
+                         const uint8_t *data, size_t len)
+{
+    size_t frame_len = AIR_ESPNOW_HEADER_LEN + len;
+    if (len > AIR_ESPNOW_MAX_DATA || frame_len > out_cap) {
+        return 0;
+    }
+
+    // Management header: addressed to da from sa, broadcast BSSID as the driver sends it
+    memset(out, 0, AIR_ESPNOW_HEADER_LEN);
+    out[0] = ESPNOW_FC0_ACTION;
+    memcpy(&out[4], da, 6);
+    memcpy(&out[10], sa, 6);
+    memset(&out[16], 0xFF, 6);
+
+    uint8_t *p = out + ESPNOW_CATEGORY_OFFSET;
+    *p++ = ESPNOW_CATEGORY_VENDOR;
+    memcpy(p, espressif_oui, sizeof(espressif_oui));
+
+    p = out + ESPNOW_ELEMENT_OFFSET;
+    size_t element_len = ESPNOW_ELEMENT_FIXED + len;
+    *p++ = ESPNOW_ELEMENT_VENDOR;
+    *p++ = element_len > 255 ? 255 : (uint8_t)element_len;
+    memcpy(p, espressif_oui, sizeof(espressif_oui));
+    p += sizeof(espressif_oui);
+    *p++ = ESPNOW_TYPE;
+    *p++ = ESPNOW_VERSION;
+
+    memcpy(p, data, len);
+    return frame_len;
+}
+
+bool air_espnow_decode(const uint8_t *frame, size_t len, const uint8_t **da, const uint8_t **sa,
+                       const uint8_t **data, size_t *data_len)
+{
+    const uint8_t *element = frame + ESPNOW_ELEMENT_OFFSET;
+    if (len < AIR_ESPNOW_HEADER_LEN || frame[0] != ESPNOW_FC0_ACTION ||
+        frame[ESPNOW_CATEGORY_OFFSET] != ESPNOW_CATEGORY_VENDOR ||
+        memcmp(&frame[ESPNOW_CATEGORY_OFFSET + 1], espressif_oui, sizeof(espressif_oui)) != 0 ||
+        element[0] != ESPNOW_ELEMENT_VENDOR || element[1] < ESPNOW_ELEMENT_FIXED ||
+        memcmp(&element[2], espressif_oui, sizeof(espressif_oui)) != 0 || element[5] != ESPNOW_TYPE) {
+        return false;
+    }
+
+    *da = &frame[4];
+    *sa = &frame[10];
+    *data = frame + AIR_ESPNOW_HEADER_LEN;
+    *data_len = len - AIR_ESPNOW_HEADER_LEN;
+    if (element[1] < 255 && (size_t)(element[1] - ESPNOW_ELEMENT_FIXED) < *data_len) {
+        *data_len = element[1] - ESPNOW_ELEMENT_FIXED;
+    }
+    return true;
+}
+
+void air_close(air_node_t *node)
+{
+    if (node->rx_running) {
+        __atomic_store_n(&node->rx_running, false, __ATOMIC_RELEASE);
+        pthread_join(node->rx_thread, NULL);
+    }
+
+    if (node->fd >= 0) {
+        send_msg(node, AIR_MSG_BYE, NULL, 0);
+        close(node->fd);
+        node->fd = -1;
+    }
+}
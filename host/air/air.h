@@ -0,0 +1,157 @@
+/**
+ * @file air.h
+ * @brief Virtual-air transport: raw 802.11 frames over a local medium process
+ *
+ * Stands in for esp_wifi_80211_tx() and the promiscuous RX callback so the
+ * station scheduler and the AP receiver can run as ordinary Linux
+ * processes. Every node sends frames to the medium (air_medium), which
+ * applies loss, delay, jitter and a shared bitrate and then delivers each
+ * frame to every other node, like a broadcast channel.
+ *
+ * Nodes and the medium talk over UNIX datagram sockets in the abstract
+ * namespace, so nothing is left behind in the filesystem. The medium is
+ * addressed by name (default AIR_DEFAULT_MEDIUM); several media can run
+ * side by side under different names.
+ *
+ * Timestamps come from CLOCK_MONOTONIC, which all processes on the host
+ * share, so one-way latency can be measured directly.
+ *
+ * ESP-NOW traffic goes over the air as the driver sends it: a vendor-specific
+ * action frame (category 127, Espressif OUI 18:fe:34) whose vendor element
+ * carries the data. Payloads over 250 bytes (ESP-NOW v2) do not fit the
+ * element's length byte, which then holds 255; the frame length bounds the
+ * data.
+ */
+
+#ifndef AIR_H
+#define AIR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define AIR_DEFAULT_MEDIUM   "air"
+#define AIR_MAX_FRAME        2048    // Larger than any 802.11 frame we build
+#define AIR_NAME_MAX         32
+
+/* Addresses used by the host station and AP (locally administered) */
+#define AIR_AP_MAC           {0x02, 0x00, 0x00, 0x00, 0x00, 0x01}
+#define AIR_STA_MAC          {0x02, 0x00, 0x00, 0x00, 0x00, 0x02}
+
+/* ESP-NOW frames */
+#define AIR_ESPNOW_MAX_DATA  1470    // ESP-NOW v2 payload limit
+#define AIR_ESPNOW_HEADER_LEN 39     // Management header, action header, vendor element header
+
+/* Message kinds exchanged with the medium */
+typedef enum {
+    AIR_MSG_HELLO = 1,       // Node -> medium: register for delivery
+    AIR_MSG_FRAME,           // Either direction: one over-the-air frame
+    AIR_MSG_BYE,             // Node -> medium: stop delivering to this node
+} air_msg_type_t;
+
+/* Header in front of every datagram */
+typedef struct {
+    uint32_t magic;          // AIR_MAGIC
+    uint8_t type;            // air_msg_type_t
+    uint8_t reserved;
+    uint16_t len;            // Frame bytes after the header
+    uint64_t tx_time_us;     // When the sender handed the frame over
+    uint64_t rx_time_us;     // When the medium delivered it (0 towards the medium)
+} air_msg_header_t;
+
+#define AIR_MAGIC            0x52494131u   // "1AIR"
+
+/* Delivery details passed to the RX callback */
+typedef struct {
+    uint64_t tx_time_us;     // Sender's air_tx() time
+    uint64_t rx_time_us;     // Medium delivery time
+    uint16_t len;            // Frame length
+} air_rx_info_t;
+
+/* Called on the node's RX thread for every delivered frame */
+typedef void (*air_rx_cb_t)(const uint8_t *frame, size_t len, const air_rx_info_t *info, void *ctx);
+
+/* One process's connection to the medium */
+typedef struct {
+    int fd;
+    char medium[AIR_NAME_MAX];
+    pthread_t rx_thread;
+    bool rx_running;
+    air_rx_cb_t rx_cb;
+    void *rx_ctx;
+
+    // Statistics
+    uint32_t tx_frames;      // Frames handed to the medium
+    uint32_t tx_errors;      // Frames the socket refused
+    uint32_t rx_frames;      // Frames delivered to the callback
+} air_node_t;
+
+/**
+ * @brief Microseconds on CLOCK_MONOTONIC
+ */
+uint64_t air_now_us(void);
+
+/**
+ * @brief Fill a sockaddr_un for a medium name; returns the address length
+ */
+size_t air_medium_addr(const char *medium, void *addr);
+
+/**
+ * @brief Connect to a running medium and register for delivery
+ *
+ * @param medium Medium name, NULL for AIR_DEFAULT_MEDIUM
+ * @return 0 on success, -1 with errno set on failure
+ */
+int air_open(air_node_t *node, const char *medium);
+
+/**
+ * @brief Put one frame on the air (esp_wifi_80211_tx() equivalent)
+ *
+ * Never blocks on the medium: a frame the socket cannot take right away
+ * is dropped and counted, like a full driver TX queue.
+ *
+ * @return 0 on success, -1 with errno set on failure
+ */
+int air_tx(air_node_t *node, const uint8_t *frame, size_t len);
+
+/**
+ * @brief Start the RX thread; @p cb runs for every frame from other nodes
+ *
+ * @return 0 on success, -1 on failure
+ */
+int air_start_rx(air_node_t *node, air_rx_cb_t cb, void *ctx);
+
+/**
+ * @brief Deliver frames already waiting on the socket, without blocking
+ *
+ * For callers that must not block or own threads, such as tasks on the
+ * FreeRTOS POSIX port; use instead of air_start_rx().
+ *
+ * @param max_frames Stop after this many frames
+ * @return Frames delivered, or -1 on a socket error
+ */
+int air_rx_poll(air_node_t *node, air_rx_cb_t cb, void *ctx, int max_frames);
+
+/**
+ * @brief Write an ESP-NOW action frame from @p sa to @p da carrying @p data
+ *
+ * @return Frame length, or 0 if @p data is too long or @p out too small
+ */
+size_t air_espnow_encode(uint8_t *out, size_t out_cap, const uint8_t da[6], const uint8_t sa[6],
+                         const uint8_t *data, size_t len);
+
+/**
+ * @brief Recognize an ESP-NOW action frame and locate its addresses and data
+ *
+ * @return false if @p frame is not an ESP-NOW frame; the pointers alias it
+ */
+bool air_espnow_decode(const uint8_t *frame, size_t len, const uint8_t **da, const uint8_t **sa,
+                       const uint8_t **data, size_t *data_len);
+
+/**
+ * @brief Stop the RX thread, unregister from the medium and close the socket
+ */
+void air_close(air_node_t *node);
+
+#endif /* AIR_H */
@@ -0,0 +1,459 @@
+/**
+ * @file air_ap.c
+ * @brief Host AP receiver: the firmware's single-parse RX path over the virtual air
+ *
+ * Each delivered frame goes through frame_parse() exactly as in the
+ * firmware promiscuous callback: schema announcements are registered, data
+ * frames have their sample time block decoded and every class widened to
+ * doubles. On exit the receiver prints frame counts, payload throughput
+ * and one-way latency (frame timestamp and, when the station sends them,
+ * per-sample capture times to delivery). With -x every valid frame is also
+ * printed as an export line (frame_export.h) for the collector. With -a
+ * only the given transmitter addresses are accepted, checked before any
+ * parsing like the firmware's source allowlist; the virtual station is
+ * 02:00:00:00:00:02. With -E the AP takes the firmware's ESP-NOW receive
+ * path instead: only ESP-NOW frames are accepted and their body gets a
+ * data header back before the same parse (air_station -E sends them).
+ * The thread CPU time spent in the RX callback is reported per frame for
+ * whichever path is in use.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/air -Icomponents/sched_core/include \
+ *       host/air/air_ap.c host/air/air.c \
+ *       components/sched_core/{sched_types,sample_codec,record_schema,sample_time,sample_held}.c \
+ *       components/sched_core/{sched_queue,sched_core,frame_codec,frame_export,crc32c,mac_allowlist}.c \
+ *       -lpthread -o /tmp/air_ap
+ *
+ * Usage:
+ *   air_ap [-m medium] [-T seconds] [-a mac]... [-E] [-v] [-x]
+ *
+ * Example:
+ *   air_ap -x | collector -d /tmp/db
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "air.h"
+#include "frame_codec.h"
+#include "frame_export.h"
+#include "record_schema.h"
+#include "sample_time.h"
+#include "sample_held.h"
+#include "mac_allowlist.h"
+
+#define LATENCY_SAMPLES_MAX   65536   // Frame latencies kept for percentiles
+#define AIR_RX_RSSI           -40     // The virtual air has no signal strength
+
+/* Receiver statistics, updated on the RX thread */
+typedef struct {
+    uint32_t frames;              // Valid scheduler frames (data and schema)
+    uint32_t data_frames;
+    uint32_t schema_frames;
+    uint32_t error_frames;        // Failed validation
+    uint32_t crc_frames;          // Of which a bad CRC trailer
+    uint32_t ignored_frames;      // Not a station-to-AP data frame for us
+    uint32_t unknown_source;      // From a transmitter not in the allowlist (-a)
+    uint32_t rx_callbacks;        // Frames the medium delivered to the RX path
+    uint64_t rx_cpu_ns;           // Thread CPU time spent in the RX path
+    uint32_t qos_frames[WMM_AC_NUM];
+    uint64_t payload_bytes;
+    uint64_t class_samples[MAX_CLASSES];
+    uint64_t held_samples[MAX_CLASSES];   // Restored from send-on-delta held groups
+    uint32_t held_dropped;                // Held groups whose reference group was not received
+    uint32_t first_rx_ms;
+    uint32_t last_rx_ms;
+
+    // One-way latency: frame timestamp to delivery
+    uint32_t latency_ms[LATENCY_SAMPLES_MAX];
+    uint32_t latency_count;
+    uint64_t latency_sum;
+    uint32_t latency_max;
+
+    // Sample age: capture time to delivery, for frames with sample times
+    uint64_t sample_age_sum;
+    uint32_t sample_age_count;
+    uint32_t sample_age_max;
+} ap_stats_t;
+
+static ap_stats_t stats;
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static const uint8_t our_mac[WIFI_MAC_LEN] = AIR_AP_MAC;
+static bool verbose;
+static bool export_frames;
+static bool use_allowlist;
+static bool espnow_path;
+static mac_allowlist_t allowlist;       // Filled before the RX thread starts
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+/* Decode a validated data frame the way the firmware AP does */
+static void process_data_frame(const frame_view_t *view, uint32_t rx_ms)
+{
+    static double values[MAX_PACKET_SIZE];
+    static sample_times_t times;
+    static sample_held_t held;
+    static sample_hold_t hold;
+    const data_packet_header_t *header = view->header;
+
+    bool have_times = view->time_block != NULL &&
+        sample_time_decode(view->time_block, view->time_block_len, header->timestamp, &times);
+    bool have_held = view->held_block != NULL &&
+        sample_held_decode(view->held_block, view->held_block_len, &held) > 0;
+
+    uint32_t samples[MAX_CLASSES] = {0};
+    uint32_t restored[MAX_CLASSES] = {0};
+    uint32_t dropped = 0;
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        uint8_t count = header->class_counts[class_id];
+        if (count == 0) {
+            continue;
+        }
+        const uint8_t *data = view->payload + view->class_offset[class_id];
+        uint16_t element_size = view->class_size[class_id] / count;
+        class_type_widen(header->class_types[class_id], values, data, count);
+        samples[class_id] = count;
+
+        if (have_held) {
+            sample_run_t runs[SAMPLE_HOLD_MAX_RUNS];
+            uint32_t class_dropped;
+            int run_count = sample_hold_expand(&hold, &held, class_id, data, count, element_size, runs,
+                                               &class_dropped);
+            for (int r = 0; r < run_count; r++) {
+                if (runs[r].held) {
+                    restored[class_id] += (uint32_t)runs[r].items * runs[r].repeat;
+                }
+            }
+            dropped += class_dropped;
+        }
+        sample_hold_keep(&hold, have_held ? &held : NULL, class_id, data, count, element_size);
+    }
+
+    uint32_t latency = rx_ms - header->timestamp;
+
+    pthread_mutex_lock(&stats_mutex);
+    stats.data_frames++;
+    stats.payload_bytes += view->payload_len;
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        stats.class_samples[class_id] += samples[class_id];
+        stats.held_samples[class_id] += restored[class_id];
+    }
+    stats.held_dropped += dropped;
+    if (stats.latency_count < LATENCY_SAMPLES_MAX) {
+        stats.latency_ms[stats.latency_count] = latency;
+    }
+    stats.latency_count++;
+    stats.latency_sum += latency;
+    if (latency > stats.latency_max) {
+        stats.latency_max = latency;
+    }
+    if (have_times) {
+        for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+            for (uint16_t i = 0; i < samples[class_id]; i++) {
+                uint32_t captured;
+                if (sample_time_at(&times, class_id, i, &captured)) {
+                    uint32_t age = rx_ms - captured;
+                    stats.sample_age_sum += age;
+                    stats.sample_age_count++;
+                    if (age > stats.sample_age_max) {
+                        stats.sample_age_max = age;
+                    }
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&stats_mutex);
+
+    if (verbose) {
+        printf("rx t=%lu latency=%lu ms size=%u counts=%u,%u,%u,%u%s%s\n",
+               (unsigned long)header->timestamp, (unsigned long)latency, header->total_size,
+               header->class_counts[0], header->class_counts[1],
+               header->class_counts[2], header->class_counts[3],
+               have_times ? " times" : "", have_held && held.count > 0 ? " held" : "");
+    }
+}
+
+/* Print a validated frame for the collector, like the firmware AP */
+static void export_frame(const uint8_t *frame, const frame_view_t *view, uint32_t rx_ms)
+{
+    char line[FRAME_EXPORT_LINE_MAX(AIR_MAX_FRAME)];
+
+    if (frame_export_format(line, sizeof(line), rx_ms, AIR_RX_RSSI, frame, view->frame_len) > 0) {
+        pthread_mutex_lock(&stats_mutex);
+        printf("%s\n", line);
+        pthread_mutex_unlock(&stats_mutex);
+    }
+}
+
+static void count_unknown_source(void)
+{
+    pthread_mutex_lock(&stats_mutex);
+    stats.unknown_source++;
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+static void count_ignored(void)
+{
+    pthread_mutex_lock(&stats_mutex);
+    stats.ignored_frames++;
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+/* Parse and process one data frame, from either receive path */
+static void receive_frame(const uint8_t *frame, size_t len, uint32_t rx_ms)
+{
+    frame_view_t view;
+    frame_status_t status = frame_parse(frame, len, our_mac, &view);
+
+    switch (status) {
+        case FRAME_OK:
+            break;
+        case FRAME_ERR_TOO_SHORT:
+        case FRAME_ERR_NOT_TO_DS:
+        case FRAME_ERR_NOT_FOR_US:
+            count_ignored();
+            return;
+        default:
+            if (verbose) {
+                printf("rx error: %s\n", frame_status_name(status));
+            }
+            pthread_mutex_lock(&stats_mutex);
+            stats.error_frames++;
+            stats.crc_frames += status == FRAME_ERR_BAD_CRC;
+            pthread_mutex_unlock(&stats_mutex);
+            return;
+    }
+
+    pthread_mutex_lock(&stats_mutex);
+    if (stats.frames == 0) {
+        stats.first_rx_ms = rx_ms;
+    }
+    stats.frames++;
+    stats.last_rx_ms = rx_ms;
+    if (view.qos) {
+        stats.qos_frames[view.access_category]++;
+    }
+    pthread_mutex_unlock(&stats_mutex);
+
+    if (export_frames) {
+        export_frame(frame, &view, rx_ms);
+    }
+
+    if (view.kind == FRAME_KIND_SCHEMA) {
+        record_schema_unpack(view.payload, view.payload_len);
+        pthread_mutex_lock(&stats_mutex);
+        stats.schema_frames++;
+        pthread_mutex_unlock(&stats_mutex);
+        return;
+    }
+    if (view.kind == FRAME_KIND_BENCH) {
+        return;     // Link benchmark traffic carries no samples
+    }
+
+    process_data_frame(&view, rx_ms);
+}
+
+/* Promiscuous RX callback equivalent */
+static void promiscuous_rx(const uint8_t *frame, size_t len, uint32_t rx_ms)
+{
+    if (use_allowlist && len >= WIFI_DATA_HEADER_LEN &&
+        !mac_allowlist_contains(&allowlist, frame + WIFI_ADDR2_OFFSET)) {
+        count_unknown_source();
+        return;
+    }
+    receive_frame(frame, len, rx_ms);
+}
+
+/* ESP-NOW receive callback equivalent: the driver hands over only ESP-NOW frames for us */
+static void espnow_rx(const uint8_t *frame, size_t len, uint32_t rx_ms)
+{
+    static const uint8_t broadcast[WIFI_MAC_LEN] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    static uint8_t rebuilt[FRAME_MAX_LEN];
+    const uint8_t *da, *sa, *body;
+    size_t body_len;
+
+    if (!air_espnow_decode(frame, len, &da, &sa, &body, &body_len) ||
+        (memcmp(da, our_mac, WIFI_MAC_LEN) != 0 && memcmp(da, broadcast, WIFI_MAC_LEN) != 0)) {
+        count_ignored();
+        return;
+    }
+    if (use_allowlist && !mac_allowlist_contains(&allowlist, sa)) {
+        count_unknown_source();
+        return;
+    }
+
+    frame_addr_t addr;
+    memcpy(addr.da, our_mac, WIFI_MAC_LEN);
+    memcpy(addr.sa, sa, WIFI_MAC_LEN);
+    memcpy(addr.bssid, our_mac, WIFI_MAC_LEN);
+    size_t rebuilt_len = frame_build_from_body(rebuilt, sizeof(rebuilt), &addr, body, body_len);
+    if (rebuilt_len == 0) {
+        count_ignored();
+        return;
+    }
+    receive_frame(rebuilt, rebuilt_len, rx_ms);
+}
+
+static uint64_t thread_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* RX thread callback: the selected receive path, timed */
+static void on_frame(const uint8_t *frame, size_t len, const air_rx_info_t *info, void *ctx)
+{
+    (void)ctx;
+    uint32_t rx_ms = (uint32_t)(info->rx_time_us / 1000u);
+    uint64_t start_ns = thread_cpu_ns();
+
+    if (espnow_path) {
+        espnow_rx(frame, len, rx_ms);
+    } else {
+        promiscuous_rx(frame, len, rx_ms);
+    }
+
+    uint64_t spent_ns = thread_cpu_ns() - start_ns;
+    pthread_mutex_lock(&stats_mutex);
+    stats.rx_callbacks++;
+    stats.rx_cpu_ns += spent_ns;
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const uint32_t *sorted, uint32_t count, double p)
+{
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t index = (uint32_t)(p * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+static void print_stats(void)
+{
+    pthread_mutex_lock(&stats_mutex);
+
+    uint32_t kept = stats.latency_count < LATENCY_SAMPLES_MAX ? stats.latency_count : LATENCY_SAMPLES_MAX;
+    qsort(stats.latency_ms, kept, sizeof(stats.latency_ms[0]), compare_u32);
+    uint32_t active_ms = stats.last_rx_ms - stats.first_rx_ms;
+
+    printf("ap frames=%u data_frames=%u schema_frames=%u error_frames=%u crc_frames=%u ignored_frames=%u"
+           " unknown_source=%u\n",
+           stats.frames, stats.data_frames, stats.schema_frames, stats.error_frames, stats.crc_frames,
+           stats.ignored_frames, stats.unknown_source);
+    if (record_schema_conflicts() > 0) {
+        printf("schema_conflicts=%u\n", record_schema_conflicts());
+    }
+    printf("qos_frames BK=%u BE=%u VI=%u VO=%u\n",
+           stats.qos_frames[WMM_AC_BK], stats.qos_frames[WMM_AC_BE],
+           stats.qos_frames[WMM_AC_VI], stats.qos_frames[WMM_AC_VO]);
+    printf("rx_path=%s callbacks=%u cpu_us_per_callback=%.2f cpu_us_per_frame=%.2f\n",
+           espnow_path ? "espnow" : "promiscuous", stats.rx_callbacks,
+           stats.rx_callbacks > 0 ? stats.rx_cpu_ns / 1000.0 / stats.rx_callbacks : 0.0,
+           stats.frames > 0 ? stats.rx_cpu_ns / 1000.0 / stats.frames : 0.0);
+    printf("samples=%llu,%llu,%llu,%llu payload_bytes=%llu throughput_bps=%.0f\n",
+           (unsigned long long)stats.class_samples[0], (unsigned long long)stats.class_samples[1],
+           (unsigned long long)stats.class_samples[2], (unsigned long long)stats.class_samples[3],
+           (unsigned long long)stats.payload_bytes,
+           active_ms > 0 ? stats.payload_bytes * 8000.0 / active_ms : 0.0);
+    if (stats.held_samples[0] + stats.held_samples[1] + stats.held_samples[2] + stats.held_samples[3] > 0) {
+        printf("held_samples=%llu,%llu,%llu,%llu\n",
+               (unsigned long long)stats.held_samples[0], (unsigned long long)stats.held_samples[1],
+               (unsigned long long)stats.held_samples[2], (unsigned long long)stats.held_samples[3]);
+    }
+    if (stats.held_dropped > 0) {
+        printf("held_dropped=%u\n", stats.held_dropped);
+    }
+    printf("latency_ms avg=%.2f p50=%u p90=%u p99=%u max=%u\n",
+           stats.latency_count > 0 ? (double)stats.latency_sum / stats.latency_count : 0.0,
+           percentile(stats.latency_ms, kept, 0.50), percentile(stats.latency_ms, kept, 0.90),
+           percentile(stats.latency_ms, kept, 0.99), stats.latency_max);
+    if (stats.sample_age_count > 0) {
+        printf("sample_age_ms avg=%.2f max=%u samples=%u\n",
+               (double)stats.sample_age_sum / stats.sample_age_count,
+               stats.sample_age_max, stats.sample_age_count);
+    }
+
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+int main(int argc, char **argv)
+{
+    const char *medium = AIR_DEFAULT_MEDIUM;
+    uint32_t duration_s = 0;
+    uint8_t mac[WIFI_MAC_LEN];
+
+    mac_allowlist_init(&allowlist);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:T:a:Evxh")) != -1) {
+        switch (opt) {
+            case 'm': medium = optarg; break;
+            case 'T': duration_s = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'a':
+                if (sscanf(optarg, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+                           &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) != WIFI_MAC_LEN ||
+                    !mac_allowlist_add(&allowlist, mac)) {
+                    fprintf(stderr, "air_ap: bad or too many -a addresses: %s\n", optarg);
+                    return 2;
+                }
+                use_allowlist = true;
+                break;
+            case 'E': espnow_path = true; break;
+            case 'v': verbose = true; break;
+            case 'x': export_frames = true; break;
+            default:
+                fprintf(stderr, "Usage: %s [-m medium] [-T seconds] [-a mac]... [-E] [-v] [-x]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    air_node_t node;
+    if (air_open(&node, medium) < 0) {
+        fprintf(stderr, "air_ap: cannot reach medium '%s': %s\n", medium, strerror(errno));
+        return 1;
+    }
+    if (air_start_rx(&node, on_frame, NULL) < 0) {
+        fprintf(stderr, "air_ap: cannot start RX thread\n");
+        air_close(&node);
+        return 1;
+    }
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    fprintf(stderr, "air_ap: listening on medium '%s', %s receive path\n", medium,
+            espnow_path ? "ESP-NOW" : "promiscuous");
+
+    uint64_t started = air_now_us();
+    while (!stop_requested) {
+        if (duration_s > 0 && air_now_us() - started >= (uint64_t)duration_s * 1000000u) {
+            break;
+        }
+        struct timespec ts = { .tv_sec = 0, .tv_nsec = 50 * 1000000L };
+        nanosleep(&ts, NULL);
+    }
+
+    air_close(&node);
+    print_stats();
+
+    return 0;
+}
@@ -0,0 +1,431 @@
+/**
+ * @file air_medium.c
+ * @brief Virtual-air medium process: shared channel with loss, delay, jitter and bitrate
+ *
+ * Nodes register with a HELLO and then send frames. Each frame occupies the
+ * channel for its airtime (len * 8 / bitrate plus a fixed per-frame
+ * overhead); frames queue behind each other, and a frame that would wait
+ * longer than the queue limit is dropped. Once on the air, the frame is
+ * delivered to every other node after the propagation delay plus a uniform
+ * jitter, and each delivery is lost independently with the loss
+ * probability.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/air host/air/air_medium.c host/air/air.c \
+ *       -lpthread -o /tmp/air_medium
+ *
+ * Usage:
+ *   air_medium [-n name] [-l loss_pct] [-d delay_ms] [-j jitter_ms]
+ *              [-b bitrate_kbps] [-o overhead_us] [-q queue_ms] [-s seed]
+ *              [-T seconds] [-v]
+ *
+ * A bitrate of 0 (the default) gives frames no airtime. Statistics are
+ * printed on exit (SIGINT, SIGTERM or after -T seconds).
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "air.h"
+
+#define MEDIUM_MAX_NODES      16
+#define MEDIUM_MAX_PENDING    4096    // Deliveries in flight across all nodes
+#define DEFAULT_QUEUE_MS      500     // Longest a frame may wait for the channel
+
+/* Channel model parameters */
+typedef struct {
+    const char *name;
+    double loss;                // Per-delivery loss probability (0..1)
+    uint32_t delay_us;          // Propagation / processing delay
+    uint32_t jitter_us;         // Uniform jitter, +/- this much
+    uint32_t bitrate_kbps;      // Channel bitrate, 0 for no airtime
+    uint32_t overhead_us;       // Per-frame preamble, IFS and ACK time
+    uint32_t queue_us;          // Queueing limit before a frame is dropped
+    uint32_t duration_s;        // Exit after this long, 0 to run until signalled
+    uint64_t seed;
+    bool verbose;
+} medium_config_t;
+
+/* A registered node */
+typedef struct {
+    bool used;
+    struct sockaddr_un addr;
+    socklen_t addr_len;
+} medium_node_t;
+
+/* A frame waiting to be delivered to one node */
+typedef struct {
+    uint64_t deliver_at;
+    uint64_t seq;               // Tie-break so equal times keep send order
+    uint64_t tx_time_us;
+    int node;
+    uint16_t len;
+    uint8_t frame[AIR_MAX_FRAME];
+} pending_t;
+
+/* Medium statistics */
+typedef struct {
+    uint32_t frames_in;         // Frames received from nodes
+    uint64_t bytes_in;
+    uint32_t deliveries;        // Frames delivered to nodes
+    uint32_t lost;              // Deliveries dropped by the loss model
+    uint32_t queue_drops;       // Frames dropped because the channel was backed up
+    uint32_t overflow_drops;    // Deliveries dropped for lack of pending slots
+    uint32_t send_errors;       // Receiver socket full or gone
+    uint64_t airtime_us;        // Channel time used
+} medium_stats_t;
+
+static medium_config_t config = {
+    .name = AIR_DEFAULT_MEDIUM,
+    .queue_us = DEFAULT_QUEUE_MS * 1000u,
+    .seed = 1,
+};
+
+static medium_node_t nodes[MEDIUM_MAX_NODES];
+static pending_t *heap[MEDIUM_MAX_PENDING];
+static int heap_len;
+static medium_stats_t stats;
+static uint64_t rng_state;
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+/* xorshift64*: reproducible for a given -s seed */
+static uint64_t rng_next(void)
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1Dull;
+}
+
+static double rng_uniform(void)
+{
+    return (rng_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static bool pending_before(const pending_t *a, const pending_t *b)
+{
+    return a->deliver_at != b->deliver_at ? a->deliver_at < b->deliver_at : a->seq < b->seq;
+}
+
+static void heap_push(pending_t *p)
+{
+    int i = heap_len++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!pending_before(p, heap[parent])) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = p;
+}
+
+static pending_t *heap_pop(void)
+{
+    pending_t *top = heap[0];
+    pending_t *last = heap[--heap_len];
+    int i = 0;
+
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= heap_len) {
+            break;
+        }
+        if (child + 1 < heap_len && pending_before(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!pending_before(heap[child], last)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (heap_len > 0) {
+        heap[i] = last;
+    }
+
+    return top;
+}
+
+static int find_node(const struct sockaddr_un *addr, socklen_t addr_len)
+{
+    for (int i = 0; i < MEDIUM_MAX_NODES; i++) {
+        if (nodes[i].used && nodes[i].addr_len == addr_len &&
+            memcmp(&nodes[i].addr, addr, addr_len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int add_node(const struct sockaddr_un *addr, socklen_t addr_len)
+{
+    int i = find_node(addr, addr_len);
+    if (i >= 0) {
+        return i;
+    }
+
+    for (i = 0; i < MEDIUM_MAX_NODES; i++) {
+        if (!nodes[i].used) {
+            nodes[i].used = true;
+            nodes[i].addr = *addr;
+            nodes[i].addr_len = addr_len;
+            if (config.verbose) {
+                fprintf(stderr, "air_medium: node %d joined\n", i);
+            }
+            return i;
+        }
+    }
+
+    fprintf(stderr, "air_medium: too many nodes, ignoring registration\n");
+    return -1;
+}
+
+static void remove_node(int i)
+{
+    nodes[i].used = false;
+    if (config.verbose) {
+        fprintf(stderr, "air_medium: node %d left\n", i);
+    }
+}
+
+/* Put a frame on the channel and schedule its deliveries */
+static void transmit(int sender, const air_msg_header_t *header, const uint8_t *frame,
+                     uint64_t now, uint64_t *channel_free_at)
+{
+    static uint64_t seq;
+
+    stats.frames_in++;
+    stats.bytes_in += header->len;
+
+    // Airtime on a shared channel: the frame starts when the channel frees up
+    uint64_t airtime = config.overhead_us;
+    if (config.bitrate_kbps > 0) {
+        airtime += ((uint64_t)header->len * 8u * 1000u + config.bitrate_kbps - 1) / config.bitrate_kbps;
+    }
+
+    uint64_t start = *channel_free_at > now ? *channel_free_at : now;
+    if (start - now > config.queue_us) {
+        stats.queue_drops++;
+        return;
+    }
+    *channel_free_at = start + airtime;
+    stats.airtime_us += airtime;
+
+    for (int i = 0; i < MEDIUM_MAX_NODES; i++) {
+        if (!nodes[i].used || i == sender) {
+            continue;
+        }
+        if (config.loss > 0 && rng_uniform() < config.loss) {
+            stats.lost++;
+            continue;
+        }
+        if (heap_len == MEDIUM_MAX_PENDING) {
+            stats.overflow_drops++;
+            continue;
+        }
+
+        int64_t jitter = 0;
+        if (config.jitter_us > 0) {
+            jitter = (int64_t)(rng_next() % (2u * config.jitter_us + 1)) - config.jitter_us;
+        }
+        int64_t delay = (int64_t)config.delay_us + jitter;
+
+        pending_t *p = malloc(sizeof(*p));
+        if (p == NULL) {
+            stats.overflow_drops++;
+            continue;
+        }
+        p->deliver_at = *channel_free_at + (delay > 0 ? (uint64_t)delay : 0);
+        p->seq = seq++;
+        p->tx_time_us = header->tx_time_us;
+        p->node = i;
+        p->len = header->len;
+        memcpy(p->frame, frame, header->len);
+        heap_push(p);
+    }
+}
+
+/* Hand every due frame to its receiver */
+static void deliver_due(int fd, uint64_t now)
+{
+    while (heap_len > 0 && heap[0]->deliver_at <= now) {
+        pending_t *p = heap_pop();
+
+        if (nodes[p->node].used) {
+            air_msg_header_t header = {
+                .magic = AIR_MAGIC,
+                .type = AIR_MSG_FRAME,
+                .len = p->len,
+                .tx_time_us = p->tx_time_us,
+                .rx_time_us = air_now_us(),
+            };
+            uint8_t buf[sizeof(header) + AIR_MAX_FRAME];
+            memcpy(buf, &header, sizeof(header));
+            memcpy(buf + sizeof(header), p->frame, p->len);
+
+            if (sendto(fd, buf, sizeof(header) + p->len, MSG_DONTWAIT,
+                       (struct sockaddr *)&nodes[p->node].addr, nodes[p->node].addr_len) < 0) {
+                stats.send_errors++;
+                if (errno == ECONNREFUSED || errno == ENOENT) {
+                    remove_node(p->node);  // Receiver exited without saying goodbye
+                }
+            } else {
+                stats.deliveries++;
+            }
+        }
+
+        free(p);
+    }
+}
+
+static void print_stats(uint64_t elapsed_us)
+{
+    double elapsed_s = elapsed_us / 1e6;
+
+    printf("medium=%s elapsed_s=%.3f\n", config.name, elapsed_s);
+    printf("frames_in=%u bytes_in=%llu deliveries=%u lost=%u queue_drops=%u overflow_drops=%u send_errors=%u\n",
+           stats.frames_in, (unsigned long long)stats.bytes_in, stats.deliveries, stats.lost,
+           stats.queue_drops, stats.overflow_drops, stats.send_errors);
+    printf("channel_utilization=%.1f%%\n",
+           elapsed_us > 0 ? 100.0 * stats.airtime_us / elapsed_us : 0.0);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-n name] [-l loss_pct] [-d delay_ms] [-j jitter_ms]\n"
+            "          [-b bitrate_kbps] [-o overhead_us] [-q queue_ms] [-s seed]\n"
+            "          [-T seconds] [-v]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "n:l:d:j:b:o:q:s:T:vh")) != -1) {
+        switch (opt) {
+            case 'n': config.name = optarg; break;
+            case 'l': config.loss = atof(optarg) / 100.0; break;
+            case 'd': config.delay_us = (uint32_t)(atof(optarg) * 1000.0); break;
+            case 'j': config.jitter_us = (uint32_t)(atof(optarg) * 1000.0); break;
+            case 'b': config.bitrate_kbps = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'o': config.overhead_us = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'q': config.queue_us = (uint32_t)strtoul(optarg, NULL, 10) * 1000u; break;
+            case 's': config.seed = strtoull(optarg, NULL, 10); break;
+            case 'T': config.duration_s = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'v': config.verbose = true; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (config.loss < 0 || config.loss > 1) {
+        fprintf(stderr, "air_medium: loss must be between 0 and 100%%\n");
+        return 2;
+    }
+    rng_state = config.seed != 0 ? config.seed : 1;
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("air_medium: socket");
+        return 1;
+    }
+
+    struct sockaddr_un addr;
+    size_t addr_len = air_medium_addr(config.name, &addr);
+    if (bind(fd, (struct sockaddr *)&addr, addr_len) < 0) {
+        perror("air_medium: bind (is another medium with this name running?)");
+        return 1;
+    }
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    fprintf(stderr, "air_medium: '%s' up (loss %.1f%%, delay %u us, jitter %u us, %u kbit/s)\n",
+            config.name, config.loss * 100.0, config.delay_us, config.jitter_us, config.bitrate_kbps);
+
+    uint64_t started = air_now_us();
+    uint64_t channel_free_at = 0;
+    uint8_t buf[sizeof(air_msg_header_t) + AIR_MAX_FRAME];
+
+    while (!stop_requested) {
+        uint64_t now = air_now_us();
+        if (config.duration_s > 0 && now - started >= (uint64_t)config.duration_s * 1000000u) {
+            break;
+        }
+
+        deliver_due(fd, now);
+
+        // Sleep until the next delivery is due or a frame arrives
+        struct timespec timeout = { .tv_sec = 0, .tv_nsec = 100 * 1000000 };
+        if (heap_len > 0) {
+            uint64_t wait = heap[0]->deliver_at > now ? heap[0]->deliver_at - now : 0;
+            if (wait < 100000) {
+                timeout.tv_nsec = (long)wait * 1000;
+            }
+        }
+
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (ppoll(&pfd, 1, &timeout, NULL) <= 0) {
+            continue;
+        }
+
+        struct sockaddr_un from;
+        socklen_t from_len = sizeof(from);
+        ssize_t n = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        if (n < (ssize_t)sizeof(air_msg_header_t)) {
+            continue;
+        }
+
+        air_msg_header_t header;
+        memcpy(&header, buf, sizeof(header));
+        if (header.magic != AIR_MAGIC || header.len != (size_t)n - sizeof(header)) {
+            continue;
+        }
+
+        switch (header.type) {
+            case AIR_MSG_HELLO:
+                add_node(&from, from_len);
+                break;
+            case AIR_MSG_BYE: {
+                int i = find_node(&from, from_len);
+                if (i >= 0) {
+                    remove_node(i);
+                }
+                break;
+            }
+            case AIR_MSG_FRAME: {
+                // A node that sends without a HELLO (e.g. after a medium restart) joins now
+                int sender = add_node(&from, from_len);
+                transmit(sender, &header, buf + sizeof(header), air_now_us(), &channel_free_at);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    print_stats(air_now_us() - started);
+
+    while (heap_len > 0) {
+        free(heap_pop());
+    }
+    close(fd);
+
+    return 0;
+}
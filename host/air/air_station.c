@@ -0,0 +1,390 @@
+/**
+ * @file air_station.c
+ * @brief Host station: the portable scheduler core sending over the virtual air
+ *
+ * Runs the same loop as the firmware station: periodic packet creation per
+ * class, sched_core batch assembly when the earliest deadline is within
+ * the processing threshold, and one raw frame per batch, built with
+ * frame_codec and handed to air_tx() instead of esp_wifi_80211_tx().
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/air -Icomponents/sched_core/include \
+ *       host/air/air_station.c host/air/air.c \
+ *       components/sched_core/{sched_types,sample_codec,record_schema,sample_time,sample_held}.c \
+ *       components/sched_core/{sched_queue,sched_core,frame_codec,crc32c}.c \
+ *       -lpthread -o /tmp/air_station
+ *
+ * Usage:
+ *   air_station [-m medium] [-c class=period,deadline,type,count]... [-t threshold_ms]
+ *               [-S class_mask] [-w ac,ac,ac,ac] [-D class=deadband[,keyframe_ms]]...
+ *               [-E] [-T seconds] [-q]
+ *
+ * Classes default to the firmware defaults (class 1: 3000 ms INT32 x5,
+ * class 2: 5000 ms FLOAT x4, class 3: 6000 ms INT16 x6, class 4 off).
+ * -S sets the classes that send per-sample times (bit 0 = class 1) and
+ * -w sends QoS data frames with the given per-class access categories.
+ * -D puts a class in send-on-delta mode; created packets never change, so
+ * after the first only keyframes go out (none without keyframe_ms).
+ * -E sends the frame body in ESP-NOW action frames, for an AP run with -E;
+ * batches are then limited to what fits in AIR_ESPNOW_MAX_DATA.
+ * Add -DCONFIG_SCHED_POLICY_EDF to build the EDF batch policy.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "air.h"
+#include "sched_core.h"
+#include "frame_codec.h"
+#include "sample_codec.h"
+#include "sample_held.h"
+
+#define STATION_TICK_MS            10      // Scheduler loop interval
+#define DEFAULT_PROCESSING_THRESHOLD 1000
+
+/* Largest batch whose frame body fits in an ESP-NOW frame */
+#define ESPNOW_MAX_TX_SIZE  (AIR_ESPNOW_MAX_DATA - sizeof(data_packet_header_t) - \
+                             SAMPLE_TIME_MAX_LEN - FRAME_CRC_LEN)
+
+/* Station configuration */
+typedef struct {
+    const char *medium;
+    uint32_t class_periods[MAX_CLASSES];
+    uint32_t class_deadlines[MAX_CLASSES];
+    data_type_t class_types[MAX_CLASSES];
+    uint16_t class_counts[MAX_CLASSES];       // Elements per created packet
+    uint32_t processing_threshold;
+    class_mask_t sample_time_mask;
+    class_mask_t dedup_mask;
+    double dedup_deadband[MAX_CLASSES];
+    uint32_t dedup_keyframe_ms[MAX_CLASSES];
+    bool wmm_enabled;
+    wmm_ac_t class_access[MAX_CLASSES];
+    bool espnow;                              // Send frame bodies as ESP-NOW frames
+    uint32_t duration_s;
+    bool quiet;
+} station_config_t;
+
+/* Station statistics */
+typedef struct {
+    uint32_t packets_created;
+    uint32_t submit_errors;
+    uint32_t frames_sent;
+    uint32_t tx_errors;
+    uint64_t bytes_sent;         // Scheduler payload bytes (class data + time blocks)
+} station_stats_t;
+
+static station_config_t config = {
+    .medium = AIR_DEFAULT_MEDIUM,
+    .class_periods = {3000, 5000, 6000, 0},
+    .class_deadlines = {3000, 5000, 6000, 2000},
+    .class_types = {DATA_TYPE_INT32, DATA_TYPE_FLOAT, DATA_TYPE_INT16, DATA_TYPE_INT32},
+    .class_counts = {5, 4, 6, 0},
+    .processing_threshold = DEFAULT_PROCESSING_THRESHOLD,
+    .class_access = {WMM_AC_BE, WMM_AC_BE, WMM_AC_BE, WMM_AC_BE},
+};
+
+static sched_core_t core;
+static station_stats_t stats;
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(air_now_us() / 1000u);
+}
+
+static void sleep_ms(uint32_t ms)
+{
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/* Queue one packet of sequential test values, like the firmware packet generator */
+static void create_packet(class_id_t class_id, uint32_t now)
+{
+    uint16_t count = config.class_counts[class_id];
+    double values[MAX_PACKET_SIZE];
+    uint64_t native[MAX_PACKET_SIZE / sizeof(uint64_t)];
+
+    if ((size_t)count * data_type_size(config.class_types[class_id]) > sizeof(native)) {
+        stats.submit_errors++;
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        values[i] = i;
+    }
+    sample_narrow(config.class_types[class_id], native, values, count);
+
+    if (sched_core_submit(&core, class_id, native, count, now) == SCHED_OK) {
+        stats.packets_created++;
+    } else {
+        stats.submit_errors++;
+    }
+}
+
+/* Assemble a batch and put it on the air */
+static void send_batch(air_node_t *node, const frame_addr_t *addr, uint32_t now)
+{
+    uint8_t data[MAX_TX_SIZE + SAMPLE_TIME_MAX_LEN];
+    uint8_t frame[FRAME_MAX_LEN + AIR_ESPNOW_HEADER_LEN];
+    sched_batch_t batch = {0};
+
+    uint16_t capacity = MAX_TX_SIZE;
+    if (config.espnow && ESPNOW_MAX_TX_SIZE < capacity) {
+        capacity = ESPNOW_MAX_TX_SIZE;
+    }
+    capacity -= core.dedup_mask != 0 ? SAMPLE_HELD_MAX_LEN : 0;
+    uint16_t size = sched_core_build_batch(&core, now, data, capacity, &batch);
+    if (size == 0) {
+        return;
+    }
+
+    data_packet_header_t header = {0};
+    memcpy(header.class_counts, batch.class_counts, sizeof(header.class_counts));
+    memcpy(header.class_types, core.class_types, sizeof(header.class_types));
+    header.timestamp = now_ms();
+
+    if (batch.held.count > 0 || batch.held.mark_count > 0) {
+        size_t held_len = sample_held_encode(data + size, SAMPLE_HELD_MAX_LEN, &batch.held);
+        if (held_len > 0) {
+            header.flags |= FRAME_FLAG_HELD;
+            size += held_len;
+        }
+    }
+
+    if (batch.times.class_mask != 0) {
+        size_t time_len = sample_time_encode(data + size, SAMPLE_TIME_MAX_LEN, header.timestamp,
+                                             core.class_periods, &batch.times);
+        if (time_len > 0) {
+            header.flags |= FRAME_FLAG_SAMPLE_TIMES;
+            size += time_len;
+        }
+    }
+    header.total_size = size;
+
+    size_t frame_len;
+    if (config.espnow) {
+        // The action frame replaces the data header; the AP rebuilds it
+        uint8_t body[FRAME_MAX_LEN];
+        size_t body_len = frame_build(body, sizeof(body), addr, &header, data);
+        frame_len = body_len > WIFI_DATA_HEADER_LEN ?
+            air_espnow_encode(frame, sizeof(frame), addr->da, addr->sa, body + WIFI_DATA_HEADER_LEN,
+                              body_len - WIFI_DATA_HEADER_LEN) : 0;
+    } else if (config.wmm_enabled) {
+        wmm_ac_t ac = frame_access_category(header.class_counts, config.class_access);
+        frame_len = frame_build_qos(frame, sizeof(frame), addr, ac, &header, data);
+    } else {
+        frame_len = frame_build(frame, sizeof(frame), addr, &header, data);
+    }
+
+    if (frame_len == 0 || air_tx(node, frame, frame_len) < 0) {
+        stats.tx_errors++;
+        return;
+    }
+
+    sched_core_batch_sent(&core, &batch);
+    stats.frames_sent++;
+    stats.bytes_sent += size;
+
+    if (!config.quiet) {
+        printf("tx t=%lu size=%u counts=%u,%u,%u,%u misses=%u,%u,%u,%u\n",
+               (unsigned long)header.timestamp, size,
+               batch.class_counts[0], batch.class_counts[1], batch.class_counts[2], batch.class_counts[3],
+               batch.class_misses[0], batch.class_misses[1], batch.class_misses[2], batch.class_misses[3]);
+    }
+}
+
+/* Parse "class=period,deadline,type,count" */
+static bool parse_class(const char *spec)
+{
+    int class_num;
+    unsigned long period, deadline, count;
+    char type[16];
+
+    if (sscanf(spec, "%d=%lu,%lu,%15[^,],%lu", &class_num, &period, &deadline, type, &count) != 5 ||
+        class_num < 1 || class_num > MAX_CLASSES || count > UINT8_MAX) {
+        return false;
+    }
+
+    data_type_t data_type;
+    if (!data_type_from_option(type, &data_type) || data_type_is_schema(data_type)) {
+        return false;
+    }
+
+    config.class_periods[class_num - 1] = (uint32_t)period;
+    config.class_deadlines[class_num - 1] = (uint32_t)deadline;
+    config.class_types[class_num - 1] = data_type;
+    config.class_counts[class_num - 1] = (uint16_t)count;
+    return true;
+}
+
+/* Parse "class=deadband[,keyframe_ms]" */
+static bool parse_dedup(const char *spec)
+{
+    int class_num;
+    double deadband;
+    unsigned long keyframe = 0;
+
+    int n = sscanf(spec, "%d=%lf,%lu", &class_num, &deadband, &keyframe);
+    if (n < 2 || class_num < 1 || class_num > MAX_CLASSES || !(deadband >= 0)) {
+        return false;
+    }
+
+    config.dedup_mask |= 1u << (class_num - 1);
+    config.dedup_deadband[class_num - 1] = deadband;
+    config.dedup_keyframe_ms[class_num - 1] = (uint32_t)keyframe;
+    return true;
+}
+
+/* Parse "vo,vi,be,bk" */
+static bool parse_access(char *list)
+{
+    char *save = NULL;
+    int i = 0;
+
+    for (char *tok = strtok_r(list, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        if (i >= MAX_CLASSES || !wmm_ac_from_option(tok, &config.class_access[i])) {
+            return false;
+        }
+        i++;
+    }
+
+    config.wmm_enabled = true;
+    return i > 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-m medium] [-c class=period,deadline,type,count]... [-t threshold_ms]\n"
+            "          [-S class_mask] [-w ac,ac,ac,ac] [-D class=deadband[,keyframe_ms]]...\n"
+            "          [-E] [-T seconds] [-q]\n"
+            "Example: %s -c 1=100,100,int16,10 -c 2=1000,500,float,4 -T 10\n", prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "m:c:t:S:w:D:ET:qh")) != -1) {
+        switch (opt) {
+            case 'm': config.medium = optarg; break;
+            case 'c':
+                if (!parse_class(optarg)) {
+                    fprintf(stderr, "air_station: bad class spec '%s'\n", optarg);
+                    return 2;
+                }
+                break;
+            case 't': config.processing_threshold = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'S': config.sample_time_mask = (class_mask_t)strtoul(optarg, NULL, 0); break;
+            case 'w':
+                if (!parse_access(optarg)) {
+                    fprintf(stderr, "air_station: bad access category list\n");
+                    return 2;
+                }
+                break;
+            case 'D':
+                if (!parse_dedup(optarg)) {
+                    fprintf(stderr, "air_station: bad send-on-delta spec '%s'\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'E': config.espnow = true; break;
+            case 'T': config.duration_s = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'q': config.quiet = true; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+
+    sched_core_init(&core);
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        core.class_types[i] = config.class_types[i];
+        core.class_periods[i] = config.class_periods[i];
+        core.class_deadlines[i] = config.class_deadlines[i];
+    }
+    core.processing_threshold = config.processing_threshold;
+    core.sample_time_mask = config.sample_time_mask;
+    core.dedup_mask = config.dedup_mask;
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        core.dedup_deadband[i] = config.dedup_deadband[i];
+        core.dedup_keyframe_ms[i] = config.dedup_keyframe_ms[i];
+    }
+
+    air_node_t node;
+    if (air_open(&node, config.medium) < 0) {
+        fprintf(stderr, "air_station: cannot reach medium '%s': %s\n", config.medium, strerror(errno));
+        return 1;
+    }
+
+    frame_addr_t addr = { .da = AIR_AP_MAC, .sa = AIR_STA_MAC, .bssid = AIR_AP_MAC };
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    fprintf(stderr, "air_station: policy %s, threshold %lu ms, medium '%s', %s frames\n",
+            SCHED_POLICY_NAME, (unsigned long)config.processing_threshold, config.medium,
+            config.espnow ? "ESP-NOW" : "data");
+
+    uint32_t started = now_ms();
+    uint32_t last_created[MAX_CLASSES];
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        last_created[i] = started;
+    }
+
+    while (!stop_requested) {
+        uint32_t now = now_ms();
+        if (config.duration_s > 0 && now - started >= config.duration_s * 1000u) {
+            break;
+        }
+
+        for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+            if (config.class_periods[class_id] > 0 && config.class_counts[class_id] > 0 &&
+                now - last_created[class_id] >= config.class_periods[class_id]) {
+                create_packet(class_id, now);
+                last_created[class_id] = now;
+            }
+        }
+
+        if (core.dedup_mask != 0) {
+            sched_core_dedup_tick(&core, now);
+        }
+        if (sched_core_due(&core, now)) {
+            send_batch(&node, &addr, now);
+        }
+
+        sleep_ms(STATION_TICK_MS);
+    }
+
+    uint32_t elapsed = now_ms() - started;
+    air_close(&node);
+
+    printf("station elapsed_ms=%lu policy=%s\n", (unsigned long)elapsed, SCHED_POLICY_NAME);
+    printf("packets_created=%u submit_errors=%u packets_transmitted=%lu deadline_misses=%lu\n",
+           stats.packets_created, stats.submit_errors,
+           (unsigned long)core.packets_transmitted, (unsigned long)core.deadline_misses);
+    printf("frames_sent=%u tx_errors=%u bytes_sent=%llu throughput_bps=%.0f\n",
+           stats.frames_sent, stats.tx_errors, (unsigned long long)stats.bytes_sent,
+           elapsed > 0 ? stats.bytes_sent * 8000.0 / elapsed : 0.0);
+    for (int i = 0; i < MAX_CLASSES; i++) {
+        if (core.dedup_mask & (1u << i)) {
+            printf("dedup class=%d held_groups=%lu held_bytes=%lu frames_avoided=%lu\n", i + 1,
+                   (unsigned long)core.dedup[i].held_groups, (unsigned long)core.dedup[i].held_bytes,
+                   (unsigned long)core.dedup[i].frames_avoided);
+        }
+    }
+
+    return 0;
+}
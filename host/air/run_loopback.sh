@@ -0,0 +1,52 @@
+#!/bin/sh
+# End-to-end run over the virtual air: medium, AP and station as separate processes.
+#
+# Usage (from the repository root):
+#   host/air/run_loopback.sh [seconds] [medium options...] [-- station options...]
+#
+# Example: 20 s at 1 Mbit/s with 5% loss and 10 +/- 5 ms delay, class 1 every 100 ms
+#   host/air/run_loopback.sh 20 -b 1000 -l 5 -d 10 -j 5 -- -c 1=100,100,int16,10 -q
+#
+# Binaries are built into $AIR_BUILD_DIR (default /tmp/air). Each process
+# prints its statistics as key=value lines on exit.
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+BUILD=${AIR_BUILD_DIR:-/tmp/air}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-O2 -std=c11 -D_GNU_SOURCE -Wall"}
+MEDIUM=loopback-$$
+
+DURATION=${1:-10}
+[ $# -gt 0 ] && shift
+
+MEDIUM_ARGS=""
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+    MEDIUM_ARGS="$MEDIUM_ARGS $1"
+    shift
+done
+[ "$1" = "--" ] && shift
+
+mkdir -p "$BUILD"
+INC="-I$ROOT/host/air -I$ROOT/components/sched_core/include"
+CORE="$ROOT/components/sched_core/*.c"
+$CC $CFLAGS $INC "$ROOT/host/air/air_medium.c" "$ROOT/host/air/air.c" -lpthread -o "$BUILD/air_medium"
+$CC $CFLAGS $INC "$ROOT/host/air/air_ap.c" "$ROOT/host/air/air.c" $CORE -lpthread -o "$BUILD/air_ap"
+$CC $CFLAGS $INC "$ROOT/host/air/air_station.c" "$ROOT/host/air/air.c" $CORE -lpthread -o "$BUILD/air_station"
+
+# The medium outlives both nodes so in-flight frames are still delivered
+"$BUILD/air_medium" -n "$MEDIUM" -T $((DURATION + 2)) $MEDIUM_ARGS > "$BUILD/medium.out" &
+MEDIUM_PID=$!
+sleep 0.2
+"$BUILD/air_ap" -m "$MEDIUM" -T $((DURATION + 1)) > "$BUILD/ap.out" &
+AP_PID=$!
+sleep 0.2
+"$BUILD/air_station" -m "$MEDIUM" -T "$DURATION" "$@" > "$BUILD/station.out"
+
+wait $AP_PID
+wait $MEDIUM_PID
+
+echo "== station"; tail -n 3 "$BUILD/station.out"
+echo "== medium";  cat "$BUILD/medium.out"
+echo "== ap";      cat "$BUILD/ap.out"
@@ -0,0 +1,1142 @@
+/**
+ * @file bench_store.c
+ * @brief Offline store and regression comparator for benchmark results
+ *
+ * Results are kept as the benchmarks printed them, one file per run:
+ *   <dir>/<machine>/<commit>/<bench>/<run>.json   (or .txt)
+ * so repeated runs of one benchmark on one machine at one commit are the
+ * samples for that commit. Two formats are read:
+ *   json       any JSON document (sched_bench); every number is a metric
+ *              named by its path, e.g. depth.points.3.submit_ns
+ *   key=value  the lines the host tools print (trace_stat, sim_validate,
+ *              sample_codec_bench, @BENCH lines from the link benchmarks);
+ *              each numeric key is a metric named by the line's first word
+ *              and its text values, e.g. codec.INT16.encode.mb_per_s
+ * A name that repeats within one run gets "#2", "#3", ... appended, so
+ * sweep points without a text label stay apart.
+ *
+ * compare takes the runs of two commits and, for every metric both have
+ * at least MIN_RUNS samples of, tests whether they differ with the
+ * Mann-Whitney U test (exact distribution for small samples without ties,
+ * normal approximation with tie correction otherwise). The p values are
+ * corrected for the number of metrics tested (Benjamini-Hochberg, -a is the
+ * false discovery rate), and a significant change larger than -p percent
+ * of the base median is a regression or an improvement depending on which
+ * way is better for the metric: *_per_s, fps and bps are better higher;
+ * times (_ns, _us, _ms, _s), percentages and error, loss, miss, drop and
+ * reject counts are better lower; anything else is only reported with -v.
+ * With four runs on each side the smallest possible p is 0.029, so record
+ * at least four runs per commit.
+ *
+ * The commit defaults to git rev-parse HEAD in the current directory
+ * ("-dirty" when tracked files have changes) and the machine to the host
+ * name and architecture. Nothing touches the network.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE host/bench/bench_store.c -lm -o /tmp/bench_store
+ *
+ * Usage:
+ *   bench_store [-d dir] [-m machine] [-c commit] [-b bench] add result...
+ *   bench_store [-d dir] list
+ *   bench_store [-d dir] [-m machine] [-a fdr] [-p percent] [-v] compare base new
+ *
+ * Example:
+ *   for i in 1 2 3 4 5; do /tmp/sched_bench > /tmp/sched_$i.json; done
+ *   bench_store add /tmp/sched_*.json
+ *   bench_store compare 4899283 b6bbb1b
+ */
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#define DEFAULT_DIR         "bench_results"
+#define DEFAULT_FDR         0.05        // Benjamini-Hochberg false discovery rate
+#define DEFAULT_MIN_PCT     5.0         // Smaller median changes are never reported
+#define MIN_RUNS            2           // Samples needed on each side to test a metric
+#define MW_EXACT_MAX        30          // Largest sample for the exact U distribution
+#define NAME_MAX_LEN        128         // Machine, commit and bench names
+#define PATH_LEN            1024
+#define METRIC_PATH_MAX     256
+#define JSON_DEPTH_MAX      32
+
+/* Samples of one metric */
+typedef struct {
+    char path[METRIC_PATH_MAX];
+    double *values;
+    int count;
+    int cap;
+} metric_t;
+
+typedef struct {
+    metric_t *items;
+    int count;
+    int cap;
+} metric_set_t;
+
+/* One tested metric, for the multiple-comparison correction */
+typedef struct {
+    int bench;                  // Index into the compared benches
+    int item;                   // Metric within the base set
+    double base_median;
+    double cur_median;
+    double change_pct;
+    double p;
+    bool significant;
+} result_t;
+
+typedef struct {
+    const char *dir;
+    const char *machine;
+    const char *commit;
+    const char *bench;
+    double fdr;
+    double min_pct;
+    bool verbose;
+} config_t;
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s [-d dir] [-m machine] [-c commit] [-b bench] add result...\n"
+            "  %s [-d dir] list\n"
+            "  %s [-d dir] [-m machine] [-a fdr] [-p percent] [-v] compare base new\n"
+            "  -d dir      result store (default %s)\n"
+            "  -m machine  machine key (default host name and architecture)\n"
+            "  -c commit   commit key for add (default git rev-parse HEAD)\n"
+            "  -b bench    benchmark name for add (default the JSON \"bench\" field\n"
+            "              or the file name)\n"
+            "  -a fdr      false discovery rate across tested metrics (default %g)\n"
+            "  -p percent  smallest median change reported (default %g)\n"
+            "  -v          also print unchanged, untested and undirected metrics\n",
+            argv0, argv0, argv0, DEFAULT_DIR, DEFAULT_FDR, DEFAULT_MIN_PCT);
+}
+
+/* ---- Metric sets ---- */
+
+static metric_t *metric_find(metric_set_t *set, const char *path)
+{
+    for (int i = 0; i < set->count; i++) {
+        if (strcmp(set->items[i].path, path) == 0) {
+            return &set->items[i];
+        }
+    }
+    return NULL;
+}
+
+static bool metric_add(metric_set_t *set, const char *path, double value)
+{
+    metric_t *m = metric_find(set, path);
+    if (m == NULL) {
+        if (set->count == set->cap) {
+            int cap = set->cap ? set->cap * 2 : 64;
+            metric_t *items = realloc(set->items, cap * sizeof(*items));
+            if (items == NULL) {
+                return false;
+            }
+            set->items = items;
+            set->cap = cap;
+        }
+        m = &set->items[set->count++];
+        memset(m, 0, sizeof(*m));
+        snprintf(m->path, sizeof(m->path), "%s", path);
+    }
+    if (m->count == m->cap) {
+        int cap = m->cap ? m->cap * 2 : 8;
+        double *values = realloc(m->values, cap * sizeof(*values));
+        if (values == NULL) {
+            return false;
+        }
+        m->values = values;
+        m->cap = cap;
+    }
+    m->values[m->count++] = value;
+    return true;
+}
+
+/* Add to a single run: a path seen before in the run gets "#n" */
+static bool run_add(metric_set_t *run, const char *path, double value)
+{
+    char unique[METRIC_PATH_MAX];
+    snprintf(unique, sizeof(unique), "%s", path);
+    for (int n = 2; metric_find(run, unique) != NULL; n++) {
+        snprintf(unique, sizeof(unique), "%.*s#%d", METRIC_PATH_MAX - 12, path, n);
+    }
+    return metric_add(run, unique, value);
+}
+
+static void metric_set_free(metric_set_t *set)
+{
+    for (int i = 0; i < set->count; i++) {
+        free(set->items[i].values);
+    }
+    free(set->items);
+    memset(set, 0, sizeof(*set));
+}
+
+/* ---- JSON ---- */
+
+typedef struct {
+    const char *p;
+    metric_set_t *run;
+    char bench[NAME_MAX_LEN];
+    int depth;
+} json_t;
+
+static void json_ws(json_t *j)
+{
+    while (isspace((unsigned char)*j->p)) {
+        j->p++;
+    }
+}
+
+/* Read a string, keeping at most cap - 1 bytes of it; escapes are kept as
+ * the escaped character, which is all a metric name needs */
+static bool json_string(json_t *j, char *out, size_t cap)
+{
+    size_t len = 0;
+
+    if (*j->p != '"') {
+        return false;
+    }
+    j->p++;
+    while (*j->p != '"') {
+        if (*j->p == '\0') {
+            return false;
+        }
+        if (*j->p == '\\' && j->p[1] != '\0') {
+            j->p++;
+        }
+        if (len + 1 < cap) {
+            out[len++] = *j->p;
+        }
+        j->p++;
+    }
+    j->p++;
+    out[len] = '\0';
+    return true;
+}
+
+static bool json_value(json_t *j, char *path, size_t path_len);
+
+static size_t path_push(char *path, size_t path_len, const char *name)
+{
+    int n = snprintf(path + path_len, METRIC_PATH_MAX - path_len, "%s%s",
+                     path_len > 0 ? "." : "", name);
+    return n < 0 || path_len + n >= METRIC_PATH_MAX ? METRIC_PATH_MAX - 1 : path_len + n;
+}
+
+static bool json_object(json_t *j, char *path, size_t path_len)
+{
+    j->p++;
+    json_ws(j);
+    if (*j->p == '}') {
+        j->p++;
+        return true;
+    }
+
+    for (;;) {
+        char key[METRIC_PATH_MAX];
+        json_ws(j);
+        if (!json_string(j, key, sizeof(key))) {
+            return false;
+        }
+        json_ws(j);
+        if (*j->p++ != ':') {
+            return false;
+        }
+        json_ws(j);
+
+        if (path_len == 0 && strcmp(key, "bench") == 0 && *j->p == '"') {
+            if (!json_string(j, j->bench, sizeof(j->bench))) {
+                return false;
+            }
+        } else {
+            size_t len = path_push(path, path_len, key);
+            if (!json_value(j, path, len)) {
+                return false;
+            }
+            path[path_len] = '\0';
+        }
+
+        json_ws(j);
+        if (*j->p == ',') {
+            j->p++;
+        } else if (*j->p == '}') {
+            j->p++;
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+static bool json_array(json_t *j, char *path, size_t path_len)
+{
+    j->p++;
+    json_ws(j);
+    if (*j->p == ']') {
+        j->p++;
+        return true;
+    }
+
+    for (int index = 0;; index++) {
+        char name[16];
+        snprintf(name, sizeof(name), "%d", index);
+        size_t len = path_push(path, path_len, name);
+        if (!json_value(j, path, len)) {
+            return false;
+        }
+        path[path_len] = '\0';
+
+        json_ws(j);
+        if (*j->p == ',') {
+            j->p++;
+        } else if (*j->p == ']') {
+            j->p++;
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+static bool json_value(json_t *j, char *path, size_t path_len)
+{
+    json_ws(j);
+
+    if (*j->p == '{' || *j->p == '[') {
+        if (++j->depth > JSON_DEPTH_MAX) {
+            return false;
+        }
+        bool ok = *j->p == '{' ? json_object(j, path, path_len) : json_array(j, path, path_len);
+        j->depth--;
+        return ok;
+    }
+    if (*j->p == '"') {
+        char skipped[8];
+        return json_string(j, skipped, sizeof(skipped));    // Text is not a metric
+    }
+    if (strncmp(j->p, "true", 4) == 0 || strncmp(j->p, "null", 4) == 0) {
+        j->p += 4;
+        return true;
+    }
+    if (strncmp(j->p, "false", 5) == 0) {
+        j->p += 5;
+        return true;
+    }
+
+    char *end;
+    double value = strtod(j->p, &end);
+    if (end == j->p) {
+        return false;
+    }
+    j->p = end;
+    return run_add(j->run, path_len > 0 ? path : "value", value);
+}
+
+/* ---- key=value lines ---- */
+
+/* Numeric value of a token, allowing a trailing '%' as in share=12.5% */
+static bool parse_number(const char *s, double *value)
+{
+    char *end;
+    *value = strtod(s, &end);
+    return end != s && (*end == '\0' || (end[0] == '%' && end[1] == '\0'));
+}
+
+static bool parse_lines(char *text, metric_set_t *run)
+{
+    for (char *line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        char *tokens[128];
+        int count = 0;
+        char *save;
+
+        for (char *t = strtok_r(line, " \t\r", &save); t != NULL && count < 128;
+             t = strtok_r(NULL, " \t\r", &save)) {
+            tokens[count++] = t;
+        }
+
+        // Name: the leading word, then every text value in order
+        char prefix[METRIC_PATH_MAX] = "";
+        size_t prefix_len = 0;
+        if (count > 0 && strchr(tokens[0], '=') == NULL) {
+            prefix_len = path_push(prefix, prefix_len, tokens[0]);
+        }
+        for (int i = 0; i < count; i++) {
+            char *eq = strchr(tokens[i], '=');
+            double value;
+            if (eq != NULL && eq != tokens[i] && !parse_number(eq + 1, &value) && eq[1] != '\0') {
+                prefix_len = path_push(prefix, prefix_len, eq + 1);
+            }
+        }
+
+        for (int i = 0; i < count; i++) {
+            char *eq = strchr(tokens[i], '=');
+            double value;
+            if (eq == NULL || eq == tokens[i] || !parse_number(eq + 1, &value)) {
+                continue;
+            }
+            *eq = '\0';
+            char path[METRIC_PATH_MAX];
+            memcpy(path, prefix, prefix_len + 1);
+            path_push(path, prefix_len, tokens[i]);
+            if (!run_add(run, path, value)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* ---- Files ---- */
+
+static char *read_all(const char *path, size_t *len)
+{
+    FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    size_t cap = 65536;
+    char *buf = malloc(cap);
+    *len = 0;
+    while (buf != NULL) {
+        size_t n = fread(buf + *len, 1, cap - *len - 1, f);
+        *len += n;
+        if (n == 0) {
+            break;
+        }
+        if (*len + 1 == cap) {
+            char *grown = realloc(buf, cap * 2);
+            if (grown == NULL) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+    }
+    if (buf != NULL) {
+        buf[*len] = '\0';
+    }
+    if (f != stdin) {
+        fclose(f);
+    }
+    return buf;
+}
+
+static bool is_json(const char *text)
+{
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    return *text == '{' || *text == '[';
+}
+
+/* Flatten one result into run; bench gets the JSON "bench" field if any */
+static bool parse_result(char *text, metric_set_t *run, char *bench, size_t bench_cap)
+{
+    if (!is_json(text)) {
+        return parse_lines(text, run);
+    }
+
+    json_t j = { .p = text, .run = run };
+    char path[METRIC_PATH_MAX] = "";
+    if (!json_value(&j, path, 0)) {
+        return false;
+    }
+    json_ws(&j);
+    if (*j.p != '\0') {
+        return false;
+    }
+    if (bench != NULL && j.bench[0] != '\0') {
+        snprintf(bench, bench_cap, "%s", j.bench);
+    }
+    return true;
+}
+
+/* Keys become directory names */
+static void sanitize(char *name)
+{
+    for (char *c = name; *c != '\0'; c++) {
+        if (!isalnum((unsigned char)*c) && *c != '-' && *c != '_' && *c != '.') {
+            *c = '_';
+        }
+    }
+    if (name[0] == '.') {
+        name[0] = '_';
+    }
+}
+
+static int mkdir_p(const char *path)
+{
+    char buf[PATH_LEN];
+    snprintf(buf, sizeof(buf), "%s", path);
+    for (char *c = buf + 1; *c != '\0'; c++) {
+        if (*c == '/') {
+            *c = '\0';
+            if (mkdir(buf, 0755) < 0 && errno != EEXIST) {
+                return -1;
+            }
+            *c = '/';
+        }
+    }
+    return mkdir(buf, 0755) < 0 && errno != EEXIST ? -1 : 0;
+}
+
+static void default_machine(char *out, size_t cap)
+{
+    char host[64] = "host";
+    struct utsname u;
+    gethostname(host, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    if (uname(&u) == 0) {
+        snprintf(out, cap, "%s-%s", host, u.machine);
+    } else {
+        snprintf(out, cap, "%s", host);
+    }
+    sanitize(out);
+}
+
+static bool default_commit(char *out, size_t cap)
+{
+    FILE *git = popen("git rev-parse --short=12 HEAD 2>/dev/null", "r");
+    if (git == NULL) {
+        return false;
+    }
+    bool ok = fgets(out, (int)cap, git) != NULL;
+    pclose(git);
+    out[strcspn(out, "\r\n")] = '\0';
+    if (!ok || out[0] == '\0') {
+        return false;
+    }
+
+    char line[8];
+    git = popen("git status --porcelain --untracked-files=no 2>/dev/null", "r");
+    if (git != NULL) {
+        if (fgets(line, sizeof(line), git) != NULL) {
+            strncat(out, "-dirty", cap - strlen(out) - 1);
+        }
+        pclose(git);
+    }
+    return true;
+}
+
+/* Bench name from a file name: basename without extension or trailing run number */
+static void bench_from_path(const char *path, char *out, size_t cap)
+{
+    const char *base = strrchr(path, '/');
+    snprintf(out, cap, "%s", base != NULL ? base + 1 : path);
+    char *dot = strchr(out, '.');
+    if (dot != NULL) {
+        *dot = '\0';
+    }
+    size_t len = strlen(out);
+    while (len > 1 && isdigit((unsigned char)out[len - 1])) {
+        len--;
+    }
+    if (len > 1 && len < strlen(out) && (out[len - 1] == '_' || out[len - 1] == '-')) {
+        out[len - 1] = '\0';
+    }
+}
+
+static int cmd_add(const config_t *config, int argc, char **argv)
+{
+    char machine[NAME_MAX_LEN];
+    char commit[NAME_MAX_LEN];
+
+    if (config->machine != NULL) {
+        snprintf(machine, sizeof(machine), "%s", config->machine);
+        sanitize(machine);
+    } else {
+        default_machine(machine, sizeof(machine));
+    }
+    if (config->commit != NULL) {
+        snprintf(commit, sizeof(commit), "%s", config->commit);
+    } else if (!default_commit(commit, sizeof(commit))) {
+        fprintf(stderr, "bench_store: not in a git checkout, give the commit with -c\n");
+        return 1;
+    }
+    sanitize(commit);
+
+    for (int i = 0; i < argc; i++) {
+        size_t len;
+        char *text = read_all(argv[i], &len);
+        if (text == NULL) {
+            fprintf(stderr, "bench_store: cannot read '%s': %s\n", argv[i], strerror(errno));
+            return 1;
+        }
+
+        // Parse a copy: the stored file is the result exactly as printed
+        char *copy = strdup(text);
+        metric_set_t run = {0};
+        char bench[NAME_MAX_LEN] = "";
+        bool ok = copy != NULL && parse_result(copy, &run, bench, sizeof(bench));
+        int metrics = run.count;
+        metric_set_free(&run);
+        free(copy);
+        if (!ok || metrics == 0) {
+            fprintf(stderr, "bench_store: '%s' holds no metrics%s\n", argv[i],
+                    is_json(text) ? " or is not valid JSON" : "");
+            free(text);
+            return 1;
+        }
+
+        if (config->bench != NULL) {
+            snprintf(bench, sizeof(bench), "%s", config->bench);
+        } else if (bench[0] == '\0') {
+            if (strcmp(argv[i], "-") == 0) {
+                fprintf(stderr, "bench_store: name the benchmark on stdin with -b\n");
+                free(text);
+                return 1;
+            }
+            bench_from_path(argv[i], bench, sizeof(bench));
+        }
+        sanitize(bench);
+
+        char dir[PATH_LEN];
+        snprintf(dir, sizeof(dir), "%s/%s/%s/%s", config->dir, machine, commit, bench);
+        if (mkdir_p(dir) < 0) {
+            fprintf(stderr, "bench_store: cannot create '%s': %s\n", dir, strerror(errno));
+            free(text);
+            return 1;
+        }
+
+        // Next free run number
+        char file[PATH_LEN + 32];
+        int run_id = 1;
+        for (;; run_id++) {
+            snprintf(file, sizeof(file), "%s/%04d.json", dir, run_id);
+            if (access(file, F_OK) == 0) {
+                continue;
+            }
+            snprintf(file, sizeof(file), "%s/%04d.txt", dir, run_id);
+            if (access(file, F_OK) == 0) {
+                continue;
+            }
+            break;
+        }
+        snprintf(file, sizeof(file), "%s/%04d.%s", dir, run_id, is_json(text) ? "json" : "txt");
+
+        FILE *out = fopen(file, "wx");
+        if (out == NULL || fwrite(text, 1, len, out) != len || fclose(out) != 0) {
+            fprintf(stderr, "bench_store: cannot write '%s': %s\n", file, strerror(errno));
+            free(text);
+            return 1;
+        }
+        free(text);
+
+        printf("added machine=%s commit=%s bench=%s run=%d metrics=%d file=%s\n",
+               machine, commit, bench, run_id, metrics, file);
+    }
+    return 0;
+}
+
+/* ---- Listing ---- */
+
+typedef int (*entry_cb_t)(const char *path, const char *name, void *ctx);
+
+/* Call cb for every entry of dir not starting with '.', in name order */
+static int for_each_entry(const char *dir, entry_cb_t cb, void *ctx)
+{
+    struct dirent **entries;
+    int count = scandir(dir, &entries, NULL, alphasort);
+    if (count < 0) {
+        return -1;
+    }
+
+    int ret = 0;
+    for (int i = 0; i < count; i++) {
+        if (ret == 0 && entries[i]->d_name[0] != '.') {
+            char path[PATH_LEN];
+            snprintf(path, sizeof(path), "%s/%s", dir, entries[i]->d_name);
+            ret = cb(path, entries[i]->d_name, ctx);
+        }
+        free(entries[i]);
+    }
+    free(entries);
+    return ret;
+}
+
+static int count_cb(const char *path, const char *name, void *ctx)
+{
+    (void)path;
+    (void)name;
+    (*(int *)ctx)++;
+    return 0;
+}
+
+typedef struct {
+    const char *machine;
+    const char *commit;
+} list_ctx_t;
+
+static int list_bench_cb(const char *path, const char *name, void *ctx)
+{
+    const list_ctx_t *l = ctx;
+    int runs = 0;
+    for_each_entry(path, count_cb, &runs);
+    printf("result machine=%s commit=%s bench=%s runs=%d\n", l->machine, l->commit, name, runs);
+    return 0;
+}
+
+static int list_commit_cb(const char *path, const char *name, void *ctx)
+{
+    list_ctx_t l = { .machine = ((list_ctx_t *)ctx)->machine, .commit = name };
+    for_each_entry(path, list_bench_cb, &l);
+    return 0;
+}
+
+static int list_machine_cb(const char *path, const char *name, void *ctx)
+{
+    (void)ctx;
+    list_ctx_t l = { .machine = name };
+    for_each_entry(path, list_commit_cb, &l);
+    return 0;
+}
+
+static int cmd_list(const config_t *config)
+{
+    if (for_each_entry(config->dir, list_machine_cb, NULL) < 0) {
+        fprintf(stderr, "bench_store: cannot read '%s': %s\n", config->dir, strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+/* ---- Statistics ---- */
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(const double *values, int count)
+{
+    double sorted[count];
+    memcpy(sorted, values, count * sizeof(*values));
+    qsort(sorted, count, sizeof(*sorted), compare_double);
+    return count % 2 ? sorted[count / 2] : 0.5 * (sorted[count / 2 - 1] + sorted[count / 2]);
+}
+
+typedef struct {
+    double value;
+    int group;
+} ranked_t;
+
+static int compare_ranked(const void *a, const void *b)
+{
+    return compare_double(&((const ranked_t *)a)->value, &((const ranked_t *)b)->value);
+}
+
+/* P(U <= u) and P(U >= u) under H0 from the exact distribution of U,
+ * counted with f(m, n, u) = f(m - 1, n, u - n) + f(m, n - 1, u) */
+static double mann_whitney_exact(int na, int nb, double u)
+{
+    int range = na * nb + 1;
+    double *f = calloc((size_t)(na + 1) * range, sizeof(*f));
+    if (f == NULL) {
+        return 1.0;
+    }
+    for (int m = 0; m <= na; m++) {
+        f[m * range] = 1.0;         // n = 0: only U = 0
+    }
+    for (int n = 1; n <= nb; n++) {
+        for (int m = 1; m <= na; m++) {
+            for (int k = range - 1; k >= n; k--) {
+                f[m * range + k] += f[(m - 1) * range + k - n];
+            }
+        }
+    }
+
+    double total = 0;
+    double low = 0;
+    double high = 0;
+    for (int k = 0; k < range; k++) {
+        double c = f[na * range + k];
+        total += c;
+        if (k <= u + 1e-9) {
+            low += c;
+        }
+        if (k >= u - 1e-9) {
+            high += c;
+        }
+    }
+    free(f);
+    return fmin(1.0, 2.0 * fmin(low, high) / total);
+}
+
+/* Two-sided Mann-Whitney U test of a against b */
+static double mann_whitney_p(const double *a, int na, const double *b, int nb)
+{
+    int n = na + nb;
+    ranked_t all[n];
+    for (int i = 0; i < na; i++) {
+        all[i] = (ranked_t){ a[i], 0 };
+    }
+    for (int i = 0; i < nb; i++) {
+        all[na + i] = (ranked_t){ b[i], 1 };
+    }
+    qsort(all, n, sizeof(*all), compare_ranked);
+
+    // Midranks; ties add t^3 - t to the variance correction
+    double rank_sum_a = 0;
+    double ties = 0;
+    for (int i = 0; i < n;) {
+        int j = i;
+        while (j + 1 < n && all[j + 1].value == all[i].value) {
+            j++;
+        }
+        double rank = 0.5 * (i + j) + 1.0;
+        for (int k = i; k <= j; k++) {
+            if (all[k].group == 0) {
+                rank_sum_a += rank;
+            }
+        }
+        double t = j - i + 1;
+        ties += t * t * t - t;
+        i = j + 1;
+    }
+    double u = rank_sum_a - 0.5 * na * (na + 1);
+
+    if (ties == 0 && na <= MW_EXACT_MAX && nb <= MW_EXACT_MAX) {
+        return mann_whitney_exact(na, nb, u);
+    }
+
+    double mean = 0.5 * na * nb;
+    double var = na * nb / 12.0 * ((n + 1) - ties / ((double)n * (n - 1)));
+    if (var <= 0) {
+        return 1.0;             // Every sample equal
+    }
+    double z = fmax(0.0, fabs(u - mean) - 0.5) / sqrt(var);
+    return erfc(z / sqrt(2.0));
+}
+
+/* +1 when higher is better, -1 when lower is better, 0 when unknown */
+static int metric_direction(const char *path)
+{
+    char leaf[METRIC_PATH_MAX];
+    const char *dot = strrchr(path, '.');
+    snprintf(leaf, sizeof(leaf), "%s", dot != NULL ? dot + 1 : path);
+    leaf[strcspn(leaf, "#")] = '\0';
+
+    size_t len = strlen(leaf);
+#define ENDS_WITH(s) (len >= sizeof(s) - 1 && strcmp(leaf + len - (sizeof(s) - 1), s) == 0)
+    if (strstr(leaf, "per_s") != NULL || ENDS_WITH("fps") || ENDS_WITH("bps") ||
+        strstr(leaf, "throughput") != NULL) {
+        return 1;
+    }
+    if (ENDS_WITH("_ns") || ENDS_WITH("_us") || ENDS_WITH("_ms") || ENDS_WITH("_s") ||
+        ENDS_WITH("_pct") || strstr(leaf, "err") != NULL || strstr(leaf, "loss") != NULL ||
+        strstr(leaf, "lost") != NULL || strstr(leaf, "miss") != NULL ||
+        strstr(leaf, "drop") != NULL || strstr(leaf, "reject") != NULL) {
+        return -1;
+    }
+#undef ENDS_WITH
+    return 0;
+}
+
+/* ---- Comparison ---- */
+
+/* Resolve a commit key or unique prefix of one under machine_dir */
+typedef struct {
+    const char *prefix;
+    char match[NAME_MAX_LEN];
+    int matches;
+    bool exact;
+} resolve_ctx_t;
+
+static int resolve_cb(const char *path, const char *name, void *ctx)
+{
+    (void)path;
+    resolve_ctx_t *r = ctx;
+    if (strcmp(name, r->prefix) == 0) {
+        snprintf(r->match, sizeof(r->match), "%s", name);
+        r->exact = true;
+    } else if (!r->exact && strncmp(name, r->prefix, strlen(r->prefix)) == 0) {
+        snprintf(r->match, sizeof(r->match), "%s", name);
+        r->matches++;
+    }
+    return 0;
+}
+
+static bool resolve_commit(const char *machine_dir, const char *prefix, char *out, size_t cap)
+{
+    resolve_ctx_t r = { .prefix = prefix };
+    if (for_each_entry(machine_dir, resolve_cb, &r) < 0) {
+        fprintf(stderr, "bench_store: cannot read '%s': %s\n", machine_dir, strerror(errno));
+        return false;
+    }
+    if (!r.exact && r.matches != 1) {
+        fprintf(stderr, "bench_store: %s commit '%s' in '%s'\n",
+                r.matches == 0 ? "no" : "ambiguous", prefix, machine_dir);
+        return false;
+    }
+    snprintf(out, cap, "%s", r.match);
+    return true;
+}
+
+/* Every run of one bench merged into one metric set */
+static int load_run_cb(const char *path, const char *name, void *ctx)
+{
+    (void)name;
+    size_t len;
+    char *text = read_all(path, &len);
+    if (text == NULL) {
+        fprintf(stderr, "bench_store: cannot read '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    metric_set_t run = {0};
+    bool ok = parse_result(text, &run, NULL, 0);
+    free(text);
+    if (!ok) {
+        fprintf(stderr, "bench_store: cannot parse '%s'\n", path);
+        metric_set_free(&run);
+        return -1;
+    }
+    for (int i = 0; i < run.count && ok; i++) {
+        ok = metric_add(ctx, run.items[i].path, run.items[i].values[0]);
+    }
+    metric_set_free(&run);
+    return ok ? 0 : -1;
+}
+
+/* Base and new runs of every bench both commits have, in pairs */
+typedef struct {
+    metric_set_t base;
+    metric_set_t cur;
+    char name[NAME_MAX_LEN];
+} bench_runs_t;
+
+typedef struct {
+    const config_t *config;
+    const char *cur_dir;            // <dir>/<machine>/<new commit>
+    bench_runs_t *benches;
+    int bench_count;
+    int bench_cap;
+    result_t *results;
+    int count;
+    int cap;
+    int untested;
+} compare_ctx_t;
+
+static int compare_bench_cb(const char *path, const char *name, void *ctx)
+{
+    compare_ctx_t *c = ctx;
+    char cur_path[PATH_LEN];
+    snprintf(cur_path, sizeof(cur_path), "%s/%s", c->cur_dir, name);
+    if (access(cur_path, F_OK) != 0) {
+        return 0;                   // Only benchmarks both commits ran
+    }
+
+    if (c->bench_count == c->bench_cap) {
+        int cap = c->bench_cap ? c->bench_cap * 2 : 16;
+        bench_runs_t *benches = realloc(c->benches, cap * sizeof(*benches));
+        if (benches == NULL) {
+            return -1;
+        }
+        c->benches = benches;
+        c->bench_cap = cap;
+    }
+    int bench = c->bench_count++;
+    bench_runs_t *runs = &c->benches[bench];
+    memset(runs, 0, sizeof(*runs));
+    snprintf(runs->name, sizeof(runs->name), "%s", name);
+    metric_set_t *base = &runs->base;
+    metric_set_t *cur = &runs->cur;
+    if (for_each_entry(path, load_run_cb, base) < 0 || for_each_entry(cur_path, load_run_cb, cur) < 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < base->count; i++) {
+        const metric_t *b = &base->items[i];
+        const metric_t *n = metric_find(cur, b->path);
+        if (n == NULL) {
+            continue;
+        }
+        if (b->count < MIN_RUNS || n->count < MIN_RUNS) {
+            c->untested++;
+            if (c->config->verbose) {
+                printf("untested bench=%s metric=%s runs=%d/%d\n", name, b->path, b->count, n->count);
+            }
+            continue;
+        }
+        if (c->count == c->cap) {
+            int cap = c->cap ? c->cap * 2 : 256;
+            result_t *results = realloc(c->results, cap * sizeof(*results));
+            if (results == NULL) {
+                return -1;
+            }
+            c->results = results;
+            c->cap = cap;
+        }
+        result_t *r = &c->results[c->count++];
+        r->bench = bench;
+        r->item = i;
+        r->base_median = median(b->values, b->count);
+        r->cur_median = median(n->values, n->count);
+        r->change_pct = r->base_median != 0
+            ? 100.0 * (r->cur_median - r->base_median) / fabs(r->base_median)
+            : (r->cur_median != 0 ? INFINITY : 0.0);
+        r->p = mann_whitney_p(b->values, b->count, n->values, n->count);
+    }
+    return 0;
+}
+
+static int compare_p(const void *a, const void *b)
+{
+    return compare_double(&(*(const result_t *const *)a)->p, &(*(const result_t *const *)b)->p);
+}
+
+static int cmd_compare(const config_t *config, const char *base_key, const char *cur_key)
+{
+    char machine[NAME_MAX_LEN];
+    if (config->machine != NULL) {
+        snprintf(machine, sizeof(machine), "%s", config->machine);
+        sanitize(machine);
+    } else {
+        default_machine(machine, sizeof(machine));
+    }
+
+    char machine_dir[PATH_LEN];
+    char base[NAME_MAX_LEN];
+    char cur[NAME_MAX_LEN];
+    snprintf(machine_dir, sizeof(machine_dir), "%s/%s", config->dir, machine);
+    if (!resolve_commit(machine_dir, base_key, base, sizeof(base)) ||
+        !resolve_commit(machine_dir, cur_key, cur, sizeof(cur))) {
+        return 2;
+    }
+
+    char base_dir[PATH_LEN + NAME_MAX_LEN];
+    char cur_dir[PATH_LEN + NAME_MAX_LEN];
+    snprintf(base_dir, sizeof(base_dir), "%s/%s", machine_dir, base);
+    snprintf(cur_dir, sizeof(cur_dir), "%s/%s", machine_dir, cur);
+
+    compare_ctx_t c = { .config = config, .cur_dir = cur_dir };
+    if (for_each_entry(base_dir, compare_bench_cb, &c) < 0) {
+        fprintf(stderr, "bench_store: cannot load results\n");
+        return 2;
+    }
+
+    // Benjamini-Hochberg: reject the k smallest p with p_(k) <= k / m * fdr
+    result_t **order = malloc((c.count + 1) * sizeof(*order));
+    if (order == NULL) {
+        return 2;
+    }
+    for (int i = 0; i < c.count; i++) {
+        order[i] = &c.results[i];
+    }
+    qsort(order, c.count, sizeof(*order), compare_p);
+    int rejected = 0;
+    for (int k = 1; k <= c.count; k++) {
+        if (order[k - 1]->p <= (double)k / c.count * config->fdr) {
+            rejected = k;
+        }
+    }
+    for (int k = 0; k < c.count; k++) {
+        order[k]->significant = k < rejected;
+    }
+    free(order);
+
+    int regressions = 0;
+    int improvements = 0;
+    int unchanged = 0;
+    for (int i = 0; i < c.count; i++) {
+        const result_t *r = &c.results[i];
+        bench_runs_t *runs = &c.benches[r->bench];
+        const metric_t *b = &runs->base.items[r->item];
+        const metric_t *n = metric_find(&runs->cur, b->path);
+        int direction = metric_direction(b->path);
+        bool changed = r->significant && fabs(r->change_pct) >= config->min_pct;
+        const char *verdict;
+
+        if (!changed) {
+            verdict = "same";
+            unchanged++;
+        } else if (direction == 0) {
+            verdict = "changed";
+        } else if ((r->cur_median - r->base_median) * direction < 0) {
+            verdict = "regression";
+            regressions++;
+        } else {
+            verdict = "improvement";
+            improvements++;
+        }
+
+        if (config->verbose || (changed && direction != 0)) {
+            printf("%s bench=%s metric=%s base=%.6g new=%.6g change_pct=%+.1f p=%.4g runs=%d/%d\n",
+                   verdict, runs->name, b->path, r->base_median, r->cur_median,
+                   r->change_pct, r->p, b->count, n->count);
+        }
+    }
+
+    printf("compare machine=%s base=%s new=%s benches=%d metrics=%d regressions=%d "
+           "improvements=%d unchanged=%d untested=%d fdr=%g min_pct=%g\n",
+           machine, base, cur, c.bench_count, c.count, regressions, improvements, unchanged,
+           c.untested, config->fdr, config->min_pct);
+
+    for (int i = 0; i < c.bench_count; i++) {
+        metric_set_free(&c.benches[i].base);
+        metric_set_free(&c.benches[i].cur);
+    }
+    free(c.benches);
+    free(c.results);
+    return regressions > 0 ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    config_t config = {
+        .dir = DEFAULT_DIR,
+        .fdr = DEFAULT_FDR,
+        .min_pct = DEFAULT_MIN_PCT,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:m:c:b:a:p:vh")) != -1) {
+        switch (opt) {
+            case 'd': config.dir = optarg; break;
+            case 'm': config.machine = optarg; break;
+            case 'c': config.commit = optarg; break;
+            case 'b': config.bench = optarg; break;
+            case 'a': config.fdr = atof(optarg); break;
+            case 'p': config.min_pct = atof(optarg); break;
+            case 'v': config.verbose = true; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc || config.fdr <= 0 || config.fdr >= 1 || config.min_pct < 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const char *command = argv[optind++];
+    if (strcmp(command, "add") == 0 && optind < argc) {
+        return cmd_add(&config, argc - optind, argv + optind);
+    }
+    if (strcmp(command, "list") == 0 && optind == argc) {
+        return cmd_list(&config);
+    }
+    if (strcmp(command, "compare") == 0 && optind + 2 == argc) {
+        return cmd_compare(&config, argv[optind], argv[optind + 1]);
+    }
+    usage(argv[0]);
+    return 2;
+}
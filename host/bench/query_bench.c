@@ -0,0 +1,303 @@
+/**
+ * @file query_bench.c
+ * @brief Host throughput benchmark for range and aggregate queries
+ *
+ * Fills a fresh database with sensor-like series (100 Hz, slowly drifting
+ * values) and reports rows/s, i.e. stored points in the queried range per
+ * second of query time, for:
+ *   kernel   - query_agg_range() alone on a decoded column
+ *   scan     - count/sum/min/max over everything, every block decoded
+ *   indexed  - the same query answered from the sparse index
+ *   filter   - a selective value filter that skips most blocks
+ *   group    - one-minute buckets, without and with a p99
+ * each with one worker thread and with one per online CPU.
+ *
+ * Every query result is checked against a plain tsdb_scan() of the same
+ * series before timing starts.
+ *
+ * Build and run from the repository root (add -march=native for the AVX kernels):
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/collector -Icomponents/sched_core/include \
+ *       host/bench/query_bench.c host/collector/{query,query_kernels,tsdb,gorilla}.c \
+ *       -lpthread -lm -o /tmp/query_bench
+ *   /tmp/query_bench [points] [dbdir]
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "query.h"
+#include "tsdb.h"
+
+#define DEFAULT_POINTS      32000000L
+#define STATIONS            8
+#define CLASSES             4
+#define SERIES              (STATIONS * CLASSES)
+#define PERIOD_MS           10
+#define START_MS            1700000000000LL
+#define KERNEL_ROWS         (1u << 20)
+#define REPEATS             3           // Best of, per measurement
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)rng_state;
+}
+
+/* Same shape as the ingest benchmark: a slow ramp with small noise */
+static double sensor_value(uint32_t series, long i)
+{
+    return (double)(int32_t)(1000 * series + (i / 64) % 500 + (rng_next() & 3));
+}
+
+static bool fill(const char *dir, long per_series)
+{
+    static tsdb_t db;
+    if (tsdb_open(&db, dir, true, 0) < 0) {
+        fprintf(stderr, "cannot open %s: %s\n", dir, strerror(errno));
+        return false;
+    }
+
+    uint32_t ids[SERIES];
+    for (uint32_t s = 0; s < SERIES; s++) {
+        tsdb_series_key_t key = { .station = {0x02, 0, 0, 0, 0, (uint8_t)(s / CLASSES)},
+                                  .class_id = (uint8_t)(s % CLASSES) };
+        ids[s] = (uint32_t)tsdb_series(&db, &key, 0);
+    }
+
+    for (long i = 0; i < per_series; i++) {
+        for (uint32_t s = 0; s < SERIES; s++) {
+            if (tsdb_append(&db, ids[s], START_MS + i * PERIOD_MS, sensor_value(s, i)) < 0) {
+                fprintf(stderr, "append failed: %s\n", strerror(errno));
+                return false;
+            }
+        }
+    }
+    tsdb_close(&db);
+    return true;
+}
+
+/* Reference answer from tsdb_scan(): every point of a series with its bucket */
+typedef struct {
+    const query_t *q;
+    int64_t origin;
+    query_agg_t *aggs;
+    double **values;
+    size_t *counts;
+    size_t bucket_count;
+} reference_t;
+
+static void on_point(int64_t time, double value, void *ctx)
+{
+    reference_t *ref = ctx;
+    if (!(value >= ref->q->v_lo && value <= ref->q->v_hi)) {
+        return;
+    }
+    size_t b = ref->q->bucket_ms > 0 ? (size_t)((time - ref->origin) / ref->q->bucket_ms) : 0;
+    if (b >= ref->bucket_count) {
+        return;
+    }
+    query_agg_t one = { .count = 1, .sum = value, .min = value, .max = value };
+    query_agg_merge(&ref->aggs[b], &one);
+    size_t n = ref->counts[b];
+    if ((n & (n - 1)) == 0) {
+        // Grow at powers of two
+        ref->values[b] = realloc(ref->values[b], (n ? 2 * n : 1) * sizeof(double));
+    }
+    ref->values[b][ref->counts[b]++] = value;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Compare a query result against tsdb_scan() of the same series */
+static bool check(const tsdb_t *db, const uint32_t *ids, size_t id_count, const query_t *base,
+                  const char *name)
+{
+    query_t threaded = *base;
+    const query_t *q = &threaded;
+    threaded.threads = 4;       // Exercise the merge even on one CPU
+
+    query_result_t result;
+    if (query_run(db, ids, id_count, q, &result) < 0) {
+        fprintf(stderr, "%s: query failed: %s\n", name, strerror(errno));
+        return false;
+    }
+
+    reference_t ref = {
+        .q = q,
+        .origin = result.bucket_count > 0 ? result.buckets[0].start : 0,
+        .bucket_count = result.bucket_count,
+        .aggs = malloc((result.bucket_count + 1) * sizeof(query_agg_t)),
+        .values = calloc(result.bucket_count + 1, sizeof(double *)),
+        .counts = calloc(result.bucket_count + 1, sizeof(size_t)),
+    };
+    for (size_t b = 0; b < result.bucket_count; b++) {
+        query_agg_init(&ref.aggs[b]);
+    }
+    for (size_t i = 0; i < id_count; i++) {
+        tsdb_scan(db, ids[i], q->t_from, q->t_to, on_point, &ref);
+    }
+
+    bool ok = true;
+    for (size_t b = 0; b < result.bucket_count && ok; b++) {
+        const query_agg_t *got = &result.buckets[b].agg;
+        const query_agg_t *want = &ref.aggs[b];
+        ok = got->count == want->count && got->sum == want->sum &&
+             (got->count == 0 || (got->min == want->min && got->max == want->max));
+        if (ok && q->quantile >= 0 && ref.counts[b] > 0) {
+            qsort(ref.values[b], ref.counts[b], sizeof(double), compare_double);
+            double rank = ceil(q->quantile * (double)ref.counts[b]);
+            size_t k = rank < 1 ? 0 : (size_t)rank - 1;
+            ok = result.buckets[b].quantile == ref.values[b][k < ref.counts[b] ? k : ref.counts[b] - 1];
+        }
+        if (!ok) {
+            fprintf(stderr, "%s: bucket %zu differs from tsdb_scan()\n", name, b);
+        }
+    }
+
+    for (size_t b = 0; b <= result.bucket_count; b++) {
+        free(ref.values[b]);
+    }
+    free(ref.values);
+    free(ref.counts);
+    free(ref.aggs);
+    query_result_free(&result);
+    return ok;
+}
+
+static void bench(const tsdb_t *db, const uint32_t *ids, size_t id_count, const query_t *base,
+                  const char *name, long rows, int cpus)
+{
+    int thread_counts[2] = {1, cpus};
+    for (int t = 0; t < (cpus > 1 ? 2 : 1); t++) {
+        query_t q = *base;
+        q.threads = thread_counts[t];
+
+        double best = INFINITY;
+        query_result_t result = {0};
+        for (int r = 0; r < REPEATS; r++) {
+            query_result_free(&result);
+            double start = now_s();
+            if (query_run(db, ids, id_count, &q, &result) < 0) {
+                fprintf(stderr, "%s: query failed: %s\n", name, strerror(errno));
+                return;
+            }
+            double elapsed = now_s() - start;
+            best = elapsed < best ? elapsed : best;
+        }
+        printf("%-8s threads=%-3d %10.1f Mrows/s  blocks %llu skipped %llu indexed %llu decoded %llu\n",
+               name, result.threads, rows / best / 1e6,
+               (unsigned long long)result.blocks, (unsigned long long)result.blocks_skipped,
+               (unsigned long long)result.blocks_indexed, (unsigned long long)result.blocks_decoded);
+        query_result_free(&result);
+    }
+}
+
+static void bench_kernel(void)
+{
+    double *v = malloc(KERNEL_ROWS * sizeof(*v));
+    if (v == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < KERNEL_ROWS; i++) {
+        v[i] = sensor_value(0, i);
+    }
+
+    const int iterations = 200;
+    query_agg_t agg;
+    query_agg_init(&agg);
+    double start = now_s();
+    for (int it = 0; it < iterations; it++) {
+        query_agg_range(v, KERNEL_ROWS, 100.0, 400.0, &agg);
+    }
+    double elapsed = now_s() - start;
+    printf("%-8s %-11s %10.1f Mrows/s  (%llu matched)\n", "kernel", query_kernel_name,
+           (double)KERNEL_ROWS * iterations / elapsed / 1e6, (unsigned long long)agg.count);
+    free(v);
+}
+
+int main(int argc, char **argv)
+{
+    long points = argc > 1 ? strtol(argv[1], NULL, 0) : DEFAULT_POINTS;
+    char dir[64] = "/tmp/query_bench.XXXXXX";
+
+    if (points < SERIES) {
+        fprintf(stderr, "usage: %s [points] [dbdir]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2) {
+        snprintf(dir, sizeof(dir), "%s", argv[2]);
+    } else if (mkdtemp(dir) == NULL) {
+        fprintf(stderr, "mkdtemp: %s\n", strerror(errno));
+        return 1;
+    }
+
+    long per_series = points / SERIES;
+    printf("%ld points in %d series, database %s\n", per_series * SERIES, SERIES, dir);
+    if (!fill(dir, per_series)) {
+        return 1;
+    }
+
+    static tsdb_t db;
+    if (tsdb_open(&db, dir, false, 0) < 0) {
+        fprintf(stderr, "cannot open %s: %s\n", dir, strerror(errno));
+        return 1;
+    }
+    uint32_t all[SERIES];
+    for (uint32_t s = 0; s < SERIES; s++) {
+        all[s] = s;
+    }
+    int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    long rows = per_series * SERIES;
+
+    query_t scan, indexed, filter, group, group_p99;
+    query_init(&scan);
+    scan.force_decode = true;
+    query_init(&indexed);
+    query_init(&filter);
+    filter.v_lo = 1490.0;       // Top of series 1's ramp: most blocks skipped by value
+    filter.v_hi = 1510.0;
+    query_init(&group);
+    group.bucket_ms = 60000;
+    group_p99 = group;
+    group_p99.quantile = 0.99;
+
+    // Checks run on the first station's series to stay quick
+    bool ok = check(&db, all, CLASSES, &scan, "scan") &&
+              check(&db, all, CLASSES, &indexed, "indexed") &&
+              check(&db, all, CLASSES, &filter, "filter") &&
+              check(&db, all, CLASSES, &group, "group") &&
+              check(&db, all, CLASSES, &group_p99, "group99");
+    if (!ok) {
+        return 1;
+    }
+
+    bench_kernel();
+    bench(&db, all, SERIES, &scan, "scan", rows, cpus);
+    bench(&db, all, SERIES, &indexed, "indexed", rows, cpus);
+    bench(&db, all, SERIES, &filter, "filter", rows, cpus);
+    bench(&db, all, SERIES, &group, "group", rows, cpus);
+    bench(&db, all, SERIES, &group_p99, "group99", rows, cpus);
+
+    tsdb_close(&db);
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file sample_codec_bench.c
+ * @brief Host throughput benchmark for the per-type sample kernels
+ *
+ * Compares, for every type in SCHED_DATA_TYPES:
+ *   generic  - per-element memcpy with the size looked up at run time
+ *              (what the station and AP did before the kernels existed)
+ *   encode   - specialized sample_encode_<TYPE>() kernel
+ *   decode   - specialized sample_decode_<TYPE>() kernel
+ *   widen    - sample_widen_<TYPE>() to double
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -std=c11 -D_POSIX_C_SOURCE=200809L -Icomponents/sched_core/include \
+ *       host/bench/sample_codec_bench.c components/sched_core/sample_codec.c \
+ *       components/sched_core/sched_types.c -o /tmp/sample_codec_bench
+ *   /tmp/sample_codec_bench [samples_per_call] [iterations]
+ *
+ * Add -DSAMPLE_FORCE_SWAP to measure the big-endian swap path.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sched_types.h"
+#include "sample_codec.h"
+
+#define DEFAULT_SAMPLES     255       // Largest per-class count in one frame
+#define DEFAULT_ITERATIONS  200000
+
+/* Keeps the optimizer from discarding the benchmarked work */
+static volatile uint8_t sink;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void __attribute__((noinline)) generic_copy(uint8_t *dst, const void *src,
+                                                    data_type_t type, size_t count)
+{
+    uint16_t element_size = data_type_size(type);
+    for (size_t i = 0; i < count; i++) {
+        memcpy(dst + i * element_size, (const uint8_t *)src + i * element_size, element_size);
+    }
+}
+
+/* One key=value line per kernel, so runs can go into host/bench/bench_store */
+static void report(const char *type, const char *kernel, size_t bytes_per_call,
+                   size_t samples, long iterations, double elapsed)
+{
+    double mb_s = (double)bytes_per_call * iterations / elapsed / 1e6;
+    double ms_s = (double)samples * iterations / elapsed / 1e6;
+    printf("codec type=%s kernel=%s mb_per_s=%.1f msamples_per_s=%.1f\n", type, kernel, mb_s, ms_s);
+}
+
+int main(int argc, char **argv)
+{
+    size_t samples = argc > 1 ? strtoul(argv[1], NULL, 0) : DEFAULT_SAMPLES;
+    long iterations = argc > 2 ? strtol(argv[2], NULL, 0) : DEFAULT_ITERATIONS;
+
+    if (samples == 0 || iterations <= 0) {
+        fprintf(stderr, "usage: %s [samples_per_call] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    uint8_t *native = malloc(samples * sizeof(double));
+    uint8_t *wire = malloc(samples * sizeof(double));
+    uint8_t *back = malloc(samples * sizeof(double));
+    double *widened = malloc(samples * sizeof(double));
+    if (native == NULL || wire == NULL || back == NULL || widened == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("codec_config samples=%zu iterations=%ld kernels=%s-endian\n",
+           samples, iterations, SAMPLE_HOST_LITTLE_ENDIAN ? "little" : "swapping");
+
+#define SAMPLE_BENCH_TYPE(name, ctype, bits, label, option)                              \
+    {                                                                                    \
+        ctype *values = (ctype *)native;                                                 \
+        for (size_t i = 0; i < samples; i++) {                                           \
+            values[i] = (ctype)(i * 3 + 1);                                              \
+        }                                                                                \
+        size_t bytes = samples * sizeof(ctype);                                          \
+        double start;                                                                    \
+                                                                                         \
+        start = now_s();                                                                 \
+        for (long it = 0; it < iterations; it++) {                                       \
+            generic_copy(wire, native, DATA_TYPE_##name, samples);                       \
+            sink ^= wire[it % bytes];                                                    \
+        }                                                                                \
+        report(label, "generic", bytes, samples, iterations, now_s() - start);          \
+                                                                                         \
+        start = now_s();                                                                 \
+        for (long it = 0; it < iterations; it++) {                                       \
+            sample_encode_##name(wire, values, samples);                                 \
+            sink ^= wire[it % bytes];                                                    \
+        }                                                                                \
+        report(label, "encode", bytes, samples, iterations, now_s() - start);           \
+                                                                                         \
+        start = now_s();                                                                 \
+        for (long it = 0; it < iterations; it++) {                                       \
+            sample_decode_##name((ctype *)back, wire, samples);                          \
+            sink ^= back[it % bytes];                                                    \
+        }                                                                                \
+        report(label, "decode", bytes, samples, iterations, now_s() - start);           \
+                                                                                         \
+        start = now_s();                                                                 \
+        for (long it = 0; it < iterations; it++) {                                       \
+            sample_widen_##name(widened, wire, samples);                                 \
+            sink ^= (uint8_t)widened[it % samples];                                      \
+        }                                                                                \
+        report(label, "widen", bytes, samples, iterations, now_s() - start);            \
+                                                                                         \
+        if (memcmp(native, back, bytes) != 0) {                                          \
+            fprintf(stderr, "%s: round trip mismatch\n", label);                         \
+            return 1;                                                                    \
+        }                                                                                \
+        for (size_t i = 0; i < samples; i++) {                                           \
+            if (widened[i] != (double)values[i]) {                                       \
+                fprintf(stderr, "%s: widen mismatch at %zu\n", label, i);                \
+                return 1;                                                                \
+            }                                                                            \
+        }                                                                                \
+    }
+    SCHED_DATA_TYPES(SAMPLE_BENCH_TYPE)
+#undef SAMPLE_BENCH_TYPE
+
+    free(native);
+    free(wire);
+    free(back);
+    free(widened);
+    return 0;
+}
@@ -0,0 +1,384 @@
+/**
+ * @file sched_bench.c
+ * @brief Host scaling benchmark for the scheduler core
+ *
+ * Drives sched_core with small records (one INT32 element each, so a
+ * batch merges as many packets as the frame allows) and measures, as the
+ * number of classes and the queue depth grow:
+ *   submit     - sched_core_submit() per record into a queue of that depth
+ *   due        - sched_core_due() per call (head-of-queue deadline scan)
+ *   build      - sched_core_build_batch() per batch with every queue full,
+ *                i.e. the scheduling decision plus the copy, and per packet
+ *   expire     - sched_core_build_batch() per dropped packet when every
+ *                queued deadline has passed
+ * then runs the core at a steady record rate across all classes, the way
+ * scheduler_task does, to show how much CPU that rate costs.
+ *
+ * For each per-operation cost (build per packet, not per batch, since
+ * batches grow until the frame is full) the growth with classes and with
+ * depth is fitted as the slope of log(cost) over log(n) and labelled O(1),
+ * O(n) or O(n^2); any path that is not O(1) is listed under "flags". Output is one JSON
+ * object on stdout, for keeping alongside earlier runs.
+ *
+ * The core's per-class loops (the head scans in sched_core_due() and
+ * drop_expired(), the EDF pick) run over MAX_CLASSES however many classes
+ * hold packets, so their growth shows between builds with different
+ * -DMAX_CLASSES rather than within the classes sweep of one build.
+ *
+ * The firmware sizing (4 classes, 50 packets per queue) hides scaling, so
+ * build with larger MAX_CLASSES and MAX_QUEUE_SIZE. sample_time.c is left
+ * out since the core only uses the sample_times_t struct. Build and run from
+ * the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -DMAX_CLASSES=16 -DMAX_QUEUE_SIZE=4096 \
+ *       -Icomponents/sched_core/include host/bench/sched_bench.c \
+ *       components/sched_core/{sched_core,sched_queue,sched_types,sample_codec,record_schema}.c \
+ *       -lm -o /tmp/sched_bench
+ *   /tmp/sched_bench [max_depth] [records_per_s] > sched_bench.json
+ *
+ * Add -DCONFIG_SCHED_POLICY_EDF to measure the EDF policy.
+ */
+
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sched_core.h"
+
+#define REPEATS             3           // Best of, for every measurement
+#define BATCHES             2000        // Batches timed per point
+#define DUE_CALLS           200000      // sched_core_due() calls timed per point
+#define FIXED_DEPTH         64          // Queue depth of the class sweep
+#define FIXED_CLASSES       4           // Classes of the depth sweep
+#define DEFAULT_RATE        4000        // Records per second of the steady run
+#define DRIVE_SECONDS       60          // Simulated time of the steady run
+#define DEADLINE_FAR_MS     1000000000u // Nothing expires while measuring build
+#define SLOPE_LINEAR        0.5         // Fitted exponent above which a path is O(n)
+#define SLOPE_QUADRATIC     1.5         // ... and O(n^2)
+
+#define MAX_POINTS          32
+
+/* Keeps the optimizer from discarding the benchmarked work */
+static volatile uint32_t sink;
+
+/* Big with a deep MAX_QUEUE_SIZE, so not on the stack */
+static sched_core_t core;
+static sched_batch_t batch;
+static uint8_t frame[MAX_TX_SIZE];
+
+typedef struct {
+    int classes;
+    int depth;
+    double submit_ns;       // Per record
+    double due_ns;          // Per call
+    double build_ns;        // Per batch
+    double build_pkt_ns;    // Per packet merged
+    double batch_packets;   // Packets merged per batch
+    double expire_ns;       // Per packet dropped
+} point_t;
+
+typedef struct {
+    const char *name;
+    size_t offset;
+} metric_t;
+
+static const metric_t metrics[] = {
+    {"submit_ns",    offsetof(point_t, submit_ns)},
+    {"due_ns",       offsetof(point_t, due_ns)},
+    {"build_pkt_ns", offsetof(point_t, build_pkt_ns)},
+    {"expire_ns",    offsetof(point_t, expire_ns)},
+};
+
+#define NUM_METRICS (sizeof(metrics) / sizeof(metrics[0]))
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void core_reset(int classes, uint32_t deadline_ms)
+{
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        queue_clear(&core.packet_queues[class_id]);
+    }
+    sched_core_init(&core);
+    for (int class_id = 0; class_id < classes; class_id++) {
+        core.class_deadlines[class_id] = deadline_ms;
+    }
+}
+
+/* Queue records until each of the first classes holds depth packets */
+static bool fill(int classes, int depth, uint32_t now_ms)
+{
+    for (int class_id = 0; class_id < classes; class_id++) {
+        int32_t value = class_id;
+        while (core.packet_queues[class_id].count < depth) {
+            if (sched_core_submit(&core, (class_id_t)class_id, &value, 1, now_ms) != SCHED_OK) {
+                return false;
+            }
+            value++;
+        }
+    }
+    return true;
+}
+
+static bool measure_point(int classes, int depth, point_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->classes = classes;
+    p->depth = depth;
+    p->submit_ns = p->due_ns = p->build_ns = p->build_pkt_ns = p->expire_ns = INFINITY;
+
+    for (int r = 0; r < REPEATS; r++) {
+        uint32_t now_ms = 0;
+
+        // submit: fill every queue from empty
+        core_reset(classes, DEADLINE_FAR_MS);
+        double t0 = now_s();
+        if (!fill(classes, depth, now_ms)) {
+            return false;
+        }
+        double submit = (now_s() - t0) * 1e9 / ((double)classes * depth);
+
+        // due: the check scheduler_task makes on every wakeup
+        uint32_t due = 0;
+        t0 = now_s();
+        for (long i = 0; i < DUE_CALLS; i++) {
+            due += sched_core_due(&core, (uint32_t)i);
+        }
+        double due_ns = (now_s() - t0) * 1e9 / DUE_CALLS;
+        sink += due;
+
+        // build: one batch at a time from full queues, topped up untimed
+        double build = 0;
+        long packets = 0;
+        for (long i = 0; i < BATCHES; i++) {
+            now_ms++;
+            t0 = now_s();
+            sink += sched_core_build_batch(&core, now_ms, frame, sizeof(frame), &batch);
+            build += now_s() - t0;
+            for (int class_id = 0; class_id < classes; class_id++) {
+                packets += batch.class_packets[class_id];
+            }
+            if (!fill(classes, depth, now_ms)) {
+                return false;
+            }
+        }
+
+        // expire: every queued deadline has passed, so the next batch drops them all
+        for (int class_id = 0; class_id < classes; class_id++) {
+            queue_clear(&core.packet_queues[class_id]);
+            core.class_deadlines[class_id] = 0;
+        }
+        if (!fill(classes, depth, now_ms)) {
+            return false;
+        }
+        uint32_t misses = core.deadline_misses;
+        t0 = now_s();
+        sink += sched_core_build_batch(&core, now_ms + 1, frame, sizeof(frame), &batch);
+        double expire = (now_s() - t0) * 1e9 / (core.deadline_misses - misses);
+
+        p->submit_ns = fmin(p->submit_ns, submit);
+        p->due_ns = fmin(p->due_ns, due_ns);
+        p->build_ns = fmin(p->build_ns, build * 1e9 / BATCHES);
+        p->build_pkt_ns = fmin(p->build_pkt_ns, packets > 0 ? build * 1e9 / packets : 0);
+        p->batch_packets = (double)packets / BATCHES;
+        p->expire_ns = fmin(p->expire_ns, expire);
+    }
+
+    core_reset(0, 0);
+    return true;
+}
+
+/* Least-squares slope of log(metric) over log(n) */
+static double fit_slope(const point_t *points, int count, bool by_classes, size_t offset)
+{
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int used = 0;
+
+    for (int i = 0; i < count; i++) {
+        double n = by_classes ? points[i].classes : points[i].depth;
+        double y = *(const double *)((const char *)&points[i] + offset);
+        if (n <= 0 || !(y > 0)) {
+            continue;
+        }
+        double x = log(n);
+        y = log(y);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        used++;
+    }
+
+    double den = used * sxx - sx * sx;
+    return used >= 2 && den > 0 ? (used * sxy - sx * sy) / den : 0.0;
+}
+
+static const char *order_label(double slope)
+{
+    return slope >= SLOPE_QUADRATIC ? "O(n^2)" : slope >= SLOPE_LINEAR ? "O(n)" : "O(1)";
+}
+
+/* Records arrive evenly over all classes at rate per second, deadlines
+ * staggered per class, batches built whenever the core says they are due */
+typedef struct {
+    int classes;
+    double rate;
+    double virtual_s;
+    double wall_s;
+    unsigned long records;
+    unsigned long rejected;
+    unsigned long batches;
+    unsigned long misses;
+} drive_t;
+
+static void drive(int classes, double rate, drive_t *d)
+{
+    memset(d, 0, sizeof(*d));
+    d->classes = classes;
+    d->rate = rate;
+    d->virtual_s = DRIVE_SECONDS;
+
+    core_reset(classes, 0);
+    core.processing_threshold = 20;
+    for (int class_id = 0; class_id < classes; class_id++) {
+        core.class_deadlines[class_id] = 50 + 10 * (uint32_t)(class_id % 8);
+    }
+
+    double period_ms = 1000.0 * classes / rate;
+    double next_ms[MAX_CLASSES];
+    for (int class_id = 0; class_id < classes; class_id++) {
+        next_ms[class_id] = period_ms * class_id / classes;
+    }
+
+    double t0 = now_s();
+    for (uint32_t now_ms = 0; now_ms < DRIVE_SECONDS * 1000u; now_ms++) {
+        for (int class_id = 0; class_id < classes; class_id++) {
+            while (next_ms[class_id] <= now_ms) {
+                int32_t value = (int32_t)now_ms;
+                if (sched_core_submit(&core, (class_id_t)class_id, &value, 1, now_ms) != SCHED_OK) {
+                    d->rejected++;
+                }
+                d->records++;
+                next_ms[class_id] += period_ms;
+            }
+        }
+        while (sched_core_due(&core, now_ms)) {
+            if (sched_core_build_batch(&core, now_ms, frame, sizeof(frame), &batch) == 0) {
+                break;
+            }
+            sched_core_batch_sent(&core, &batch);
+            d->batches++;
+        }
+    }
+    d->wall_s = now_s() - t0;
+    d->misses = core.deadline_misses;
+
+    core_reset(0, 0);
+}
+
+static void print_point(const point_t *p, bool last)
+{
+    printf("      {\"classes\": %d, \"depth\": %d, \"submit_ns\": %.1f, \"due_ns\": %.2f, "
+           "\"build_ns\": %.1f, \"build_pkt_ns\": %.1f, \"batch_packets\": %.1f, "
+           "\"expire_ns\": %.1f}%s\n",
+           p->classes, p->depth, p->submit_ns, p->due_ns, p->build_ns, p->build_pkt_ns,
+           p->batch_packets, p->expire_ns, last ? "" : ",");
+}
+
+static void print_sweep(const char *name, const point_t *points, int count, bool by_classes,
+                        bool last)
+{
+    printf("  \"%s\": {\n", name);
+    printf("    \"points\": [\n");
+    for (int i = 0; i < count; i++) {
+        print_point(&points[i], i == count - 1);
+    }
+    printf("    ],\n");
+    printf("    \"slopes\": {");
+    for (size_t m = 0; m < NUM_METRICS; m++) {
+        double slope = fit_slope(points, count, by_classes, metrics[m].offset);
+        printf("%s\"%s\": {\"slope\": %.2f, \"order\": \"%s\"}", m ? ", " : "",
+               metrics[m].name, slope, order_label(slope));
+    }
+    printf("}\n");
+    printf("  }%s\n", last ? "" : ",");
+}
+
+static int print_flags(const char *sweep, const point_t *points, int count, bool by_classes,
+                       int flagged)
+{
+    for (size_t m = 0; m < NUM_METRICS; m++) {
+        double slope = fit_slope(points, count, by_classes, metrics[m].offset);
+        if (slope >= SLOPE_LINEAR) {
+            printf("%s\n    {\"sweep\": \"%s\", \"metric\": \"%s\", \"slope\": %.2f, \"order\": \"%s\"}",
+                   flagged++ ? "," : "", sweep, metrics[m].name, slope, order_label(slope));
+        }
+    }
+    return flagged;
+}
+
+int main(int argc, char **argv)
+{
+    int max_depth = argc > 1 ? atoi(argv[1]) : MAX_QUEUE_SIZE;
+    double rate = argc > 2 ? atof(argv[2]) : DEFAULT_RATE;
+    if (max_depth < 1 || max_depth > MAX_QUEUE_SIZE || rate <= 0) {
+        fprintf(stderr, "usage: %s [max_depth <= %d] [records_per_s]\n", argv[0], MAX_QUEUE_SIZE);
+        return 2;
+    }
+
+    // The firmware heap never pages: keep freed queue nodes mapped so that
+    // refilling measures the core rather than page faults
+    mallopt(M_TRIM_THRESHOLD, INT32_MAX);
+    mallopt(M_MMAP_THRESHOLD, INT32_MAX);
+
+    int fixed_depth = max_depth < FIXED_DEPTH ? max_depth : FIXED_DEPTH;
+    int fixed_classes = MAX_CLASSES < FIXED_CLASSES ? MAX_CLASSES : FIXED_CLASSES;
+
+    point_t by_classes[MAX_POINTS];
+    point_t by_depth[MAX_POINTS];
+    int class_points = 0;
+    int depth_points = 0;
+
+    for (int classes = 1; classes <= MAX_CLASSES && class_points < MAX_POINTS; classes *= 2) {
+        if (!measure_point(classes, fixed_depth, &by_classes[class_points++])) {
+            fprintf(stderr, "submit failed at %d classes\n", classes);
+            return 1;
+        }
+    }
+    for (int depth = 8; depth <= max_depth && depth_points < MAX_POINTS; depth *= 2) {
+        if (!measure_point(fixed_classes, depth, &by_depth[depth_points++])) {
+            fprintf(stderr, "submit failed at depth %d\n", depth);
+            return 1;
+        }
+    }
+
+    drive_t d;
+    drive(MAX_CLASSES, rate, &d);
+
+    printf("{\n");
+    printf("  \"bench\": \"sched\",\n");
+    printf("  \"policy\": \"%s\",\n", SCHED_POLICY_NAME);
+    printf("  \"max_classes\": %d,\n", MAX_CLASSES);
+    printf("  \"max_queue_size\": %d,\n", MAX_QUEUE_SIZE);
+    printf("  \"capacity\": %u,\n", (unsigned)sizeof(frame));
+    printf("  \"record_bytes\": %u,\n", (unsigned)sizeof(int32_t));
+    print_sweep("classes", by_classes, class_points, true, false);
+    print_sweep("depth", by_depth, depth_points, false, false);
+    printf("  \"drive\": {\"classes\": %d, \"records_per_s\": %.0f, \"virtual_s\": %.0f, "
+           "\"wall_s\": %.4f, \"cpu_pct\": %.3f, \"records\": %lu, \"rejected\": %lu, "
+           "\"batches\": %lu, \"misses\": %lu, \"max_records_per_s\": %.0f},\n",
+           d.classes, d.rate, d.virtual_s, d.wall_s, 100.0 * d.wall_s / d.virtual_s,
+           d.records, d.rejected, d.batches, d.misses, d.records / d.wall_s);
+    printf("  \"flags\": [");
+    int flagged = print_flags("classes", by_classes, class_points, true, 0);
+    flagged = print_flags("depth", by_depth, depth_points, false, flagged);
+    printf("%s]\n", flagged ? "\n  " : "");
+    printf("}\n");
+
+    return sink == 0xFFFFFFFFu ? 1 : 0;
+}
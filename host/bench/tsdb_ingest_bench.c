@@ -0,0 +1,298 @@
+/**
+ * @file tsdb_ingest_bench.c
+ * @brief Host ingest throughput benchmark for the collector's time-series store
+ *
+ * Measures, on one core:
+ *   append   - tsdb_append() of sensor-like points (steady period with
+ *              jitter, slowly drifting values) across several series
+ *   ingest   - ingest_line() of AP export lines carrying full data frames,
+ *              i.e. hex decoding, frame_parse(), widening and appending
+ *
+ * Both phases flush, then read every series back with tsdb_scan() and
+ * check the point counts and values against what was written.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/collector -Icomponents/sched_core/include \
+ *       host/bench/tsdb_ingest_bench.c host/collector/{ingest,tsdb,gorilla}.c \
+ *       components/sched_core/{sched_types,sample_codec,record_schema,sample_time}.c \
+ *       components/sched_core/{frame_codec,frame_export,crc32c}.c -o /tmp/tsdb_ingest_bench
+ *   /tmp/tsdb_ingest_bench [points] [dbdir]
+ *
+ * The database directory (default a fresh one under /tmp) is left behind
+ * for inspection with the query tools.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "frame_codec.h"
+#include "frame_export.h"
+#include "ingest.h"
+#include "sample_codec.h"
+#include "tsdb.h"
+
+#define DEFAULT_POINTS      20000000L
+#define APPEND_SERIES       16
+#define FRAME_VARIANTS      64          // Distinct export lines cycled through
+#define TARGET_RATE         1e6         // Samples per second the collector must sustain
+#define FRAME_INTERVAL_MS   10
+#define RX_MS_BASE          1000000000u // Keeps the export line's rx_ms field at 10 digits
+#define RX_MS_DIGITS        10
+
+/* Samples per frame in the ingest phase: INT16, FLOAT and INT32 classes */
+static const uint8_t frame_counts[MAX_CLASSES] = {200, 100, 100, 0};
+static const data_type_t frame_types[MAX_CLASSES] = {
+    DATA_TYPE_INT16, DATA_TYPE_FLOAT, DATA_TYPE_INT32, DATA_TYPE_INT32
+};
+
+/* Outcome of a phase: a failure to run it is not a read-back mismatch */
+typedef enum {
+    PHASE_OK,
+    PHASE_MISMATCH,
+    PHASE_FAILED,
+} phase_result_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)rng_state;
+}
+
+/* Value of point i of a series: a slow ramp with small noise, like a sensor */
+static double sensor_value(uint32_t series, long i)
+{
+    return (double)(int32_t)(1000 * series + (i / 64) % 500 + (rng_next() & 3));
+}
+
+/* Scan callback: count points and sum values */
+typedef struct {
+    long points;
+    double sum;
+    int64_t last_time;
+    bool ordered;
+} scan_check_t;
+
+static void on_point(int64_t time, double value, void *ctx)
+{
+    scan_check_t *check = ctx;
+    if (check->points > 0 && time < check->last_time) {
+        check->ordered = false;
+    }
+    check->last_time = time;
+    check->points++;
+    check->sum += value;
+}
+
+static bool verify(const tsdb_t *db, uint32_t series_id, long expected_points, double expected_sum)
+{
+    scan_check_t check = { .ordered = true };
+    if (tsdb_scan(db, series_id, INT64_MIN, INT64_MAX, on_point, &check) < 0) {
+        fprintf(stderr, "series %u: scan failed: %s\n", series_id, strerror(errno));
+        return false;
+    }
+    if (check.points != expected_points || check.sum != expected_sum || !check.ordered) {
+        fprintf(stderr, "series %u: read back %ld points sum %.0f, wrote %ld points sum %.0f%s\n",
+                series_id, check.points, check.sum, expected_points, expected_sum,
+                check.ordered ? "" : " (out of order)");
+        return false;
+    }
+    return true;
+}
+
+static void report(const char *phase, long samples, double elapsed, const tsdb_t *db)
+{
+    double rate = samples / elapsed;
+    printf("%-7s %10ld samples %8.3f s %10.2f Msamples/s %6.2f bytes/sample %s\n",
+           phase, samples, elapsed, rate / 1e6,
+           db->points_written > 0 ? (double)db->bytes_written / db->points_written : 0.0,
+           rate >= TARGET_RATE ? "ok" : "BELOW TARGET");
+}
+
+static phase_result_t bench_append(const char *dir, long points)
+{
+    static tsdb_t db;
+    if (tsdb_open(&db, dir, true, 0) < 0) {
+        fprintf(stderr, "cannot open %s: %s\n", dir, strerror(errno));
+        return PHASE_FAILED;
+    }
+
+    uint32_t ids[APPEND_SERIES];
+    int64_t times[APPEND_SERIES];
+    double sums[APPEND_SERIES] = {0};
+    for (uint32_t s = 0; s < APPEND_SERIES; s++) {
+        tsdb_series_key_t key = { .station = {0x02, 0, 0, 0, 0, (uint8_t)(s / MAX_CLASSES)},
+                                  .class_id = (uint8_t)(s % MAX_CLASSES) };
+        ids[s] = (uint32_t)tsdb_series(&db, &key, DATA_TYPE_INT32);
+        times[s] = 1700000000000LL;
+    }
+
+    long per_series = points / APPEND_SERIES;
+    double start = now_s();
+    for (long i = 0; i < per_series; i++) {
+        for (uint32_t s = 0; s < APPEND_SERIES; s++) {
+            times[s] += 10 + (rng_next() & 1);     // 100 Hz with 1 ms jitter
+            double value = sensor_value(s, i);
+            sums[s] += value;
+            if (tsdb_append(&db, ids[s], times[s], value) < 0) {
+                fprintf(stderr, "append failed: %s\n", strerror(errno));
+                return PHASE_FAILED;
+            }
+        }
+    }
+    tsdb_flush(&db);
+    report("append", per_series * APPEND_SERIES, now_s() - start, &db);
+
+    bool ok = true;
+    for (uint32_t s = 0; s < APPEND_SERIES; s++) {
+        ok = verify(&db, ids[s], per_series, sums[s]) && ok;
+    }
+    tsdb_close(&db);
+    return ok ? PHASE_OK : PHASE_MISMATCH;
+}
+
+/* Build one export line of a full data frame sent at t_ms */
+static size_t build_line(char *line, size_t cap, uint32_t t_ms, double *class_sums)
+{
+    static const frame_addr_t addr = {
+        .da = {0x02, 0, 0, 0, 0, 0x01}, .sa = {0x02, 0, 0, 0, 0, 0x02}, .bssid = {0x02, 0, 0, 0, 0, 0x01},
+    };
+    uint8_t data[MAX_TX_SIZE];
+    uint8_t frame[FRAME_MAX_LEN];
+    data_packet_header_t header = { .timestamp = t_ms };
+    size_t size = 0;
+
+    for (int c = 0; c < MAX_CLASSES; c++) {
+        double values[UINT8_MAX];
+        header.class_types[c] = frame_types[c];
+        header.class_counts[c] = frame_counts[c];
+        for (int i = 0; i < frame_counts[c]; i++) {
+            values[i] = sensor_value((uint32_t)c, t_ms / 10 + i);
+            class_sums[c] += values[i];
+        }
+        size += sample_narrow(frame_types[c], data + size, values, frame_counts[c]);
+    }
+    header.total_size = (uint16_t)size;
+
+    size_t frame_len = frame_build(frame, sizeof(frame), &addr, &header, data);
+    return frame_export_format(line, cap, RX_MS_BASE, -40, frame, frame_len);
+}
+
+/* Overwrite the fixed-width rx_ms field of an export line in place */
+static void set_rx_ms(char *line, uint32_t rx_ms)
+{
+    char *digit = line + FRAME_EXPORT_PREFIX_LEN + RX_MS_DIGITS;
+    for (int i = 0; i < RX_MS_DIGITS; i++) {
+        *--digit = (char)('0' + rx_ms % 10);
+        rx_ms /= 10;
+    }
+}
+
+static phase_result_t bench_ingest(const char *dir, long points)
+{
+    static tsdb_t db;
+    if (tsdb_open(&db, dir, true, 0) < 0) {
+        fprintf(stderr, "cannot open %s: %s\n", dir, strerror(errno));
+        return PHASE_FAILED;
+    }
+
+    // Lines are prepared up front so only ingestion is timed
+    enum { LINE_CAP = FRAME_EXPORT_LINE_MAX(FRAME_MAX_LEN) };
+    char *lines = malloc((size_t)FRAME_VARIANTS * LINE_CAP);
+    size_t line_lens[FRAME_VARIANTS];
+    double variant_sums[FRAME_VARIANTS][MAX_CLASSES] = {{0}};
+    if (lines == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return PHASE_FAILED;
+    }
+    for (int v = 0; v < FRAME_VARIANTS; v++) {
+        line_lens[v] = build_line(lines + (size_t)v * LINE_CAP, LINE_CAP, 1000u * v, variant_sums[v]);
+    }
+
+    int per_frame = 0;
+    for (int c = 0; c < MAX_CLASSES; c++) {
+        per_frame += frame_counts[c];
+    }
+    long frames = points / per_frame;
+    double class_sums[MAX_CLASSES] = {0};
+
+    // Device time keeps the timeline reproducible; frames arrive every FRAME_INTERVAL_MS
+    ingest_t in;
+    ingest_init(&in, &db, true);
+    double start = now_s();
+    for (long f = 0; f < frames; f++) {
+        int v = (int)(f % FRAME_VARIANTS);
+        char *line = lines + (size_t)v * LINE_CAP;
+        set_rx_ms(line, RX_MS_BASE + (uint32_t)f * FRAME_INTERVAL_MS);
+        if (!ingest_line(&in, line, line_lens[v])) {
+            fprintf(stderr, "ingest failed: %s\n", strerror(errno));
+            return PHASE_FAILED;
+        }
+        for (int c = 0; c < MAX_CLASSES; c++) {
+            class_sums[c] += variant_sums[v][c];
+        }
+    }
+    tsdb_flush(&db);
+    report("ingest", (long)in.samples, now_s() - start, &db);
+
+    bool ok = in.frames == (uint64_t)frames && in.samples == (uint64_t)frames * per_frame;
+    for (uint32_t id = 0; id < db.series_count; id++) {
+        int c = db.series[id].key.class_id;
+        ok = verify(&db, id, frames * frame_counts[c], class_sums[c]) && ok;
+    }
+    free(lines);
+    tsdb_close(&db);
+    return ok ? PHASE_OK : PHASE_MISMATCH;
+}
+
+int main(int argc, char **argv)
+{
+    long points = argc > 1 ? strtol(argv[1], NULL, 0) : DEFAULT_POINTS;
+    char dir[64] = "/tmp/tsdb_bench.XXXXXX";
+
+    if (points <= 0) {
+        fprintf(stderr, "usage: %s [points] [dbdir]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2) {
+        snprintf(dir, sizeof(dir), "%s", argv[2]);
+        if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+            fprintf(stderr, "cannot create %s: %s\n", dir, strerror(errno));
+            return 1;
+        }
+    } else if (mkdtemp(dir) == NULL) {
+        fprintf(stderr, "mkdtemp: %s\n", strerror(errno));
+        return 1;
+    }
+
+    char append_dir[80], ingest_dir[80];
+    snprintf(append_dir, sizeof(append_dir), "%s/append", dir);
+    snprintf(ingest_dir, sizeof(ingest_dir), "%s/ingest", dir);
+
+    printf("%ld points, database %s\n", points, dir);
+    phase_result_t append = bench_append(append_dir, points);
+    phase_result_t ingest = bench_ingest(ingest_dir, points);
+
+    if (append == PHASE_FAILED || ingest == PHASE_FAILED) {
+        fprintf(stderr, "benchmark did not complete\n");
+        return 1;
+    }
+    if (append == PHASE_MISMATCH || ingest == PHASE_MISMATCH) {
+        fprintf(stderr, "read-back mismatch\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,271 @@
+/**
+ * @file collector.c
+ * @brief Collector daemon: stores the AP export stream in a time-series database
+ *
+ * Reads the AP console from a serial device, a file, a FIFO or stdin,
+ * keeps the "@FRM" export lines (frame_export.h) and stores every sample
+ * in the per-station, per-class series of a tsdb directory (tsdb.h).
+ * Buffered points are flushed every -F seconds and on exit, so at most
+ * that much data is lost if the collector is killed.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/collector -Icomponents/sched_core/include \
+ *       host/collector/{collector,ingest,tsdb,gorilla}.c \
+ *       components/sched_core/{sched_types,sample_codec,record_schema,sample_time}.c \
+ *       components/sched_core/{frame_codec,frame_export,crc32c}.c -o /tmp/collector
+ *
+ * Usage:
+ *   collector -d dbdir [-b baud] [-p partition_s] [-F flush_s] [-R] [-q] [input]
+ *
+ * input is a path or "-" for stdin (default). A serial device is switched
+ * to raw mode at -b baud (default 115200). -R stores the AP clock instead
+ * of host time, for replaying saved console logs. -p sets the partition
+ * span of a new database (default one hour).
+ *
+ * Examples:
+ *   collector -d /var/lib/sched /dev/ttyUSB0
+ *   /tmp/posix/ap -m lab | collector -d /tmp/db
+ *   collector -d /tmp/db -R ap_console.log
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "ingest.h"
+#include "record_schema.h"
+#include "tsdb.h"
+
+#define READ_CHUNK          65536
+#define LINE_MAX_LEN        8192     // Longer lines are dropped
+#define DEFAULT_BAUD        115200
+#define DEFAULT_FLUSH_S     1
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static speed_t baud_speed(long baud)
+{
+    switch (baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+        default: return B0;
+    }
+}
+
+/* Raw 8N1 input, like the ESP-IDF monitor */
+static int configure_serial(int fd, long baud)
+{
+    speed_t speed = baud_speed(baud);
+    struct termios tio;
+
+    if (speed == B0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (tcgetattr(fd, &tio) < 0) {
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+static int open_input(const char *path, long baud)
+{
+    if (strcmp(path, "-") == 0) {
+        return STDIN_FILENO;
+    }
+
+    int fd = open(path, O_RDONLY | O_NOCTTY | O_CLOEXEC);
+    if (fd >= 0 && isatty(fd) && configure_serial(fd, baud) < 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+static void print_stats(const ingest_t *in, const tsdb_t *db, double elapsed)
+{
+    printf("collector lines=%llu frames=%llu schema_frames=%llu schema_conflicts=%u bad_lines=%llu bad_frames=%llu\n",
+           (unsigned long long)in->lines, (unsigned long long)in->frames,
+           (unsigned long long)in->schema_frames, record_schema_conflicts(), (unsigned long long)in->bad_lines,
+           (unsigned long long)in->bad_frames);
+    printf("samples=%llu series=%u blocks=%llu bytes_written=%llu bytes_per_sample=%.2f\n",
+           (unsigned long long)in->samples, db->series_count,
+           (unsigned long long)db->blocks_written, (unsigned long long)db->bytes_written,
+           db->points_written > 0 ? (double)db->bytes_written / db->points_written : 0.0);
+    printf("elapsed_s=%.3f samples_per_s=%.0f\n", elapsed, elapsed > 0 ? in->samples / elapsed : 0.0);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s -d dbdir [-b baud] [-p partition_s] [-F flush_s] [-R] [-q] [input]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = NULL;
+    long baud = DEFAULT_BAUD;
+    int64_t partition_ms = 0;
+    double flush_s = DEFAULT_FLUSH_S;
+    bool device_time = false;
+    bool quiet = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:b:p:F:Rqh")) != -1) {
+        switch (opt) {
+            case 'd': dir = optarg; break;
+            case 'b': baud = strtol(optarg, NULL, 10); break;
+            case 'p': partition_ms = strtoll(optarg, NULL, 10) * 1000; break;
+            case 'F': flush_s = strtod(optarg, NULL); break;
+            case 'R': device_time = true; break;
+            case 'q': quiet = true; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (dir == NULL || optind < argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *input = optind < argc ? argv[optind] : "-";
+
+    int fd = open_input(input, baud);
+    if (fd < 0) {
+        fprintf(stderr, "collector: cannot open '%s': %s\n", input, strerror(errno));
+        return 1;
+    }
+
+    static tsdb_t db;
+    if (tsdb_open(&db, dir, true, partition_ms) < 0) {
+        fprintf(stderr, "collector: cannot open database '%s': %s\n", dir, strerror(errno));
+        return 1;
+    }
+
+    ingest_t in;
+    ingest_init(&in, &db, device_time);
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (!quiet) {
+        fprintf(stderr, "collector: %s -> %s (%u series, partition %lld s)\n", input, dir,
+                db.series_count, (long long)(db.partition_ms / 1000));
+    }
+
+    static char buf[LINE_MAX_LEN + READ_CHUNK];
+    size_t used = 0;
+    bool skipping = false;      // Inside an overlong line
+    int status = 0;
+    double started = now_s();
+    double last_flush = started;
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    while (!stop_requested) {
+        // Wake up at least once per flush interval on a quiet input
+        int ready = poll(&pfd, 1, (int)(flush_s * 1000));
+        if (ready < 0 && errno != EINTR) {
+            fprintf(stderr, "collector: poll: %s\n", strerror(errno));
+            status = 1;
+            break;
+        }
+
+        if (ready > 0) {
+            ssize_t n = read(fd, buf + used, sizeof(buf) - used);
+            if (n == 0) {
+                break;  // End of file or pipe closed
+            }
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                fprintf(stderr, "collector: read: %s\n", strerror(errno));
+                status = 1;
+                break;
+            }
+            used += (size_t)n;
+
+            char *start = buf;
+            char *end = buf + used;
+            char *nl;
+            while ((nl = memchr(start, '\n', (size_t)(end - start))) != NULL) {
+                if (!skipping && !ingest_line(&in, start, (size_t)(nl - start))) {
+                    fprintf(stderr, "collector: write failed: %s\n", strerror(errno));
+                    stop_requested = 1;
+                    status = 1;
+                    break;
+                }
+                skipping = false;
+                start = nl + 1;
+            }
+
+            used = (size_t)(end - start);
+            if (used > LINE_MAX_LEN) {
+                skipping = true;    // Drop the rest of an overlong line
+                used = 0;
+            } else {
+                memmove(buf, start, used);
+            }
+        }
+
+        double now = now_s();
+        if (now - last_flush >= flush_s) {
+            if (tsdb_flush(&db) < 0) {
+                fprintf(stderr, "collector: flush failed: %s\n", strerror(errno));
+                status = 1;
+                break;
+            }
+            last_flush = now;
+        }
+    }
+
+    if (used > 0 && !skipping) {
+        ingest_line(&in, buf, used);   // Unterminated last line
+    }
+
+    if (tsdb_flush(&db) < 0) {
+        fprintf(stderr, "collector: flush failed: %s\n", strerror(errno));
+        status = 1;
+    }
+    print_stats(&in, &db, now_s() - started);
+
+    tsdb_close(&db);
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return status;
+}
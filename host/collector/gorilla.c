@@ -0,0 +1,248 @@
+/**
+ * @file gorilla.c
+ * @brief Gorilla time and value column codecs
+ */
+
+#include <string.h>
+#include "gorilla.h"
+
+/* MSB-first bit writer; callers guarantee room from the *_MAX bounds */
+typedef struct {
+    uint8_t *p;
+    uint64_t acc;       // Pending bits, right-aligned
+    int n;              // Pending bit count, below 32 between calls
+} bit_writer_t;
+
+/* MSB-first bit reader */
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint64_t acc;
+    int n;
+    bool underflow;
+} bit_reader_t;
+
+static inline void put_bits(bit_writer_t *w, uint32_t value, int count)
+{
+    w->acc = (w->acc << count) | (value & (uint32_t)((1ull << count) - 1));
+    w->n += count;
+    if (w->n >= 32) {
+        uint32_t word = (uint32_t)(w->acc >> (w->n - 32));
+        w->p[0] = word >> 24;
+        w->p[1] = word >> 16;
+        w->p[2] = word >> 8;
+        w->p[3] = word;
+        w->p += 4;
+        w->n -= 32;
+    }
+}
+
+static inline void put_bits64(bit_writer_t *w, uint64_t value, int count)
+{
+    if (count > 32) {
+        put_bits(w, (uint32_t)(value >> 32), count - 32);
+        count = 32;
+    }
+    put_bits(w, (uint32_t)value, count);
+}
+
+/* Flush the last partial byte(s); returns the end of the stream */
+static uint8_t *finish_bits(bit_writer_t *w)
+{
+    while (w->n > 0) {
+        int take = w->n >= 8 ? 8 : w->n;
+        *w->p++ = (uint8_t)((w->acc >> (w->n - take)) << (8 - take));
+        w->n -= take;
+    }
+    return w->p;
+}
+
+static inline uint32_t get_bits(bit_reader_t *r, int count)
+{
+    while (r->n < count) {
+        if (r->p < r->end) {
+            r->acc = (r->acc << 8) | *r->p++;
+        } else {
+            r->acc <<= 8;
+            r->underflow = true;
+        }
+        r->n += 8;
+    }
+    r->n -= count;
+    return (uint32_t)(r->acc >> r->n) & (uint32_t)((1ull << count) - 1);
+}
+
+static inline uint64_t get_bits64(bit_reader_t *r, int count)
+{
+    uint64_t high = 0;
+    if (count > 32) {
+        high = (uint64_t)get_bits(r, count - 32) << 32;
+        count = 32;
+    }
+    return high | get_bits(r, count);
+}
+
+/* ---- Times ---- */
+
+static inline void put_dod(bit_writer_t *w, int64_t dod)
+{
+    uint64_t zz = ((uint64_t)dod << 1) ^ (uint64_t)(dod >> 63);
+
+    if (zz == 0) {
+        put_bits(w, 0x0, 1);
+    } else if (zz < (1u << 7)) {
+        put_bits(w, 0x2 << 7 | (uint32_t)zz, 9);
+    } else if (zz < (1u << 9)) {
+        put_bits(w, 0x6 << 9 | (uint32_t)zz, 12);
+    } else if (zz < (1u << 12)) {
+        put_bits(w, 0xE << 12 | (uint32_t)zz, 16);
+    } else {
+        put_bits(w, 0xF, 4);
+        put_bits64(w, zz, 64);
+    }
+}
+
+static inline int64_t get_dod(bit_reader_t *r)
+{
+    uint64_t zz;
+
+    if (get_bits(r, 1) == 0) {
+        return 0;
+    } else if (get_bits(r, 1) == 0) {
+        zz = get_bits(r, 7);
+    } else if (get_bits(r, 1) == 0) {
+        zz = get_bits(r, 9);
+    } else if (get_bits(r, 1) == 0) {
+        zz = get_bits(r, 12);
+    } else {
+        zz = get_bits64(r, 64);
+    }
+    return (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1);
+}
+
+size_t gorilla_encode_times(uint8_t *out, size_t out_cap, const int64_t *times, size_t n)
+{
+    if (n == 0 || out_cap < GORILLA_TIMES_MAX(n)) {
+        return 0;
+    }
+
+    bit_writer_t w = { .p = out };
+    put_bits64(&w, (uint64_t)times[0], 64);
+
+    int64_t prev_delta = 0;
+    for (size_t i = 1; i < n; i++) {
+        int64_t delta = times[i] - times[i - 1];
+        put_dod(&w, delta - prev_delta);
+        prev_delta = delta;
+    }
+
+    return (size_t)(finish_bits(&w) - out);
+}
+
+bool gorilla_decode_times(const uint8_t *in, size_t len, int64_t *times, size_t n)
+{
+    if (n == 0) {
+        return true;
+    }
+
+    bit_reader_t r = { .p = in, .end = in + len };
+    times[0] = (int64_t)get_bits64(&r, 64);
+
+    int64_t delta = 0;
+    for (size_t i = 1; i < n; i++) {
+        delta += get_dod(&r);
+        times[i] = times[i - 1] + delta;
+    }
+
+    return !r.underflow;
+}
+
+/* ---- Values ---- */
+
+static inline uint64_t double_bits(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+size_t gorilla_encode_values(uint8_t *out, size_t out_cap, const double *values, size_t n)
+{
+    if (n == 0 || out_cap < GORILLA_VALUES_MAX(n)) {
+        return 0;
+    }
+
+    bit_writer_t w = { .p = out };
+    uint64_t prev = double_bits(values[0]);
+    put_bits64(&w, prev, 64);
+
+    int prev_leading = 65;      // No window yet
+    int prev_trailing = 0;
+
+    for (size_t i = 1; i < n; i++) {
+        uint64_t bits = double_bits(values[i]);
+        uint64_t x = bits ^ prev;
+        prev = bits;
+
+        if (x == 0) {
+            put_bits(&w, 0x0, 1);
+            continue;
+        }
+
+        int leading = __builtin_clzll(x);
+        int trailing = __builtin_ctzll(x);
+        if (leading > 31) {
+            leading = 31;       // 5-bit field
+        }
+
+        if (leading >= prev_leading && trailing >= prev_trailing) {
+            // Fits in the previous window
+            put_bits(&w, 0x2, 2);
+            put_bits64(&w, x >> prev_trailing, 64 - prev_leading - prev_trailing);
+        } else {
+            int length = 64 - leading - trailing;
+            put_bits(&w, 0x3 << 11 | (uint32_t)leading << 6 | (uint32_t)(length & 0x3F), 13);
+            put_bits64(&w, x >> trailing, length);
+            prev_leading = leading;
+            prev_trailing = trailing;
+        }
+    }
+
+    return (size_t)(finish_bits(&w) - out);
+}
+
+bool gorilla_decode_values(const uint8_t *in, size_t len, double *values, size_t n)
+{
+    if (n == 0) {
+        return true;
+    }
+
+    bit_reader_t r = { .p = in, .end = in + len };
+    uint64_t prev = get_bits64(&r, 64);
+    memcpy(&values[0], &prev, sizeof(prev));
+
+    int leading = 0;
+    int trailing = 0;
+
+    for (size_t i = 1; i < n; i++) {
+        if (get_bits(&r, 1) != 0) {
+            if (get_bits(&r, 1) != 0) {
+                uint32_t header = get_bits(&r, 11);
+                leading = header >> 6;
+                int length = header & 0x3F;
+                if (length == 0) {
+                    length = 64;
+                }
+                trailing = 64 - leading - length;
+                if (trailing < 0) {
+                    return false;
+                }
+            }
+            int length = 64 - leading - trailing;
+            prev ^= get_bits64(&r, length) << trailing;
+        }
+        memcpy(&values[i], &prev, sizeof(prev));
+    }
+
+    return !r.underflow;
+}
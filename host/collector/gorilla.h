@@ -0,0 +1,59 @@
+/**
+ * @file gorilla.h
+ * @brief Gorilla compression of time and value columns
+ *
+ * Timestamps (int64 ms) are stored as the first value followed by
+ * delta-of-deltas in the same zigzag bucket code as sample_time.h: '0' for
+ * zero, '10' + 7 bits, '110' + 9 bits, '1110' + 12 bits, '1111' + 64 bits.
+ * Regularly sampled series cost one bit per point.
+ *
+ * Values (doubles) are stored as the first value followed by the XOR with
+ * the previous value: '0' if equal, '10' + meaningful bits if they fit in
+ * the previous leading/trailing-zero window, otherwise '11' + 5 bits of
+ * leading zeros + 6 bits of length + the meaningful bits.
+ *
+ * Both columns are MSB-first bit streams padded to a whole byte.
+ */
+
+#ifndef GORILLA_H
+#define GORILLA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Worst-case encoded size of n points, per column */
+#define GORILLA_TIMES_MAX(n)    (8 + (size_t)(n) * 9 + 8)
+#define GORILLA_VALUES_MAX(n)   (8 + (size_t)(n) * 10 + 8)
+
+/**
+ * @brief Encode a time column
+ *
+ * @param out_cap Must be at least GORILLA_TIMES_MAX(n)
+ * @return Bytes written, 0 if @p out_cap is too small or n is 0
+ */
+size_t gorilla_encode_times(uint8_t *out, size_t out_cap, const int64_t *times, size_t n);
+
+/**
+ * @brief Encode a value column
+ *
+ * @param out_cap Must be at least GORILLA_VALUES_MAX(n)
+ * @return Bytes written, 0 if @p out_cap is too small or n is 0
+ */
+size_t gorilla_encode_values(uint8_t *out, size_t out_cap, const double *values, size_t n);
+
+/**
+ * @brief Decode n timestamps
+ *
+ * @return false if the column is truncated
+ */
+bool gorilla_decode_times(const uint8_t *in, size_t len, int64_t *times, size_t n);
+
+/**
+ * @brief Decode n values
+ *
+ * @return false if the column is truncated
+ */
+bool gorilla_decode_values(const uint8_t *in, size_t len, double *values, size_t n);
+
+#endif /* GORILLA_H */
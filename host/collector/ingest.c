@@ -0,0 +1,137 @@
+/**
+ * @file ingest.c
+ * @brief AP export line decoder feeding the time-series store
+ */
+
+#include <string.h>
+#include <time.h>
+#include "ingest.h"
+#include "frame_codec.h"
+#include "frame_export.h"
+#include "record_schema.h"
+#include "sample_time.h"
+
+#define INGEST_FRAME_MAX     2048    // Larger than any exported frame
+
+static int64_t wall_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Map the AP's arrival time onto the stored timeline */
+static int64_t arrival_time(ingest_t *in, uint32_t rx_ms)
+{
+    if (in->device_time) {
+        return rx_ms;
+    }
+
+    // Re-anchor on the first frame and whenever the AP clock restarts
+    if (!in->anchored || rx_ms < in->last_rx_ms) {
+        in->time_offset = wall_ms() - rx_ms;
+        in->anchored = true;
+    }
+    in->last_rx_ms = rx_ms;
+    return (int64_t)rx_ms + in->time_offset;
+}
+
+void ingest_init(ingest_t *in, tsdb_t *db, bool device_time)
+{
+    memset(in, 0, sizeof(*in));
+    in->db = db;
+    in->device_time = device_time;
+}
+
+/* Append every sample of one class */
+static bool ingest_class(ingest_t *in, const frame_view_t *view, int class_id, int64_t rx_time,
+                         const sample_times_t *times)
+{
+    static double values[MAX_PACKET_SIZE];
+    const data_packet_header_t *header = view->header;
+    data_type_t type = header->class_types[class_id];
+    uint8_t count = header->class_counts[class_id];
+    uint8_t fields = class_type_fields(type);
+
+    if (count == 0 || fields == 0) {
+        return true;    // Absent
+    }
+    class_type_widen(type, values, view->payload + view->class_offset[class_id], count);
+
+    int series[SCHEMA_MAX_FIELDS];
+    tsdb_series_key_t key = { .class_id = (uint8_t)class_id };
+    memcpy(key.station, view->src_mac, sizeof(key.station));
+    for (uint8_t f = 0; f < fields; f++) {
+        key.field = f;
+        series[f] = tsdb_series(in->db, &key, type);
+        if (series[f] < 0) {
+            return false;
+        }
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        int64_t t = rx_time;
+        uint32_t captured;
+        if (times != NULL && sample_time_at(times, class_id, i, &captured)) {
+            t -= (int32_t)(header->timestamp - captured);   // Age when the frame was sent
+        }
+        for (uint8_t f = 0; f < fields; f++) {
+            if (tsdb_append(in->db, (uint32_t)series[f], t, values[(size_t)i * fields + f]) < 0) {
+                return false;
+            }
+        }
+    }
+
+    in->samples += (uint64_t)count * fields;
+    return true;
+}
+
+bool ingest_line(ingest_t *in, const char *line, size_t len)
+{
+    static uint8_t frame[INGEST_FRAME_MAX];
+    static sample_times_t times;
+    uint32_t rx_ms;
+    int8_t rssi;
+    size_t frame_len;
+
+    in->lines++;
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    if (len < FRAME_EXPORT_PREFIX_LEN || memcmp(line, FRAME_EXPORT_PREFIX, FRAME_EXPORT_PREFIX_LEN) != 0) {
+        return true;    // AP log output
+    }
+
+    if (!frame_export_parse(line, len, &rx_ms, &rssi, frame, sizeof(frame), &frame_len)) {
+        in->bad_lines++;
+        return true;
+    }
+
+    frame_view_t view;
+    if (frame_parse(frame, frame_len, NULL, &view) != FRAME_OK) {
+        in->bad_frames++;
+        return true;
+    }
+    in->frames++;
+
+    if (view.kind == FRAME_KIND_SCHEMA) {
+        record_schema_unpack(view.payload, view.payload_len);
+        in->schema_frames++;
+        return true;
+    }
+    if (view.kind == FRAME_KIND_BENCH) {
+        return true;    // Link benchmark traffic carries no samples
+    }
+
+    int64_t rx_time = arrival_time(in, rx_ms);
+    bool have_times = view.time_block != NULL &&
+        sample_time_decode(view.time_block, view.time_block_len, view.header->timestamp, &times);
+
+    for (int class_id = 0; class_id < MAX_CLASSES; class_id++) {
+        if (!ingest_class(in, &view, class_id, rx_time, have_times ? &times : NULL)) {
+            in->write_errors++;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file ingest.h
+ * @brief Decode AP export lines into per-station, per-class series points
+ *
+ * Each "@FRM" line (frame_export.h) goes through frame_parse() like on the
+ * AP. Schema announcements register record layouts; data frames have every
+ * class widened to doubles and appended to the series of (station MAC,
+ * class, field). A sample's time is the frame's arrival time, moved back by
+ * its age at transmission when the frame carries per-sample capture times.
+ */
+
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "tsdb.h"
+
+typedef struct {
+    tsdb_t *db;
+    bool device_time;           // Use the AP clock as the timeline instead of host time
+    int64_t time_offset;        // Host ms minus AP ms
+    uint32_t last_rx_ms;
+    bool anchored;
+
+    // Statistics
+    uint64_t lines;
+    uint64_t frames;            // Valid export lines
+    uint64_t schema_frames;
+    uint64_t bad_lines;         // "@FRM" lines that did not parse
+    uint64_t bad_frames;        // Parsed lines that failed frame validation
+    uint64_t samples;           // Points appended
+    uint64_t write_errors;
+} ingest_t;
+
+/**
+ * @brief Start ingesting into an open, writable database
+ *
+ * @param device_time Store AP clock milliseconds instead of host wall-clock time
+ */
+void ingest_init(ingest_t *in, tsdb_t *db, bool device_time);
+
+/**
+ * @brief Process one line without its terminator; other log lines are ignored
+ *
+ * @return false if a point could not be written
+ */
+bool ingest_line(ingest_t *in, const char *line, size_t len);
+
+#endif /* INGEST_H */
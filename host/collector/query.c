@@ -0,0 +1,512 @@
+/**
+ * @file query.c
+ * @brief Range and aggregate queries over stored series
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "query.h"
+
+/* Values kept for a bucket's quantile */
+typedef struct {
+    double *v;
+    size_t count;
+    size_t cap;
+} value_list_t;
+
+/* A run of index entries of one partition */
+typedef struct {
+    const tsdb_partition_map_t *map;
+    size_t first;
+    size_t end;
+} work_unit_t;
+
+/* State shared by the workers of one query */
+typedef struct {
+    const query_t *q;
+    const uint8_t *selected;    // Per series id: 1 if part of the query
+    uint32_t series_count;
+    int64_t t_from;             // Query range clamped to the stored data
+    int64_t t_to;
+    int64_t origin;             // Start of bucket 0
+    int64_t width;              // Bucket width, 0 for a single bucket
+    size_t bucket_count;
+    const work_unit_t *units;
+    size_t unit_count;
+    size_t next_unit;           // Claimed atomically
+} query_ctx_t;
+
+typedef struct {
+    query_ctx_t *ctx;
+    pthread_t thread;
+    query_agg_t *aggs;
+    value_list_t *lists;        // NULL without a quantile
+    int64_t *times;
+    double *values;
+    int error;                  // errno of the first failure, 0 if none
+
+    uint64_t blocks;
+    uint64_t blocks_skipped;
+    uint64_t blocks_indexed;
+    uint64_t blocks_decoded;
+    uint64_t blocks_corrupt;
+    uint64_t rows;
+    uint64_t rows_decoded;
+} worker_t;
+
+void query_init(query_t *q)
+{
+    *q = (query_t) {
+        .t_from = INT64_MIN,
+        .t_to = INT64_MAX,
+        .v_lo = -INFINITY,
+        .v_hi = INFINITY,
+        .quantile = -1.0,
+    };
+}
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+static size_t bucket_of(const query_ctx_t *ctx, int64_t t)
+{
+    return ctx->width > 0 ? (size_t)((uint64_t)(t - ctx->origin) / (uint64_t)ctx->width) : 0;
+}
+
+static bool list_reserve(value_list_t *list, size_t more)
+{
+    if (list->count + more <= list->cap) {
+        return true;
+    }
+    size_t cap = list->cap ? list->cap : 256;
+    while (cap < list->count + more) {
+        cap *= 2;
+    }
+    double *grown = realloc(list->v, cap * sizeof(*grown));
+    if (grown == NULL) {
+        return false;
+    }
+    list->v = grown;
+    list->cap = cap;
+    return true;
+}
+
+/* Aggregate n consecutive points that all fall in bucket b */
+static void add_run(worker_t *w, size_t b, const double *v, size_t n)
+{
+    const query_t *q = w->ctx->q;
+
+    query_agg_range(v, n, q->v_lo, q->v_hi, &w->aggs[b]);
+    if (w->lists != NULL) {
+        value_list_t *list = &w->lists[b];
+        if (!list_reserve(list, n)) {
+            w->error = ENOMEM;
+            return;
+        }
+        list->count += query_select_range(v, n, q->v_lo, q->v_hi, list->v + list->count);
+    }
+}
+
+static void add_block(worker_t *w, const int64_t *times, const double *values, size_t n)
+{
+    const query_ctx_t *ctx = w->ctx;
+
+    if (!query_times_sorted(times, n)) {
+        // Out-of-order block: place each point on its own
+        for (size_t i = 0; i < n; i++) {
+            if (times[i] >= ctx->t_from && times[i] <= ctx->t_to) {
+                add_run(w, bucket_of(ctx, times[i]), &values[i], 1);
+            }
+        }
+        return;
+    }
+
+    size_t i = query_lower_bound(times, n, ctx->t_from);
+    size_t end = ctx->t_to < INT64_MAX ? query_lower_bound(times, n, ctx->t_to + 1) : n;
+
+    // One kernel call per bucket the block spans
+    while (i < end) {
+        size_t b = bucket_of(ctx, times[i]);
+        size_t j = end;
+        if (ctx->width > 0) {
+            int64_t bucket_end = ctx->origin + (int64_t)(b + 1) * ctx->width;
+            j = i + query_lower_bound(times + i, end - i, bucket_end);
+        }
+        add_run(w, b, values + i, j - i);
+        i = j;
+    }
+}
+
+/* True if the block needs no decoding: one bucket, inside range and filter */
+static bool answer_from_index(const query_ctx_t *ctx, const tsdb_index_entry_t *e)
+{
+    const query_t *q = ctx->q;
+
+    return !q->force_decode && q->quantile < 0 &&
+           e->t_min >= ctx->t_from && e->t_max <= ctx->t_to &&
+           bucket_of(ctx, e->t_min) == bucket_of(ctx, e->t_max) &&
+           e->v_min >= q->v_lo && e->v_max <= q->v_hi && !isnan(e->v_sum);
+}
+
+static void process_unit(worker_t *w, const work_unit_t *unit)
+{
+    const query_ctx_t *ctx = w->ctx;
+    const query_t *q = ctx->q;
+
+    for (size_t i = unit->first; i < unit->end && w->error == 0; i++) {
+        const tsdb_index_entry_t *e = &unit->map->index[i];
+        if (e->series_id >= ctx->series_count || !ctx->selected[e->series_id]) {
+            continue;
+        }
+        w->blocks++;
+
+        if (e->t_max < ctx->t_from || e->t_min > ctx->t_to || e->v_max < q->v_lo || e->v_min > q->v_hi) {
+            w->blocks_skipped++;
+            continue;
+        }
+
+        if (answer_from_index(ctx, e)) {
+            query_agg_t block = { .count = e->count, .sum = e->v_sum, .min = e->v_min, .max = e->v_max };
+            query_agg_merge(&w->aggs[bucket_of(ctx, e->t_min)], &block);
+            w->blocks_indexed++;
+            w->rows += e->count;
+            continue;
+        }
+
+        if (e->count > TSDB_BLOCK_POINTS || !tsdb_block_decode(unit->map, e, w->times, w->values)) {
+            w->blocks_corrupt++;
+            continue;
+        }
+        add_block(w, w->times, w->values, e->count);
+        w->blocks_decoded++;
+        w->rows += e->count;
+        w->rows_decoded += e->count;
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    worker_t *w = arg;
+    query_ctx_t *ctx = w->ctx;
+
+    for (;;) {
+        size_t u = __atomic_fetch_add(&ctx->next_unit, 1, __ATOMIC_RELAXED);
+        if (u >= ctx->unit_count || w->error != 0) {
+            break;
+        }
+        process_unit(w, &ctx->units[u]);
+    }
+    return NULL;
+}
+
+static int worker_init(worker_t *w, query_ctx_t *ctx)
+{
+    memset(w, 0, sizeof(*w));
+    w->ctx = ctx;
+    w->aggs = malloc(ctx->bucket_count * sizeof(*w->aggs));
+    w->times = malloc(TSDB_BLOCK_POINTS * sizeof(*w->times));
+    w->values = malloc(TSDB_BLOCK_POINTS * sizeof(*w->values));
+    if (ctx->q->quantile >= 0) {
+        w->lists = calloc(ctx->bucket_count, sizeof(*w->lists));
+    }
+    if (w->aggs == NULL || w->times == NULL || w->values == NULL ||
+        (ctx->q->quantile >= 0 && w->lists == NULL)) {
+        return -1;
+    }
+    for (size_t b = 0; b < ctx->bucket_count; b++) {
+        query_agg_init(&w->aggs[b]);
+    }
+    return 0;
+}
+
+static void worker_free(worker_t *w)
+{
+    if (w->lists != NULL) {
+        for (size_t b = 0; b < w->ctx->bucket_count; b++) {
+            free(w->lists[b].v);
+        }
+    }
+    free(w->lists);
+    free(w->aggs);
+    free(w->times);
+    free(w->values);
+}
+
+/*
+ * Clamp the query range to the stored data of the selected series, so
+ * unbounded queries get a finite set of buckets. Returns false if no
+ * block can contribute.
+ */
+static bool clamp_range(query_ctx_t *ctx, const tsdb_partition_map_t *maps, int map_count)
+{
+    const query_t *q = ctx->q;
+    int64_t lo = INT64_MAX, hi = INT64_MIN;
+
+    for (int p = 0; p < map_count; p++) {
+        for (size_t i = 0; i < maps[p].index_count; i++) {
+            const tsdb_index_entry_t *e = &maps[p].index[i];
+            if (e->series_id >= ctx->series_count || !ctx->selected[e->series_id] ||
+                e->t_max < q->t_from || e->t_min > q->t_to || e->v_max < q->v_lo || e->v_min > q->v_hi) {
+                continue;
+            }
+            lo = e->t_min < lo ? e->t_min : lo;
+            hi = e->t_max > hi ? e->t_max : hi;
+        }
+    }
+    if (lo > hi) {
+        return false;
+    }
+
+    ctx->t_from = lo > q->t_from ? lo : q->t_from;
+    ctx->t_to = hi < q->t_to ? hi : q->t_to;
+    return true;
+}
+
+/* Split every partition's index into runs of QUERY_RUN_ENTRIES */
+static work_unit_t *make_units(const tsdb_partition_map_t *maps, int map_count, size_t *count)
+{
+    size_t total = 0;
+    for (int p = 0; p < map_count; p++) {
+        total += (maps[p].index_count + QUERY_RUN_ENTRIES - 1) / QUERY_RUN_ENTRIES;
+    }
+
+    work_unit_t *units = malloc((total ? total : 1) * sizeof(*units));
+    if (units == NULL) {
+        return NULL;
+    }
+
+    size_t n = 0;
+    for (int p = 0; p < map_count; p++) {
+        for (size_t first = 0; first < maps[p].index_count; first += QUERY_RUN_ENTRIES) {
+            size_t end = first + QUERY_RUN_ENTRIES;
+            units[n++] = (work_unit_t) {
+                .map = &maps[p],
+                .first = first,
+                .end = end < maps[p].index_count ? end : maps[p].index_count,
+            };
+        }
+    }
+    *count = n;
+    return units;
+}
+
+/* Fold every worker into the result buckets */
+static int merge_workers(const query_ctx_t *ctx, worker_t *workers, int count, query_result_t *result)
+{
+    for (size_t b = 0; b < ctx->bucket_count; b++) {
+        query_bucket_t *bucket = &result->buckets[b];
+        bucket->start = ctx->width > 0 ? ctx->origin + (int64_t)b * ctx->width : ctx->t_from;
+        bucket->quantile = NAN;
+        query_agg_init(&bucket->agg);
+        for (int i = 0; i < count; i++) {
+            query_agg_merge(&bucket->agg, &workers[i].aggs[b]);
+        }
+
+        if (ctx->q->quantile < 0) {
+            continue;
+        }
+        // Gather every worker's values into the first worker's list
+        value_list_t *all = &workers[0].lists[b];
+        for (int i = 1; i < count; i++) {
+            value_list_t *list = &workers[i].lists[b];
+            if (list->count == 0) {
+                continue;
+            }
+            if (!list_reserve(all, list->count)) {
+                errno = ENOMEM;
+                return -1;
+            }
+            memcpy(all->v + all->count, list->v, list->count * sizeof(*list->v));
+            all->count += list->count;
+        }
+        bucket->quantile = query_quantile(all->v, all->count, ctx->q->quantile);
+    }
+
+    for (int i = 0; i < count; i++) {
+        worker_t *w = &workers[i];
+        result->blocks += w->blocks;
+        result->blocks_skipped += w->blocks_skipped;
+        result->blocks_indexed += w->blocks_indexed;
+        result->blocks_decoded += w->blocks_decoded;
+        result->blocks_corrupt += w->blocks_corrupt;
+        result->rows += w->rows;
+        result->rows_decoded += w->rows_decoded;
+    }
+    result->threads = count;
+    return 0;
+}
+
+static int run_workers(query_ctx_t *ctx, query_result_t *result)
+{
+    long threads = ctx->q->threads > 0 ? ctx->q->threads : sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) {
+        threads = 1;
+    }
+    if ((size_t)threads > ctx->unit_count) {
+        threads = ctx->unit_count > 0 ? (long)ctx->unit_count : 1;
+    }
+
+    worker_t *workers = calloc((size_t)threads, sizeof(*workers));
+    if (workers == NULL) {
+        return -1;
+    }
+
+    int ready = 0, status = 0;
+    for (; ready < threads; ready++) {
+        if (worker_init(&workers[ready], ctx) < 0) {
+            worker_free(&workers[ready]);
+            status = -1;
+            break;
+        }
+    }
+
+    if (status == 0) {
+        // The calling thread is worker 0
+        int started = 1;
+        for (; started < threads; started++) {
+            if (pthread_create(&workers[started].thread, NULL, worker_main, &workers[started]) != 0) {
+                break;
+            }
+        }
+        worker_main(&workers[0]);
+        for (int i = 1; i < started; i++) {
+            pthread_join(workers[i].thread, NULL);
+        }
+
+        for (int i = 0; i < started; i++) {
+            if (workers[i].error != 0) {
+                errno = workers[i].error;
+                status = -1;
+            }
+        }
+        if (status == 0) {
+            status = merge_workers(ctx, workers, started, result);
+        }
+    }
+
+    for (int i = 0; i < ready; i++) {
+        worker_free(&workers[i]);
+    }
+    free(workers);
+    return status;
+}
+
+/* Per series id of db: 1 if listed; malloc'd */
+static uint8_t *select_series(const tsdb_t *db, const uint32_t *series_ids, size_t series_count)
+{
+    uint8_t *selected = calloc(db->series_count ? db->series_count : 1, 1);
+    if (selected == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < series_count; i++) {
+        if (series_ids[i] < db->series_count) {
+            selected[series_ids[i]] = 1;
+        }
+    }
+    return selected;
+}
+
+int query_run(const tsdb_t *db, const uint32_t *series_ids, size_t series_count,
+              const query_t *q, query_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    if (q->bucket_ms < 0 || q->t_from > q->t_to || q->quantile > 1.0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint8_t *selected = select_series(db, series_ids, series_count);
+    if (selected == NULL) {
+        return -1;
+    }
+    query_ctx_t ctx = {
+        .q = q,
+        .selected = selected,
+        .series_count = db->series_count,
+        .width = q->bucket_ms,
+    };
+
+    tsdb_partition_map_t *maps;
+    int map_count = tsdb_map(db, q->t_from, q->t_to, &maps);
+    if (map_count < 0) {
+        free(selected);
+        return -1;
+    }
+
+    int status = 0;
+    if (clamp_range(&ctx, maps, map_count)) {
+        if (ctx.width > 0) {
+            ctx.origin = floor_div(ctx.t_from, ctx.width) * ctx.width;
+            uint64_t span = (uint64_t)(ctx.t_to - ctx.origin) / (uint64_t)ctx.width;
+            ctx.bucket_count = span < QUERY_MAX_BUCKETS ? (size_t)span + 1 : 0;
+        } else {
+            ctx.bucket_count = 1;
+        }
+
+        ctx.units = make_units(maps, map_count, &ctx.unit_count);
+        result->buckets = calloc(ctx.bucket_count ? ctx.bucket_count : 1, sizeof(*result->buckets));
+
+        if (ctx.bucket_count == 0) {
+            errno = E2BIG;
+            status = -1;
+        } else if (ctx.units == NULL || result->buckets == NULL) {
+            errno = ENOMEM;
+            status = -1;
+        } else {
+            result->bucket_count = ctx.bucket_count;
+            status = run_workers(&ctx, result);
+        }
+        free((void *)ctx.units);
+    }
+
+    if (status < 0) {
+        int err = errno;
+        query_result_free(result);
+        errno = err;
+    }
+    tsdb_unmap(maps, map_count);
+    free(selected);
+    return status;
+}
+
+void query_result_free(query_result_t *result)
+{
+    free(result->buckets);
+    result->buckets = NULL;
+    result->bucket_count = 0;
+}
+
+int query_extent(const tsdb_t *db, const uint32_t *series_ids, size_t series_count,
+                 int64_t *t_min, int64_t *t_max)
+{
+    query_t q;
+    query_init(&q);
+
+    uint8_t *selected = select_series(db, series_ids, series_count);
+    if (selected == NULL) {
+        return -1;
+    }
+    query_ctx_t ctx = { .q = &q, .selected = selected, .series_count = db->series_count };
+
+    tsdb_partition_map_t *maps;
+    int map_count = tsdb_map(db, q.t_from, q.t_to, &maps);
+    if (map_count < 0) {
+        free(selected);
+        return -1;
+    }
+
+    int found = clamp_range(&ctx, maps, map_count) ? 1 : 0;
+    *t_min = ctx.t_from;
+    *t_max = ctx.t_to;
+
+    tsdb_unmap(maps, map_count);
+    free(selected);
+    return found;
+}
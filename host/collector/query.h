@@ -0,0 +1,89 @@
+/**
+ * @file query.h
+ * @brief Range and aggregate queries over stored series
+ *
+ * A query selects one or more series, a closed time range, an optional
+ * value filter and a bucket width, and returns count, sum, min, max and
+ * optionally one quantile per time bucket. Buckets are aligned to
+ * multiples of the width from the epoch, so one-minute buckets start on
+ * whole minutes.
+ *
+ * The sparse index is used as a skip index. A block outside the time range
+ * or value filter is skipped unread. A block that lies wholly inside one
+ * bucket, the range and the filter is answered from its index entry
+ * (count, sum, min, max) without decompressing it. Only the remaining
+ * blocks are decoded and fed to the kernels in query_kernels.h.
+ *
+ * Partitions are mapped once and split into runs of index entries that
+ * worker threads claim in turn. Each worker aggregates into its own
+ * buckets, and the buckets are merged when all runs are done.
+ */
+
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "query_kernels.h"
+#include "tsdb.h"
+
+#define QUERY_MAX_BUCKETS   (1u << 20)      // Refuse queries that would need more
+#define QUERY_RUN_ENTRIES   256             // Index entries per unit of work
+
+typedef struct {
+    int64_t t_from;             // Inclusive; INT64_MIN for no bound
+    int64_t t_to;               // Inclusive; INT64_MAX for no bound
+    int64_t bucket_ms;          // Bucket width, 0 for one bucket over the whole range
+    double v_lo;                // Value filter, inclusive; -INFINITY for no bound
+    double v_hi;                // +INFINITY for no bound
+    double quantile;            // In [0, 1], or negative for none
+    int threads;                // Worker threads, 0 for one per online CPU
+    bool force_decode;          // Never answer from index entries (benchmarks, checks)
+} query_t;
+
+typedef struct {
+    int64_t start;              // Bucket start time
+    query_agg_t agg;
+    double quantile;            // NaN if not requested or empty
+} query_bucket_t;
+
+typedef struct {
+    query_bucket_t *buckets;    // First to last bucket holding data, empty ones included
+    size_t bucket_count;
+
+    // Statistics
+    uint64_t blocks;            // Index entries of the selected series
+    uint64_t blocks_skipped;    // Outside the range or filter, never read
+    uint64_t blocks_indexed;    // Answered from the index entry
+    uint64_t blocks_decoded;
+    uint64_t blocks_corrupt;
+    uint64_t rows;              // Points in blocks that were indexed or decoded
+    uint64_t rows_decoded;
+    int threads;                // Workers actually used
+} query_result_t;
+
+/* Defaults: whole time range, no filter, one bucket, no quantile */
+void query_init(query_t *q);
+
+/**
+ * @brief Run a query over the union of the given series
+ *
+ * @param series_ids Series ids of @p db; unknown ids are ignored
+ * @param result Receives the buckets; release with query_result_free()
+ * @return 0 on success, -1 with errno set on failure
+ */
+int query_run(const tsdb_t *db, const uint32_t *series_ids, size_t series_count,
+              const query_t *q, query_result_t *result);
+
+void query_result_free(query_result_t *result);
+
+/**
+ * @brief Time range covered by the flushed blocks of the given series, from the index alone
+ *
+ * @return 1 if any block exists, 0 if none, -1 with errno set on failure
+ */
+int query_extent(const tsdb_t *db, const uint32_t *series_ids, size_t series_count,
+                 int64_t *t_min, int64_t *t_max);
+
+#endif /* QUERY_H */
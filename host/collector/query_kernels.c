@@ -0,0 +1,263 @@
+/**
+ * @file query_kernels.c
+ * @brief Aggregation kernels over decoded value columns
+ */
+
+#include <math.h>
+#include "query_kernels.h"
+
+#if !defined(QUERY_NO_SIMD) && defined(__AVX__)
+#include <immintrin.h>
+#define QUERY_KERNEL_AVX 1
+const char *const query_kernel_name = "avx";
+#elif !defined(QUERY_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define QUERY_KERNEL_SSE2 1
+const char *const query_kernel_name = "sse2";
+#else
+const char *const query_kernel_name = "scalar";
+#endif
+
+void query_agg_init(query_agg_t *agg)
+{
+    agg->count = 0;
+    agg->sum = 0.0;
+    agg->min = INFINITY;
+    agg->max = -INFINITY;
+}
+
+void query_agg_merge(query_agg_t *agg, const query_agg_t *other)
+{
+    agg->count += other->count;
+    agg->sum += other->sum;
+    if (other->min < agg->min) {
+        agg->min = other->min;
+    }
+    if (other->max > agg->max) {
+        agg->max = other->max;
+    }
+}
+
+/* Scalar tail and fallback */
+static void agg_range_scalar(const double *v, size_t n, double lo, double hi, query_agg_t *agg)
+{
+    for (size_t i = 0; i < n; i++) {
+        double x = v[i];
+        if (x >= lo && x <= hi) {
+            agg->count++;
+            agg->sum += x;
+            agg->min = x < agg->min ? x : agg->min;
+            agg->max = x > agg->max ? x : agg->max;
+        }
+    }
+}
+
+#if defined(QUERY_KERNEL_AVX)
+
+void query_agg_range(const double *v, size_t n, double lo, double hi, query_agg_t *agg)
+{
+    const __m256d vlo = _mm256_set1_pd(lo);
+    const __m256d vhi = _mm256_set1_pd(hi);
+    const __m256d pinf = _mm256_set1_pd(INFINITY);
+    const __m256d ninf = _mm256_set1_pd(-INFINITY);
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    __m256d min0 = pinf, min1 = pinf;
+    __m256d max0 = ninf, max1 = ninf;
+    uint64_t count = 0;
+    size_t i = 0;
+
+    // Two independent chains hide the add latency
+    for (; i + 8 <= n; i += 8) {
+        __m256d a = _mm256_loadu_pd(v + i);
+        __m256d b = _mm256_loadu_pd(v + i + 4);
+        __m256d ma = _mm256_and_pd(_mm256_cmp_pd(a, vlo, _CMP_GE_OQ), _mm256_cmp_pd(a, vhi, _CMP_LE_OQ));
+        __m256d mb = _mm256_and_pd(_mm256_cmp_pd(b, vlo, _CMP_GE_OQ), _mm256_cmp_pd(b, vhi, _CMP_LE_OQ));
+        sum0 = _mm256_add_pd(sum0, _mm256_and_pd(ma, a));
+        sum1 = _mm256_add_pd(sum1, _mm256_and_pd(mb, b));
+        min0 = _mm256_min_pd(min0, _mm256_blendv_pd(pinf, a, ma));
+        min1 = _mm256_min_pd(min1, _mm256_blendv_pd(pinf, b, mb));
+        max0 = _mm256_max_pd(max0, _mm256_blendv_pd(ninf, a, ma));
+        max1 = _mm256_max_pd(max1, _mm256_blendv_pd(ninf, b, mb));
+        count += (uint64_t)__builtin_popcount(_mm256_movemask_pd(ma) | (_mm256_movemask_pd(mb) << 4));
+    }
+
+    double s[4], lo4[4], hi4[4];
+    _mm256_storeu_pd(s, _mm256_add_pd(sum0, sum1));
+    _mm256_storeu_pd(lo4, _mm256_min_pd(min0, min1));
+    _mm256_storeu_pd(hi4, _mm256_max_pd(max0, max1));
+
+    query_agg_t part = { .count = count, .sum = (s[0] + s[1]) + (s[2] + s[3]),
+                         .min = fmin(fmin(lo4[0], lo4[1]), fmin(lo4[2], lo4[3])),
+                         .max = fmax(fmax(hi4[0], hi4[1]), fmax(hi4[2], hi4[3])) };
+    agg_range_scalar(v + i, n - i, lo, hi, &part);
+    query_agg_merge(agg, &part);
+}
+
+#elif defined(QUERY_KERNEL_SSE2)
+
+/* mask ? v : other */
+static inline __m128d select_pd(__m128d mask, __m128d v, __m128d other)
+{
+    return _mm_or_pd(_mm_and_pd(mask, v), _mm_andnot_pd(mask, other));
+}
+
+void query_agg_range(const double *v, size_t n, double lo, double hi, query_agg_t *agg)
+{
+    const __m128d vlo = _mm_set1_pd(lo);
+    const __m128d vhi = _mm_set1_pd(hi);
+    const __m128d pinf = _mm_set1_pd(INFINITY);
+    const __m128d ninf = _mm_set1_pd(-INFINITY);
+    __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+    __m128d min0 = pinf, min1 = pinf;
+    __m128d max0 = ninf, max1 = ninf;
+    uint64_t count = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128d a = _mm_loadu_pd(v + i);
+        __m128d b = _mm_loadu_pd(v + i + 2);
+        __m128d ma = _mm_and_pd(_mm_cmpge_pd(a, vlo), _mm_cmple_pd(a, vhi));
+        __m128d mb = _mm_and_pd(_mm_cmpge_pd(b, vlo), _mm_cmple_pd(b, vhi));
+        sum0 = _mm_add_pd(sum0, _mm_and_pd(ma, a));
+        sum1 = _mm_add_pd(sum1, _mm_and_pd(mb, b));
+        min0 = _mm_min_pd(min0, select_pd(ma, a, pinf));
+        min1 = _mm_min_pd(min1, select_pd(mb, b, pinf));
+        max0 = _mm_max_pd(max0, select_pd(ma, a, ninf));
+        max1 = _mm_max_pd(max1, select_pd(mb, b, ninf));
+        count += (uint64_t)__builtin_popcount(_mm_movemask_pd(ma) | (_mm_movemask_pd(mb) << 2));
+    }
+
+    double s[2], lo2[2], hi2[2];
+    _mm_storeu_pd(s, _mm_add_pd(sum0, sum1));
+    _mm_storeu_pd(lo2, _mm_min_pd(min0, min1));
+    _mm_storeu_pd(hi2, _mm_max_pd(max0, max1));
+
+    query_agg_t part = { .count = count, .sum = s[0] + s[1],
+                         .min = fmin(lo2[0], lo2[1]), .max = fmax(hi2[0], hi2[1]) };
+    agg_range_scalar(v + i, n - i, lo, hi, &part);
+    query_agg_merge(agg, &part);
+}
+
+#else
+
+void query_agg_range(const double *v, size_t n, double lo, double hi, query_agg_t *agg)
+{
+    query_agg_t lanes[4];
+    size_t i = 0;
+
+    for (int l = 0; l < 4; l++) {
+        query_agg_init(&lanes[l]);
+    }
+    for (; i + 4 <= n; i += 4) {
+        for (int l = 0; l < 4; l++) {
+            double x = v[i + l];
+            bool match = x >= lo && x <= hi;
+            lanes[l].count += match;
+            lanes[l].sum += match ? x : 0.0;
+            lanes[l].min = match && x < lanes[l].min ? x : lanes[l].min;
+            lanes[l].max = match && x > lanes[l].max ? x : lanes[l].max;
+        }
+    }
+    for (int l = 1; l < 4; l++) {
+        query_agg_merge(&lanes[0], &lanes[l]);
+    }
+    agg_range_scalar(v + i, n - i, lo, hi, &lanes[0]);
+    query_agg_merge(agg, &lanes[0]);
+}
+
+#endif
+
+size_t query_select_range(const double *v, size_t n, double lo, double hi, double *out)
+{
+    size_t k = 0;
+
+    // Branch-free: always store, advance only on a match
+    for (size_t i = 0; i < n; i++) {
+        double x = v[i];
+        out[k] = x;
+        k += (x >= lo) & (x <= hi);
+    }
+    return k;
+}
+
+bool query_times_sorted(const int64_t *t, size_t n)
+{
+    int unsorted = 0;
+    for (size_t i = 1; i < n; i++) {
+        unsorted |= t[i] < t[i - 1];
+    }
+    return !unsorted;
+}
+
+size_t query_lower_bound(const int64_t *t, size_t n, int64_t key)
+{
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (t[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void swap_d(double *a, double *b)
+{
+    double t = *a;
+    *a = *b;
+    *b = t;
+}
+
+double query_quantile(double *v, size_t n, double q)
+{
+    if (n == 0) {
+        return NAN;
+    }
+
+    double rank = ceil(q * (double)n);
+    size_t k = rank < 1.0 ? 0 : rank >= (double)n ? n - 1 : (size_t)rank - 1;
+
+    // Quickselect with a median-of-three pivot
+    size_t lo = 0, hi = n - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (v[mid] < v[lo]) {
+            swap_d(&v[mid], &v[lo]);
+        }
+        if (v[hi] < v[lo]) {
+            swap_d(&v[hi], &v[lo]);
+        }
+        if (v[hi] < v[mid]) {
+            swap_d(&v[hi], &v[mid]);
+        }
+        double pivot = v[mid];
+
+        size_t i = lo, j = hi;
+        while (i <= j) {
+            while (v[i] < pivot) {
+                i++;
+            }
+            while (v[j] > pivot) {
+                j--;
+            }
+            if (i <= j) {
+                swap_d(&v[i], &v[j]);
+                i++;
+                if (j == 0) {
+                    break;
+                }
+                j--;
+            }
+        }
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+    return v[k];
+}
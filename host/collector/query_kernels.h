@@ -0,0 +1,60 @@
+/**
+ * @file query_kernels.h
+ * @brief Aggregation kernels over decoded value columns
+ *
+ * Blocks are decoded into doubles whatever the series' source type, so one
+ * set of kernels serves every stored type. The aggregate kernel uses AVX
+ * or SSE2 when the compiler targets them (-march=native picks AVX) and a
+ * four-accumulator scalar loop otherwise; build with -DQUERY_NO_SIMD to
+ * force the scalar path. Values outside [lo, hi], and NaN, never match.
+ */
+
+#ifndef QUERY_KERNELS_H
+#define QUERY_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Running aggregate of matching values */
+typedef struct {
+    uint64_t count;
+    double sum;
+    double min;                 // +inf while empty
+    double max;                 // -inf while empty
+} query_agg_t;
+
+/* Name of the compiled kernel variant: "avx", "sse2" or "scalar" */
+extern const char *const query_kernel_name;
+
+void query_agg_init(query_agg_t *agg);
+
+/* Fold another aggregate into agg */
+void query_agg_merge(query_agg_t *agg, const query_agg_t *other);
+
+/**
+ * @brief Add the values of v[0..n) that lie in [lo, hi] to agg
+ */
+void query_agg_range(const double *v, size_t n, double lo, double hi, query_agg_t *agg);
+
+/**
+ * @brief Copy the values of v[0..n) that lie in [lo, hi] to out
+ *
+ * @return Values copied; out needs room for n
+ */
+size_t query_select_range(const double *v, size_t n, double lo, double hi, double *out);
+
+/* True if t[0..n) is non-decreasing */
+bool query_times_sorted(const int64_t *t, size_t n);
+
+/* First index of sorted t[0..n) with t[i] >= key, n if none */
+size_t query_lower_bound(const int64_t *t, size_t n, int64_t key);
+
+/**
+ * @brief The value of rank ceil(q * n) (nearest rank) of v[0..n)
+ *
+ * Reorders v. Returns NaN if n is 0.
+ */
+double query_quantile(double *v, size_t n, double q);
+
+#endif /* QUERY_KERNELS_H */
@@ -0,0 +1,720 @@
+/**
+ * @file tsdb.c
+ * @brief Chunked columnar time-series store: writer, catalog and mapped reads
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "tsdb.h"
+#include "gorilla.h"
+
+#define TSDB_VERSION        1
+#define SCRATCH_LEN         (sizeof(tsdb_block_header_t) + GORILLA_TIMES_MAX(TSDB_BLOCK_POINTS) + \
+                             GORILLA_VALUES_MAX(TSDB_BLOCK_POINTS) + 8)
+
+_Static_assert(sizeof(tsdb_block_header_t) == 24, "block header layout");
+_Static_assert(sizeof(tsdb_index_entry_t) == 64, "index entry layout");
+
+/* ---- Helpers ---- */
+
+static int64_t partition_of(const tsdb_t *db, int64_t time)
+{
+    int64_t q = time / db->partition_ms;
+    if (time % db->partition_ms < 0) {
+        q--;
+    }
+    return q * db->partition_ms;
+}
+
+static int db_path(const tsdb_t *db, char *out, size_t cap, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static int db_path(const tsdb_t *db, char *out, size_t cap, const char *fmt, ...)
+{
+    char name[64];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(name, sizeof(name), fmt, args);
+    va_end(args);
+
+    int n = snprintf(out, cap, "%s/%s", db->dir, name);
+    if (n < 0 || (size_t)n >= cap) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    return 0;
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static uint64_t pack_key(const tsdb_series_key_t *key)
+{
+    uint64_t packed = 0;
+    memcpy(&packed, key->station, sizeof(key->station));
+    return packed | (uint64_t)key->class_id << 48 | (uint64_t)key->field << 56;
+}
+
+static uint32_t key_slot(const tsdb_t *db, uint64_t packed)
+{
+    return (uint32_t)((packed * 0x9E3779B97F4A7C15ull) >> 32) & db->slot_mask;
+}
+
+/* ---- Metadata and catalog ---- */
+
+static int read_meta(tsdb_t *db)
+{
+    char path[PATH_MAX];
+    if (db_path(db, path, sizeof(path), "meta") < 0) {
+        return -1;
+    }
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    int version = 0;
+    long long span = 0;
+    int ok = fscanf(f, "tsdb %d partition_ms %lld", &version, &span);
+    fclose(f);
+
+    if (ok != 2 || version != TSDB_VERSION || span <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    db->partition_ms = span;
+    return 0;
+}
+
+static int write_meta(const tsdb_t *db)
+{
+    char path[PATH_MAX];
+    if (db_path(db, path, sizeof(path), "meta") < 0) {
+        return -1;
+    }
+
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    fprintf(f, "tsdb %d\npartition_ms %lld\n", TSDB_VERSION, (long long)db->partition_ms);
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static int grow_slots(tsdb_t *db, uint32_t size)
+{
+    uint32_t *slots = calloc(size, sizeof(*slots));
+    if (slots == NULL) {
+        return -1;
+    }
+
+    free(db->slots);
+    db->slots = slots;
+    db->slot_mask = size - 1;
+
+    for (uint32_t id = 0; id < db->series_count; id++) {
+        uint32_t slot = key_slot(db, pack_key(&db->series[id].key));
+        while (db->slots[slot] != 0) {
+            slot = (slot + 1) & db->slot_mask;
+        }
+        db->slots[slot] = id + 1;
+    }
+    return 0;
+}
+
+static int find_series(const tsdb_t *db, uint64_t packed)
+{
+    if (db->slots == NULL) {
+        return -1;
+    }
+
+    for (uint32_t slot = key_slot(db, packed); db->slots[slot] != 0; slot = (slot + 1) & db->slot_mask) {
+        uint32_t id = db->slots[slot] - 1;
+        if (pack_key(&db->series[id].key) == packed) {
+            return (int)id;
+        }
+    }
+    return -1;
+}
+
+/* Add a series to the in-memory catalog */
+static int add_series(tsdb_t *db, const tsdb_series_key_t *key, uint32_t type)
+{
+    if (db->series_count == db->series_cap) {
+        uint32_t cap = db->series_cap ? db->series_cap * 2 : 64;
+        tsdb_series_t *series = realloc(db->series, cap * sizeof(*series));
+        if (series == NULL) {
+            return -1;
+        }
+        db->series = series;
+        db->series_cap = cap;
+    }
+
+    // Keep the hash table at most half full
+    if ((db->series_count + 1) * 2 > db->slot_mask + 1 || db->slots == NULL) {
+        if (grow_slots(db, db->slots == NULL ? 128 : (db->slot_mask + 1) * 2) < 0) {
+            return -1;
+        }
+    }
+
+    uint32_t id = db->series_count++;
+    db->series[id] = (tsdb_series_t) { .key = *key, .type = type };
+
+    uint32_t slot = key_slot(db, pack_key(key));
+    while (db->slots[slot] != 0) {
+        slot = (slot + 1) & db->slot_mask;
+    }
+    db->slots[slot] = id + 1;
+
+    return (int)id;
+}
+
+static int load_catalog(tsdb_t *db)
+{
+    char path[PATH_MAX];
+    if (db_path(db, path, sizeof(path), "series") < 0) {
+        return -1;
+    }
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    char line[128];
+    long complete_len = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        size_t len = strlen(line);
+        if (len == 0 || line[len - 1] != '\n') {
+            break;  // Torn last line
+        }
+
+        unsigned id, class_num, field, type;
+        unsigned mac[6];
+        tsdb_series_key_t key;
+        if (sscanf(line, "%u %x:%x:%x:%x:%x:%x %u %u %u", &id, &mac[0], &mac[1], &mac[2],
+                   &mac[3], &mac[4], &mac[5], &class_num, &field, &type) != 10 ||
+            id != db->series_count || class_num < 1 || class_num > 256 || field > 255) {
+            fclose(f);
+            errno = EINVAL;
+            return -1;
+        }
+        for (int i = 0; i < 6; i++) {
+            key.station[i] = (uint8_t)mac[i];
+        }
+        key.class_id = (uint8_t)(class_num - 1);
+        key.field = (uint8_t)field;
+
+        if (add_series(db, &key, type) < 0) {
+            fclose(f);
+            return -1;
+        }
+        complete_len = ftell(f);
+    }
+    fclose(f);
+
+    // Drop a torn line so the next entry starts on a fresh line
+    if (db->writable && truncate(path, complete_len) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/* ---- Writing ---- */
+
+static void close_partition(tsdb_partition_t *p)
+{
+    if (p->data_fd >= 0) {
+        close(p->data_fd);
+        close(p->index_fd);
+        p->data_fd = -1;
+        p->index_fd = -1;
+    }
+}
+
+/* Cut blocks that have no index entry, and index entries past the data */
+static int recover_partition(tsdb_partition_t *p)
+{
+    struct stat data_st, index_st;
+    if (fstat(p->data_fd, &data_st) < 0 || fstat(p->index_fd, &index_st) < 0) {
+        return -1;
+    }
+
+    off_t entries = index_st.st_size / (off_t)sizeof(tsdb_index_entry_t);
+    uint64_t valid_end = 0;
+
+    while (entries > 0) {
+        tsdb_index_entry_t last;
+        if (pread(p->index_fd, &last, sizeof(last), (entries - 1) * (off_t)sizeof(last)) != sizeof(last)) {
+            return -1;
+        }
+        if (last.offset + last.length <= (uint64_t)data_st.st_size) {
+            valid_end = last.offset + last.length;
+            break;
+        }
+        entries--;
+    }
+
+    if (entries * (off_t)sizeof(tsdb_index_entry_t) != index_st.st_size &&
+        ftruncate(p->index_fd, entries * (off_t)sizeof(tsdb_index_entry_t)) < 0) {
+        return -1;
+    }
+    if ((uint64_t)data_st.st_size != valid_end && ftruncate(p->data_fd, (off_t)valid_end) < 0) {
+        return -1;
+    }
+
+    p->data_size = valid_end;
+    return 0;
+}
+
+static tsdb_partition_t *open_partition(tsdb_t *db, int64_t start)
+{
+    tsdb_partition_t *slot = NULL;
+
+    for (int i = 0; i < TSDB_OPEN_PARTITIONS; i++) {
+        tsdb_partition_t *p = &db->open[i];
+        if (p->data_fd >= 0 && p->start == start) {
+            p->last_used = ++db->use_clock;
+            return p;
+        }
+        if (slot == NULL || p->data_fd < 0 ||
+            (slot->data_fd >= 0 && p->last_used < slot->last_used)) {
+            slot = p;
+        }
+    }
+    close_partition(slot);
+
+    char data_path[PATH_MAX], index_path[PATH_MAX];
+    if (db_path(db, data_path, sizeof(data_path), "p%lld.dat", (long long)start) < 0 ||
+        db_path(db, index_path, sizeof(index_path), "p%lld.idx", (long long)start) < 0) {
+        return NULL;
+    }
+
+    slot->data_fd = open(data_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (slot->data_fd < 0) {
+        return NULL;
+    }
+    slot->index_fd = open(index_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (slot->index_fd < 0) {
+        int err = errno;
+        close(slot->data_fd);
+        slot->data_fd = -1;
+        errno = err;
+        return NULL;
+    }
+
+    if (recover_partition(slot) < 0) {
+        int err = errno;
+        close_partition(slot);
+        errno = err;
+        return NULL;
+    }
+
+    slot->start = start;
+    slot->last_used = ++db->use_clock;
+    return slot;
+}
+
+/* Compress the buffered points of a series into one block */
+static int flush_series(tsdb_t *db, uint32_t id)
+{
+    tsdb_series_t *s = &db->series[id];
+    if (s->count == 0) {
+        return 0;
+    }
+
+    tsdb_partition_t *p = open_partition(db, s->partition);
+    if (p == NULL) {
+        return -1;
+    }
+
+    tsdb_block_header_t *header = (tsdb_block_header_t *)db->scratch;
+    uint8_t *columns = db->scratch + sizeof(*header);
+    size_t times_len = gorilla_encode_times(columns, GORILLA_TIMES_MAX(s->count), s->times, s->count);
+    size_t values_len = gorilla_encode_values(columns + times_len, GORILLA_VALUES_MAX(s->count),
+                                              s->values, s->count);
+    size_t used = sizeof(*header) + times_len + values_len;
+    size_t length = (used + 7) & ~(size_t)7;
+    memset(db->scratch + used, 0, length - used);
+
+    *header = (tsdb_block_header_t) {
+        .magic = TSDB_BLOCK_MAGIC,
+        .series_id = id,
+        .count = s->count,
+        .times_len = (uint32_t)times_len,
+        .values_len = (uint32_t)values_len,
+    };
+
+    tsdb_index_entry_t entry = {
+        .series_id = id,
+        .count = s->count,
+        .offset = p->data_size,
+        .length = (uint32_t)length,
+        .t_min = s->times[0],
+        .t_max = s->times[0],
+        .v_min = s->values[0],
+        .v_max = s->values[0],
+    };
+    for (uint32_t i = 0; i < s->count; i++) {
+        int64_t t = s->times[i];
+        double v = s->values[i];
+        entry.t_min = t < entry.t_min ? t : entry.t_min;
+        entry.t_max = t > entry.t_max ? t : entry.t_max;
+        entry.v_min = v < entry.v_min ? v : entry.v_min;
+        entry.v_max = v > entry.v_max ? v : entry.v_max;
+        entry.v_sum += v;
+    }
+
+    // Data first: an index entry must never point past the data
+    if (write_all(p->data_fd, db->scratch, length) < 0 ||
+        write_all(p->index_fd, &entry, sizeof(entry)) < 0) {
+        int err = errno;
+        close_partition(p);     // Reopening recovers a consistent end
+        errno = err;
+        return -1;
+    }
+
+    p->data_size += length;
+    db->points_written += s->count;
+    db->blocks_written++;
+    db->bytes_written += length;
+    s->count = 0;
+    return 0;
+}
+
+int tsdb_open(tsdb_t *db, const char *dir, bool writable, int64_t partition_ms)
+{
+    memset(db, 0, sizeof(*db));
+    db->catalog_fd = -1;
+    for (int i = 0; i < TSDB_OPEN_PARTITIONS; i++) {
+        db->open[i].data_fd = -1;
+        db->open[i].index_fd = -1;
+    }
+
+    int n = snprintf(db->dir, sizeof(db->dir), "%s", dir);
+    if (n < 0 || (size_t)n >= sizeof(db->dir)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    db->writable = writable;
+
+    if (writable && mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        return -1;
+    }
+
+    if (read_meta(db) < 0) {
+        if (errno != ENOENT || !writable) {
+            return -1;
+        }
+        db->partition_ms = partition_ms > 0 ? partition_ms : TSDB_DEFAULT_PARTITION_MS;
+        if (write_meta(db) < 0) {
+            return -1;
+        }
+    }
+
+    if (load_catalog(db) < 0) {
+        int err = errno;
+        tsdb_close(db);
+        errno = err;
+        return -1;
+    }
+
+    if (writable) {
+        char path[PATH_MAX];
+        if (db_path(db, path, sizeof(path), "series") < 0 ||
+            (db->catalog_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)) < 0 ||
+            (db->scratch = malloc(SCRATCH_LEN)) == NULL) {
+            int err = errno;
+            tsdb_close(db);
+            errno = err;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void tsdb_close(tsdb_t *db)
+{
+    if (db->writable && db->scratch != NULL) {
+        tsdb_flush(db);
+    }
+
+    for (int i = 0; i < TSDB_OPEN_PARTITIONS; i++) {
+        close_partition(&db->open[i]);
+    }
+    if (db->catalog_fd >= 0) {
+        close(db->catalog_fd);
+        db->catalog_fd = -1;
+    }
+
+    for (uint32_t id = 0; id < db->series_count; id++) {
+        free(db->series[id].times);
+        free(db->series[id].values);
+    }
+    free(db->series);
+    free(db->slots);
+    free(db->scratch);
+    db->series = NULL;
+    db->slots = NULL;
+    db->scratch = NULL;
+    db->series_count = 0;
+    db->series_cap = 0;
+}
+
+int tsdb_series(tsdb_t *db, const tsdb_series_key_t *key, uint32_t type)
+{
+    int id = find_series(db, pack_key(key));
+    if (id >= 0 || !db->writable) {
+        return id;
+    }
+
+    id = add_series(db, key, type);
+    if (id < 0) {
+        return -1;
+    }
+
+    char line[96];
+    int len = snprintf(line, sizeof(line), "%d %02x:%02x:%02x:%02x:%02x:%02x %u %u %u\n", id,
+                       key->station[0], key->station[1], key->station[2],
+                       key->station[3], key->station[4], key->station[5],
+                       key->class_id + 1u, key->field, type);
+    if (write_all(db->catalog_fd, line, (size_t)len) < 0) {
+        db->series_count--;
+        grow_slots(db, db->slot_mask + 1);
+        return -1;
+    }
+
+    return id;
+}
+
+int tsdb_append(tsdb_t *db, uint32_t series_id, int64_t time, double value)
+{
+    tsdb_series_t *s = &db->series[series_id];
+
+    if (s->times == NULL) {
+        s->times = malloc(TSDB_BLOCK_POINTS * sizeof(*s->times));
+        s->values = malloc(TSDB_BLOCK_POINTS * sizeof(*s->values));
+        if (s->times == NULL || s->values == NULL) {
+            return -1;
+        }
+    }
+
+    int64_t partition = partition_of(db, time);
+    if (s->count > 0 && partition != s->partition && flush_series(db, series_id) < 0) {
+        return -1;
+    }
+    if (s->count == 0) {
+        s->partition = partition;
+    }
+
+    s->times[s->count] = time;
+    s->values[s->count] = value;
+    s->count++;
+
+    return s->count == TSDB_BLOCK_POINTS ? flush_series(db, series_id) : 0;
+}
+
+int tsdb_flush(tsdb_t *db)
+{
+    int ret = 0;
+    for (uint32_t id = 0; id < db->series_count; id++) {
+        if (flush_series(db, id) < 0) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+/* ---- Reading ---- */
+
+static int compare_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static const void *map_file(const char *path, size_t *len)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    const void *addr = NULL;
+    *len = 0;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            addr = NULL;
+        } else {
+            *len = (size_t)st.st_size;
+        }
+    }
+    close(fd);
+    return addr;
+}
+
+int tsdb_map(const tsdb_t *db, int64_t t_from, int64_t t_to, tsdb_partition_map_t **maps)
+{
+    DIR *d = opendir(db->dir);
+    if (d == NULL) {
+        return -1;
+    }
+
+    int64_t *starts = NULL;
+    size_t count = 0, cap = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+        long long start;
+        int consumed = 0;
+        if (sscanf(ent->d_name, "p%lld.idx%n", &start, &consumed) != 1 ||
+            ent->d_name[consumed] != '\0' || consumed == 0) {
+            continue;
+        }
+        if (start > t_to || start + db->partition_ms - 1 < t_from) {
+            continue;
+        }
+        if (count == cap) {
+            cap = cap ? cap * 2 : 16;
+            int64_t *grown = realloc(starts, cap * sizeof(*starts));
+            if (grown == NULL) {
+                free(starts);
+                closedir(d);
+                return -1;
+            }
+            starts = grown;
+        }
+        starts[count++] = start;
+    }
+    closedir(d);
+
+    qsort(starts, count, sizeof(*starts), compare_i64);
+
+    *maps = calloc(count ? count : 1, sizeof(**maps));
+    if (*maps == NULL) {
+        free(starts);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        tsdb_partition_map_t *m = &(*maps)[i];
+        char path[PATH_MAX];
+
+        m->start = starts[i];
+        // Index before data: every mapped entry then refers to data that exists
+        if (db_path(db, path, sizeof(path), "p%lld.idx", (long long)m->start) == 0) {
+            m->index = map_file(path, &m->index_len);
+        }
+        if (db_path(db, path, sizeof(path), "p%lld.dat", (long long)m->start) == 0) {
+            m->data = map_file(path, &m->data_len);
+        }
+        m->index_count = m->index_len / sizeof(tsdb_index_entry_t);
+    }
+
+    free(starts);
+    return (int)count;
+}
+
+void tsdb_unmap(tsdb_partition_map_t *maps, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (maps[i].index != NULL) {
+            munmap((void *)maps[i].index, maps[i].index_len);
+        }
+        if (maps[i].data != NULL) {
+            munmap((void *)maps[i].data, maps[i].data_len);
+        }
+    }
+    free(maps);
+}
+
+bool tsdb_block_decode(const tsdb_partition_map_t *map, const tsdb_index_entry_t *entry,
+                       int64_t *times, double *values)
+{
+    if (map->data == NULL || entry->offset > map->data_len ||
+        entry->length > map->data_len - entry->offset || entry->length < sizeof(tsdb_block_header_t)) {
+        return false;
+    }
+
+    tsdb_block_header_t header;
+    const uint8_t *block = map->data + entry->offset;
+    memcpy(&header, block, sizeof(header));
+
+    if (header.magic != TSDB_BLOCK_MAGIC || header.series_id != entry->series_id ||
+        header.count != entry->count ||
+        (uint64_t)header.times_len + header.values_len > entry->length - sizeof(header)) {
+        return false;
+    }
+
+    const uint8_t *columns = block + sizeof(header);
+    return gorilla_decode_times(columns, header.times_len, times, header.count) &&
+           gorilla_decode_values(columns + header.times_len, header.values_len, values, header.count);
+}
+
+long tsdb_scan(const tsdb_t *db, uint32_t series_id, int64_t t_from, int64_t t_to,
+               tsdb_point_cb_t cb, void *ctx)
+{
+    tsdb_partition_map_t *maps;
+    int count = tsdb_map(db, t_from, t_to, &maps);
+    if (count < 0) {
+        return -1;
+    }
+
+    int64_t *times = malloc(TSDB_BLOCK_POINTS * sizeof(*times));
+    double *values = malloc(TSDB_BLOCK_POINTS * sizeof(*values));
+    long visited = 0;
+
+    for (int p = 0; p < count && times != NULL && values != NULL; p++) {
+        const tsdb_partition_map_t *m = &maps[p];
+        for (size_t i = 0; i < m->index_count; i++) {
+            const tsdb_index_entry_t *e = &m->index[i];
+            if (e->series_id != series_id || e->t_max < t_from || e->t_min > t_to ||
+                e->count > TSDB_BLOCK_POINTS || !tsdb_block_decode(m, e, times, values)) {
+                continue;
+            }
+            for (uint32_t k = 0; k < e->count; k++) {
+                if (times[k] >= t_from && times[k] <= t_to) {
+                    cb(times[k], values[k], ctx);
+                    visited++;
+                }
+            }
+        }
+    }
+
+    if (times == NULL || values == NULL) {
+        visited = -1;
+        errno = ENOMEM;
+    }
+    free(times);
+    free(values);
+    tsdb_unmap(maps, count);
+    return visited;
+}
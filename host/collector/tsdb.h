@@ -0,0 +1,188 @@
+/**
+ * @file tsdb.h
+ * @brief Append-only chunked columnar time-series store
+ *
+ * A database is a directory:
+ *
+ *   meta            "tsdb 1" and the partition span
+ *   series          catalog, one "<id> <station> <class> <field> <type>" line per series
+ *   p<start>.dat    blocks of every series with points in [start, start + span)
+ *   p<start>.idx    sparse time index: one tsdb_index_entry_t per block
+ *
+ * Points are buffered per series and written as a block of up to
+ * TSDB_BLOCK_POINTS points: a header, the Gorilla-compressed time column
+ * and the Gorilla-compressed value column (gorilla.h). Each block is
+ * appended to its partition's data file, then its index entry (series,
+ * time range, count and min/max/sum of the values) to the index file, so
+ * readers can skip blocks by time or value without decompressing them.
+ *
+ * Files are only ever appended to. A block whose index entry is missing
+ * after a crash is cut off when the partition is next opened for writing.
+ * Readers memory-map both files and only see flushed blocks.
+ */
+
+#ifndef TSDB_H
+#define TSDB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#define TSDB_BLOCK_POINTS           1024            // Points per full block
+#define TSDB_DEFAULT_PARTITION_MS   3600000         // One hour per partition
+#define TSDB_OPEN_PARTITIONS        4               // Partitions kept open for writing
+#define TSDB_BLOCK_MAGIC            0x31425354u     // "TSB1"
+
+/* Identity of a series: one field of one class of one station */
+typedef struct {
+    uint8_t station[6];         // Station MAC address
+    uint8_t class_id;           // 0-based class
+    uint8_t field;              // Record field, 0 for primitive classes
+} tsdb_series_key_t;
+
+/* Block header in a data file, followed by the two columns padded to 8 bytes */
+typedef struct {
+    uint32_t magic;
+    uint32_t series_id;
+    uint32_t count;
+    uint32_t times_len;         // Bytes of the time column
+    uint32_t values_len;        // Bytes of the value column
+    uint32_t reserved;
+} tsdb_block_header_t;
+
+/* Sparse index entry, one per block */
+typedef struct {
+    uint32_t series_id;
+    uint32_t count;
+    uint64_t offset;            // Block header offset in the data file
+    uint32_t length;            // Block bytes, header and padding included
+    uint32_t reserved;
+    int64_t t_min;
+    int64_t t_max;
+    double v_min;
+    double v_max;
+    double v_sum;
+} tsdb_index_entry_t;
+
+/* Catalog entry and write buffer of a series */
+typedef struct {
+    tsdb_series_key_t key;
+    uint32_t type;              // Source data type code, for display only
+    uint32_t count;             // Buffered points
+    int64_t partition;          // Partition start of the buffered points
+    int64_t *times;
+    double *values;
+} tsdb_series_t;
+
+/* A partition open for appending */
+typedef struct {
+    int64_t start;
+    int data_fd;                // -1 if the slot is unused
+    int index_fd;
+    uint64_t data_size;
+    uint64_t last_used;
+} tsdb_partition_t;
+
+/* Read-only mapping of one partition */
+typedef struct {
+    int64_t start;
+    const uint8_t *data;
+    size_t data_len;
+    const tsdb_index_entry_t *index;
+    size_t index_count;
+    size_t index_len;           // Mapped index bytes
+} tsdb_partition_map_t;
+
+typedef struct {
+    char dir[PATH_MAX];
+    bool writable;
+    int64_t partition_ms;
+
+    tsdb_series_t *series;
+    uint32_t series_count;
+    uint32_t series_cap;
+    uint32_t *slots;            // Hash table of series ids + 1, 0 = empty
+    uint32_t slot_mask;
+    int catalog_fd;
+
+    tsdb_partition_t open[TSDB_OPEN_PARTITIONS];
+    uint64_t use_clock;
+    uint8_t *scratch;           // Block encode buffer
+
+    // Statistics
+    uint64_t points_written;
+    uint64_t blocks_written;
+    uint64_t bytes_written;     // Data bytes, index excluded
+} tsdb_t;
+
+/* Called by tsdb_scan() for every point in range */
+typedef void (*tsdb_point_cb_t)(int64_t time, double value, void *ctx);
+
+/**
+ * @brief Open a database directory
+ *
+ * @param writable Open for appending, creating the directory if needed
+ * @param partition_ms Partition span for a new database, 0 for the default;
+ *                     an existing database keeps its own span
+ * @return 0 on success, -1 with errno set on failure
+ */
+int tsdb_open(tsdb_t *db, const char *dir, bool writable, int64_t partition_ms);
+
+/**
+ * @brief Flush every buffered point and close all files
+ */
+void tsdb_close(tsdb_t *db);
+
+/**
+ * @brief Look up a series, creating it if the database is writable
+ *
+ * @param type Data type code recorded in the catalog for a new series
+ * @return Series id, or -1 if it does not exist and cannot be created
+ */
+int tsdb_series(tsdb_t *db, const tsdb_series_key_t *key, uint32_t type);
+
+/**
+ * @brief Buffer one point; writes a block once the series has TSDB_BLOCK_POINTS
+ *
+ * Points of one series should arrive in time order; out-of-order points are
+ * stored as given and the block's t_min/t_max still bound them.
+ *
+ * @return 0 on success, -1 with errno set if a block could not be written
+ */
+int tsdb_append(tsdb_t *db, uint32_t series_id, int64_t time, double value);
+
+/**
+ * @brief Write the buffered points of every series as (possibly short) blocks
+ *
+ * @return 0 on success, -1 with errno set on failure
+ */
+int tsdb_flush(tsdb_t *db);
+
+/**
+ * @brief Map the partitions overlapping [t_from, t_to], oldest first
+ *
+ * @param maps Receives a malloc'd array; release with tsdb_unmap()
+ * @return Number of partitions mapped, or -1 with errno set on failure
+ */
+int tsdb_map(const tsdb_t *db, int64_t t_from, int64_t t_to, tsdb_partition_map_t **maps);
+
+void tsdb_unmap(tsdb_partition_map_t *maps, int count);
+
+/**
+ * @brief Decompress one block into arrays of at least entry->count points
+ *
+ * @return false if the block is corrupt
+ */
+bool tsdb_block_decode(const tsdb_partition_map_t *map, const tsdb_index_entry_t *entry,
+                       int64_t *times, double *values);
+
+/**
+ * @brief Call @p cb for every flushed point of a series in [t_from, t_to]
+ *
+ * @return Points visited, or -1 with errno set on failure
+ */
+long tsdb_scan(const tsdb_t *db, uint32_t series_id, int64_t t_from, int64_t t_to,
+               tsdb_point_cb_t cb, void *ctx);
+
+#endif /* TSDB_H */
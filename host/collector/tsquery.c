@@ -0,0 +1,276 @@
+/**
+ * @file tsquery.c
+ * @brief Command-line range and aggregate queries over a collector database
+ *
+ * Selects the series matching a station, class and field (any of them may
+ * be left out to take all), runs one query over their union and prints
+ * one CSV row per non-empty time bucket.
+ *
+ * Build from the repository root (add -march=native for the AVX kernels):
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/collector -Icomponents/sched_core/include \
+ *       host/collector/{tsquery,query,query_kernels,tsdb,gorilla}.c \
+ *       components/sched_core/sched_types.c -lpthread -lm -o /tmp/tsquery
+ *
+ * Usage:
+ *   tsquery -d dbdir -l
+ *   tsquery -d dbdir [-s station] [-c class] [-f field] [-F from_ms] [-T to_ms] [-L last]
+ *           [-b bucket] [-Q quantile] [-m min] [-M max] [-j threads] [-D] [-v]
+ *
+ * Durations (-L, -b) take ms, s, m, h or d suffixes; a bare number is ms.
+ * -L selects the given span ending at -T, or at the newest stored point of
+ * the selected series. -Q takes 0.99 or p99. -m/-M keep only values in
+ * [min, max]. -D decodes every block instead of answering from the index,
+ * and -v prints block and row statistics to stderr.
+ *
+ * Example: p99 of class 2 for one station over the last day, per minute
+ *   tsquery -d /tmp/db -s 02:00:00:00:00:02 -c 2 -L 1d -b 1m -Q p99
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "query.h"
+#include "sched_types.h"
+#include "tsdb.h"
+
+/* Series selection; a negative value matches anything */
+typedef struct {
+    bool any_station;
+    uint8_t station[6];
+    int class_id;
+    int field;
+} selection_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* "90s", "1m", "2h", "1d", "250ms" or bare milliseconds */
+static bool parse_duration(const char *s, int64_t *ms)
+{
+    static const struct { const char *suffix; int64_t scale; } units[] = {
+        {"", 1}, {"ms", 1}, {"s", 1000}, {"m", 60000}, {"h", 3600000}, {"d", 86400000},
+    };
+    char *end;
+    double value = strtod(s, &end);
+
+    if (end == s || value < 0) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(units) / sizeof(units[0]); i++) {
+        if (strcmp(end, units[i].suffix) == 0) {
+            *ms = (int64_t)llround(value * units[i].scale);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_quantile(const char *s, double *q)
+{
+    char *end;
+    bool percent = s[0] == 'p' || s[0] == 'P';
+    double value = strtod(percent ? s + 1 : s, &end);
+
+    if (*end != '\0' || end == s) {
+        return false;
+    }
+    *q = percent ? value / 100.0 : value;
+    return *q >= 0.0 && *q <= 1.0;
+}
+
+static bool parse_station(const char *s, uint8_t *mac)
+{
+    unsigned b[6];
+    char extra;
+    if (sscanf(s, "%x:%x:%x:%x:%x:%x%c", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &extra) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        if (b[i] > 0xFF) {
+            return false;
+        }
+        mac[i] = (uint8_t)b[i];
+    }
+    return true;
+}
+
+static void list_series(const tsdb_t *db)
+{
+    printf("id,station,class,field,type\n");
+    for (uint32_t id = 0; id < db->series_count; id++) {
+        const tsdb_series_t *s = &db->series[id];
+        const uint8_t *m = s->key.station;
+        printf("%u,%02x:%02x:%02x:%02x:%02x:%02x,%u,%u,%s\n", id, m[0], m[1], m[2], m[3], m[4], m[5],
+               s->key.class_id + 1, s->key.field, data_type_name((data_type_t)s->type));
+    }
+}
+
+/* Ids of the series matching sel; returns the count, ids is malloc'd */
+static size_t select_series(const tsdb_t *db, const selection_t *sel, uint32_t **ids)
+{
+    size_t count = 0;
+
+    *ids = malloc((db->series_count ? db->series_count : 1) * sizeof(**ids));
+    if (*ids == NULL) {
+        return 0;
+    }
+    for (uint32_t id = 0; id < db->series_count; id++) {
+        const tsdb_series_key_t *key = &db->series[id].key;
+        if ((sel->any_station || memcmp(key->station, sel->station, sizeof(key->station)) == 0) &&
+            (sel->class_id < 0 || key->class_id == sel->class_id) &&
+            (sel->field < 0 || key->field == sel->field)) {
+            (*ids)[count++] = id;
+        }
+    }
+    return count;
+}
+
+static void print_result(const query_result_t *result, double quantile)
+{
+    if (quantile >= 0) {
+        printf("start_ms,count,min,max,sum,mean,p%g\n", quantile * 100.0);
+    } else {
+        printf("start_ms,count,min,max,sum,mean\n");
+    }
+
+    for (size_t b = 0; b < result->bucket_count; b++) {
+        const query_bucket_t *bucket = &result->buckets[b];
+        const query_agg_t *agg = &bucket->agg;
+        if (agg->count == 0) {
+            continue;
+        }
+        printf("%lld,%llu,%.17g,%.17g,%.17g,%.17g", (long long)bucket->start,
+               (unsigned long long)agg->count, agg->min, agg->max, agg->sum, agg->sum / agg->count);
+        if (quantile >= 0) {
+            printf(",%.17g", bucket->quantile);
+        }
+        printf("\n");
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s -d dbdir -l\n"
+            "       %s -d dbdir [-s station] [-c class] [-f field] [-F from_ms] [-T to_ms] [-L last]\n"
+            "          [-b bucket] [-Q quantile] [-m min] [-M max] [-j threads] [-D] [-v]\n",
+            prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = NULL;
+    selection_t sel = { .any_station = true, .class_id = -1, .field = -1 };
+    int64_t last_ms = 0;
+    bool have_to = false, list = false, verbose = false;
+    query_t q;
+    query_init(&q);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:ls:c:f:F:T:L:b:Q:m:M:j:Dvh")) != -1) {
+        bool ok = true;
+        switch (opt) {
+            case 'd': dir = optarg; break;
+            case 'l': list = true; break;
+            case 's':
+                sel.any_station = false;
+                ok = parse_station(optarg, sel.station);
+                break;
+            case 'c':
+                sel.class_id = atoi(optarg) - 1;
+                ok = sel.class_id >= 0 && sel.class_id < 256;
+                break;
+            case 'f': sel.field = atoi(optarg); break;
+            case 'F': q.t_from = strtoll(optarg, NULL, 10); break;
+            case 'T':
+                q.t_to = strtoll(optarg, NULL, 10);
+                have_to = true;
+                break;
+            case 'L': ok = parse_duration(optarg, &last_ms) && last_ms > 0; break;
+            case 'b': ok = parse_duration(optarg, &q.bucket_ms); break;
+            case 'Q': ok = parse_quantile(optarg, &q.quantile); break;
+            case 'm': q.v_lo = strtod(optarg, NULL); break;
+            case 'M': q.v_hi = strtod(optarg, NULL); break;
+            case 'j': q.threads = atoi(optarg); break;
+            case 'D': q.force_decode = true; break;
+            case 'v': verbose = true; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+        if (!ok) {
+            fprintf(stderr, "tsquery: bad value '%s' for -%c\n", optarg, opt);
+            return 2;
+        }
+    }
+    if (dir == NULL) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    static tsdb_t db;
+    if (tsdb_open(&db, dir, false, 0) < 0) {
+        fprintf(stderr, "tsquery: cannot open database '%s': %s\n", dir, strerror(errno));
+        return 1;
+    }
+    if (list) {
+        list_series(&db);
+        tsdb_close(&db);
+        return 0;
+    }
+
+    uint32_t *ids;
+    size_t id_count = select_series(&db, &sel, &ids);
+    if (id_count == 0) {
+        fprintf(stderr, "tsquery: no series match\n");
+        free(ids);
+        tsdb_close(&db);
+        return 1;
+    }
+
+    if (last_ms > 0) {
+        int64_t t_min, t_max;
+        if (!have_to && query_extent(&db, ids, id_count, &t_min, &t_max) > 0) {
+            q.t_to = t_max;
+        }
+        if (q.t_to != INT64_MAX) {
+            q.t_from = q.t_to - last_ms + 1;
+        }
+    }
+
+    query_result_t result;
+    double started = now_s();
+    if (query_run(&db, ids, id_count, &q, &result) < 0) {
+        fprintf(stderr, "tsquery: query failed: %s\n", strerror(errno));
+        free(ids);
+        tsdb_close(&db);
+        return 1;
+    }
+    double elapsed = now_s() - started;
+
+    print_result(&result, q.quantile);
+    if (verbose) {
+        fprintf(stderr, "series=%zu buckets=%zu threads=%d kernel=%s\n",
+                id_count, result.bucket_count, result.threads, query_kernel_name);
+        fprintf(stderr, "blocks=%llu skipped=%llu indexed=%llu decoded=%llu corrupt=%llu\n",
+                (unsigned long long)result.blocks, (unsigned long long)result.blocks_skipped,
+                (unsigned long long)result.blocks_indexed, (unsigned long long)result.blocks_decoded,
+                (unsigned long long)result.blocks_corrupt);
+        fprintf(stderr, "rows=%llu rows_decoded=%llu elapsed_s=%.6f rows_per_s=%.0f\n",
+                (unsigned long long)result.rows, (unsigned long long)result.rows_decoded,
+                elapsed, elapsed > 0 ? result.rows / elapsed : 0.0);
+    }
+
+    query_result_free(&result);
+    free(ids);
+    tsdb_close(&db);
+    return 0;
+}
@@ -0,0 +1,61 @@
+#!/bin/sh
+# Build the station and AP apps (app_main and all their tasks) on the FreeRTOS
+# POSIX/Linux port, with esp_wifi, NVS, UART and console stubbed out. Frames
+# travel over the virtual air (host/air), terminal commands come from stdin.
+#
+# Usage (from anywhere):
+#   FREERTOS_KERNEL_PATH=/path/to/FreeRTOS-Kernel host/posix/build.sh
+#
+# Environment:
+#   FREERTOS_KERNEL_PATH  FreeRTOS-Kernel checkout (V10.5 or later), required
+#   POSIX_BUILD_DIR       Output directory (default /tmp/posix)
+#   SANITIZE              address, undefined or thread: build with that sanitizer
+#   PROFILE=1             Keep frame pointers and symbols for perf
+#   CC, CFLAGS            Compiler and extra flags
+#
+# Run (each in its own terminal, or in the background):
+#   /tmp/posix/air_medium -n lab -b 1000 -l 2
+#   /tmp/posix/ap -m lab -T 30
+#   printf 'set 1 100 100\nstart\n' | /tmp/posix/station -m lab -T 25
+#
+# Profiling a run with perf (PROFILE=1 build):
+#   perf record -g --call-graph fp -- /tmp/posix/station -m lab -T 20 < commands.txt
+#   perf report --children --sort sym
+# Each FreeRTOS task runs on its own pthread, so with call graphs the task
+# entry functions (scheduler_task, packet_creator_task, receiver_task, ...)
+# show the time spent under each task.
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+BUILD=${POSIX_BUILD_DIR:-/tmp/posix}
+CC=${CC:-gcc}
+K=${FREERTOS_KERNEL_PATH:?set FREERTOS_KERNEL_PATH to a FreeRTOS-Kernel checkout}
+PORT="$K/portable/ThirdParty/GCC/Posix"
+
+# The firmware prints uint32_t with %lu, which is 32 bits on the target
+FLAGS="-std=gnu11 -D_GNU_SOURCE -Wall -Wno-format -O2 -g"
+case "${SANITIZE:-}" in
+    "") ;;
+    address|undefined|thread) FLAGS="$FLAGS -O1 -fno-omit-frame-pointer -fsanitize=$SANITIZE" ;;
+    *) echo "SANITIZE must be address, undefined or thread" >&2; exit 2 ;;
+esac
+[ -n "${PROFILE:-}" ] && FLAGS="$FLAGS -fno-omit-frame-pointer"
+FLAGS="$FLAGS ${CFLAGS:-}"
+
+INC="-I$ROOT/host/posix/include -I$ROOT/host/air -I$ROOT/components/sched_core/include"
+INC="$INC -I$K/include -I$PORT -I$PORT/utils"
+KERNEL="$K/tasks.c $K/queue.c $K/list.c $K/timers.c $K/event_groups.c"
+KERNEL="$KERNEL $PORT/port.c $PORT/utils/wait_for_event.c $K/portable/MemMang/heap_3.c"
+STUBS="$ROOT/host/posix/src/*.c $ROOT/host/air/air.c"
+CORE="$ROOT/components/sched_core/*.c"
+
+mkdir -p "$BUILD"
+$CC $FLAGS $INC -I"$ROOT/c3_wifi_station/main" "$ROOT"/c3_wifi_station/main/*.c \
+    $STUBS $CORE $KERNEL -lpthread -lm -o "$BUILD/station"
+$CC $FLAGS $INC "$ROOT/c3_wifi_ap/main/softap_example_main.c" \
+    $STUBS $CORE $KERNEL -lpthread -lm -o "$BUILD/ap"
+$CC -O2 -std=c11 -D_GNU_SOURCE -Wall -I"$ROOT/host/air" \
+    "$ROOT/host/air/air_medium.c" "$ROOT/host/air/air.c" -lpthread -o "$BUILD/air_medium"
+
+echo "Built $BUILD/station, $BUILD/ap and $BUILD/air_medium"
@@ -0,0 +1,73 @@
+/**
+ * @file FreeRTOSConfig.h
+ * @brief Kernel configuration for the FreeRTOS POSIX (Linux) port
+ *
+ * Follows the ESP-IDF defaults the apps are written against: 1 kHz tick,
+ * preemption, mutexes, event groups and timers. Each task is a pthread
+ * and only one runs at a time, so task interleavings match a single-core
+ * target. Stack sizes passed to xTaskCreate() are counted in words here
+ * (bytes on ESP-IDF), which only makes them larger.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configUSE_IDLE_HOOK                     0
+#define configUSE_TICK_HOOK                     0
+#define configUSE_DAEMON_TASK_STARTUP_HOOK      0
+#define configTICK_RATE_HZ                      1000
+#define configMAX_PRIORITIES                    25
+#define configMINIMAL_STACK_SIZE                4096
+#define configSTACK_DEPTH_TYPE                  uint32_t
+#define configTOTAL_HEAP_SIZE                   (64 * 1024 * 1024)   // Unused with heap_3
+#define configMAX_TASK_NAME_LEN                 16
+#define configUSE_TRACE_FACILITY                1
+#define configUSE_STATS_FORMATTING_FUNCTIONS    1
+#ifdef TICK_TYPE_WIDTH_32_BITS
+#define configTICK_TYPE_WIDTH_IN_BITS           TICK_TYPE_WIDTH_32_BITS
+#else
+#define configUSE_16_BIT_TICKS                  0
+#endif
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             1
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configUSE_QUEUE_SETS                    0
+#define configQUEUE_REGISTRY_SIZE               0
+#define configUSE_TIME_SLICING                  1
+#define configUSE_NEWLIB_REENTRANT              0
+#define configSUPPORT_STATIC_ALLOCATION         0
+#define configSUPPORT_DYNAMIC_ALLOCATION        1
+#define configCHECK_FOR_STACK_OVERFLOW          0    // Not supported by the POSIX port
+#define configUSE_MALLOC_FAILED_HOOK            0
+#define configGENERATE_RUN_TIME_STATS           0
+#define configUSE_CO_ROUTINES                   0
+
+#define configUSE_TIMERS                        1
+#define configTIMER_TASK_PRIORITY               (configMAX_PRIORITIES - 1)
+#define configTIMER_QUEUE_LENGTH                10
+#define configTIMER_TASK_STACK_DEPTH            configMINIMAL_STACK_SIZE
+
+#define INCLUDE_vTaskPrioritySet                1
+#define INCLUDE_uxTaskPriorityGet               1
+#define INCLUDE_vTaskDelete                     1
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_xTaskDelayUntil                 1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+#define INCLUDE_xTaskGetIdleTaskHandle          1
+#define INCLUDE_eTaskGetState                   1
+#define INCLUDE_xTimerPendFunctionCall          1
+#define INCLUDE_xTaskAbortDelay                 1
+
+/* Report the failing location and abort, so sanitizers and gdb stop there */
+void vAssertCalled(const char *file, unsigned long line);
+#define configASSERT(x) if ((x) == 0) vAssertCalled(__FILE__, __LINE__)
+
+#endif /* FREERTOS_CONFIG_H */
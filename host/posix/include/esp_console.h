@@ -0,0 +1,22 @@
+/**
+ * @file esp_console.h
+ * @brief Console initialization stub (POSIX build)
+ */
+
+#ifndef ESP_CONSOLE_H
+#define ESP_CONSOLE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef struct {
+    size_t max_cmdline_length;
+    size_t max_cmdline_args;
+    int hint_color;
+    int hint_bold;
+} esp_console_config_t;
+
+esp_err_t esp_console_init(const esp_console_config_t *config);
+
+#endif /* ESP_CONSOLE_H */
@@ -0,0 +1,43 @@
+/**
+ * @file esp_event.h
+ * @brief Default event loop (POSIX build)
+ *
+ * Handlers run synchronously in the task that posts the event (the task
+ * calling esp_wifi_start() or esp_wifi_connect()), instead of on a
+ * separate event task.
+ */
+
+#ifndef ESP_EVENT_H
+#define ESP_EVENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef const char *esp_event_base_t;
+typedef void *esp_event_handler_instance_t;
+typedef void (*esp_event_handler_t)(void *event_handler_arg, esp_event_base_t event_base,
+                                    int32_t event_id, void *event_data);
+
+#define ESP_EVENT_ANY_ID        -1
+
+#define ESP_EVENT_DECLARE_BASE(id) extern esp_event_base_t const id
+#define ESP_EVENT_DEFINE_BASE(id)  esp_event_base_t const id = #id
+
+esp_err_t esp_event_loop_create_default(void);
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base, int32_t event_id,
+                                              esp_event_handler_t event_handler,
+                                              void *event_handler_arg,
+                                              esp_event_handler_instance_t *instance);
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void *event_handler_arg);
+
+/**
+ * @brief Call every matching handler with a copy-free pointer to @p event_data
+ */
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+                         const void *event_data, size_t event_data_size, uint32_t ticks_to_wait);
+
+#endif /* ESP_EVENT_H */
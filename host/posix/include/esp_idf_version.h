@@ -0,0 +1,20 @@
+/**
+ * @file esp_idf_version.h
+ * @brief ESP-IDF version the POSIX stubs follow
+ *
+ * The apps compare against it where driver APIs changed between releases.
+ */
+
+#ifndef ESP_IDF_VERSION_H
+#define ESP_IDF_VERSION_H
+
+#define ESP_IDF_VERSION_MAJOR   5
+#define ESP_IDF_VERSION_MINOR   4
+#define ESP_IDF_VERSION_PATCH   0
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) (((major) << 16) | ((minor) << 8) | (patch))
+
+#define ESP_IDF_VERSION \
+    ESP_IDF_VERSION_VAL(ESP_IDF_VERSION_MAJOR, ESP_IDF_VERSION_MINOR, ESP_IDF_VERSION_PATCH)
+
+#endif /* ESP_IDF_VERSION_H */
@@ -0,0 +1,50 @@
+/**
+ * @file esp_log.h
+ * @brief ESP-IDF logging macros on stdout (POSIX build)
+ *
+ * Lines look like the firmware's: "I (1234) tag: message", with the
+ * FreeRTOS tick count in milliseconds.
+ */
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+typedef enum {
+    ESP_LOG_NONE = 0,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+/**
+ * @brief Set the run-time level for a tag, or for all tags with "*"
+ */
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+/**
+ * @brief Milliseconds since the scheduler started
+ */
+uint32_t esp_log_timestamp(void);
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOG_LEVEL(level, letter, tag, format, ...) do {                      \
+        if ((level) <= CONFIG_LOG_MAXIMUM_LEVEL) {                               \
+            esp_log_write(level, tag, #letter " (%u) %s: " format "\n",          \
+                          (unsigned)esp_log_timestamp(), tag, ##__VA_ARGS__);    \
+        }                                                                        \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_ERROR, E, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_WARN, W, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_INFO, I, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_DEBUG, D, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_VERBOSE, V, tag, format, ##__VA_ARGS__)
+
+#endif /* ESP_LOG_H */
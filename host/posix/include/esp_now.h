@@ -0,0 +1,66 @@
+/**
+ * @file esp_now.h
+ * @brief ESP-NOW over the virtual air (POSIX build)
+ *
+ * Frames go out as ESP-NOW action frames (air.h) through the same medium
+ * connection as esp_wifi_80211_tx(). The wifi task hands received frames
+ * addressed to us or broadcast to the receive callback and reports sent
+ * frames to the send callback, both in driver context as on the target.
+ * Encryption is not modelled: the PMK and peer LMKs are accepted and
+ * ignored. The send callback has the signature of ESP-IDF before v5.5.
+ */
+
+#ifndef ESP_NOW_H
+#define ESP_NOW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+
+#define ESP_NOW_ETH_ALEN            6
+#define ESP_NOW_KEY_LEN             16
+#define ESP_NOW_MAX_TOTAL_PEER_NUM  20
+#define ESP_NOW_MAX_DATA_LEN        250     // ESP-NOW v1
+#define ESP_NOW_MAX_DATA_LEN_V2     1470
+
+typedef enum {
+    ESP_NOW_SEND_SUCCESS = 0,
+    ESP_NOW_SEND_FAIL,
+} esp_now_send_status_t;
+
+typedef struct esp_now_peer_info {
+    uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+    uint8_t lmk[ESP_NOW_KEY_LEN];
+    uint8_t channel;             // 0: the current channel
+    wifi_interface_t ifidx;
+    bool encrypt;
+    void *priv;
+} esp_now_peer_info_t;
+
+typedef struct esp_now_recv_info {
+    uint8_t *src_addr;
+    uint8_t *des_addr;
+    wifi_pkt_rx_ctrl_t *rx_ctrl;
+} esp_now_recv_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const esp_now_recv_info_t *esp_now_info, const uint8_t *data, int data_len);
+typedef void (*esp_now_send_cb_t)(const uint8_t *mac_addr, esp_now_send_status_t status);
+
+esp_err_t esp_now_init(void);
+esp_err_t esp_now_deinit(void);
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb);
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb);
+esp_err_t esp_now_set_pmk(const uint8_t *pmk);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer);
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr);
+bool esp_now_is_peer_exist(const uint8_t *peer_addr);
+
+/**
+ * @brief Send @p data to a registered peer, or to every peer when @p peer_addr is NULL
+ *
+ * The data is copied; the send callback reports each frame.
+ */
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len);
+
+#endif /* ESP_NOW_H */
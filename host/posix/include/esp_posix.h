@@ -0,0 +1,33 @@
+/**
+ * @file esp_posix.h
+ * @brief Process options shared by the POSIX stubs
+ *
+ * Filled from the command line in posix_main.c before the scheduler
+ * starts; the Wi-Fi, log and random stubs read them from there.
+ */
+
+#ifndef ESP_POSIX_H
+#define ESP_POSIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_log.h"
+
+typedef struct {
+    const char *medium;          // air_medium name
+    uint8_t mac[6];              // Our MAC when mac_set, else the AIR_*_MAC for the mode
+    bool mac_set;
+    int8_t rssi;                 // Reported for the associated AP
+    esp_log_level_t log_level;
+    uint32_t seed;               // esp_random() seed, 0 = time based
+    uint32_t duration_s;         // Stop after this long, 0 = until SIGINT
+} esp_posix_options_t;
+
+extern esp_posix_options_t esp_posix_options;
+
+/**
+ * @brief Close the virtual air and print its frame counters (called on exit)
+ */
+void esp_wifi_posix_shutdown(void);
+
+#endif /* ESP_POSIX_H */
@@ -0,0 +1,19 @@
+/**
+ * @file esp_random.h
+ * @brief Random numbers (POSIX build)
+ */
+
+#ifndef ESP_RANDOM_H
+#define ESP_RANDOM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 32 random bits; seeded from -s so runs can be repeated
+ */
+uint32_t esp_random(void);
+
+void esp_fill_random(void *buf, size_t len);
+
+#endif /* ESP_RANDOM_H */
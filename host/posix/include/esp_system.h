@@ -0,0 +1,23 @@
+/**
+ * @file esp_system.h
+ * @brief System functions used by the apps (POSIX build)
+ */
+
+#ifndef ESP_SYSTEM_H
+#define ESP_SYSTEM_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+/**
+ * @brief Exit the process; there is nothing to reboot into
+ */
+void esp_restart(void) __attribute__((noreturn));
+
+/**
+ * @brief Reported free heap; the host heap is not tracked, so a fixed large value
+ */
+uint32_t esp_get_free_heap_size(void);
+
+#endif /* ESP_SYSTEM_H */
@@ -0,0 +1,16 @@
+/**
+ * @file esp_timer.h
+ * @brief High-resolution time (POSIX build)
+ */
+
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Microseconds from CLOCK_MONOTONIC
+ */
+int64_t esp_timer_get_time(void);
+
+#endif /* ESP_TIMER_H */
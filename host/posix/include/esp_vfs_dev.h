@@ -0,0 +1,21 @@
+/**
+ * @file esp_vfs_dev.h
+ * @brief UART VFS stubs (POSIX build)
+ */
+
+#ifndef ESP_VFS_DEV_H
+#define ESP_VFS_DEV_H
+
+#include "esp_err.h"
+
+typedef enum {
+    ESP_LINE_ENDINGS_CRLF,
+    ESP_LINE_ENDINGS_CR,
+    ESP_LINE_ENDINGS_LF,
+} esp_line_endings_t;
+
+esp_err_t esp_vfs_dev_uart_port_set_rx_line_endings(int uart_num, esp_line_endings_t mode);
+esp_err_t esp_vfs_dev_uart_port_set_tx_line_endings(int uart_num, esp_line_endings_t mode);
+void esp_vfs_dev_uart_use_driver(int uart_num);
+
+#endif /* ESP_VFS_DEV_H */
@@ -0,0 +1,285 @@
+/**
+ * @file esp_wifi.h
+ * @brief Wi-Fi driver API used by the apps, backed by the virtual air (POSIX build)
+ *
+ * esp_wifi_80211_tx() hands frames to the air_medium process and a "wifi"
+ * FreeRTOS task delivers received frames to the promiscuous callback. The
+ * station "associates" as soon as it connects: it reports the AP at
+ * AIR_AP_MAC with the RSSI given on the command line. Power save,
+ * protocol, rate and TX power settings are stored and read back but do not
+ * change what goes on the air.
+ */
+
+#ifndef ESP_WIFI_H
+#define ESP_WIFI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+
+typedef enum {
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP,
+    WIFI_IF_NUM,
+} wifi_interface_t;
+
+typedef enum {
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA,
+} wifi_mode_t;
+
+typedef enum {
+    WIFI_PS_NONE,
+    WIFI_PS_MIN_MODEM,
+    WIFI_PS_MAX_MODEM,
+} wifi_ps_type_t;
+
+#define WIFI_PROTOCOL_11B       0x1
+#define WIFI_PROTOCOL_11G       0x2
+#define WIFI_PROTOCOL_11N       0x4
+
+/* Same values as the driver, for esp_wifi_config_80211_tx_rate() */
+typedef enum {
+    WIFI_PHY_RATE_1M_L      = 0x00,
+    WIFI_PHY_RATE_2M_L      = 0x01,
+    WIFI_PHY_RATE_5M_L      = 0x02,
+    WIFI_PHY_RATE_11M_L     = 0x03,
+    WIFI_PHY_RATE_2M_S      = 0x05,
+    WIFI_PHY_RATE_5M_S      = 0x06,
+    WIFI_PHY_RATE_11M_S     = 0x07,
+    WIFI_PHY_RATE_48M       = 0x08,
+    WIFI_PHY_RATE_24M       = 0x09,
+    WIFI_PHY_RATE_12M       = 0x0A,
+    WIFI_PHY_RATE_6M        = 0x0B,
+    WIFI_PHY_RATE_54M       = 0x0C,
+    WIFI_PHY_RATE_36M       = 0x0D,
+    WIFI_PHY_RATE_18M       = 0x0E,
+    WIFI_PHY_RATE_9M        = 0x0F,
+    WIFI_PHY_RATE_MCS0_LGI  = 0x10,
+    WIFI_PHY_RATE_MCS1_LGI  = 0x11,
+    WIFI_PHY_RATE_MCS2_LGI  = 0x12,
+    WIFI_PHY_RATE_MCS3_LGI  = 0x13,
+    WIFI_PHY_RATE_MCS4_LGI  = 0x14,
+    WIFI_PHY_RATE_MCS5_LGI  = 0x15,
+    WIFI_PHY_RATE_MCS6_LGI  = 0x16,
+    WIFI_PHY_RATE_MCS7_LGI  = 0x17,
+    WIFI_PHY_RATE_MCS0_SGI  = 0x18,
+    WIFI_PHY_RATE_MCS1_SGI  = 0x19,
+    WIFI_PHY_RATE_MCS2_SGI  = 0x1A,
+    WIFI_PHY_RATE_MCS3_SGI  = 0x1B,
+    WIFI_PHY_RATE_MCS4_SGI  = 0x1C,
+    WIFI_PHY_RATE_MCS5_SGI  = 0x1D,
+    WIFI_PHY_RATE_MCS6_SGI  = 0x1E,
+    WIFI_PHY_RATE_MCS7_SGI  = 0x1F,
+    WIFI_PHY_RATE_MAX,
+} wifi_phy_rate_t;
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_WPA2_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK,
+    WIFI_AUTH_WPA2_WPA3_PSK,
+} wifi_auth_mode_t;
+
+typedef enum {
+    WPA3_SAE_PWE_UNSPECIFIED,
+    WPA3_SAE_PWE_HUNT_AND_PECK,
+    WPA3_SAE_PWE_HASH_TO_ELEMENT,
+    WPA3_SAE_PWE_BOTH,
+} wifi_sae_pwe_method_t;
+
+typedef struct {
+    bool capable;
+    bool required;
+} wifi_pmf_config_t;
+
+typedef struct {
+    int8_t rssi;
+    wifi_auth_mode_t authmode;
+} wifi_scan_threshold_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    bool bssid_set;
+    uint8_t bssid[6];
+    uint8_t channel;
+    wifi_scan_threshold_t threshold;
+    wifi_pmf_config_t pmf_cfg;
+} wifi_sta_config_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    uint8_t ssid_len;
+    uint8_t channel;
+    wifi_auth_mode_t authmode;
+    uint8_t ssid_hidden;
+    uint8_t max_connection;
+    uint16_t beacon_interval;
+    wifi_pmf_config_t pmf_cfg;
+    wifi_sae_pwe_method_t sae_pwe_h2e;
+} wifi_ap_config_t;
+
+typedef union {
+    wifi_ap_config_t ap;
+    wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t ssid[33];
+    uint8_t primary;
+    int8_t rssi;
+    wifi_auth_mode_t authmode;
+} wifi_ap_record_t;
+
+typedef struct {
+    int magic;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() { .magic = 0x1F2F3F4F }
+
+/* Promiscuous mode */
+typedef enum {
+    WIFI_PKT_MGMT,
+    WIFI_PKT_CTRL,
+    WIFI_PKT_DATA,
+    WIFI_PKT_MISC,
+} wifi_promiscuous_pkt_type_t;
+
+typedef struct {
+    signed rssi:8;
+    unsigned rate:5;
+    unsigned :1;
+    unsigned sig_mode:2;
+    unsigned channel:4;
+    unsigned sig_len:12;         // Frame length including the 4-byte FCS
+    uint32_t timestamp;          // Microseconds, low 32 bits of the delivery time
+} wifi_pkt_rx_ctrl_t;
+
+typedef struct {
+    wifi_pkt_rx_ctrl_t rx_ctrl;
+    uint8_t payload[0];
+} wifi_promiscuous_pkt_t;
+
+typedef void (*wifi_promiscuous_cb_t)(void *buf, wifi_promiscuous_pkt_type_t type);
+
+#define WIFI_PROMIS_FILTER_MASK_ALL         0xFFFFFFFF
+#define WIFI_PROMIS_FILTER_MASK_MGMT        (1 << 0)
+#define WIFI_PROMIS_FILTER_MASK_CTRL        (1 << 1)
+#define WIFI_PROMIS_FILTER_MASK_DATA        (1 << 2)
+#define WIFI_PROMIS_FILTER_MASK_MISC        (1 << 3)
+#define WIFI_PROMIS_FILTER_MASK_DATA_MPDU   (1 << 4)    // Data frames sent on their own
+#define WIFI_PROMIS_FILTER_MASK_DATA_AMPDU  (1 << 5)    // Data frames from A-MPDUs
+#define WIFI_PROMIS_FILTER_MASK_FCSFAIL     (1 << 6)
+
+typedef struct {
+    uint32_t filter_mask;
+} wifi_promiscuous_filter_t;
+
+/* TX-done reporting for esp_wifi_80211_tx() */
+typedef enum {
+    WIFI_SEND_SUCCESS = 0,
+    WIFI_SEND_FAIL,
+} wifi_tx_status_t;
+
+typedef struct {
+    const uint8_t *des_addr;
+    const uint8_t *src_addr;
+    wifi_interface_t ifidx;
+    const uint8_t *data;         // NULL here: the frame body is not kept
+    uint16_t data_len;
+    wifi_phy_rate_t rate;
+    wifi_tx_status_t tx_status;
+} esp_80211_tx_info_t;
+
+typedef void (*esp_wifi_80211_tx_done_cb_t)(const esp_80211_tx_info_t *tx_info);
+
+/* Events */
+typedef enum {
+    WIFI_EVENT_WIFI_READY = 0,
+    WIFI_EVENT_SCAN_DONE,
+    WIFI_EVENT_STA_START,
+    WIFI_EVENT_STA_STOP,
+    WIFI_EVENT_STA_CONNECTED,
+    WIFI_EVENT_STA_DISCONNECTED,
+    WIFI_EVENT_STA_AUTHMODE_CHANGE,
+    WIFI_EVENT_STA_WPS_ER_SUCCESS,
+    WIFI_EVENT_STA_WPS_ER_FAILED,
+    WIFI_EVENT_STA_WPS_ER_TIMEOUT,
+    WIFI_EVENT_STA_WPS_ER_PIN,
+    WIFI_EVENT_STA_WPS_ER_PBC_OVERLAP,
+    WIFI_EVENT_AP_START,
+    WIFI_EVENT_AP_STOP,
+    WIFI_EVENT_AP_STACONNECTED,
+    WIFI_EVENT_AP_STADISCONNECTED,
+} wifi_event_t;
+
+ESP_EVENT_DECLARE_BASE(WIFI_EVENT);
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t aid;
+    bool is_mesh_child;
+} wifi_event_ap_staconnected_t;
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t aid;
+    bool is_mesh_child;
+    uint16_t reason;
+} wifi_event_ap_stadisconnected_t;
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_stop(void);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t *type);
+esp_err_t esp_wifi_set_protocol(wifi_interface_t ifx, uint8_t protocol_bitmap);
+esp_err_t esp_wifi_get_protocol(wifi_interface_t ifx, uint8_t *protocol_bitmap);
+esp_err_t esp_wifi_config_11b_rate(wifi_interface_t ifx, bool disable);
+esp_err_t esp_wifi_config_80211_tx_rate(wifi_interface_t ifx, wifi_phy_rate_t rate);
+esp_err_t esp_wifi_set_max_tx_power(int8_t power);
+esp_err_t esp_wifi_get_max_tx_power(int8_t *power);
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]);
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info);
+
+/**
+ * @brief Send a raw 802.11 frame over the virtual air
+ *
+ * @param en_sys_seq Overwrite the sequence control field with our own counter
+ * @return ESP_OK, ESP_ERR_WIFI_NOT_STARTED, ESP_ERR_INVALID_ARG, or
+ *         ESP_ERR_NO_MEM when the medium socket cannot take the frame
+ */
+esp_err_t esp_wifi_80211_tx(wifi_interface_t ifx, const void *buffer, int len, bool en_sys_seq);
+
+/**
+ * @brief Register a callback for frames sent with esp_wifi_80211_tx()
+ *
+ * Called on the wifi task once per accepted frame, in send order. The
+ * virtual air has no acknowledgements, so every frame the medium took is
+ * reported as WIFI_SEND_SUCCESS.
+ */
+esp_err_t esp_wifi_register_80211_tx_cb(esp_wifi_80211_tx_done_cb_t cb);
+
+esp_err_t esp_wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb);
+esp_err_t esp_wifi_set_promiscuous_filter(const wifi_promiscuous_filter_t *filter);
+esp_err_t esp_wifi_set_promiscuous(bool en);
+
+#endif /* ESP_WIFI_H */
@@ -0,0 +1,5 @@
+/* ESP-IDF include path for the FreeRTOS kernel's FreeRTOS.h (POSIX build) */
+#ifndef POSIX_FREERTOS_FREERTOS_H
+#define POSIX_FREERTOS_FREERTOS_H
+#include <FreeRTOS.h>
+#endif
@@ -0,0 +1,5 @@
+/* ESP-IDF include path for the FreeRTOS kernel's event_groups.h (POSIX build) */
+#ifndef POSIX_FREERTOS_EVENT_GROUPS_H
+#define POSIX_FREERTOS_EVENT_GROUPS_H
+#include <event_groups.h>
+#endif
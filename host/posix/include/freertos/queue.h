@@ -0,0 +1,5 @@
+/* ESP-IDF include path for the FreeRTOS kernel's queue.h (POSIX build) */
+#ifndef POSIX_FREERTOS_QUEUE_H
+#define POSIX_FREERTOS_QUEUE_H
+#include <queue.h>
+#endif
@@ -0,0 +1,5 @@
+/* ESP-IDF include path for the FreeRTOS kernel's semphr.h (POSIX build) */
+#ifndef POSIX_FREERTOS_SEMPHR_H
+#define POSIX_FREERTOS_SEMPHR_H
+#include <semphr.h>
+#endif
@@ -0,0 +1,5 @@
+/* ESP-IDF include path for the FreeRTOS kernel's task.h (POSIX build) */
+#ifndef POSIX_FREERTOS_TASK_H
+#define POSIX_FREERTOS_TASK_H
+#include <task.h>
+#endif
@@ -0,0 +1,5 @@
+/* ESP-IDF include path for the FreeRTOS kernel's timers.h (POSIX build) */
+#ifndef POSIX_FREERTOS_TIMERS_H
+#define POSIX_FREERTOS_TIMERS_H
+#include <timers.h>
+#endif
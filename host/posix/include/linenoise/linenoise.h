@@ -0,0 +1,23 @@
+/**
+ * @file linenoise.h
+ * @brief Line input from stdin for the terminal commands (POSIX build)
+ *
+ * linenoise() reads without blocking the FreeRTOS scheduler: it polls
+ * stdin and yields with vTaskDelay() while no full line is available.
+ * Lines read from a pipe or file are echoed after the prompt so logs of
+ * scripted runs show the commands. Once stdin is closed it ends the
+ * scheduler, since no 'start' can follow.
+ */
+
+#ifndef LINENOISE_H
+#define LINENOISE_H
+
+char *linenoise(const char *prompt);
+void linenoiseFree(void *ptr);
+int linenoiseHistoryAdd(const char *line);
+int linenoiseHistorySetMaxLen(int len);
+void linenoiseSetMultiLine(int ml);
+void linenoiseSetDumbMode(int set);
+void linenoiseClearScreen(void);
+
+#endif /* LINENOISE_H */
@@ -0,0 +1 @@
+/* lwIP is not used by the apps; kept so their includes resolve (POSIX build) */
@@ -0,0 +1,10 @@
+/*
+ * lwIP is not used by the apps (POSIX build). On the target this header
+ * brings in the FreeRTOS semaphore API through lwIP's sys_arch.h, which
+ * the AP relies on, so it does the same here.
+ */
+#ifndef POSIX_LWIP_SYS_H
+#define POSIX_LWIP_SYS_H
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#endif
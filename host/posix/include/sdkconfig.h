@@ -0,0 +1,45 @@
+/**
+ * @file sdkconfig.h
+ * @brief Kconfig values for the POSIX build (menuconfig defaults of the apps)
+ *
+ * Override any of these with -D on the compiler command line.
+ */
+
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+#ifndef CONFIG_ESP_WIFI_SSID
+#define CONFIG_ESP_WIFI_SSID         "myssid"
+#endif
+#ifndef CONFIG_ESP_WIFI_PASSWORD
+#define CONFIG_ESP_WIFI_PASSWORD     "mypassword"
+#endif
+#ifndef CONFIG_ESP_WIFI_CHANNEL
+#define CONFIG_ESP_WIFI_CHANNEL      1
+#endif
+#ifndef CONFIG_ESP_MAX_STA_CONN
+#define CONFIG_ESP_MAX_STA_CONN      4
+#endif
+#ifndef CONFIG_ESP_MAXIMUM_RETRY
+#define CONFIG_ESP_MAXIMUM_RETRY     5
+#endif
+#ifndef CONFIG_AP_EXPORT_FRAMES
+#define CONFIG_AP_EXPORT_FRAMES      1
+#endif
+#ifndef CONFIG_AP_REQUIRE_FRAME_CRC
+#define CONFIG_AP_REQUIRE_FRAME_CRC  1
+#endif
+#ifndef CONFIG_AP_SOURCE_ALLOWLIST
+#define CONFIG_AP_SOURCE_ALLOWLIST   1
+#endif
+#if !defined(CONFIG_AP_RX_PATH_ESPNOW) && !defined(CONFIG_AP_RX_PATH_PROMISCUOUS)
+#define CONFIG_AP_RX_PATH_PROMISCUOUS 1
+#endif
+#ifndef CONFIG_LOG_DEFAULT_LEVEL
+#define CONFIG_LOG_DEFAULT_LEVEL     3       // ESP_LOG_INFO
+#endif
+#ifndef CONFIG_LOG_MAXIMUM_LEVEL
+#define CONFIG_LOG_MAXIMUM_LEVEL     4       // ESP_LOG_DEBUG; enable at run time with -l d
+#endif
+
+#endif /* SDKCONFIG_H */
@@ -0,0 +1,186 @@
+/**
+ * @file console_posix.c
+ * @brief UART, VFS, console and linenoise on stdin/stdout (POSIX build)
+ *
+ * The terminal task reads its commands from stdin. stdin is switched to
+ * non-blocking mode and linenoise() yields with vTaskDelay() until a full
+ * line is buffered, so waiting for input never stalls the other tasks.
+ * Closing stdin before 'start' ends the run.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#include "esp_vfs_dev.h"
+#include "esp_console.h"
+#include "linenoise/linenoise.h"
+#include "esp_posix.h"
+
+#define LINE_MAX_LEN        256
+#define STDIN_POLL_MS       20
+
+/* Bytes read from stdin but not yet returned as a line */
+typedef struct {
+    char buf[LINE_MAX_LEN * 4];
+    size_t len;
+    bool nonblocking;
+    bool eof;
+    int saved_flags;
+} stdin_state_t;
+
+static stdin_state_t input;
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, void *uart_queue, int intr_alloc_flags)
+{
+    (void)uart_num; (void)rx_buffer_size; (void)tx_buffer_size;
+    (void)queue_size; (void)uart_queue; (void)intr_alloc_flags;
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config)
+{
+    (void)uart_num;
+    return uart_config != NULL ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_vfs_dev_uart_port_set_rx_line_endings(int uart_num, esp_line_endings_t mode)
+{
+    (void)uart_num; (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_dev_uart_port_set_tx_line_endings(int uart_num, esp_line_endings_t mode)
+{
+    (void)uart_num; (void)mode;
+    return ESP_OK;
+}
+
+void esp_vfs_dev_uart_use_driver(int uart_num)
+{
+    (void)uart_num;
+}
+
+esp_err_t esp_console_init(const esp_console_config_t *config)
+{
+    return config != NULL ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+static void restore_stdin(void)
+{
+    fcntl(STDIN_FILENO, F_SETFL, input.saved_flags);
+}
+
+static void make_stdin_nonblocking(void)
+{
+    input.saved_flags = fcntl(STDIN_FILENO, F_GETFL);
+    if (input.saved_flags >= 0 &&
+        fcntl(STDIN_FILENO, F_SETFL, input.saved_flags | O_NONBLOCK) == 0) {
+        atexit(restore_stdin);
+    }
+    input.nonblocking = true;
+}
+
+/* Take one line (without the terminator) out of the buffer, if there is one */
+static char *take_line(void)
+{
+    char *end = memchr(input.buf, '\n', input.len);
+    if (end == NULL) {
+        end = memchr(input.buf, '\r', input.len);
+    }
+    if (end == NULL && !(input.eof && input.len > 0) && input.len < sizeof(input.buf)) {
+        return NULL;
+    }
+
+    size_t line_len = end != NULL ? (size_t)(end - input.buf) : input.len;
+    size_t consumed = end != NULL ? line_len + 1 : line_len;
+
+    char *line = malloc(line_len + 1);
+    if (line == NULL) {
+        return NULL;
+    }
+    memcpy(line, input.buf, line_len);
+    line[line_len] = '\0';
+    if (line_len > 0 && line[line_len - 1] == '\r') {
+        line[line_len - 1] = '\0';
+    }
+
+    memmove(input.buf, input.buf + consumed, input.len - consumed);
+    input.len -= consumed;
+    return line;
+}
+
+char *linenoise(const char *prompt)
+{
+    if (!input.nonblocking) {
+        make_stdin_nonblocking();
+    }
+
+    printf("%s", prompt);
+    fflush(stdout);
+
+    for (;;) {
+        char *line = take_line();
+        if (line != NULL) {
+            if (!isatty(STDIN_FILENO)) {
+                printf("%s\n", line);   // Show scripted commands in the log
+            }
+            return line;
+        }
+        if (input.eof) {
+            // No more commands can arrive, so 'start' never will
+            printf("\nstdin closed, stopping\n");
+            fflush(stdout);
+            vTaskEndScheduler();
+            return NULL;
+        }
+
+        ssize_t n = read(STDIN_FILENO, input.buf + input.len, sizeof(input.buf) - input.len);
+        if (n > 0) {
+            input.len += (size_t)n;
+        } else if (n == 0) {
+            input.eof = true;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            input.eof = true;
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(STDIN_POLL_MS));
+        }
+    }
+}
+
+void linenoiseFree(void *ptr)
+{
+    free(ptr);
+}
+
+int linenoiseHistoryAdd(const char *line)
+{
+    (void)line;
+    return 1;
+}
+
+int linenoiseHistorySetMaxLen(int len)
+{
+    (void)len;
+    return 1;
+}
+
+void linenoiseSetMultiLine(int ml)
+{
+    (void)ml;
+}
+
+void linenoiseSetDumbMode(int set)
+{
+    (void)set;
+}
+
+void linenoiseClearScreen(void)
+{
+}
@@ -0,0 +1,255 @@
+/**
+ * @file esp_system_posix.c
+ * @brief Logging, errors, time, random numbers, NVS, netif and the event loop (POSIX build)
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "nvs_flash.h"
+#include "esp_posix.h"
+
+#define MAX_LOG_TAGS        16
+#define MAX_EVENT_HANDLERS  16
+
+ESP_EVENT_DEFINE_BASE(IP_EVENT);
+
+/* Run-time log level per tag, "*" is the default */
+typedef struct {
+    char tag[24];
+    esp_log_level_t level;
+} log_tag_level_t;
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void *arg;
+} event_handler_entry_t;
+
+static log_tag_level_t log_tags[MAX_LOG_TAGS];
+static int log_tag_count;
+static event_handler_entry_t event_handlers[MAX_EVENT_HANDLERS];
+static int event_handler_count;
+static uint64_t random_state;
+
+/* ---- Logging ---- */
+
+static esp_log_level_t log_level_for(const char *tag)
+{
+    for (int i = 0; i < log_tag_count; i++) {
+        if (strcmp(log_tags[i].tag, tag) == 0) {
+            return log_tags[i].level;
+        }
+    }
+    return esp_posix_options.log_level;
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    if (strcmp(tag, "*") == 0) {
+        esp_posix_options.log_level = level;
+        return;
+    }
+
+    for (int i = 0; i < log_tag_count; i++) {
+        if (strcmp(log_tags[i].tag, tag) == 0) {
+            log_tags[i].level = level;
+            return;
+        }
+    }
+
+    if (log_tag_count < MAX_LOG_TAGS) {
+        snprintf(log_tags[log_tag_count].tag, sizeof(log_tags[0].tag), "%s", tag);
+        log_tags[log_tag_count].level = level;
+        log_tag_count++;
+    }
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        return 0;
+    }
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    if (level > log_level_for(tag)) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    fflush(stdout);
+}
+
+/* ---- Errors ---- */
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_NVS_NO_FREE_PAGES: return "ESP_ERR_NVS_NO_FREE_PAGES";
+        case ESP_ERR_NVS_NEW_VERSION_FOUND: return "ESP_ERR_NVS_NEW_VERSION_FOUND";
+        case ESP_ERR_WIFI_NOT_INIT: return "ESP_ERR_WIFI_NOT_INIT";
+        case ESP_ERR_WIFI_NOT_STARTED: return "ESP_ERR_WIFI_NOT_STARTED";
+        case ESP_ERR_WIFI_IF: return "ESP_ERR_WIFI_IF";
+        case ESP_ERR_WIFI_MODE: return "ESP_ERR_WIFI_MODE";
+        case ESP_ERR_WIFI_CONN: return "ESP_ERR_WIFI_CONN";
+        case ESP_ERR_WIFI_NOT_CONNECT: return "ESP_ERR_WIFI_NOT_CONNECT";
+        case ESP_ERR_ESPNOW_NOT_INIT: return "ESP_ERR_ESPNOW_NOT_INIT";
+        case ESP_ERR_ESPNOW_ARG: return "ESP_ERR_ESPNOW_ARG";
+        case ESP_ERR_ESPNOW_NO_MEM: return "ESP_ERR_ESPNOW_NO_MEM";
+        case ESP_ERR_ESPNOW_FULL: return "ESP_ERR_ESPNOW_FULL";
+        case ESP_ERR_ESPNOW_NOT_FOUND: return "ESP_ERR_ESPNOW_NOT_FOUND";
+        case ESP_ERR_ESPNOW_EXIST: return "ESP_ERR_ESPNOW_EXIST";
+        case ESP_ERR_ESPNOW_IF: return "ESP_ERR_ESPNOW_IF";
+        default: return "UNKNOWN ERROR";
+    }
+}
+
+/* ---- System ---- */
+
+void esp_restart(void)
+{
+    printf("esp_restart() called, exiting\n");
+    fflush(stdout);
+    exit(0);
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return 256 * 1024;
+}
+
+/* Monotonic microseconds; the apps only ever take differences */
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/* xorshift64*, so a fixed -s seed repeats a run exactly */
+uint32_t esp_random(void)
+{
+    if (random_state == 0) {
+        random_state = esp_posix_options.seed != 0 ? esp_posix_options.seed
+                                                   : (uint64_t)time(NULL) ^ 0x9E3779B97F4A7C15ull;
+    }
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return (uint32_t)((random_state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+void esp_fill_random(void *buf, size_t len)
+{
+    uint8_t *out = buf;
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (uint8_t)esp_random();
+    }
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    return ESP_OK;
+}
+
+/* ---- Netif ---- */
+
+esp_err_t esp_netif_init(void)
+{
+    return ESP_OK;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_sta(void)
+{
+    return NULL;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_ap(void)
+{
+    return NULL;
+}
+
+/* ---- Event loop ---- */
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    if (event_handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (event_handler_count >= MAX_EVENT_HANDLERS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    event_handlers[event_handler_count++] = (event_handler_entry_t) {
+        .base = event_base,
+        .id = event_id,
+        .handler = event_handler,
+        .arg = event_handler_arg,
+    };
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base, int32_t event_id,
+                                              esp_event_handler_t event_handler,
+                                              void *event_handler_arg,
+                                              esp_event_handler_instance_t *instance)
+{
+    esp_err_t ret = esp_event_handler_register(event_base, event_id, event_handler, event_handler_arg);
+    if (ret == ESP_OK && instance != NULL) {
+        *instance = &event_handlers[event_handler_count - 1];
+    }
+    return ret;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+                         const void *event_data, size_t event_data_size, uint32_t ticks_to_wait)
+{
+    (void)event_data_size;
+    (void)ticks_to_wait;
+
+    for (int i = 0; i < event_handler_count; i++) {
+        const event_handler_entry_t *entry = &event_handlers[i];
+        if (entry->base == event_base && (entry->id == ESP_EVENT_ANY_ID || entry->id == event_id)) {
+            entry->handler(entry->arg, event_base, event_id, (void *)event_data);
+        }
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,677 @@
+/**
+ * @file esp_wifi_posix.c
+ * @brief esp_wifi on top of the virtual air (POSIX build)
+ *
+ * Frames from esp_wifi_80211_tx() go to the air_medium process. A "wifi"
+ * task, standing in for the driver task, polls the medium socket without
+ * blocking and hands each delivered frame to the promiscuous callback with
+ * the same rx_ctrl fields the apps read. Tasks on the POSIX port must not
+ * block in system calls or be called from foreign threads, which is why
+ * air_rx_poll() is used instead of the air RX thread. The same task reports
+ * sent frames to the TX-done callback, so it runs in driver context as on
+ * the target. ESP-NOW (esp_now.h) shares the medium connection and the
+ * task: its frames are action frames in the air.h layout.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_wifi.h"
+#include "esp_now.h"
+#include "esp_log.h"
+#include "esp_posix.h"
+#include "air.h"
+
+#define WIFI_TASK_PRIORITY      23      // Above the app tasks, like the driver task
+#define WIFI_TASK_STACK_SIZE    8192
+#define WIFI_TASK_POLL_MS       1
+#define WIFI_RX_BURST           32      // Frames delivered per poll
+#define WIFI_FCS_LEN            4       // sig_len counts the FCS
+#define WIFI_SEQ_CTRL_OFFSET    22
+#define WIFI_TX_DONE_QUEUE_LEN  32      // Completions pending for the wifi task
+
+/* 802.11 frame control type field */
+#define FC0_TYPE_MASK           0x0C
+#define FC0_TYPE_MGMT           0x00
+#define FC0_TYPE_CTRL           0x04
+#define FC0_TYPE_DATA           0x08
+
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+
+static const char *TAG = "wifi_posix";
+
+/* Driver state */
+typedef struct {
+    bool initialized;
+    bool started;
+    bool connected;
+    wifi_mode_t mode;
+    wifi_config_t config[WIFI_IF_NUM];
+    wifi_ps_type_t ps;
+    uint8_t protocol[WIFI_IF_NUM];
+    bool disable_11b[WIFI_IF_NUM];
+    wifi_phy_rate_t tx_rate[WIFI_IF_NUM];
+    int8_t max_tx_power;
+    uint16_t sequence;
+
+    bool promiscuous;
+    wifi_promiscuous_cb_t promiscuous_cb;
+    uint32_t filter_mask;
+
+    esp_wifi_80211_tx_done_cb_t tx_done_cb;
+    QueueHandle_t tx_done;          // tx_done_t, filled by esp_wifi_80211_tx() and esp_now_send()
+
+    bool espnow;                    // esp_now_init() called
+    esp_now_recv_cb_t espnow_recv_cb;
+    esp_now_send_cb_t espnow_send_cb;
+    esp_now_peer_info_t peers[ESP_NOW_MAX_TOTAL_PEER_NUM];
+    uint8_t peer_count;
+
+    air_node_t air;
+    bool air_open;
+    TaskHandle_t task;
+} wifi_posix_t;
+
+static wifi_posix_t wifi = {
+    .ps = WIFI_PS_MIN_MODEM,
+    .protocol = {
+        WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N,
+        WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N,
+    },
+    .max_tx_power = 80,
+    .filter_mask = WIFI_PROMIS_FILTER_MASK_ALL,
+};
+
+/* A frame accepted by the medium, waiting to be reported to the TX-done callback */
+typedef struct {
+    wifi_interface_t ifx;
+    bool espnow;                    // Report to the ESP-NOW send callback
+    uint16_t len;
+    uint8_t da[6];
+    uint8_t sa[6];
+} tx_done_t;
+
+static const uint8_t ap_mac[6] = AIR_AP_MAC;
+static const uint8_t sta_mac[6] = AIR_STA_MAC;
+
+static bool interface_valid(wifi_interface_t ifx)
+{
+    return ifx == WIFI_IF_STA ? (wifi.mode == WIFI_MODE_STA || wifi.mode == WIFI_MODE_APSTA)
+         : ifx == WIFI_IF_AP  ? (wifi.mode == WIFI_MODE_AP || wifi.mode == WIFI_MODE_APSTA)
+         : false;
+}
+
+/* Map the frame control type to the promiscuous packet type and the filter bits that pass it */
+static wifi_promiscuous_pkt_type_t frame_pkt_type(const uint8_t *frame, uint32_t *mask)
+{
+    switch (frame[0] & FC0_TYPE_MASK) {
+        case FC0_TYPE_MGMT: *mask = WIFI_PROMIS_FILTER_MASK_MGMT; return WIFI_PKT_MGMT;
+        case FC0_TYPE_CTRL: *mask = WIFI_PROMIS_FILTER_MASK_CTRL; return WIFI_PKT_CTRL;
+        case FC0_TYPE_DATA:
+            // The virtual air does not aggregate, so every data frame is an MPDU
+            *mask = WIFI_PROMIS_FILTER_MASK_DATA | WIFI_PROMIS_FILTER_MASK_DATA_MPDU;
+            return WIFI_PKT_DATA;
+        default:            *mask = WIFI_PROMIS_FILTER_MASK_MISC; return WIFI_PKT_MISC;
+    }
+}
+
+/* Hand an ESP-NOW frame addressed to one of our interfaces, or broadcast, to the receive callback */
+static void espnow_rx(const uint8_t *frame, size_t len, const air_rx_info_t *info)
+{
+    static const uint8_t broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    const uint8_t *da, *sa, *data;
+    size_t data_len;
+    uint8_t mac[6];
+
+    if (!wifi.espnow || wifi.espnow_recv_cb == NULL ||
+        !air_espnow_decode(frame, len, &da, &sa, &data, &data_len)) {
+        return;
+    }
+    bool ours = memcmp(da, broadcast, 6) == 0;
+    for (wifi_interface_t ifx = WIFI_IF_STA; ifx < WIFI_IF_NUM && !ours; ifx++) {
+        ours = interface_valid(ifx) && esp_wifi_get_mac(ifx, mac) == ESP_OK && memcmp(da, mac, 6) == 0;
+    }
+    if (!ours) {
+        return;
+    }
+
+    wifi_pkt_rx_ctrl_t rx_ctrl = {
+        .rssi = esp_posix_options.rssi,
+        .channel = CONFIG_ESP_WIFI_CHANNEL,
+        .sig_len = len + WIFI_FCS_LEN,
+        .timestamp = (uint32_t)info->rx_time_us,
+    };
+    esp_now_recv_info_t recv_info = {
+        .src_addr = (uint8_t *)sa,
+        .des_addr = (uint8_t *)da,
+        .rx_ctrl = &rx_ctrl,
+    };
+    wifi.espnow_recv_cb(&recv_info, data, (int)data_len);
+}
+
+/* Called from air_rx_poll() on the wifi task */
+static void on_air_frame(const uint8_t *frame, size_t len, const air_rx_info_t *info, void *ctx)
+{
+    (void)ctx;
+    static uint8_t buf[sizeof(wifi_promiscuous_pkt_t) + AIR_MAX_FRAME + WIFI_FCS_LEN];
+
+    espnow_rx(frame, len, info);
+
+    if (!wifi.promiscuous || wifi.promiscuous_cb == NULL || len < 2) {
+        return;
+    }
+
+    uint32_t mask;
+    wifi_promiscuous_pkt_type_t type = frame_pkt_type(frame, &mask);
+    if ((wifi.filter_mask & mask) == 0) {
+        return;
+    }
+
+    wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
+    memset(&pkt->rx_ctrl, 0, sizeof(pkt->rx_ctrl));
+    pkt->rx_ctrl.rssi = esp_posix_options.rssi;
+    pkt->rx_ctrl.channel = CONFIG_ESP_WIFI_CHANNEL;
+    pkt->rx_ctrl.sig_len = len + WIFI_FCS_LEN;
+    pkt->rx_ctrl.timestamp = (uint32_t)info->rx_time_us;
+    memcpy(pkt->payload, frame, len);
+    memset(pkt->payload + len, 0, WIFI_FCS_LEN);
+
+    wifi.promiscuous_cb(pkt, type);
+}
+
+/* Report sent frames in send order, like the driver's TX-done path */
+static void report_tx_done(void)
+{
+    tx_done_t done;
+
+    while (xQueueReceive(wifi.tx_done, &done, 0) == pdTRUE) {
+        if (done.espnow) {
+            if (wifi.espnow_send_cb != NULL) {
+                wifi.espnow_send_cb(done.da, ESP_NOW_SEND_SUCCESS);
+            }
+            continue;
+        }
+        if (wifi.tx_done_cb == NULL) {
+            continue;
+        }
+        esp_80211_tx_info_t info = {
+            .des_addr = done.da,
+            .src_addr = done.sa,
+            .ifidx = done.ifx,
+            .data = NULL,
+            .data_len = done.len,
+            .rate = wifi.tx_rate[done.ifx],
+            .tx_status = WIFI_SEND_SUCCESS,
+        };
+        wifi.tx_done_cb(&info);
+    }
+}
+
+static void wifi_task(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        report_tx_done();
+
+        // Always drain the socket, so frames queued while promiscuous is off are dropped
+        if (air_rx_poll(&wifi.air, on_air_frame, NULL, WIFI_RX_BURST) < 0) {
+            ESP_LOGE(TAG, "Medium socket error: %s", strerror(errno));
+        }
+        vTaskDelay(pdMS_TO_TICKS(WIFI_TASK_POLL_MS));
+    }
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    wifi.initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    if (!wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    wifi.mode = mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    if (!wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (conf == NULL || interface >= WIFI_IF_NUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!interface_valid(interface)) {
+        return ESP_ERR_WIFI_MODE;
+    }
+    wifi.config[interface] = *conf;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    if (!wifi.initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (wifi.started) {
+        return ESP_OK;
+    }
+
+    if (air_open(&wifi.air, esp_posix_options.medium) < 0) {
+        ESP_LOGE(TAG, "Cannot reach medium '%s' (%s); start air_medium first",
+                 esp_posix_options.medium != NULL ? esp_posix_options.medium : AIR_DEFAULT_MEDIUM,
+                 strerror(errno));
+        return ESP_FAIL;
+    }
+    wifi.air_open = true;
+
+    if (wifi.tx_done == NULL) {
+        wifi.tx_done = xQueueCreate(WIFI_TX_DONE_QUEUE_LEN, sizeof(tx_done_t));
+    }
+    if (wifi.tx_done == NULL ||
+        xTaskCreate(wifi_task, "wifi", WIFI_TASK_STACK_SIZE, NULL, WIFI_TASK_PRIORITY,
+                    &wifi.task) != pdPASS) {
+        air_close(&wifi.air);
+        wifi.air_open = false;
+        return ESP_ERR_NO_MEM;
+    }
+    wifi.started = true;
+
+    if (interface_valid(WIFI_IF_AP)) {
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_AP_START, NULL, 0, portMAX_DELAY);
+
+        // The station on the air is always associated
+        wifi_event_ap_staconnected_t sta = { .aid = 1 };
+        memcpy(sta.mac, sta_mac, 6);
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_AP_STACONNECTED, &sta, sizeof(sta), portMAX_DELAY);
+    }
+    if (interface_valid(WIFI_IF_STA)) {
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, portMAX_DELAY);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void)
+{
+    if (!wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    vTaskDelete(wifi.task);
+    wifi.task = NULL;
+    wifi.started = false;
+    wifi.connected = false;
+    return ESP_OK;
+}
+
+/* The AP is always there: connecting succeeds at once */
+esp_err_t esp_wifi_connect(void)
+{
+    if (!wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (!interface_valid(WIFI_IF_STA)) {
+        return ESP_ERR_WIFI_MODE;
+    }
+
+    wifi.connected = true;
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, NULL, 0, portMAX_DELAY);
+
+    ip_event_got_ip_t got_ip = {
+        .ip_info = {
+            .ip.addr = 0x0204A8C0,        // 192.168.4.2, the softAP's first lease
+            .netmask.addr = 0x00FFFFFF,
+            .gw.addr = 0x0104A8C0,
+        },
+        .ip_changed = true,
+    };
+    esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), portMAX_DELAY);
+
+    return ESP_OK;
+}
+
+/* The event handlers see the same disconnect a lost association gives */
+esp_err_t esp_wifi_disconnect(void)
+{
+    if (!wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (!interface_valid(WIFI_IF_STA)) {
+        return ESP_ERR_WIFI_MODE;
+    }
+
+    wifi.connected = false;
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, NULL, 0, portMAX_DELAY);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+    wifi.ps = type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t *type)
+{
+    if (type == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *type = wifi.ps;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_protocol(wifi_interface_t ifx, uint8_t protocol_bitmap)
+{
+    if (ifx >= WIFI_IF_NUM) {
+        return ESP_ERR_WIFI_IF;
+    }
+    wifi.protocol[ifx] = protocol_bitmap;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_protocol(wifi_interface_t ifx, uint8_t *protocol_bitmap)
+{
+    if (ifx >= WIFI_IF_NUM || protocol_bitmap == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *protocol_bitmap = wifi.protocol[ifx];
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_config_11b_rate(wifi_interface_t ifx, bool disable)
+{
+    if (ifx >= WIFI_IF_NUM) {
+        return ESP_ERR_WIFI_IF;
+    }
+    wifi.disable_11b[ifx] = disable;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_config_80211_tx_rate(wifi_interface_t ifx, wifi_phy_rate_t rate)
+{
+    if (!wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (ifx >= WIFI_IF_NUM) {
+        return ESP_ERR_WIFI_IF;
+    }
+    if (rate >= WIFI_PHY_RATE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    wifi.tx_rate[ifx] = rate;
+    return ESP_OK;
+}
+
+/* Same range as the driver: 8..84 in 0.25 dBm units */
+esp_err_t esp_wifi_set_max_tx_power(int8_t power)
+{
+    if (!wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (power < 8 || power > 84) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    wifi.max_tx_power = power;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_max_tx_power(int8_t *power)
+{
+    if (power == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *power = wifi.max_tx_power;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6])
+{
+    if (ifx >= WIFI_IF_NUM || mac == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (esp_posix_options.mac_set) {
+        memcpy(mac, esp_posix_options.mac, 6);
+    } else {
+        memcpy(mac, ifx == WIFI_IF_AP ? ap_mac : sta_mac, 6);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info)
+{
+    if (ap_info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!wifi.connected) {
+        return ESP_ERR_WIFI_NOT_CONNECT;
+    }
+
+    memset(ap_info, 0, sizeof(*ap_info));
+    memcpy(ap_info->bssid, ap_mac, sizeof(ap_info->bssid));
+    memcpy(ap_info->ssid, wifi.config[WIFI_IF_STA].sta.ssid, sizeof(wifi.config[WIFI_IF_STA].sta.ssid));
+    ap_info->primary = CONFIG_ESP_WIFI_CHANNEL;
+    ap_info->rssi = esp_posix_options.rssi;
+    ap_info->authmode = wifi.config[WIFI_IF_STA].sta.threshold.authmode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_80211_tx(wifi_interface_t ifx, const void *buffer, int len, bool en_sys_seq)
+{
+    uint8_t frame[AIR_MAX_FRAME];
+
+    if (!wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    if (ifx >= WIFI_IF_NUM || buffer == NULL || len < WIFI_SEQ_CTRL_OFFSET + 2 || len > AIR_MAX_FRAME) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!interface_valid(ifx)) {
+        return ESP_ERR_WIFI_IF;
+    }
+
+    memcpy(frame, buffer, len);
+    if (en_sys_seq) {
+        // Sequence number in bits 4..15 of the sequence control field
+        uint16_t seq_ctrl = (uint16_t)((wifi.sequence++ & 0x0FFF) << 4);
+        frame[WIFI_SEQ_CTRL_OFFSET] = seq_ctrl & 0xFF;
+        frame[WIFI_SEQ_CTRL_OFFSET + 1] = seq_ctrl >> 8;
+    }
+
+    if (air_tx(&wifi.air, frame, len) < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Addresses 1 and 2 of the MAC header; the report is dropped if the wifi task is behind
+    tx_done_t done = { .ifx = ifx, .len = (uint16_t)len };
+    memcpy(done.da, frame + 4, sizeof(done.da));
+    memcpy(done.sa, frame + 10, sizeof(done.sa));
+    xQueueSend(wifi.tx_done, &done, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_register_80211_tx_cb(esp_wifi_80211_tx_done_cb_t cb)
+{
+    wifi.tx_done_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb)
+{
+    wifi.promiscuous_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous_filter(const wifi_promiscuous_filter_t *filter)
+{
+    if (filter == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    wifi.filter_mask = filter->filter_mask;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_promiscuous(bool en)
+{
+    wifi.promiscuous = en;
+    return ESP_OK;
+}
+
+/* ---- ESP-NOW ---- */
+
+esp_err_t esp_now_init(void)
+{
+    if (!wifi.started) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    wifi.espnow = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_deinit(void)
+{
+    wifi.espnow = false;
+    wifi.espnow_recv_cb = NULL;
+    wifi.espnow_send_cb = NULL;
+    wifi.peer_count = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb)
+{
+    if (!wifi.espnow) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    wifi.espnow_recv_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb)
+{
+    if (!wifi.espnow) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    wifi.espnow_send_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_set_pmk(const uint8_t *pmk)
+{
+    return pmk == NULL ? ESP_ERR_ESPNOW_ARG : ESP_OK;
+}
+
+static esp_now_peer_info_t *find_peer(const uint8_t *peer_addr)
+{
+    for (int i = 0; i < wifi.peer_count; i++) {
+        if (memcmp(wifi.peers[i].peer_addr, peer_addr, ESP_NOW_ETH_ALEN) == 0) {
+            return &wifi.peers[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer)
+{
+    if (!wifi.espnow) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    if (peer == NULL || peer->ifidx >= WIFI_IF_NUM) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+    if (find_peer(peer->peer_addr) != NULL) {
+        return ESP_ERR_ESPNOW_EXIST;
+    }
+    if (wifi.peer_count >= ESP_NOW_MAX_TOTAL_PEER_NUM) {
+        return ESP_ERR_ESPNOW_FULL;
+    }
+    wifi.peers[wifi.peer_count++] = *peer;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr)
+{
+    if (!wifi.espnow) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    esp_now_peer_info_t *peer = peer_addr != NULL ? find_peer(peer_addr) : NULL;
+    if (peer == NULL) {
+        return ESP_ERR_ESPNOW_NOT_FOUND;
+    }
+    *peer = wifi.peers[--wifi.peer_count];
+    return ESP_OK;
+}
+
+bool esp_now_is_peer_exist(const uint8_t *peer_addr)
+{
+    return wifi.espnow && peer_addr != NULL && find_peer(peer_addr) != NULL;
+}
+
+/* One frame to one peer; the report goes to the send callback from the wifi task */
+static esp_err_t espnow_send_one(const esp_now_peer_info_t *peer, const uint8_t *data, size_t len)
+{
+    uint8_t frame[AIR_MAX_FRAME];
+    uint8_t sa[6];
+
+    if (!interface_valid(peer->ifidx)) {
+        return ESP_ERR_ESPNOW_IF;
+    }
+    esp_wifi_get_mac(peer->ifidx, sa);
+    size_t frame_len = air_espnow_encode(frame, sizeof(frame), peer->peer_addr, sa, data, len);
+    if (frame_len == 0) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+    if (air_tx(&wifi.air, frame, frame_len) < 0) {
+        return ESP_ERR_ESPNOW_NO_MEM;
+    }
+
+    tx_done_t done = { .ifx = peer->ifidx, .espnow = true, .len = (uint16_t)frame_len };
+    memcpy(done.da, peer->peer_addr, sizeof(done.da));
+    memcpy(done.sa, sa, sizeof(done.sa));
+    xQueueSend(wifi.tx_done, &done, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len)
+{
+    if (!wifi.espnow) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    if (data == NULL || len == 0 || len > ESP_NOW_MAX_DATA_LEN_V2) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+
+    if (peer_addr != NULL) {
+        const esp_now_peer_info_t *peer = find_peer(peer_addr);
+        return peer != NULL ? espnow_send_one(peer, data, len) : ESP_ERR_ESPNOW_NOT_FOUND;
+    }
+    for (int i = 0; i < wifi.peer_count; i++) {
+        esp_err_t ret = espnow_send_one(&wifi.peers[i], data, len);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+void esp_wifi_posix_shutdown(void)
+{
+    if (!wifi.air_open) {
+        return;
+    }
+
+    printf("wifi tx_frames=%u tx_errors=%u rx_frames=%u\n",
+           wifi.air.tx_frames, wifi.air.tx_errors, wifi.air.rx_frames);
+    air_close(&wifi.air);
+    wifi.air_open = false;
+}
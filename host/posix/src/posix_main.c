@@ -0,0 +1,154 @@
+/**
+ * @file posix_main.c
+ * @brief Entry point for the station and AP apps on the FreeRTOS POSIX port
+ *
+ * Parses the host options, starts app_main() in a "main" task at priority
+ * 1 (as ESP-IDF does) and runs the FreeRTOS scheduler. A supervisor task
+ * ends the scheduler after -T seconds or on SIGINT/SIGTERM, after which
+ * the virtual-air counters are printed.
+ */
+
+#include <ctype.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_posix.h"
+
+#define MAIN_TASK_PRIORITY          1
+#define MAIN_TASK_STACK_SIZE        16384
+#define SUPERVISOR_TASK_PRIORITY    (configMAX_PRIORITIES - 2)
+#define SUPERVISOR_POLL_MS          100
+
+extern void app_main(void);
+
+esp_posix_options_t esp_posix_options = {
+    .rssi = -45,
+    .log_level = CONFIG_LOG_DEFAULT_LEVEL,
+};
+
+static volatile sig_atomic_t stop_requested;
+
+void vAssertCalled(const char *file, unsigned long line)
+{
+    fprintf(stderr, "configASSERT failed at %s:%lu\n", file, line);
+    fflush(stdout);
+    abort();
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void main_task(void *arg)
+{
+    (void)arg;
+    app_main();
+    vTaskDelete(NULL);
+}
+
+static void supervisor_task(void *arg)
+{
+    (void)arg;
+    TickType_t started = xTaskGetTickCount();
+
+    while (!stop_requested) {
+        if (esp_posix_options.duration_s > 0 &&
+            xTaskGetTickCount() - started >= pdMS_TO_TICKS(esp_posix_options.duration_s * 1000u)) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(SUPERVISOR_POLL_MS));
+    }
+
+    vTaskEndScheduler();
+    vTaskDelete(NULL);
+}
+
+static bool parse_mac(const char *text, uint8_t mac[6])
+{
+    unsigned int b[6];
+    if (sscanf(text, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        if (b[i] > 0xFF) {
+            return false;
+        }
+        mac[i] = (uint8_t)b[i];
+    }
+    return true;
+}
+
+static bool parse_log_level(const char *text, esp_log_level_t *level)
+{
+    static const char letters[] = "NEWIDV";
+    const char *found = strchr(letters, toupper((unsigned char)text[0]));
+
+    if (text[0] == '\0' || text[1] != '\0' || found == NULL) {
+        return false;
+    }
+    *level = (esp_log_level_t)(found - letters);
+    return true;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-m medium] [-M mac] [-r rssi] [-l n|e|w|i|d|v] [-s seed] [-T seconds]\n"
+            "Terminal commands are read from stdin, e.g.\n"
+            "  printf 'set 1 100 100\\nstart\\n' | %s -T 10\n", prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "m:M:r:l:s:T:h")) != -1) {
+        switch (opt) {
+            case 'm': esp_posix_options.medium = optarg; break;
+            case 'M':
+                if (!parse_mac(optarg, esp_posix_options.mac)) {
+                    fprintf(stderr, "%s: bad MAC '%s'\n", argv[0], optarg);
+                    return 2;
+                }
+                esp_posix_options.mac_set = true;
+                break;
+            case 'r': esp_posix_options.rssi = (int8_t)atoi(optarg); break;
+            case 'l':
+                if (!parse_log_level(optarg, &esp_posix_options.log_level)) {
+                    fprintf(stderr, "%s: bad log level '%s'\n", argv[0], optarg);
+                    return 2;
+                }
+                break;
+            case 's': esp_posix_options.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'T': esp_posix_options.duration_s = (uint32_t)strtoul(optarg, NULL, 10); break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+
+    // Line-buffered output keeps task logs in order when piped to a file
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (xTaskCreate(main_task, "main", MAIN_TASK_STACK_SIZE, NULL, MAIN_TASK_PRIORITY, NULL) != pdPASS ||
+        xTaskCreate(supervisor_task, "posix", configMINIMAL_STACK_SIZE, NULL,
+                    SUPERVISOR_TASK_PRIORITY, NULL) != pdPASS) {
+        fprintf(stderr, "%s: cannot create the initial tasks\n", argv[0]);
+        return 1;
+    }
+
+    vTaskStartScheduler();
+
+    esp_wifi_posix_shutdown();
+    return 0;
+}
@@ -0,0 +1,480 @@
+/**
+ * @file energy_sim.c
+ * @brief Discrete-time energy simulator of the station
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "energy_sim.h"
+#include "sched_core.h"
+#include "frame_codec.h"
+#include "sample_codec.h"
+
+#define SIM_STEP_MS             10      // Random packet task period, the finest loop
+#define SIM_CREATOR_MS          100     // Packet creator check interval
+#define SIM_SCHEDULER_MS        50      // SCHEDULER_CHECK_INTERVAL_MS
+#define SIM_SCHEDULER_START_MS  1000    // The scheduler task waits for WiFi first
+#define SIM_BURST_DURATION_MS   5000    // Random packet burst mode length
+#define SIM_CHUNK_SAMPLES       8192
+
+/* Radio activity the renderer turns into current */
+typedef enum {
+    ACTIVITY_LISTEN,
+    ACTIVITY_TX,
+} activity_t;
+
+typedef struct {
+    double t;                   // ms
+    uint8_t activity;
+    int8_t delta;               // +1 starts, -1 ends
+} sim_event_t;
+
+typedef struct {
+    sim_event_t *events;
+    size_t count;
+    size_t capacity;
+} event_list_t;
+
+/* Model parameters by name */
+static const struct {
+    const char *key;
+    size_t offset;
+} model_keys[] = {
+    { "idle_a", offsetof(sim_model_t, idle_a) },
+    { "listen_a", offsetof(sim_model_t, listen_a) },
+    { "tx_a", offsetof(sim_model_t, tx_a) },
+    { "beacon_ms", offsetof(sim_model_t, beacon_ms) },
+    { "max_modem_beacons", offsetof(sim_model_t, max_modem_beacons) },
+    { "listen_ms", offsetof(sim_model_t, listen_ms) },
+    { "tx_lead_ms", offsetof(sim_model_t, tx_lead_ms) },
+    { "tx_fixed_ms", offsetof(sim_model_t, tx_fixed_ms) },
+    { "rate_mbps", offsetof(sim_model_t, rate_mbps) },
+    { "tx_tail_ms", offsetof(sim_model_t, tx_tail_ms) },
+};
+
+#define MODEL_KEY_COUNT (sizeof(model_keys) / sizeof(model_keys[0]))
+
+void sim_model_defaults(sim_model_t *model)
+{
+    *model = (sim_model_t){
+        .idle_a = 0.027,
+        .listen_a = 0.08,
+        .tx_a = 0.25,
+        .beacon_ms = 102.4,
+        .max_modem_beacons = 3,
+        .listen_ms = 6.0,
+        .tx_lead_ms = 1.0,
+        .tx_fixed_ms = 0.2,
+        .rate_mbps = 1.0,
+        .tx_tail_ms = 3.0,
+    };
+}
+
+bool sim_model_set(sim_model_t *model, const char *key, const char *value)
+{
+    for (size_t i = 0; i < MODEL_KEY_COUNT; i++) {
+        if (strcmp(key, model_keys[i].key) == 0) {
+            char *end;
+            double v = strtod(value, &end);
+            if (end == value || *end != '\0' || v < 0) {
+                return false;
+            }
+            *(double *)((char *)model + model_keys[i].offset) = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+int sim_model_load(sim_model_t *model, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    char line[256];
+    int status = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char *hash = strchr(line, '#');
+        if (hash != NULL) {
+            *hash = '\0';
+        }
+        char *save = NULL;
+        for (char *tok = strtok_r(line, " \t\r\n", &save); tok != NULL; tok = strtok_r(NULL, " \t\r\n", &save)) {
+            char *eq = strchr(tok, '=');
+            if (eq == NULL) {
+                status = -1;
+                continue;
+            }
+            *eq = '\0';
+            if (!sim_model_set(model, tok, eq + 1)) {
+                status = -1;
+            }
+        }
+    }
+    fclose(f);
+    if (status < 0) {
+        errno = EINVAL;
+    }
+    return status;
+}
+
+void sim_model_print(const sim_model_t *model, FILE *out)
+{
+    for (size_t i = 0; i < MODEL_KEY_COUNT; i++) {
+        fprintf(out, "%s=%.6g\n", model_keys[i].key, *(const double *)((const char *)model + model_keys[i].offset));
+    }
+}
+
+void sim_workload_defaults(sim_workload_t *w)
+{
+    *w = (sim_workload_t){
+        .class_periods = { 3000, 5000, 6000, 0 },
+        .class_deadlines = { 3000, 5000, 6000, 2000 },
+        .class_types = { DATA_TYPE_INT32, DATA_TYPE_FLOAT, DATA_TYPE_INT16, DATA_TYPE_INT32 },
+        .class_counts = { 5, 4, 6, 0 },
+        .threshold_ms = 1000,
+        .random_min_ms = 500,
+        .random_max_ms = 3000,
+        .burst = true,
+        .burst_period_ms = 10000,
+        .burst_interval_ms = 50,
+        .random_count = 10,
+        .random_type = DATA_TYPE_INT32,
+        .ps_mode = SIM_PS_MIN,
+        .seed = 1,
+    };
+}
+
+static bool parse_u32(const char *value, uint32_t *out)
+{
+    char *end;
+    unsigned long v = strtoul(value, &end, 0);
+    if (end == value || *end != '\0' || v > UINT32_MAX) {
+        return false;
+    }
+    *out = (uint32_t)v;
+    return true;
+}
+
+/* Plain types only: records need the schema definitions, which @CFG does not carry */
+static bool parse_type(const char *value, data_type_t *type)
+{
+    return data_type_from_option(value, type) && !data_type_is_schema(*type);
+}
+
+bool sim_workload_set(sim_workload_t *w, const char *key, const char *value)
+{
+    uint32_t v;
+    int class_num;
+    char field[32];
+
+    if (sscanf(key, "class%d_%31s", &class_num, field) == 2 && class_num >= 1 && class_num <= MAX_CLASSES) {
+        int c = class_num - 1;
+        if (strcmp(field, "type") == 0) {
+            return parse_type(value, &w->class_types[c]);
+        }
+        if (!parse_u32(value, &v)) {
+            return false;
+        }
+        if (strcmp(field, "period_ms") == 0) {
+            w->class_periods[c] = v;
+        } else if (strcmp(field, "deadline_ms") == 0) {
+            w->class_deadlines[c] = v;
+        } else if (strcmp(field, "count") == 0 && v <= UINT16_MAX) {
+            w->class_counts[c] = (uint16_t)v;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    if (strcmp(key, "random_type") == 0) {
+        return parse_type(value, &w->random_type);
+    }
+    if (strcmp(key, "ps_mode") == 0) {
+        if (strcasecmp(value, "none") == 0) {
+            w->ps_mode = SIM_PS_NONE;
+        } else if (strcasecmp(value, "min") == 0) {
+            w->ps_mode = SIM_PS_MIN;
+        } else if (strcasecmp(value, "max") == 0) {
+            w->ps_mode = SIM_PS_MAX;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (!parse_u32(value, &v)) {
+        return false;
+    }
+    if (strcmp(key, "sample_times") == 0) {
+        w->sample_time_mask = v;
+    } else if (strcmp(key, "threshold_ms") == 0) {
+        w->threshold_ms = v;
+    } else if (strcmp(key, "random") == 0) {
+        w->random = v != 0;
+    } else if (strcmp(key, "random_min_ms") == 0) {
+        w->random_min_ms = v;
+    } else if (strcmp(key, "random_max_ms") == 0) {
+        w->random_max_ms = v;
+    } else if (strcmp(key, "burst") == 0) {
+        w->burst = v != 0;
+    } else if (strcmp(key, "burst_period_ms") == 0) {
+        w->burst_period_ms = v;
+    } else if (strcmp(key, "burst_interval_ms") == 0) {
+        w->burst_interval_ms = v;
+    } else if (strcmp(key, "random_count") == 0 && v <= UINT16_MAX) {
+        w->random_count = (uint16_t)v;
+    } else if (strcmp(key, "wmm") == 0) {
+        w->wmm = v != 0;
+    } else if (strcmp(key, "seed") == 0) {
+        w->seed = v;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static uint32_t next_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/* Same as the firmware's random_range() */
+static uint32_t random_range(uint32_t *state, uint32_t min, uint32_t max)
+{
+    if (min >= max) {
+        return min;
+    }
+    return min + next_random(state) % (max - min + 1);
+}
+
+static int add_window(event_list_t *list, activity_t activity, double start, double end)
+{
+    if (end <= start) {
+        return 0;
+    }
+    if (list->count + 2 > list->capacity) {
+        size_t capacity = list->capacity > 0 ? list->capacity * 2 : 1024;
+        sim_event_t *grown = realloc(list->events, sizeof(*grown) * capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        list->events = grown;
+        list->capacity = capacity;
+    }
+    list->events[list->count++] = (sim_event_t){ .t = start, .activity = (uint8_t)activity, .delta = 1 };
+    list->events[list->count++] = (sim_event_t){ .t = end, .activity = (uint8_t)activity, .delta = -1 };
+    return 0;
+}
+
+static int compare_events(const void *a, const void *b)
+{
+    const sim_event_t *x = a, *y = b;
+    return x->t < y->t ? -1 : x->t > y->t ? 1 : 0;
+}
+
+/* Queue one packet of sequential values, like the firmware packet generator */
+static void create_packet(sched_core_t *core, class_id_t class_id, uint16_t count, uint32_t now,
+                          sim_stats_t *stats)
+{
+    double values[MAX_PACKET_SIZE];
+    uint64_t native[MAX_PACKET_SIZE / sizeof(uint64_t)];
+
+    if ((size_t)count * data_type_size(core->class_types[class_id]) > sizeof(native)) {
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        values[i] = i;
+    }
+    sample_narrow(core->class_types[class_id], native, values, count);
+    if (sched_core_submit(core, class_id, native, count, now) == SCHED_OK) {
+        stats->packets++;
+    }
+}
+
+/* Assemble a batch like process_packets(); returns the frame length, 0 if nothing was sent */
+static size_t send_batch(sched_core_t *core, const sim_workload_t *w, uint32_t now, sim_stats_t *stats)
+{
+    static const frame_addr_t addr = {
+        .da = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01},
+        .sa = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02},
+        .bssid = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01},
+    };
+    static const wmm_ac_t access[MAX_CLASSES] = { WMM_AC_BE, WMM_AC_BE, WMM_AC_BE, WMM_AC_BE };
+    uint8_t data[MAX_TX_SIZE + SAMPLE_TIME_MAX_LEN];
+    uint8_t frame[FRAME_MAX_LEN];
+    sched_batch_t batch = {0};
+
+    uint16_t size = sched_core_build_batch(core, now, data, MAX_TX_SIZE, &batch);
+    for (int c = 0; c < MAX_CLASSES; c++) {
+        stats->misses += batch.class_misses[c];
+    }
+    if (size == 0) {
+        return 0;
+    }
+
+    data_packet_header_t header = {0};
+    memcpy(header.class_counts, batch.class_counts, sizeof(header.class_counts));
+    memcpy(header.class_types, core->class_types, sizeof(header.class_types));
+    header.timestamp = now;
+    if (batch.times.class_mask != 0) {
+        size_t time_len = sample_time_encode(data + size, SAMPLE_TIME_MAX_LEN, now, core->class_periods,
+                                             &batch.times);
+        if (time_len > 0) {
+            header.flags |= FRAME_FLAG_SAMPLE_TIMES;
+            size += time_len;
+        }
+    }
+    header.total_size = size;
+
+    size_t len = w->wmm ? frame_build_qos(frame, sizeof(frame), &addr,
+                                          frame_access_category(header.class_counts, access), &header, data)
+                        : frame_build(frame, sizeof(frame), &addr, &header, data);
+    if (len > 0) {
+        sched_core_batch_sent(core, &batch);
+    }
+    return len;
+}
+
+/* Run the station loop and collect its radio activity */
+static int simulate(const sim_model_t *model, const sim_workload_t *w, uint32_t duration_ms, event_list_t *list,
+                    sim_stats_t *stats)
+{
+    static sched_core_t core;
+    uint32_t rng = w->seed != 0 ? w->seed : 1;
+
+    sched_core_init(&core);
+    for (int c = 0; c < MAX_CLASSES; c++) {
+        core.class_types[c] = w->class_types[c];
+        core.class_periods[c] = w->class_periods[c];
+        core.class_deadlines[c] = w->class_deadlines[c];
+    }
+    core.class_types[CLASS_RANDOM] = w->random_type;
+    core.processing_threshold = w->threshold_ms;
+    core.sample_time_mask = w->sample_time_mask;
+
+    // Power-save wakes at a random beacon phase
+    if (w->ps_mode != SIM_PS_NONE && model->beacon_ms > 0) {
+        double period = model->beacon_ms * (w->ps_mode == SIM_PS_MAX ? model->max_modem_beacons : 1.0);
+        double t = (double)(next_random(&rng) % 1000) / 1000.0 * period;
+        for (; t < duration_ms; t += period) {
+            if (add_window(list, ACTIVITY_LISTEN, t, t + model->listen_ms) < 0) {
+                return -1;
+            }
+            stats->wakes++;
+        }
+    }
+
+    uint32_t last_created[MAX_CLASSES] = {0};
+    uint32_t random_start = 0, burst_start = 0;
+    uint32_t next_random_packet = random_range(&rng, w->random_min_ms, w->random_max_ms);
+    bool burst_mode = false;
+
+    for (uint32_t t = 0; t < duration_ms; t += SIM_STEP_MS) {
+        if (t % SIM_CREATOR_MS == 0) {
+            for (int c = 0; c < MAX_CLASSES; c++) {
+                if (w->class_periods[c] > 0 && w->class_counts[c] > 0 && t - last_created[c] >= w->class_periods[c]) {
+                    create_packet(&core, (class_id_t)c, w->class_counts[c], t, stats);
+                    last_created[c] = t;
+                }
+            }
+        }
+
+        if (w->random) {
+            if (w->burst && !burst_mode && t > random_start + w->burst_period_ms) {
+                burst_mode = true;
+                burst_start = t;
+            } else if (burst_mode && t > burst_start + SIM_BURST_DURATION_MS) {
+                burst_mode = false;
+                random_start = t;
+            }
+            if (t >= next_random_packet) {
+                create_packet(&core, CLASS_RANDOM, w->random_count, t, stats);
+                next_random_packet = t + (burst_mode ? w->burst_interval_ms
+                                                     : random_range(&rng, w->random_min_ms, w->random_max_ms));
+            }
+        }
+
+        if (t >= SIM_SCHEDULER_START_MS && (t - SIM_SCHEDULER_START_MS) % SIM_SCHEDULER_MS == 0 &&
+            sched_core_due(&core, t)) {
+            size_t len = send_batch(&core, w, t, stats);
+            if (len > 0) {
+                double air = model->tx_fixed_ms + (model->rate_mbps > 0 ? len * 8.0 / (model->rate_mbps * 1000.0) : 0);
+                double start = t + model->tx_lead_ms;
+                if (add_window(list, ACTIVITY_LISTEN, t, start) < 0 ||
+                    add_window(list, ACTIVITY_TX, start, start + air) < 0 ||
+                    add_window(list, ACTIVITY_LISTEN, start + air, start + air + model->tx_tail_ms) < 0) {
+                    return -1;
+                }
+                stats->frames++;
+                stats->frame_bytes += len;
+                stats->tx_ms += air;
+            }
+        }
+    }
+    return 0;
+}
+
+int sim_run(const sim_model_t *model, const sim_workload_t *w, double duration_s, double interval_s,
+            sim_sample_cb_t cb, void *ctx, sim_stats_t *stats)
+{
+    event_list_t list = {0};
+    double chunk[SIM_CHUNK_SAMPLES];
+
+    memset(stats, 0, sizeof(*stats));
+    if (!(duration_s > 0) || !(interval_s > 0) || duration_s * 1000.0 > UINT32_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (simulate(model, w, (uint32_t)(duration_s * 1000.0), &list, stats) < 0) {
+        free(list.events);
+        errno = ENOMEM;
+        return -1;
+    }
+    qsort(list.events, list.count, sizeof(list.events[0]), compare_events);
+
+    // Average current over each sample period; transmitting wins over listening
+    double base = w->ps_mode == SIM_PS_NONE ? model->listen_a : model->idle_a;
+    double dt = interval_s * 1000.0;
+    uint64_t samples = (uint64_t)(duration_s / interval_s + 0.5);
+    int active[2] = {0, 0};
+    size_t next = 0, used = 0;
+
+    for (uint64_t i = 0; i < samples; i++) {
+        double t0 = i * dt, t1 = t0 + dt, at = t0, charge = 0.0;
+        for (;;) {
+            double level = active[ACTIVITY_TX] > 0 ? model->tx_a : active[ACTIVITY_LISTEN] > 0 ? model->listen_a : base;
+            double until = next < list.count && list.events[next].t < t1 ? list.events[next].t : t1;
+            if (until > at) {
+                charge += (until - at) * level;
+                at = until;
+            }
+            if (until >= t1) {
+                break;
+            }
+            active[list.events[next].activity] += list.events[next].delta;
+            next++;
+        }
+        chunk[used++] = charge / dt;
+        if (used == SIM_CHUNK_SAMPLES) {
+            cb(chunk, used, ctx);
+            used = 0;
+        }
+    }
+    if (used > 0) {
+        cb(chunk, used, ctx);
+    }
+
+    free(list.events);
+    return 0;
+}
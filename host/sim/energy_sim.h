@@ -0,0 +1,123 @@
+/**
+ * @file energy_sim.h
+ * @brief Discrete-time energy simulator of the station
+ *
+ * Replays the firmware station's loop in simulated time with the portable
+ * scheduler core. Periodic packet creation runs on its 100 ms check,
+ * random packets on their 10 ms check and batch assembly on the 50 ms
+ * scheduler tick. The resulting radio activity is rendered as a current
+ * trace at the power meter's sample interval. Each frame the scheduler
+ * sends turns into receiver-on lead time, a transmission whose airtime
+ * follows the real frame length (frame_codec), and a receiver-on tail.
+ * Power-save wakes add receiver-on windows every beacon, or every few
+ * beacons in max modem sleep.
+ *
+ * The power model is a set of key=value parameters (sim_model_t). The
+ * defaults are rough datasheet-level guesses; host/sim/sim_validate
+ * calibrates them against measured traces and checks the result.
+ */
+
+#ifndef ENERGY_SIM_H
+#define ENERGY_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "sched_types.h"
+
+/* Power model, currents in A and times in ms */
+typedef struct {
+    double idle_a;              // CPU running, modem asleep
+    double listen_a;            // Receiver on
+    double tx_a;                // Transmitting
+    double beacon_ms;           // Beacon interval; min modem sleep wakes for every beacon
+    double max_modem_beacons;   // Beacons per wake in max modem sleep
+    double listen_ms;           // Receiver on per power-save wake
+    double tx_lead_ms;          // Receiver on before a frame (wake-up, channel access)
+    double tx_fixed_ms;         // Airtime besides the frame bytes (preamble, PLCP)
+    double rate_mbps;           // PHY rate of the frame bytes
+    double tx_tail_ms;          // Receiver on after a frame (ACK, PS-Poll)
+} sim_model_t;
+
+typedef enum {
+    SIM_PS_NONE,
+    SIM_PS_MIN,
+    SIM_PS_MAX,
+} sim_ps_mode_t;
+
+/* The station configuration that drives the simulation (scheduler_config_t subset) */
+typedef struct {
+    uint32_t class_periods[MAX_CLASSES];
+    uint32_t class_deadlines[MAX_CLASSES];
+    data_type_t class_types[MAX_CLASSES];
+    uint16_t class_counts[MAX_CLASSES];
+    class_mask_t sample_time_mask;
+    uint32_t threshold_ms;
+
+    bool random;
+    uint32_t random_min_ms;
+    uint32_t random_max_ms;
+    bool burst;
+    uint32_t burst_period_ms;
+    uint32_t burst_interval_ms;
+    uint16_t random_count;
+    data_type_t random_type;
+
+    sim_ps_mode_t ps_mode;
+    bool wmm;
+    uint32_t seed;              // Random packet timing and beacon phase
+} sim_workload_t;
+
+typedef struct {
+    uint32_t packets;           // Packets created
+    uint32_t frames;            // Frames sent
+    uint64_t frame_bytes;
+    uint32_t misses;            // Packets dropped for a missed deadline
+    uint32_t wakes;             // Power-save wakes
+    double tx_ms;               // Total airtime
+} sim_stats_t;
+
+/* Receives the rendered current trace in chunks */
+typedef void (*sim_sample_cb_t)(const double *samples, size_t n, void *ctx);
+
+void sim_model_defaults(sim_model_t *model);
+
+/**
+ * @brief Set one model parameter by name
+ *
+ * @return false for an unknown key or a value that is not a number
+ */
+bool sim_model_set(sim_model_t *model, const char *key, const char *value);
+
+/**
+ * @brief Read "key=value" lines ('#' starts a comment) over the current values
+ *
+ * @return 0 on success, -1 with errno set on failure (EINVAL for a bad line)
+ */
+int sim_model_load(sim_model_t *model, const char *path);
+
+void sim_model_print(const sim_model_t *model, FILE *out);
+
+/**
+ * @brief Firmware defaults (terminal_cmd.h), random packets off, min modem sleep
+ */
+void sim_workload_defaults(sim_workload_t *w);
+
+/**
+ * @brief Apply one key of the station's "@CFG" manifest line
+ *
+ * @return false if the key does not affect the simulation or its value is bad
+ */
+bool sim_workload_set(sim_workload_t *w, const char *key, const char *value);
+
+/**
+ * @brief Simulate duration_s of station activity
+ *
+ * @param interval_s Sample interval of the rendered trace
+ * @return 0 on success, -1 with errno set on failure
+ */
+int sim_run(const sim_model_t *model, const sim_workload_t *w, double duration_s, double interval_s,
+            sim_sample_cb_t cb, void *ctx, sim_stats_t *stats);
+
+#endif /* ENERGY_SIM_H */
@@ -0,0 +1,703 @@
+/**
+ * @file sim_validate.c
+ * @brief Validate and calibrate the energy simulator against measured traces
+ *
+ * Reads the experiment manifest (data/manifest.txt). For each run it
+ * rebuilds the station configuration: the firmware defaults, overridden
+ * by whatever "@CFG" keys the run lists. workload=default also counts as
+ * a configuration, since it names those defaults. It simulates the run for as long
+ * as the trace lasts (energy_sim.h), at the trace's sample interval, and
+ * passes both traces through the same operators. The per-run comparison
+ * covers total energy, wakeups (bursts as trace_stat finds them), TX
+ * bursts, and Kolmogorov-Smirnov distances and medians of burst lengths
+ * and of gaps between burst starts. A summary of mean errors follows.
+ * Runs whose line sets no configuration (traces of other workloads that
+ * predate @CFG) would only measure the defaults, so they are listed as
+ * skipped and left out of the summary.
+ *
+ * -C calibrates the power model from the measured traces of the runs it
+ * does not skip, before validating:
+ *   idle_a, listen_a, tx_a   levels fitted as trace_states does
+ *   listen_ms, beacon_ms     median length and spacing of bursts without TX
+ *   tx_fixed_ms              median TX time per TX burst (from its charge)
+ *                            less the payload airtime of the frames the
+ *                            runs' configurations send
+ *   tx_lead_ms, tx_tail_ms   the rest of a TX burst, split as before
+ * -w saves the result for -M. The other parameters keep their values.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/sim -Ihost/trace -Icomponents/sched_core/include \
+ *       host/sim/{sim_validate,energy_sim}.c host/trace/{trace_io,trace_ops,trace_classify}.c \
+ *       components/sched_core/{sched_types,sample_codec,record_schema,sample_time}.c \
+ *       components/sched_core/{sched_queue,sched_core,frame_codec,crc32c}.c -lm -o /tmp/sim_validate
+ *
+ * Usage:
+ *   sim_validate [-m manifest] [-M model] [-C] [-w model_out] [-o dir]
+ *                [-i interval_ms] [-V volts] [-e on_a[,off_a]] [-g merge_gap_ms] [-q]
+ *
+ * -o writes each simulated trace as <dir>/<name>.sim.trc; -q prints only the summary.
+ *
+ * Example:
+ *   sim_validate -C -w /tmp/c3.model
+ *   sim_validate -M /tmp/c3.model -o /tmp/sim
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "energy_sim.h"
+#include "trace_io.h"
+#include "trace_ops.h"
+#include "trace_classify.h"
+
+#define CHUNK_SAMPLES   8192
+#define MAX_KEYS        96
+#define LINE_MAX_LEN    4096
+
+/* One burst, in samples */
+typedef struct {
+    uint64_t start;
+    uint64_t len;
+    double peak;
+    double sum;
+} burst_t;
+
+/* What is compared between a measured and a simulated trace */
+typedef struct {
+    trace_energy_t energy;
+    trace_events_t events;
+    trace_histogram_t *histogram;   // Optional, for calibration
+    burst_t *bursts;
+    size_t count;
+    size_t capacity;
+    bool failed;
+} metrics_t;
+
+typedef struct {
+    char *line;
+    const char *trace;
+    int keys;
+    const char *key[MAX_KEYS];
+    const char *value[MAX_KEYS];
+} run_t;
+
+static struct {
+    const char *manifest;
+    const char *model_path;
+    const char *model_out;
+    const char *sim_dir;
+    bool calibrate;
+    bool quiet;
+    double interval_s;
+    double voltage;
+    double event_on;
+    double event_off;
+    double merge_gap_s;
+} config = {
+    .manifest = "data/manifest.txt",
+    .voltage = 5.0,
+    .event_on = 0.035,
+    .event_off = 0.03,
+    .merge_gap_s = 1.8e-3,
+};
+
+static void on_burst(const trace_event_t *event, void *ctx)
+{
+    metrics_t *m = ctx;
+    if (m->count == m->capacity) {
+        size_t capacity = m->capacity > 0 ? m->capacity * 2 : 256;
+        burst_t *grown = realloc(m->bursts, sizeof(*grown) * capacity);
+        if (grown == NULL) {
+            m->failed = true;
+            return;
+        }
+        m->bursts = grown;
+        m->capacity = capacity;
+    }
+    m->bursts[m->count++] = (burst_t){
+        .start = event->start, .len = event->end - event->start, .peak = event->peak, .sum = event->sum,
+    };
+}
+
+static void metrics_init(metrics_t *m, double dt, trace_histogram_t *histogram)
+{
+    memset(m, 0, sizeof(*m));
+    m->histogram = histogram;
+    trace_energy_init(&m->energy);
+    trace_events_init(&m->events, config.event_on, config.event_off, (uint64_t)llround(config.merge_gap_s / dt), 0,
+                      on_burst, m);
+}
+
+static void metrics_push(const double *v, size_t n, void *ctx)
+{
+    metrics_t *m = ctx;
+    trace_energy_push(&m->energy, v, n);
+    trace_events_push(&m->events, v, n);
+    if (m->histogram != NULL) {
+        trace_histogram_push(m->histogram, v, n);
+    }
+}
+
+static void metrics_free(metrics_t *m)
+{
+    free(m->bursts);
+    m->bursts = NULL;
+}
+
+/* Simulated samples go to the metrics and optionally to a trc file */
+typedef struct {
+    metrics_t *metrics;
+    trace_writer_t *writer;
+} sim_sink_t;
+
+static void sim_sink(const double *v, size_t n, void *ctx)
+{
+    sim_sink_t *sink = ctx;
+    metrics_push(v, n, sink->metrics);
+    if (sink->writer != NULL) {
+        trace_write(sink->writer, v, n);
+    }
+}
+
+/* ---- Manifest ---- */
+
+static bool parse_line(char *line, run_t *run)
+{
+    char *hash = strchr(line, '#');
+    if (hash != NULL) {
+        *hash = '\0';
+    }
+    char *save = NULL;
+    char *tok = strtok_r(line, " \t\r\n", &save);
+    if (tok == NULL) {
+        return false;
+    }
+    run->trace = tok;
+    while ((tok = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+        char *eq = strchr(tok, '=');
+        if (eq == NULL || eq == tok || run->keys >= MAX_KEYS) {
+            continue;
+        }
+        *eq = '\0';
+        run->key[run->keys] = tok;
+        run->value[run->keys] = eq + 1;
+        run->keys++;
+    }
+    return true;
+}
+
+static run_t *read_manifest(const char *path, int *count)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return NULL;
+    }
+    run_t *runs = NULL;
+    int n = 0, capacity = 0;
+    char buf[LINE_MAX_LEN];
+    while (fgets(buf, sizeof(buf), f) != NULL) {
+        run_t run = { .line = strdup(buf) };
+        if (run.line == NULL) {
+            break;
+        }
+        if (!parse_line(run.line, &run)) {
+            free(run.line);
+            continue;
+        }
+        if (n == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 64;
+            run_t *grown = realloc(runs, sizeof(*runs) * (size_t)capacity);
+            if (grown == NULL) {
+                free(run.line);
+                break;
+            }
+            runs = grown;
+        }
+        runs[n++] = run;
+    }
+    fclose(f);
+    *count = n;
+    return runs;
+}
+
+static void run_path(const run_t *run, char *out, size_t size)
+{
+    const char *slash = strrchr(config.manifest, '/');
+    if (run->trace[0] == '/' || slash == NULL) {
+        snprintf(out, size, "%s", run->trace);
+    } else {
+        snprintf(out, size, "%.*s/%s", (int)(slash - config.manifest), config.manifest, run->trace);
+    }
+}
+
+/* Stream a measured trace; returns its sample interval or -1 */
+static double measure(const char *path, metrics_t *m, trace_histogram_t *histogram)
+{
+    static trace_reader_t reader;
+    static double chunk[CHUNK_SAMPLES];
+
+    if (trace_open(&reader, path, TRACE_FORMAT_AUTO) < 0) {
+        fprintf(stderr, "sim_validate: cannot open '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    double dt = config.interval_s > 0 ? config.interval_s :
+                reader.interval_s > 0 ? reader.interval_s : TRACE_DEFAULT_INTERVAL_S;
+
+    metrics_init(m, dt, histogram);
+    long n;
+    while ((n = trace_read(&reader, chunk, CHUNK_SAMPLES)) > 0) {
+        metrics_push(chunk, (size_t)n, m);
+    }
+    trace_events_finish(&m->events);
+    trace_close(&reader);
+    if (n < 0 || m->failed || m->energy.count == 0) {
+        fprintf(stderr, "sim_validate: cannot read '%s'\n", path);
+        metrics_free(m);
+        return -1;
+    }
+    return dt;
+}
+
+/* ---- Statistics ---- */
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static double median(double *v, size_t n)
+{
+    if (n == 0) {
+        return NAN;
+    }
+    qsort(v, n, sizeof(v[0]), compare_doubles);
+    return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+/* Two-sample Kolmogorov-Smirnov distance; both arrays sorted */
+static double ks_distance(const double *a, size_t na, const double *b, size_t nb)
+{
+    if (na == 0 || nb == 0) {
+        return na == nb ? 0.0 : 1.0;
+    }
+    size_t i = 0, j = 0;
+    double d = 0.0;
+    while (i < na && j < nb) {
+        double x = a[i] < b[j] ? a[i] : b[j];
+        while (i < na && a[i] <= x) {
+            i++;
+        }
+        while (j < nb && b[j] <= x) {
+            j++;
+        }
+        double gap = fabs((double)i / na - (double)j / nb);
+        d = gap > d ? gap : d;
+    }
+    return d;
+}
+
+/* Burst lengths and start-to-start gaps in ms, sorted */
+static void timing(const metrics_t *m, double dt, double *lengths, double *gaps)
+{
+    for (size_t i = 0; i < m->count; i++) {
+        lengths[i] = m->bursts[i].len * dt * 1e3;
+        if (i > 0) {
+            gaps[i - 1] = (m->bursts[i].start - m->bursts[i - 1].start) * dt * 1e3;
+        }
+    }
+    qsort(lengths, m->count, sizeof(double), compare_doubles);
+    if (m->count > 1) {
+        qsort(gaps, m->count - 1, sizeof(double), compare_doubles);
+    }
+}
+
+static double relative_error(double sim, double meas)
+{
+    return meas != 0 ? 100.0 * (sim - meas) / meas : (sim == 0 ? 0.0 : INFINITY);
+}
+
+static size_t tx_bursts(const metrics_t *m, double tx_threshold)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < m->count; i++) {
+        n += m->bursts[i].peak >= tx_threshold;
+    }
+    return n;
+}
+
+/* ---- Calibration ---- */
+
+static void apply_keys(sim_workload_t *w, const run_t *run, int *applied)
+{
+    sim_workload_defaults(w);
+    *applied = 0;
+    for (int k = 0; k < run->keys; k++) {
+        // The default workload is what sim_workload_defaults() already set
+        if (strcmp(run->key[k], "workload") == 0 && strcmp(run->value[k], "default") == 0) {
+            (*applied)++;
+        } else {
+            *applied += sim_workload_set(w, run->key[k], run->value[k]);
+        }
+    }
+}
+
+static int calibrate(sim_model_t *model, const run_t *runs, int run_count)
+{
+    static trace_histogram_t histogram;
+    static trace_levels_t levels;
+    static const double nominal[3] = { 0.027, 0.08, 0.25 };   // idle, listen, tx
+    double *listen_len = NULL, *listen_gap = NULL, *tx_time = NULL, *tx_rest = NULL;
+    size_t n_len = 0, n_gap = 0, n_tx = 0, capacity = 0;
+    int used = 0;
+    metrics_t *all = calloc((size_t)run_count, sizeof(*all));
+    double *dts = calloc((size_t)run_count, sizeof(*dts));
+    int status = -1;
+
+    if (all == NULL || dts == NULL) {
+        goto out;
+    }
+    trace_histogram_init(&histogram);
+    for (int r = 0; r < run_count; r++) {
+        char path[LINE_MAX_LEN];
+        sim_workload_t w;
+        int applied;
+
+        // Unconfigured runs are skipped here as in validation; their dts stay 0
+        apply_keys(&w, &runs[r], &applied);
+        if (applied == 0) {
+            continue;
+        }
+        run_path(&runs[r], path, sizeof(path));
+        dts[r] = measure(path, &all[r], &histogram);
+        if (dts[r] < 0) {
+            goto out;
+        }
+        capacity += all[r].count;
+        used++;
+    }
+    if (used == 0) {
+        fprintf(stderr, "sim_validate: no run with a configuration to calibrate from\n");
+        goto out;
+    }
+
+    if (trace_levels_fit(&levels, &histogram, 4, 1.6, 1e-4) == 0) {
+        fprintf(stderr, "sim_validate: no levels in the traces\n");
+        goto out;
+    }
+    trace_levels_label(&levels, nominal, 3);
+    // Where two levels share a name, the one holding more samples sets it
+    double *targets[3] = { &model->idle_a, &model->listen_a, &model->tx_a };
+    double share[3] = {0};
+    for (int l = 0; l < levels.count; l++) {
+        int label = levels.label[l];
+        if (levels.share[l] > share[label]) {
+            share[label] = levels.share[l];
+            *targets[label] = exp(levels.mean[l]);
+        }
+    }
+    double tx_threshold = sqrt(model->listen_a * model->tx_a);
+
+    listen_len = malloc(sizeof(double) * (capacity + 1));
+    listen_gap = malloc(sizeof(double) * (capacity + 1));
+    tx_time = malloc(sizeof(double) * (capacity + 1));
+    tx_rest = malloc(sizeof(double) * (capacity + 1));
+    if (listen_len == NULL || listen_gap == NULL || tx_time == NULL || tx_rest == NULL) {
+        goto out;
+    }
+
+    // Receive-only bursts give the wake pattern; TX bursts their charge split
+    for (int r = 0; r < run_count; r++) {
+        double dt_ms = dts[r] * 1e3;
+        const burst_t *previous = NULL;
+        for (size_t i = 0; i < all[r].count; i++) {
+            const burst_t *b = &all[r].bursts[i];
+            if (b->peak < tx_threshold) {
+                listen_len[n_len++] = b->len * dt_ms;
+                if (previous != NULL) {
+                    listen_gap[n_gap++] = (b->start - previous->start) * dt_ms;
+                }
+                previous = b;
+                continue;
+            }
+            double tx = (b->sum - b->len * model->listen_a) / (model->tx_a - model->listen_a) * dt_ms;
+            tx = tx > 0 ? tx : 0;
+            tx_time[n_tx] = tx;
+            tx_rest[n_tx++] = b->len * dt_ms - tx;
+        }
+    }
+    if (n_len > 0) {
+        model->listen_ms = median(listen_len, n_len);
+    }
+    if (n_gap > 0) {
+        model->beacon_ms = median(listen_gap, n_gap);
+    }
+
+    if (n_tx > 0) {
+        // Subtract the payload airtime of the frames the runs' configurations send
+        uint64_t frame_bytes = 0;
+        uint32_t frames = 0;
+        for (int r = 0; r < run_count; r++) {
+            sim_workload_t w;
+            sim_stats_t stats;
+            sim_model_t probe = *model;
+            metrics_t scratch;
+            int applied;
+
+            if (dts[r] == 0) {
+                continue;
+            }
+            apply_keys(&w, &runs[r], &applied);
+            metrics_init(&scratch, dts[r], NULL);
+            sim_sink_t sink = { .metrics = &scratch };
+            if (sim_run(&probe, &w, all[r].energy.count * dts[r], dts[r], sim_sink, &sink, &stats) < 0) {
+                metrics_free(&scratch);
+                goto out;
+            }
+            metrics_free(&scratch);
+            frame_bytes += stats.frame_bytes;
+            frames += stats.frames;
+        }
+        double bytes = frames > 0 ? (double)frame_bytes / frames : 0.0;
+        double payload = model->rate_mbps > 0 ? bytes * 8.0 / (model->rate_mbps * 1000.0) : 0.0;
+        double fixed = median(tx_time, n_tx) - payload;
+        model->tx_fixed_ms = fixed > 0 ? fixed : 0;
+
+        double rest = median(tx_rest, n_tx);
+        double around = model->tx_lead_ms + model->tx_tail_ms;
+        double lead_share = around > 0 ? model->tx_lead_ms / around : 0.5;
+        rest = rest > 0 ? rest : 0;
+        model->tx_lead_ms = rest * lead_share;
+        model->tx_tail_ms = rest - model->tx_lead_ms;
+    }
+
+    printf("calibration runs=%d skipped=%d levels=%d listen_bursts=%zu tx_bursts=%zu\n", used, run_count - used,
+           levels.count, n_len, n_tx);
+    status = 0;
+
+out:
+    for (int r = 0; all != NULL && r < run_count; r++) {
+        metrics_free(&all[r]);
+    }
+    free(all);
+    free(dts);
+    free(listen_len);
+    free(listen_gap);
+    free(tx_time);
+    free(tx_rest);
+    return status;
+}
+
+/* ---- Validation ---- */
+
+typedef struct {
+    int runs;
+    int skipped;                // No configuration, so not scored
+    double energy_abs_err;
+    double wakeup_abs_err;
+    double gap_ks;
+    double len_ks;
+    double worst_energy_err;
+    const char *worst;
+} summary_t;
+
+static int validate(const sim_model_t *model, const run_t *run, summary_t *summary)
+{
+    char path[LINE_MAX_LEN];
+    metrics_t meas, sim;
+    sim_workload_t w;
+    sim_stats_t stats;
+    int applied;
+
+    apply_keys(&w, run, &applied);
+    if (applied == 0) {
+        if (!config.quiet) {
+            printf("skip trace=%s reason=no_config\n", run->trace);
+        }
+        summary->skipped++;
+        return 0;
+    }
+
+    run_path(run, path, sizeof(path));
+    double dt = measure(path, &meas, NULL);
+    if (dt < 0) {
+        return -1;
+    }
+
+    trace_writer_t *writer = NULL;
+    if (config.sim_dir != NULL) {
+        char out[PATH_MAX];
+        const char *base = strrchr(run->trace, '/');
+        base = base != NULL ? base + 1 : run->trace;
+        const char *dot = strrchr(base, '.');
+        snprintf(out, sizeof(out), "%s/%.*s.sim.trc", config.sim_dir, (int)(dot != NULL ? dot - base : (long)strlen(base)),
+                 base);
+        writer = malloc(sizeof(*writer));
+        if (writer == NULL || trace_create(writer, out, dt) < 0) {
+            fprintf(stderr, "sim_validate: cannot create '%s': %s\n", out, strerror(errno));
+            free(writer);
+            writer = NULL;
+        }
+    }
+
+    metrics_init(&sim, dt, NULL);
+    sim_sink_t sink = { .metrics = &sim, .writer = writer };
+    int ret = sim_run(model, &w, meas.energy.count * dt, dt, sim_sink, &sink, &stats);
+    trace_events_finish(&sim.events);
+    if (writer != NULL) {
+        trace_finish(writer);
+        free(writer);
+    }
+    if (ret < 0 || sim.failed) {
+        fprintf(stderr, "sim_validate: simulation of '%s' failed\n", run->trace);
+        metrics_free(&meas);
+        metrics_free(&sim);
+        return -1;
+    }
+
+    size_t n_meas = meas.count, n_sim = sim.count;
+    double *buf = malloc(sizeof(double) * 2 * (n_meas + n_sim + 2));
+    if (buf == NULL) {
+        metrics_free(&meas);
+        metrics_free(&sim);
+        return -1;
+    }
+    double *len_meas = buf, *gap_meas = len_meas + n_meas + 1;
+    double *len_sim = gap_meas + n_meas + 1, *gap_sim = len_sim + n_sim + 1;
+    timing(&meas, dt, len_meas, gap_meas);
+    timing(&sim, dt, len_sim, gap_sim);
+    size_t g_meas = n_meas > 0 ? n_meas - 1 : 0, g_sim = n_sim > 0 ? n_sim - 1 : 0;
+
+    double e_meas = trace_energy_joules(&meas.energy, dt, config.voltage);
+    double e_sim = trace_energy_joules(&sim.energy, dt, config.voltage);
+    double tx_threshold = sqrt(model->listen_a * model->tx_a);
+    double energy_err = relative_error(e_sim, e_meas);
+    double wakeup_err = relative_error((double)n_sim, (double)n_meas);
+    double gap_ks = ks_distance(gap_meas, g_meas, gap_sim, g_sim);
+    double len_ks = ks_distance(len_meas, n_meas, len_sim, n_sim);
+
+    if (!config.quiet) {
+        printf("run trace=%s config_keys=%d energy_j=%.4g/%.4g energy_err=%+.1f%% wakeups=%zu/%zu wakeup_err=%+.1f%% "
+               "tx_bursts=%zu/%zu frames_sim=%u gap_p50_ms=%.1f/%.1f gap_ks=%.3f len_p50_ms=%.2f/%.2f len_ks=%.3f\n",
+               run->trace, applied, e_meas, e_sim, energy_err, n_meas, n_sim, wakeup_err,
+               tx_bursts(&meas, tx_threshold), tx_bursts(&sim, tx_threshold), stats.frames,
+               g_meas > 0 ? gap_meas[g_meas / 2] : NAN, g_sim > 0 ? gap_sim[g_sim / 2] : NAN, gap_ks,
+               n_meas > 0 ? len_meas[n_meas / 2] : NAN, n_sim > 0 ? len_sim[n_sim / 2] : NAN, len_ks);
+    }
+
+    summary->runs++;
+    summary->energy_abs_err += fabs(energy_err);
+    summary->wakeup_abs_err += fabs(wakeup_err);
+    summary->gap_ks += gap_ks;
+    summary->len_ks += len_ks;
+    if (fabs(energy_err) > fabs(summary->worst_energy_err) || summary->worst == NULL) {
+        summary->worst_energy_err = energy_err;
+        summary->worst = run->trace;
+    }
+
+    free(buf);
+    metrics_free(&meas);
+    metrics_free(&sim);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-m manifest] [-M model] [-C] [-w model_out] [-o dir]\n"
+            "          [-i interval_ms] [-V volts] [-e on_a[,off_a]] [-g merge_gap_ms] [-q]\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    sim_model_t model;
+    sim_model_defaults(&model);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:M:Cw:o:i:V:e:g:qh")) != -1) {
+        bool ok = true;
+        char *comma;
+        switch (opt) {
+            case 'm': config.manifest = optarg; break;
+            case 'M': config.model_path = optarg; break;
+            case 'C': config.calibrate = true; break;
+            case 'w': config.model_out = optarg; break;
+            case 'o': config.sim_dir = optarg; break;
+            case 'i': config.interval_s = strtod(optarg, NULL) * 1e-3; ok = config.interval_s > 0; break;
+            case 'V': config.voltage = strtod(optarg, NULL); break;
+            case 'e':
+                config.event_on = strtod(optarg, &comma);
+                config.event_off = *comma == ',' ? strtod(comma + 1, NULL) : config.event_on;
+                ok = config.event_on > 0 && config.event_off <= config.event_on;
+                break;
+            case 'g': config.merge_gap_s = strtod(optarg, NULL) * 1e-3; break;
+            case 'q': config.quiet = true; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+        if (!ok) {
+            fprintf(stderr, "sim_validate: bad value '%s' for -%c\n", optarg, opt);
+            return 2;
+        }
+    }
+    if (optind != argc) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (config.model_path != NULL && sim_model_load(&model, config.model_path) < 0) {
+        fprintf(stderr, "sim_validate: cannot load '%s': %s\n", config.model_path, strerror(errno));
+        return 1;
+    }
+
+    int run_count;
+    run_t *runs = read_manifest(config.manifest, &run_count);
+    if (runs == NULL || run_count == 0) {
+        fprintf(stderr, "sim_validate: no runs in '%s'\n", config.manifest);
+        return 1;
+    }
+
+    if (config.calibrate && calibrate(&model, runs, run_count) < 0) {
+        return 1;
+    }
+    if (config.model_out != NULL) {
+        FILE *f = fopen(config.model_out, "w");
+        if (f == NULL) {
+            fprintf(stderr, "sim_validate: cannot write '%s': %s\n", config.model_out, strerror(errno));
+            return 1;
+        }
+        sim_model_print(&model, f);
+        fclose(f);
+    }
+    if (!config.quiet) {
+        sim_model_print(&model, stdout);
+    }
+
+    summary_t summary = {0};
+    int status = 0;
+    for (int r = 0; r < run_count; r++) {
+        if (validate(&model, &runs[r], &summary) < 0) {
+            status = 1;
+        }
+    }
+    if (summary.runs > 0) {
+        printf("summary runs=%d skipped=%d energy_mape=%.1f%% wakeup_mape=%.1f%% gap_ks_mean=%.3f len_ks_mean=%.3f "
+               "worst=%s worst_energy_err=%+.1f%%\n",
+               summary.runs, summary.skipped, summary.energy_abs_err / summary.runs,
+               summary.wakeup_abs_err / summary.runs, summary.gap_ks / summary.runs, summary.len_ks / summary.runs,
+               summary.worst, summary.worst_energy_err);
+    } else {
+        printf("summary runs=0 skipped=%d: no run in the manifest has a configuration\n", summary.skipped);
+    }
+
+    for (int r = 0; r < run_count; r++) {
+        free(runs[r].line);
+    }
+    free(runs);
+    return status;
+}
@@ -0,0 +1,302 @@
+/**
+ * @file trace_classify.c
+ * @brief Unsupervised power-state classification of current traces
+ */
+
+#include <math.h>
+#include <string.h>
+#include "trace_classify.h"
+
+#define LLOYD_ITERATIONS    50
+
+static double bin_step(void)
+{
+    return log(TRACE_CLASSIFY_HI_A / TRACE_CLASSIFY_LO_A) / TRACE_CLASSIFY_BINS;
+}
+
+static double bin_center(int b)
+{
+    return log(TRACE_CLASSIFY_LO_A) + (b + 0.5) * bin_step();
+}
+
+static double log_current(double x)
+{
+    return log(x > TRACE_CLASSIFY_LO_A ? x : TRACE_CLASSIFY_LO_A);
+}
+
+void trace_histogram_init(trace_histogram_t *h)
+{
+    memset(h, 0, sizeof(*h));
+}
+
+void trace_histogram_push(trace_histogram_t *h, const double *v, size_t n)
+{
+    double lo = log(TRACE_CLASSIFY_LO_A);
+    double scale = 1.0 / bin_step();
+
+    for (size_t i = 0; i < n; i++) {
+        double b = (log_current(v[i]) - lo) * scale;
+        int bin = b < TRACE_CLASSIFY_BINS ? (int)b : TRACE_CLASSIFY_BINS - 1;
+        h->bins[bin]++;
+    }
+    h->count += n;
+}
+
+void trace_histogram_merge(trace_histogram_t *into, const trace_histogram_t *from)
+{
+    for (int b = 0; b < TRACE_CLASSIFY_BINS; b++) {
+        into->bins[b] += from->bins[b];
+    }
+    into->count += from->count;
+}
+
+/* Histogram smoothed with a 1-2-3-2-1 kernel, in samples per 5 bins (x3) */
+static void smooth(const trace_histogram_t *h, double *out)
+{
+    static const double kernel[5] = { 1, 2, 3, 2, 1 };
+
+    for (int b = 0; b < TRACE_CLASSIFY_BINS; b++) {
+        double sum = 0;
+        for (int j = -2; j <= 2; j++) {
+            if (b + j >= 0 && b + j < TRACE_CLASSIFY_BINS) {
+                sum += kernel[j + 2] * (double)h->bins[b + j];
+            }
+        }
+        out[b] = sum / 3.0;
+    }
+}
+
+/* Seed levels at the histogram modes, strongest first */
+static int find_modes(const trace_histogram_t *h, double *centers, int max_levels, double min_ratio,
+                      double min_share)
+{
+    double s[TRACE_CLASSIFY_BINS];
+    int peaks[TRACE_CLASSIFY_BINS];
+    int count = 0;
+
+    smooth(h, s);
+    for (int b = 0; b < TRACE_CLASSIFY_BINS; b++) {
+        double left = b > 0 ? s[b - 1] : 0;
+        double right = b < TRACE_CLASSIFY_BINS - 1 ? s[b + 1] : 0;
+        if (s[b] > 0 && s[b] >= left && s[b] > right && s[b] >= min_share * (double)h->count) {
+            peaks[count++] = b;
+        }
+    }
+
+    // Insertion sort by height; there are few peaks
+    for (int i = 1; i < count; i++) {
+        int p = peaks[i], j = i;
+        while (j > 0 && s[peaks[j - 1]] < s[p]) {
+            peaks[j] = peaks[j - 1];
+            j--;
+        }
+        peaks[j] = p;
+    }
+
+    int levels = 0;
+    double min_gap = log(min_ratio);
+    for (int i = 0; i < count && levels < max_levels; i++) {
+        double c = bin_center(peaks[i]);
+        bool distinct = true;
+        for (int l = 0; l < levels; l++) {
+            distinct = distinct && fabs(c - centers[l]) >= min_gap;
+        }
+        if (distinct) {
+            centers[levels++] = c;
+        }
+    }
+
+    for (int i = 1; i < levels; i++) {
+        double c = centers[i];
+        int j = i;
+        while (j > 0 && centers[j - 1] > c) {
+            centers[j] = centers[j - 1];
+            j--;
+        }
+        centers[j] = c;
+    }
+    return levels;
+}
+
+static int nearest(const double *centers, int count, double x)
+{
+    int best = 0;
+    for (int l = 1; l < count; l++) {
+        if (fabs(x - centers[l]) < fabs(x - centers[best])) {
+            best = l;
+        }
+    }
+    return best;
+}
+
+int trace_levels_fit(trace_levels_t *lv, const trace_histogram_t *h, int max_levels, double min_ratio,
+                     double min_share)
+{
+    memset(lv, 0, sizeof(*lv));
+    if (h->count == 0) {
+        return 0;
+    }
+    max_levels = max_levels < TRACE_STATES_MAX ? max_levels : TRACE_STATES_MAX;
+
+    double centers[TRACE_STATES_MAX];
+    int count = find_modes(h, centers, max_levels, min_ratio, min_share);
+
+    // Lloyd's k-means over the bins, from the modes
+    double weight[TRACE_STATES_MAX], sum[TRACE_STATES_MAX], sum_sq[TRACE_STATES_MAX];
+    for (int iter = 0; iter < LLOYD_ITERATIONS; iter++) {
+        memset(weight, 0, sizeof(weight));
+        memset(sum, 0, sizeof(sum));
+        memset(sum_sq, 0, sizeof(sum_sq));
+        for (int b = 0; b < TRACE_CLASSIFY_BINS; b++) {
+            if (h->bins[b] > 0) {
+                double c = bin_center(b), w = (double)h->bins[b];
+                int l = nearest(centers, count, c);
+                weight[l] += w;
+                sum[l] += w * c;
+                sum_sq[l] += w * c * c;
+            }
+        }
+
+        bool moved = false;
+        for (int l = 0; l < count; l++) {
+            double c = weight[l] > 0 ? sum[l] / weight[l] : centers[l];
+            moved = moved || c != centers[l];
+            centers[l] = c;
+        }
+        if (!moved) {
+            break;
+        }
+    }
+
+    // Keep the levels that still hold enough samples
+    double step = bin_step();
+    for (int l = 0; l < count; l++) {
+        double share = weight[l] / (double)h->count;
+        if (share < min_share) {
+            continue;
+        }
+        double var = sum_sq[l] / weight[l] - centers[l] * centers[l] + step * step / 12.0;
+        double sd = var > 0 ? sqrt(var) : 0;
+        lv->mean[lv->count] = centers[l];
+        lv->sd[lv->count] = sd > step / 2 ? sd : step / 2;
+        lv->share[lv->count] = share;
+        lv->label[lv->count] = lv->count;
+        lv->count++;
+    }
+    return lv->count;
+}
+
+void trace_levels_label(trace_levels_t *lv, const double *nominal_a, int count)
+{
+    double nominal[TRACE_STATES_MAX];
+
+    for (int i = 0; i < count; i++) {
+        nominal[i] = log_current(nominal_a[i]);
+    }
+    for (int l = 0; l < lv->count; l++) {
+        lv->label[l] = nearest(nominal, count, lv->mean[l]);
+    }
+}
+
+void trace_hmm_init(trace_hmm_t *op, const trace_levels_t *levels, double switch_prob)
+{
+    memset(op, 0, sizeof(*op));
+    op->levels = levels;
+    op->current = -1;
+    op->label = -1;
+    op->stay_log = log(1.0 - switch_prob);
+    op->switch_log = levels->count > 1 ? log(switch_prob / (levels->count - 1)) : -INFINITY;
+    for (int l = 0; l < levels->count; l++) {
+        op->inv_sd[l] = 1.0 / levels->sd[l];
+        op->log_sd[l] = log(levels->sd[l]);
+    }
+}
+
+static void emit(const trace_hmm_t *op, double x, double *out)
+{
+    double lx = log_current(x);
+    for (int l = 0; l < op->levels->count; l++) {
+        double z = (lx - op->levels->mean[l]) * op->inv_sd[l];
+        out[l] = -0.5 * z * z - op->log_sd[l];
+    }
+}
+
+/* Viterbi over the buffered window, then account the decoded path */
+static void decode(trace_hmm_t *op)
+{
+    int k = op->levels->count;
+    size_t n = op->used;
+    double delta[TRACE_STATES_MAX], next[TRACE_STATES_MAX], e[TRACE_STATES_MAX];
+
+    if (n == 0 || k == 0) {
+        op->used = 0;
+        return;
+    }
+
+    emit(op, op->window[0], e);
+    for (int s = 0; s < k; s++) {
+        double prior = op->current < 0 ? 0.0 : s == op->current ? op->stay_log : op->switch_log;
+        delta[s] = prior + e[s];
+    }
+    for (size_t t = 1; t < n; t++) {
+        emit(op, op->window[t], e);
+        for (int s = 0; s < k; s++) {
+            double best = -INFINITY;
+            int from = s;
+            for (int r = 0; r < k; r++) {
+                double v = delta[r] + (r == s ? op->stay_log : op->switch_log);
+                if (v > best) {
+                    best = v;
+                    from = r;
+                }
+            }
+            next[s] = best + e[s];
+            op->back[t][s] = (uint8_t)from;
+        }
+        memcpy(delta, next, sizeof(double) * (size_t)k);
+    }
+
+    int last = 0;
+    for (int s = 1; s < k; s++) {
+        if (delta[s] > delta[last]) {
+            last = s;
+        }
+    }
+    op->path[n - 1] = (uint8_t)last;
+    for (size_t t = n - 1; t > 0; t--) {
+        op->path[t - 1] = op->back[t][op->path[t]];
+    }
+
+    for (size_t t = 0; t < n; t++) {
+        int label = op->levels->label[op->path[t]];
+        op->samples[label]++;
+        op->sum[label] += op->window[t];
+        if (label != op->label) {
+            op->entries[label]++;
+            op->transitions += op->label >= 0;
+            op->label = label;
+        }
+    }
+    op->current = last;
+    op->used = 0;
+}
+
+void trace_hmm_push(trace_hmm_t *op, const double *v, size_t n)
+{
+    while (n > 0) {
+        size_t take = TRACE_CLASSIFY_WINDOW - op->used;
+        take = take < n ? take : n;
+        memcpy(op->window + op->used, v, take * sizeof(double));
+        op->used += take;
+        v += take;
+        n -= take;
+        if (op->used == TRACE_CLASSIFY_WINDOW) {
+            decode(op);
+        }
+    }
+}
+
+void trace_hmm_finish(trace_hmm_t *op)
+{
+    decode(op);
+}
@@ -0,0 +1,104 @@
+/**
+ * @file trace_classify.h
+ * @brief Unsupervised power-state classification of current traces
+ *
+ * Current levels are found in two steps. First, the modes of a
+ * log-spaced histogram of the samples seed the clusters. Second, 1-D
+ * k-means in log current refines them. Seeding from the modes keeps rare
+ * but distinct levels, such as TX bursts a few samples long, that a plain
+ * k-means would trade for splitting the dominant idle level. Each level
+ * is then named after the nearest nominal state current (sleep, idle,
+ * rx, tx by default), so a trace without light sleep has no sleep level
+ * rather than a mislabelled one.
+ *
+ * Samples are labelled by a hidden Markov model with one state per level.
+ * It uses Gaussian emissions in log current and a single switch
+ * probability, and is decoded by Viterbi over fixed windows of
+ * TRACE_CLASSIFY_WINDOW samples. Each window starts from the state the
+ * previous one ended in. The switch cost absorbs samples on the ramps
+ * between levels into their neighbours, which a fixed threshold splits
+ * into spurious short states. Labels depend only on sample positions, not
+ * on how the trace is pushed.
+ */
+
+#ifndef TRACE_CLASSIFY_H
+#define TRACE_CLASSIFY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "trace_ops.h"
+
+#define TRACE_CLASSIFY_BINS     320         // Log-spaced histogram bins...
+#define TRACE_CLASSIFY_LO_A     1e-4        // ...from this current...
+#define TRACE_CLASSIFY_HI_A     10.0        // ...to this one (64 bins per decade)
+#define TRACE_CLASSIFY_WINDOW   8192        // Samples per Viterbi decode
+
+/* Histogram of log current, mergeable across traces */
+typedef struct {
+    uint64_t bins[TRACE_CLASSIFY_BINS];
+    uint64_t count;
+} trace_histogram_t;
+
+void trace_histogram_init(trace_histogram_t *h);
+void trace_histogram_push(trace_histogram_t *h, const double *v, size_t n);
+void trace_histogram_merge(trace_histogram_t *into, const trace_histogram_t *from);
+
+/* Fitted current levels, ascending */
+typedef struct {
+    int count;
+    double mean[TRACE_STATES_MAX];      // ln(current)
+    double sd[TRACE_STATES_MAX];        // In ln(current), at least half a bin
+    double share[TRACE_STATES_MAX];     // Fraction of the samples
+    int label[TRACE_STATES_MAX];        // Nominal state of each level
+} trace_levels_t;
+
+/**
+ * @brief Find up to max_levels current levels in a histogram
+ *
+ * @param min_ratio Smallest current ratio between two levels (e.g. 1.6)
+ * @param min_share Smallest fraction of the samples a level may hold
+ * @return Levels found, 0 for an empty histogram
+ */
+int trace_levels_fit(trace_levels_t *lv, const trace_histogram_t *h, int max_levels, double min_ratio,
+                     double min_share);
+
+/**
+ * @brief Name each level after the nearest of count nominal currents (in log current)
+ */
+void trace_levels_label(trace_levels_t *lv, const double *nominal_a, int count);
+
+/* Viterbi labelling with residency and energy per nominal state */
+typedef struct {
+    const trace_levels_t *levels;
+    double stay_log;            // ln P(stay), ln P(switch to one other level)
+    double switch_log;
+    int current;                // Level the decoded path ended in, -1 before the first window
+    double inv_sd[TRACE_STATES_MAX];
+    double log_sd[TRACE_STATES_MAX];
+
+    double window[TRACE_CLASSIFY_WINDOW];
+    size_t used;
+    uint8_t back[TRACE_CLASSIFY_WINDOW][TRACE_STATES_MAX];
+    uint8_t path[TRACE_CLASSIFY_WINDOW];
+
+    // Results, indexed by nominal state
+    int label;                  // Nominal state of the last sample, -1 before the first
+    uint64_t samples[TRACE_STATES_MAX];
+    double sum[TRACE_STATES_MAX];
+    uint64_t entries[TRACE_STATES_MAX];
+    uint64_t transitions;
+} trace_hmm_t;
+
+/**
+ * @param switch_prob Probability of leaving a level at any sample
+ */
+void trace_hmm_init(trace_hmm_t *op, const trace_levels_t *levels, double switch_prob);
+void trace_hmm_push(trace_hmm_t *op, const double *v, size_t n);
+
+/**
+ * @brief Decode the samples still buffered; call once at the end of the trace
+ */
+void trace_hmm_finish(trace_hmm_t *op);
+
+#endif /* TRACE_CLASSIFY_H */
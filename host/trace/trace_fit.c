@@ -0,0 +1,224 @@
+/**
+ * @file trace_fit.c
+ * @brief Ordinary least squares with standard errors and confidence intervals
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace_fit.h"
+
+#define ALIAS_TOLERANCE     1e-9    // Residual column norm, relative to the original
+#define BETA_ITERATIONS     200
+#define QUANTILE_ITERATIONS 200
+
+/* Continued fraction of the incomplete beta function (modified Lentz) */
+static double beta_fraction(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double c = 1.0, d = 1.0 - (a + b) * x / (a + 1.0);
+
+    d = fabs(d) < tiny ? tiny : d;
+    d = 1.0 / d;
+    double h = d;
+    for (int m = 1; m <= BETA_ITERATIONS; m++) {
+        int m2 = 2 * m;
+        double aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+        d = 1.0 + aa * d;
+        d = fabs(d) < tiny ? tiny : d;
+        c = 1.0 + aa / c;
+        c = fabs(c) < tiny ? tiny : c;
+        d = 1.0 / d;
+        h *= d * c;
+
+        aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+        d = 1.0 + aa * d;
+        d = fabs(d) < tiny ? tiny : d;
+        c = 1.0 + aa / c;
+        c = fabs(c) < tiny ? tiny : c;
+        d = 1.0 / d;
+        double step = d * c;
+        h *= step;
+        if (fabs(step - 1.0) < 1e-15) {
+            break;
+        }
+    }
+    return h;
+}
+
+/* Regularized incomplete beta function I_x(a, b) */
+static double beta_regularized(double a, double b, double x)
+{
+    if (x <= 0.0) {
+        return 0.0;
+    }
+    if (x >= 1.0) {
+        return 1.0;
+    }
+    double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log1p(-x));
+    if (x < (a + 1.0) / (a + b + 2.0)) {
+        return front * beta_fraction(a, b, x) / a;
+    }
+    return 1.0 - front * beta_fraction(b, a, 1.0 - x) / b;
+}
+
+double trace_t_cdf(double t, double df)
+{
+    double tail = 0.5 * beta_regularized(df / 2.0, 0.5, df / (df + t * t));
+    return t >= 0 ? 1.0 - tail : tail;
+}
+
+double trace_t_quantile(double p, double df)
+{
+    double lo = -1.0, hi = 1.0;
+
+    while (trace_t_cdf(lo, df) > p) {
+        lo *= 2.0;
+    }
+    while (trace_t_cdf(hi, df) < p) {
+        hi *= 2.0;
+    }
+    for (int i = 0; i < QUANTILE_ITERATIONS && hi - lo > 1e-12 * fabs(hi); i++) {
+        double mid = 0.5 * (lo + hi);
+        if (trace_t_cdf(mid, df) < p) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return 0.5 * (lo + hi);
+}
+
+int trace_fit_ols(trace_fit_t *fit, const double *x, const double *y, int rows, int cols, double confidence)
+{
+    memset(fit, 0, sizeof(*fit));
+    if (cols < 1 || cols > TRACE_FIT_MAX_COLS || rows <= cols) {
+        errno = EINVAL;
+        return -1;
+    }
+    fit->rows = rows;
+    fit->cols = cols;
+
+    // Q is stored column-major, one column per fitted (non-aliased) term
+    double *q = malloc(sizeof(double) * (size_t)rows * (size_t)cols);
+    double *r = calloc((size_t)cols * (size_t)cols, sizeof(double));
+    double *rinv = calloc((size_t)cols * (size_t)cols, sizeof(double));
+    int *kept = malloc(sizeof(int) * (size_t)cols);
+    if (q == NULL || r == NULL || rinv == NULL || kept == NULL) {
+        free(q);
+        free(r);
+        free(rinv);
+        free(kept);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    // Modified Gram-Schmidt, dropping columns that add nothing
+    int k = 0;
+    for (int j = 0; j < cols; j++) {
+        double *v = q + (size_t)k * rows;
+        double norm0 = 0.0;
+        for (int i = 0; i < rows; i++) {
+            v[i] = x[(size_t)i * cols + j];
+            norm0 += v[i] * v[i];
+        }
+        for (int c = 0; c < k; c++) {
+            const double *u = q + (size_t)c * rows;
+            double dot = 0.0;
+            for (int i = 0; i < rows; i++) {
+                dot += u[i] * v[i];
+            }
+            r[c * cols + k] = dot;
+            for (int i = 0; i < rows; i++) {
+                v[i] -= dot * u[i];
+            }
+        }
+        double norm = 0.0;
+        for (int i = 0; i < rows; i++) {
+            norm += v[i] * v[i];
+        }
+        norm = sqrt(norm);
+        if (norm <= ALIAS_TOLERANCE * sqrt(norm0) || norm == 0.0) {
+            fit->aliased[j] = true;
+            for (int c = 0; c < k; c++) {
+                r[c * cols + k] = 0.0;
+            }
+            continue;
+        }
+        for (int i = 0; i < rows; i++) {
+            v[i] /= norm;
+        }
+        r[k * cols + k] = norm;
+        kept[k++] = j;
+    }
+    fit->rank = k;
+    fit->df = rows - k;
+
+    // beta = R^-1 Q^T y, by back substitution
+    double qty[TRACE_FIT_MAX_COLS], b[TRACE_FIT_MAX_COLS];
+    for (int c = 0; c < k; c++) {
+        const double *u = q + (size_t)c * rows;
+        qty[c] = 0.0;
+        for (int i = 0; i < rows; i++) {
+            qty[c] += u[i] * y[i];
+        }
+    }
+    for (int c = k - 1; c >= 0; c--) {
+        double s = qty[c];
+        for (int j = c + 1; j < k; j++) {
+            s -= r[c * cols + j] * b[j];
+        }
+        b[c] = s / r[c * cols + c];
+    }
+
+    // Residuals against the fit, and the spread of y about its mean
+    double mean = 0.0, tss = 0.0;
+    for (int i = 0; i < rows; i++) {
+        mean += y[i];
+    }
+    mean /= rows;
+    for (int i = 0; i < rows; i++) {
+        double e = y[i];
+        for (int c = 0; c < k; c++) {
+            e -= x[(size_t)i * cols + kept[c]] * b[c];
+        }
+        fit->rss += e * e;
+        tss += (y[i] - mean) * (y[i] - mean);
+    }
+    fit->sigma = fit->df > 0 ? sqrt(fit->rss / fit->df) : 0.0;
+    fit->r2 = tss > 0 ? 1.0 - fit->rss / tss : 1.0;
+    fit->adj_r2 = fit->df > 0 && rows > 1 ? 1.0 - (1.0 - fit->r2) * (rows - 1) / fit->df : fit->r2;
+
+    // Cov(beta) = sigma^2 R^-1 R^-T
+    for (int c = k - 1; c >= 0; c--) {
+        rinv[c * cols + c] = 1.0 / r[c * cols + c];
+        for (int j = c + 1; j < k; j++) {
+            double s = 0.0;
+            for (int m = c + 1; m <= j; m++) {
+                s += r[c * cols + m] * rinv[m * cols + j];
+            }
+            rinv[c * cols + j] = -s / r[c * cols + c];
+        }
+    }
+    double crit = fit->df > 0 ? trace_t_quantile(0.5 + confidence / 2.0, fit->df) : NAN;
+    for (int c = 0; c < k; c++) {
+        double row = 0.0;
+        for (int j = c; j < k; j++) {
+            row += rinv[c * cols + j] * rinv[c * cols + j];
+        }
+        int j = kept[c];
+        fit->beta[j] = b[c];
+        fit->se[j] = fit->sigma * sqrt(row);
+        fit->ci_lo[j] = b[c] - crit * fit->se[j];
+        fit->ci_hi[j] = b[c] + crit * fit->se[j];
+        fit->t[j] = fit->se[j] > 0 ? b[c] / fit->se[j] : INFINITY;
+        fit->p[j] = fit->df > 0 ? 2.0 * (1.0 - trace_t_cdf(fabs(fit->t[j]), fit->df)) : NAN;
+    }
+
+    free(q);
+    free(r);
+    free(rinv);
+    free(kept);
+    return 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file trace_fit.h
+ * @brief Ordinary least squares with standard errors and confidence intervals
+ *
+ * Small dense fits of experiment-level responses (energy per run) against
+ * a handful of factors. The design matrix is factored by modified
+ * Gram-Schmidt. A column that is, to rounding, a combination of earlier
+ * ones is marked aliased and left out instead of making the fit singular.
+ * Intervals and p-values use Student's t with rows - rank degrees of
+ * freedom.
+ */
+
+#ifndef TRACE_FIT_H
+#define TRACE_FIT_H
+
+#include <stdbool.h>
+
+#define TRACE_FIT_MAX_COLS  64
+
+typedef struct {
+    int rows;
+    int cols;
+    int rank;                   // Columns actually fitted
+    int df;                     // rows - rank
+    bool aliased[TRACE_FIT_MAX_COLS];
+
+    // Per column; zero for aliased columns
+    double beta[TRACE_FIT_MAX_COLS];
+    double se[TRACE_FIT_MAX_COLS];
+    double ci_lo[TRACE_FIT_MAX_COLS];
+    double ci_hi[TRACE_FIT_MAX_COLS];
+    double t[TRACE_FIT_MAX_COLS];
+    double p[TRACE_FIT_MAX_COLS];   // Two-sided, for beta == 0
+
+    double rss;                 // Residual sum of squares
+    double r2;                  // Against the mean of y; the design should hold an intercept
+    double adj_r2;
+    double sigma;               // Residual standard error
+} trace_fit_t;
+
+/**
+ * @brief Fit y ~ x by least squares
+ *
+ * @param x rows x cols design matrix, row-major
+ * @param confidence Interval coverage, e.g. 0.95
+ * @return 0 on success, -1 with errno set (EINVAL for too few rows or
+ *         columns, ENOMEM)
+ */
+int trace_fit_ols(trace_fit_t *fit, const double *x, const double *y, int rows, int cols, double confidence);
+
+/**
+ * @brief Student's t distribution function with df degrees of freedom
+ */
+double trace_t_cdf(double t, double df);
+
+/**
+ * @brief Inverse of trace_t_cdf() for 0 < p < 1
+ */
+double trace_t_quantile(double p, double df);
+
+#endif /* TRACE_FIT_H */
@@ -0,0 +1,373 @@
+/**
+ * @file trace_io.c
+ * @brief Chunked reading and writing of current traces
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "trace_io.h"
+
+static const char *const format_names[] = {
+    [TRACE_FORMAT_AUTO] = "auto",
+    [TRACE_FORMAT_CSV] = "csv",
+    [TRACE_FORMAT_TRC] = "trc",
+    [TRACE_FORMAT_F32] = "f32",
+};
+
+bool trace_format_from_option(const char *option, trace_format_t *format)
+{
+    for (size_t i = 0; i < sizeof(format_names) / sizeof(format_names[0]); i++) {
+        if (strcmp(option, format_names[i]) == 0) {
+            *format = (trace_format_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *trace_format_name(trace_format_t format)
+{
+    return (unsigned)format < sizeof(format_names) / sizeof(format_names[0]) ? format_names[format] : "?";
+}
+
+/* Refill the buffer, keeping unread bytes; false at end of file or on error */
+static bool fill(trace_reader_t *r)
+{
+    if (r->eof) {
+        return false;
+    }
+    if (r->pos > 0) {
+        memmove(r->buf, r->buf + r->pos, r->len - r->pos);
+        r->len -= r->pos;
+        r->pos = 0;
+    }
+
+    while (r->len < sizeof(r->buf)) {
+        ssize_t n = read(r->fd, r->buf + r->len, sizeof(r->buf) - r->len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            r->eof = true;
+            return n == 0 ? r->len > 0 : false;
+        }
+        r->len += (size_t)n;
+        r->bytes += (uint64_t)n;
+        break;  // Hand over what arrived; pipes deliver in pieces
+    }
+    return true;
+}
+
+static bool ends_with(const char *s, const char *suffix)
+{
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+int trace_open(trace_reader_t *r, const char *path, trace_format_t format)
+{
+    memset(r, 0, sizeof(*r));
+    r->remaining = UINT64_MAX;
+
+    if (strcmp(path, "-") == 0) {
+        r->fd = STDIN_FILENO;
+    } else {
+        r->fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (r->fd < 0) {
+            return -1;
+        }
+        r->owned = true;
+        posix_fadvise(r->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    // Read until the magic can be checked or the input ends
+    while (r->len < sizeof(trace_header_t) && !r->eof) {
+        fill(r);
+    }
+
+    uint32_t magic = 0;
+    if (r->len >= sizeof(magic)) {
+        memcpy(&magic, r->buf, sizeof(magic));
+    }
+    if (format == TRACE_FORMAT_AUTO) {
+        format = magic == TRACE_MAGIC ? TRACE_FORMAT_TRC :
+                 ends_with(path, ".f32") ? TRACE_FORMAT_F32 : TRACE_FORMAT_CSV;
+    }
+    r->format = format;
+
+    if (format == TRACE_FORMAT_TRC) {
+        trace_header_t header;
+        if (r->len < sizeof(header)) {
+            trace_close(r);
+            errno = EINVAL;
+            return -1;
+        }
+        memcpy(&header, r->buf, sizeof(header));
+        if (header.magic != TRACE_MAGIC || header.version != TRACE_VERSION || !(header.interval_s > 0)) {
+            trace_close(r);
+            errno = EINVAL;
+            return -1;
+        }
+        r->interval_s = header.interval_s;
+        r->remaining = header.count > 0 ? header.count : UINT64_MAX;
+        r->pos = sizeof(header);
+    }
+    return 0;
+}
+
+static long read_binary(trace_reader_t *r, double *out, size_t max)
+{
+    size_t n = 0;
+
+    if (max > r->remaining) {
+        max = (size_t)r->remaining;
+    }
+    while (n < max) {
+        if (r->len - r->pos < sizeof(float) && !fill(r)) {
+            break;
+        }
+        size_t avail = (r->len - r->pos) / sizeof(float);
+        if (avail == 0) {
+            if (r->eof) {
+                break;  // Trailing partial sample
+            }
+            continue;
+        }
+        size_t take = avail < max - n ? avail : max - n;
+        const uint8_t *p = r->buf + r->pos;
+        for (size_t i = 0; i < take; i++) {
+            float f;
+            memcpy(&f, p + i * sizeof(float), sizeof(f));
+            out[n + i] = f;
+        }
+        n += take;
+        r->pos += take * sizeof(float);
+    }
+
+    if (r->remaining != UINT64_MAX) {
+        r->remaining -= n;
+    }
+    return (long)n;
+}
+
+static bool is_separator(uint8_t c)
+{
+    return c == ',' || c == ';' || c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/*
+ * Exact fast path for plain decimals such as "+2.71416002e-02": with at
+ * most 15 significant digits and a power of ten up to 1e22, one multiply
+ * or divide of two exactly representable doubles rounds correctly.
+ * Returns false to fall back to strtod().
+ */
+static bool parse_decimal(const char *s, size_t len, double *value)
+{
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    const char *p = s, *end = s + len;
+    bool negative = false;
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p++ == '-';
+    }
+    const char *start = p;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (mantissa != 0 || *p != '0') {
+            digits++;
+        }
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (mantissa != 0 || *p != '0') {
+                digits++;
+            }
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            exponent--;
+        }
+    }
+    if (p == start || (p == start + 1 && *start == '.') || digits > 15) {
+        return false;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool exp_negative = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            exp_negative = *p++ == '-';
+        }
+        int e = 0;
+        const char *exp_start = p;
+        for (; p < end && *p >= '0' && *p <= '9' && e < 1000; p++) {
+            e = e * 10 + (*p - '0');
+        }
+        if (p == exp_start) {
+            return false;
+        }
+        exponent += exp_negative ? -e : e;
+    }
+    if (p != end || exponent < -22 || exponent > 22) {
+        return false;
+    }
+
+    double m = (double)mantissa;
+    double v = exponent < 0 ? m / pow10[-exponent] : m * pow10[exponent];
+    *value = negative ? -v : v;
+    return true;
+}
+
+/* Convert the assembled token; false if it is not a number */
+static bool finish_token(trace_reader_t *r, double *value)
+{
+    bool ok = !r->token_overflow;
+    if (ok && !parse_decimal(r->token, r->token_len, value)) {
+        char *end;
+        r->token[r->token_len] = '\0';
+        *value = strtod(r->token, &end);
+        ok = end == r->token + r->token_len;
+    }
+    if (!ok) {
+        r->bad_tokens++;
+    }
+    r->token_len = 0;
+    r->token_overflow = false;
+    return ok;
+}
+
+static long read_csv(trace_reader_t *r, double *out, size_t max)
+{
+    size_t n = 0;
+
+    while (n < max) {
+        if (r->pos == r->len && !fill(r)) {
+            // End of input ends the last number
+            if (r->token_len > 0 || r->token_overflow) {
+                if (finish_token(r, &out[n])) {
+                    n++;
+                }
+            }
+            break;
+        }
+
+        const uint8_t *p = r->buf + r->pos;
+        const uint8_t *end = r->buf + r->len;
+        while (p < end && n < max) {
+            uint8_t c = *p++;
+            if (!is_separator(c)) {
+                if (r->token_len < TRACE_TOKEN_MAX - 1) {
+                    r->token[r->token_len++] = (char)c;
+                } else {
+                    r->token_overflow = true;
+                }
+            } else if (r->token_len > 0 || r->token_overflow) {
+                if (finish_token(r, &out[n])) {
+                    n++;
+                }
+            }
+        }
+        r->pos = (size_t)(p - r->buf);
+    }
+    return (long)n;
+}
+
+long trace_read(trace_reader_t *r, double *out, size_t max)
+{
+    long n = r->format == TRACE_FORMAT_CSV ? read_csv(r, out, max) : read_binary(r, out, max);
+    r->samples += (uint64_t)n;
+    return n;
+}
+
+void trace_close(trace_reader_t *r)
+{
+    if (r->owned && r->fd >= 0) {
+        close(r->fd);
+    }
+    r->fd = -1;
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int trace_create(trace_writer_t *w, const char *path, double interval_s)
+{
+    memset(w, 0, sizeof(*w));
+
+    if (strcmp(path, "-") == 0) {
+        w->fd = STDOUT_FILENO;
+    } else {
+        w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (w->fd < 0) {
+            return -1;
+        }
+        w->owned = true;
+    }
+
+    trace_header_t header = { .magic = TRACE_MAGIC, .version = TRACE_VERSION, .interval_s = interval_s };
+    if (write_all(w->fd, &header, sizeof(header)) < 0) {
+        int err = errno;
+        if (w->owned) {
+            close(w->fd);
+        }
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+static int flush_writer(trace_writer_t *w)
+{
+    int ret = write_all(w->fd, w->buf, w->used * sizeof(float));
+    w->used = 0;
+    return ret;
+}
+
+int trace_write(trace_writer_t *w, const double *samples, size_t count)
+{
+    const size_t cap = sizeof(w->buf) / sizeof(w->buf[0]);
+
+    for (size_t i = 0; i < count; i++) {
+        w->buf[w->used++] = (float)samples[i];
+        if (w->used == cap && flush_writer(w) < 0) {
+            return -1;
+        }
+    }
+    w->count += count;
+    return 0;
+}
+
+int trace_finish(trace_writer_t *w)
+{
+    int ret = flush_writer(w);
+
+    // Patch the count in when the output can seek; a pipe keeps 0 (unknown)
+    if (ret == 0 && lseek(w->fd, offsetof(trace_header_t, count), SEEK_SET) >= 0) {
+        ret = write_all(w->fd, &w->count, sizeof(w->count));
+    }
+
+    if (w->owned && close(w->fd) < 0) {
+        ret = -1;
+    }
+    w->fd = -1;
+    return ret;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file trace_io.h
+ * @brief Chunked reading and writing of current traces
+ *
+ * A trace is a sequence of current samples in amperes taken at a fixed
+ * interval (0.6 ms for the captures in data/). Three encodings are read:
+ *
+ *   csv   text numbers separated by commas, semicolons or whitespace, as
+ *         written by the bench supply ("+2.71416002e-02,+2.66484906e-02,...")
+ *   trc   a trace_header_t followed by little-endian float32 samples
+ *   f32   bare little-endian float32 samples
+ *
+ * Input is read through a fixed buffer, so memory use does not depend on
+ * the trace length, and "-" reads stdin. TRACE_FORMAT_AUTO recognizes trc
+ * by its magic, f32 by the ".f32" extension and takes anything else as csv.
+ */
+
+#ifndef TRACE_IO_H
+#define TRACE_IO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TRACE_MAGIC              0x31435254u    // "TRC1"
+#define TRACE_VERSION            1
+#define TRACE_DEFAULT_INTERVAL_S 0.6e-3         // Bench supply sample interval
+#define TRACE_IO_BUF             65536          // Read buffer bytes
+#define TRACE_TOKEN_MAX          64             // Longer csv tokens are counted as bad
+
+typedef enum {
+    TRACE_FORMAT_AUTO,
+    TRACE_FORMAT_CSV,
+    TRACE_FORMAT_TRC,
+    TRACE_FORMAT_F32,
+} trace_format_t;
+
+/* Header of a trc file */
+typedef struct {
+    uint32_t magic;             // TRACE_MAGIC
+    uint32_t version;           // TRACE_VERSION
+    double interval_s;          // Sample interval
+    uint64_t count;             // Samples that follow, 0 if unknown (read to end of file)
+} trace_header_t;
+
+typedef struct {
+    int fd;
+    bool owned;                 // Close fd in trace_close()
+    trace_format_t format;
+    double interval_s;          // From a trc header, 0 otherwise
+    uint64_t remaining;         // Samples left per the trc header, UINT64_MAX if unknown
+
+    uint8_t buf[TRACE_IO_BUF];
+    size_t pos;
+    size_t len;
+    bool eof;
+
+    char token[TRACE_TOKEN_MAX];  // csv number being assembled across reads
+    size_t token_len;
+    bool token_overflow;
+
+    // Statistics
+    uint64_t samples;
+    uint64_t bytes;
+    uint64_t bad_tokens;        // csv tokens that are not numbers
+} trace_reader_t;
+
+typedef struct {
+    int fd;
+    bool owned;
+    uint64_t count;
+    float buf[TRACE_IO_BUF / sizeof(float)];
+    size_t used;
+} trace_writer_t;
+
+/**
+ * @brief Parse "auto", "csv", "trc" or "f32"
+ */
+bool trace_format_from_option(const char *option, trace_format_t *format);
+
+const char *trace_format_name(trace_format_t format);
+
+/**
+ * @brief Open a trace file, or stdin for "-"
+ *
+ * @return 0 on success, -1 with errno set on failure
+ */
+int trace_open(trace_reader_t *r, const char *path, trace_format_t format);
+
+/**
+ * @brief Read up to max samples
+ *
+ * @return Samples read, 0 at the end of the trace, -1 with errno set on error
+ */
+long trace_read(trace_reader_t *r, double *out, size_t max);
+
+void trace_close(trace_reader_t *r);
+
+/**
+ * @brief Create a trc file, or write to stdout for "-"
+ *
+ * @return 0 on success, -1 with errno set on failure
+ */
+int trace_create(trace_writer_t *w, const char *path, double interval_s);
+
+int trace_write(trace_writer_t *w, const double *samples, size_t count);
+
+/**
+ * @brief Flush, record the sample count in the header if the file is seekable, and close
+ *
+ * @return 0 on success, -1 with errno set on failure
+ */
+int trace_finish(trace_writer_t *w);
+
+#endif /* TRACE_IO_H */
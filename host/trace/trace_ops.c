@@ -0,0 +1,199 @@
+/**
+ * @file trace_ops.c
+ * @brief Single-pass streaming operators over current traces
+ */
+
+#include <math.h>
+#include <string.h>
+#include "trace_ops.h"
+
+void trace_energy_init(trace_energy_t *op)
+{
+    *op = (trace_energy_t) { .min = INFINITY, .max = -INFINITY };
+}
+
+void trace_energy_push(trace_energy_t *op, const double *v, size_t n)
+{
+    double sum = 0.0, sum_sq = 0.0, lo = op->min, hi = op->max;
+
+    for (size_t i = 0; i < n; i++) {
+        double x = v[i];
+        sum += x;
+        sum_sq += x * x;
+        lo = x < lo ? x : lo;
+        hi = x > hi ? x : hi;
+    }
+    op->count += n;
+    op->sum += sum;
+    op->sum_sq += sum_sq;
+    op->min = lo;
+    op->max = hi;
+}
+
+double trace_energy_joules(const trace_energy_t *op, double interval_s, double voltage)
+{
+    return op->sum * interval_s * voltage;
+}
+
+void trace_threshold_init(trace_threshold_t *op, double threshold)
+{
+    *op = (trace_threshold_t) { .threshold = threshold };
+}
+
+void trace_threshold_push(trace_threshold_t *op, const double *v, size_t n)
+{
+    uint64_t high = 0;
+    double low_sum = 0.0, high_sum = 0.0;
+
+    for (size_t i = 0; i < n; i++) {
+        double x = v[i];
+        bool above = x > op->threshold;
+        high += above;
+        high_sum += above ? x : 0.0;
+        low_sum += above ? 0.0 : x;
+    }
+    op->high_count += high;
+    op->high_sum += high_sum;
+    op->low_count += n - high;
+    op->low_sum += low_sum;
+}
+
+double trace_threshold_baseline(const trace_threshold_t *op)
+{
+    return op->low_count > 0 ? op->low_sum / op->low_count : NAN;
+}
+
+double trace_threshold_joules(const trace_threshold_t *op, double interval_s, double voltage)
+{
+    double baseline = op->low_count > 0 ? op->low_sum / op->low_count : 0.0;
+    return (op->high_sum - op->high_count * baseline) * interval_s * voltage;
+}
+
+void trace_events_init(trace_events_t *op, double on, double off, uint64_t merge_gap, uint64_t min_len,
+                       trace_event_cb_t cb, void *ctx)
+{
+    *op = (trace_events_t) {
+        .on = on,
+        .off = off < on ? off : on,
+        .merge_gap = merge_gap,
+        .min_len = min_len,
+        .cb = cb,
+        .ctx = ctx,
+        .gap_min = UINT64_MAX,
+    };
+}
+
+/* Hand a finished burst to the statistics and the callback */
+static void report_event(trace_events_t *op)
+{
+    const trace_event_t *e = &op->event;
+    uint64_t len = e->end - e->start;
+
+    if (len < op->min_len) {
+        return;
+    }
+    if (op->events > 0) {
+        uint64_t gap = e->start - op->last_end;
+        op->gap_count++;
+        op->gap_total += gap;
+        op->gap_min = gap < op->gap_min ? gap : op->gap_min;
+        op->gap_max = gap > op->gap_max ? gap : op->gap_max;
+    }
+    op->events++;
+    op->active_samples += len;
+    op->active_sum += e->sum;
+    op->len_max = len > op->len_max ? len : op->len_max;
+    op->last_end = e->end;
+
+    if (op->cb != NULL) {
+        op->cb(e, op->ctx);
+    }
+}
+
+void trace_events_push(trace_events_t *op, const double *v, size_t n)
+{
+    for (size_t i = 0; i < n; i++, op->index++) {
+        double x = v[i];
+
+        if (op->active) {
+            if (x > op->off) {
+                op->event.sum += x;
+                op->event.peak = x > op->event.peak ? x : op->event.peak;
+                continue;
+            }
+            op->active = false;
+            op->pending = true;
+            op->event.end = op->index;
+            op->gap_sum = x;
+            continue;
+        }
+
+        if (op->pending && op->index - op->event.end >= op->merge_gap) {
+            report_event(op);
+            op->pending = false;
+        }
+        if (x > op->on) {
+            if (op->pending) {
+                // Join the previous burst; the gap becomes part of it
+                op->event.sum += op->gap_sum;
+                op->pending = false;
+            } else {
+                op->event = (trace_event_t) { .start = op->index, .peak = x };
+            }
+            op->active = true;
+            op->event.sum += x;
+            op->event.peak = x > op->event.peak ? x : op->event.peak;
+        } else if (op->pending) {
+            op->gap_sum += x;
+        }
+    }
+}
+
+void trace_events_finish(trace_events_t *op)
+{
+    if (op->active) {
+        op->event.end = op->index;
+        op->active = false;
+        op->pending = true;
+    }
+    if (op->pending) {
+        report_event(op);
+        op->pending = false;
+    }
+}
+
+bool trace_residency_init(trace_residency_t *op, int count, const double *upper, const char *const *names)
+{
+    if (count < 1 || count > TRACE_STATES_MAX) {
+        return false;
+    }
+    memset(op, 0, sizeof(*op));
+    op->count = count;
+    op->current = -1;
+    for (int i = 0; i < count; i++) {
+        op->upper[i] = i < count - 1 ? upper[i] : INFINITY;
+        op->names[i] = names != NULL ? names[i] : NULL;
+        if (i > 0 && !(op->upper[i] > op->upper[i - 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void trace_residency_push(trace_residency_t *op, const double *v, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        double x = v[i];
+        int s = 0;
+        while (s < op->count - 1 && !(x < op->upper[s])) {
+            s++;
+        }
+        op->samples[s]++;
+        op->sum[s] += x;
+        if (s != op->current) {
+            op->entries[s]++;
+            op->transitions += op->current >= 0;
+            op->current = s;
+        }
+    }
+}
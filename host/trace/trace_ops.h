@@ -0,0 +1,127 @@
+/**
+ * @file trace_ops.h
+ * @brief Single-pass streaming operators over current traces
+ *
+ * Every operator keeps a fixed amount of state, takes samples in chunks
+ * of any size through its _push() function and gives the same result
+ * however the trace is split. Sample positions are counted from the first
+ * push, so times are index * interval.
+ *
+ *   trace_energy_t     count, mean, min/max, charge and total energy
+ *   trace_threshold_t  plot.py's split: baseline current below a threshold
+ *                      and the energy above it
+ *   trace_events_t     activity bursts segmented with hysteresis, merged
+ *                      across short gaps and reported through a callback
+ *   trace_residency_t  time, energy and entries per current band (state)
+ */
+
+#ifndef TRACE_OPS_H
+#define TRACE_OPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TRACE_STATES_MAX  8
+
+/* Energy and basic statistics */
+typedef struct {
+    uint64_t count;
+    double sum;                 // Sum of samples (A), i.e. charge / interval
+    double sum_sq;
+    double min;
+    double max;
+} trace_energy_t;
+
+void trace_energy_init(trace_energy_t *op);
+void trace_energy_push(trace_energy_t *op, const double *v, size_t n);
+
+/* Energy in joules at a supply voltage */
+double trace_energy_joules(const trace_energy_t *op, double interval_s, double voltage);
+
+/* Split at a fixed threshold, as data/plot.py did */
+typedef struct {
+    double threshold;
+    uint64_t low_count;         // Samples <= threshold
+    double low_sum;
+    uint64_t high_count;
+    double high_sum;
+} trace_threshold_t;
+
+void trace_threshold_init(trace_threshold_t *op, double threshold);
+void trace_threshold_push(trace_threshold_t *op, const double *v, size_t n);
+
+/* Mean current at or below the threshold (the CPU baseline) */
+double trace_threshold_baseline(const trace_threshold_t *op);
+
+/* Energy above the baseline in samples over the threshold (radio listen and TX) */
+double trace_threshold_joules(const trace_threshold_t *op, double interval_s, double voltage);
+
+/* One activity burst */
+typedef struct {
+    uint64_t start;             // First sample index
+    uint64_t end;               // One past the last sample
+    double peak;                // Highest sample
+    double sum;                 // Sum of samples, charge / interval
+} trace_event_t;
+
+typedef void (*trace_event_cb_t)(const trace_event_t *event, void *ctx);
+
+/* Burst segmentation with hysteresis */
+typedef struct {
+    // Configuration
+    double on;                  // A burst starts above this current
+    double off;                 // and ends at or below this one
+    uint64_t merge_gap;         // Bursts closer than this many samples are joined
+    uint64_t min_len;           // Shorter bursts are dropped
+    trace_event_cb_t cb;        // Optional, called for every reported burst
+    void *ctx;
+
+    // State
+    uint64_t index;
+    bool active;                // Inside a burst
+    bool pending;               // A closed burst that may still be joined
+    trace_event_t event;
+    double gap_sum;             // Samples since the pending burst closed
+
+    // Statistics of reported bursts
+    uint64_t events;
+    uint64_t active_samples;
+    double active_sum;
+    uint64_t len_max;
+    uint64_t gap_count;         // Gaps between consecutive bursts
+    uint64_t gap_total;
+    uint64_t gap_min;
+    uint64_t gap_max;
+    uint64_t last_end;
+} trace_events_t;
+
+void trace_events_init(trace_events_t *op, double on, double off, uint64_t merge_gap, uint64_t min_len,
+                       trace_event_cb_t cb, void *ctx);
+void trace_events_push(trace_events_t *op, const double *v, size_t n);
+
+/* Report the burst still open at the end of the trace */
+void trace_events_finish(trace_events_t *op);
+
+/* Residency per current band: state i holds samples below upper[i] */
+typedef struct {
+    int count;
+    double upper[TRACE_STATES_MAX];     // Ascending; the last band is unbounded
+    const char *names[TRACE_STATES_MAX];
+
+    int current;                // State of the last sample, -1 before the first
+    uint64_t transitions;
+    uint64_t samples[TRACE_STATES_MAX];
+    double sum[TRACE_STATES_MAX];
+    uint64_t entries[TRACE_STATES_MAX]; // Times the state was entered
+} trace_residency_t;
+
+/**
+ * @brief Set up count bands from count - 1 ascending upper bounds
+ *
+ * @return false if count is out of range or the bounds are not ascending
+ */
+bool trace_residency_init(trace_residency_t *op, int count, const double *upper, const char *const *names);
+void trace_residency_push(trace_residency_t *op, const double *v, size_t n);
+
+#endif /* TRACE_OPS_H */
@@ -0,0 +1,428 @@
+/**
+ * @file trace_pyramid.c
+ * @brief Zoom pyramid of a trace: min/max envelopes and LTTB points per level
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trace_io.h"
+#include "trace_pyramid.h"
+
+/* State of one build, shared by the workers */
+typedef struct {
+    const float *samples;
+    uint64_t count;
+    uint32_t fanout;
+    uint32_t levels;
+    trace_pyramid_level_t table[TRACE_PYRAMID_LEVELS];
+    trace_pyramid_bucket_t *buckets[TRACE_PYRAMID_LEVELS];
+
+    // Current phase
+    uint32_t level;
+    void (*work)(const void *build, uint32_t level, uint64_t first, uint64_t end);
+    uint64_t segments;
+    uint64_t next_segment;      // Claimed atomically
+} build_t;
+
+static int map_file(const char *path, trace_map_t *map)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+    map->len = (size_t)st.st_size;
+    map->addr = map->len > 0 ? mmap(NULL, map->len, PROT_READ, MAP_SHARED, fd, 0) : NULL;
+    close(fd);
+
+    if (map->addr == MAP_FAILED || map->addr == NULL) {
+        map->addr = NULL;
+        if (map->len == 0) {
+            errno = EINVAL;
+        }
+        return -1;
+    }
+    return 0;
+}
+
+void trace_unmap(trace_map_t *map)
+{
+    if (map->addr != NULL) {
+        munmap((void *)map->addr, map->len);
+        map->addr = NULL;
+    }
+}
+
+int trace_map_samples(const char *path, trace_map_t *map, const float **samples, uint64_t *count,
+                      double *interval_s)
+{
+    if (map_file(path, map) < 0) {
+        return -1;
+    }
+
+    trace_header_t header;
+    size_t n = strlen(path);
+    if (map->len >= sizeof(header) && memcpy(&header, map->addr, sizeof(header)) &&
+        header.magic == TRACE_MAGIC && header.version == TRACE_VERSION) {
+        uint64_t stored = (map->len - sizeof(header)) / sizeof(float);
+        *samples = (const float *)((const uint8_t *)map->addr + sizeof(header));
+        *count = header.count > 0 && header.count < stored ? header.count : stored;
+        *interval_s = header.interval_s;
+        return 0;
+    }
+    if (n >= 4 && strcmp(path + n - 4, ".f32") == 0) {
+        *samples = map->addr;
+        *count = map->len / sizeof(float);
+        *interval_s = 0;
+        return 0;
+    }
+
+    trace_unmap(map);
+    errno = EINVAL;     // Text traces must be converted to trc first
+    return -1;
+}
+
+/* ---- Building ---- */
+
+static uint64_t bucket_samples_of(const build_t *b, uint32_t level, uint64_t bucket)
+{
+    uint64_t size = b->table[level].bucket_samples;
+    uint64_t start = bucket * size;
+    return b->count - start < size ? b->count - start : size;
+}
+
+/* Centre of a bucket on the sample axis */
+static double bucket_center(const build_t *b, uint32_t level, uint64_t bucket)
+{
+    return (double)(bucket * b->table[level].bucket_samples) +
+           (double)(bucket_samples_of(b, level, bucket) - 1) / 2.0;
+}
+
+/* Envelope and mean of level 0 buckets, straight from the samples */
+static void envelope_base(const void *ctx, uint32_t level, uint64_t first, uint64_t end)
+{
+    const build_t *b = ctx;
+    trace_pyramid_bucket_t *out = b->buckets[level];
+
+    for (uint64_t k = first; k < end; k++) {
+        uint64_t start = k * b->fanout;
+        uint64_t n = bucket_samples_of(b, level, k);
+        const float *s = b->samples + start;
+        float lo = s[0], hi = s[0];
+        double sum = 0.0;
+        for (uint64_t i = 0; i < n; i++) {
+            lo = s[i] < lo ? s[i] : lo;
+            hi = s[i] > hi ? s[i] : hi;
+            sum += s[i];
+        }
+        out[k].min = lo;
+        out[k].max = hi;
+        out[k].mean = (float)(sum / (double)n);
+    }
+}
+
+/* Envelope and mean of upper level buckets, from the level below */
+static void envelope_upper(const void *ctx, uint32_t level, uint64_t first, uint64_t end)
+{
+    const build_t *b = ctx;
+    const trace_pyramid_bucket_t *below = b->buckets[level - 1];
+    uint64_t below_count = b->table[level - 1].buckets;
+    trace_pyramid_bucket_t *out = b->buckets[level];
+
+    for (uint64_t k = first; k < end; k++) {
+        uint64_t c0 = k * b->fanout;
+        uint64_t c1 = c0 + b->fanout < below_count ? c0 + b->fanout : below_count;
+        float lo = below[c0].min, hi = below[c0].max;
+        double sum = 0.0, n = 0.0;
+        for (uint64_t c = c0; c < c1; c++) {
+            double weight = (double)bucket_samples_of(b, level - 1, c);
+            lo = below[c].min < lo ? below[c].min : lo;
+            hi = below[c].max > hi ? below[c].max : hi;
+            sum += below[c].mean * weight;
+            n += weight;
+        }
+        out[k].min = lo;
+        out[k].max = hi;
+        out[k].mean = (float)(sum / n);
+    }
+}
+
+/* Twice the area of the triangle (ax, ay), (bx, by), (cx, cy) */
+static double triangle_area(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    double area = (ax - cx) * (by - ay) - (ax - bx) * (cy - ay);
+    return area < 0 ? -area : area;
+}
+
+/*
+ * LTTB over a segment of buckets. Level 0 picks among the bucket's samples,
+ * upper levels among the points chosen by their child buckets.
+ */
+static void lttb_segment(const void *ctx, uint32_t level, uint64_t first, uint64_t end)
+{
+    const build_t *b = ctx;
+    trace_pyramid_bucket_t *out = b->buckets[level];
+    uint64_t count = b->table[level].buckets;
+    double ax, ay;
+
+    // A segment starts from the previous bucket's mean, known before any choice
+    if (first == 0) {
+        ax = 0.0;
+        ay = b->samples[0];
+    } else {
+        ax = bucket_center(b, level, first - 1);
+        ay = out[first - 1].mean;
+    }
+
+    for (uint64_t k = first; k < end; k++) {
+        double cx, cy;
+        if (k + 1 < count) {
+            cx = bucket_center(b, level, k + 1);
+            cy = out[k + 1].mean;
+        } else {
+            cx = (double)(b->count - 1);
+            cy = b->samples[b->count - 1];
+        }
+
+        double best = -1.0;
+        uint64_t best_index = 0;
+        float best_value = 0.0f;
+        if (level == 0) {
+            uint64_t start = k * b->fanout;
+            uint64_t n = bucket_samples_of(b, level, k);
+            for (uint64_t i = start; i < start + n; i++) {
+                double area = triangle_area(ax, ay, (double)i, b->samples[i], cx, cy);
+                if (area > best) {
+                    best = area;
+                    best_index = i;
+                    best_value = b->samples[i];
+                }
+            }
+        } else {
+            const trace_pyramid_bucket_t *below = b->buckets[level - 1];
+            uint64_t below_count = b->table[level - 1].buckets;
+            uint64_t c0 = k * b->fanout;
+            uint64_t c1 = c0 + b->fanout < below_count ? c0 + b->fanout : below_count;
+            for (uint64_t c = c0; c < c1; c++) {
+                double area = triangle_area(ax, ay, below[c].index, below[c].value, cx, cy);
+                if (area > best) {
+                    best = area;
+                    best_index = below[c].index;
+                    best_value = below[c].value;
+                }
+            }
+        }
+
+        out[k].index = (uint32_t)best_index;
+        out[k].value = best_value;
+        ax = (double)best_index;
+        ay = best_value;
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    build_t *b = arg;
+    uint64_t buckets = b->table[b->level].buckets;
+
+    for (;;) {
+        uint64_t s = __atomic_fetch_add(&b->next_segment, 1, __ATOMIC_RELAXED);
+        if (s >= b->segments) {
+            break;
+        }
+        uint64_t first = s * TRACE_PYRAMID_SEGMENT;
+        uint64_t end = first + TRACE_PYRAMID_SEGMENT < buckets ? first + TRACE_PYRAMID_SEGMENT : buckets;
+        b->work(b, b->level, first, end);
+    }
+    return NULL;
+}
+
+/* Run one phase over every segment of a level; the caller is a worker too */
+static void run_phase(build_t *b, uint32_t level, void (*work)(const void *, uint32_t, uint64_t, uint64_t),
+                      int threads)
+{
+    pthread_t ids[64];
+    int started = 0;
+
+    b->level = level;
+    b->work = work;
+    b->segments = (b->table[level].buckets + TRACE_PYRAMID_SEGMENT - 1) / TRACE_PYRAMID_SEGMENT;
+    b->next_segment = 0;
+
+    if ((uint64_t)threads > b->segments) {
+        threads = (int)b->segments;
+    }
+    for (; started < threads - 1 && started < (int)(sizeof(ids) / sizeof(ids[0])); started++) {
+        if (pthread_create(&ids[started], NULL, worker_main, b) != 0) {
+            break;
+        }
+    }
+    worker_main(b);
+    for (int i = 0; i < started; i++) {
+        pthread_join(ids[i], NULL);
+    }
+}
+
+int trace_pyramid_build(const char *path, const float *samples, uint64_t count, double interval_s,
+                        uint32_t fanout, int threads)
+{
+    if (fanout == 0) {
+        fanout = TRACE_PYRAMID_FANOUT;
+    }
+    if (count == 0 || count > UINT32_MAX || fanout < 2) {
+        errno = EINVAL;     // Bucket records hold 32-bit sample indexes
+        return -1;
+    }
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    build_t *b = calloc(1, sizeof(*b));
+    if (b == NULL) {
+        return -1;
+    }
+    b->samples = samples;
+    b->count = count;
+    b->fanout = fanout;
+
+    // Level sizes, then the file layout
+    uint64_t size = sizeof(trace_pyramid_header_t);
+    uint64_t bucket_samples = fanout;
+    do {
+        trace_pyramid_level_t *l = &b->table[b->levels++];
+        l->bucket_samples = bucket_samples;
+        l->buckets = (count + bucket_samples - 1) / bucket_samples;
+        bucket_samples *= fanout;
+    } while (b->table[b->levels - 1].buckets > TRACE_PYRAMID_TOP && b->levels < TRACE_PYRAMID_LEVELS);
+
+    size += b->levels * sizeof(trace_pyramid_level_t);
+    for (uint32_t l = 0; l < b->levels; l++) {
+        b->table[l].offset = size;
+        size += b->table[l].buckets * sizeof(trace_pyramid_bucket_t);
+    }
+
+    // Write under a temporary name so readers never see a partial pyramid
+    char tmp[PATH_MAX];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+        free(b);
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        free(b);
+        return -1;
+    }
+    uint8_t *out = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0) {
+        out = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (out == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        unlink(tmp);
+        free(b);
+        errno = err;
+        return -1;
+    }
+
+    trace_pyramid_header_t header = {
+        .magic = TRACE_PYRAMID_MAGIC,
+        .version = TRACE_PYRAMID_VERSION,
+        .interval_s = interval_s,
+        .count = count,
+        .fanout = fanout,
+        .levels = b->levels,
+    };
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), b->table, b->levels * sizeof(trace_pyramid_level_t));
+    for (uint32_t l = 0; l < b->levels; l++) {
+        b->buckets[l] = (trace_pyramid_bucket_t *)(out + b->table[l].offset);
+    }
+
+    // Each level needs every mean of its own level before LTTB can run
+    for (uint32_t l = 0; l < b->levels; l++) {
+        run_phase(b, l, l == 0 ? envelope_base : envelope_upper, threads);
+        run_phase(b, l, lttb_segment, threads);
+    }
+
+    int ret = munmap(out, size);
+    if (close(fd) < 0 || ret < 0 || rename(tmp, path) < 0) {
+        int err = errno;
+        unlink(tmp);
+        free(b);
+        errno = err;
+        return -1;
+    }
+    free(b);
+    return 0;
+}
+
+/* ---- Reading ---- */
+
+int trace_pyramid_open(trace_pyramid_t *p, const char *path)
+{
+    memset(p, 0, sizeof(*p));
+    if (map_file(path, &p->map) < 0) {
+        return -1;
+    }
+
+    const uint8_t *base = p->map.addr;
+    bool ok = p->map.len >= sizeof(p->header);
+    if (ok) {
+        memcpy(&p->header, base, sizeof(p->header));
+        ok = p->header.magic == TRACE_PYRAMID_MAGIC && p->header.version == TRACE_PYRAMID_VERSION &&
+             p->header.levels >= 1 && p->header.levels <= TRACE_PYRAMID_LEVELS &&
+             sizeof(p->header) + p->header.levels * sizeof(trace_pyramid_level_t) <= p->map.len;
+    }
+    if (ok) {
+        p->levels = (const trace_pyramid_level_t *)(base + sizeof(p->header));
+        for (uint32_t l = 0; l < p->header.levels && ok; l++) {
+            const trace_pyramid_level_t *level = &p->levels[l];
+            ok = level->offset <= p->map.len && level->bucket_samples > 0 &&
+                 level->buckets <= (p->map.len - level->offset) / sizeof(trace_pyramid_bucket_t);
+        }
+    }
+    if (!ok) {
+        trace_unmap(&p->map);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+void trace_pyramid_close(trace_pyramid_t *p)
+{
+    trace_unmap(&p->map);
+}
+
+const trace_pyramid_bucket_t *trace_pyramid_buckets(const trace_pyramid_t *p, uint32_t level)
+{
+    return (const trace_pyramid_bucket_t *)((const uint8_t *)p->map.addr + p->levels[level].offset);
+}
+
+int trace_pyramid_select(const trace_pyramid_t *p, uint64_t from, uint64_t to, uint32_t width)
+{
+    uint64_t span = to > from ? to - from : 1;
+
+    for (int l = (int)p->header.levels - 1; l >= 0; l--) {
+        if (span / p->levels[l].bucket_samples >= width) {
+            return l;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file trace_pyramid.h
+ * @brief Zoom pyramid of a trace: min/max envelopes and LTTB points per level
+ *
+ * A pyramid file (".trp", stored next to the ".trc" trace) holds levels of
+ * buckets. Level 0 buckets cover fanout samples, and each higher level
+ * covers fanout buckets of the level below, up to a level of at most
+ * TRACE_PYRAMID_TOP buckets. Every bucket records the minimum, maximum and
+ * mean of its samples, plus one representative sample chosen by
+ * Largest-Triangle-Three-Buckets. That sample is the one forming the
+ * largest triangle with the previous bucket's choice and the next
+ * bucket's mean. Upper levels choose among the points of the level below.
+ *
+ * A view of any window at any width reads only the buckets in the window
+ * from the coarsest level that still has enough of them, and the raw trace
+ * once the window is a few screens of samples wide. Drawing cost therefore
+ * depends on the width in pixels, not on the trace length.
+ *
+ * Buckets are processed in fixed segments of TRACE_PYRAMID_SEGMENT, and a
+ * segment's LTTB run starts from the mean of the bucket before it. The file
+ * is therefore identical whatever the number of threads.
+ */
+
+#ifndef TRACE_PYRAMID_H
+#define TRACE_PYRAMID_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TRACE_PYRAMID_MAGIC     0x31505254u     // "TRP1"
+#define TRACE_PYRAMID_VERSION   1
+#define TRACE_PYRAMID_FANOUT    8               // Default samples or buckets per bucket
+#define TRACE_PYRAMID_TOP       1024            // The top level has at most this many buckets
+#define TRACE_PYRAMID_LEVELS    24
+#define TRACE_PYRAMID_SEGMENT   65536           // Buckets per unit of parallel work
+
+typedef struct {
+    uint32_t magic;             // TRACE_PYRAMID_MAGIC
+    uint32_t version;
+    double interval_s;
+    uint64_t count;             // Samples in the trace
+    uint32_t fanout;
+    uint32_t levels;
+} trace_pyramid_header_t;
+
+/* Level table entry, levels follow the header finest first */
+typedef struct {
+    uint64_t offset;            // File offset of the first bucket
+    uint64_t buckets;
+    uint64_t bucket_samples;    // Samples per bucket; the last bucket may hold fewer
+} trace_pyramid_level_t;
+
+typedef struct {
+    float min;
+    float max;
+    float mean;
+    float value;                // LTTB sample
+    uint32_t index;             // Its sample index
+} trace_pyramid_bucket_t;
+
+/* A mapped trace or pyramid */
+typedef struct {
+    const void *addr;
+    size_t len;
+} trace_map_t;
+
+/* An open pyramid */
+typedef struct {
+    trace_map_t map;
+    trace_pyramid_header_t header;
+    const trace_pyramid_level_t *levels;
+} trace_pyramid_t;
+
+/**
+ * @brief Map the samples of a trc or f32 file read-only
+ *
+ * @param samples Receives the first sample
+ * @param count Receives the sample count
+ * @param interval_s Receives the trc header's interval, 0 for f32
+ * @return 0 on success, -1 with errno set on failure
+ */
+int trace_map_samples(const char *path, trace_map_t *map, const float **samples, uint64_t *count,
+                      double *interval_s);
+
+void trace_unmap(trace_map_t *map);
+
+/**
+ * @brief Build the pyramid of samples[0..count) into path
+ *
+ * @param fanout Buckets per bucket, 0 for TRACE_PYRAMID_FANOUT
+ * @param threads Worker threads, 0 for one per online CPU
+ * @return 0 on success, -1 with errno set on failure
+ */
+int trace_pyramid_build(const char *path, const float *samples, uint64_t count, double interval_s,
+                        uint32_t fanout, int threads);
+
+int trace_pyramid_open(trace_pyramid_t *p, const char *path);
+void trace_pyramid_close(trace_pyramid_t *p);
+
+const trace_pyramid_bucket_t *trace_pyramid_buckets(const trace_pyramid_t *p, uint32_t level);
+
+/**
+ * @brief Choose what to draw for samples [from, to) at width points
+ *
+ * @return The coarsest level with at least width buckets in the window,
+ *         or -1 if the window holds few enough samples to draw raw
+ */
+int trace_pyramid_select(const trace_pyramid_t *p, uint64_t from, uint64_t to, uint32_t width);
+
+#endif /* TRACE_PYRAMID_H */
@@ -0,0 +1,497 @@
+/**
+ * @file trace_regress.c
+ * @brief Fit per-run energy against workload and configuration factors
+ *
+ * Reads an experiment manifest (data/manifest.txt). The manifest lists
+ * each trace with the key=value pairs describing the configuration and
+ * workload that produced it. The tool measures every trace in one
+ * streaming pass and fits the response by least squares (trace_fit.h).
+ * It prints each term's estimate with its confidence interval and
+ * p-value, so a knob whose interval spans zero is one the data cannot
+ * tell apart from no effect.
+ *
+ * Terms are manifest keys or these per-trace measurements:
+ *   energy_j, power_w, duration_s, wakeups (bursts as in trace_stat),
+ *   wakeup_hz, active_s (time in bursts)
+ * A key whose values are not all numbers, or one named with -c, is a
+ * factor. Each of its levels but the first (in sort order) gets its own
+ * column, measured against that first level.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/trace \
+ *       host/trace/{trace_regress,trace_fit,trace_io,trace_ops}.c -lm -o /tmp/trace_regress
+ *
+ * Usage:
+ *   trace_regress [-m manifest] [-y response] [-x term,term,...] [-c key,...]
+ *                 [-a confidence] [-i interval_ms] [-V volts] [-e on_a[,off_a]]
+ *                 [-g merge_gap_ms] [-r]
+ *
+ * -r also prints every run used with its fitted value and residual.
+ *
+ * Example:
+ *   trace_regress -m data/manifest.txt -x workload,wakeups
+ *   trace_regress -m runs.txt -y power_w -x frames,bytes,wakeups,ps_mode,protocol,tx_power
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace_io.h"
+#include "trace_ops.h"
+#include "trace_fit.h"
+
+#define CHUNK_SAMPLES   8192
+#define MAX_KEYS        96      // key=value pairs per manifest line
+#define MAX_TERMS       32
+#define MAX_LEVELS      TRACE_FIT_MAX_COLS
+#define LINE_MAX_LEN    4096
+
+/* Measurements taken from each trace */
+enum {
+    FEATURE_ENERGY,
+    FEATURE_POWER,
+    FEATURE_DURATION,
+    FEATURE_WAKEUPS,
+    FEATURE_WAKEUP_HZ,
+    FEATURE_ACTIVE,
+    FEATURE_COUNT
+};
+
+static const char *const feature_names[FEATURE_COUNT] = {
+    "energy_j", "power_w", "duration_s", "wakeups", "wakeup_hz", "active_s",
+};
+
+/* One manifest line and its measurements */
+typedef struct {
+    char *line;                 // Owns the strings below
+    const char *trace;
+    int keys;
+    const char *key[MAX_KEYS];
+    const char *value[MAX_KEYS];
+    bool measured;
+    double feature[FEATURE_COUNT];
+} run_t;
+
+/* One column of the design matrix */
+typedef struct {
+    int term;
+    const char *level;          // Factor level, NULL for a numeric term
+} column_t;
+
+static struct {
+    const char *manifest;
+    const char *response;
+    char *terms[MAX_TERMS];
+    int term_count;
+    char *factors[MAX_TERMS];
+    int factor_count;
+    double confidence;
+    double interval_s;
+    double voltage;
+    double event_on;
+    double event_off;
+    double merge_gap_s;
+    bool print_runs;
+} config = {
+    .manifest = "data/manifest.txt",
+    .response = "energy_j",
+    .confidence = 0.95,
+    .voltage = 5.0,
+    .event_on = 0.035,
+    .event_off = 0.03,
+    .merge_gap_s = 1.8e-3,
+};
+
+static int split_list(char *list, char **out, int max)
+{
+    char *save = NULL;
+    int n = 0;
+    for (char *tok = strtok_r(list, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        if (n >= max) {
+            return -1;
+        }
+        out[n++] = tok;
+    }
+    return n;
+}
+
+/* Parse "trace key=value ..." in place; false for blank and comment lines */
+static bool parse_line(char *line, run_t *run)
+{
+    char *hash = strchr(line, '#');
+    if (hash != NULL) {
+        *hash = '\0';
+    }
+
+    char *save = NULL;
+    char *tok = strtok_r(line, " \t\r\n", &save);
+    if (tok == NULL) {
+        return false;
+    }
+    run->trace = tok;
+    while ((tok = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+        char *eq = strchr(tok, '=');
+        if (eq == NULL || eq == tok || run->keys >= MAX_KEYS) {
+            continue;   // The @CFG marker and anything else that is not key=value
+        }
+        *eq = '\0';
+        run->key[run->keys] = tok;
+        run->value[run->keys] = eq + 1;
+        run->keys++;
+    }
+    return true;
+}
+
+static run_t *read_manifest(const char *path, int *count)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    run_t *runs = NULL;
+    int n = 0, capacity = 0;
+    char buf[LINE_MAX_LEN];
+    while (fgets(buf, sizeof(buf), f) != NULL) {
+        run_t run = { .line = strdup(buf) };
+        if (run.line == NULL) {
+            break;
+        }
+        if (!parse_line(run.line, &run)) {
+            free(run.line);
+            continue;
+        }
+        if (n == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 64;
+            run_t *grown = realloc(runs, sizeof(*runs) * (size_t)capacity);
+            if (grown == NULL) {
+                free(run.line);
+                break;
+            }
+            runs = grown;
+        }
+        runs[n++] = run;
+    }
+    fclose(f);
+    *count = n;
+    return runs;
+}
+
+/* Stream one trace through the energy and burst operators */
+static int measure(run_t *run, const char *dir)
+{
+    static trace_reader_t reader;
+    static double chunk[CHUNK_SAMPLES];
+    char path[LINE_MAX_LEN];
+
+    if (run->trace[0] == '/' || dir == NULL) {
+        snprintf(path, sizeof(path), "%s", run->trace);
+    } else {
+        snprintf(path, sizeof(path), "%s/%s", dir, run->trace);
+    }
+    if (trace_open(&reader, path, TRACE_FORMAT_AUTO) < 0) {
+        fprintf(stderr, "trace_regress: cannot open '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    double dt = config.interval_s > 0 ? config.interval_s :
+                reader.interval_s > 0 ? reader.interval_s : TRACE_DEFAULT_INTERVAL_S;
+
+    trace_energy_t energy;
+    trace_events_t bursts;
+    trace_energy_init(&energy);
+    trace_events_init(&bursts, config.event_on, config.event_off, (uint64_t)llround(config.merge_gap_s / dt), 0,
+                      NULL, NULL);
+
+    long n;
+    while ((n = trace_read(&reader, chunk, CHUNK_SAMPLES)) > 0) {
+        trace_energy_push(&energy, chunk, (size_t)n);
+        trace_events_push(&bursts, chunk, (size_t)n);
+    }
+    trace_events_finish(&bursts);
+    trace_close(&reader);
+    if (n < 0 || energy.count == 0) {
+        fprintf(stderr, "trace_regress: cannot read '%s'\n", path);
+        return -1;
+    }
+
+    double duration = energy.count * dt;
+    run->feature[FEATURE_ENERGY] = trace_energy_joules(&energy, dt, config.voltage);
+    run->feature[FEATURE_POWER] = run->feature[FEATURE_ENERGY] / duration;
+    run->feature[FEATURE_DURATION] = duration;
+    run->feature[FEATURE_WAKEUPS] = (double)bursts.events;
+    run->feature[FEATURE_WAKEUP_HZ] = bursts.events / duration;
+    run->feature[FEATURE_ACTIVE] = bursts.active_samples * dt;
+    run->measured = true;
+    return 0;
+}
+
+/* Value of a term for a run as text, or NULL if unknown */
+static const char *lookup(const run_t *run, const char *name, char *buf, size_t size)
+{
+    for (int f = 0; f < FEATURE_COUNT; f++) {
+        if (strcmp(name, feature_names[f]) == 0) {
+            snprintf(buf, size, "%.17g", run->feature[f]);
+            return buf;
+        }
+    }
+    for (int k = 0; k < run->keys; k++) {
+        if (strcmp(name, run->key[k]) == 0) {
+            return run->value[k];
+        }
+    }
+    return NULL;
+}
+
+static bool parse_number(const char *s, double *out)
+{
+    char *end;
+    *out = strtod(s, &end);
+    return end != s && *end == '\0' && isfinite(*out);
+}
+
+static bool named_factor(const char *term)
+{
+    for (int i = 0; i < config.factor_count; i++) {
+        if (strcmp(term, config.factors[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int compare_strings(const void *a, const void *b)
+{
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-m manifest] [-y response] [-x term,term,...] [-c key,...]\n"
+            "          [-a confidence] [-i interval_ms] [-V volts] [-e on_a[,off_a]]\n"
+            "          [-g merge_gap_ms] [-r]\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    static char default_terms[] = "workload,wakeups";
+    char *terms = default_terms;
+    double pair[2];
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:y:x:c:a:i:V:e:g:rh")) != -1) {
+        bool ok = true;
+        char *list[2];
+        int n;
+        switch (opt) {
+            case 'm': config.manifest = optarg; break;
+            case 'y': config.response = optarg; break;
+            case 'x': terms = optarg; break;
+            case 'c':
+                config.factor_count = split_list(optarg, config.factors, MAX_TERMS);
+                ok = config.factor_count > 0;
+                break;
+            case 'a': config.confidence = strtod(optarg, NULL); ok = config.confidence > 0 && config.confidence < 1; break;
+            case 'i': config.interval_s = strtod(optarg, NULL) * 1e-3; ok = config.interval_s > 0; break;
+            case 'V': config.voltage = strtod(optarg, NULL); break;
+            case 'e':
+                n = split_list(optarg, list, 2);
+                ok = n >= 1 && parse_number(list[0], &pair[0]) && (n == 1 || parse_number(list[1], &pair[1]));
+                if (ok) {
+                    config.event_on = pair[0];
+                    config.event_off = n == 2 ? pair[1] : pair[0];
+                }
+                break;
+            case 'g': config.merge_gap_s = strtod(optarg, NULL) * 1e-3; break;
+            case 'r': config.print_runs = true; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+        if (!ok) {
+            fprintf(stderr, "trace_regress: bad value '%s' for -%c\n", optarg, opt);
+            return 2;
+        }
+    }
+    config.term_count = split_list(terms, config.terms, MAX_TERMS);
+    if (config.term_count <= 0 || optind != argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int run_count;
+    run_t *runs = read_manifest(config.manifest, &run_count);
+    if (runs == NULL) {
+        fprintf(stderr, "trace_regress: cannot read '%s': %s\n", config.manifest, strerror(errno));
+        return 1;
+    }
+    char *dir = strdup(config.manifest);
+    char *slash = dir != NULL ? strrchr(dir, '/') : NULL;
+    if (slash != NULL) {
+        *slash = '\0';
+    }
+
+    // Keep runs that can be measured and know every term
+    char buf[64];
+    int *used = malloc(sizeof(int) * (size_t)(run_count > 0 ? run_count : 1));
+    int rows = 0, unknown = 0, unreadable = 0;
+    for (int r = 0; r < run_count; r++) {
+        bool known = lookup(&runs[r], config.response, buf, sizeof(buf)) != NULL ||
+                     strcmp(config.response, feature_names[0]) != 0;
+        for (int t = 0; t < config.term_count && known; t++) {
+            bool feature = false;
+            for (int f = 0; f < FEATURE_COUNT; f++) {
+                feature = feature || strcmp(config.terms[t], feature_names[f]) == 0;
+            }
+            known = feature || lookup(&runs[r], config.terms[t], buf, sizeof(buf)) != NULL;
+        }
+        if (!known) {
+            unknown++;
+            continue;
+        }
+        if (measure(&runs[r], slash != NULL ? dir : NULL) < 0) {
+            unreadable++;
+            continue;
+        }
+        const char *response = lookup(&runs[r], config.response, buf, sizeof(buf));
+        double y;
+        if (response == NULL || !parse_number(response, &y)) {
+            unknown++;
+            continue;
+        }
+        used[rows++] = r;
+    }
+
+    // One column per numeric term, one per non-baseline level of a factor
+    column_t columns[TRACE_FIT_MAX_COLS];
+    int cols = 0;
+    columns[cols++] = (column_t){ .term = -1 };
+    for (int t = 0; t < config.term_count; t++) {
+        const char *levels[MAX_LEVELS];
+        int level_count = 0;
+        bool factor = named_factor(config.terms[t]);
+        for (int i = 0; i < rows; i++) {
+            const char *v = lookup(&runs[used[i]], config.terms[t], buf, sizeof(buf));
+            double unused;
+            factor = factor || !parse_number(v, &unused);
+        }
+        if (!factor) {
+            if (cols == TRACE_FIT_MAX_COLS) {
+                fprintf(stderr, "trace_regress: too many columns\n");
+                return 2;
+            }
+            columns[cols++] = (column_t){ .term = t };
+            continue;
+        }
+        for (int i = 0; i < rows; i++) {
+            const char *v = lookup(&runs[used[i]], config.terms[t], buf, sizeof(buf));
+            bool seen = false;
+            for (int l = 0; l < level_count && !seen; l++) {
+                seen = strcmp(levels[l], v) == 0;
+            }
+            if (!seen) {
+                if (level_count == MAX_LEVELS) {
+                    fprintf(stderr, "trace_regress: too many levels of '%s'\n", config.terms[t]);
+                    return 2;
+                }
+                levels[level_count++] = v;
+            }
+        }
+        qsort(levels, (size_t)level_count, sizeof(levels[0]), compare_strings);
+        for (int l = 1; l < level_count; l++) {
+            if (cols == TRACE_FIT_MAX_COLS) {
+                fprintf(stderr, "trace_regress: too many columns\n");
+                return 2;
+            }
+            columns[cols++] = (column_t){ .term = t, .level = levels[l] };
+        }
+        printf("factor name=%s baseline=%s levels=%d\n", config.terms[t], level_count > 0 ? levels[0] : "-",
+               level_count);
+    }
+
+    printf("runs manifest=%d used=%d unknown_terms=%d unreadable=%d response=%s\n",
+           run_count, rows, unknown, unreadable, config.response);
+    if (rows <= cols) {
+        fprintf(stderr, "trace_regress: %d runs cannot fit %d columns\n", rows, cols);
+        return 1;
+    }
+
+    double *x = malloc(sizeof(double) * (size_t)rows * (size_t)cols);
+    double *y = malloc(sizeof(double) * (size_t)rows);
+    if (x == NULL || y == NULL) {
+        fprintf(stderr, "trace_regress: out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < rows; i++) {
+        const run_t *run = &runs[used[i]];
+        parse_number(lookup(run, config.response, buf, sizeof(buf)), &y[i]);
+        for (int c = 0; c < cols; c++) {
+            const column_t *col = &columns[c];
+            double v = 1.0;
+            if (col->term >= 0) {
+                const char *text = lookup(run, config.terms[col->term], buf, sizeof(buf));
+                if (col->level != NULL) {
+                    v = strcmp(text, col->level) == 0;
+                } else {
+                    parse_number(text, &v);
+                }
+            }
+            x[(size_t)i * cols + c] = v;
+        }
+    }
+
+    trace_fit_t fit;
+    if (trace_fit_ols(&fit, x, y, rows, cols, config.confidence) < 0) {
+        fprintf(stderr, "trace_regress: fit failed: %s\n", strerror(errno));
+        return 1;
+    }
+    printf("fit columns=%d rank=%d df=%d r2=%.4f adj_r2=%.4f sigma=%.6g confidence=%g\n",
+           cols, fit.rank, fit.df, fit.r2, fit.adj_r2, fit.sigma, config.confidence);
+    for (int c = 0; c < cols; c++) {
+        const column_t *col = &columns[c];
+        char name[128];
+        if (col->term < 0) {
+            snprintf(name, sizeof(name), "(intercept)");
+        } else if (col->level != NULL) {
+            snprintf(name, sizeof(name), "%s[%s]", config.terms[col->term], col->level);
+        } else {
+            snprintf(name, sizeof(name), "%s", config.terms[col->term]);
+        }
+        if (fit.aliased[c]) {
+            printf("term name=%s aliased\n", name);
+            continue;
+        }
+        printf("term name=%s estimate=%.6g se=%.4g ci_lo=%.6g ci_hi=%.6g t=%.3f p=%.3g%s\n",
+               name, fit.beta[c], fit.se[c], fit.ci_lo[c], fit.ci_hi[c], fit.t[c], fit.p[c],
+               fit.ci_lo[c] > 0 || fit.ci_hi[c] < 0 ? " significant" : "");
+    }
+
+    if (config.print_runs) {
+        for (int i = 0; i < rows; i++) {
+            double fitted = 0.0;
+            for (int c = 0; c < cols; c++) {
+                fitted += x[(size_t)i * cols + c] * fit.beta[c];
+            }
+            const run_t *run = &runs[used[i]];
+            printf("run trace=%s energy_j=%.6g power_w=%.6g wakeups=%.0f active_s=%.4f %s=%.6g fitted=%.6g "
+                   "residual=%.4g\n",
+                   run->trace, run->feature[FEATURE_ENERGY], run->feature[FEATURE_POWER],
+                   run->feature[FEATURE_WAKEUPS], run->feature[FEATURE_ACTIVE], config.response, y[i], fitted,
+                   y[i] - fitted);
+        }
+    }
+
+    free(x);
+    free(y);
+    free(used);
+    free(dir);
+    for (int r = 0; r < run_count; r++) {
+        free(runs[r].line);
+    }
+    free(runs);
+    return 0;
+}
@@ -0,0 +1,306 @@
+/**
+ * @file trace_stat.c
+ * @brief Streaming energy, threshold, burst and residency analysis of current traces
+ *
+ * Replaces the whole-file analysis in data/plot.py for long captures. Each
+ * trace is read in fixed-size chunks and fed once through the operators in
+ * trace_ops.h, so memory use is constant and run time is linear in the
+ * trace length. Results are printed as key=value lines per trace.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/trace \
+ *       host/trace/{trace_stat,trace_io,trace_ops}.c -lm -o /tmp/trace_stat
+ *
+ * Usage:
+ *   trace_stat [-f format] [-i interval_ms] [-V volts] [-t threshold_a]
+ *              [-e on_a[,off_a]] [-g merge_gap_ms] [-m min_burst_ms]
+ *              [-b upper,upper,...] [-n name,name,...] [-E] [-o out.trc] [trace]...
+ *
+ * Traces are csv, trc or f32 files (trace_io.h), "-" or nothing for stdin.
+ * The interval defaults to a trc header's, else 0.6 ms. -t is plot.py's
+ * wifi_curr_th split. -e sets the burst hysteresis and -b/-n the current
+ * bands for residency (default sleep < 0.02 A <= idle < 0.03 A <= rx
+ * < 0.15 A <= tx). -E prints every burst as csv; -o also writes the single
+ * input trace as trc for faster rereading.
+ *
+ * Example:
+ *   trace_stat data/sync/default_1-1.csv data/sync/default_1-2.csv
+ *   trace_stat -o capture.trc < capture.csv
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "trace_io.h"
+#include "trace_ops.h"
+
+#define CHUNK_SAMPLES   8192
+
+/* Analysis settings shared by every input */
+typedef struct {
+    trace_format_t format;
+    double interval_s;          // 0: from the trc header or the default
+    double voltage;
+    double threshold;
+    double event_on;
+    double event_off;
+    double merge_gap_s;
+    double min_burst_s;
+    int state_count;
+    double state_upper[TRACE_STATES_MAX];
+    const char *state_names[TRACE_STATES_MAX];
+    bool print_events;
+    const char *output;
+} stat_config_t;
+
+static stat_config_t config = {
+    .format = TRACE_FORMAT_AUTO,
+    .voltage = 5.0,
+    .threshold = 0.03,
+    .event_on = 0.035,
+    .event_off = 0.03,
+    .merge_gap_s = 1.8e-3,
+    .state_count = 4,
+    .state_upper = {0.02, 0.03, 0.15},
+    .state_names = {"sleep", "idle", "rx", "tx"},
+};
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    double interval_s;
+} event_print_ctx_t;
+
+static void print_event(const trace_event_t *e, void *ctx)
+{
+    const event_print_ctx_t *p = ctx;
+    printf("burst,%.6f,%.6f,%.6g,%.6g\n", e->start * p->interval_s, (e->end - e->start) * p->interval_s * 1e3,
+           e->peak, e->sum / (e->end - e->start));
+}
+
+static int analyze(const char *path)
+{
+    static double chunk[CHUNK_SAMPLES];
+    static trace_reader_t reader;
+    static trace_writer_t writer;
+
+    if (trace_open(&reader, path, config.format) < 0) {
+        fprintf(stderr, "trace_stat: cannot open '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    double dt = config.interval_s > 0 ? config.interval_s :
+                reader.interval_s > 0 ? reader.interval_s : TRACE_DEFAULT_INTERVAL_S;
+    if (config.output != NULL && trace_create(&writer, config.output, dt) < 0) {
+        fprintf(stderr, "trace_stat: cannot create '%s': %s\n", config.output, strerror(errno));
+        trace_close(&reader);
+        return -1;
+    }
+
+    trace_energy_t energy;
+    trace_threshold_t split;
+    trace_events_t bursts;
+    trace_residency_t states;
+    event_print_ctx_t print_ctx = { .interval_s = dt };
+
+    trace_energy_init(&energy);
+    trace_threshold_init(&split, config.threshold);
+    trace_events_init(&bursts, config.event_on, config.event_off,
+                      (uint64_t)llround(config.merge_gap_s / dt), (uint64_t)llround(config.min_burst_s / dt),
+                      config.print_events ? print_event : NULL, &print_ctx);
+    trace_residency_init(&states, config.state_count, config.state_upper, config.state_names);
+
+    if (config.print_events) {
+        printf("burst,start_s,length_ms,peak_a,mean_a\n");
+    }
+
+    double started = now_s();
+    long n;
+    int status = 0;
+    while ((n = trace_read(&reader, chunk, CHUNK_SAMPLES)) > 0) {
+        trace_energy_push(&energy, chunk, (size_t)n);
+        trace_threshold_push(&split, chunk, (size_t)n);
+        trace_events_push(&bursts, chunk, (size_t)n);
+        trace_residency_push(&states, chunk, (size_t)n);
+        if (config.output != NULL && trace_write(&writer, chunk, (size_t)n) < 0) {
+            fprintf(stderr, "trace_stat: write failed: %s\n", strerror(errno));
+            status = -1;
+            break;
+        }
+    }
+    if (n < 0) {
+        fprintf(stderr, "trace_stat: read failed on '%s': %s\n", path, strerror(errno));
+        status = -1;
+    }
+    trace_events_finish(&bursts);
+    double elapsed = now_s() - started;
+
+    if (config.output != NULL && trace_finish(&writer) < 0) {
+        fprintf(stderr, "trace_stat: cannot finish '%s': %s\n", config.output, strerror(errno));
+        status = -1;
+    }
+
+    uint64_t count = energy.count;
+    double duration = count * dt;
+    printf("file=%s format=%s samples=%llu interval_ms=%g duration_s=%.3f bad_tokens=%llu\n",
+           path, trace_format_name(reader.format), (unsigned long long)count, dt * 1e3, duration,
+           (unsigned long long)reader.bad_tokens);
+    if (count > 0) {
+        double mean = energy.sum / count;
+        printf("current_a mean=%.6g min=%.6g max=%.6g rms=%.6g\n",
+               mean, energy.min, energy.max, sqrt(energy.sum_sq / count));
+    }
+    printf("energy_j total=%.6g threshold_a=%g baseline_a=%.6g above_threshold_j=%.6g\n",
+           trace_energy_joules(&energy, dt, config.voltage), config.threshold,
+           trace_threshold_baseline(&split), trace_threshold_joules(&split, dt, config.voltage));
+    printf("bursts count=%llu active_s=%.4f mean_ms=%.3f max_ms=%.3f charge_mc=%.6g rate_hz=%.4g\n",
+           (unsigned long long)bursts.events, bursts.active_samples * dt,
+           bursts.events > 0 ? bursts.active_samples * dt * 1e3 / bursts.events : 0.0,
+           bursts.len_max * dt * 1e3, bursts.active_sum * dt * 1e3,
+           duration > 0 ? bursts.events / duration : 0.0);
+    if (bursts.gap_count > 0) {
+        printf("burst_gap_ms mean=%.3f min=%.3f max=%.3f\n",
+               bursts.gap_total * dt * 1e3 / bursts.gap_count,
+               bursts.gap_min * dt * 1e3, bursts.gap_max * dt * 1e3);
+    }
+    for (int s = 0; s < states.count; s++) {
+        printf("state name=%s below_a=%g time_s=%.4f share=%.2f%% energy_j=%.6g entries=%llu\n",
+               states.names[s], states.upper[s], states.samples[s] * dt,
+               count > 0 ? 100.0 * states.samples[s] / count : 0.0,
+               states.sum[s] * dt * config.voltage, (unsigned long long)states.entries[s]);
+    }
+    printf("elapsed_s=%.3f samples_per_s=%.0f\n", elapsed, elapsed > 0 ? count / elapsed : 0.0);
+
+    trace_close(&reader);
+    return status;
+}
+
+/* Parse up to max comma-separated numbers; returns the count or -1 */
+static int parse_list(char *list, double *out, int max)
+{
+    char *save = NULL;
+    int n = 0;
+    for (char *tok = strtok_r(list, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        char *end;
+        if (n >= max) {
+            return -1;
+        }
+        out[n++] = strtod(tok, &end);
+        if (*end != '\0' || end == tok) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+static int parse_names(char *list, const char **out, int max)
+{
+    char *save = NULL;
+    int n = 0;
+    for (char *tok = strtok_r(list, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        if (n >= max) {
+            return -1;
+        }
+        out[n++] = tok;
+    }
+    return n;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-f format] [-i interval_ms] [-V volts] [-t threshold_a]\n"
+            "          [-e on_a[,off_a]] [-g merge_gap_ms] [-m min_burst_ms]\n"
+            "          [-b upper,upper,...] [-n name,name,...] [-E] [-o out.trc] [trace]...\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const default_names[TRACE_STATES_MAX] = {
+        "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+    };
+    bool bands_given = false;
+    int names_given = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:i:V:t:e:g:m:b:n:Eo:h")) != -1) {
+        bool ok = true;
+        double pair[2];
+        int n;
+        switch (opt) {
+            case 'f': ok = trace_format_from_option(optarg, &config.format); break;
+            case 'i': config.interval_s = strtod(optarg, NULL) * 1e-3; ok = config.interval_s > 0; break;
+            case 'V': config.voltage = strtod(optarg, NULL); break;
+            case 't': config.threshold = strtod(optarg, NULL); break;
+            case 'e':
+                n = parse_list(optarg, pair, 2);
+                ok = n >= 1;
+                if (ok) {
+                    config.event_on = pair[0];
+                    config.event_off = n == 2 ? pair[1] : pair[0];
+                }
+                break;
+            case 'g': config.merge_gap_s = strtod(optarg, NULL) * 1e-3; break;
+            case 'm': config.min_burst_s = strtod(optarg, NULL) * 1e-3; break;
+            case 'b':
+                n = parse_list(optarg, config.state_upper, TRACE_STATES_MAX - 1);
+                ok = n >= 0;
+                config.state_count = n + 1;
+                bands_given = true;
+                break;
+            case 'n':
+                names_given = parse_names(optarg, config.state_names, TRACE_STATES_MAX);
+                ok = names_given > 0;
+                break;
+            case 'E': config.print_events = true; break;
+            case 'o': config.output = optarg; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+        if (!ok) {
+            fprintf(stderr, "trace_stat: bad value '%s' for -%c\n", optarg, opt);
+            return 2;
+        }
+    }
+
+    // Custom bands without names are numbered
+    if (names_given != 0 && names_given != config.state_count) {
+        fprintf(stderr, "trace_stat: %d names for %d bands\n", names_given, config.state_count);
+        return 2;
+    }
+    if (bands_given && names_given == 0) {
+        memcpy(config.state_names, default_names, sizeof(config.state_names));
+    }
+
+    trace_residency_t probe;
+    if (!trace_residency_init(&probe, config.state_count, config.state_upper, config.state_names)) {
+        fprintf(stderr, "trace_stat: band bounds must ascend\n");
+        return 2;
+    }
+    if (config.output != NULL && argc - optind > 1) {
+        fprintf(stderr, "trace_stat: -o takes a single input\n");
+        return 2;
+    }
+
+    int status = 0;
+    if (optind == argc) {
+        status = analyze("-") < 0;
+    }
+    for (int i = optind; i < argc; i++) {
+        if (analyze(argv[i]) < 0) {
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,270 @@
+/**
+ * @file trace_states.c
+ * @brief Classify current traces into power states with residency and energy per state
+ *
+ * Unlike trace_stat's fixed bands, the levels are fitted to the traces
+ * (trace_classify.h), and every sample is labelled by a Viterbi-decoded
+ * HMM. By default one model is fitted to all inputs together, so states
+ * mean the same thing in every file of a batch: a first pass builds the
+ * pooled histogram and a second pass classifies each file. -P fits each
+ * file on its own.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/trace \
+ *       host/trace/{trace_states,trace_classify,trace_io}.c -lm -o /tmp/trace_states
+ *
+ * Usage:
+ *   trace_states [-f format] [-i interval_ms] [-V volts] [-k max_levels]
+ *                [-r min_ratio] [-s min_share] [-p switch_prob]
+ *                [-L name=amps,name=amps,...] [-P] trace...
+ *
+ * -L sets the nominal states levels are named after (default sleep=0.005,
+ * idle=0.027, rx=0.08, tx=0.25, as measured on the ESP32-C3 board). Traces
+ * are read twice, so stdin is not accepted; convert with trace_stat -o.
+ *
+ * Example:
+ *   trace_states data/sync/default_1-1.csv data/sync/stress_5-1.csv
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "trace_io.h"
+#include "trace_classify.h"
+
+#define CHUNK_SAMPLES   8192
+
+typedef struct {
+    trace_format_t format;
+    double interval_s;          // 0: from the trc header or the default
+    double voltage;
+    int max_levels;
+    double min_ratio;
+    double min_share;
+    double switch_prob;
+    bool per_file;
+    int nominal_count;
+    double nominal_a[TRACE_STATES_MAX];
+    const char *names[TRACE_STATES_MAX];
+} states_config_t;
+
+static states_config_t config = {
+    .format = TRACE_FORMAT_AUTO,
+    .voltage = 5.0,
+    .max_levels = 4,
+    .min_ratio = 1.6,
+    .min_share = 1e-4,
+    .switch_prob = 1e-3,
+    .nominal_count = 4,
+    .nominal_a = { 0.005, 0.027, 0.08, 0.25 },
+    .names = { "sleep", "idle", "rx", "tx" },
+};
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Feed a whole trace to the histogram or the HMM; returns the interval or -1 */
+static double read_trace(const char *path, trace_histogram_t *h, trace_hmm_t *hmm, uint64_t *count)
+{
+    static trace_reader_t reader;
+    static double chunk[CHUNK_SAMPLES];
+
+    if (trace_open(&reader, path, config.format) < 0) {
+        fprintf(stderr, "trace_states: cannot open '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    long n;
+    while ((n = trace_read(&reader, chunk, CHUNK_SAMPLES)) > 0) {
+        if (h != NULL) {
+            trace_histogram_push(h, chunk, (size_t)n);
+        }
+        if (hmm != NULL) {
+            trace_hmm_push(hmm, chunk, (size_t)n);
+        }
+    }
+    if (n < 0) {
+        fprintf(stderr, "trace_states: read failed on '%s': %s\n", path, strerror(errno));
+        trace_close(&reader);
+        return -1;
+    }
+    if (hmm != NULL) {
+        trace_hmm_finish(hmm);
+    }
+
+    *count = reader.samples;
+    double dt = config.interval_s > 0 ? config.interval_s :
+                reader.interval_s > 0 ? reader.interval_s : TRACE_DEFAULT_INTERVAL_S;
+    trace_close(&reader);
+    return dt;
+}
+
+static int fit(const trace_histogram_t *h, trace_levels_t *levels)
+{
+    if (trace_levels_fit(levels, h, config.max_levels, config.min_ratio, config.min_share) == 0) {
+        return -1;
+    }
+    trace_levels_label(levels, config.nominal_a, config.nominal_count);
+    return 0;
+}
+
+static void print_levels(const trace_levels_t *levels)
+{
+    for (int l = 0; l < levels->count; l++) {
+        printf("level name=%s current_a=%.5g spread=%.3f share=%.4f%%\n",
+               config.names[levels->label[l]], exp(levels->mean[l]), exp(levels->sd[l]) - 1.0,
+               100.0 * levels->share[l]);
+    }
+}
+
+/* Second pass: label one trace and print its states */
+static int classify(const char *path, const trace_levels_t *levels)
+{
+    static trace_hmm_t hmm;
+    uint64_t count;
+
+    trace_hmm_init(&hmm, levels, config.switch_prob);
+    double dt = read_trace(path, NULL, &hmm, &count);
+    if (dt < 0) {
+        return -1;
+    }
+
+    double total = 0;
+    for (int s = 0; s < config.nominal_count; s++) {
+        total += hmm.sum[s];
+    }
+    printf("file=%s samples=%llu duration_s=%.3f transitions=%llu energy_j=%.6g\n", path,
+           (unsigned long long)count, count * dt, (unsigned long long)hmm.transitions,
+           total * dt * config.voltage);
+    for (int s = 0; s < config.nominal_count; s++) {
+        printf("state name=%s time_s=%.4f share=%.3f%% mean_a=%.5g energy_j=%.6g energy_share=%.2f%% "
+               "entries=%llu\n",
+               config.names[s], hmm.samples[s] * dt, count > 0 ? 100.0 * hmm.samples[s] / count : 0.0,
+               hmm.samples[s] > 0 ? hmm.sum[s] / hmm.samples[s] : 0.0, hmm.sum[s] * dt * config.voltage,
+               total > 0 ? 100.0 * hmm.sum[s] / total : 0.0, (unsigned long long)hmm.entries[s]);
+    }
+    return 0;
+}
+
+/* Parse name=amps,... into the nominal states */
+static bool parse_nominal(char *list)
+{
+    char *save = NULL;
+    int n = 0;
+    for (char *tok = strtok_r(list, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+        char *end;
+        if (n >= TRACE_STATES_MAX || eq == NULL || eq == tok) {
+            return false;
+        }
+        *eq = '\0';
+        config.names[n] = tok;
+        config.nominal_a[n] = strtod(eq + 1, &end);
+        if (*end != '\0' || !(config.nominal_a[n] > 0)) {
+            return false;
+        }
+        n++;
+    }
+    config.nominal_count = n;
+    return n > 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-f format] [-i interval_ms] [-V volts] [-k max_levels]\n"
+            "          [-r min_ratio] [-s min_share] [-p switch_prob]\n"
+            "          [-L name=amps,name=amps,...] [-P] trace...\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "f:i:V:k:r:s:p:L:Ph")) != -1) {
+        bool ok = true;
+        switch (opt) {
+            case 'f': ok = trace_format_from_option(optarg, &config.format); break;
+            case 'i': config.interval_s = strtod(optarg, NULL) * 1e-3; ok = config.interval_s > 0; break;
+            case 'V': config.voltage = strtod(optarg, NULL); break;
+            case 'k':
+                config.max_levels = atoi(optarg);
+                ok = config.max_levels >= 1 && config.max_levels <= TRACE_STATES_MAX;
+                break;
+            case 'r': config.min_ratio = strtod(optarg, NULL); ok = config.min_ratio > 1.0; break;
+            case 's': config.min_share = strtod(optarg, NULL); ok = config.min_share >= 0; break;
+            case 'p':
+                config.switch_prob = strtod(optarg, NULL);
+                ok = config.switch_prob > 0 && config.switch_prob < 1;
+                break;
+            case 'L': ok = parse_nominal(optarg); break;
+            case 'P': config.per_file = true; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+        if (!ok) {
+            fprintf(stderr, "trace_states: bad value '%s' for -%c\n", optarg, opt);
+            return 2;
+        }
+    }
+    if (optind == argc) {
+        usage(argv[0]);
+        return 2;
+    }
+    for (int i = optind; i < argc; i++) {
+        if (strcmp(argv[i], "-") == 0) {
+            fprintf(stderr, "trace_states: traces are read twice; save stdin with trace_stat -o first\n");
+            return 2;
+        }
+    }
+
+    static trace_histogram_t pooled, single;
+    static trace_levels_t levels;
+    double started = now_s();
+    uint64_t total = 0, count;
+    int status = 0;
+
+    trace_histogram_init(&pooled);
+    if (!config.per_file) {
+        for (int i = optind; i < argc; i++) {
+            if (read_trace(argv[i], &pooled, NULL, &count) < 0) {
+                return 1;
+            }
+        }
+        if (fit(&pooled, &levels) < 0) {
+            fprintf(stderr, "trace_states: no samples\n");
+            return 1;
+        }
+        print_levels(&levels);
+    }
+
+    for (int i = optind; i < argc; i++) {
+        if (config.per_file) {
+            trace_histogram_init(&single);
+            if (read_trace(argv[i], &single, NULL, &count) < 0 || fit(&single, &levels) < 0) {
+                status = 1;
+                continue;
+            }
+            print_levels(&levels);
+        }
+        if (classify(argv[i], &levels) < 0) {
+            status = 1;
+            continue;
+        }
+        total += count;
+    }
+
+    double elapsed = now_s() - started;
+    printf("files=%d samples=%llu elapsed_s=%.3f samples_per_s=%.0f\n", argc - optind,
+           (unsigned long long)total, elapsed, elapsed > 0 ? total / elapsed : 0.0);
+    return status;
+}
@@ -0,0 +1,251 @@
+/**
+ * @file trace_zoom.c
+ * @brief Build zoom pyramids of current traces and print views of them
+ *
+ * "build" converts a trace to trc if needed and writes its pyramid
+ * (trace_pyramid.h) next to it, using every CPU. "view" prints what a plot
+ * of a window at a given width should draw, as csv: the buckets of the
+ * level trace_pyramid_select() picks, or the raw samples of a narrow
+ * window. data/plot.py reads the same pyramid files directly.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -D_GNU_SOURCE -Ihost/trace \
+ *       host/trace/{trace_zoom,trace_pyramid,trace_io}.c -lpthread -lm -o /tmp/trace_zoom
+ *
+ * Usage:
+ *   trace_zoom build [-j threads] [-F fanout] [-i interval_ms] trace...
+ *   trace_zoom view [-s start_s] [-e end_s] [-w width] trace.trp
+ *
+ * Example:
+ *   trace_zoom build /tmp/capture.csv       (writes capture.trc and capture.trp)
+ *   trace_zoom view -s 60 -e 61 -w 1920 /tmp/capture.trp
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "trace_io.h"
+#include "trace_pyramid.h"
+
+#define CHUNK_SAMPLES   8192
+#define DEFAULT_WIDTH   2000
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* path with its extension replaced */
+static bool sibling(char *out, size_t size, const char *path, const char *ext)
+{
+    const char *slash = strrchr(path, '/');
+    const char *dot = strrchr(path, '.');
+    size_t base = dot != NULL && (slash == NULL || dot > slash) ? (size_t)(dot - path) : strlen(path);
+    return snprintf(out, size, "%.*s%s", (int)base, path, ext) < (int)size;
+}
+
+static bool has_ext(const char *path, const char *ext)
+{
+    size_t n = strlen(path), e = strlen(ext);
+    return n >= e && strcmp(path + n - e, ext) == 0;
+}
+
+/* Rewrite a csv trace as trc so it can be mapped */
+static int convert(const char *in, const char *out, double interval_s)
+{
+    static double chunk[CHUNK_SAMPLES];
+    trace_reader_t *r = malloc(sizeof(*r));
+    trace_writer_t *w = malloc(sizeof(*w));
+    int ret = -1;
+
+    if (r == NULL || w == NULL || trace_open(r, in, TRACE_FORMAT_AUTO) < 0) {
+        free(r);
+        free(w);
+        return -1;
+    }
+    if (interval_s <= 0) {
+        interval_s = r->interval_s > 0 ? r->interval_s : TRACE_DEFAULT_INTERVAL_S;
+    }
+    if (trace_create(w, out, interval_s) == 0) {
+        long n;
+        ret = 0;
+        while ((n = trace_read(r, chunk, CHUNK_SAMPLES)) > 0) {
+            if (trace_write(w, chunk, (size_t)n) < 0) {
+                ret = -1;
+                break;
+            }
+        }
+        if (n < 0) {
+            ret = -1;
+        }
+        if (trace_finish(w) < 0) {
+            ret = -1;
+        }
+    }
+    trace_close(r);
+    free(r);
+    free(w);
+    return ret;
+}
+
+static int build(const char *path, int threads, uint32_t fanout, double interval_s)
+{
+    char trc[PATH_MAX], trp[PATH_MAX];
+    const char *samples_path = path;
+    double start = now_s();
+
+    if (!sibling(trp, sizeof(trp), path, ".trp")) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    if (!has_ext(path, ".trc") && !has_ext(path, ".f32")) {
+        if (!sibling(trc, sizeof(trc), path, ".trc") || convert(path, trc, interval_s) < 0) {
+            return -1;
+        }
+        samples_path = trc;
+    }
+
+    trace_map_t map;
+    const float *samples;
+    uint64_t count;
+    double header_interval;
+    if (trace_map_samples(samples_path, &map, &samples, &count, &header_interval) < 0) {
+        return -1;
+    }
+    if (interval_s <= 0) {
+        interval_s = header_interval > 0 ? header_interval : TRACE_DEFAULT_INTERVAL_S;
+    }
+    double mapped = now_s();
+
+    int ret = trace_pyramid_build(trp, samples, count, interval_s, fanout, threads);
+    int err = errno;
+    trace_unmap(&map);
+    if (ret < 0) {
+        errno = err;
+        return -1;
+    }
+
+    trace_pyramid_t p;
+    if (trace_pyramid_open(&p, trp) < 0) {
+        return -1;
+    }
+    double elapsed = now_s() - mapped;
+    printf("file=%s samples=%llu pyramid=%s levels=%u bytes=%zu convert_s=%.3f build_s=%.3f samples_per_s=%.0f\n",
+           path, (unsigned long long)count, trp, p.header.levels, p.map.len, mapped - start, elapsed,
+           elapsed > 0 ? (double)count / elapsed : 0.0);
+    trace_pyramid_close(&p);
+    return 0;
+}
+
+static int view(const char *path, double start_s, double end_s, uint32_t width)
+{
+    trace_pyramid_t p;
+    if (trace_pyramid_open(&p, path) < 0) {
+        return -1;
+    }
+
+    double interval = p.header.interval_s;
+    uint64_t from = start_s > 0 ? (uint64_t)(start_s / interval + 0.5) : 0;
+    uint64_t to = end_s > 0 ? (uint64_t)(end_s / interval + 0.5) : p.header.count;
+    to = to < p.header.count ? to : p.header.count;
+    from = from < to ? from : (to > 0 ? to - 1 : 0);
+
+    int level = trace_pyramid_select(&p, from, to, width);
+    if (level < 0) {
+        // Narrow window: the samples themselves
+        char trc[PATH_MAX];
+        trace_map_t map;
+        const float *samples;
+        uint64_t count;
+        double unused;
+        if (!sibling(trc, sizeof(trc), path, ".trc") ||
+            trace_map_samples(trc, &map, &samples, &count, &unused) < 0) {
+            int err = errno;
+            trace_pyramid_close(&p);
+            errno = err;
+            return -1;
+        }
+        to = to < count ? to : count;
+        printf("t_s,current_a\n");
+        for (uint64_t i = from; i < to; i++) {
+            printf("%.6f,%.6g\n", (double)i * interval, samples[i]);
+        }
+        trace_unmap(&map);
+    } else {
+        const trace_pyramid_level_t *l = &p.levels[level];
+        const trace_pyramid_bucket_t *b = trace_pyramid_buckets(&p, (uint32_t)level);
+        uint64_t last = (to + l->bucket_samples - 1) / l->bucket_samples;
+        printf("# level=%d bucket_samples=%llu\n", level, (unsigned long long)l->bucket_samples);
+        printf("t_s,min_a,max_a,mean_a,lttb_t_s,lttb_a\n");
+        for (uint64_t k = from / l->bucket_samples; k < last && k < l->buckets; k++) {
+            printf("%.6f,%.6g,%.6g,%.6g,%.6f,%.6g\n", (double)(k * l->bucket_samples) * interval,
+                   b[k].min, b[k].max, b[k].mean, (double)b[k].index * interval, b[k].value);
+        }
+    }
+
+    trace_pyramid_close(&p);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s build [-j threads] [-F fanout] [-i interval_ms] trace...\n"
+            "       %s view [-s start_s] [-e end_s] [-w width] trace.trp\n",
+            prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || (strcmp(argv[1], "build") != 0 && strcmp(argv[1], "view") != 0)) {
+        usage(argv[0]);
+        return 2;
+    }
+    bool building = strcmp(argv[1], "build") == 0;
+    int threads = 0;
+    uint32_t fanout = TRACE_PYRAMID_FANOUT;
+    double interval_s = 0, start_s = 0, end_s = 0;
+    long width = DEFAULT_WIDTH;
+
+    optind = 2;
+    int opt;
+    while ((opt = getopt(argc, argv, building ? "j:F:i:h" : "s:e:w:h")) != -1) {
+        bool ok = true;
+        switch (opt) {
+            case 'j': threads = atoi(optarg); ok = threads > 0; break;
+            case 'F': fanout = (uint32_t)strtoul(optarg, NULL, 0); ok = fanout >= 2; break;
+            case 'i': interval_s = strtod(optarg, NULL) * 1e-3; ok = interval_s > 0; break;
+            case 's': start_s = strtod(optarg, NULL); ok = start_s >= 0; break;
+            case 'e': end_s = strtod(optarg, NULL); ok = end_s >= 0; break;
+            case 'w': width = strtol(optarg, NULL, 0); ok = width > 0 && width <= UINT32_MAX; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+        if (!ok) {
+            fprintf(stderr, "trace_zoom: bad value '%s' for -%c\n", optarg, opt);
+            return 2;
+        }
+    }
+    if (optind == argc || (!building && argc - optind != 1)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int status = 0;
+    for (int i = optind; i < argc; i++) {
+        int ret = building ? build(argv[i], threads, fanout, interval_s)
+                           : view(argv[i], start_s, end_s, (uint32_t)width);
+        if (ret < 0) {
+            fprintf(stderr, "trace_zoom: %s: %s\n", argv[i], strerror(errno));
+            status = 1;
+        }
+    }
+    return status;
+}